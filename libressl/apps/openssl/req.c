@@ -1764,8 +1764,13 @@ do_sign_init(BIO * err, EVP_MD_CTX * ctx, EVP_PKEY * pkey,
     const EVP_MD * md, STACK_OF(OPENSSL_STRING) * sigopts)
 {
 	EVP_PKEY_CTX *pkctx = NULL;
+	int def_nid;
 	int i;
 	EVP_MD_CTX_init(ctx);
+	/* Keys such as Ed25519 sign the message itself and take no digest. */
+	if (EVP_PKEY_get_default_digest_nid(pkey, &def_nid) == 2 &&
+	    def_nid == NID_undef)
+		md = NULL;
 	if (!EVP_DigestSignInit(ctx, &pkctx, md, NULL, pkey))
 		return 0;
 	for (i = 0; i < sk_OPENSSL_STRING_num(sigopts); i++) {
@@ -80,22 +80,31 @@
 #define ECDH_SECONDS    10
 
 #include <math.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "apps.h"
 
 #include <openssl/bn.h>
 #include <openssl/crypto.h>
+#include <openssl/curve25519.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/hkdf.h>
 #include <openssl/modes.h>
 #include <openssl/objects.h>
+#include <openssl/ssl.h>
 #include <openssl/x509.h>
+#include <openssl/x509v3.h>
 
 #ifndef OPENSSL_NO_AES
 #include <openssl/aes.h>
@@ -161,6 +170,23 @@ pkey_print_message(const char *str, const char *str2,
 static void print_result(int alg, int run_no, int count, double time_used);
 #ifndef _WIN32
 static int do_multi(int multi);
+
+#define THR_SECONDS	1
+#define THR_MAX		1024
+
+#define TD_AES_128_GCM	0
+#define TD_AES_256_GCM	1
+#define TD_CHACHA20_POLY1305 2
+#define TD_X25519	3
+#define TD_ED25519	4
+#define TD_HKDF		5
+#define TD_TLS1_2	6
+#define TD_TLS1_3	7
+#define TD_X509_VERIFY	8
+#define THR_DOIT_NUM	9
+
+static int speed_thr_seconds = THR_SECONDS;
+static int speed_threads(int max_threads, const int *thr_doit, int json);
 #else
 void speed_signal(int sigcatch, void (*func)(int sigraised));
 unsigned int speed_alarm(unsigned int seconds);
@@ -478,6 +504,9 @@ speed_main(int argc, char **argv)
 #ifndef _WIN32
 	int multi = 0;
 	const char *errstr = NULL;
+	int thr_doit[THR_DOIT_NUM];
+	int threads = -1;
+	int json = 0;
 #endif
 
 	if (single_execution) {
@@ -524,7 +553,10 @@ speed_main(int argc, char **argv)
 		ecdsa_doit[i] = 0;
 	for (i = 0; i < EC_NUM; i++)
 		ecdh_doit[i] = 0;
-
+#ifndef _WIN32
+	for (i = 0; i < THR_DOIT_NUM; i++)
+		thr_doit[i] = 0;
+#endif
 
 	j = 0;
 	argc--;
@@ -570,7 +602,50 @@ speed_main(int argc, char **argv)
 			}
 			j--;	/* Otherwise, -multi gets confused with an
 				 * algorithm. */
-		}
+		} else if ((argc > 0) && (strcmp(*argv, "-threads") == 0)) {
+			argc--;
+			argv++;
+			if (argc == 0) {
+				BIO_printf(bio_err, "no thread count given\n");
+				goto end;
+			}
+			threads = strtonum(argv[0], 0, THR_MAX, &errstr);
+			if (errstr) {
+				BIO_printf(bio_err, "bad thread count: %s", errstr);
+				goto end;
+			}
+			j--;	/* Otherwise, -threads gets confused with an
+				 * algorithm. */
+		} else if ((argc > 0) && (strcmp(*argv, "-seconds") == 0)) {
+			argc--;
+			argv++;
+			if (argc == 0) {
+				BIO_printf(bio_err, "no seconds given\n");
+				goto end;
+			}
+			speed_thr_seconds = strtonum(argv[0], 1, INT_MAX, &errstr);
+			if (errstr) {
+				BIO_printf(bio_err, "bad seconds: %s", errstr);
+				goto end;
+			}
+			j--;	/* Otherwise, -seconds gets confused with an
+				 * algorithm. */
+		} else if (argc > 0 && !strcmp(*argv, "-json")) {
+			json = 1;
+			j--;	/* Otherwise, -json gets confused with an
+				 * algorithm. */
+		} else if (strcmp(*argv, "x25519") == 0)
+			thr_doit[TD_X25519] = 1;
+		else if (strcmp(*argv, "ed25519") == 0)
+			thr_doit[TD_ED25519] = 1;
+		else if (strcmp(*argv, "hkdf") == 0)
+			thr_doit[TD_HKDF] = 1;
+		else if (strcmp(*argv, "tls1.2") == 0)
+			thr_doit[TD_TLS1_2] = 1;
+		else if (strcmp(*argv, "tls1.3") == 0)
+			thr_doit[TD_TLS1_3] = 1;
+		else if (strcmp(*argv, "x509verify") == 0)
+			thr_doit[TD_X509_VERIFY] = 1;
 #endif
 		else if (argc > 0 && !strcmp(*argv, "-mr")) {
 			mr = 1;
@@ -891,6 +966,9 @@ speed_main(int argc, char **argv)
 			BIO_printf(bio_err," chacha20-poly1305");
 #endif
 			BIO_printf(bio_err, "\n");
+#ifndef _WIN32
+			BIO_printf(bio_err, "x25519   ed25519  hkdf     tls1.2   tls1.3   x509verify (threaded only)\n");
+#endif
 
 			BIO_printf(bio_err, "rsa512   rsa1024  rsa2048  rsa4096\n");
 
@@ -936,6 +1014,10 @@ speed_main(int argc, char **argv)
 			BIO_printf(bio_err, "-mr             produce machine readable output.\n");
 #ifndef _WIN32
 			BIO_printf(bio_err, "-multi n        run n benchmarks in parallel.\n");
+			BIO_printf(bio_err, "-threads n      run the threaded benchmarks with up to n threads,\n");
+			BIO_printf(bio_err, "                one per CPU if n is 0.\n");
+			BIO_printf(bio_err, "-seconds n      run each threaded benchmark for n seconds.\n");
+			BIO_printf(bio_err, "-json           print threaded results as JSON.\n");
 #endif
 			goto end;
 		}
@@ -945,6 +1027,27 @@ speed_main(int argc, char **argv)
 	}
 
 #ifndef _WIN32
+	/*
+	 * The threaded benchmarks only cover the AEADs, X25519, Ed25519,
+	 * HKDF, TLS handshakes and certificate verification; selecting any
+	 * of the latter implies them.
+	 */
+	for (i = TD_X25519; i < THR_DOIT_NUM; i++) {
+		if (thr_doit[i] && threads < 0)
+			threads = 1;
+	}
+	if (threads >= 0) {
+		thr_doit[TD_AES_128_GCM] = doit[D_AES_128_GCM];
+		thr_doit[TD_AES_256_GCM] = doit[D_AES_256_GCM];
+		thr_doit[TD_CHACHA20_POLY1305] = doit[D_CHACHA20_POLY1305];
+		if (j == 0) {
+			for (i = 0; i < THR_DOIT_NUM; i++)
+				thr_doit[i] = 1;
+		}
+		mret = speed_threads(threads, thr_doit, json);
+		goto end;
+	}
+
 	if (multi && do_multi(multi))
 		goto show_res;
 #endif
@@ -2179,4 +2282,696 @@ do_multi(int multi)
 	return 1;
 }
 #endif
+
+#ifndef _WIN32
+/*
+ * Multi-threaded benchmarks. Each test is run for speed_thr_seconds with
+ * 1, 2, 4, ... and finally the requested number of worker threads, each
+ * pinned to its own CPU where the system allows it, so that lock contention
+ * shows up as throughput that fails to grow with the number of threads.
+ */
+
+#define THR_RUNS	16
+#define THR_TESTS	48
+
+#define T_AEAD_SEAL	0
+#define T_AEAD_OPEN	1
+#define T_X25519	2
+#define T_ED25519_SIGN	3
+#define T_ED25519_VERIFY 4
+#define T_HKDF		5
+#define T_TLS		6
+#define T_X509_VERIFY	7
+
+static const int thr_lengths[] = {16, 256, 1350, 16384};
+#define THR_LENGTHS	(sizeof(thr_lengths) / sizeof(thr_lengths[0]))
+
+struct thr_test {
+	char name[64];
+	int type;
+	const EVP_AEAD *aead;
+	int length;
+	SSL_CTX *client_ctx;
+	SSL_CTX *server_ctx;
+	X509_STORE *store;
+	X509 *leaf;
+	int nthreads[THR_RUNS];
+	long ops[THR_RUNS];
+	double rate[THR_RUNS];
+	int nruns;
+};
+
+struct thr_run {
+	struct thr_test *test;
+	pthread_mutex_t mtx;
+	pthread_cond_t cond;
+	int ready;
+	int go;
+	volatile sig_atomic_t stop;
+};
+
+struct thr_worker {
+	struct thr_run *run;
+	pthread_t thread;
+	int cpu;
+	long count;
+	double elapsed;
+	int failed;
+};
+
+/* Per thread state of a test. */
+struct thr_state {
+	EVP_AEAD_CTX aead_ctx;
+	int aead_init;
+	unsigned char nonce[12];	/* all AEADs here use 96 bit nonces */
+	unsigned char *in;
+	unsigned char *out;
+	size_t in_len;
+	size_t out_len;
+};
+
+static uint8_t thr_x25519_peer[X25519_KEY_LENGTH];
+static uint8_t thr_ed25519_pub[ED25519_PUBLIC_KEY_LENGTH];
+static uint8_t thr_ed25519_priv[ED25519_PRIVATE_KEY_LENGTH];
+static uint8_t thr_ed25519_sig[ED25519_SIGNATURE_LENGTH];
+static const uint8_t thr_message[32];
+
+static double
+thr_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static int
+thr_state_init(struct thr_test *test, struct thr_state *st)
+{
+	static const unsigned char key[32];
+	size_t len;
+
+	memset(st, 0, sizeof(*st));
+
+	if (test->type != T_AEAD_SEAL && test->type != T_AEAD_OPEN)
+		return 1;
+
+	if (!EVP_AEAD_CTX_init(&st->aead_ctx, test->aead, key,
+	    EVP_AEAD_key_length(test->aead), EVP_AEAD_DEFAULT_TAG_LENGTH,
+	    NULL))
+		return 0;
+	st->aead_init = 1;
+
+	st->in_len = test->length + EVP_AEAD_max_overhead(test->aead);
+	if ((st->in = calloc(1, st->in_len)) == NULL ||
+	    (st->out = calloc(1, st->in_len)) == NULL)
+		return 0;
+
+	/* Open repeatedly decrypts the same record. */
+	if (test->type == T_AEAD_OPEN) {
+		if (!EVP_AEAD_CTX_seal(&st->aead_ctx, st->in, &len, st->in_len,
+		    st->nonce, EVP_AEAD_nonce_length(test->aead), st->out,
+		    test->length, NULL, 0))
+			return 0;
+		st->in_len = len;
+	} else
+		st->in_len = test->length;
+
+	return 1;
+}
+
+static void
+thr_state_cleanup(struct thr_state *st)
+{
+	if (st->aead_init)
+		EVP_AEAD_CTX_cleanup(&st->aead_ctx);
+	free(st->in);
+	free(st->out);
+}
+
+/* Complete a full handshake between two fresh connections over a BIO pair. */
+static int
+thr_handshake(SSL_CTX *client_ctx, SSL_CTX *server_ctx)
+{
+	SSL *client = NULL, *server = NULL;
+	BIO *client_bio = NULL, *server_bio = NULL;
+	int client_done = 0, server_done = 0;
+	int i, ret, failed = 1;
+
+	if ((client = SSL_new(client_ctx)) == NULL ||
+	    (server = SSL_new(server_ctx)) == NULL)
+		goto err;
+	if (!BIO_new_bio_pair(&client_bio, 0, &server_bio, 0))
+		goto err;
+	SSL_set_bio(client, client_bio, client_bio);
+	SSL_set_bio(server, server_bio, server_bio);
+	SSL_set_connect_state(client);
+	SSL_set_accept_state(server);
+
+	for (i = 0; i < 32 && (!client_done || !server_done); i++) {
+		if (!client_done) {
+			if ((ret = SSL_do_handshake(client)) == 1)
+				client_done = 1;
+			else if (SSL_get_error(client, ret) !=
+			    SSL_ERROR_WANT_READ &&
+			    SSL_get_error(client, ret) != SSL_ERROR_WANT_WRITE)
+				goto err;
+		}
+		if (!server_done) {
+			if ((ret = SSL_do_handshake(server)) == 1)
+				server_done = 1;
+			else if (SSL_get_error(server, ret) !=
+			    SSL_ERROR_WANT_READ &&
+			    SSL_get_error(server, ret) != SSL_ERROR_WANT_WRITE)
+				goto err;
+		}
+	}
+	failed = !client_done || !server_done;
+
+ err:
+	SSL_free(client);
+	SSL_free(server);
+
+	return !failed;
+}
+
+/*
+ * Verify a leaf that all threads share against a store that they share,
+ * as a server checking client certificates does.
+ */
+static int
+thr_x509_verify(X509_STORE *store, X509 *leaf)
+{
+	X509_STORE_CTX *ctx;
+	int ret = 0;
+
+	if ((ctx = X509_STORE_CTX_new()) == NULL)
+		return 0;
+	if (X509_STORE_CTX_init(ctx, store, leaf, NULL))
+		ret = X509_verify_cert(ctx) == 1;
+	X509_STORE_CTX_free(ctx);
+
+	return ret;
+}
+
+static int
+thr_op(struct thr_test *test, struct thr_state *st)
+{
+	uint8_t pub[X25519_KEY_LENGTH], priv[X25519_KEY_LENGTH];
+	uint8_t shared[X25519_KEY_LENGTH];
+	uint8_t sig[ED25519_SIGNATURE_LENGTH];
+	uint8_t okm[32];
+	size_t len;
+
+	switch (test->type) {
+	case T_AEAD_SEAL:
+		return EVP_AEAD_CTX_seal(&st->aead_ctx, st->out, &len,
+		    test->length + EVP_AEAD_max_overhead(test->aead),
+		    st->nonce, EVP_AEAD_nonce_length(test->aead), st->in,
+		    st->in_len, NULL, 0);
+	case T_AEAD_OPEN:
+		return EVP_AEAD_CTX_open(&st->aead_ctx, st->out, &len,
+		    test->length, st->nonce, EVP_AEAD_nonce_length(test->aead),
+		    st->in, st->in_len, NULL, 0);
+	case T_X25519:
+		X25519_keypair(pub, priv);
+		return X25519(shared, priv, thr_x25519_peer);
+	case T_ED25519_SIGN:
+		return ED25519_sign(sig, thr_message, sizeof(thr_message),
+		    thr_ed25519_pub, thr_ed25519_priv);
+	case T_ED25519_VERIFY:
+		return ED25519_verify(thr_message, sizeof(thr_message),
+		    thr_ed25519_sig, thr_ed25519_pub);
+	case T_HKDF:
+		return HKDF(okm, sizeof(okm), EVP_sha256(), thr_message,
+		    sizeof(thr_message), thr_message, sizeof(thr_message),
+		    thr_message, 16);
+	case T_TLS:
+		return thr_handshake(test->client_ctx, test->server_ctx);
+	case T_X509_VERIFY:
+		return thr_x509_verify(test->store, test->leaf);
+	}
+
+	return 0;
+}
+
+static void
+thr_pin(int cpu)
+{
+#if defined(__linux__) && defined(CPU_SET)
+	cpu_set_t set;
+
+	if (cpu < 0)
+		return;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+static void *
+thr_worker_main(void *arg)
+{
+	struct thr_worker *w = arg;
+	struct thr_run *run = w->run;
+	struct thr_state st;
+	double start;
+
+	thr_pin(w->cpu);
+
+	w->failed = !thr_state_init(run->test, &st);
+
+	pthread_mutex_lock(&run->mtx);
+	run->ready++;
+	pthread_cond_broadcast(&run->cond);
+	while (!run->go)
+		pthread_cond_wait(&run->cond, &run->mtx);
+	pthread_mutex_unlock(&run->mtx);
+
+	start = thr_now();
+	while (!w->failed && !run->stop) {
+		if (!thr_op(run->test, &st)) {
+			w->failed = 1;
+			break;
+		}
+		w->count++;
+	}
+	w->elapsed = thr_now() - start;
+
+	thr_state_cleanup(&st);
+
+	return NULL;
+}
+
+/*
+ * Return the CPUs this process may run on, so that worker i can be pinned
+ * to the i-th of them, or -1 where pinning is not supported.
+ */
+static void
+thr_cpus(int *cpus, int num)
+{
+	int i, n = 0;
+#if defined(__linux__) && defined(CPU_SET)
+	cpu_set_t set;
+	int cpu;
+
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (cpu = 0; cpu < CPU_SETSIZE && n < num; cpu++) {
+			if (CPU_ISSET(cpu, &set))
+				cpus[n++] = cpu;
+		}
+	}
+#endif
+	/* More threads than CPUs are left to the scheduler. */
+	for (i = n; i < num; i++)
+		cpus[i] = -1;
+}
+
+static int
+thr_run_test(struct thr_test *test, int nthreads, const int *cpus)
+{
+	struct thr_worker *workers;
+	struct thr_run run;
+	double rate = 0;
+	long count = 0;
+	int i, started = 0, failed = 0;
+
+	if (!mr)
+		BIO_printf(bio_err, "Doing %s with %d thread%s for %ds: ",
+		    test->name, nthreads, nthreads == 1 ? "" : "s",
+		    speed_thr_seconds);
+	(void)BIO_flush(bio_err);
+
+	if ((workers = calloc(nthreads, sizeof(*workers))) == NULL) {
+		BIO_printf(bio_err, "out of memory\n");
+		return 0;
+	}
+
+	memset(&run, 0, sizeof(run));
+	run.test = test;
+	pthread_mutex_init(&run.mtx, NULL);
+	pthread_cond_init(&run.cond, NULL);
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].run = &run;
+		workers[i].cpu = cpus[i];
+		if (pthread_create(&workers[i].thread, NULL, thr_worker_main,
+		    &workers[i]) != 0) {
+			BIO_printf(bio_err, "failed to create thread\n");
+			failed = 1;
+			break;
+		}
+		started++;
+	}
+
+	/* Start all workers at once, once they have set up their state. */
+	pthread_mutex_lock(&run.mtx);
+	while (run.ready < started)
+		pthread_cond_wait(&run.cond, &run.mtx);
+	run.go = 1;
+	pthread_cond_broadcast(&run.cond);
+	pthread_mutex_unlock(&run.mtx);
+
+	if (!failed)
+		sleep(speed_thr_seconds);
+	run.stop = 1;
+
+	for (i = 0; i < started; i++) {
+		pthread_join(workers[i].thread, NULL);
+		if (workers[i].failed)
+			failed = 1;
+		count += workers[i].count;
+		if (workers[i].elapsed > 0)
+			rate += workers[i].count / workers[i].elapsed;
+	}
+
+	pthread_cond_destroy(&run.cond);
+	pthread_mutex_destroy(&run.mtx);
+	free(workers);
+
+	if (failed) {
+		BIO_printf(bio_err, "%s failed\n", test->name);
+		ERR_print_errors(bio_err);
+		return 0;
+	}
+
+	if (!mr)
+		BIO_printf(bio_err, "%ld ops, %.0f ops/s\n", count, rate);
+
+	test->nthreads[test->nruns] = nthreads;
+	test->ops[test->nruns] = count;
+	test->rate[test->nruns] = rate;
+	test->nruns++;
+
+	return 1;
+}
+
+/*
+ * Make a certificate for pkey named cn, issued by issuer or self-signed if
+ * issuer is NULL. The issuer key is pkey as well, which keeps things
+ * simple and costs the same to verify.
+ */
+static X509 *
+thr_certificate(EVP_PKEY *pkey, const char *cn, X509 *issuer, int ca)
+{
+	BASIC_CONSTRAINTS *bc = NULL;
+	X509_NAME *name = NULL;
+	X509 *cert;
+
+	if ((cert = X509_new()) == NULL)
+		goto err;
+	if (!X509_set_version(cert, 2))
+		goto err;
+	if (!ASN1_INTEGER_set(X509_get_serialNumber(cert), 1))
+		goto err;
+	if (X509_gmtime_adj(X509_get_notBefore(cert), 0) == NULL ||
+	    X509_gmtime_adj(X509_get_notAfter(cert), 3600) == NULL)
+		goto err;
+	if ((name = X509_NAME_new()) == NULL)
+		goto err;
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)cn, -1, -1, 0))
+		goto err;
+	if (!X509_set_subject_name(cert, name))
+		goto err;
+	if (!X509_set_issuer_name(cert, issuer != NULL ?
+	    X509_get_subject_name(issuer) : name))
+		goto err;
+	if (ca) {
+		if ((bc = BASIC_CONSTRAINTS_new()) == NULL)
+			goto err;
+		bc->ca = 1;
+		if (!X509_add1_ext_i2d(cert, NID_basic_constraints, bc, 1, 0))
+			goto err;
+	}
+	if (!X509_set_pubkey(cert, pkey))
+		goto err;
+	if (!X509_sign(cert, pkey, EVP_sha256()))
+		goto err;
+	BASIC_CONSTRAINTS_free(bc);
+	X509_NAME_free(name);
+
+	return cert;
+
+ err:
+	BASIC_CONSTRAINTS_free(bc);
+	X509_NAME_free(name);
+	X509_free(cert);
+	return NULL;
+}
+
+/*
+ * Set up a client and a server context that only speak the given version,
+ * with a self-signed P-256 certificate on the server.
+ */
+static int
+thr_tls_setup(struct thr_test *test, int version, EVP_PKEY *pkey, X509 *cert)
+{
+	if ((test->client_ctx = SSL_CTX_new(TLS_client_method())) == NULL ||
+	    (test->server_ctx = SSL_CTX_new(TLS_server_method())) == NULL)
+		return 0;
+	if (!SSL_CTX_set_min_proto_version(test->client_ctx, version) ||
+	    !SSL_CTX_set_max_proto_version(test->client_ctx, version) ||
+	    !SSL_CTX_set_min_proto_version(test->server_ctx, version) ||
+	    !SSL_CTX_set_max_proto_version(test->server_ctx, version))
+		return 0;
+	if (!SSL_CTX_use_certificate(test->server_ctx, cert) ||
+	    !SSL_CTX_use_PrivateKey(test->server_ctx, pkey))
+		return 0;
+
+	return 1;
+}
+
+/* Set up a store holding a self-signed root and a leaf issued by it. */
+static int
+thr_x509_setup(struct thr_test *test, EVP_PKEY *pkey)
+{
+	X509 *root;
+	int ret = 0;
+
+	if ((root = thr_certificate(pkey, "speed root", NULL, 1)) == NULL)
+		return 0;
+	if ((test->leaf = thr_certificate(pkey, "speed leaf", root,
+	    0)) == NULL)
+		goto err;
+	if ((test->store = X509_STORE_new()) == NULL)
+		goto err;
+	if (!X509_STORE_add_cert(test->store, root))
+		goto err;
+
+	ret = thr_x509_verify(test->store, test->leaf);
+
+ err:
+	X509_free(root);
+
+	return ret;
+}
+
+static void
+thr_print_json(struct thr_test *tests, int ntests)
+{
+	struct thr_test *test;
+	int i, j;
+
+	fprintf(stdout, "{\n");
+	fprintf(stdout, "  \"seconds\": %d,\n", speed_thr_seconds);
+	fprintf(stdout, "  \"results\": [");
+	for (i = 0; i < ntests; i++) {
+		test = &tests[i];
+		fprintf(stdout, "%s\n    {\"name\": \"%s\", \"bytes\": %d, "
+		    "\"runs\": [", i == 0 ? "" : ",", test->name,
+		    test->length);
+		for (j = 0; j < test->nruns; j++) {
+			fprintf(stdout, "%s\n      {\"threads\": %d, "
+			    "\"ops\": %ld, \"ops_per_sec\": %.2f, "
+			    "\"bytes_per_sec\": %.2f, \"scaling\": %.3f}",
+			    j == 0 ? "" : ",", test->nthreads[j], test->ops[j],
+			    test->rate[j], test->rate[j] * test->length,
+			    test->rate[0] > 0 ? test->rate[j] / test->rate[0] :
+			    0);
+		}
+		fprintf(stdout, "\n    ]}");
+	}
+	fprintf(stdout, "\n  ]\n}\n");
+}
+
+static void
+thr_print_table(struct thr_test *tests, int ntests)
+{
+	struct thr_test *test;
+	int i, j;
+
+	if (ntests == 0)
+		return;
+
+	fprintf(stdout, "ops/s at %-24s", "threads:");
+	for (j = 0; j < tests[0].nruns; j++)
+		fprintf(stdout, " %11d", tests[0].nthreads[j]);
+	fprintf(stdout, "  scaling\n");
+
+	for (i = 0; i < ntests; i++) {
+		test = &tests[i];
+		fprintf(stdout, "%-33s", test->name);
+		for (j = 0; j < test->nruns; j++)
+			fprintf(stdout, " %11.0f", test->rate[j]);
+		fprintf(stdout, "  %7.2f\n", test->rate[0] > 0 ?
+		    test->rate[test->nruns - 1] / test->rate[0] : 0);
+	}
+}
+
+/*
+ * Run the selected multi-threaded tests with up to max_threads threads.
+ * A zero max_threads means one thread per online CPU.
+ */
+static int
+speed_threads(int max_threads, const int *thr_doit, int json)
+{
+	static const struct {
+		const char *name;
+		const EVP_AEAD *(*aead)(void);
+		int doit;
+	} aeads[] = {
+#ifndef OPENSSL_NO_AES
+		{ "aes-128-gcm", EVP_aead_aes_128_gcm, TD_AES_128_GCM },
+		{ "aes-256-gcm", EVP_aead_aes_256_gcm, TD_AES_256_GCM },
+#endif
+#if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+		{ "chacha20-poly1305", EVP_aead_chacha20_poly1305,
+		    TD_CHACHA20_POLY1305 },
+#endif
+	};
+	static const struct {
+		const char *name;
+		int type;
+		int version;
+		int doit;
+	} others[] = {
+		{ "x25519", T_X25519, 0, TD_X25519 },
+		{ "ed25519 sign", T_ED25519_SIGN, 0, TD_ED25519 },
+		{ "ed25519 verify", T_ED25519_VERIFY, 0, TD_ED25519 },
+		{ "hkdf sha256", T_HKDF, 0, TD_HKDF },
+		{ "tls1.2 handshake", T_TLS, TLS1_2_VERSION, TD_TLS1_2 },
+		{ "tls1.3 handshake", T_TLS, TLS1_3_VERSION, TD_TLS1_3 },
+		{ "x509 verify", T_X509_VERIFY, 0, TD_X509_VERIFY },
+	};
+	struct thr_test *tests = NULL, *test;
+	EVP_PKEY *pkey = NULL;
+	EC_KEY *eckey = NULL;
+	X509 *cert = NULL;
+	uint8_t priv[X25519_KEY_LENGTH];
+	int cpus[THR_MAX];
+	int ntests = 0, nthreads;
+	int i, j, op;
+	long ncpus;
+	int ret = 1;
+
+	if (max_threads == 0) {
+		if ((ncpus = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+			ncpus = 1;
+		max_threads = ncpus > THR_MAX ? THR_MAX : ncpus;
+	}
+	thr_cpus(cpus, max_threads);
+
+	if ((tests = calloc(THR_TESTS, sizeof(*tests))) == NULL) {
+		BIO_printf(bio_err, "out of memory\n");
+		goto end;
+	}
+
+	for (i = 0; i < (int)(sizeof(aeads) / sizeof(aeads[0])); i++) {
+		if (!thr_doit[aeads[i].doit])
+			continue;
+		for (op = T_AEAD_SEAL; op <= T_AEAD_OPEN; op++) {
+			for (j = 0; j < (int)THR_LENGTHS; j++) {
+				test = &tests[ntests++];
+				snprintf(test->name, sizeof(test->name),
+				    "%s %s %d", aeads[i].name,
+				    op == T_AEAD_SEAL ? "seal" : "open",
+				    thr_lengths[j]);
+				test->type = op;
+				test->aead = aeads[i].aead();
+				test->length = thr_lengths[j];
+			}
+		}
+	}
+
+	X25519_keypair(thr_x25519_peer, priv);
+	ED25519_keypair(thr_ed25519_pub, thr_ed25519_priv);
+	if (!ED25519_sign(thr_ed25519_sig, thr_message, sizeof(thr_message),
+	    thr_ed25519_pub, thr_ed25519_priv))
+		goto end;
+
+	for (i = 0; i < (int)(sizeof(others) / sizeof(others[0])); i++) {
+		if (!thr_doit[others[i].doit])
+			continue;
+		test = &tests[ntests++];
+		strlcpy(test->name, others[i].name, sizeof(test->name));
+		test->type = others[i].type;
+		if (test->type != T_TLS && test->type != T_X509_VERIFY)
+			continue;
+		if (pkey == NULL) {
+			if ((eckey = EC_KEY_new_by_curve_name(
+			    NID_X9_62_prime256v1)) == NULL) {
+				BIO_printf(bio_err, "failed to create key\n");
+				goto end;
+			}
+			EC_KEY_set_asn1_flag(eckey, OPENSSL_EC_NAMED_CURVE);
+			if (!EC_KEY_generate_key(eckey) ||
+			    (pkey = EVP_PKEY_new()) == NULL ||
+			    !EVP_PKEY_set1_EC_KEY(pkey, eckey) ||
+			    (cert = thr_certificate(pkey, "speed", NULL,
+			    0)) == NULL) {
+				BIO_printf(bio_err,
+				    "failed to create certificate\n");
+				goto end;
+			}
+		}
+		if (test->type == T_X509_VERIFY) {
+			if (!thr_x509_setup(test, pkey)) {
+				BIO_printf(bio_err, "failed to set up %s\n",
+				    test->name);
+				goto end;
+			}
+			continue;
+		}
+		if (!thr_tls_setup(test, others[i].version, pkey, cert)) {
+			BIO_printf(bio_err, "failed to set up %s\n",
+			    test->name);
+			goto end;
+		}
+	}
+
+	for (i = 0; i < ntests; i++) {
+		for (nthreads = 1; ; nthreads *= 2) {
+			if (nthreads > max_threads)
+				nthreads = max_threads;
+			if (!thr_run_test(&tests[i], nthreads, cpus))
+				goto end;
+			if (nthreads == max_threads)
+				break;
+		}
+	}
+
+	if (json)
+		thr_print_json(tests, ntests);
+	else
+		thr_print_table(tests, ntests);
+
+	ret = 0;
+
+ end:
+	for (i = 0; tests != NULL && i < ntests; i++) {
+		SSL_CTX_free(tests[i].client_ctx);
+		SSL_CTX_free(tests[i].server_ctx);
+		X509_STORE_free(tests[i].store);
+		X509_free(tests[i].leaf);
+	}
+	free(tests);
+	X509_free(cert);
+	EVP_PKEY_free(pkey);
+	EC_KEY_free(eckey);
+
+	return ret;
+}
+#endif
 #endif
@@ -152,7 +152,7 @@ ASN1_item_sign_ctx(const ASN1_ITEM *it, X509_ALGOR *algor1, X509_ALGOR *algor2,
 	type = EVP_MD_CTX_md(ctx);
 	pkey = EVP_PKEY_CTX_get0_pkey(ctx->pctx);
 
-	if (!type || !pkey) {
+	if (pkey == NULL) {
 		ASN1error(ASN1_R_CONTEXT_NOT_INITIALISED);
 		return 0;
 	}
@@ -176,6 +176,10 @@ ASN1_item_sign_ctx(const ASN1_ITEM *it, X509_ALGOR *algor1, X509_ALGOR *algor2,
 		rv = 2;
 
 	if (rv == 2) {
+		if (type == NULL) {
+			ASN1error(ASN1_R_CONTEXT_NOT_INITIALISED);
+			return 0;
+		}
 		if (type->flags & EVP_MD_FLAG_PKEY_METHOD_SIGNATURE) {
 			if (!pkey->ameth ||
 			    !OBJ_find_sigid_by_algs(&signid,
@@ -209,8 +213,7 @@ ASN1_item_sign_ctx(const ASN1_ITEM *it, X509_ALGOR *algor1, X509_ALGOR *algor2,
 		goto err;
 	}
 
-	if (!EVP_DigestSignUpdate(ctx, buf_in, inl) ||
-	    !EVP_DigestSignFinal(ctx, buf_out, &outl)) {
+	if (!EVP_DigestSign(ctx, buf_out, &outl, buf_in, inl)) {
 		outl = 0;
 		ASN1error(ERR_R_EVP_LIB);
 		goto err;
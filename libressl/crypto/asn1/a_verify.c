@@ -142,16 +142,12 @@ ASN1_item_verify(const ASN1_ITEM *it, X509_ALGOR *a,
 		goto err;
 	}
 
-	if (!EVP_DigestVerifyUpdate(&ctx, buf_in, inl)) {
-		ASN1error(ERR_R_EVP_LIB);
-		ret = 0;
-		goto err;
-	}
+	ret = EVP_DigestVerify(&ctx, signature->data,
+	    (size_t)signature->length, buf_in, inl);
 
 	freezero(buf_in, (unsigned int)inl);
 
-	if (EVP_DigestVerifyFinal(&ctx, signature->data,
-	    (size_t)signature->length) <= 0) {
+	if (ret <= 0) {
 		ASN1error(ERR_R_EVP_LIB);
 		ret = 0;
 		goto err;
@@ -79,6 +79,7 @@ extern const EVP_PKEY_ASN1_METHOD gostr01_asn1_meths[];
 extern const EVP_PKEY_ASN1_METHOD gostimit_asn1_meth;
 extern const EVP_PKEY_ASN1_METHOD hmac_asn1_meth;
 extern const EVP_PKEY_ASN1_METHOD cmac_asn1_meth;
+extern const EVP_PKEY_ASN1_METHOD ed25519_asn1_meth;
 
 /* Keep this sorted in type order !! */
 static const EVP_PKEY_ASN1_METHOD *standard_methods[] = {
@@ -112,6 +113,7 @@ static const EVP_PKEY_ASN1_METHOD *standard_methods[] = {
 	&gostr01_asn1_meths[1],
 	&gostr01_asn1_meths[2],
 #endif
+	&ed25519_asn1_meth,
 };
 
 typedef int sk_cmp_fn_type(const char * const *a, const char * const *b);
@@ -368,6 +370,11 @@ EVP_PKEY_asn1_copy(EVP_PKEY_ASN1_METHOD *dst, const EVP_PKEY_ASN1_METHOD *src)
 
 	dst->item_sign = src->item_sign;
 	dst->item_verify = src->item_verify;
+
+	dst->set_priv_key = src->set_priv_key;
+	dst->set_pub_key = src->set_pub_key;
+	dst->get_priv_key = src->get_priv_key;
+	dst->get_pub_key = src->get_pub_key;
 }
 
 void
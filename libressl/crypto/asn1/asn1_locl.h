@@ -122,6 +122,14 @@ struct evp_pkey_asn1_method_st {
 	int (*item_sign)(EVP_MD_CTX *ctx, const ASN1_ITEM *it, void *asn,
 	    X509_ALGOR *alg1, X509_ALGOR *alg2, ASN1_BIT_STRING *sig);
 
+	/* Raw key access, see EVP_PKEY_new_raw_private_key(). */
+	int (*set_priv_key)(EVP_PKEY *pk, const unsigned char *priv,
+	    size_t len);
+	int (*set_pub_key)(EVP_PKEY *pk, const unsigned char *pub, size_t len);
+	int (*get_priv_key)(const EVP_PKEY *pk, unsigned char *out_priv,
+	    size_t *out_len);
+	int (*get_pub_key)(const EVP_PKEY *pk, unsigned char *out_pub,
+	    size_t *out_len);
 } /* EVP_PKEY_ASN1_METHOD */;
 
 /* Method to handle CRL access.
@@ -142,6 +150,8 @@ struct x509_crl_method_st {
 	int (*crl_verify)(X509_CRL *crl, EVP_PKEY *pk);
 };
 
+void x509_crl_index_clear(X509_CRL *crl);
+
 /*
  * Unicode codepoint constants
  */
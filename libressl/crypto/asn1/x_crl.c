@@ -56,7 +56,9 @@
  * [including the GNU Public Licence.]
  */
 
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <openssl/opensslconf.h>
 
@@ -67,9 +69,29 @@
 
 #include "asn1_locl.h"
 
+struct x509_crl_index_st;
+
 static int X509_REVOKED_cmp(const X509_REVOKED * const *a,
     const X509_REVOKED * const *b);
 static void setup_idp(X509_CRL *crl, ISSUING_DIST_POINT *idp);
+static void crl_index_free(struct x509_crl_index_st *index);
+static struct x509_crl_index_st *crl_index_get(X509_CRL *crl);
+
+/*
+ * X509_CRL objects are allocated with room for the fields below, which are
+ * kept out of the public struct X509_crl_st so that its layout does not
+ * change.  They are only ever allocated through X509_CRL_it.
+ */
+struct x509_crl_internal {
+	X509_CRL crl;
+	struct x509_crl_index_st *index;
+};
+
+static struct x509_crl_internal *
+crl_internal(X509_CRL *crl)
+{
+	return (struct x509_crl_internal *)crl;
+}
 
 static const ASN1_TEMPLATE X509_REVOKED_seq_tt[] = {
 	{
@@ -284,6 +306,7 @@ crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it, void *exarg)
 		crl->issuers = NULL;
 		crl->crl_number = NULL;
 		crl->base_crl_number = NULL;
+		crl_internal(crl)->index = NULL;
 		break;
 
 	case ASN1_OP_D2I_POST:
@@ -355,11 +378,156 @@ crl_cb(int operation, ASN1_VALUE **pval, const ASN1_ITEM *it, void *exarg)
 		ASN1_INTEGER_free(crl->crl_number);
 		ASN1_INTEGER_free(crl->base_crl_number);
 		sk_GENERAL_NAMES_pop_free(crl->issuers, GENERAL_NAMES_free);
+		x509_crl_index_clear(crl);
 		break;
 	}
 	return rc;
 }
 
+/*
+ * CRLs carry a hash index of their revoked entries by serial number, so
+ * that def_crl_lookup() finds revoked serials without searching the
+ * revoked stack.  The index is built by the first lookup, under
+ * CRYPTO_LOCK_X509_CRL where the stack used to be sorted, and is not
+ * changed afterwards, so later lookups read it without locking.  Building
+ * it sorts the stack as that lookup did, so that the positions it holds do
+ * not move; the stack is not sorted at decode time as that would change
+ * the output of X509_CRL_print().  It uses open addressing with linear
+ * probing: slots hold a position in the revoked stack plus one.
+ * X509_CRL_add0_revoked() and X509_CRL_sort() drop the index, so that the
+ * next lookup builds a new one, and an index that no longer matches the
+ * revoked stack or its size is not used.
+ *
+ * The stack may still be changed behind our back, for example with
+ * sk_X509_REVOKED_set(), and there is no way to tell.  So positions are
+ * checked against the stack and its serials on each lookup, instead of
+ * keeping pointers to entries that may have been freed, and only a match
+ * is trusted: if the index finds nothing, the sorted stack is searched as
+ * before.  That search only takes the lock if the stack was changed and
+ * needs sorting again.
+ */
+#if defined(__ATOMIC_ACQUIRE) && !defined(_WIN32)
+#define X509_CRL_INDEX_ATOMIC
+#endif
+
+struct x509_crl_index_st {
+	STACK_OF(X509_REVOKED) *revoked;
+	int num;
+	uint32_t mask;
+	uint32_t *slots;
+	uint32_t *hashes;
+};
+
+static uint32_t
+crl_serial_hash(const ASN1_INTEGER *serial)
+{
+	uint32_t hash = 2166136261U;
+	const unsigned char *data = serial->data;
+	int len = serial->length;
+
+	/* ASN1_INTEGER_cmp() tells negative from positive by type. */
+	hash ^= serial->type == V_ASN1_NEG_INTEGER;
+	hash *= 16777619U;
+	while (len-- > 0) {
+		hash ^= *data++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static void
+crl_index_free(struct x509_crl_index_st *index)
+{
+	if (index == NULL)
+		return;
+	free(index->slots);
+	free(index->hashes);
+	free(index);
+}
+
+void
+x509_crl_index_clear(X509_CRL *crl)
+{
+	crl_index_free(crl_internal(crl)->index);
+	crl_internal(crl)->index = NULL;
+}
+
+static struct x509_crl_index_st *
+crl_index_new(STACK_OF(X509_REVOKED) *revoked)
+{
+	struct x509_crl_index_st *index;
+	X509_REVOKED *rev;
+	uint32_t size, slot;
+	int i, num;
+
+	/* Keep the table at most half full. */
+	num = sk_X509_REVOKED_num(revoked);
+	if (num > 0 && (uint32_t)num > UINT32_MAX / 4)
+		return NULL;
+	for (size = 16; num > 0 && size < 2 * (uint32_t)num; size <<= 1)
+		;
+
+	if ((index = calloc(1, sizeof(*index))) == NULL)
+		return NULL;
+	index->revoked = revoked;
+	index->num = num;
+	index->mask = size - 1;
+	if ((index->slots = calloc(size, sizeof(*index->slots))) == NULL)
+		goto err;
+	if (num > 0 &&
+	    (index->hashes = calloc(num, sizeof(*index->hashes))) == NULL)
+		goto err;
+
+	for (i = 0; i < num; i++) {
+		rev = sk_X509_REVOKED_value(revoked, i);
+		index->hashes[i] = crl_serial_hash(rev->serialNumber);
+		slot = index->hashes[i] & index->mask;
+		while (index->slots[slot] != 0)
+			slot = (slot + 1) & index->mask;
+		index->slots[slot] = i + 1;
+	}
+
+	return index;
+
+ err:
+	crl_index_free(index);
+	return NULL;
+}
+
+static struct x509_crl_index_st *
+crl_index_get(X509_CRL *crl)
+{
+	struct x509_crl_internal *ci = crl_internal(crl);
+	struct x509_crl_index_st *index;
+
+#ifdef X509_CRL_INDEX_ATOMIC
+	if ((index = __atomic_load_n(&ci->index, __ATOMIC_ACQUIRE)) != NULL)
+		return index;
+#else
+	CRYPTO_r_lock(CRYPTO_LOCK_X509_CRL);
+	index = ci->index;
+	CRYPTO_r_unlock(CRYPTO_LOCK_X509_CRL);
+	if (index != NULL)
+		return index;
+#endif
+
+	CRYPTO_w_lock(CRYPTO_LOCK_X509_CRL);
+	if ((index = ci->index) == NULL) {
+		sk_X509_REVOKED_sort(crl->crl->revoked);
+		if ((index = crl_index_new(crl->crl->revoked)) != NULL) {
+#ifdef X509_CRL_INDEX_ATOMIC
+			__atomic_store_n(&ci->index, index, __ATOMIC_RELEASE);
+#else
+			ci->index = index;
+#endif
+		}
+	}
+	CRYPTO_w_unlock(CRYPTO_LOCK_X509_CRL);
+
+	return index;
+}
+
 /* Convert IDP into a more convenient form */
 
 static void
@@ -432,7 +600,7 @@ const ASN1_ITEM X509_CRL_it = {
 	.templates = X509_CRL_seq_tt,
 	.tcount = sizeof(X509_CRL_seq_tt) / sizeof(ASN1_TEMPLATE),
 	.funcs = &X509_CRL_aux,
-	.size = sizeof(X509_CRL),
+	.size = sizeof(struct x509_crl_internal),
 	.sname = "X509_CRL",
 };
 
@@ -543,6 +711,7 @@ X509_CRL_add0_revoked(X509_CRL *crl, X509_REVOKED *rev)
 		return 0;
 	}
 	inf->enc.modified = 1;
+	x509_crl_index_clear(crl);
 	return 1;
 }
 
@@ -606,12 +775,56 @@ crl_revoked_issuer_match(X509_CRL *crl, X509_NAME *nm, X509_REVOKED *rev)
 
 }
 
+static int
+crl_revoked_found(X509_REVOKED **ret, X509_REVOKED *rev)
+{
+	if (ret)
+		*ret = rev;
+	if (rev->reason == CRL_REASON_REMOVE_FROM_CRL)
+		return 2;
+	return 1;
+}
+
+static int
+crl_index_lookup(X509_CRL *crl, struct x509_crl_index_st *index,
+    X509_REVOKED **ret, ASN1_INTEGER *serial, X509_NAME *issuer)
+{
+	X509_REVOKED *rev;
+	uint32_t hash, slot, entry;
+
+	hash = crl_serial_hash(serial);
+	for (slot = hash & index->mask; (entry = index->slots[slot]) != 0;
+	    slot = (slot + 1) & index->mask) {
+		entry--;
+		if (index->hashes[entry] != hash)
+			continue;
+		if ((rev = sk_X509_REVOKED_value(crl->crl->revoked,
+		    entry)) == NULL)
+			continue;
+		if (ASN1_INTEGER_cmp(rev->serialNumber, serial) != 0)
+			continue;
+		if (crl_revoked_issuer_match(crl, issuer, rev))
+			return crl_revoked_found(ret, rev);
+	}
+	return 0;
+}
+
 static int
 def_crl_lookup(X509_CRL *crl, X509_REVOKED **ret, ASN1_INTEGER *serial,
     X509_NAME *issuer)
 {
+	struct x509_crl_index_st *index;
 	X509_REVOKED rtmp, *rev;
-	int idx;
+	int idx, rv;
+
+	/* A miss in the index may be stale, see above. */
+	if ((index = crl_index_get(crl)) != NULL &&
+	    index->revoked == crl->crl->revoked &&
+	    index->num == sk_X509_REVOKED_num(crl->crl->revoked)) {
+		if ((rv = crl_index_lookup(crl, index, ret, serial,
+		    issuer)) != 0)
+			return rv;
+	}
 
 	rtmp.serialNumber = serial;
 	/* Sort revoked into serial number order if not already sorted.
@@ -630,13 +843,8 @@ def_crl_lookup(X509_CRL *crl, X509_REVOKED **ret, ASN1_INTEGER *serial,
 		rev = sk_X509_REVOKED_value(crl->crl->revoked, idx);
 		if (ASN1_INTEGER_cmp(rev->serialNumber, serial))
 			return 0;
-		if (crl_revoked_issuer_match(crl, issuer, rev)) {
-			if (ret)
-				*ret = rev;
-			if (rev->reason == CRL_REASON_REMOVE_FROM_CRL)
-				return 2;
-			return 1;
-		}
+		if (crl_revoked_issuer_match(crl, issuer, rev))
+			return crl_revoked_found(ret, rev);
 	}
 	return 0;
 }
@@ -739,6 +739,18 @@ BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
 	} else if (!BN_to_montgomery(&am, a,mont, ctx))
 		goto err;
 
+#ifdef BN_MONT_X86_64
+	/* MULX/ADCX/ADOX kernel with its own fixed window of 5 bits. */
+	for (i = am.top; i < top; i++)
+		am.d[i] = 0;
+	for (i = tmp.top; i < top; i++)
+		tmp.d[i] = 0;
+	if (window >= 5 && bn_mod_exp_mont_x86_64(tmp.d, am.d, p,
+	    (BN_ULONG *)powerbuf, mont->N.d, mont->n0, top)) {
+		tmp.top = top;
+		bn_correct_top(&tmp);
+	} else
+#endif
 #if defined(OPENSSL_BN_ASM_MONT5)
 	/* This optimization uses ideas from http://eprint.iacr.org/2011/239,
 	 * specifically optimization of cache-timing attack countermeasures
@@ -474,6 +474,16 @@ BN_ULONG bn_sub_part_words(BN_ULONG *r, const BN_ULONG *a, const BN_ULONG *b,
     int cl, int dl);
 int bn_mul_mont(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp, const BN_ULONG *np, const BN_ULONG *n0, int num);
 
+#if defined(__x86_64__) && defined(__GNUC__) && \
+    defined(OPENSSL_BN_ASM_MONT) && defined(OPENSSL_CPUID_OBJ) && \
+    !defined(OPENSSL_NO_ASM)
+#define BN_MONT_X86_64
+int bn_mul_mont_x86_64(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp,
+    const BN_ULONG *np, const BN_ULONG *n0, int num);
+int bn_mod_exp_mont_x86_64(BN_ULONG *rp, const BN_ULONG *am, const BIGNUM *p,
+    BN_ULONG *table, const BN_ULONG *np, const BN_ULONG *n0, int num);
+#endif
+
 #define bn_wexpand(a,words) (((words) <= (a)->dmax)?(a):bn_expand2((a),(words)))
 BIGNUM *bn_expand2(BIGNUM *a, int words);
 BIGNUM *bn_expand(BIGNUM *a, int bits);
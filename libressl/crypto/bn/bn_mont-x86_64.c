@@ -0,0 +1,267 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Montgomery multiplication for x86_64 using MULX, ADCX and ADOX. Each row
+ * of the interleaved (CIOS) multiplication keeps two independent carry
+ * chains, in the carry and overflow flags, for the low and high halves of
+ * the partial products. The exponentiation uses a fixed 5 bit window and
+ * reads the whole table of powers for every lookup so that neither timing
+ * nor memory access pattern depends on the exponent.
+ *
+ * Squaring uses the multiplication, and RSA private key operations reach
+ * the exponentiation through BN_mod_exp_mont_consttime() like any other
+ * caller; there is no separate squaring or RSA-specific kernel.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/crypto.h>
+
+#include "bn_lcl.h"
+
+#ifdef BN_MONT_X86_64
+
+#include "cryptlib.h"
+#include "x86_arch.h"
+
+#define BN_MONT_X86_64_MAX_WORDS	128
+#define BN_MONT_X86_64_WINDOW		5
+
+static int
+bn_mont_x86_64_available(int num)
+{
+	uint64_t caps_ext = OPENSSL_cpu_caps_ext();
+
+	if ((caps_ext & CPUCAP_EXT_MASK_BMI2) == 0 ||
+	    (caps_ext & CPUCAP_EXT_MASK_ADX) == 0)
+		return 0;
+
+	return num >= 8 && num <= BN_MONT_X86_64_MAX_WORDS && num % 4 == 0;
+}
+
+/*
+ * One CIOS iteration on the num + 2 word accumulator t:
+ *
+ *	t = (t + a * b + m * n) / 2^64, with m = (t + a * b) * n0 mod 2^64
+ *
+ * The reduction stores word j at t[j - 1], so t[-1] must be writable.
+ */
+static inline void
+bn_mont_row(BN_ULONG *t, const BN_ULONG *ap, BN_ULONG b,
+    const BN_ULONG *np, BN_ULONG n0, size_t num)
+{
+	size_t n4 = num / 4;
+
+	__asm__ volatile (
+	    /* t += a * b */
+	    "	movq	%[b], %%rdx\n"
+	    "	movq	%[ap], %%rsi\n"
+	    "	movq	%[t], %%rdi\n"
+	    "	movq	%[n4], %%rcx\n"
+	    "	xorl	%%r9d, %%r9d\n"
+	    "1:\n"
+	    "	mulxq	0(%%rsi), %%r10, %%r11\n"
+	    "	movq	0(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r9, %%r12\n"
+	    "	movq	%%r12, 0(%%rdi)\n"
+	    "	mulxq	8(%%rsi), %%r10, %%r9\n"
+	    "	movq	8(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r11, %%r12\n"
+	    "	movq	%%r12, 8(%%rdi)\n"
+	    "	mulxq	16(%%rsi), %%r10, %%r11\n"
+	    "	movq	16(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r9, %%r12\n"
+	    "	movq	%%r12, 16(%%rdi)\n"
+	    "	mulxq	24(%%rsi), %%r10, %%r9\n"
+	    "	movq	24(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r11, %%r12\n"
+	    "	movq	%%r12, 24(%%rdi)\n"
+	    "	leaq	32(%%rsi), %%rsi\n"
+	    "	leaq	32(%%rdi), %%rdi\n"
+	    "	leaq	-1(%%rcx), %%rcx\n"
+	    "	jrcxz	2f\n"
+	    "	jmp	1b\n"
+	    "2:\n"
+	    "	movq	$0, %%r10\n"
+	    "	movq	0(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r9, %%r12\n"
+	    "	movq	%%r12, 0(%%rdi)\n"
+	    "	movq	$0, %%r11\n"
+	    "	adcxq	%%r10, %%r11\n"
+	    "	adoxq	%%r10, %%r11\n"
+	    "	movq	%%r11, 8(%%rdi)\n"
+
+	    /* t = (t + m * n) / 2^64 */
+	    "	movq	%[t], %%rdi\n"
+	    "	movq	0(%%rdi), %%rdx\n"
+	    "	imulq	%[n0], %%rdx\n"
+	    "	movq	%[np], %%rsi\n"
+	    "	movq	%[n4], %%rcx\n"
+	    "	xorl	%%r9d, %%r9d\n"
+	    "3:\n"
+	    "	mulxq	0(%%rsi), %%r10, %%r11\n"
+	    "	movq	0(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r9, %%r12\n"
+	    "	movq	%%r12, -8(%%rdi)\n"
+	    "	mulxq	8(%%rsi), %%r10, %%r9\n"
+	    "	movq	8(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r11, %%r12\n"
+	    "	movq	%%r12, 0(%%rdi)\n"
+	    "	mulxq	16(%%rsi), %%r10, %%r11\n"
+	    "	movq	16(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r9, %%r12\n"
+	    "	movq	%%r12, 8(%%rdi)\n"
+	    "	mulxq	24(%%rsi), %%r10, %%r9\n"
+	    "	movq	24(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r11, %%r12\n"
+	    "	movq	%%r12, 16(%%rdi)\n"
+	    "	leaq	32(%%rsi), %%rsi\n"
+	    "	leaq	32(%%rdi), %%rdi\n"
+	    "	leaq	-1(%%rcx), %%rcx\n"
+	    "	jrcxz	4f\n"
+	    "	jmp	3b\n"
+	    "4:\n"
+	    "	movq	$0, %%r10\n"
+	    "	movq	0(%%rdi), %%r12\n"
+	    "	adcxq	%%r10, %%r12\n"
+	    "	adoxq	%%r9, %%r12\n"
+	    "	movq	%%r12, -8(%%rdi)\n"
+	    "	movq	8(%%rdi), %%r11\n"
+	    "	adcxq	%%r10, %%r11\n"
+	    "	adoxq	%%r10, %%r11\n"
+	    "	movq	%%r11, 0(%%rdi)\n"
+	    "	movq	%%r10, 8(%%rdi)\n"
+	    :
+	    : [t] "r" (t), [ap] "r" (ap), [b] "r" (b), [np] "r" (np),
+	      [n0] "r" (n0), [n4] "r" (n4)
+	    : "rcx", "rdx", "rsi", "rdi", "r9", "r10", "r11", "r12",
+	      "cc", "memory");
+}
+
+/*
+ * rp = ap * bp / 2^(64 * num) mod np, for ap, bp < np. rp may alias either
+ * input.
+ */
+static void
+bn_mont_mul(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp,
+    const BN_ULONG *np, BN_ULONG n0, int num)
+{
+	BN_ULONG tbuf[BN_MONT_X86_64_MAX_WORDS + 3];
+	BN_ULONG sub[BN_MONT_X86_64_MAX_WORDS];
+	BN_ULONG *t = tbuf + 1, mask;
+	int i;
+
+	memset(tbuf, 0, (num + 3) * sizeof(BN_ULONG));
+	for (i = 0; i < num; i++)
+		bn_mont_row(t, ap, bp[i], np, n0, num);
+
+	/*
+	 * t < 2 * np, so subtract np unless that borrows more than t[num]
+	 * can cover, selecting the result without branching.
+	 */
+	mask = t[num] - bn_sub_words(sub, t, np, num);
+	for (i = 0; i < num; i++)
+		rp[i] = (t[i] & mask) | (sub[i] & ~mask);
+
+	explicit_bzero(tbuf, (num + 3) * sizeof(BN_ULONG));
+	explicit_bzero(sub, num * sizeof(BN_ULONG));
+}
+
+int
+bn_mul_mont_x86_64(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp,
+    const BN_ULONG *np, const BN_ULONG *n0, int num)
+{
+	if (!bn_mont_x86_64_available(num))
+		return 0;
+
+	bn_mont_mul(rp, ap, bp, np, n0[0], num);
+
+	return 1;
+}
+
+/*
+ * Copy entry idx of the table of powers to out, reading every entry.
+ */
+static void
+bn_mont_gather(BN_ULONG *out, const BN_ULONG *table, int num, int idx)
+{
+	BN_ULONG d, mask;
+	int i, j;
+
+	memset(out, 0, num * sizeof(BN_ULONG));
+	for (i = 0; i < (1 << BN_MONT_X86_64_WINDOW); i++) {
+		d = (BN_ULONG)(i ^ idx);
+		mask = 0 - (((d - 1) & ~d) >> (BN_BITS2 - 1));
+		for (j = 0; j < num; j++)
+			out[j] |= table[i * num + j] & mask;
+	}
+}
+
+int
+bn_mod_exp_mont_x86_64(BN_ULONG *rp, const BN_ULONG *am, const BIGNUM *p,
+    BN_ULONG *table, const BN_ULONG *np, const BN_ULONG *n0, int num)
+{
+	BN_ULONG tmp[BN_MONT_X86_64_MAX_WORDS];
+	int bits, i, wvalue;
+
+	if (!bn_mont_x86_64_available(num))
+		return 0;
+
+	/* table[i] = am^i, with table[0] being one in Montgomery form. */
+	memcpy(&table[0], rp, num * sizeof(BN_ULONG));
+	memcpy(&table[num], am, num * sizeof(BN_ULONG));
+	for (i = 2; i < (1 << BN_MONT_X86_64_WINDOW); i++) {
+		if (i % 2 == 0)
+			bn_mont_mul(&table[i * num], &table[i / 2 * num],
+			    &table[i / 2 * num], np, n0[0], num);
+		else
+			bn_mont_mul(&table[i * num], &table[(i - 1) * num],
+			    am, np, n0[0], num);
+	}
+
+	bits = BN_num_bits(p) - 1;
+	for (wvalue = 0, i = bits % BN_MONT_X86_64_WINDOW; i >= 0;
+	    i--, bits--)
+		wvalue = (wvalue << 1) + BN_is_bit_set(p, bits);
+	bn_mont_gather(rp, table, num, wvalue);
+
+	while (bits >= 0) {
+		for (wvalue = 0, i = 0; i < BN_MONT_X86_64_WINDOW;
+		    i++, bits--) {
+			bn_mont_mul(rp, rp, rp, np, n0[0], num);
+			wvalue = (wvalue << 1) + BN_is_bit_set(p, bits);
+		}
+		bn_mont_gather(tmp, table, num, wvalue);
+		bn_mont_mul(rp, rp, tmp, np, n0[0], num);
+	}
+
+	explicit_bzero(tmp, num * sizeof(BN_ULONG));
+
+	return 1;
+}
+
+#endif /* BN_MONT_X86_64 */
@@ -139,6 +139,15 @@ BN_mod_mul_montgomery(BIGNUM *r, const BIGNUM *a, const BIGNUM *b,
 	if (num > 1 && a->top == num && b->top == num) {
 		if (bn_wexpand(r, num) == NULL)
 			return (0);
+#ifdef BN_MONT_X86_64
+		if (bn_mul_mont_x86_64(r->d, a->d, b->d, mont->N.d, mont->n0,
+		    num)) {
+			r->neg = a->neg^b->neg;
+			r->top = num;
+			bn_correct_top(r);
+			return (1);
+		}
+#endif
 		if (bn_mul_mont(r->d, a->d, b->d, mont->N.d, mont->n0, num)) {
 			r->neg = a->neg^b->neg;
 			r->top = num;
@@ -512,6 +521,12 @@ BN_MONT_CTX_set_locked(BN_MONT_CTX **pmont, int lock, const BIGNUM *mod,
 	int got_write_lock = 0;
 	BN_MONT_CTX *ret;
 
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+	/* Once set, *pmont never changes, so there is no need to lock. */
+	if ((ret = __atomic_load_n(pmont, __ATOMIC_ACQUIRE)) != NULL)
+		return ret;
+#endif
+
 	CRYPTO_r_lock(lock);
 	if (!*pmont) {
 		CRYPTO_r_unlock(lock);
@@ -522,8 +537,13 @@ BN_MONT_CTX_set_locked(BN_MONT_CTX **pmont, int lock, const BIGNUM *mod,
 			ret = BN_MONT_CTX_new();
 			if (ret && !BN_MONT_CTX_set(ret, mod, ctx))
 				BN_MONT_CTX_free(ret);
-			else
+			else {
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+				__atomic_store_n(pmont, ret, __ATOMIC_RELEASE);
+#else
 				*pmont = ret;
+#endif
+			}
 		}
 	}
 
@@ -0,0 +1,365 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Multi-block ChaCha20 for x86_64, processing 4 (SSSE3), 8 (AVX2) or 16
+ * (AVX-512) blocks in parallel. Each vector register holds the same state
+ * word for every block, so the quarter rounds operate on all blocks at once
+ * and the keystream is transposed back into block order before being
+ * combined with the input.
+ */
+
+#include <stdint.h>
+
+#include <openssl/crypto.h>
+
+#include "chacha_internal.h"
+
+#ifdef CHACHA_X86_64
+
+#include <immintrin.h>
+
+#include "cryptlib.h"
+#include "x86_arch.h"
+
+#define CHACHA_ROUNDS	20
+
+#define CHACHA_QUARTERROUND(add, xor, rotl, a, b, c, d) do {		\
+	a = add(a, b); d = rotl(xor(d, a), 16);				\
+	c = add(c, d); b = rotl(xor(b, c), 12);				\
+	a = add(a, b); d = rotl(xor(d, a), 8);				\
+	c = add(c, d); b = rotl(xor(b, c), 7);				\
+} while (0)
+
+#define CHACHA_DOUBLEROUND(add, xor, rotl, x) do {			\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[0], x[4], x[8], x[12]);	\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[1], x[5], x[9], x[13]);	\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[2], x[6], x[10], x[14]);	\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[3], x[7], x[11], x[15]);	\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[0], x[5], x[10], x[15]);	\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[1], x[6], x[11], x[12]);	\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[2], x[7], x[8], x[13]);	\
+	CHACHA_QUARTERROUND(add, xor, rotl, x[3], x[4], x[9], x[14]);	\
+} while (0)
+
+/*
+ * SSSE3, four blocks. Rotations by 16 and 8 bits are byte shuffles.
+ */
+
+#define SSSE3_ATTR	__attribute__((__target__("ssse3")))
+
+static inline __m128i SSSE3_ATTR
+chacha_rotl_ssse3(__m128i v, int n)
+{
+	if (n == 16)
+		return _mm_shuffle_epi8(v, _mm_set_epi8(13, 12, 15, 14,
+		    9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+	if (n == 8)
+		return _mm_shuffle_epi8(v, _mm_set_epi8(14, 13, 12, 15,
+		    10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3));
+	return _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - n));
+}
+
+/* Transpose four words of four blocks and XOR them into 16 bytes each. */
+static inline void SSSE3_ATTR
+chacha_xor4_ssse3(const uint8_t *in, uint8_t *out, __m128i a, __m128i b,
+    __m128i c, __m128i d)
+{
+	__m128i t0, t1, t2, t3;
+
+	t0 = _mm_unpacklo_epi32(a, b);
+	t1 = _mm_unpacklo_epi32(c, d);
+	t2 = _mm_unpackhi_epi32(a, b);
+	t3 = _mm_unpackhi_epi32(c, d);
+
+	a = _mm_unpacklo_epi64(t0, t1);
+	b = _mm_unpackhi_epi64(t0, t1);
+	c = _mm_unpacklo_epi64(t2, t3);
+	d = _mm_unpackhi_epi64(t2, t3);
+
+	_mm_storeu_si128((__m128i *)(out + 0 * 64), _mm_xor_si128(a,
+	    _mm_loadu_si128((const __m128i *)(in + 0 * 64))));
+	_mm_storeu_si128((__m128i *)(out + 1 * 64), _mm_xor_si128(b,
+	    _mm_loadu_si128((const __m128i *)(in + 1 * 64))));
+	_mm_storeu_si128((__m128i *)(out + 2 * 64), _mm_xor_si128(c,
+	    _mm_loadu_si128((const __m128i *)(in + 2 * 64))));
+	_mm_storeu_si128((__m128i *)(out + 3 * 64), _mm_xor_si128(d,
+	    _mm_loadu_si128((const __m128i *)(in + 3 * 64))));
+}
+
+static void SSSE3_ATTR
+chacha_blocks_ssse3(uint32_t input[16], const uint8_t *in, uint8_t *out,
+    size_t blocks)
+{
+	__m128i j[16], x[16];
+	int i;
+
+	for (i = 0; i < 16; i++)
+		j[i] = _mm_set1_epi32(input[i]);
+	j[12] = _mm_add_epi32(j[12], _mm_set_epi32(3, 2, 1, 0));
+
+	for (; blocks >= 4; blocks -= 4) {
+		for (i = 0; i < 16; i++)
+			x[i] = j[i];
+		for (i = 0; i < CHACHA_ROUNDS; i += 2)
+			CHACHA_DOUBLEROUND(_mm_add_epi32, _mm_xor_si128,
+			    chacha_rotl_ssse3, x);
+		for (i = 0; i < 16; i++)
+			x[i] = _mm_add_epi32(x[i], j[i]);
+
+		for (i = 0; i < 16; i += 4)
+			chacha_xor4_ssse3(in + i * 4, out + i * 4, x[i],
+			    x[i + 1], x[i + 2], x[i + 3]);
+
+		j[12] = _mm_add_epi32(j[12], _mm_set1_epi32(4));
+		input[12] += 4;
+		in += 4 * 64;
+		out += 4 * 64;
+	}
+}
+
+/*
+ * AVX2, eight blocks. The low 128 bits of each register hold blocks 0-3 and
+ * the high 128 bits hold blocks 4-7.
+ */
+
+#define AVX2_ATTR	__attribute__((__target__("avx2")))
+
+static inline __m256i AVX2_ATTR
+chacha_rotl_avx2(__m256i v, int n)
+{
+	if (n == 16)
+		return _mm256_shuffle_epi8(v, _mm256_set_epi8(
+		    13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+		    13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+	if (n == 8)
+		return _mm256_shuffle_epi8(v, _mm256_set_epi8(
+		    14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+		    14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3));
+	return _mm256_or_si256(_mm256_slli_epi32(v, n),
+	    _mm256_srli_epi32(v, 32 - n));
+}
+
+/* Transpose 4x4 words within each 128 bit lane. */
+static inline void AVX2_ATTR
+chacha_transpose_avx2(__m256i x[4])
+{
+	__m256i t0, t1, t2, t3;
+
+	t0 = _mm256_unpacklo_epi32(x[0], x[1]);
+	t1 = _mm256_unpacklo_epi32(x[2], x[3]);
+	t2 = _mm256_unpackhi_epi32(x[0], x[1]);
+	t3 = _mm256_unpackhi_epi32(x[2], x[3]);
+
+	x[0] = _mm256_unpacklo_epi64(t0, t1);
+	x[1] = _mm256_unpackhi_epi64(t0, t1);
+	x[2] = _mm256_unpacklo_epi64(t2, t3);
+	x[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+static inline void AVX2_ATTR
+chacha_xor32_avx2(const uint8_t *in, uint8_t *out, __m256i v)
+{
+	_mm256_storeu_si256((__m256i *)out, _mm256_xor_si256(v,
+	    _mm256_loadu_si256((const __m256i *)in)));
+}
+
+static void AVX2_ATTR
+chacha_blocks_avx2(uint32_t input[16], const uint8_t *in, uint8_t *out,
+    size_t blocks)
+{
+	__m256i j[16], x[16];
+	int i, k;
+
+	for (i = 0; i < 16; i++)
+		j[i] = _mm256_set1_epi32(input[i]);
+	j[12] = _mm256_add_epi32(j[12],
+	    _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+	for (; blocks >= 8; blocks -= 8) {
+		for (i = 0; i < 16; i++)
+			x[i] = j[i];
+		for (i = 0; i < CHACHA_ROUNDS; i += 2)
+			CHACHA_DOUBLEROUND(_mm256_add_epi32, _mm256_xor_si256,
+			    chacha_rotl_avx2, x);
+		for (i = 0; i < 16; i++)
+			x[i] = _mm256_add_epi32(x[i], j[i]);
+
+		/*
+		 * After the transposes, x[4g + k] holds words 4g..4g+3 of
+		 * block k in its low half and of block k + 4 in its high half.
+		 */
+		for (i = 0; i < 16; i += 4)
+			chacha_transpose_avx2(&x[i]);
+		for (k = 0; k < 4; k++) {
+			chacha_xor32_avx2(in + k * 64, out + k * 64,
+			    _mm256_permute2x128_si256(x[k], x[4 + k], 0x20));
+			chacha_xor32_avx2(in + k * 64 + 32, out + k * 64 + 32,
+			    _mm256_permute2x128_si256(x[8 + k], x[12 + k],
+			    0x20));
+			chacha_xor32_avx2(in + (k + 4) * 64,
+			    out + (k + 4) * 64,
+			    _mm256_permute2x128_si256(x[k], x[4 + k], 0x31));
+			chacha_xor32_avx2(in + (k + 4) * 64 + 32,
+			    out + (k + 4) * 64 + 32,
+			    _mm256_permute2x128_si256(x[8 + k], x[12 + k],
+			    0x31));
+		}
+
+		j[12] = _mm256_add_epi32(j[12], _mm256_set1_epi32(8));
+		input[12] += 8;
+		in += 8 * 64;
+		out += 8 * 64;
+	}
+}
+
+/*
+ * AVX-512, sixteen blocks. 128 bit lane L of each register holds blocks
+ * 4L to 4L+3.
+ */
+
+#define AVX512_ATTR	__attribute__((__target__("avx512f")))
+
+static inline __m512i AVX512_ATTR
+chacha_rotl_avx512(__m512i v, int n)
+{
+	switch (n) {
+	case 16:
+		return _mm512_rol_epi32(v, 16);
+	case 12:
+		return _mm512_rol_epi32(v, 12);
+	case 8:
+		return _mm512_rol_epi32(v, 8);
+	default:
+		return _mm512_rol_epi32(v, 7);
+	}
+}
+
+static inline void AVX512_ATTR
+chacha_transpose_avx512(__m512i x[4])
+{
+	__m512i t0, t1, t2, t3;
+
+	t0 = _mm512_unpacklo_epi32(x[0], x[1]);
+	t1 = _mm512_unpacklo_epi32(x[2], x[3]);
+	t2 = _mm512_unpackhi_epi32(x[0], x[1]);
+	t3 = _mm512_unpackhi_epi32(x[2], x[3]);
+
+	x[0] = _mm512_unpacklo_epi64(t0, t1);
+	x[1] = _mm512_unpackhi_epi64(t0, t1);
+	x[2] = _mm512_unpacklo_epi64(t2, t3);
+	x[3] = _mm512_unpackhi_epi64(t2, t3);
+}
+
+static inline void AVX512_ATTR
+chacha_xor64_avx512(const uint8_t *in, uint8_t *out, __m512i v)
+{
+	_mm512_storeu_si512((void *)out, _mm512_xor_si512(v,
+	    _mm512_loadu_si512((const void *)in)));
+}
+
+static void AVX512_ATTR
+chacha_blocks_avx512(uint32_t input[16], const uint8_t *in, uint8_t *out,
+    size_t blocks)
+{
+	__m512i j[16], x[16];
+	__m512i a, b, c, d, t0, t1, t2, t3;
+	int i, k;
+
+	for (i = 0; i < 16; i++)
+		j[i] = _mm512_set1_epi32(input[i]);
+	j[12] = _mm512_add_epi32(j[12], _mm512_set_epi32(15, 14, 13, 12,
+	    11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+
+	for (; blocks >= 16; blocks -= 16) {
+		for (i = 0; i < 16; i++)
+			x[i] = j[i];
+		for (i = 0; i < CHACHA_ROUNDS; i += 2)
+			CHACHA_DOUBLEROUND(_mm512_add_epi32, _mm512_xor_si512,
+			    chacha_rotl_avx512, x);
+		for (i = 0; i < 16; i++)
+			x[i] = _mm512_add_epi32(x[i], j[i]);
+
+		/*
+		 * After the transposes, lane L of x[4g + k] holds words
+		 * 4g..4g+3 of block 4L + k. Gathering lane L from the four
+		 * groups yields the complete block.
+		 */
+		for (i = 0; i < 16; i += 4)
+			chacha_transpose_avx512(&x[i]);
+		for (k = 0; k < 4; k++) {
+			a = x[k];
+			b = x[4 + k];
+			c = x[8 + k];
+			d = x[12 + k];
+
+			t0 = _mm512_shuffle_i32x4(a, b, 0x44);
+			t1 = _mm512_shuffle_i32x4(c, d, 0x44);
+			t2 = _mm512_shuffle_i32x4(a, b, 0xee);
+			t3 = _mm512_shuffle_i32x4(c, d, 0xee);
+
+			chacha_xor64_avx512(in + k * 64, out + k * 64,
+			    _mm512_shuffle_i32x4(t0, t1, 0x88));
+			chacha_xor64_avx512(in + (k + 4) * 64,
+			    out + (k + 4) * 64,
+			    _mm512_shuffle_i32x4(t0, t1, 0xdd));
+			chacha_xor64_avx512(in + (k + 8) * 64,
+			    out + (k + 8) * 64,
+			    _mm512_shuffle_i32x4(t2, t3, 0x88));
+			chacha_xor64_avx512(in + (k + 12) * 64,
+			    out + (k + 12) * 64,
+			    _mm512_shuffle_i32x4(t2, t3, 0xdd));
+		}
+
+		j[12] = _mm512_add_epi32(j[12], _mm512_set1_epi32(16));
+		input[12] += 16;
+		in += 16 * 64;
+		out += 16 * 64;
+	}
+}
+
+size_t
+chacha_blocks_x86_64(uint32_t input[16], const uint8_t *in, uint8_t *out,
+    size_t blocks)
+{
+	uint64_t caps = OPENSSL_cpu_caps();
+	uint64_t caps_ext = OPENSSL_cpu_caps_ext();
+	size_t done, n;
+
+	/* Leave blocks that would wrap the 32 bit counter to the caller. */
+	if (blocks > UINT32_MAX - input[12])
+		blocks = UINT32_MAX - input[12];
+
+	done = 0;
+	if ((caps_ext & CPUCAP_EXT_MASK_AVX512F) != 0) {
+		n = (blocks - done) & ~(size_t)15;
+		chacha_blocks_avx512(input, in, out, n);
+		done += n;
+	}
+	if ((caps_ext & CPUCAP_EXT_MASK_AVX2) != 0) {
+		n = (blocks - done) & ~(size_t)7;
+		chacha_blocks_avx2(input, in + done * 64, out + done * 64, n);
+		done += n;
+	}
+	if ((caps & CPUCAP_MASK_SSSE3) != 0) {
+		n = (blocks - done) & ~(size_t)3;
+		chacha_blocks_ssse3(input, in + done * 64, out + done * 64, n);
+		done += n;
+	}
+
+	return done;
+}
+
+#endif /* CHACHA_X86_64 */
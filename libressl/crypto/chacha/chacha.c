@@ -20,6 +20,25 @@
 #include <openssl/chacha.h>
 
 #include "chacha-merged.c"
+#include "chacha_internal.h"
+
+static void
+chacha_encrypt(chacha_ctx *ctx, const u8 *in, u8 *out, size_t len)
+{
+#ifdef CHACHA_X86_64
+	size_t blocks;
+
+	if (len >= 4 * CHACHA_BLOCKLEN) {
+		blocks = chacha_blocks_x86_64(ctx->input, in, out,
+		    len / CHACHA_BLOCKLEN);
+		in += blocks * CHACHA_BLOCKLEN;
+		out += blocks * CHACHA_BLOCKLEN;
+		len -= blocks * CHACHA_BLOCKLEN;
+	}
+#endif
+
+	chacha_encrypt_bytes(ctx, in, out, (uint32_t)len);
+}
 
 void
 ChaCha_set_key(ChaCha_ctx *ctx, const unsigned char *key, uint32_t keybits)
@@ -52,7 +71,7 @@ ChaCha(ChaCha_ctx *ctx, unsigned char *out, const unsigned char *in, size_t len)
 		len -= l;
 	}
 
-	chacha_encrypt_bytes((chacha_ctx *)ctx, in, out, (uint32_t)len);
+	chacha_encrypt((chacha_ctx *)ctx, in, out, len);
 }
 
 void
@@ -73,7 +92,7 @@ CRYPTO_chacha_20(unsigned char *out, const unsigned char *in, size_t len,
 		ctx.input[13] = (uint32_t)(counter >> 32);
 	}
 
-	chacha_encrypt_bytes(&ctx, in, out, (uint32_t)len);
+	chacha_encrypt(&ctx, in, out, len);
 }
 
 void
@@ -0,0 +1,44 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef HEADER_CHACHA_INTERNAL_H
+#define HEADER_CHACHA_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_HIDDEN_DECLS
+
+/*
+ * The multi-block x86_64 implementations use compiler intrinsics and are
+ * selected at runtime based on OPENSSL_cpu_caps() and OPENSSL_cpu_caps_ext().
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && \
+    defined(OPENSSL_CPUID_OBJ) && !defined(OPENSSL_NO_ASM)
+#define CHACHA_X86_64
+
+/*
+ * Encrypt as many of the given 64 byte blocks as the available SIMD
+ * implementations can handle, advancing the block counter in input[12].
+ * Returns the number of blocks processed, which may be zero. Blocks are
+ * never processed if doing so would carry into input[13].
+ */
+size_t chacha_blocks_x86_64(uint32_t input[16], const uint8_t *in,
+    uint8_t *out, size_t blocks);
+#endif
+
+__END_HIDDEN_DECLS
+
+#endif /* HEADER_CHACHA_INTERNAL_H */
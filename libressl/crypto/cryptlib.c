@@ -124,6 +124,9 @@
 #include <openssl/opensslconf.h>
 #include <openssl/crypto.h>
 
+#include "cryptlib.h"
+#include "x86_arch.h"
+
 static void (*locking_callback)(int mode, int type,
     const char *file, int line) = NULL;
 static int (*add_lock_callback)(int *pointer, int amount,
@@ -305,6 +308,7 @@ CRYPTO_THREADID_hash(const CRYPTO_THREADID *id)
 	defined(__x86_64) || defined(__x86_64__) || defined(_M_AMD64) || defined(_M_X64)
 
 uint64_t OPENSSL_ia32cap_P;
+uint64_t OPENSSL_ia32cap_ext_P;
 
 uint64_t
 OPENSSL_cpu_caps(void)
@@ -312,8 +316,67 @@ OPENSSL_cpu_caps(void)
 	return OPENSSL_ia32cap_P;
 }
 
+uint64_t
+OPENSSL_cpu_caps_ext(void)
+{
+	return OPENSSL_ia32cap_ext_P;
+}
+
+/*
+ * Clear capabilities, so that regress tests can check the code that is used
+ * on machines without them. This is not exported from the shared library.
+ */
+void
+OPENSSL_cpu_caps_clear(uint64_t caps, uint64_t caps_ext)
+{
+	OPENSSL_cpuid_setup();
+	OPENSSL_ia32cap_P &= ~caps;
+	OPENSSL_ia32cap_ext_P &= ~caps_ext;
+}
+
 #if defined(OPENSSL_CPUID_OBJ) && !defined(OPENSSL_NO_ASM)
 #define OPENSSL_CPUID_SETUP
+
+#if defined(__GNUC__)
+#include <cpuid.h>
+
+/*
+ * Query the structured extended feature flags, which OPENSSL_ia32_cpuid()
+ * does not cover. AVX2 and AVX-512 are only reported if the operating
+ * system saves the YMM, respectively opmask and ZMM, register state.
+ */
+static uint64_t
+OPENSSL_ia32_cpuid_ext(uint64_t caps)
+{
+	unsigned int eax, ebx, ecx, edx;
+	uint64_t ext;
+
+	if (__get_cpuid_max(0, NULL) < 7)
+		return 0;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	ext = (uint64_t)ecx << 32 | ebx;
+
+	/* The AVX bit is only set if XCR0 enables the SSE and YMM state. */
+	if ((caps & CPUCAP_MASK_AVX) == 0) {
+		ext &= ~(CPUCAP_EXT_MASK_AVX2 | CPUCAP_EXT_MASK_AVX512 |
+		    CPUCAP_EXT_MASK_VAES | CPUCAP_EXT_MASK_VPCLMULQDQ);
+		return ext;
+	}
+	__asm__ volatile (".byte 0x0f,0x01,0xd0" /* xgetbv */
+	    : "=a" (eax), "=d" (edx) : "c" (0));
+	if ((eax & 0xe6) != 0xe6)
+		ext &= ~CPUCAP_EXT_MASK_AVX512;
+
+	return ext;
+}
+#else
+static uint64_t
+OPENSSL_ia32_cpuid_ext(uint64_t caps)
+{
+	return 0;
+}
+#endif
+
 void
 OPENSSL_cpuid_setup(void)
 {
@@ -324,6 +387,7 @@ OPENSSL_cpuid_setup(void)
 		return;
 	trigger = 1;
 	OPENSSL_ia32cap_P = OPENSSL_ia32_cpuid();
+	OPENSSL_ia32cap_ext_P = OPENSSL_ia32_cpuid_ext(OPENSSL_ia32cap_P);
 }
 #endif
 
@@ -333,6 +397,17 @@ OPENSSL_cpu_caps(void)
 {
 	return 0;
 }
+
+uint64_t
+OPENSSL_cpu_caps_ext(void)
+{
+	return 0;
+}
+
+void
+OPENSSL_cpu_caps_clear(uint64_t caps, uint64_t caps_ext)
+{
+}
 #endif
 
 #if !defined(OPENSSL_CPUID_SETUP) && !defined(OPENSSL_CPUID_OBJ)
@@ -59,6 +59,8 @@
 #ifndef HEADER_CRYPTLIB_H
 #define HEADER_CRYPTLIB_H
 
+#include <stdint.h>
+
 #include <openssl/opensslconf.h>
 
 #ifdef  __cplusplus
@@ -73,6 +75,8 @@ extern "C" {
 #define X509_CERT_FILE_EVP       "SSL_CERT_FILE"
 
 void OPENSSL_cpuid_setup(void);
+uint64_t OPENSSL_cpu_caps_ext(void);
+void OPENSSL_cpu_caps_clear(uint64_t caps, uint64_t caps_ext);
 
 #ifdef  __cplusplus
 }
@@ -80,10 +80,23 @@ CRYPTO_lock(int mode, int type, const char *file, int line)
 		(void) pthread_mutex_unlock(&locks[type]);
 }
 
+/*
+ * Reference counts are updated atomically where the compiler supports it, as
+ * is already the case on Windows, instead of serialising every update through
+ * one of a handful of global locks. Increments need no ordering, while a
+ * decrement has to make prior writes visible to whoever drops the last
+ * reference and frees the object.
+ */
 int
 CRYPTO_add_lock(int *pointer, int amount, int type, const char *file,
     int line)
 {
+#if defined(__ATOMIC_RELAXED) && defined(__ATOMIC_ACQ_REL)
+	if (amount > 0)
+		return __atomic_add_fetch(pointer, amount, __ATOMIC_RELAXED);
+
+	return __atomic_add_fetch(pointer, amount, __ATOMIC_ACQ_REL);
+#else
 	int ret;
 
 	CRYPTO_lock(CRYPTO_LOCK|CRYPTO_WRITE, type, file, line);
@@ -92,4 +105,5 @@ CRYPTO_add_lock(int *pointer, int amount, int type, const char *file,
 	CRYPTO_lock(CRYPTO_UNLOCK|CRYPTO_WRITE, type, file, line);
 
 	return (ret);
+#endif
 }
@@ -0,0 +1,339 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * X25519 scalar multiplication using 64 bit limbs in radix 2^51. Products
+ * are accumulated in unsigned __int128, so this is only built on targets
+ * whose compiler provides that type.
+ *
+ * Field elements are kept loosely reduced: after fe51_mul, fe51_sq and
+ * fe51_mul121666 every limb is below 2^51 + 2^18. fe51_add of two such
+ * values stays below 2^53 and fe51_sub adds 2p before subtracting, so
+ * every input to a multiplication is below 2^54 and no 128 bit
+ * accumulator can overflow.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "curve25519_internal.h"
+
+#ifdef CURVE25519_FE51
+
+typedef unsigned __int128 uint128_t;
+typedef uint64_t fe51[5];
+
+#define FE51_MASK	((UINT64_C(1) << 51) - 1)
+
+static uint64_t
+fe51_load64(const uint8_t *in)
+{
+	return (uint64_t)in[0] | (uint64_t)in[1] << 8 |
+	    (uint64_t)in[2] << 16 | (uint64_t)in[3] << 24 |
+	    (uint64_t)in[4] << 32 | (uint64_t)in[5] << 40 |
+	    (uint64_t)in[6] << 48 | (uint64_t)in[7] << 56;
+}
+
+static void
+fe51_store64(uint8_t *out, uint64_t v)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		out[i] = v & 0xff;
+		v >>= 8;
+	}
+}
+
+/* Decode 32 bytes, ignoring the most significant bit. */
+static void
+fe51_frombytes(fe51 h, const uint8_t s[32])
+{
+	uint64_t w0, w1, w2, w3;
+
+	w0 = fe51_load64(s);
+	w1 = fe51_load64(s + 8);
+	w2 = fe51_load64(s + 16);
+	w3 = fe51_load64(s + 24);
+
+	h[0] = w0 & FE51_MASK;
+	h[1] = (w0 >> 51 | w1 << 13) & FE51_MASK;
+	h[2] = (w1 >> 38 | w2 << 26) & FE51_MASK;
+	h[3] = (w2 >> 25 | w3 << 39) & FE51_MASK;
+	h[4] = (w3 >> 12) & FE51_MASK;
+}
+
+static void
+fe51_carry(fe51 h)
+{
+	h[1] += h[0] >> 51;
+	h[0] &= FE51_MASK;
+	h[2] += h[1] >> 51;
+	h[1] &= FE51_MASK;
+	h[3] += h[2] >> 51;
+	h[2] &= FE51_MASK;
+	h[4] += h[3] >> 51;
+	h[3] &= FE51_MASK;
+	h[0] += 19 * (h[4] >> 51);
+	h[4] &= FE51_MASK;
+}
+
+/* Encode the fully reduced value of h. */
+static void
+fe51_tobytes(uint8_t s[32], const fe51 f)
+{
+	fe51 h;
+	uint64_t q;
+
+	memcpy(h, f, sizeof(h));
+	fe51_carry(h);
+	fe51_carry(h);
+
+	/* q is 1 if h >= p = 2^255 - 19, otherwise 0. */
+	q = (h[0] + 19) >> 51;
+	q = (h[1] + q) >> 51;
+	q = (h[2] + q) >> 51;
+	q = (h[3] + q) >> 51;
+	q = (h[4] + q) >> 51;
+
+	/* Subtract p by adding 19 and dropping 2^255. */
+	h[0] += 19 * q;
+	h[1] += h[0] >> 51;
+	h[0] &= FE51_MASK;
+	h[2] += h[1] >> 51;
+	h[1] &= FE51_MASK;
+	h[3] += h[2] >> 51;
+	h[2] &= FE51_MASK;
+	h[4] += h[3] >> 51;
+	h[3] &= FE51_MASK;
+	h[4] &= FE51_MASK;
+
+	fe51_store64(s, h[0] | h[1] << 51);
+	fe51_store64(s + 8, h[1] >> 13 | h[2] << 38);
+	fe51_store64(s + 16, h[2] >> 26 | h[3] << 25);
+	fe51_store64(s + 24, h[3] >> 39 | h[4] << 12);
+}
+
+static void
+fe51_add(fe51 h, const fe51 f, const fe51 g)
+{
+	h[0] = f[0] + g[0];
+	h[1] = f[1] + g[1];
+	h[2] = f[2] + g[2];
+	h[3] = f[3] + g[3];
+	h[4] = f[4] + g[4];
+}
+
+/* h = f - g, computed as f + 2p - g so that no limb goes negative. */
+static void
+fe51_sub(fe51 h, const fe51 f, const fe51 g)
+{
+	h[0] = f[0] + 0xfffffffffffdaULL - g[0];
+	h[1] = f[1] + 0xffffffffffffeULL - g[1];
+	h[2] = f[2] + 0xffffffffffffeULL - g[2];
+	h[3] = f[3] + 0xffffffffffffeULL - g[3];
+	h[4] = f[4] + 0xffffffffffffeULL - g[4];
+}
+
+/* Carry the five accumulators of a product into h. */
+static inline void
+fe51_reduce(fe51 h, uint128_t t0, uint128_t t1, uint128_t t2, uint128_t t3,
+    uint128_t t4)
+{
+	uint128_t c;
+
+	t1 += (uint64_t)(t0 >> 51);
+	t2 += (uint64_t)(t1 >> 51);
+	t3 += (uint64_t)(t2 >> 51);
+	t4 += (uint64_t)(t3 >> 51);
+
+	c = (t4 >> 51) * 19 + ((uint64_t)t0 & FE51_MASK);
+
+	h[0] = (uint64_t)c & FE51_MASK;
+	h[1] = ((uint64_t)t1 & FE51_MASK) + (uint64_t)(c >> 51);
+	h[2] = (uint64_t)t2 & FE51_MASK;
+	h[3] = (uint64_t)t3 & FE51_MASK;
+	h[4] = (uint64_t)t4 & FE51_MASK;
+}
+
+static void
+fe51_mul(fe51 h, const fe51 f, const fe51 g)
+{
+	uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+	uint64_t g1_19 = 19 * g1, g2_19 = 19 * g2;
+	uint64_t g3_19 = 19 * g3, g4_19 = 19 * g4;
+	uint128_t t0, t1, t2, t3, t4;
+
+	t0 = (uint128_t)f0 * g0 + (uint128_t)f1 * g4_19 +
+	    (uint128_t)f2 * g3_19 + (uint128_t)f3 * g2_19 +
+	    (uint128_t)f4 * g1_19;
+	t1 = (uint128_t)f0 * g1 + (uint128_t)f1 * g0 +
+	    (uint128_t)f2 * g4_19 + (uint128_t)f3 * g3_19 +
+	    (uint128_t)f4 * g2_19;
+	t2 = (uint128_t)f0 * g2 + (uint128_t)f1 * g1 +
+	    (uint128_t)f2 * g0 + (uint128_t)f3 * g4_19 +
+	    (uint128_t)f4 * g3_19;
+	t3 = (uint128_t)f0 * g3 + (uint128_t)f1 * g2 +
+	    (uint128_t)f2 * g1 + (uint128_t)f3 * g0 +
+	    (uint128_t)f4 * g4_19;
+	t4 = (uint128_t)f0 * g4 + (uint128_t)f1 * g3 +
+	    (uint128_t)f2 * g2 + (uint128_t)f3 * g1 +
+	    (uint128_t)f4 * g0;
+
+	fe51_reduce(h, t0, t1, t2, t3, t4);
+}
+
+static void
+fe51_sq(fe51 h, const fe51 f)
+{
+	uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+	uint64_t f0_2 = 2 * f0, f1_2 = 2 * f1;
+	uint64_t f2_38 = 38 * f2, f3_19 = 19 * f3;
+	uint64_t f4_19 = 19 * f4, f4_38 = 38 * f4;
+	uint128_t t0, t1, t2, t3, t4;
+
+	t0 = (uint128_t)f0 * f0 + (uint128_t)f1 * f4_38 +
+	    (uint128_t)f2_38 * f3;
+	t1 = (uint128_t)f0_2 * f1 + (uint128_t)f2 * f4_38 +
+	    (uint128_t)f3 * f3_19;
+	t2 = (uint128_t)f0_2 * f2 + (uint128_t)f1 * f1 +
+	    (uint128_t)f3 * f4_38;
+	t3 = (uint128_t)f0_2 * f3 + (uint128_t)f1_2 * f2 +
+	    (uint128_t)f4 * f4_19;
+	t4 = (uint128_t)f0_2 * f4 + (uint128_t)f1_2 * f3 +
+	    (uint128_t)f2 * f2;
+
+	fe51_reduce(h, t0, t1, t2, t3, t4);
+}
+
+static void
+fe51_sqn(fe51 h, const fe51 f, int n)
+{
+	fe51_sq(h, f);
+	while (--n > 0)
+		fe51_sq(h, h);
+}
+
+static void
+fe51_mul121666(fe51 h, const fe51 f)
+{
+	fe51_reduce(h, (uint128_t)f[0] * 121666, (uint128_t)f[1] * 121666,
+	    (uint128_t)f[2] * 121666, (uint128_t)f[3] * 121666,
+	    (uint128_t)f[4] * 121666);
+}
+
+/* Swap f and g if b is 1, leave them alone if b is 0. */
+static void
+fe51_cswap(fe51 f, fe51 g, uint64_t b)
+{
+	uint64_t mask = 0 - b, x;
+	int i;
+
+	for (i = 0; i < 5; i++) {
+		x = (f[i] ^ g[i]) & mask;
+		f[i] ^= x;
+		g[i] ^= x;
+	}
+}
+
+/* h = z^(p - 2) = 1/z, using the same addition chain as fe_invert. */
+static void
+fe51_invert(fe51 h, const fe51 z)
+{
+	fe51 t0, t1, t2, t3;
+
+	fe51_sq(t0, z);
+	fe51_sqn(t1, t0, 2);
+	fe51_mul(t1, z, t1);
+	fe51_mul(t0, t0, t1);
+	fe51_sq(t2, t0);
+	fe51_mul(t1, t1, t2);
+	fe51_sqn(t2, t1, 5);
+	fe51_mul(t1, t2, t1);
+	fe51_sqn(t2, t1, 10);
+	fe51_mul(t2, t2, t1);
+	fe51_sqn(t3, t2, 20);
+	fe51_mul(t2, t3, t2);
+	fe51_sqn(t2, t2, 10);
+	fe51_mul(t1, t2, t1);
+	fe51_sqn(t2, t1, 50);
+	fe51_mul(t2, t2, t1);
+	fe51_sqn(t3, t2, 100);
+	fe51_mul(t2, t3, t2);
+	fe51_sqn(t2, t2, 50);
+	fe51_mul(t1, t2, t1);
+	fe51_sqn(t1, t1, 5);
+	fe51_mul(h, t1, t0);
+}
+
+void
+x25519_scalar_mult_fe51(uint8_t out[32], const uint8_t scalar[32],
+    const uint8_t point[32])
+{
+	fe51 x1, x2, z2, x3, z3, tmp0, tmp1;
+	uint8_t e[32];
+	uint64_t b, swap = 0;
+	int pos;
+
+	memcpy(e, scalar, 32);
+	e[0] &= 248;
+	e[31] &= 127;
+	e[31] |= 64;
+
+	fe51_frombytes(x1, point);
+	memset(x2, 0, sizeof(x2));
+	x2[0] = 1;
+	memset(z2, 0, sizeof(z2));
+	memcpy(x3, x1, sizeof(x3));
+	memset(z3, 0, sizeof(z3));
+	z3[0] = 1;
+
+	for (pos = 254; pos >= 0; pos--) {
+		b = 1 & (e[pos / 8] >> (pos & 7));
+		swap ^= b;
+		fe51_cswap(x2, x3, swap);
+		fe51_cswap(z2, z3, swap);
+		swap = b;
+		fe51_sub(tmp0, x3, z3);
+		fe51_sub(tmp1, x2, z2);
+		fe51_add(x2, x2, z2);
+		fe51_add(z2, x3, z3);
+		fe51_mul(z3, tmp0, x2);
+		fe51_mul(z2, z2, tmp1);
+		fe51_sq(tmp0, tmp1);
+		fe51_sq(tmp1, x2);
+		fe51_add(x3, z3, z2);
+		fe51_sub(z2, z3, z2);
+		fe51_mul(x2, tmp1, tmp0);
+		fe51_sub(tmp1, tmp1, tmp0);
+		fe51_sq(z2, z2);
+		fe51_mul121666(z3, tmp1);
+		fe51_sq(x3, x3);
+		fe51_add(tmp0, tmp0, z3);
+		fe51_mul(z3, x1, z2);
+		fe51_mul(z2, tmp1, tmp0);
+	}
+	fe51_cswap(x2, x3, swap);
+	fe51_cswap(z2, z3, swap);
+
+	fe51_invert(z2, z2);
+	fe51_mul(x2, x2, z2);
+	fe51_tobytes(out, x2);
+
+	explicit_bzero(e, sizeof(e));
+}
+
+#endif /* CURVE25519_FE51 */
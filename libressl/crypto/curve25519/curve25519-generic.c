@@ -30,5 +30,9 @@ void
 x25519_scalar_mult(uint8_t out[32], const uint8_t scalar[32],
     const uint8_t point[32])
 {
+#ifdef CURVE25519_FE51
+	x25519_scalar_mult_fe51(out, scalar, point);
+#else
 	x25519_scalar_mult_generic(out, scalar, point);
+#endif
 }
@@ -28,10 +28,7 @@
 #include <string.h>
 
 #include <openssl/curve25519.h>
-
-#ifdef ED25519
 #include <openssl/sha.h>
-#endif
 
 #include "curve25519_internal.h"
 
@@ -979,7 +976,6 @@ void x25519_ge_tobytes(uint8_t *s, const ge_p2 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
-#ifdef ED25519
 static void ge_p3_tobytes(uint8_t *s, const ge_p3 *h) {
   fe recip;
   fe x;
@@ -991,7 +987,6 @@ static void ge_p3_tobytes(uint8_t *s, const ge_p3 *h) {
   fe_tobytes(s, y);
   s[31] ^= fe_isnegative(x) << 7;
 }
-#endif
 
 static const fe d = {-10913610, 13857413, -15372611, 6949391,   114729,
                      -8787816,  -6275908, -3247719,  -18696448, -12055116};
@@ -1146,7 +1141,6 @@ static void ge_madd(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q) {
   fe_sub(r->T, t0, r->T);
 }
 
-#ifdef ED25519
 /* r = p - q */
 static void ge_msub(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q) {
   fe t0;
@@ -1162,7 +1156,6 @@ static void ge_msub(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q) {
   fe_sub(r->Z, t0, r->T);
   fe_add(r->T, t0, r->T);
 }
-#endif
 
 /* r = p + q */
 void x25519_ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
@@ -3624,7 +3617,6 @@ void x25519_ge_scalarmult(ge_p2 *r, const uint8_t *scalar, const ge_p3 *A) {
   }
 }
 
-#ifdef ED25519
 static void slide(signed char *r, const uint8_t *a) {
   int i;
   int b;
@@ -3726,23 +3718,12 @@ static const ge_precomp Bi[8] = {
     },
 };
 
-/* r = a * A + b * B
- * where a = a[0]+256*a[1]+...+256^31 a[31].
- * and b = b[0]+256*b[1]+...+256^31 b[31].
- * B is the Ed25519 base point (x,4/5) with x positive. */
+/* Ai[i] = (2i + 1) * A, for the signed digits produced by slide(). */
 static void
-ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
-    const ge_p3 *A, const uint8_t *b) {
-  signed char aslide[256];
-  signed char bslide[256];
-  ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
+ge_precompute_odd_multiples(ge_cached Ai[8], const ge_p3 *A) {
   ge_p1p1 t;
   ge_p3 u;
   ge_p3 A2;
-  int i;
-
-  slide(aslide, a);
-  slide(bslide, b);
 
   x25519_ge_p3_to_cached(&Ai[0], A);
   ge_p3_dbl(&t, A);
@@ -3768,6 +3749,26 @@ ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
   x25519_ge_add(&t, &A2, &Ai[6]);
   x25519_ge_p1p1_to_p3(&u, &t);
   x25519_ge_p3_to_cached(&Ai[7], &u);
+}
+
+/* r = a * A + b * B
+ * where a = a[0]+256*a[1]+...+256^31 a[31].
+ * and b = b[0]+256*b[1]+...+256^31 b[31].
+ * B is the Ed25519 base point (x,4/5) with x positive. */
+static void
+ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
+    const ge_p3 *A, const uint8_t *b) {
+  signed char aslide[256];
+  signed char bslide[256];
+  ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
+  ge_p1p1 t;
+  ge_p3 u;
+  int i;
+
+  slide(aslide, a);
+  slide(bslide, b);
+
+  ge_precompute_odd_multiples(Ai, A);
 
   ge_p2_0(r);
 
@@ -3799,7 +3800,6 @@ ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
     x25519_ge_p1p1_to_p2(r, &t);
   }
 }
-#endif
 
 /* The set of scalars is \Z/l
  * where l = 2^252 + 27742317777372353535851937790883648493. */
@@ -4145,7 +4145,6 @@ x25519_sc_reduce(uint8_t *s) {
   s[31] = s11 >> 17;
 }
 
-#ifdef ED25519
 /* Input:
  *   a[0]+256*a[1]+...+256^31*a[31] = a
  *   b[0]+256*b[1]+...+256^31*b[31] = b
@@ -4636,99 +4635,351 @@ sc_muladd(uint8_t *s, const uint8_t *a, const uint8_t *b,
   s[30] = s11 >> 9;
   s[31] = s11 >> 17;
 }
-#endif
-
-#ifdef ED25519
-void ED25519_keypair(uint8_t out_public_key[32], uint8_t out_private_key[64]) {
-  uint8_t seed[32];
-  arc4random_buf(seed, 32);
 
+void
+ED25519_public_from_private(uint8_t out_public_key[ED25519_PUBLIC_KEY_LENGTH],
+    const uint8_t private_key[ED25519_PRIVATE_KEY_LENGTH])
+{
   uint8_t az[SHA512_DIGEST_LENGTH];
-  SHA512(seed, 32, az);
+  ge_p3 A;
+
+  SHA512(private_key, ED25519_PRIVATE_KEY_LENGTH, az);
 
   az[0] &= 248;
   az[31] &= 63;
   az[31] |= 64;
 
-  ge_p3 A;
   x25519_ge_scalarmult_base(&A, az);
   ge_p3_tobytes(out_public_key, &A);
 
-  memcpy(out_private_key, seed, 32);
-  memmove(out_private_key + 32, out_public_key, 32);
+  explicit_bzero(az, sizeof(az));
 }
 
-int ED25519_sign(uint8_t *out_sig, const uint8_t *message, size_t message_len,
-                 const uint8_t private_key[64]) {
+void
+ED25519_keypair(uint8_t out_public_key[ED25519_PUBLIC_KEY_LENGTH],
+    uint8_t out_private_key[ED25519_PRIVATE_KEY_LENGTH])
+{
+  arc4random_buf(out_private_key, ED25519_PRIVATE_KEY_LENGTH);
+
+  ED25519_public_from_private(out_public_key, out_private_key);
+}
+
+int
+ED25519_sign(uint8_t *out_sig, const uint8_t *message, size_t message_len,
+    const uint8_t public_key[ED25519_PUBLIC_KEY_LENGTH],
+    const uint8_t private_key[ED25519_PRIVATE_KEY_LENGTH])
+{
   uint8_t az[SHA512_DIGEST_LENGTH];
-  SHA512(private_key, 32, az);
+  uint8_t nonce[SHA512_DIGEST_LENGTH];
+  uint8_t hram[SHA512_DIGEST_LENGTH];
+  SHA512_CTX hash_ctx;
+  ge_p3 R;
+
+  SHA512(private_key, ED25519_PRIVATE_KEY_LENGTH, az);
 
   az[0] &= 248;
   az[31] &= 63;
   az[31] |= 64;
 
-  SHA512_CTX hash_ctx;
   SHA512_Init(&hash_ctx);
   SHA512_Update(&hash_ctx, az + 32, 32);
   SHA512_Update(&hash_ctx, message, message_len);
-  uint8_t nonce[SHA512_DIGEST_LENGTH];
   SHA512_Final(nonce, &hash_ctx);
 
   x25519_sc_reduce(nonce);
-  ge_p3 R;
   x25519_ge_scalarmult_base(&R, nonce);
   ge_p3_tobytes(out_sig, &R);
 
   SHA512_Init(&hash_ctx);
   SHA512_Update(&hash_ctx, out_sig, 32);
-  SHA512_Update(&hash_ctx, private_key + 32, 32);
+  SHA512_Update(&hash_ctx, public_key, ED25519_PUBLIC_KEY_LENGTH);
   SHA512_Update(&hash_ctx, message, message_len);
-  uint8_t hram[SHA512_DIGEST_LENGTH];
   SHA512_Final(hram, &hash_ctx);
 
   x25519_sc_reduce(hram);
   sc_muladd(out_sig + 32, hram, az, nonce);
 
+  explicit_bzero(az, sizeof(az));
+  explicit_bzero(nonce, sizeof(nonce));
+
   return 1;
 }
 
-int ED25519_verify(const uint8_t *message, size_t message_len,
-                   const uint8_t signature[64], const uint8_t public_key[32]) {
-  ge_p3 A;
-  if ((signature[63] & 224) != 0 ||
-      x25519_ge_frombytes_vartime(&A, public_key) != 0) {
-    return 0;
-  }
+/* The order of the base point,
+ * l = 2^252 + 27742317777372353535851937790883648493. */
+static const uint8_t kOrder[32] = {
+  0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2,
+  0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+};
 
-  fe_neg(A.X, A.X);
-  fe_neg(A.T, A.T);
+/* Returns 1 if the scalar s is fully reduced modulo l, as RFC 8032 requires
+ * of the S half of a signature. */
+static int
+sc_is_canonical(const uint8_t s[32])
+{
+  int i;
 
-  uint8_t pkcopy[32];
-  memcpy(pkcopy, public_key, 32);
-  uint8_t rcopy[32];
-  memcpy(rcopy, signature, 32);
-  uint8_t scopy[32];
-  memcpy(scopy, signature + 32, 32);
+  for (i = 31; i >= 0; i--) {
+    if (s[i] < kOrder[i])
+      return 1;
+    if (s[i] > kOrder[i])
+      return 0;
+  }
+
+  return 0;
+}
 
+/* Computes k = SHA-512(R || A || M) mod l. */
+static void
+ed25519_hram(uint8_t k[SHA512_DIGEST_LENGTH], const uint8_t *R,
+    const uint8_t *public_key, const uint8_t *message, size_t message_len)
+{
   SHA512_CTX hash_ctx;
+
   SHA512_Init(&hash_ctx);
-  SHA512_Update(&hash_ctx, signature, 32);
-  SHA512_Update(&hash_ctx, public_key, 32);
+  SHA512_Update(&hash_ctx, R, 32);
+  SHA512_Update(&hash_ctx, public_key, ED25519_PUBLIC_KEY_LENGTH);
   SHA512_Update(&hash_ctx, message, message_len);
+  SHA512_Final(k, &hash_ctx);
+
+  x25519_sc_reduce(k);
+}
+
+/* Returns 1 if the low 255 bits of s, the y coordinate of an encoded
+ * point, are less than p = 2^255 - 19. */
+static int
+ge_bytes_is_canonical(const uint8_t s[32])
+{
+  int i;
+
+  if ((s[31] & 0x7f) != 0x7f)
+    return 1;
+  for (i = 30; i > 0; i--) {
+    if (s[i] != 0xff)
+      return 1;
+  }
+
+  return s[0] < 0xed;
+}
+
+/* Sets r to [8]r. */
+static void
+ge_p2_mul_by_cofactor(ge_p2 *r)
+{
+  ge_p1p1 t;
+  int i;
+
+  for (i = 0; i < 3; i++) {
+    ge_p2_dbl(&t, r);
+    x25519_ge_p1p1_to_p2(r, &t);
+  }
+}
+
+/* Returns 1 if h is the neutral element (0 : Z : Z). */
+static int
+ge_p2_is_neutral(const ge_p2 *h)
+{
+  fe y_minus_z;
+
+  fe_sub(y_minus_z, h->Y, h->Z);
+
+  return !fe_isnonzero(h->X) && !fe_isnonzero(y_minus_z);
+}
+
+/* Returns 1 if p and q are the same point. */
+static int
+ge_p2_equal(const ge_p2 *p, const ge_p2 *q)
+{
+  fe a, b;
+
+  fe_mul(a, p->X, q->Z);
+  fe_mul(b, q->X, p->Z);
+  fe_sub(a, a, b);
+  if (fe_isnonzero(a))
+    return 0;
+
+  fe_mul(a, p->Y, q->Z);
+  fe_mul(b, q->Y, p->Z);
+  fe_sub(a, a, b);
+
+  return !fe_isnonzero(a);
+}
+
+/* Decodes A or R for verification. Encodings that are not canonical and
+ * points of small order are refused, so that no signature depends on how
+ * the verifier treats the torsion subgroup. */
+static int
+ed25519_point_decode(ge_p3 *h, const uint8_t s[32])
+{
+  ge_p2 r;
+
+  if (!ge_bytes_is_canonical(s) || x25519_ge_frombytes_vartime(h, s) != 0)
+    return 0;
+
+  ge_p3_to_p2(&r, h);
+  ge_p2_mul_by_cofactor(&r);
+
+  return !ge_p2_is_neutral(&r);
+}
+
+/*
+ * Both ED25519_verify and ED25519_verify_batch check the cofactored
+ * equation [8][s]B = [8]R + [8][k]A from RFC 8032, so that they accept
+ * exactly the same signatures.
+ */
+int
+ED25519_verify(const uint8_t *message, size_t message_len,
+    const uint8_t signature[ED25519_SIGNATURE_LENGTH],
+    const uint8_t public_key[ED25519_PUBLIC_KEY_LENGTH])
+{
   uint8_t h[SHA512_DIGEST_LENGTH];
-  SHA512_Final(h, &hash_ctx);
+  ge_p3 A, R;
+  ge_p2 rcheck, r;
+
+  if (!sc_is_canonical(signature + 32) ||
+      !ed25519_point_decode(&A, public_key) ||
+      !ed25519_point_decode(&R, signature))
+    return 0;
+
+  fe_neg(A.X, A.X);
+  fe_neg(A.T, A.T);
 
-  x25519_sc_reduce(h);
+  ed25519_hram(h, signature, public_key, message, message_len);
 
-  ge_p2 R;
-  ge_double_scalarmult_vartime(&R, h, &A, scopy);
+  ge_double_scalarmult_vartime(&rcheck, h, &A, signature + 32);
+  ge_p3_to_p2(&r, &R);
 
-  uint8_t rcheck[32];
-  x25519_ge_tobytes(rcheck, &R);
+  ge_p2_mul_by_cofactor(&rcheck);
+  ge_p2_mul_by_cofactor(&r);
 
-  return timingsafe_memcmp(rcheck, rcopy, sizeof(rcheck)) == 0;
+  return ge_p2_equal(&rcheck, &r);
+}
+
+/*
+ * Batch verification checks the single equation
+ *
+ *   [8]([sum z_i s_i] B - sum [z_i] R_i - sum [z_i k_i] A_i) = 0
+ *
+ * for random 128 bit z_i, with one interleaved sliding window pass over all
+ * the points. Signatures are processed in chunks so that the tables of
+ * multiples stay bounded.
+ */
+#define ED25519_BATCH_CHUNK 64
+
+struct ed25519_batch_point {
+  ge_cached multiples[8];
+  signed char slide[256];
+};
+
+static int
+ed25519_verify_batch_chunk(struct ed25519_batch_point *points,
+    const uint8_t *const *messages, const size_t *message_lens,
+    const uint8_t *const *signatures, const uint8_t *const *public_keys,
+    size_t num)
+{
+  static const uint8_t kZero[32] = {0};
+  uint8_t s_sum[32] = {0};
+  uint8_t k[SHA512_DIGEST_LENGTH];
+  uint8_t z[32] = {0};
+  uint8_t zk[32];
+  signed char bslide[256];
+  ge_p1p1 t;
+  ge_p3 u, A, R;
+  ge_p2 r;
+  size_t i, j;
+  int bit;
+
+  for (i = 0; i < num; i++) {
+    const uint8_t *sig = signatures[i];
+
+    if (!sc_is_canonical(sig + 32) ||
+        !ed25519_point_decode(&A, public_keys[i]) ||
+        !ed25519_point_decode(&R, sig))
+      return 0;
+
+    ed25519_hram(k, sig, public_keys[i], messages[i], message_lens[i]);
+
+    arc4random_buf(z, 16);
+    sc_muladd(zk, z, k, kZero);
+    sc_muladd(s_sum, z, sig + 32, s_sum);
+
+    fe_neg(R.X, R.X);
+    fe_neg(R.T, R.T);
+    fe_neg(A.X, A.X);
+    fe_neg(A.T, A.T);
+
+    ge_precompute_odd_multiples(points[2 * i].multiples, &R);
+    slide(points[2 * i].slide, z);
+    ge_precompute_odd_multiples(points[2 * i + 1].multiples, &A);
+    slide(points[2 * i + 1].slide, zk);
+  }
+
+  slide(bslide, s_sum);
+
+  ge_p2_0(&r);
+  for (bit = 255; bit >= 0; bit--) {
+    ge_p2_dbl(&t, &r);
+
+    for (j = 0; j < 2 * num; j++) {
+      signed char digit = points[j].slide[bit];
+
+      if (digit > 0) {
+        x25519_ge_p1p1_to_p3(&u, &t);
+        x25519_ge_add(&t, &u, &points[j].multiples[digit / 2]);
+      } else if (digit < 0) {
+        x25519_ge_p1p1_to_p3(&u, &t);
+        x25519_ge_sub(&t, &u, &points[j].multiples[-digit / 2]);
+      }
+    }
+
+    if (bslide[bit] > 0) {
+      x25519_ge_p1p1_to_p3(&u, &t);
+      ge_madd(&t, &u, &Bi[bslide[bit] / 2]);
+    } else if (bslide[bit] < 0) {
+      x25519_ge_p1p1_to_p3(&u, &t);
+      ge_msub(&t, &u, &Bi[-bslide[bit] / 2]);
+    }
+
+    x25519_ge_p1p1_to_p2(&r, &t);
+  }
+
+  ge_p2_mul_by_cofactor(&r);
+
+  return ge_p2_is_neutral(&r);
+}
+
+int
+ED25519_verify_batch(const uint8_t *const *messages, const size_t *message_lens,
+    const uint8_t *const *signatures, const uint8_t *const *public_keys,
+    size_t num)
+{
+  struct ed25519_batch_point *points;
+  size_t chunk, n;
+  int ret = 0;
+
+  if (num == 0)
+    return 1;
+
+  chunk = num < ED25519_BATCH_CHUNK ? num : ED25519_BATCH_CHUNK;
+  if ((points = calloc(2 * chunk, sizeof(*points))) == NULL)
+    return 0;
+
+  for (n = 0; n < num; n += chunk) {
+    if (chunk > num - n)
+      chunk = num - n;
+    if (!ed25519_verify_batch_chunk(points, messages + n, message_lens + n,
+        signatures + n, public_keys + n, chunk))
+      goto err;
+  }
+
+  ret = 1;
+
+ err:
+  free(points);
+
+  return ret;
 }
-#endif
 
 /* Replace (f,g) with (g,f) if b == 1;
  * replace (f,g) with (f,g) if b == 0.
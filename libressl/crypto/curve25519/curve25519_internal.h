@@ -18,6 +18,7 @@
 #ifndef HEADER_CURVE25519_INTERNAL_H
 #define HEADER_CURVE25519_INTERNAL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 __BEGIN_HIDDEN_DECLS
@@ -89,11 +90,38 @@ void x25519_sc_reduce(uint8_t *s);
 void x25519_public_from_private(uint8_t out_public_value[32],
     const uint8_t private_key[32]);
 
+void ED25519_public_from_private(uint8_t out_public_key[32],
+    const uint8_t private_key[32]);
+
+/*
+ * Key material behind an EVP_PKEY of type EVP_PKEY_ED25519. The private
+ * key is absent for keys that were loaded from a certificate or a bare
+ * public key.
+ */
+struct ecx_key_st {
+	int nid;
+	int key_len;
+	uint8_t pub_key[32];
+	size_t pub_key_len;
+	uint8_t *priv_key;
+	size_t priv_key_len;
+};
+
 void x25519_scalar_mult(uint8_t out[32], const uint8_t scalar[32],
     const uint8_t point[32]);
 void x25519_scalar_mult_generic(uint8_t out[32], const uint8_t scalar[32],
     const uint8_t point[32]);
 
+/*
+ * On 64 bit targets with unsigned __int128, X25519 uses a radix 2^51
+ * field representation instead of the 32 bit ref10 one.
+ */
+#if defined(__SIZEOF_INT128__)
+#define CURVE25519_FE51
+void x25519_scalar_mult_fe51(uint8_t out[32], const uint8_t scalar[32],
+    const uint8_t point[32]);
+#endif
+
 __END_HIDDEN_DECLS
 
 #endif  /* HEADER_CURVE25519_INTERNAL_H */
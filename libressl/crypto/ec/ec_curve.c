@@ -3208,7 +3208,7 @@ static const ec_list_element curve_list[] = {
 #elif !defined(OPENSSL_NO_EC_NISTP_64_GCC_128)
 	 EC_GFp_nistp256_method,
 #else
-	 0,
+	 EC_GFp_p256_method,
 #endif
 	 "X9.62/SECG curve over a 256 bit prime field"},
 #ifndef OPENSSL_NO_EC2M
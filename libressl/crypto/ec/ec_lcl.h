@@ -194,6 +194,8 @@ typedef struct ec_extra_data_st {
 	void (*clear_free_func)(void *);
 } EC_EXTRA_DATA; /* used in EC_GROUP */
 
+struct ec_comb;
+
 struct ec_group_st {
 	const EC_METHOD *meth;
 
@@ -243,6 +245,8 @@ struct ec_group_st {
 	void *field_data1; /* method-specific (e.g., Montgomery structure) */
 	void *field_data2; /* method-specific */
 	int (*field_mod_func)(BIGNUM *, const BIGNUM *, const BIGNUM *,	BN_CTX *); /* method-specific */
+
+	const struct ec_comb *comb; /* generator comb table, see ecp_comb.c */
 } /* EC_GROUP */;
 
 struct ec_key_st {
@@ -367,6 +371,10 @@ int ec_GFp_mont_field_set_to_one(const EC_GROUP *, BIGNUM *r, BN_CTX *);
 
 int ec_point_blind_coordinates(const EC_GROUP *group, EC_POINT *p, BN_CTX *ctx);
 
+/* method functions in ecp_comb.c */
+int ec_GFp_comb_mul_generator(const EC_GROUP *, EC_POINT *r, const BIGNUM *scalar, BN_CTX *);
+void ec_comb_group_set(EC_GROUP *group);
+
 /* method functions in ecp_nist.c */
 int ec_GFp_nist_group_copy(EC_GROUP *dest, const EC_GROUP *src);
 int ec_GFp_nist_group_set_curve(EC_GROUP *, const BIGNUM *p, const BIGNUM *a, const BIGNUM *b, BN_CTX *);
@@ -446,6 +454,9 @@ int ec_GFp_nistp256_have_precompute_mult(const EC_GROUP *group);
 const EC_METHOD *EC_GFp_nistz256_method(void);
 #endif
 
+/* method in ecp_p256.c */
+const EC_METHOD *EC_GFp_p256_method(void);
+
 /* EC_METHOD definitions */
 
 struct ec_key_method_st {
@@ -106,6 +106,8 @@ EC_GROUP_new(const EC_METHOD * meth)
 	ret->seed = NULL;
 	ret->seed_len = 0;
 
+	ret->comb = NULL;
+
 	if (!meth->group_init(ret)) {
 		free(ret);
 		return NULL;
@@ -207,6 +209,7 @@ EC_GROUP_copy(EC_GROUP * dest, const EC_GROUP * src)
 	dest->curve_name = src->curve_name;
 	dest->asn1_flag = src->asn1_flag;
 	dest->asn1_form = src->asn1_form;
+	dest->comb = src->comb;
 
 	if (src->seed) {
 		free(dest->seed);
@@ -381,6 +384,8 @@ EC_GROUP_set_generator(EC_GROUP *group, const EC_POINT *generator,
 	} else if (!ec_guess_cofactor(group))
 		return 0;
 
+	ec_comb_group_set(group);
+
 	return 1;
 }
 
@@ -416,6 +421,7 @@ void
 EC_GROUP_set_curve_name(EC_GROUP * group, int nid)
 {
 	group->curve_name = nid;
+	ec_comb_group_set(group);
 }
 
 
@@ -497,7 +503,10 @@ EC_GROUP_set_curve_GFp(EC_GROUP * group, const BIGNUM * p, const BIGNUM * a,
 		ECerror(ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
 		return 0;
 	}
-	return group->meth->group_set_curve(group, p, a, b, ctx);
+	if (!group->meth->group_set_curve(group, p, a, b, ctx))
+		return 0;
+	ec_comb_group_set(group);
+	return 1;
 }
 
 
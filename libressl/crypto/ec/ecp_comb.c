@@ -0,0 +1,828 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Multiplication of the P-384 and P-521 generators using a fixed base comb
+ * with precomputed tables, for the generic prime field methods.
+ *
+ * The scalar is made odd by adding the (odd) group order if needed and is
+ * then recoded into L signed digits s_i = +1 or -1, which are read in
+ * columns of EC_COMB_TEETH digits spaced d = L / EC_COMB_TEETH bits apart.
+ * Each column is plus or minus one of EC_COMB_ENTRIES table points, so the
+ * multiplication is d - 1 doublings and d - 1 mixed additions, with every
+ * table entry read for each lookup. The tables are static and shared by
+ * all groups that match the named curve exactly, which is checked once
+ * when the curve, generator or name of a group is set; anything else falls
+ * back to the Montgomery ladder.
+ *
+ * The arithmetic is done on fixed width field elements, in Montgomery form
+ * for P-384 and reduced directly modulo 2^521 - 1 for P-521, with the
+ * complete projective formulas for a = -3 of Renes, Costello and Batina,
+ * which have no exceptional cases. So nothing after loading the scalar
+ * branches on it or depends on its size. The result is converted back to
+ * affine coordinates before it becomes a BIGNUM again.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/err.h>
+#include <openssl/objects.h>
+
+#include "bn_lcl.h"
+#include "ec_lcl.h"
+
+#define EC_COMB_TEETH		6
+#define EC_COMB_ENTRIES		(1 << (EC_COMB_TEETH - 1))
+#define EC_COMB_MAX_WORDS	9
+
+#include "ecp_comb_table.h"
+
+/*
+ * The x86_64 bn_mul_mont() does its final subtraction without branching,
+ * so it may be used on secrets, and it is faster than the C code below.
+ */
+#if defined(__x86_64__) && defined(OPENSSL_BN_ASM_MONT) && \
+    !defined(OPENSSL_NO_ASM)
+#define EC_COMB_BN_MUL_MONT
+#endif
+
+struct ec_comb {
+	int nid;
+	int words;
+	int spacing;
+	const uint64_t *p;
+	const uint64_t *b;
+	const uint64_t *n;
+	const uint64_t *gx;
+	const uint64_t *gy;
+	const uint64_t *rr;
+	void (*field_mul)(const struct ec_comb *comb, uint64_t *r,
+	    const uint64_t *a, const uint64_t *b);
+	const uint64_t *table;
+};
+
+static void ec_comb_p384_mul(const struct ec_comb *comb, uint64_t *r,
+    const uint64_t *a, const uint64_t *b);
+static void ec_comb_p521_mul(const struct ec_comb *comb, uint64_t *r,
+    const uint64_t *a, const uint64_t *b);
+
+static const struct ec_comb ec_combs[] = {
+	{
+		.nid = NID_secp384r1,
+		.words = 6,
+		.spacing = 65,
+		.p = p384_p,
+		.b = p384_b,
+		.n = p384_n,
+		.gx = p384_gx,
+		.gy = p384_gy,
+		.rr = p384_rr,
+		.field_mul = ec_comb_p384_mul,
+		.table = &p384_g_comb[0][0][0],
+	},
+	{
+		.nid = NID_secp521r1,
+		.words = 9,
+		.spacing = 87,
+		.p = p521_p,
+		.b = p521_b,
+		.n = p521_n,
+		.gx = p521_gx,
+		.gy = p521_gy,
+		.rr = p521_rr,
+		.field_mul = ec_comb_p521_mul,
+		.table = &p521_g_comb[0][0][0],
+	},
+};
+
+#define N_EC_COMBS (sizeof(ec_combs) / sizeof(ec_combs[0]))
+
+/*
+ * Field elements below p, multiplied by R = 2^384 (Montgomery form) for
+ * P-384 and by R = 1 for P-521.
+ */
+typedef uint64_t ec_comb_felem[EC_COMB_MAX_WORDS];
+
+/* A point in projective coordinates, (X : Y : Z) is (X / Z, Y / Z). */
+struct ec_comb_point {
+	ec_comb_felem X;
+	ec_comb_felem Y;
+	ec_comb_felem Z;
+};
+
+/* Returns the low half of a * b + c + d and stores the high half in hi. */
+static inline uint64_t
+ec_comb_mac(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t *hi)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 t;
+
+	t = (unsigned __int128)a * b + c + d;
+	*hi = t >> 64;
+
+	return (uint64_t)t;
+#else
+	uint64_t a0 = a & 0xffffffff, a1 = a >> 32;
+	uint64_t b0 = b & 0xffffffff, b1 = b >> 32;
+	uint64_t p00, p01, p10, p11, mid, lo;
+
+	p00 = a0 * b0;
+	p01 = a0 * b1;
+	p10 = a1 * b0;
+	p11 = a1 * b1;
+
+	mid = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+	lo = (p00 & 0xffffffff) | (mid << 32);
+	*hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+
+	lo += c;
+	*hi += lo < c;
+	lo += d;
+	*hi += lo < d;
+
+	return lo;
+#endif
+}
+
+static inline uint64_t
+ec_comb_addc(uint64_t a, uint64_t b, uint64_t carry, uint64_t *carry_out)
+{
+	uint64_t r;
+
+	r = a + carry;
+	*carry_out = r < carry;
+	r += b;
+	*carry_out += r < b;
+
+	return r;
+}
+
+static inline uint64_t
+ec_comb_subb(uint64_t a, uint64_t b, uint64_t borrow, uint64_t *borrow_out)
+{
+	uint64_t r;
+
+	r = a - b;
+	*borrow_out = a < b;
+	*borrow_out |= r < borrow;
+	r -= borrow;
+
+	return r;
+}
+
+/*
+ * Reduce a value below 2p, with carry as its most significant limb, to
+ * below p.
+ */
+static void
+ec_comb_felem_reduce_once(const struct ec_comb *comb, ec_comb_felem r,
+    const uint64_t *a, uint64_t carry)
+{
+	ec_comb_felem t;
+	uint64_t borrow, mask;
+	int i;
+
+	borrow = 0;
+	for (i = 0; i < comb->words; i++)
+		t[i] = ec_comb_subb(a[i], comb->p[i], borrow, &borrow);
+	(void)ec_comb_subb(carry, 0, borrow, &borrow);
+
+	/* If the subtraction borrowed, a was already fully reduced. */
+	mask = 0 - borrow;
+	for (i = 0; i < comb->words; i++)
+		r[i] = (a[i] & mask) | (t[i] & ~mask);
+}
+
+static void
+ec_comb_felem_add(const struct ec_comb *comb, ec_comb_felem r,
+    const ec_comb_felem a, const ec_comb_felem b)
+{
+	ec_comb_felem t;
+	uint64_t carry;
+	int i;
+
+	carry = 0;
+	for (i = 0; i < comb->words; i++)
+		t[i] = ec_comb_addc(a[i], b[i], carry, &carry);
+
+	ec_comb_felem_reduce_once(comb, r, t, carry);
+}
+
+static void
+ec_comb_felem_sub(const struct ec_comb *comb, ec_comb_felem r,
+    const ec_comb_felem a, const ec_comb_felem b)
+{
+	uint64_t borrow, carry, mask;
+	int i;
+
+	borrow = 0;
+	for (i = 0; i < comb->words; i++)
+		r[i] = ec_comb_subb(a[i], b[i], borrow, &borrow);
+
+	/* Add p back if the subtraction borrowed. */
+	mask = 0 - borrow;
+	carry = 0;
+	for (i = 0; i < comb->words; i++)
+		r[i] = ec_comb_addc(r[i], comb->p[i] & mask, carry, &carry);
+}
+
+/* -p^-1 mod 2^64 for P-384. */
+#define EC_COMB_P384_N0		0x0000000100000001ULL
+
+/* Montgomery multiplication, r = a * b * 2^-384 mod p. */
+static void
+ec_comb_p384_mul(const struct ec_comb *comb, uint64_t *r, const uint64_t *a,
+    const uint64_t *b)
+{
+	uint64_t t[6 + 2];
+	uint64_t carry, m;
+	int i, j;
+#ifdef EC_COMB_BN_MUL_MONT
+	BN_ULONG n0 = EC_COMB_P384_N0;
+
+	if (bn_mul_mont((BN_ULONG *)r, (const BN_ULONG *)a,
+	    (const BN_ULONG *)b, (const BN_ULONG *)comb->p, &n0, 6))
+		return;
+#endif
+
+	memset(t, 0, sizeof(t));
+
+	for (i = 0; i < 6; i++) {
+		carry = 0;
+		for (j = 0; j < 6; j++)
+			t[j] = ec_comb_mac(a[j], b[i], t[j], carry, &carry);
+		t[6] = ec_comb_addc(t[6], carry, 0, &carry);
+		t[7] = carry;
+
+		/* Add m * p, which clears the low limb, and shift it out. */
+		m = t[0] * EC_COMB_P384_N0;
+		(void)ec_comb_mac(m, comb->p[0], t[0], 0, &carry);
+		for (j = 1; j < 6; j++)
+			t[j - 1] = ec_comb_mac(m, comb->p[j], t[j], carry,
+			    &carry);
+		t[5] = ec_comb_addc(t[6], carry, 0, &carry);
+		t[6] = t[7] + carry;
+	}
+
+	ec_comb_felem_reduce_once(comb, r, t, t[6]);
+}
+
+/*
+ * r = a * b mod p for p = 2^521 - 1. The product t is below p^2, so the
+ * sum of its low 521 bits and t >> 521 is below 2p.
+ */
+static void
+ec_comb_p521_mul(const struct ec_comb *comb, uint64_t *r, const uint64_t *a,
+    const uint64_t *b)
+{
+	uint64_t t[18], hi[9];
+	uint64_t carry;
+	int i, j;
+
+	memset(t, 0, sizeof(t));
+
+	for (i = 0; i < 9; i++) {
+		carry = 0;
+		for (j = 0; j < 9; j++)
+			t[i + j] = ec_comb_mac(a[j], b[i], t[i + j], carry,
+			    &carry);
+		t[i + 9] = carry;
+	}
+
+	for (i = 0; i < 9; i++)
+		hi[i] = (t[i + 8] >> 9) | (t[i + 9] << 55);
+	t[8] &= 0x1ff;
+
+	carry = 0;
+	for (i = 0; i < 9; i++)
+		t[i] = ec_comb_addc(t[i], hi[i], carry, &carry);
+
+	ec_comb_felem_reduce_once(comb, r, t, 0);
+}
+
+static void
+ec_comb_felem_mul(const struct ec_comb *comb, ec_comb_felem r,
+    const ec_comb_felem a, const ec_comb_felem b)
+{
+	comb->field_mul(comb, r, a, b);
+}
+
+/*
+ * Inversion by Fermat's little theorem, r = a^(p - 2), with a fixed window
+ * of four bits. The exponent is public, so skipping zero windows is fine.
+ */
+static void
+ec_comb_felem_inv(const struct ec_comb *comb, ec_comb_felem r,
+    const ec_comb_felem a, const ec_comb_felem one)
+{
+	ec_comb_felem pow[16], t;
+	unsigned int w;
+	uint64_t e;
+	int i, j;
+
+	memcpy(pow[0], one, sizeof(pow[0]));
+	for (i = 1; i < 16; i++)
+		ec_comb_felem_mul(comb, pow[i], pow[i - 1], a);
+
+	memcpy(t, one, sizeof(t));
+	for (i = 16 * comb->words - 1; i >= 0; i--) {
+		for (j = 0; j < 4; j++)
+			ec_comb_felem_mul(comb, t, t, t);
+		/* The low limb of both primes is at least 2. */
+		e = comb->p[i / 16] - (i < 16 ? 2 : 0);
+		if ((w = (e >> ((i % 16) * 4)) & 0xf) != 0)
+			ec_comb_felem_mul(comb, t, t, pow[w]);
+	}
+	memcpy(r, t, sizeof(t));
+
+	explicit_bzero(pow, sizeof(pow));
+}
+
+/* Returns all ones if a is zero, otherwise zero. */
+static uint64_t
+ec_comb_felem_is_zero(const struct ec_comb *comb, const ec_comb_felem a)
+{
+	uint64_t t = 0;
+	int i;
+
+	for (i = 0; i < comb->words; i++)
+		t |= a[i];
+
+	return ((t | (0 - t)) >> 63) - 1;
+}
+
+/*
+ * Point doubling for a = -3, algorithm 6 of Renes, Costello and Batina,
+ * "Complete addition formulas for prime order elliptic curves" (2016).
+ * It works for every point, including the point at infinity (0 : 1 : 0).
+ */
+static void
+ec_comb_point_double(const struct ec_comb *comb, struct ec_comb_point *r,
+    const struct ec_comb_point *a, const ec_comb_felem b)
+{
+	ec_comb_felem t0, t1, t2, t3, X3, Y3, Z3;
+
+	ec_comb_felem_mul(comb, t0, a->X, a->X);
+	ec_comb_felem_mul(comb, t1, a->Y, a->Y);
+	ec_comb_felem_mul(comb, t2, a->Z, a->Z);
+	ec_comb_felem_mul(comb, t3, a->X, a->Y);
+	ec_comb_felem_add(comb, t3, t3, t3);
+	ec_comb_felem_mul(comb, Z3, a->X, a->Z);
+	ec_comb_felem_add(comb, Z3, Z3, Z3);
+	ec_comb_felem_mul(comb, Y3, b, t2);
+	ec_comb_felem_sub(comb, Y3, Y3, Z3);
+	ec_comb_felem_add(comb, X3, Y3, Y3);
+	ec_comb_felem_add(comb, Y3, X3, Y3);
+	ec_comb_felem_sub(comb, X3, t1, Y3);
+	ec_comb_felem_add(comb, Y3, t1, Y3);
+	ec_comb_felem_mul(comb, Y3, X3, Y3);
+	ec_comb_felem_mul(comb, X3, X3, t3);
+	ec_comb_felem_add(comb, t3, t2, t2);
+	ec_comb_felem_add(comb, t2, t2, t3);
+	ec_comb_felem_mul(comb, Z3, b, Z3);
+	ec_comb_felem_sub(comb, Z3, Z3, t2);
+	ec_comb_felem_sub(comb, Z3, Z3, t0);
+	ec_comb_felem_add(comb, t3, Z3, Z3);
+	ec_comb_felem_add(comb, Z3, Z3, t3);
+	ec_comb_felem_add(comb, t3, t0, t0);
+	ec_comb_felem_add(comb, t0, t3, t0);
+	ec_comb_felem_sub(comb, t0, t0, t2);
+	ec_comb_felem_mul(comb, t0, t0, Z3);
+	ec_comb_felem_add(comb, Y3, Y3, t0);
+	ec_comb_felem_mul(comb, t0, a->Y, a->Z);
+	ec_comb_felem_add(comb, t0, t0, t0);
+	ec_comb_felem_mul(comb, Z3, t0, Z3);
+	ec_comb_felem_sub(comb, X3, X3, Z3);
+	ec_comb_felem_mul(comb, Z3, t0, t1);
+	ec_comb_felem_add(comb, Z3, Z3, Z3);
+	ec_comb_felem_add(comb, Z3, Z3, Z3);
+
+	memcpy(r->X, X3, sizeof(X3));
+	memcpy(r->Y, Y3, sizeof(Y3));
+	memcpy(r->Z, Z3, sizeof(Z3));
+}
+
+/*
+ * Mixed addition of the affine point (x2, y2) for a = -3, algorithm 5 of
+ * Renes, Costello and Batina. It works for every a, including the point
+ * at infinity, a = (x2, y2) and a = -(x2, y2).
+ */
+static void
+ec_comb_point_add_affine(const struct ec_comb *comb, struct ec_comb_point *r,
+    const struct ec_comb_point *a, const ec_comb_felem x2,
+    const ec_comb_felem y2, const ec_comb_felem b)
+{
+	ec_comb_felem t0, t1, t2, t3, t4, X3, Y3, Z3;
+
+	ec_comb_felem_mul(comb, t0, a->X, x2);
+	ec_comb_felem_mul(comb, t1, a->Y, y2);
+	ec_comb_felem_add(comb, t3, x2, y2);
+	ec_comb_felem_add(comb, t4, a->X, a->Y);
+	ec_comb_felem_mul(comb, t3, t3, t4);
+	ec_comb_felem_add(comb, t4, t0, t1);
+	ec_comb_felem_sub(comb, t3, t3, t4);
+	ec_comb_felem_mul(comb, t4, y2, a->Z);
+	ec_comb_felem_add(comb, t4, t4, a->Y);
+	ec_comb_felem_mul(comb, Y3, x2, a->Z);
+	ec_comb_felem_add(comb, Y3, Y3, a->X);
+	ec_comb_felem_mul(comb, Z3, b, a->Z);
+	ec_comb_felem_sub(comb, X3, Y3, Z3);
+	ec_comb_felem_add(comb, Z3, X3, X3);
+	ec_comb_felem_add(comb, X3, X3, Z3);
+	ec_comb_felem_sub(comb, Z3, t1, X3);
+	ec_comb_felem_add(comb, X3, t1, X3);
+	ec_comb_felem_mul(comb, Y3, b, Y3);
+	ec_comb_felem_add(comb, t1, a->Z, a->Z);
+	ec_comb_felem_add(comb, t2, t1, a->Z);
+	ec_comb_felem_sub(comb, Y3, Y3, t2);
+	ec_comb_felem_sub(comb, Y3, Y3, t0);
+	ec_comb_felem_add(comb, t1, Y3, Y3);
+	ec_comb_felem_add(comb, Y3, t1, Y3);
+	ec_comb_felem_add(comb, t1, t0, t0);
+	ec_comb_felem_add(comb, t0, t1, t0);
+	ec_comb_felem_sub(comb, t0, t0, t2);
+	ec_comb_felem_mul(comb, t1, t4, Y3);
+	ec_comb_felem_mul(comb, t2, t0, Y3);
+	ec_comb_felem_mul(comb, Y3, X3, Z3);
+	ec_comb_felem_add(comb, Y3, Y3, t2);
+	ec_comb_felem_mul(comb, X3, t3, X3);
+	ec_comb_felem_sub(comb, X3, X3, t1);
+	ec_comb_felem_mul(comb, Z3, t4, Z3);
+	ec_comb_felem_mul(comb, t1, t3, t0);
+	ec_comb_felem_add(comb, Z3, Z3, t1);
+
+	memcpy(r->X, X3, sizeof(X3));
+	memcpy(r->Y, Y3, sizeof(Y3));
+	memcpy(r->Z, Z3, sizeof(Z3));
+}
+
+static int
+ec_comb_from_bn(uint64_t *r, const BIGNUM *bn, int words)
+{
+	int i;
+
+	if (BN_is_negative(bn) || BN_num_bits(bn) > 64 * words)
+		return 0;
+
+	memset(r, 0, words * sizeof(r[0]));
+#if BN_BITS2 == 64
+	for (i = 0; i < bn->top; i++)
+		r[i] = bn->d[i];
+#else
+	for (i = 0; i < bn->top; i++)
+		r[i / 2] |= (uint64_t)bn->d[i] << ((i % 2) * 32);
+#endif
+
+	return 1;
+}
+
+static int
+ec_comb_to_bn(BIGNUM *bn, const uint64_t *a, int words)
+{
+	int i;
+
+	if (bn_wexpand(bn, words * 64 / BN_BITS2) == NULL)
+		return 0;
+#if BN_BITS2 == 64
+	for (i = 0; i < words; i++)
+		bn->d[i] = a[i];
+#else
+	for (i = 0; i < 2 * words; i++)
+		bn->d[i] = (BN_ULONG)(a[i / 2] >> ((i % 2) * 32));
+#endif
+	bn->top = words * 64 / BN_BITS2;
+	bn->neg = 0;
+	bn_correct_top(bn);
+
+	return 1;
+}
+
+static int
+ec_comb_bn_equal(const BIGNUM *bn, const uint64_t *a, int words)
+{
+	uint64_t v[EC_COMB_MAX_WORDS];
+
+	if (!ec_comb_from_bn(v, bn, words))
+		return 0;
+
+	return memcmp(v, a, words * sizeof(v[0])) == 0;
+}
+
+/*
+ * Find the comb table for the group, if it is one of the named curves with
+ * the standard generator. On success *out is NULL if there is no table.
+ */
+static int
+ec_comb_lookup(const EC_GROUP *group, const struct ec_comb **out, BN_CTX *ctx)
+{
+	const struct ec_comb *comb = NULL;
+	BIGNUM *p, *a, *b, *x, *y;
+	size_t i;
+	int ret = 0;
+
+	*out = NULL;
+
+	for (i = 0; i < N_EC_COMBS; i++) {
+		if (ec_combs[i].nid == group->curve_name)
+			comb = &ec_combs[i];
+	}
+	if (comb == NULL || group->generator == NULL)
+		return 1;
+
+	BN_CTX_start(ctx);
+
+	if ((p = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if ((a = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if ((b = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if ((x = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if ((y = BN_CTX_get(ctx)) == NULL)
+		goto err;
+
+	if (!EC_GROUP_get_curve_GFp(group, p, a, b, ctx))
+		goto err;
+	if (!EC_POINT_get_affine_coordinates_GFp(group, group->generator,
+	    x, y, ctx))
+		goto err;
+
+	/* Both curves have a = -3. */
+	if (!BN_add_word(a, 3))
+		goto err;
+
+	if (ec_comb_bn_equal(p, comb->p, comb->words) && BN_cmp(a, p) == 0 &&
+	    ec_comb_bn_equal(b, comb->b, comb->words) &&
+	    ec_comb_bn_equal(&group->order, comb->n, comb->words) &&
+	    ec_comb_bn_equal(x, comb->gx, comb->words) &&
+	    ec_comb_bn_equal(y, comb->gy, comb->words))
+		*out = comb;
+
+	ret = 1;
+
+ err:
+	BN_CTX_end(ctx);
+
+	return ret;
+}
+
+static unsigned int
+ec_comb_bit(const uint64_t *k, int i)
+{
+	return (k[i / 64] >> (i % 64)) & 1;
+}
+
+/*
+ * Compute the table index and sign of column col of the recoded scalar.
+ * The table only holds points whose top digit is +1, columns with a top
+ * digit of -1 are the negation of the entry with all digits flipped.
+ */
+static void
+ec_comb_digit(const uint64_t *k, int spacing, int col, unsigned int *idx,
+    unsigned int *neg)
+{
+	unsigned int bits = 0;
+	int t;
+
+	for (t = 0; t < EC_COMB_TEETH - 1; t++)
+		bits |= ec_comb_bit(k, col + t * spacing) << t;
+
+	*neg = ec_comb_bit(k, col + (EC_COMB_TEETH - 1) * spacing) ^ 1;
+	*idx = (bits ^ (0 - *neg)) & (EC_COMB_ENTRIES - 1);
+}
+
+/*
+ * Copy entry idx of the table to x and y, reading every entry, and negate
+ * y if neg is set.
+ */
+static void
+ec_comb_select(const struct ec_comb *comb, uint64_t *x, uint64_t *y,
+    unsigned int idx, unsigned int neg)
+{
+	const uint64_t *entry;
+	uint64_t borrow, d, mask, ny;
+	int i, j, words = comb->words;
+
+	memset(x, 0, words * sizeof(x[0]));
+	memset(y, 0, words * sizeof(y[0]));
+	for (i = 0; i < EC_COMB_ENTRIES; i++) {
+		d = (uint64_t)(i ^ idx);
+		mask = 0 - (((d - 1) & ~d) >> 63);
+		entry = &comb->table[i * 2 * words];
+		for (j = 0; j < words; j++) {
+			x[j] |= entry[j] & mask;
+			y[j] |= entry[words + j] & mask;
+		}
+	}
+
+	/* y = p - y, which is in range since y is never zero. */
+	mask = 0 - (uint64_t)neg;
+	borrow = 0;
+	for (j = 0; j < words; j++) {
+		d = comb->p[j] - y[j];
+		ny = d - borrow;
+		borrow = (comb->p[j] < y[j]) | (d < borrow);
+		y[j] = (ny & mask) | (y[j] & ~mask);
+	}
+}
+
+/*
+ * Replace the odd scalar k < 2^L by k' = (k + 2^L - 1) / 2, so that
+ * k = sum((2 * bit i of k' - 1) * 2^i) for i = 0..L-1.
+ */
+static void
+ec_comb_recode(uint64_t *k, int words, int bits)
+{
+	uint64_t carry, m, s;
+	int i;
+
+	carry = 0;
+	for (i = 0; i < words; i++) {
+		if (64 * (i + 1) <= bits)
+			m = ~(uint64_t)0;
+		else if (64 * i < bits)
+			m = ((uint64_t)1 << (bits - 64 * i)) - 1;
+		else
+			m = 0;
+		s = k[i] + m;
+		k[i] = s + carry;
+		carry = (s < m) | (k[i] < carry);
+	}
+	for (i = 0; i < words - 1; i++)
+		k[i] = (k[i] >> 1) | (k[i + 1] << 63);
+	k[words - 1] = (k[words - 1] >> 1) | (carry << 63);
+}
+
+/*
+ * Remember the comb table for the group, or that there is none. Failing to
+ * find out leaves the group without a table, which only costs speed.
+ */
+void
+ec_comb_group_set(EC_GROUP *group)
+{
+	const struct ec_comb *comb;
+	BN_CTX *ctx;
+
+	group->comb = NULL;
+	if (group->meth->mul_generator_ct != ec_GFp_comb_mul_generator)
+		return;
+
+	ERR_set_mark();
+	if ((ctx = BN_CTX_new()) != NULL && ec_comb_lookup(group, &comb, ctx))
+		group->comb = comb;
+	BN_CTX_free(ctx);
+	ERR_pop_to_mark();
+}
+
+/*
+ * Load the scalar and make it odd, adding the group order in constant time
+ * if it is even. Negative or oversized scalars are unusual inputs and are
+ * reduced first, which is not constant time, as in the ladder.
+ */
+static int
+ec_comb_scalar(const EC_GROUP *group, const struct ec_comb *comb, uint64_t *k,
+    const BIGNUM *scalar, BN_CTX *ctx)
+{
+	uint64_t kn[EC_COMB_MAX_WORDS + 1];
+	uint64_t carry, mask;
+	BIGNUM *t;
+	int i, words = comb->words;
+	int ret = 0;
+
+	BN_CTX_start(ctx);
+
+	if (BN_num_bits(scalar) > BN_num_bits(&group->order) ||
+	    BN_is_negative(scalar)) {
+		if ((t = BN_CTX_get(ctx)) == NULL)
+			goto err;
+		if (!BN_nnmod(t, scalar, &group->order, ctx))
+			goto err;
+		scalar = t;
+	}
+	if (!ec_comb_from_bn(k, scalar, words + 1))
+		goto err;
+
+	carry = 0;
+	for (i = 0; i < words; i++)
+		kn[i] = ec_comb_addc(k[i], comb->n[i], carry, &carry);
+	kn[words] = k[words] + carry;
+
+	mask = (k[0] & 1) - 1;
+	for (i = 0; i <= words; i++)
+		k[i] = (kn[i] & mask) | (k[i] & ~mask);
+
+	ret = 1;
+
+ err:
+	explicit_bzero(kn, sizeof(kn));
+	BN_CTX_end(ctx);
+
+	return ret;
+}
+
+int
+ec_GFp_comb_mul_generator(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *scalar, BN_CTX *ctx)
+{
+	BN_CTX *new_ctx = NULL;
+	const struct ec_comb *comb;
+	struct ec_comb_point acc;
+	uint64_t k[EC_COMB_MAX_WORDS + 1];
+	ec_comb_felem x, y, b, one, z_inv;
+	BIGNUM *bx, *by;
+	unsigned int idx, neg;
+	int col;
+	int ret = 0;
+
+	if ((comb = group->comb) == NULL)
+		return ec_GFp_simple_mul_generator_ct(group, r, scalar, ctx);
+
+	if (ctx == NULL && (ctx = new_ctx = BN_CTX_new()) == NULL)
+		return 0;
+
+	BN_CTX_start(ctx);
+
+	if ((bx = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if ((by = BN_CTX_get(ctx)) == NULL)
+		goto err;
+
+	if (!ec_comb_scalar(group, comb, k, scalar, ctx))
+		goto err;
+	ec_comb_recode(k, comb->words + 1, EC_COMB_TEETH * comb->spacing);
+
+	/* R mod p and b * R mod p. */
+	memset(x, 0, sizeof(x));
+	x[0] = 1;
+	ec_comb_felem_mul(comb, one, comb->rr, x);
+	memcpy(x, comb->b, comb->words * sizeof(x[0]));
+	ec_comb_felem_mul(comb, b, x, comb->rr);
+
+	memset(&acc, 0, sizeof(acc));
+	for (col = comb->spacing - 1; col >= 0; col--) {
+		ec_comb_digit(k, comb->spacing, col, &idx, &neg);
+		ec_comb_select(comb, x, y, idx, neg);
+		ec_comb_felem_mul(comb, x, x, comb->rr);
+		ec_comb_felem_mul(comb, y, y, comb->rr);
+
+		if (col == comb->spacing - 1) {
+			memcpy(acc.X, x, sizeof(x));
+			memcpy(acc.Y, y, sizeof(y));
+			memcpy(acc.Z, one, sizeof(one));
+			continue;
+		}
+
+		ec_comb_point_double(comb, &acc, &acc, b);
+		ec_comb_point_add_affine(comb, &acc, &acc, x, y, b);
+	}
+
+	/* Only a multiple of the order gives the point at infinity. */
+	if (ec_comb_felem_is_zero(comb, acc.Z) != 0) {
+		ret = EC_POINT_set_to_infinity(group, r);
+		goto err;
+	}
+
+	ec_comb_felem_inv(comb, z_inv, acc.Z, one);
+	ec_comb_felem_mul(comb, x, acc.X, z_inv);
+	ec_comb_felem_mul(comb, y, acc.Y, z_inv);
+
+	/* Multiplying by 1 takes the coordinates out of Montgomery form. */
+	memset(z_inv, 0, sizeof(z_inv));
+	z_inv[0] = 1;
+	ec_comb_felem_mul(comb, x, x, z_inv);
+	ec_comb_felem_mul(comb, y, y, z_inv);
+
+	if (!ec_comb_to_bn(bx, x, comb->words))
+		goto err;
+	if (!ec_comb_to_bn(by, y, comb->words))
+		goto err;
+	if (!EC_POINT_set_affine_coordinates_GFp(group, r, bx, by, ctx))
+		goto err;
+
+	ret = 1;
+
+ err:
+	explicit_bzero(k, sizeof(k));
+	explicit_bzero(x, sizeof(x));
+	explicit_bzero(y, sizeof(y));
+	explicit_bzero(&acc, sizeof(acc));
+	explicit_bzero(z_inv, sizeof(z_inv));
+	BN_CTX_end(ctx);
+	BN_CTX_free(new_ctx);
+
+	return ret;
+}
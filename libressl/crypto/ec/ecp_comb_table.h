@@ -0,0 +1,556 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Comb tables for multiplication of the P-384 and P-521 generators G. With
+ * EC_COMB_TEETH = w teeth spaced d bits apart (d = 65 for P-384 and 87 for
+ * P-521), entry i of each table holds the affine point
+ *
+ *	(2^(d * (w - 1)) + sum(s_j * 2^(d * j))) * G for j = 0..w-2,
+ *
+ * where s_j is +1 if bit j of i is set and -1 otherwise. Coordinates are
+ * in normal form as 64 bit limbs, least significant limb first. The curve
+ * parameters are included so that a group can be matched against them,
+ * along with R^2 mod p for the conversion into the form used by the field
+ * arithmetic in ecp_comb.c, where R = 2^384 for P-384 and 1 for P-521.
+ */
+
+static const uint64_t p384_p[6] = {
+	0x00000000ffffffffULL, 0xffffffff00000000ULL,
+	0xfffffffffffffffeULL, 0xffffffffffffffffULL,
+	0xffffffffffffffffULL, 0xffffffffffffffffULL,
+};
+static const uint64_t p384_b[6] = {
+	0x2a85c8edd3ec2aefULL, 0xc656398d8a2ed19dULL,
+	0x0314088f5013875aULL, 0x181d9c6efe814112ULL,
+	0x988e056be3f82d19ULL, 0xb3312fa7e23ee7e4ULL,
+};
+static const uint64_t p384_n[6] = {
+	0xecec196accc52973ULL, 0x581a0db248b0a77aULL,
+	0xc7634d81f4372ddfULL, 0xffffffffffffffffULL,
+	0xffffffffffffffffULL, 0xffffffffffffffffULL,
+};
+static const uint64_t p384_gx[6] = {
+	0x3a545e3872760ab7ULL, 0x5502f25dbf55296cULL,
+	0x59f741e082542a38ULL, 0x6e1d3b628ba79b98ULL,
+	0x8eb1c71ef320ad74ULL, 0xaa87ca22be8b0537ULL,
+};
+static const uint64_t p384_gy[6] = {
+	0x7a431d7c90ea0e5fULL, 0x0a60b1ce1d7e819dULL,
+	0xe9da3113b5f0b8c0ULL, 0xf8f41dbd289a147cULL,
+	0x5d9e98bf9292dc29ULL, 0x3617de4a96262c6fULL,
+};
+static const uint64_t p384_rr[6] = {
+	0xfffffffe00000001ULL, 0x0000000200000000ULL,
+	0xfffffffe00000000ULL, 0x0000000200000000ULL,
+	0x0000000000000001ULL, 0x0000000000000000ULL,
+};
+
+static const uint64_t p384_g_comb[EC_COMB_ENTRIES][2][6] = {
+	{
+		{0x4f54f36bcfeb60da, 0xfbfd5ea8822b70fa, 0xca697c7af93cb57f,
+		    0x430d41505991ca51, 0x40c5ba7113f15b4c, 0xdc36cd9926950e26},
+		{0xc4b8ab3b4df58dea, 0xa0cfce4ee8a630fe, 0xd696f8bc106bed88,
+		    0xf835ac9a4feaa30c, 0xae8f806cc1441172, 0xeb1a7fbb98f55e79},
+	},
+	{
+		{0x1483ace03053e017, 0xddff1ab7033943c8, 0x9429aeb525b49d5c,
+		    0x73811edb1f7d0aa9, 0xf0051f007ad226d6, 0x4a3b0b6f679a0790},
+		{0x92f40480ee12a601, 0xeafbc40a16440450, 0x25d6b7085eed2cf7,
+		    0xd835bc24c987dcde, 0x686dc054f6cb415f, 0xde2f203dc46917f1},
+	},
+	{
+		{0xa6bc29f78192b619, 0x8ed9819feac0864e, 0x6707b1db16121d1e,
+		    0x3daa76b8070f7d6d, 0x0426241a10d64a61, 0x2b5ce0048062ef82},
+		{0xebb71151aa64fa4a, 0x06c2e8a8870b914d, 0xa92c3a495a29c7b4,
+		    0xf7ff43c38ba2f8e5, 0x9f4fb530608cd56a, 0x38458692e80db69e},
+	},
+	{
+		{0x02ac63f240db53c0, 0x4285195f540ef42d, 0x6b9e7e4ca64e4035,
+		    0xabc99a732bdcdcf4, 0xd5f80708d65348db, 0xe69134b3eea6b5c4},
+		{0x86d935840050de00, 0xef5bde1db416c6ae, 0x5188cf3951739dae,
+		    0xa82f24ac9df66d72, 0xd570e3a8d0677751, 0x480e29e85863ef93},
+	},
+	{
+		{0x1fefc47a89aa2df9, 0x48808883320e4d39, 0xa0b3edffe1466e15,
+		    0x8a45e04d04c06b6b, 0xd201e31cf927f38f, 0x91a7729438cda114},
+		{0x734a5c594215f501, 0x414b99842fd05f6c, 0xc497135cdf572742,
+		    0xccffc08305b95b5c, 0xc2634183b44a4f49, 0x99017e7a4a74f1c0},
+	},
+	{
+		{0xf58015e35e7ca5dc, 0x2a0bf7bf4835d505, 0x24e39e46a7570acd,
+		    0xf8cd45ea3ef96734, 0xb498af6436337a73, 0x4dbd241cf536e6f2},
+		{0x8986d01f06ac4f7f, 0x4ec907920d651420, 0x1edd60d00a1f0029,
+		    0x38b6c72253958cf0, 0xd714b11b85fc7c7a, 0xa51f5f86ecb62575},
+	},
+	{
+		{0x11d4a72072188939, 0x85b7c6aac7eb7692, 0xd4fe381eb1cbf712,
+		    0x4528ab4b69c49b9b, 0x5de94ebc0d33e6a6, 0x6d0b382f42814c14},
+		{0x588e2acb682bb036, 0xed1980d219433885, 0xebe24dab82347bd8,
+		    0x4ab43cb8e08d776e, 0x3ceefad4e3192644, 0xf854e49e1e36a53d},
+	},
+	{
+		{0xff93da0903cd5921, 0x37ee30c4ffc5fcb4, 0xc2cf1c68bdc9531c,
+		    0xfe234fdaa8e3bac0, 0xc0ddd2571a16c9ea, 0x46a6b659334e4674},
+		{0x2e97e7134d26d0f1, 0x498b2ca8090924ee, 0xc8b1f4d8074bdb1f,
+		    0x728ae039eb796bcc, 0xbd0b9ab89fb1765f, 0x8d84fd6d1d2cdac6},
+	},
+	{
+		{0x4c877f320186e687, 0xf5dd62cb695c7e3e, 0xc1e61abdd5b707c2,
+		    0xc2950540aaec05c3, 0xdbf18cf8cc2a177e, 0x632a1b8369f240d2},
+		{0x625b346c26ca7196, 0xaadc0e6b9efc74b5, 0xb43457f49ca2c154,
+		    0xa24554d94cf1dcb9, 0xade86bf40b747a54, 0x3098b9b7554f0189},
+	},
+	{
+		{0xe006d6cd67bc690e, 0xdc5160a20f1741e1, 0x4bbf0d235e158e55,
+		    0xcc90c1f39128c225, 0x1e57e18633b4fe76, 0x2aa5f9821c70a305},
+		{0xa387f616b0166b46, 0x14b35243967f6104, 0xfc11b4983d486c32,
+		    0xef0bbd0989f3ccce, 0x9b3a15deb553d3b4, 0x20ee3cad6fcfa796},
+	},
+	{
+		{0x7e5285c293711031, 0x8b6261d37d295154, 0x69549dc010780c2d,
+		    0x1d7ee358c784b007, 0x3ab36390d3441dda, 0xaecc93283dc2968f},
+		{0x9b739b27013314c9, 0x1b957107866b50a5, 0xa33d22e686f5cdca,
+		    0x099c2812e9c9e665, 0xe314633d33cdc32b, 0xdd825fe11dd672e5},
+	},
+	{
+		{0x318bc6efd93c91fa, 0x86c7a8da0156f2e2, 0xca16ea52924790be,
+		    0x44f41e5a287a2820, 0xba8b66962033747e, 0x99e1fb70fa8875d2},
+		{0x695ee3ad450af82f, 0xd156c03af9220a48, 0x12506b9639f46b0c,
+		    0xd3849aaf8e5a9900, 0xd05b2a0af3dd7842, 0xc135ef716137be74},
+	},
+	{
+		{0xc177deb0c000482e, 0xa7ab5df2721cdf81, 0x876276d6b9cd553c,
+		    0x50727e106f4fb36f, 0x7ffd257ee562f229, 0x7d1249af0b5195a0},
+		{0x46727cb4960ab1bd, 0xa0ba304fcfe01c6d, 0x9d45e6704aaa7343,
+		    0xcf78f0ba85fffbe9, 0x416b82eb2fae8b36, 0x2d21689e1fbbab15},
+	},
+	{
+		{0xd2d428ec526b8535, 0x7f554f9c42280de6, 0xc27c72a2e27710ef,
+		    0x79b185dfee3ab1ce, 0x65a8ed6cc384c9c9, 0xdf5ea38133398184},
+		{0xd5ca91e071b9b0eb, 0xd2a71ba64b01df1d, 0x623e7e292176e67b,
+		    0x28d5c6efd81a640b, 0x1e3cb9888a29aabe, 0xe34fdff7613ea6ef},
+	},
+	{
+		{0x0ff89217c9354371, 0x09a96fd5c92e4060, 0xe5ac189f8133b172,
+		    0xfa44d5ac5e5322bf, 0xf6fd572ee3c88ad0, 0x038e3be979856836},
+		{0x31fdd8f086c93d88, 0xe4008a35d5e7e08e, 0x506e79191316aa65,
+		    0x6ec7cc1c5601fb0e, 0x65930e25db24660a, 0xbf89fd7febebb2b4},
+	},
+	{
+		{0xfe3f406ac84d57a5, 0x81622742c3b7ae03, 0x75e6422b081e6967,
+		    0x4c5dfa22d15af24b, 0xe3b537a6e111fc0a, 0xf498a4ae935944b1},
+		{0x64cc864d4f414baa, 0x8524b67059a47852, 0xb97ef796241e9168,
+		    0x3b5cebef943ec06a, 0xadf7f6012682cec1, 0x535552a003912df6},
+	},
+	{
+		{0xa9ea3d1b1fe7a1af, 0x2d6343834146e9f2, 0x898326d2258afd70,
+		    0x3e7ba384d31bbb25, 0x5a827cde0b9270db, 0xf24e65a949a2cd34},
+		{0xebec09952a961dc5, 0x35cfa07d50349919, 0xfff0da40fe1c6e81,
+		    0x724da45a6ff89f05, 0x089d36ad29f22981, 0x6fdc210ae0436a9c},
+	},
+	{
+		{0x2f497a5609e6c6b9, 0x0d6125a1a20fb096, 0x0f54becfef144e84,
+		    0x844484437629ba01, 0x3fccaeadc63002b2, 0x2429f6636931da04},
+		{0x71c51ce6f474ba3f, 0xfd7321b77288a956, 0x9d0ead270eaf053d,
+		    0x7dc30a8724c55e4f, 0xcdd37aba0ac88c60, 0xd87d156a778a9e78},
+	},
+	{
+		{0x8c3e5d1942d503d9, 0x81cf992d39871d2c, 0xc0eb0609c015b1b5,
+		    0x58f03f35021eb64b, 0x06e4ebcf92babc09, 0x0a061c1549d113c7},
+		{0x9cb97bc88be3be01, 0x11ee6aae226e73ea, 0x05cbceff1b005392,
+		    0x3bd9160cc6a18dd7, 0x7d651d2679b5a1b9, 0x67585c912b590df1},
+	},
+	{
+		{0xe7b66a7faa6c87ce, 0x27722a0b66785930, 0x75e36e7e412cec3d,
+		    0xd9a33eb6fe330c15, 0x95366e0928caa963, 0x59962a8bf816dbed},
+		{0xb8839d795a5125c2, 0x6b43a0f709bed209, 0x14831ee883549e2c,
+		    0x6b61518d1fa75c6d, 0xc3604ba586e823cc, 0xbda24c2a99aa76c5},
+	},
+	{
+		{0xa5d3262e6d592fb7, 0xa933168ef01452db, 0x473015c6a49c8651,
+		    0xa9b03fff5fd0ed2f, 0xd9eed83ceba27bfe, 0x1bb6f09ba8740cd7},
+		{0xbc77842c99c1ec46, 0xe1a62ac7b4c49453, 0x3ece29f19a0a0562,
+		    0x6606ac20d4e5448d, 0xbc2a8057309be4a1, 0x142c5ee9c1f07eef},
+	},
+	{
+		{0xa6cdeaeae441b2f9, 0xd311ce4ec30dde69, 0x6b4759161dcd5761,
+		    0x28ada2419c02057e, 0xb32391a95e7cc39b, 0x3e9e6f74ef087265},
+		{0x7c89aaf8c6a42ffe, 0xd96d082b37dd8ea6, 0x807cee7e20bc38ec,
+		    0x0f8f4e0f2e39f529, 0x3581645be0939142, 0x3edc48170404ed67},
+	},
+	{
+		{0x0539903fd2b59a0a, 0x41e3506a9efbbe92, 0x16f66c81a05d27c8,
+		    0x7c99533a7569c074, 0x4c88b6c140d80827, 0xca130b859d98d299},
+		{0x41e6be721085856f, 0xfc5a7f0c7cb7da46, 0x5b592b5921369625,
+		    0x019822fe32f254ce, 0xb82bb47dc13bd747, 0x5ca561b717f00e34},
+	},
+	{
+		{0x451b68c19b0f9a5b, 0xebb5e03ecee2827b, 0x677a5650c8eae60f,
+		    0x9c38ba9572806dff, 0x34522a1f45c89ce4, 0x3a8c47043498088e},
+		{0xd1ee1a14c214e2ed, 0xd0a5ce81d1ea13ba, 0x4c42b188db213d9b,
+		    0x25fcaeec374e9bd9, 0xd8f32ab928d425ca, 0xde49462a575a96e3},
+	},
+	{
+		{0xfe1a26bdbc71955b, 0x27aaffd13b68aa98, 0xcc0b0ce40cd78e9f,
+		    0x027b173417c3b4b6, 0x02c32412937f45a5, 0x3d23e9b2d018f3d9},
+		{0xe0a04c48bc707aee, 0xc3e8f3cd526d420f, 0x8abcd4f149b34e46,
+		    0xb157757112983bc2, 0xa40f2b08d1930428, 0xf1351608e341d0fd},
+	},
+	{
+		{0x08c163138fcf5263, 0x3500d3406c93a9c7, 0xb33c4af5c04d7bdd,
+		    0xc26cb33ecf0a0546, 0xcad341c7c1dc0b99, 0xe3af1934eac7a5d5},
+		{0xff0fbb5a39d13400, 0x0d0b5c0b057dbf46, 0x0f0c2c2b167566f1,
+		    0xaeae27b4d10d5e10, 0x99e9da309258b90b, 0x4c3540178df9ffff},
+	},
+	{
+		{0x0ac052d40c9594c5, 0x445df013cbb9c078, 0x5bd752a88284b86e,
+		    0x29dcc189a265c9bc, 0x8a36561ded9bc02a, 0x33d0f116f22f7dd1},
+		{0xbbe4931d6714dcd0, 0xeebe82b717327440, 0x3c16d75c19492ef9,
+		    0x5c7eb68f6e8a48a3, 0xc55cce777742b2e7, 0x9fcecd6af6886c18},
+	},
+	{
+		{0x88fbadce8d827af2, 0x88976446c317c4ff, 0x7d10bd672a76eb13,
+		    0x410b125ace6342af, 0x180ad703e57d1401, 0xccd97f9806943b5f},
+		{0x2adc413cc316fba9, 0x7b2a7815408d8fca, 0xbef063dd58ef5aef,
+		    0x034bba925c2a102c, 0x6b31beb2f19095ea, 0x276b5df71b450d8c},
+	},
+	{
+		{0x70b9e07cfe6c2175, 0x09e23604166c6526, 0xdd94b2dc5b4fc43f,
+		    0xfda77c0174152980, 0x77e68418d892d95d, 0x6fddc68fc61e5f41},
+		{0x7ee68410836a99f5, 0x18ef453a8428b1e8, 0x251eadd6e92d4f9b,
+		    0x2fa423be7249b0bc, 0xea364debe6129d2f, 0x41b7c1356ef2287d},
+	},
+	{
+		{0x5b151b3c6c5443de, 0x548ee2339c2b719b, 0x61f1a7a58b77c032,
+		    0x110fb19fa946c4f9, 0xb99d8c8e6d286bba, 0x99755665697ea295},
+		{0x11c94d02bd5e234f, 0x8e75f2b827875c19, 0xb086183bc5857b98,
+		    0x2c234aa53b17ff9d, 0xef0a24f13b508ce9, 0x336b2d8b2ba69f1e},
+	},
+	{
+		{0x0c62f019ec141c31, 0x2491373df87e6397, 0xb8e1c6368aaf02d3,
+		    0x85de06149722d79d, 0xacfce56feaff1fc5, 0xc8c609efaa85c5cc},
+		{0x8cb9dee8f82518a9, 0x958371f92f353330, 0x24bb8a4503d5a430,
+		    0xc63f02e921fb8752, 0xd14fb367161fe465, 0xf1ceec87eac15c37},
+	},
+	{
+		{0x2b40e78c7873a81a, 0x9885199bbc171cf2, 0x21e6cf9d91fcd86b,
+		    0x74dde55cb0789035, 0x2f232a1a1e3d6ac9, 0x730887b47bd74aac},
+		{0x1274d6bff570af9c, 0x29ee8d42ed711e57, 0x160ae1c4659477b1,
+		    0x62febc36388693bb, 0x4fc52afe724a4b23, 0xe2515296d5677a8f},
+	},
+};
+
+static const uint64_t p521_p[9] = {
+	0xffffffffffffffffULL, 0xffffffffffffffffULL,
+	0xffffffffffffffffULL, 0xffffffffffffffffULL,
+	0xffffffffffffffffULL, 0xffffffffffffffffULL,
+	0xffffffffffffffffULL, 0xffffffffffffffffULL,
+	0x00000000000001ffULL,
+};
+static const uint64_t p521_b[9] = {
+	0xef451fd46b503f00ULL, 0x3573df883d2c34f1ULL,
+	0x1652c0bd3bb1bf07ULL, 0x56193951ec7e937bULL,
+	0xb8b489918ef109e1ULL, 0xa2da725b99b315f3ULL,
+	0x929a21a0b68540eeULL, 0x953eb9618e1c9a1fULL,
+	0x0000000000000051ULL,
+};
+static const uint64_t p521_n[9] = {
+	0xbb6fb71e91386409ULL, 0x3bb5c9b8899c47aeULL,
+	0x7fcc0148f709a5d0ULL, 0x51868783bf2f966bULL,
+	0xfffffffffffffffaULL, 0xffffffffffffffffULL,
+	0xffffffffffffffffULL, 0xffffffffffffffffULL,
+	0x00000000000001ffULL,
+};
+static const uint64_t p521_gx[9] = {
+	0xf97e7e31c2e5bd66ULL, 0x3348b3c1856a429bULL,
+	0xfe1dc127a2ffa8deULL, 0xa14b5e77efe75928ULL,
+	0xf828af606b4d3dbaULL, 0x9c648139053fb521ULL,
+	0x9e3ecb662395b442ULL, 0x858e06b70404e9cdULL,
+	0x00000000000000c6ULL,
+};
+static const uint64_t p521_gy[9] = {
+	0x88be94769fd16650ULL, 0x353c7086a272c240ULL,
+	0xc550b9013fad0761ULL, 0x97ee72995ef42640ULL,
+	0x17afbd17273e662cULL, 0x98f54449579b4468ULL,
+	0x5c8a5fb42c7d1bd9ULL, 0x39296a789a3bc004ULL,
+	0x0000000000000118ULL,
+};
+static const uint64_t p521_rr[9] = {
+	0x0000000000000001ULL, 0x0000000000000000ULL,
+	0x0000000000000000ULL, 0x0000000000000000ULL,
+	0x0000000000000000ULL, 0x0000000000000000ULL,
+	0x0000000000000000ULL, 0x0000000000000000ULL,
+	0x0000000000000000ULL,
+};
+
+static const uint64_t p521_g_comb[EC_COMB_ENTRIES][2][9] = {
+	{
+		{0x5dabc902d0a6dbf0, 0x652aad00ac2e526b, 0x19196d8a85e9e558,
+		    0x1cfa6afa19257266, 0x4e0443321b3f0d79, 0x8011178002300df2,
+		    0x87c71ec556cf0f3e, 0x889df75dd2767ac8, 0x00000000000001e1},
+		{0x264c9c5832d98450, 0x9e43825e75ab88d2, 0xda8723b07965d980,
+		    0x406bd877914b545b, 0x9e647977c70f887e, 0x62e18975c41582d8,
+		    0x835374826c83524a, 0x6aff1ef63a5d0965, 0x00000000000001d3},
+	},
+	{
+		{0xfc3505c0e2c03d79, 0x1d38b7248185032e, 0x2b6d681fb798b37c,
+		    0x4065bd27de1e5c09, 0xcd26842a221f0c51, 0xc312e6fa16eedc7b,
+		    0x08298382985d9bf8, 0xc8fbeb49d3a7fff2, 0x0000000000000001},
+		{0xd8cab527b7fb29bd, 0x487e818302399fa8, 0xb3057ab57dfb5ec2,
+		    0x1fcda72cbef538c7, 0x54f27e8090607df4, 0xcba9f56c907a3dee,
+		    0xdad2f7605000f573, 0x251d7ac8a7a2d924, 0x00000000000000f0},
+	},
+	{
+		{0x0f3596174b54ef36, 0x3bbb423e9048bb9d, 0x7bce8f5cba6a4dee,
+		    0x03100481ab93da8b, 0x4031aa52a64df7cd, 0x3fe6a29482238a0e,
+		    0x22349bc6a56b01de, 0x40a6885cfda7e64d, 0x0000000000000045},
+		{0x708de26ee2bbd433, 0xad9526bd4c563bf5, 0xb0fb935856b2f080,
+		    0x287a877d150227b0, 0x4daa507b64df471a, 0x95d66481fa7efcc1,
+		    0xbaf333a7de9acbbc, 0x2a31103a1384b575, 0x0000000000000092},
+	},
+	{
+		{0xccdde11f76918e97, 0x239a03c553defdb6, 0x5d555f079303bd8b,
+		    0x776edf814ade380c, 0xeaec2f43ff6b1153, 0xe9131d88e338c49f,
+		    0x9b17f46d2dea7c41, 0xbc4eec0a0f8f99f9, 0x00000000000001a0},
+		{0x54f4fa8e45b3f922, 0xf496dd84c674828f, 0x05b807d7ff3533c3,
+		    0x3280e7ac4ae8d65d, 0x7826e6718741b5ba, 0x8ac0f007fc7c209e,
+		    0x4d155f2456c4f3b0, 0xd824194072e0859f, 0x000000000000009d},
+	},
+	{
+		{0x8f5ecd5cb76e7d48, 0xcde12000d5ff0843, 0xcedc1335b924b2d8,
+		    0x472b1aa1b322cb9c, 0x440a318403b5c93f, 0xe1ee279a9b2a434b,
+		    0xa5a56ac488e5fecf, 0x5667a452ac3de98d, 0x0000000000000144},
+		{0x0ca9e3105dfbbd73, 0xb85c2f081f0247f7, 0x8ef6df3f10b9c347,
+		    0x542355a693a8ef3a, 0xea4e1bb9b8e42b2f, 0xe1d618cd98d7d0f1,
+		    0x194f59907b1f1c48, 0x0890d669eadf5269, 0x000000000000014e},
+	},
+	{
+		{0x8c33fc5fe6e2c2ad, 0xe232ea8cfa8ce140, 0xa617196252daca3d,
+		    0xf4a664810d0df91f, 0x2078a85d6ad104f5, 0x98ba5676f0d0ecc0,
+		    0x06fd757f57996715, 0xbb5d1d0470cc9f65, 0x0000000000000179},
+		{0x3bc1805f03f9e66e, 0x2e2cd7d2a9cbb1a2, 0x07ae77f45583a0d0,
+		    0xab4a5d50a6352231, 0x14a5ce908e9a0303, 0x7acc82725eda975f,
+		    0x471c73fa65ce77b9, 0xdd660789b90dc021, 0x00000000000001af},
+	},
+	{
+		{0xd6d69adbbb359d6e, 0x03c131c21f438c1a, 0x394df149eb679df8,
+		    0x6198616479de8bf5, 0xa048cf915815dc86, 0x13163eb08191d468,
+		    0xac9e97ad6f4db395, 0xce53e31f84f2d874, 0x0000000000000055},
+		{0xc3ecfb94324c44c0, 0x618b57acb14df507, 0x025e5bc8314ae558,
+		    0x6d41ce7ef3d2a6bc, 0x3dfdcd3e2a10a4f5, 0x3955ac5923f952f7,
+		    0x43617eabac2753cb, 0x3b2ba33e82787e29, 0x0000000000000009},
+	},
+	{
+		{0xf77bbdc358e30b77, 0x5272406bb9306f31, 0xbb26da4cc013dcf3,
+		    0x5ac9956640db4daf, 0x4c8c39bb76a2f86e, 0x55f194363d287209,
+		    0xdfe78b0ee92ffdcf, 0x70d3bf2c52dfb9e4, 0x00000000000001f6},
+		{0x25144708db0df74c, 0x0650b28be9fba997, 0x41fecb81130b1e46,
+		    0xa61082e8a7923eae, 0x4339cd4b592d078a, 0x5176c7865025e56f,
+		    0x7c828b300feeece6, 0xc8666e523c1e294d, 0x0000000000000179},
+	},
+	{
+		{0x3507118d1e393f7d, 0xfc591cc35b425343, 0xe09e99fd50ae091a,
+		    0x84eea85cb0bf73c9, 0x098454afe474616b, 0xd8435d273dea0671,
+		    0x58ce4ed72f770f87, 0x166a889e4e34fdf2, 0x000000000000000b},
+		{0xc75038a41b4adbe9, 0x93c30028373f3167, 0x6c23e283321078de,
+		    0xd724e0438e18d8b3, 0xdcbd7fc45122350a, 0x199a3cb97fed67a5,
+		    0x25331c05f36a8bbc, 0xfd6019f5dadf2635, 0x000000000000016c},
+	},
+	{
+		{0xe56d1aefec8b9d53, 0x9d641da20d2033cf, 0x5c3c8ef90aac846d,
+		    0x2a8a1efe905aa2df, 0x61e35ddb8bd29cad, 0x27e05d1c3be3013b,
+		    0xece998a22b67be2e, 0x73ce8f7d425b453d, 0x0000000000000107},
+		{0x230db18cc3ce1fc3, 0xda7db52c0f8672ca, 0x08544d02ea3ef24d,
+		    0x0a62cc49147f5eee, 0x80571551779a409c, 0xbcedf2a0acd66ef0,
+		    0x0079c6e9e5601066, 0x19eab15d990fa238, 0x00000000000000d8},
+	},
+	{
+		{0x0048b1078c2db445, 0xa3777c79c25fabe9, 0xd3f6cceaad11a386,
+		    0x7c987eecf7ab6895, 0x25d0b1b4a56885ef, 0xf32dbf0cb3f050d2,
+		    0x5df940a282e9e328, 0xe4d5cf5c57a1dad5, 0x00000000000001b0},
+		{0x3d4b1aa1cb520217, 0x793f91a1fd936afd, 0x155f29c56cf57814,
+		    0xe24170725df1b621, 0x4803606ea06e9723, 0x438db960f2674fc8,
+		    0xb1533e6e84094c54, 0xf49eb49156c9175c, 0x0000000000000059},
+	},
+	{
+		{0x8e772229b6b59733, 0xed513088ba2da3ca, 0x8fa8b23efc9d4f1e,
+		    0xf0d9c234c4245e55, 0x7b9990b7c7b9799c, 0x2738b709fd12496a,
+		    0x201eb9524d968b7d, 0x4cb657de34169550, 0x0000000000000122},
+		{0x31f08a981642ff7b, 0xca422d52e744e6bc, 0x37edf4ac8fdfe250,
+		    0x303d3a35278e8ece, 0x8fbf48476e143333, 0xf9fd82816cb4b8b4,
+		    0x51f669e75ecbd7b0, 0xabc2f842aa9bd39e, 0x000000000000017b},
+	},
+	{
+		{0xe840779e554dd365, 0xe2a6960e6688ea97, 0x459f7b907f978272,
+		    0x1cc8a6112c4defaa, 0xd9c6893c36be77d1, 0x6146828dc2d2e45d,
+		    0x8d792a3db564f43b, 0x534fd5d1996a5172, 0x0000000000000177},
+		{0xb9d6c4152eb91ccb, 0xdec21eca1e3c536e, 0x035001900f6da7a2,
+		    0x08a6f9a6d64ff1c5, 0x263d1b4c0ca55872, 0x87989b040fc04573,
+		    0xf25cc00a8264edaa, 0x336a7388fb4fc989, 0x0000000000000040},
+	},
+	{
+		{0xa09c48fce1430c58, 0x222695c7270d21b8, 0x4110b99547a2e4e1,
+		    0x8ab2c4ba2b59e371, 0xf148429027782e6a, 0xded055c49cf7c552,
+		    0x7da9ad8a47eaad34, 0x5cd1d92981c64ab5, 0x00000000000000ca},
+		{0xe2d04d2f313c3199, 0x68b4ae14c531dda9, 0x42f610911aea572c,
+		    0x9c34d1d65c823b77, 0x8c2182101fa09cd6, 0x7e293327f862e891,
+		    0xf8a62b1903fa02dc, 0x51e6b34dfc1bf647, 0x000000000000019b},
+	},
+	{
+		{0x22ac99b50636bdde, 0x882cfd9872d03551, 0x5d359e7674fa277e,
+		    0x349bc7bf0c74bd14, 0x2036e97ab81e8d13, 0x76a43e9aebb2417f,
+		    0xc9218c422c3c2125, 0xbd9259f26a795853, 0x0000000000000138},
+		{0x92ae71d1f21832dc, 0x9d75656b89df9cb7, 0x621ec3c0045a6c8c,
+		    0x15a4f240fe70604f, 0x784ce70cbb37bbf3, 0xf0e09eaa9f5d3ffb,
+		    0xd9b284ab0ef9f4e5, 0xfd185cb8c4b48777, 0x00000000000000b0},
+	},
+	{
+		{0xbe268407b426146b, 0x302e912a668fba99, 0x0980f8932cd01c21,
+		    0x06486e21a123a0f3, 0xf161ab8fbd6216ad, 0xddfb4cef8d4fa688,
+		    0x8704d8d72f82602e, 0x6f73cdcd76c9f673, 0x000000000000000a},
+		{0x9bc7e6e2f72527d1, 0xaf811019fe9d0c98, 0xc63480de0cc31d10,
+		    0xa4a7d2eb365d1edd, 0xce3cfdd00574e2ab, 0xc1eb9186909be460,
+		    0x510c902352fb5cdc, 0x6ff21ea2f8100ef5, 0x0000000000000159},
+	},
+	{
+		{0x77fd37cbd60b478e, 0x265f315ac055793e, 0x2a5d5b59d1a0592c,
+		    0xae3232ab24db22a6, 0x6e43a414a2bcccdc, 0x2944fe1a8f18dbfe,
+		    0xaae8b6679e2ad30c, 0x38e7278f35bc9b65, 0x000000000000000d},
+		{0x03f93d5f9ca65945, 0x1858e10298162c33, 0x15424f1a40e22108,
+		    0x81e25abe5880ad56, 0x48eb48f92faedbc3, 0x67a098a830510cfa,
+		    0x523941bf3f8ad40f, 0xec94a212decacc55, 0x0000000000000144},
+	},
+	{
+		{0x573dc0d24d814035, 0x75de69895bd43ed2, 0xf8c06143ed8fc701,
+		    0x130f665ad3a1d925, 0x869a6df2d819cb4e, 0x9ab8532771b57557,
+		    0xb25bab1d22b89bf5, 0x69b1dd4b8743a4d9, 0x00000000000000d2},
+		{0x3a73d3fe3c7e44a0, 0x6e041694ac0413cd, 0x21f7497535ea3f8d,
+		    0xe5cf5eb679698c0c, 0xd683170e51a280d9, 0xf17fa4b86586f441,
+		    0x923a7bf3100bfcce, 0x5bed3d696809c6fc, 0x00000000000001d8},
+	},
+	{
+		{0x485b2717e3fe8baf, 0x73fc8c88ae8a1843, 0xac8e3a1c57886f49,
+		    0xc6c2289e78fbc516, 0x84bffafad291f3be, 0xa2db5c5a2ebf0745,
+		    0x4eacb0f616f619e9, 0xfa4e6888447e5fe3, 0x0000000000000178},
+		{0x4b658b74af5a3bd4, 0x902ab962d1c92e41, 0xfda188beffa2d442,
+		    0xe36cf721a7c52684, 0x40ce9dc16246d6f6, 0xc4e9f8b9fe4c83ca,
+		    0xb1362e4698fa2265, 0x06cd5ebbf1a11bcb, 0x0000000000000199},
+	},
+	{
+		{0x329e364acc463ae3, 0x06f21f306238f012, 0xf48fd21b2e93dfb2,
+		    0xb2f5f3836bb30ad0, 0x9159cbe4a881de16, 0x63eeac021a0c6efc,
+		    0xaf2439659fff7742, 0x6a5acfb4b942db98, 0x0000000000000050},
+		{0x70ecb9e27b9f0dc2, 0x5bfd2711d218efc6, 0xa5f8c1f2eafd5c1d,
+		    0x9ad08c7b112c96d6, 0xfca3f48c81993694, 0x442d1b8218407fa1,
+		    0x776df1bb47d8b083, 0x6a63965893168483, 0x000000000000003f},
+	},
+	{
+		{0xeaec92a5c02cc8ae, 0x332d1a0a85a42959, 0xdd8c33a93d596815,
+		    0x26930c57888feaad, 0x9cff41de82ebea46, 0x8217488a23a8e16d,
+		    0x9f6aa3ea8a1c8a8a, 0x1ccf4a832f744260, 0x0000000000000063},
+		{0x9bd6db202bcae2f6, 0xc9bcf871076194d0, 0x7a28ba67971acec7,
+		    0x51347b302108bdab, 0xeff2f809de470d16, 0xcf985917ccb073e1,
+		    0xbfa4297c463e7b6a, 0x42fe5abe8397ee90, 0x000000000000008d},
+	},
+	{
+		{0x052b35a820e5cef8, 0xb852a30ba68fe203, 0xe9ff65e0653b7dc3,
+		    0xccb7b6a0ef1f8777, 0xcee22b5a98ef017d, 0x34709aed1121162d,
+		    0xf08d0af650a14b06, 0x15903b7671da7754, 0x00000000000001f6},
+		{0x893551591fca3582, 0x1836823a01fdc214, 0x497ed05d213c927a,
+		    0xae5390d1d9f5c3ac, 0x5bfdac8c3e19dde7, 0x2e0dcb4cd4b2574d,
+		    0x8b409a5f094e24e7, 0xa8cb89fdddc26c63, 0x000000000000002b},
+	},
+	{
+		{0x9d30d94eff57eba2, 0x420145b3c6bcbea4, 0x03549c08fb0db06e,
+		    0x76369258dfbdf691, 0x74fb265902d36d45, 0x32eb665d15b8a1bb,
+		    0xc524094dde16b056, 0x7e8c0f3880abb07c, 0x000000000000011d},
+		{0x26fd28bbabf56db4, 0xd7a924c1548e3ebf, 0x13305df14c958362,
+		    0x912f31a3d8c55f4b, 0xe65ad7b551aae91c, 0x217f335cc93023ad,
+		    0x2e932cb8741f3fac, 0x42ef2d760766758e, 0x0000000000000193},
+	},
+	{
+		{0x5514eaaa034d4fb0, 0x635a2565f4444583, 0xbc57969bcba87b5f,
+		    0x30804fb8822f666f, 0xec070e528f135a07, 0xd1fff81cb3e9f458,
+		    0xa9a7c04431568292, 0xd9a1f027a5f7429a, 0x00000000000000bb},
+		{0x539bd1bb369a70d8, 0xdfa51ac4d2dd448e, 0x351b71df2a0a5f1d,
+		    0x20aa681687186d8d, 0x9ad66166054cd585, 0x024235f0277cb590,
+		    0xe9ffe8e2edd3d625, 0x0a98deed3c7bbf55, 0x0000000000000025},
+	},
+	{
+		{0xb2a49d7610f87d38, 0x080daa1242641368, 0xf5f4e09ab837685c,
+		    0xe8f9dec21206c229, 0x1fa2bbace472efe9, 0xd7a6b1a8d5d0fffd,
+		    0x6b1d1c619de87067, 0xbde82407dabe9178, 0x0000000000000145},
+		{0x33caf53502f95074, 0x7ce87271e6287e49, 0xece8660f009460e0,
+		    0x3792a018f501db73, 0x36b76bd25471cf48, 0x061c86da7eed2e2d,
+		    0x3043cc3a8e50e288, 0x59c53ac888d9828d, 0x0000000000000176},
+	},
+	{
+		{0x9b2b90f624213548, 0x236369d0b72ca19a, 0xef7a135430d2cbef,
+		    0x211c392b38278b2f, 0xf4f1b6634a5fea26, 0xd29a14277f27f8b3,
+		    0x45a4cca52e18c7c9, 0x2060f2f0dd4e9bc1, 0x0000000000000019},
+		{0x90e9909ea5425980, 0x48c4b5179af177d7, 0x58f4bb726b2a80e1,
+		    0x6e97380019064adf, 0x45e6711c378250f6, 0xe50078553cdf9b45,
+		    0x6172a550e89cbf73, 0xff3df435e0421204, 0x00000000000000fd},
+	},
+	{
+		{0xe2c9f2c317ba628f, 0x3ec85696e36f45a6, 0x423a0dc9e59491ee,
+		    0xea1f7124841f563d, 0xd0b9719151a7e0b2, 0x6f32dba2b069e8c5,
+		    0xecca9ca87802a1c1, 0x4ab2fbbfc551502b, 0x0000000000000095},
+		{0xb3b26a088fb87f9f, 0x8485148833302882, 0x6d04eb4c6f224d8e,
+		    0x5f208284f12e9686, 0x780b85e07457cbf4, 0x37be8df02f11c1cf,
+		    0x9332262f596e9fd6, 0x8ee38636de243678, 0x0000000000000080},
+	},
+	{
+		{0x2747ec61b06f6d56, 0x04889e6cd5631215, 0x511a73a0e603e30f,
+		    0xbbd176d30064d78c, 0x096fd1e19aa7dedc, 0x2817896b3932cdef,
+		    0xd5096c2cb47144c8, 0x7801c279bb34209f, 0x000000000000003f},
+		{0x64c533c321ef4396, 0x3550dce843c2bb2e, 0x76dd7315466261e2,
+		    0x9db4425e88883f39, 0xde7fb10f338ca6f1, 0x02c7dc9259c2a4fe,
+		    0x398cb3d4af617008, 0xb41ff60910ac1832, 0x00000000000001b5},
+	},
+	{
+		{0x7f52505ade299406, 0xd12ba7a490715d15, 0xdd473d8046283a45,
+		    0x100aa6a7c69b8f3e, 0xa35e240390eaa913, 0xeca794aa56b82d8a,
+		    0x64f69d5f4dddb63b, 0x7a642a7030166515, 0x000000000000015a},
+		{0xe212f26bc5475b4b, 0xd3317dd7673b14b9, 0xe9b2214c93df9238,
+		    0xf5c5447e2e77aeb7, 0x6144e89545c3624d, 0xefb3d487bd7a7900,
+		    0x0146d10efc738468, 0xe311b60acd2644cc, 0x0000000000000072},
+	},
+	{
+		{0x1409adfa4ba699e0, 0xa879793ad0b92489, 0x20ffc166f909c1b9,
+		    0xc57a8314e1d21dc6, 0x017ef8af918e6aeb, 0x9e9ee8ee39236f47,
+		    0x764c8cd60f5af7d7, 0x72a9de2fea9f8b53, 0x0000000000000021},
+		{0x0dbf7fa130a3c67f, 0xf10c5a6fba821ab5, 0x91139d0024ab58e6,
+		    0x440bab029eb5a072, 0x16ed6517b3f19eb4, 0xb10a7ee0c471eccf,
+		    0x77c239f60b1c5cb4, 0xdd1916c6eb31d2db, 0x0000000000000166},
+	},
+	{
+		{0xb3b6f22a14e50463, 0x1007e9d4d38a12a9, 0x176fb8313f6a367e,
+		    0x1eabb21e42a7ba35, 0x6618e85872975ae7, 0x3c62b1b70a058304,
+		    0xe7b22d0151e0b3a0, 0x9c67ed451e54a60a, 0x0000000000000107},
+		{0x412cb7e755c27832, 0x2201b271f282e305, 0xd04cf343cc19298c,
+		    0xef03655dd6d9efd5, 0x1a84f935a87bc64a, 0x55879ce7df7b2ef8,
+		    0x8e6c435ba740d039, 0xfeb3ea7528e9a2bd, 0x00000000000000b3},
+	},
+	{
+		{0x272883fb34c28cb6, 0x22b00e9e5e7d03a4, 0x23bbacb97f4602a2,
+		    0x27564d96c248ed06, 0x9b7e1ce6d1c5b544, 0xb3d77b2d71182e92,
+		    0xb18e78aade9d46ab, 0xde48d9e12e69d74d, 0x00000000000001fb},
+		{0x8de62222099effaf, 0x2212621b1328146c, 0x05f3c0b003677fcc,
+		    0xf43e4825fb0fc3c0, 0x94d3b33698536e0b, 0x22c1cca4225481eb,
+		    0x2b8668dfa9fcbaf5, 0x51e858f2c30e9271, 0x00000000000001e9},
+	},
+};
@@ -0,0 +1,919 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Scalar multiplication for NIST P-256 using fixed width field arithmetic.
+ *
+ * Field elements are held as four 64 bit limbs in Montgomery form with
+ * R = 2^256, which is the same representation that the Montgomery method
+ * uses for point coordinates, so points are exchanged with the generic code
+ * by copying limbs. Everything apart from scalar multiplication is left to
+ * the Montgomery method.
+ *
+ * Multiplication of the generator uses a two table comb with four teeth
+ * (32 doublings and 64 mixed additions), variable base multiplication uses
+ * a fixed four bit window. In both cases the sequence of field operations
+ * and memory accesses is independent of the scalar.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/err.h>
+
+#include "bn_lcl.h"
+#include "ec_lcl.h"
+
+#include "ecp_p256_table.h"
+
+typedef uint64_t p256_felem[4];
+
+typedef struct {
+	p256_felem X;
+	p256_felem Y;
+	p256_felem Z;
+} p256_point;
+
+/* p = 2^256 - 2^224 + 2^192 + 2^96 - 1 */
+static const p256_felem p256_p = {
+	0xffffffffffffffffULL, 0x00000000ffffffffULL,
+	0x0000000000000000ULL, 0xffffffff00000001ULL,
+};
+
+/* R mod p */
+static const p256_felem p256_one = {
+	0x0000000000000001ULL, 0xffffffff00000000ULL,
+	0xffffffffffffffffULL, 0x00000000fffffffeULL,
+};
+
+/* The group order n, which is below 2^256 and above 2^255. */
+static const uint64_t p256_n[4] = {
+	0xf3b9cac2fc632551ULL, 0xbce6faada7179e84ULL,
+	0xffffffffffffffffULL, 0xffffffff00000000ULL,
+};
+
+/* b, in normal form. */
+static const p256_felem p256_b = {
+	0x3bce3c3e27d2604bULL, 0x651d06b0cc53b0f6ULL,
+	0xb3ebbd55769886bcULL, 0x5ac635d8aa3a93e7ULL,
+};
+
+/* Returns the low half of a * b + c + d and stores the high half in hi. */
+static inline uint64_t
+p256_mac(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t *hi)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 t;
+
+	t = (unsigned __int128)a * b + c + d;
+	*hi = t >> 64;
+
+	return (uint64_t)t;
+#else
+	uint64_t a0 = a & 0xffffffff, a1 = a >> 32;
+	uint64_t b0 = b & 0xffffffff, b1 = b >> 32;
+	uint64_t p00, p01, p10, p11, mid, lo;
+
+	p00 = a0 * b0;
+	p01 = a0 * b1;
+	p10 = a1 * b0;
+	p11 = a1 * b1;
+
+	mid = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+	lo = (p00 & 0xffffffff) | (mid << 32);
+	*hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+
+	lo += c;
+	*hi += lo < c;
+	lo += d;
+	*hi += lo < d;
+
+	return lo;
+#endif
+}
+
+static inline uint64_t
+p256_addc(uint64_t a, uint64_t b, uint64_t carry, uint64_t *carry_out)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 t;
+
+	t = (unsigned __int128)a + b + carry;
+	*carry_out = t >> 64;
+
+	return (uint64_t)t;
+#else
+	uint64_t r;
+
+	r = a + carry;
+	*carry_out = r < carry;
+	r += b;
+	*carry_out += r < b;
+
+	return r;
+#endif
+}
+
+static inline uint64_t
+p256_subb(uint64_t a, uint64_t b, uint64_t borrow, uint64_t *borrow_out)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 t;
+
+	t = (unsigned __int128)a - b - borrow;
+	*borrow_out = (uint64_t)(t >> 64) & 1;
+
+	return (uint64_t)t;
+#else
+	uint64_t r;
+
+	r = a - b;
+	*borrow_out = a < b;
+	*borrow_out |= r < borrow;
+	r -= borrow;
+
+	return r;
+#endif
+}
+
+/* Returns all ones if a is zero, otherwise zero. */
+static inline uint64_t
+p256_felem_is_zero(const p256_felem a)
+{
+	uint64_t t;
+
+	t = a[0] | a[1] | a[2] | a[3];
+
+	return ((t | (0 - t)) >> 63) - 1;
+}
+
+static inline void
+p256_felem_select(p256_felem r, const p256_felem a, uint64_t mask)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		r[i] = (a[i] & mask) | (r[i] & ~mask);
+}
+
+/*
+ * Reduce a five limb value below 2p to below p, where carry is the most
+ * significant limb.
+ */
+static inline void
+p256_felem_reduce_once(p256_felem r, const p256_felem a, uint64_t carry)
+{
+	p256_felem t;
+	uint64_t borrow, mask;
+	int i;
+
+	borrow = 0;
+	for (i = 0; i < 4; i++)
+		t[i] = p256_subb(a[i], p256_p[i], borrow, &borrow);
+	(void)p256_subb(carry, 0, borrow, &borrow);
+
+	/* If the subtraction borrowed, a was already fully reduced. */
+	mask = 0 - borrow;
+	for (i = 0; i < 4; i++)
+		r[i] = (a[i] & mask) | (t[i] & ~mask);
+}
+
+static void
+p256_felem_add(p256_felem r, const p256_felem a, const p256_felem b)
+{
+	p256_felem t;
+	uint64_t carry;
+	int i;
+
+	carry = 0;
+	for (i = 0; i < 4; i++)
+		t[i] = p256_addc(a[i], b[i], carry, &carry);
+
+	p256_felem_reduce_once(r, t, carry);
+}
+
+static void
+p256_felem_sub(p256_felem r, const p256_felem a, const p256_felem b)
+{
+	uint64_t borrow, carry, mask;
+	int i;
+
+	borrow = 0;
+	for (i = 0; i < 4; i++)
+		r[i] = p256_subb(a[i], b[i], borrow, &borrow);
+
+	/* Add p back if the subtraction borrowed. */
+	mask = 0 - borrow;
+	carry = 0;
+	for (i = 0; i < 4; i++)
+		r[i] = p256_addc(r[i], p256_p[i] & mask, carry, &carry);
+}
+
+/* t[0..4] = t[0..3] + a * b, where t[4] is overwritten. */
+static inline void
+p256_mul_row(uint64_t t[5], const p256_felem a, uint64_t b)
+{
+	uint64_t carry;
+
+	t[0] = p256_mac(a[0], b, t[0], 0, &carry);
+	t[1] = p256_mac(a[1], b, t[1], carry, &carry);
+	t[2] = p256_mac(a[2], b, t[2], carry, &carry);
+	t[3] = p256_mac(a[3], b, t[3], carry, &carry);
+	t[4] = carry;
+}
+
+/*
+ * One Montgomery reduction step, adding m * p to t where m = t[0] so that
+ * t[0] becomes zero. Since the least significant limb of p is 2^64 - 1,
+ * -p^-1 mod 2^64 is 1, the low limb of t[0] + m * p[0] is always zero with
+ * a carry of m, and p[2] is zero. The carry out of t[4] is accumulated in
+ * top, which is added back in by the next step.
+ */
+static inline void
+p256_reduce_row(uint64_t t[5], uint64_t *top)
+{
+	uint64_t carry, m;
+
+	m = t[0];
+	t[1] = p256_mac(m, p256_p[1], t[1], m, &carry);
+	t[2] = p256_addc(t[2], carry, 0, &carry);
+	t[3] = p256_mac(m, p256_p[3], t[3], carry, &carry);
+	t[4] = p256_addc(t[4], carry, *top, top);
+}
+
+/* Montgomery multiplication, r = a * b * R^-1 mod p. */
+static void
+p256_felem_mul(p256_felem r, const p256_felem a, const p256_felem b)
+{
+	uint64_t t[8] = { 0 };
+	uint64_t top = 0;
+
+	p256_mul_row(&t[0], a, b[0]);
+	p256_mul_row(&t[1], a, b[1]);
+	p256_mul_row(&t[2], a, b[2]);
+	p256_mul_row(&t[3], a, b[3]);
+
+	p256_reduce_row(&t[0], &top);
+	p256_reduce_row(&t[1], &top);
+	p256_reduce_row(&t[2], &top);
+	p256_reduce_row(&t[3], &top);
+
+	p256_felem_reduce_once(r, &t[4], top);
+}
+
+static void
+p256_felem_sqr(p256_felem r, const p256_felem a)
+{
+	p256_felem_mul(r, a, a);
+}
+
+static void
+p256_felem_sqr_n(p256_felem r, const p256_felem a, int n)
+{
+	p256_felem_sqr(r, a);
+	while (--n > 0)
+		p256_felem_sqr(r, r);
+}
+
+/*
+ * Inversion by Fermat's little theorem, r = a^(p - 2). The exponent is
+ * ffffffff 00000001 00000000 00000000 00000000 ffffffff ffffffff fffffffd.
+ */
+static void
+p256_felem_inv(p256_felem r, const p256_felem a)
+{
+	p256_felem p2, p4, p8, p16, p32, t;
+
+	p256_felem_sqr(t, a);
+	p256_felem_mul(p2, t, a);		/* 2^2 - 1 */
+	p256_felem_sqr_n(t, p2, 2);
+	p256_felem_mul(p4, t, p2);		/* 2^4 - 1 */
+	p256_felem_sqr_n(t, p4, 4);
+	p256_felem_mul(p8, t, p4);		/* 2^8 - 1 */
+	p256_felem_sqr_n(t, p8, 8);
+	p256_felem_mul(p16, t, p8);		/* 2^16 - 1 */
+	p256_felem_sqr_n(t, p16, 16);
+	p256_felem_mul(p32, t, p16);		/* 2^32 - 1 */
+
+	p256_felem_sqr_n(t, p32, 32);
+	p256_felem_mul(t, t, a);		/* ffffffff 00000001 */
+	p256_felem_sqr_n(t, t, 128);
+	p256_felem_mul(t, t, p32);		/* ... 00000000 ffffffff */
+	p256_felem_sqr_n(t, t, 32);
+	p256_felem_mul(t, t, p32);		/* ... ffffffff ffffffff */
+	p256_felem_sqr_n(t, t, 16);
+	p256_felem_mul(t, t, p16);
+	p256_felem_sqr_n(t, t, 8);
+	p256_felem_mul(t, t, p8);
+	p256_felem_sqr_n(t, t, 4);
+	p256_felem_mul(t, t, p4);
+	p256_felem_sqr_n(t, t, 2);
+	p256_felem_mul(t, t, p2);		/* ... 3fffffff */
+	p256_felem_sqr_n(t, t, 2);
+	p256_felem_mul(r, t, a);		/* ... fffffffd */
+}
+
+/*
+ * Point doubling in Jacobian coordinates for a = -3 ("dbl-2001-b"). The
+ * point at infinity (Z = 0) is mapped to itself.
+ */
+static void
+p256_point_double(p256_point *r, const p256_point *a)
+{
+	p256_felem delta, gamma, beta, alpha, t0, t1;
+
+	p256_felem_sqr(delta, a->Z);
+	p256_felem_sqr(gamma, a->Y);
+	p256_felem_mul(beta, a->X, gamma);
+
+	/* alpha = 3 * (X - delta) * (X + delta) */
+	p256_felem_sub(t0, a->X, delta);
+	p256_felem_add(t1, a->X, delta);
+	p256_felem_mul(alpha, t0, t1);
+	p256_felem_add(t0, alpha, alpha);
+	p256_felem_add(alpha, t0, alpha);
+
+	/* Z3 = (Y + Z)^2 - gamma - delta */
+	p256_felem_add(t0, a->Y, a->Z);
+	p256_felem_sqr(t0, t0);
+	p256_felem_sub(t0, t0, gamma);
+	p256_felem_sub(r->Z, t0, delta);
+
+	/* X3 = alpha^2 - 8 * beta */
+	p256_felem_add(beta, beta, beta);
+	p256_felem_add(beta, beta, beta);	/* 4 * beta */
+	p256_felem_sqr(t0, alpha);
+	p256_felem_add(t1, beta, beta);
+	p256_felem_sub(r->X, t0, t1);
+
+	/* Y3 = alpha * (4 * beta - X3) - 8 * gamma^2 */
+	p256_felem_sub(t0, beta, r->X);
+	p256_felem_mul(t0, alpha, t0);
+	p256_felem_sqr(gamma, gamma);
+	p256_felem_add(gamma, gamma, gamma);
+	p256_felem_add(gamma, gamma, gamma);
+	p256_felem_add(gamma, gamma, gamma);
+	p256_felem_sub(r->Y, t0, gamma);
+}
+
+/*
+ * Point addition in Jacobian coordinates ("add-2007-bl"). If mixed is
+ * non-zero, b is taken to be affine (Z = 1) and b->Z is ignored, with
+ * b_is_inf indicating whether b is the point at infinity instead.
+ *
+ * The formula does not work for adding a point to itself, so this returns
+ * all ones if a and b are the same finite point, in which case r is not
+ * their sum. The scalar multiplications below never get there: with the
+ * scalar below the group order, the multiple of the base point in r and
+ * the one that is added have no bits in common and sum to at most the
+ * scalar, so they can neither be equal nor add up to the order.
+ */
+static uint64_t
+p256_point_add(p256_point *r, const p256_point *a, const p256_point *b,
+    int mixed, uint64_t b_is_inf)
+{
+	p256_felem z1z1, z2z2, u1, u2, s1, s2, h, rr, hh, hhh, v, t;
+	p256_point out;
+	uint64_t a_is_inf, is_dbl;
+
+	a_is_inf = p256_felem_is_zero(a->Z);
+	if (!mixed)
+		b_is_inf = p256_felem_is_zero(b->Z);
+
+	p256_felem_sqr(z1z1, a->Z);
+	if (!mixed) {
+		p256_felem_sqr(z2z2, b->Z);
+		p256_felem_mul(u1, a->X, z2z2);
+		p256_felem_mul(s1, b->Z, z2z2);
+		p256_felem_mul(s1, a->Y, s1);
+	} else {
+		memcpy(u1, a->X, sizeof(u1));
+		memcpy(s1, a->Y, sizeof(s1));
+	}
+	p256_felem_mul(u2, b->X, z1z1);
+	p256_felem_mul(s2, a->Z, z1z1);
+	p256_felem_mul(s2, b->Y, s2);
+
+	p256_felem_sub(h, u2, u1);
+	p256_felem_sub(rr, s2, s1);
+
+	is_dbl = p256_felem_is_zero(h) & p256_felem_is_zero(rr) &
+	    ~a_is_inf & ~b_is_inf;
+
+	p256_felem_sqr(hh, h);
+	p256_felem_mul(hhh, h, hh);
+	p256_felem_mul(v, u1, hh);
+
+	/* X3 = r^2 - HHH - 2 * V */
+	p256_felem_sqr(t, rr);
+	p256_felem_sub(t, t, hhh);
+	p256_felem_sub(t, t, v);
+	p256_felem_sub(out.X, t, v);
+
+	/* Y3 = r * (V - X3) - S1 * HHH */
+	p256_felem_sub(t, v, out.X);
+	p256_felem_mul(t, rr, t);
+	p256_felem_mul(s1, s1, hhh);
+	p256_felem_sub(out.Y, t, s1);
+
+	/* Z3 = Z1 * Z2 * H */
+	p256_felem_mul(out.Z, a->Z, h);
+	if (!mixed)
+		p256_felem_mul(out.Z, out.Z, b->Z);
+
+	/* If a is infinity the result is b, if b is infinity it is a. */
+	p256_felem_select(out.X, b->X, a_is_inf);
+	p256_felem_select(out.Y, b->Y, a_is_inf);
+	p256_felem_select(out.Z, mixed ? p256_one : b->Z, a_is_inf);
+	p256_felem_select(out.X, a->X, b_is_inf);
+	p256_felem_select(out.Y, a->Y, b_is_inf);
+	p256_felem_select(out.Z, a->Z, b_is_inf);
+
+	*r = out;
+
+	return is_dbl;
+}
+
+/* Returns all ones if a equals b, otherwise zero. */
+static inline uint64_t
+p256_ct_eq(uint64_t a, uint64_t b)
+{
+	uint64_t t = a ^ b;
+
+	return ((t | (0 - t)) >> 63) - 1;
+}
+
+/*
+ * Select entry idx (1..15) of a comb table as an affine point, reading every
+ * entry. Returns all ones if idx is zero, i.e. the point is at infinity.
+ */
+static uint64_t
+p256_select_affine(p256_point *r, const uint64_t table[15][2][4], uint64_t idx)
+{
+	uint64_t mask;
+	int i, j;
+
+	memset(r, 0, sizeof(*r));
+	for (i = 0; i < 15; i++) {
+		mask = p256_ct_eq(idx, i + 1);
+		for (j = 0; j < 4; j++) {
+			r->X[j] |= table[i][0][j] & mask;
+			r->Y[j] |= table[i][1][j] & mask;
+		}
+	}
+
+	return p256_ct_eq(idx, 0);
+}
+
+static void
+p256_select_point(p256_point *r, const p256_point table[16], uint64_t idx)
+{
+	uint64_t mask;
+	int i, j;
+
+	memset(r, 0, sizeof(*r));
+	for (i = 0; i < 16; i++) {
+		mask = p256_ct_eq(idx, i);
+		for (j = 0; j < 4; j++) {
+			r->X[j] |= table[i].X[j] & mask;
+			r->Y[j] |= table[i].Y[j] & mask;
+			r->Z[j] |= table[i].Z[j] & mask;
+		}
+	}
+}
+
+static inline uint64_t
+p256_scalar_bit(const uint64_t k[4], int i)
+{
+	return (k[i >> 6] >> (i & 63)) & 1;
+}
+
+/* r = k * G, using the comb tables. */
+static void
+p256_mul_g(p256_point *r, const uint64_t k[4])
+{
+	p256_point t;
+	uint64_t idx, is_inf;
+	int i;
+
+	memset(r, 0, sizeof(*r));
+
+	for (i = 31; i >= 0; i--) {
+		if (i != 31)
+			p256_point_double(r, r);
+
+		idx = p256_scalar_bit(k, i) |
+		    p256_scalar_bit(k, i + 64) << 1 |
+		    p256_scalar_bit(k, i + 128) << 2 |
+		    p256_scalar_bit(k, i + 192) << 3;
+		is_inf = p256_select_affine(&t, p256_g_comb[0], idx);
+		p256_point_add(r, r, &t, 1, is_inf);
+
+		idx = p256_scalar_bit(k, i + 32) |
+		    p256_scalar_bit(k, i + 96) << 1 |
+		    p256_scalar_bit(k, i + 160) << 2 |
+		    p256_scalar_bit(k, i + 224) << 3;
+		is_inf = p256_select_affine(&t, p256_g_comb[1], idx);
+		p256_point_add(r, r, &t, 1, is_inf);
+	}
+
+	explicit_bzero(&t, sizeof(t));
+}
+
+/* r = k * a, using a fixed window of four bits. */
+static void
+p256_mul_point(p256_point *r, const uint64_t k[4], const p256_point *a)
+{
+	p256_point table[16], t;
+	uint64_t idx;
+	int i;
+
+	memset(&table[0], 0, sizeof(table[0]));
+	table[1] = *a;
+	p256_point_double(&table[2], a);
+	for (i = 3; i < 16; i++)
+		p256_point_add(&table[i], &table[i - 1], a, 0, 0);
+
+	idx = k[3] >> 60;
+	p256_select_point(r, table, idx);
+
+	for (i = 62; i >= 0; i--) {
+		p256_point_double(r, r);
+		p256_point_double(r, r);
+		p256_point_double(r, r);
+		p256_point_double(r, r);
+
+		idx = (k[i >> 4] >> ((i & 15) * 4)) & 0xf;
+		p256_select_point(&t, table, idx);
+		p256_point_add(r, r, &t, 0, 0);
+	}
+
+	explicit_bzero(table, sizeof(table));
+	explicit_bzero(&t, sizeof(t));
+}
+
+/*
+ * Load a field element or scalar from a non-negative BIGNUM of at most 256
+ * bits.
+ */
+static int
+p256_from_bn(uint64_t r[4], const BIGNUM *bn)
+{
+	int i;
+
+	if (BN_is_negative(bn) || BN_num_bits(bn) > 256)
+		return 0;
+
+	memset(r, 0, 4 * sizeof(r[0]));
+#if BN_BITS2 == 64
+	for (i = 0; i < bn->top && i < 4; i++)
+		r[i] = bn->d[i];
+#else
+	for (i = 0; i < bn->top && i < 8; i++)
+		r[i / 2] |= (uint64_t)bn->d[i] << ((i % 2) * 32);
+#endif
+
+	return 1;
+}
+
+static int
+p256_felem_from_bn(p256_felem r, const BIGNUM *bn)
+{
+	if (!p256_from_bn(r, bn))
+		return 0;
+
+	/* Any value below 2^256 is below 2p. */
+	p256_felem_reduce_once(r, r, 0);
+
+	return 1;
+}
+
+static int
+p256_felem_to_bn(BIGNUM *bn, const p256_felem a)
+{
+	int i;
+
+	if (bn_wexpand(bn, 256 / BN_BITS2) == NULL)
+		return 0;
+#if BN_BITS2 == 64
+	for (i = 0; i < 4; i++)
+		bn->d[i] = a[i];
+#else
+	for (i = 0; i < 8; i++)
+		bn->d[i] = (BN_ULONG)(a[i / 2] >> ((i % 2) * 32));
+#endif
+	bn->top = 256 / BN_BITS2;
+	bn->neg = 0;
+	bn_correct_top(bn);
+
+	return 1;
+}
+
+static int
+p256_point_from_ec_point(const EC_GROUP *group, p256_point *r,
+    const EC_POINT *point)
+{
+	if (ec_GFp_simple_is_at_infinity(group, point) > 0) {
+		memset(r, 0, sizeof(*r));
+		return 1;
+	}
+	if (!p256_felem_from_bn(r->X, &point->X))
+		return 0;
+	if (!p256_felem_from_bn(r->Y, &point->Y))
+		return 0;
+	if (!p256_felem_from_bn(r->Z, &point->Z))
+		return 0;
+
+	return 1;
+}
+
+/* Convert to affine coordinates and store the result in an EC_POINT. */
+static int
+p256_point_to_ec_point(const EC_GROUP *group, EC_POINT *r, const p256_point *a)
+{
+	p256_felem z_inv, z_inv2, x, y;
+
+	if (p256_felem_is_zero(a->Z) != 0)
+		return EC_POINT_set_to_infinity(group, r);
+
+	p256_felem_inv(z_inv, a->Z);
+	p256_felem_sqr(z_inv2, z_inv);
+	p256_felem_mul(x, a->X, z_inv2);
+	p256_felem_mul(z_inv2, z_inv2, z_inv);
+	p256_felem_mul(y, a->Y, z_inv2);
+
+	if (!p256_felem_to_bn(&r->X, x))
+		return 0;
+	if (!p256_felem_to_bn(&r->Y, y))
+		return 0;
+	if (!p256_felem_to_bn(&r->Z, p256_one))
+		return 0;
+	r->Z_is_one = 1;
+
+	return 1;
+}
+
+/*
+ * Load a scalar, reducing it modulo the group order. Values of up to 256
+ * bits are reduced by a single subtraction of n, selected by mask. Negative
+ * or larger ones are reduced as in the generic code, not in constant time.
+ */
+static int
+p256_scalar_from_bn(const EC_GROUP *group, uint64_t k[4], const BIGNUM *scalar,
+    BN_CTX *ctx)
+{
+	BIGNUM *t;
+	uint64_t borrow, mask, tk[4];
+	int i;
+	int ret = 0;
+
+	if (!BN_is_negative(scalar) && BN_num_bits(scalar) <= 256) {
+		if (!p256_from_bn(k, scalar))
+			return 0;
+
+		/* Any value below 2^256 is below 2n. */
+		borrow = 0;
+		for (i = 0; i < 4; i++)
+			tk[i] = p256_subb(k[i], p256_n[i], borrow, &borrow);
+		mask = 0 - borrow;
+		for (i = 0; i < 4; i++)
+			k[i] = (k[i] & mask) | (tk[i] & ~mask);
+		explicit_bzero(tk, sizeof(tk));
+
+		return 1;
+	}
+
+	BN_CTX_start(ctx);
+	if ((t = BN_CTX_get(ctx)) == NULL)
+		goto err;
+	if (!BN_nnmod(t, scalar, &group->order, ctx))
+		goto err;
+	ret = p256_from_bn(k, t);
+
+ err:
+	BN_CTX_end(ctx);
+
+	return ret;
+}
+
+/* Check that the group's generator is the one that the comb tables are for. */
+static int
+p256_generator_is_standard(const EC_GROUP *group)
+{
+	p256_felem x, y;
+
+	if (group->generator == NULL || !group->generator->Z_is_one)
+		return 0;
+	if (!p256_felem_from_bn(x, &group->generator->X) ||
+	    !p256_felem_from_bn(y, &group->generator->Y))
+		return 0;
+
+	return memcmp(x, p256_g_comb[0][0][0], sizeof(x)) == 0 &&
+	    memcmp(y, p256_g_comb[0][0][1], sizeof(y)) == 0;
+}
+
+static int
+ec_GFp_p256_group_set_curve(EC_GROUP *group, const BIGNUM *p, const BIGNUM *a,
+    const BIGNUM *b, BN_CTX *ctx)
+{
+	p256_felem fp, fa, fb, a_want;
+	uint64_t borrow;
+	int i;
+
+	/* This method only implements P-256, where a = -3. */
+	if (!p256_from_bn(fp, p) || !p256_from_bn(fa, a) ||
+	    !p256_from_bn(fb, b)) {
+		ECerror(EC_R_INVALID_FIELD);
+		return 0;
+	}
+	borrow = 0;
+	for (i = 0; i < 4; i++)
+		a_want[i] = p256_subb(p256_p[i], i == 0 ? 3 : 0, borrow,
+		    &borrow);
+	if (memcmp(fp, p256_p, sizeof(fp)) != 0 ||
+	    memcmp(fa, a_want, sizeof(fa)) != 0 ||
+	    memcmp(fb, p256_b, sizeof(fb)) != 0) {
+		ECerror(EC_R_INVALID_FIELD);
+		return 0;
+	}
+
+	return ec_GFp_mont_group_set_curve(group, p, a, b, ctx);
+}
+
+static int
+ec_GFp_p256_mul_generator_ct(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *scalar, BN_CTX *ctx)
+{
+	BN_CTX *new_ctx = NULL;
+	p256_point p;
+	uint64_t k[4];
+	int ret = 0;
+
+	if (!p256_generator_is_standard(group))
+		return ec_GFp_simple_mul_generator_ct(group, r, scalar, ctx);
+	if (r->meth != group->meth) {
+		ECerror(EC_R_INCOMPATIBLE_OBJECTS);
+		return 0;
+	}
+
+	if (ctx == NULL && (ctx = new_ctx = BN_CTX_new()) == NULL)
+		return 0;
+
+	if (!p256_scalar_from_bn(group, k, scalar, ctx))
+		goto err;
+
+	p256_mul_g(&p, k);
+	if (!p256_point_to_ec_point(group, r, &p))
+		goto err;
+
+	ret = 1;
+
+ err:
+	explicit_bzero(k, sizeof(k));
+	explicit_bzero(&p, sizeof(p));
+	BN_CTX_free(new_ctx);
+
+	return ret;
+}
+
+static int
+ec_GFp_p256_mul_single_ct(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *scalar, const EC_POINT *point, BN_CTX *ctx)
+{
+	BN_CTX *new_ctx = NULL;
+	p256_point a, p;
+	uint64_t k[4];
+	int ret = 0;
+
+	if (r->meth != group->meth || point->meth != group->meth) {
+		ECerror(EC_R_INCOMPATIBLE_OBJECTS);
+		return 0;
+	}
+
+	if (ctx == NULL && (ctx = new_ctx = BN_CTX_new()) == NULL)
+		return 0;
+
+	if (!p256_scalar_from_bn(group, k, scalar, ctx))
+		goto err;
+	if (!p256_point_from_ec_point(group, &a, point))
+		goto err;
+
+	p256_mul_point(&p, k, &a);
+	if (!p256_point_to_ec_point(group, r, &p))
+		goto err;
+
+	ret = 1;
+
+ err:
+	explicit_bzero(k, sizeof(k));
+	explicit_bzero(&p, sizeof(p));
+	BN_CTX_free(new_ctx);
+
+	return ret;
+}
+
+static int
+ec_GFp_p256_mul_double_nonct(const EC_GROUP *group, EC_POINT *r,
+    const BIGNUM *g_scalar, const BIGNUM *p_scalar, const EC_POINT *point,
+    BN_CTX *ctx)
+{
+	BN_CTX *new_ctx = NULL;
+	p256_point a, p, q;
+	uint64_t g_k[4], p_k[4];
+	int ret = 0;
+
+	if (!p256_generator_is_standard(group))
+		return ec_GFp_simple_mul_double_nonct(group, r, g_scalar,
+		    p_scalar, point, ctx);
+	if (r->meth != group->meth || point->meth != group->meth) {
+		ECerror(EC_R_INCOMPATIBLE_OBJECTS);
+		return 0;
+	}
+
+	if (ctx == NULL && (ctx = new_ctx = BN_CTX_new()) == NULL)
+		return 0;
+
+	if (!p256_scalar_from_bn(group, g_k, g_scalar, ctx))
+		goto err;
+	if (!p256_scalar_from_bn(group, p_k, p_scalar, ctx))
+		goto err;
+	if (!p256_point_from_ec_point(group, &a, point))
+		goto err;
+
+	p256_mul_g(&p, g_k);
+	p256_mul_point(&q, p_k, &a);
+	/* The two halves are public here and may well be the same point. */
+	if (p256_point_add(&p, &p, &q, 0, 0) != 0)
+		p256_point_double(&p, &q);
+	if (!p256_point_to_ec_point(group, r, &p))
+		goto err;
+
+	ret = 1;
+
+ err:
+	BN_CTX_free(new_ctx);
+
+	return ret;
+}
+
+const EC_METHOD *
+EC_GFp_p256_method(void)
+{
+	static const EC_METHOD ret = {
+		.flags = EC_FLAGS_DEFAULT_OCT,
+		.field_type = NID_X9_62_prime_field,
+		.group_init = ec_GFp_mont_group_init,
+		.group_finish = ec_GFp_mont_group_finish,
+		.group_clear_finish = ec_GFp_mont_group_clear_finish,
+		.group_copy = ec_GFp_mont_group_copy,
+		.group_set_curve = ec_GFp_p256_group_set_curve,
+		.group_get_curve = ec_GFp_simple_group_get_curve,
+		.group_get_degree = ec_GFp_simple_group_get_degree,
+		.group_check_discriminant =
+		ec_GFp_simple_group_check_discriminant,
+		.point_init = ec_GFp_simple_point_init,
+		.point_finish = ec_GFp_simple_point_finish,
+		.point_clear_finish = ec_GFp_simple_point_clear_finish,
+		.point_copy = ec_GFp_simple_point_copy,
+		.point_set_to_infinity = ec_GFp_simple_point_set_to_infinity,
+		.point_set_Jprojective_coordinates_GFp =
+		ec_GFp_simple_set_Jprojective_coordinates_GFp,
+		.point_get_Jprojective_coordinates_GFp =
+		ec_GFp_simple_get_Jprojective_coordinates_GFp,
+		.point_set_affine_coordinates =
+		ec_GFp_simple_point_set_affine_coordinates,
+		.point_get_affine_coordinates =
+		ec_GFp_simple_point_get_affine_coordinates,
+		.add = ec_GFp_simple_add,
+		.dbl = ec_GFp_simple_dbl,
+		.invert = ec_GFp_simple_invert,
+		.is_at_infinity = ec_GFp_simple_is_at_infinity,
+		.is_on_curve = ec_GFp_simple_is_on_curve,
+		.point_cmp = ec_GFp_simple_cmp,
+		.make_affine = ec_GFp_simple_make_affine,
+		.points_make_affine = ec_GFp_simple_points_make_affine,
+		.mul_generator_ct = ec_GFp_p256_mul_generator_ct,
+		.mul_single_ct = ec_GFp_p256_mul_single_ct,
+		.mul_double_nonct = ec_GFp_p256_mul_double_nonct,
+		.field_mul = ec_GFp_mont_field_mul,
+		.field_sqr = ec_GFp_mont_field_sqr,
+		.field_encode = ec_GFp_mont_field_encode,
+		.field_decode = ec_GFp_mont_field_decode,
+		.field_set_to_one = ec_GFp_mont_field_set_to_one,
+		.blind_coordinates = ec_GFp_simple_blind_coordinates,
+	};
+
+	return &ret;
+}
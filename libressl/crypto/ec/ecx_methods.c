@@ -0,0 +1,598 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/curve25519.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include "asn1_locl.h"
+#include "curve25519_internal.h"
+#include "evp_locl.h"
+
+/*
+ * EVP_PKEY_ASN1_METHOD and EVP_PKEY_METHOD for Ed25519 (RFC 8410). Keys
+ * are encoded without algorithm parameters, the private key being the
+ * 32 byte seed wrapped in an OCTET STRING.
+ */
+
+#define ED25519_BITS		253
+
+static struct ecx_key_st *
+ecx_key_new(int nid)
+{
+	struct ecx_key_st *ecx_key;
+
+	if ((ecx_key = calloc(1, sizeof(*ecx_key))) == NULL)
+		return NULL;
+
+	ecx_key->nid = nid;
+	ecx_key->key_len = ED25519_PUBLIC_KEY_LENGTH;
+
+	return ecx_key;
+}
+
+static void
+ecx_key_free(struct ecx_key_st *ecx_key)
+{
+	if (ecx_key == NULL)
+		return;
+
+	freezero(ecx_key->priv_key, ecx_key->priv_key_len);
+	freezero(ecx_key, sizeof(*ecx_key));
+}
+
+static int
+ecx_key_set_pub(struct ecx_key_st *ecx_key, const uint8_t *pub, size_t len)
+{
+	if (len != ED25519_PUBLIC_KEY_LENGTH)
+		return 0;
+
+	memcpy(ecx_key->pub_key, pub, len);
+	ecx_key->pub_key_len = len;
+
+	return 1;
+}
+
+static int
+ecx_key_set_priv(struct ecx_key_st *ecx_key, const uint8_t *priv, size_t len)
+{
+	if (len != ED25519_PRIVATE_KEY_LENGTH)
+		return 0;
+
+	freezero(ecx_key->priv_key, ecx_key->priv_key_len);
+	ecx_key->priv_key_len = 0;
+	if ((ecx_key->priv_key = malloc(len)) == NULL)
+		return 0;
+	memcpy(ecx_key->priv_key, priv, len);
+	ecx_key->priv_key_len = len;
+
+	ED25519_public_from_private(ecx_key->pub_key, ecx_key->priv_key);
+	ecx_key->pub_key_len = ED25519_PUBLIC_KEY_LENGTH;
+
+	return 1;
+}
+
+static int
+ecx_pub_decode(EVP_PKEY *pkey, X509_PUBKEY *pubkey)
+{
+	struct ecx_key_st *ecx_key = NULL;
+	const unsigned char *p;
+	X509_ALGOR *algor;
+	int len, ptype;
+
+	if (!X509_PUBKEY_get0_param(NULL, &p, &len, &algor, pubkey))
+		return 0;
+
+	X509_ALGOR_get0(NULL, &ptype, NULL, algor);
+	if (ptype != V_ASN1_UNDEF) {
+		ECerror(EC_R_INVALID_ENCODING);
+		return 0;
+	}
+
+	if ((ecx_key = ecx_key_new(pkey->ameth->pkey_id)) == NULL)
+		goto err;
+	if (len < 0 || !ecx_key_set_pub(ecx_key, p, len)) {
+		ECerror(EC_R_INVALID_ENCODING);
+		goto err;
+	}
+	if (!EVP_PKEY_assign(pkey, pkey->ameth->pkey_id, ecx_key))
+		goto err;
+
+	return 1;
+
+ err:
+	ecx_key_free(ecx_key);
+
+	return 0;
+}
+
+static int
+ecx_pub_encode(X509_PUBKEY *pubkey, const EVP_PKEY *pkey)
+{
+	const struct ecx_key_st *ecx_key = pkey->pkey.ecx;
+	unsigned char *pub = NULL;
+
+	if (ecx_key == NULL || ecx_key->pub_key_len == 0) {
+		ECerror(EC_R_KEYS_NOT_SET);
+		return 0;
+	}
+
+	if ((pub = malloc(ecx_key->pub_key_len)) == NULL) {
+		ECerror(ERR_R_MALLOC_FAILURE);
+		return 0;
+	}
+	memcpy(pub, ecx_key->pub_key, ecx_key->pub_key_len);
+
+	if (!X509_PUBKEY_set0_param(pubkey, OBJ_nid2obj(pkey->ameth->pkey_id),
+	    V_ASN1_UNDEF, NULL, pub, ecx_key->pub_key_len)) {
+		free(pub);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+ecx_pub_cmp(const EVP_PKEY *pkey1, const EVP_PKEY *pkey2)
+{
+	const struct ecx_key_st *a = pkey1->pkey.ecx, *b = pkey2->pkey.ecx;
+
+	if (a == NULL || b == NULL)
+		return -2;
+	if (a->pub_key_len != b->pub_key_len)
+		return 0;
+
+	return timingsafe_memcmp(a->pub_key, b->pub_key, a->pub_key_len) == 0;
+}
+
+static int
+ecx_buf_print(BIO *bio, const uint8_t *buf, size_t len, int indent)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (i % 15 == 0) {
+			if (i != 0 && BIO_printf(bio, "\n") <= 0)
+				return 0;
+			if (!BIO_indent(bio, indent + 4, 128))
+				return 0;
+		}
+		if (BIO_printf(bio, "%02x%s", buf[i],
+		    i + 1 == len ? "" : ":") <= 0)
+			return 0;
+	}
+	if (BIO_printf(bio, "\n") <= 0)
+		return 0;
+
+	return 1;
+}
+
+static int
+ecx_pub_print(BIO *bio, const EVP_PKEY *pkey, int indent, ASN1_PCTX *ctx)
+{
+	const struct ecx_key_st *ecx_key = pkey->pkey.ecx;
+
+	if (!BIO_indent(bio, indent, 128))
+		return 0;
+	if (ecx_key == NULL || ecx_key->pub_key_len == 0)
+		return BIO_printf(bio, "%s <INVALID PUBLIC KEY>\n",
+		    OBJ_nid2ln(pkey->ameth->pkey_id)) > 0;
+	if (BIO_printf(bio, "%s Public-Key:\n",
+	    OBJ_nid2ln(pkey->ameth->pkey_id)) <= 0)
+		return 0;
+	if (!BIO_indent(bio, indent, 128))
+		return 0;
+	if (BIO_printf(bio, "pub:\n") <= 0)
+		return 0;
+
+	return ecx_buf_print(bio, ecx_key->pub_key, ecx_key->pub_key_len,
+	    indent);
+}
+
+static int
+ecx_priv_decode(EVP_PKEY *pkey, const PKCS8_PRIV_KEY_INFO *p8pki)
+{
+	struct ecx_key_st *ecx_key = NULL;
+	ASN1_OCTET_STRING *aos = NULL;
+	const X509_ALGOR *algor;
+	const unsigned char *p;
+	int len, ptype;
+
+	if (!PKCS8_pkey_get0(NULL, &p, &len, &algor, p8pki))
+		return 0;
+	if ((aos = d2i_ASN1_OCTET_STRING(NULL, &p, len)) == NULL) {
+		ECerror(EC_R_INVALID_ENCODING);
+		return 0;
+	}
+
+	X509_ALGOR_get0(NULL, &ptype, NULL, algor);
+	if (ptype != V_ASN1_UNDEF) {
+		ECerror(EC_R_INVALID_ENCODING);
+		goto err;
+	}
+
+	if ((ecx_key = ecx_key_new(pkey->ameth->pkey_id)) == NULL)
+		goto err;
+	if (!ecx_key_set_priv(ecx_key, ASN1_STRING_data(aos),
+	    ASN1_STRING_length(aos))) {
+		ECerror(EC_R_INVALID_PRIVATE_KEY);
+		goto err;
+	}
+	if (!EVP_PKEY_assign(pkey, pkey->ameth->pkey_id, ecx_key))
+		goto err;
+	ecx_key = NULL;
+
+	ASN1_OCTET_STRING_free(aos);
+
+	return 1;
+
+ err:
+	ecx_key_free(ecx_key);
+	ASN1_OCTET_STRING_free(aos);
+
+	return 0;
+}
+
+static int
+ecx_priv_encode(PKCS8_PRIV_KEY_INFO *p8pki, const EVP_PKEY *pkey)
+{
+	const struct ecx_key_st *ecx_key = pkey->pkey.ecx;
+	ASN1_OCTET_STRING aos;
+	unsigned char *der = NULL;
+	int der_len;
+
+	if (ecx_key == NULL || ecx_key->priv_key == NULL) {
+		ECerror(EC_R_MISSING_PRIVATE_KEY);
+		return 0;
+	}
+
+	memset(&aos, 0, sizeof(aos));
+	aos.type = V_ASN1_OCTET_STRING;
+	aos.data = ecx_key->priv_key;
+	aos.length = ecx_key->priv_key_len;
+
+	if ((der_len = i2d_ASN1_OCTET_STRING(&aos, &der)) <= 0) {
+		ECerror(ERR_R_MALLOC_FAILURE);
+		return 0;
+	}
+
+	if (!PKCS8_pkey_set0(p8pki, OBJ_nid2obj(pkey->ameth->pkey_id), 0,
+	    V_ASN1_UNDEF, NULL, der, der_len)) {
+		freezero(der, der_len);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+ecx_priv_print(BIO *bio, const EVP_PKEY *pkey, int indent, ASN1_PCTX *ctx)
+{
+	const struct ecx_key_st *ecx_key = pkey->pkey.ecx;
+
+	if (!BIO_indent(bio, indent, 128))
+		return 0;
+	if (ecx_key == NULL || ecx_key->priv_key == NULL)
+		return BIO_printf(bio, "%s <INVALID PRIVATE KEY>\n",
+		    OBJ_nid2ln(pkey->ameth->pkey_id)) > 0;
+	if (BIO_printf(bio, "%s Private-Key:\n",
+	    OBJ_nid2ln(pkey->ameth->pkey_id)) <= 0)
+		return 0;
+	if (!BIO_indent(bio, indent, 128))
+		return 0;
+	if (BIO_printf(bio, "priv:\n") <= 0)
+		return 0;
+	if (!ecx_buf_print(bio, ecx_key->priv_key, ecx_key->priv_key_len,
+	    indent))
+		return 0;
+	if (!BIO_indent(bio, indent, 128))
+		return 0;
+	if (BIO_printf(bio, "pub:\n") <= 0)
+		return 0;
+
+	return ecx_buf_print(bio, ecx_key->pub_key, ecx_key->pub_key_len,
+	    indent);
+}
+
+static int
+ecx_sig_size(const EVP_PKEY *pkey)
+{
+	return ED25519_SIGNATURE_LENGTH;
+}
+
+static int
+ecx_bits(const EVP_PKEY *pkey)
+{
+	return ED25519_BITS;
+}
+
+static void
+ecx_free(EVP_PKEY *pkey)
+{
+	ecx_key_free(pkey->pkey.ecx);
+}
+
+static int
+ecx_ctrl(EVP_PKEY *pkey, int op, long arg1, void *arg2)
+{
+	switch (op) {
+	case ASN1_PKEY_CTRL_DEFAULT_MD_NID:
+		/* Ed25519 hashes the message itself. */
+		*(int *)arg2 = NID_undef;
+		return 2;
+	}
+
+	return -2;
+}
+
+static int
+ecx_item_verify(EVP_MD_CTX *md_ctx, const ASN1_ITEM *it, void *asn,
+    X509_ALGOR *algor, ASN1_BIT_STRING *abs, EVP_PKEY *pkey)
+{
+	const ASN1_OBJECT *aobj;
+	int nid, param_type;
+
+	X509_ALGOR_get0(&aobj, &param_type, NULL, algor);
+
+	if ((nid = OBJ_obj2nid(aobj)) != NID_Ed25519 ||
+	    param_type != V_ASN1_UNDEF) {
+		ECerror(EC_R_INVALID_ENCODING);
+		return 0;
+	}
+
+	if (!EVP_DigestVerifyInit(md_ctx, NULL, NULL, NULL, pkey))
+		return 0;
+
+	return 2;
+}
+
+static int
+ecx_item_sign(EVP_MD_CTX *md_ctx, const ASN1_ITEM *it, void *asn,
+    X509_ALGOR *algor1, X509_ALGOR *algor2, ASN1_BIT_STRING *abs)
+{
+	if (algor1 != NULL &&
+	    !X509_ALGOR_set0(algor1, OBJ_nid2obj(NID_Ed25519), V_ASN1_UNDEF,
+	    NULL))
+		return 0;
+	if (algor2 != NULL &&
+	    !X509_ALGOR_set0(algor2, OBJ_nid2obj(NID_Ed25519), V_ASN1_UNDEF,
+	    NULL))
+		return 0;
+
+	/* Tell ASN1_item_sign_ctx() that identifiers are set and it needs to sign. */
+	return 3;
+}
+
+static int
+ecx_set_priv_key(EVP_PKEY *pkey, const unsigned char *priv, size_t len)
+{
+	struct ecx_key_st *ecx_key;
+
+	if ((ecx_key = ecx_key_new(pkey->ameth->pkey_id)) == NULL)
+		return 0;
+	if (!ecx_key_set_priv(ecx_key, priv, len) ||
+	    !EVP_PKEY_assign(pkey, pkey->ameth->pkey_id, ecx_key)) {
+		ecx_key_free(ecx_key);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+ecx_set_pub_key(EVP_PKEY *pkey, const unsigned char *pub, size_t len)
+{
+	struct ecx_key_st *ecx_key;
+
+	if ((ecx_key = ecx_key_new(pkey->ameth->pkey_id)) == NULL)
+		return 0;
+	if (!ecx_key_set_pub(ecx_key, pub, len) ||
+	    !EVP_PKEY_assign(pkey, pkey->ameth->pkey_id, ecx_key)) {
+		ecx_key_free(ecx_key);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+ecx_get_priv_key(const EVP_PKEY *pkey, unsigned char *out_priv,
+    size_t *out_len)
+{
+	const struct ecx_key_st *ecx_key = pkey->pkey.ecx;
+
+	if (ecx_key == NULL || ecx_key->priv_key == NULL) {
+		ECerror(EC_R_MISSING_PRIVATE_KEY);
+		return 0;
+	}
+
+	if (out_priv == NULL) {
+		*out_len = ecx_key->priv_key_len;
+		return 1;
+	}
+	if (*out_len < ecx_key->priv_key_len) {
+		ECerror(EC_R_BUFFER_TOO_SMALL);
+		return 0;
+	}
+
+	memcpy(out_priv, ecx_key->priv_key, ecx_key->priv_key_len);
+	*out_len = ecx_key->priv_key_len;
+
+	return 1;
+}
+
+static int
+ecx_get_pub_key(const EVP_PKEY *pkey, unsigned char *out_pub,
+    size_t *out_len)
+{
+	const struct ecx_key_st *ecx_key = pkey->pkey.ecx;
+
+	if (ecx_key == NULL || ecx_key->pub_key_len == 0) {
+		ECerror(EC_R_KEYS_NOT_SET);
+		return 0;
+	}
+
+	if (out_pub == NULL) {
+		*out_len = ecx_key->pub_key_len;
+		return 1;
+	}
+	if (*out_len < ecx_key->pub_key_len) {
+		ECerror(EC_R_BUFFER_TOO_SMALL);
+		return 0;
+	}
+
+	memcpy(out_pub, ecx_key->pub_key, ecx_key->pub_key_len);
+	*out_len = ecx_key->pub_key_len;
+
+	return 1;
+}
+
+static int
+pkey_ecx_keygen(EVP_PKEY_CTX *pkey_ctx, EVP_PKEY *pkey)
+{
+	struct ecx_key_st *ecx_key;
+	uint8_t pub[ED25519_PUBLIC_KEY_LENGTH];
+	uint8_t priv[ED25519_PRIVATE_KEY_LENGTH];
+	int ret = 0;
+
+	if ((ecx_key = ecx_key_new(pkey_ctx->pmeth->pkey_id)) == NULL)
+		goto err;
+
+	ED25519_keypair(pub, priv);
+	if (!ecx_key_set_priv(ecx_key, priv, sizeof(priv)))
+		goto err;
+	if (!EVP_PKEY_assign(pkey, pkey_ctx->pmeth->pkey_id, ecx_key))
+		goto err;
+	ecx_key = NULL;
+
+	ret = 1;
+
+ err:
+	ecx_key_free(ecx_key);
+	explicit_bzero(priv, sizeof(priv));
+
+	return ret;
+}
+
+static int
+pkey_ecx_digestsign(EVP_MD_CTX *md_ctx, unsigned char *out_sig,
+    size_t *out_sig_len, const unsigned char *message, size_t message_len)
+{
+	const struct ecx_key_st *ecx_key = md_ctx->pctx->pkey->pkey.ecx;
+
+	if (out_sig == NULL) {
+		*out_sig_len = ED25519_SIGNATURE_LENGTH;
+		return 1;
+	}
+	if (*out_sig_len < ED25519_SIGNATURE_LENGTH) {
+		ECerror(EC_R_BUFFER_TOO_SMALL);
+		return 0;
+	}
+
+	if (ecx_key == NULL || ecx_key->priv_key == NULL) {
+		ECerror(EC_R_MISSING_PRIVATE_KEY);
+		return 0;
+	}
+
+	if (!ED25519_sign(out_sig, message, message_len, ecx_key->pub_key,
+	    ecx_key->priv_key))
+		return 0;
+
+	*out_sig_len = ED25519_SIGNATURE_LENGTH;
+
+	return 1;
+}
+
+static int
+pkey_ecx_digestverify(EVP_MD_CTX *md_ctx, const unsigned char *sig,
+    size_t sig_len, const unsigned char *message, size_t message_len)
+{
+	const struct ecx_key_st *ecx_key = md_ctx->pctx->pkey->pkey.ecx;
+
+	if (ecx_key == NULL || ecx_key->pub_key_len == 0) {
+		ECerror(EC_R_KEYS_NOT_SET);
+		return -1;
+	}
+	if (sig_len != ED25519_SIGNATURE_LENGTH)
+		return 0;
+
+	return ED25519_verify(message, message_len, sig, ecx_key->pub_key);
+}
+
+static int
+pkey_ecx_ctrl(EVP_PKEY_CTX *pkey_ctx, int op, int arg1, void *arg2)
+{
+	switch (op) {
+	case EVP_PKEY_CTRL_MD:
+		/* Only one-shot signing without a digest is supported. */
+		if (arg2 != NULL) {
+			ECerror(EC_R_INVALID_DIGEST_TYPE);
+			return 0;
+		}
+		return 1;
+
+	case EVP_PKEY_CTRL_DIGESTINIT:
+		return 1;
+	}
+
+	return -2;
+}
+
+const EVP_PKEY_ASN1_METHOD ed25519_asn1_meth = {
+	.pkey_id = EVP_PKEY_ED25519,
+	.pkey_base_id = EVP_PKEY_ED25519,
+
+	.pem_str = "ED25519",
+	.info = "OpenSSL ED25519 algorithm",
+
+	.pub_decode = ecx_pub_decode,
+	.pub_encode = ecx_pub_encode,
+	.pub_cmp = ecx_pub_cmp,
+	.pub_print = ecx_pub_print,
+
+	.priv_decode = ecx_priv_decode,
+	.priv_encode = ecx_priv_encode,
+	.priv_print = ecx_priv_print,
+
+	.pkey_size = ecx_sig_size,
+	.pkey_bits = ecx_bits,
+
+	.pkey_free = ecx_free,
+	.pkey_ctrl = ecx_ctrl,
+
+	.item_verify = ecx_item_verify,
+	.item_sign = ecx_item_sign,
+
+	.set_priv_key = ecx_set_priv_key,
+	.set_pub_key = ecx_set_pub_key,
+	.get_priv_key = ecx_get_priv_key,
+	.get_pub_key = ecx_get_pub_key,
+};
+
+const EVP_PKEY_METHOD ed25519_pkey_meth = {
+	.pkey_id = EVP_PKEY_ED25519,
+
+	.keygen = pkey_ecx_keygen,
+
+	.ctrl = pkey_ecx_ctrl,
+
+	.digestsign = pkey_ecx_digestsign,
+	.digestverify = pkey_ecx_digestverify,
+};
@@ -86,6 +86,9 @@ int ossl_ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in, BIGNUM **kinvp,
 int ossl_ecdsa_sign(int type, const unsigned char *dgst, int dlen,
     unsigned char *sig, unsigned int *siglen, const BIGNUM *kinv,
     const BIGNUM *r, EC_KEY *eckey);
+void ossl_ecdsa_verify_batch(const unsigned char *const *dgsts,
+    const int *dgst_lens, const ECDSA_SIG *const *sigs,
+    EC_KEY *const *eckeys, int *results, size_t num);
 ECDSA_SIG *ossl_ecdsa_sign_sig(const unsigned char *dgst, int dgst_len,
     const BIGNUM *in_kinv, const BIGNUM *in_r, EC_KEY *eckey);
 
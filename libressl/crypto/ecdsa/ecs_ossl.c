@@ -65,6 +65,7 @@
 #include <openssl/bn.h>
 
 #include "bn_lcl.h"
+#include "ec_lcl.h"
 #include "ecs_locl.h"
 
 static int ecdsa_prepare_digest(const unsigned char *dgst, int dgst_len,
@@ -564,3 +565,245 @@ ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
 		return 0;
 	return ecdsa->meth->ecdsa_do_verify(dgst, dgst_len, sig, eckey);
 }
+
+/*
+ * Verify the signatures with indices idx[0..num-1], whose keys all use the
+ * built-in implementation on curves equal to group. The s values are all
+ * inverted with a single inversion of their product, and the resulting
+ * points are made affine together by EC_POINTs_make_affine(), which does
+ * the same for their Z coordinates.
+ */
+static void
+ecdsa_verify_batch_group(const EC_GROUP *group, const size_t *idx, size_t num,
+    const unsigned char *const *dgsts, const int *dgst_lens,
+    const ECDSA_SIG *const *sigs, EC_KEY *const *eckeys, int *results,
+    BN_CTX *ctx)
+{
+	BIGNUM **prod = NULL;
+	EC_POINT **points = NULL;
+	size_t *valid = NULL;
+	BIGNUM *order, *inv, *w, *m, *u1, *u2, *X;
+	const ECDSA_SIG *sig;
+	size_t i, j, nvalid = 0;
+
+	BN_CTX_start(ctx);
+	order = BN_CTX_get(ctx);
+	inv = BN_CTX_get(ctx);
+	w = BN_CTX_get(ctx);
+	m = BN_CTX_get(ctx);
+	u1 = BN_CTX_get(ctx);
+	u2 = BN_CTX_get(ctx);
+	X = BN_CTX_get(ctx);
+	if (X == NULL) {
+		ECDSAerror(ERR_R_BN_LIB);
+		goto err;
+	}
+
+	if (!EC_GROUP_get_order(group, order, ctx)) {
+		ECDSAerror(ERR_R_EC_LIB);
+		goto err;
+	}
+
+	if ((prod = calloc(num, sizeof(*prod))) == NULL ||
+	    (points = calloc(num, sizeof(*points))) == NULL ||
+	    (valid = reallocarray(NULL, num, sizeof(*valid))) == NULL) {
+		ECDSAerror(ERR_R_MALLOC_FAILURE);
+		goto err;
+	}
+
+	/* prod[k] = s_0 * ... * s_k over the signatures with r, s in range. */
+	for (i = 0; i < num; i++) {
+		sig = sigs[idx[i]];
+		if (BN_is_zero(sig->r) || BN_is_negative(sig->r) ||
+		    BN_ucmp(sig->r, order) >= 0 ||
+		    BN_is_zero(sig->s) || BN_is_negative(sig->s) ||
+		    BN_ucmp(sig->s, order) >= 0) {
+			results[idx[i]] = 0;
+			continue;
+		}
+		if ((prod[nvalid] = BN_new()) == NULL) {
+			ECDSAerror(ERR_R_MALLOC_FAILURE);
+			goto err;
+		}
+		if (nvalid == 0) {
+			if (!BN_copy(prod[nvalid], sig->s)) {
+				ECDSAerror(ERR_R_BN_LIB);
+				goto err;
+			}
+		} else if (!BN_mod_mul(prod[nvalid], prod[nvalid - 1], sig->s,
+		    order, ctx)) {
+			ECDSAerror(ERR_R_BN_LIB);
+			goto err;
+		}
+		valid[nvalid++] = idx[i];
+	}
+	if (nvalid == 0)
+		goto err;
+
+	if (!BN_mod_inverse_ct(inv, prod[nvalid - 1], order, ctx)) {
+		ECDSAerror(ERR_R_BN_LIB);
+		goto err;
+	}
+
+	/*
+	 * Walking backwards, inv = inv(s_0 * ... * s_j), so that
+	 * w = inv(s_j) = inv * prod[j - 1], after which multiplying inv by s_j
+	 * leaves it ready for the next signature.
+	 */
+	for (j = nvalid; j-- > 0;) {
+		i = valid[j];
+		sig = sigs[i];
+		if (j > 0) {
+			if (!BN_mod_mul(w, inv, prod[j - 1], order, ctx)) {
+				ECDSAerror(ERR_R_BN_LIB);
+				goto err;
+			}
+			if (!BN_mod_mul(inv, inv, sig->s, order, ctx)) {
+				ECDSAerror(ERR_R_BN_LIB);
+				goto err;
+			}
+		} else if (!BN_copy(w, inv)) {
+			ECDSAerror(ERR_R_BN_LIB);
+			goto err;
+		}
+
+		if (!ecdsa_prepare_digest(dgsts[i], dgst_lens[i], order, m))
+			goto err;
+		if (!BN_mod_mul(u1, m, w, order, ctx)) {	/* u1 = mw */
+			ECDSAerror(ERR_R_BN_LIB);
+			goto err;
+		}
+		if (!BN_mod_mul(u2, sig->r, w, order, ctx)) {	/* u2 = rw */
+			ECDSAerror(ERR_R_BN_LIB);
+			goto err;
+		}
+
+		if ((points[j] = EC_POINT_new(group)) == NULL) {
+			ECDSAerror(ERR_R_MALLOC_FAILURE);
+			goto err;
+		}
+		if (!EC_POINT_mul(group, points[j], u1,
+		    EC_KEY_get0_public_key(eckeys[i]), u2, ctx)) {
+			ECDSAerror(ERR_R_EC_LIB);
+			goto err;
+		}
+	}
+
+	if (!EC_POINTs_make_affine(group, nvalid, points, ctx)) {
+		ECDSAerror(ERR_R_EC_LIB);
+		goto err;
+	}
+
+	for (j = 0; j < nvalid; j++) {
+		i = valid[j];
+		if (EC_POINT_is_at_infinity(group, points[j])) {
+			results[i] = 0;
+			continue;
+		}
+		if (EC_METHOD_get_field_type(EC_GROUP_method_of(group)) ==
+		    NID_X9_62_prime_field) {
+			if (!EC_POINT_get_affine_coordinates_GFp(group,
+			    points[j], X, NULL, ctx)) {
+				ECDSAerror(ERR_R_EC_LIB);
+				goto err;
+			}
+		}
+#ifndef OPENSSL_NO_EC2M
+		else { /* NID_X9_62_characteristic_two_field */
+			if (!EC_POINT_get_affine_coordinates_GF2m(group,
+			    points[j], X, NULL, ctx)) {
+				ECDSAerror(ERR_R_EC_LIB);
+				goto err;
+			}
+		}
+#endif
+		if (!BN_nnmod(u1, X, order, ctx)) {
+			ECDSAerror(ERR_R_BN_LIB);
+			goto err;
+		}
+		results[i] = (BN_ucmp(u1, sigs[i]->r) == 0);
+	}
+
+ err:
+	for (j = 0; prod != NULL && j < nvalid; j++)
+		BN_free(prod[j]);
+	for (j = 0; points != NULL && j < nvalid; j++)
+		EC_POINT_free(points[j]);
+	free(prod);
+	free(points);
+	free(valid);
+	BN_CTX_end(ctx);
+}
+
+void
+ossl_ecdsa_verify_batch(const unsigned char *const *dgsts, const int *dgst_lens,
+    const ECDSA_SIG *const *sigs, EC_KEY *const *eckeys, int *results,
+    size_t num)
+{
+	BN_CTX *ctx = NULL;
+	const EC_GROUP *group, *g;
+	ECDSA_DATA *ecdsa;
+	unsigned char *done = NULL;
+	size_t *idx = NULL;
+	size_t i, j, n;
+
+	for (i = 0; i < num; i++)
+		results[i] = -1;
+	if (num == 0)
+		return;
+
+	if ((done = calloc(num, 1)) == NULL ||
+	    (idx = reallocarray(NULL, num, sizeof(*idx))) == NULL) {
+		ECDSAerror(ERR_R_MALLOC_FAILURE);
+		goto err;
+	}
+	if ((ctx = BN_CTX_new()) == NULL) {
+		ECDSAerror(ERR_R_MALLOC_FAILURE);
+		goto err;
+	}
+
+	/*
+	 * Keys with another method, or without the parameters that
+	 * ecdsa_do_verify() needs, are verified one at a time.
+	 */
+	for (i = 0; i < num; i++) {
+		if (eckeys[i] == NULL || EC_KEY_get0_group(eckeys[i]) == NULL ||
+		    EC_KEY_get0_public_key(eckeys[i]) == NULL ||
+		    sigs[i] == NULL) {
+			ECDSAerror(ECDSA_R_MISSING_PARAMETERS);
+			done[i] = 1;
+			continue;
+		}
+		if (eckeys[i]->meth->verify_sig != ossl_ecdsa_verify_sig ||
+		    (ecdsa = ecdsa_check(eckeys[i])) == NULL ||
+		    ecdsa->meth->ecdsa_do_verify != ecdsa_do_verify) {
+			results[i] = ECDSA_do_verify(dgsts[i], dgst_lens[i],
+			    sigs[i], eckeys[i]);
+			done[i] = 1;
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		if (done[i])
+			continue;
+		group = EC_KEY_get0_group(eckeys[i]);
+		for (n = 0, j = i; j < num; j++) {
+			if (done[j])
+				continue;
+			g = EC_KEY_get0_group(eckeys[j]);
+			if (g != group &&
+			    (EC_GROUP_method_of(g) != EC_GROUP_method_of(group) ||
+			    EC_GROUP_cmp(group, g, ctx) != 0))
+				continue;
+			idx[n++] = j;
+			done[j] = 1;
+		}
+		ecdsa_verify_batch_group(group, idx, n, dgsts, dgst_lens, sigs,
+		    eckeys, results, ctx);
+	}
+
+ err:
+	BN_CTX_free(ctx);
+	free(done);
+	free(idx);
+}
@@ -79,6 +79,22 @@ ECDSA_do_verify(const unsigned char *dgst, int dgst_len, const ECDSA_SIG *sig,
 	return 0;
 }
 
+int
+ECDSA_do_verify_batch(const unsigned char *const *dgsts, const int *dgst_lens,
+    const ECDSA_SIG *const *sigs, EC_KEY *const *eckeys, int *results,
+    size_t num)
+{
+	size_t i;
+
+	ossl_ecdsa_verify_batch(dgsts, dgst_lens, sigs, eckeys, results, num);
+
+	for (i = 0; i < num; i++) {
+		if (results[i] != 1)
+			return 0;
+	}
+	return 1;
+}
+
 /* returns
  *      1: correct signature
  *      0: incorrect signature
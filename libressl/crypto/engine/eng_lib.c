@@ -117,9 +117,12 @@ engine_free_util(ENGINE *e, int locked)
 
 	if (e == NULL)
 		return 1;
-	if (locked)
-		i = CRYPTO_add(&e->struct_ref, -1, CRYPTO_LOCK_ENGINE);
-	else
+	if (locked) {
+		/* See ENGINE_up_ref(). */
+		CRYPTO_w_lock(CRYPTO_LOCK_ENGINE);
+		i = --e->struct_ref;
+		CRYPTO_w_unlock(CRYPTO_LOCK_ENGINE);
+	} else
 		i = --e->struct_ref;
 	engine_ref_debug(e, 0, -1)
 	if (i > 0)
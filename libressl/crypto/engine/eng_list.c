@@ -382,6 +382,12 @@ ENGINE_up_ref(ENGINE *e)
 		ENGINEerror(ERR_R_PASSED_NULL_PARAMETER);
 		return 0;
 	}
-	refs = CRYPTO_add(&e->struct_ref, 1, CRYPTO_LOCK_ENGINE);
+	/*
+	 * The structural reference count is also updated directly while
+	 * holding CRYPTO_LOCK_ENGINE, so CRYPTO_add() cannot be used here.
+	 */
+	CRYPTO_w_lock(CRYPTO_LOCK_ENGINE);
+	refs = ++e->struct_ref;
+	CRYPTO_w_unlock(CRYPTO_LOCK_ENGINE);
 	return refs > 1 ? 1 : 0;
 }
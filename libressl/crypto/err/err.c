@@ -285,6 +285,16 @@ static int int_err_library_number = ERR_LIB_USER;
 
 static pthread_t err_init_thread;
 
+/*
+ * With the default implementation, each thread's error state is kept in
+ * thread-specific data rather than in int_thread_hash, so that putting,
+ * getting and clearing errors neither takes CRYPTO_LOCK_ERR nor performs a
+ * hash lookup. The state is freed when the thread exits.
+ */
+static pthread_once_t err_state_once = PTHREAD_ONCE_INIT;
+static pthread_key_t err_state_key;
+static int err_state_key_created;
+
 /* Internal function that checks whether "err_fns" is set and if not, sets it to
  * the defaults. */
 static void
@@ -299,6 +309,36 @@ err_fns_check(void)
 	CRYPTO_w_unlock(CRYPTO_LOCK_ERR);
 }
 
+static void
+err_state_key_destroy(void *arg)
+{
+	ERR_STATE_free(arg);
+}
+
+static void
+err_state_key_init(void)
+{
+	if (pthread_key_create(&err_state_key, err_state_key_destroy) == 0)
+		err_state_key_created = 1;
+}
+
+/*
+ * Returns 1 if the error state is kept in thread-specific data, or 0 if it
+ * has to be managed via the ERR_FNS functions, since an application replaced
+ * the implementation or no key could be created.
+ */
+static int
+err_state_thread_local(void)
+{
+	err_fns_check();
+	if (err_fns != &err_defaults)
+		return 0;
+
+	(void) pthread_once(&err_state_once, err_state_key_init);
+
+	return err_state_key_created;
+}
+
 /* API functions to get or set the underlying ERR functions. */
 
 const ERR_FNS *
@@ -1023,7 +1063,23 @@ ERR_reason_error_string(unsigned long e)
 void
 ERR_remove_thread_state(const CRYPTO_THREADID *id)
 {
-	ERR_STATE tmp;
+	CRYPTO_THREADID cur;
+	ERR_STATE *es, tmp;
+
+	if (err_state_thread_local()) {
+		/*
+		 * Only the current thread's state can be reached - that of any
+		 * other thread is freed once the thread exits.
+		 */
+		CRYPTO_THREADID_current(&cur);
+		if (id != NULL && CRYPTO_THREADID_cmp(id, &cur) != 0)
+			return;
+		if ((es = pthread_getspecific(err_state_key)) == NULL)
+			return;
+		(void) pthread_setspecific(err_state_key, NULL);
+		ERR_STATE_free(es);
+		return;
+	}
 
 	if (id)
 		CRYPTO_THREADID_cpy(&tmp.tid, id);
@@ -1043,31 +1099,54 @@ ERR_remove_state(unsigned long pid)
 }
 #endif
 
+static ERR_STATE *
+err_state_new(const CRYPTO_THREADID *tid)
+{
+	ERR_STATE *ret;
+	int i;
+
+	if ((ret = malloc(sizeof(ERR_STATE))) == NULL)
+		return NULL;
+	CRYPTO_THREADID_cpy(&ret->tid, tid);
+	ret->top = 0;
+	ret->bottom = 0;
+	for (i = 0; i < ERR_NUM_ERRORS; i++) {
+		ret->err_data[i] = NULL;
+		ret->err_data_flags[i] = 0;
+	}
+
+	return ret;
+}
+
 ERR_STATE *
 ERR_get_state(void)
 {
 	static ERR_STATE fallback;
 	ERR_STATE *ret, tmp, *tmpp = NULL;
-	int i;
 	CRYPTO_THREADID tid;
 
-	err_fns_check();
+	if (err_state_thread_local()) {
+		if ((ret = pthread_getspecific(err_state_key)) != NULL)
+			return ret;
+
+		CRYPTO_THREADID_current(&tid);
+		if ((ret = err_state_new(&tid)) == NULL)
+			return (&fallback);
+		if (pthread_setspecific(err_state_key, ret) != 0) {
+			ERR_STATE_free(ret);
+			return (&fallback);
+		}
+		return ret;
+	}
+
 	CRYPTO_THREADID_current(&tid);
 	CRYPTO_THREADID_cpy(&tmp.tid, &tid);
 	ret = ERRFN(thread_get_item)(&tmp);
 
 	/* ret == the error state, if NULL, make a new one */
 	if (ret == NULL) {
-		ret = malloc(sizeof(ERR_STATE));
-		if (ret == NULL)
+		if ((ret = err_state_new(&tid)) == NULL)
 			return (&fallback);
-		CRYPTO_THREADID_cpy(&ret->tid, &tid);
-		ret->top = 0;
-		ret->bottom = 0;
-		for (i = 0; i < ERR_NUM_ERRORS; i++) {
-			ret->err_data[i] = NULL;
-			ret->err_data_flags[i] = 0;
-		}
 		tmpp = ERRFN(thread_set_item)(ret);
 		/* To check if insertion failed, do a get. */
 		if (ERRFN(thread_get_item)(ret) != ret) {
@@ -1471,6 +1471,80 @@ aead_aes_gcm_seal(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
 	return 1;
 }
 
+static int
+aead_aes_gcm_sealv(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, const unsigned char *nonce,
+    size_t nonce_len, const EVP_AEAD_IOVEC *in, size_t in_cnt,
+    const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	const struct aead_aes_gcm_ctx *gcm_ctx = ctx->aead_state;
+	struct evp_aead_iov_cursor in_cur, out_cur;
+	unsigned char tag[EVP_AEAD_AES_GCM_TAG_LEN];
+	unsigned char *ip, *op;
+	size_t in_len, max_out_len;
+	size_t i, m, n;
+	GCM128_CONTEXT gcm;
+
+	if (!evp_aead_iov_len(in, in_cnt, &in_len) ||
+	    !evp_aead_iov_len(out, out_cnt, &max_out_len))
+		return 0;
+
+	if (max_out_len < in_len + gcm_ctx->tag_len) {
+		EVPerror(EVP_R_BUFFER_TOO_SMALL);
+		return 0;
+	}
+
+	memcpy(&gcm, &gcm_ctx->gcm, sizeof(gcm));
+
+	if (nonce_len == 0) {
+		EVPerror(EVP_R_INVALID_IV_LENGTH);
+		return 0;
+	}
+	CRYPTO_gcm128_setiv(&gcm, nonce, nonce_len);
+
+	for (i = 0; i < ad_cnt; i++) {
+		if (ad[i].len > 0 &&
+		    CRYPTO_gcm128_aad(&gcm, ad[i].data, ad[i].len))
+			return 0;
+	}
+
+	/*
+	 * Walk the input and output regions in step - GCM maintains partial
+	 * block state, so chunks do not need to be block aligned.
+	 */
+	evp_aead_iov_cursor_init(&in_cur, in, in_cnt);
+	evp_aead_iov_cursor_init(&out_cur, out, out_cnt);
+
+	while ((n = evp_aead_iov_cursor_peek(&in_cur, &ip)) > 0) {
+		if ((m = evp_aead_iov_cursor_peek(&out_cur, &op)) == 0)
+			return 0;
+		if (n > m)
+			n = m;
+		if (gcm_ctx->ctr) {
+			if (CRYPTO_gcm128_encrypt_ctr32(&gcm, ip, op, n,
+			    gcm_ctx->ctr))
+				return 0;
+		} else {
+			if (CRYPTO_gcm128_encrypt(&gcm, ip, op, n))
+				return 0;
+		}
+		evp_aead_iov_cursor_advance(&in_cur, n);
+		evp_aead_iov_cursor_advance(&out_cur, n);
+	}
+
+	/* Write the tag directly if it fits in the current output region. */
+	if (evp_aead_iov_cursor_peek(&out_cur, &op) >= gcm_ctx->tag_len) {
+		CRYPTO_gcm128_tag(&gcm, op, gcm_ctx->tag_len);
+	} else {
+		CRYPTO_gcm128_tag(&gcm, tag, gcm_ctx->tag_len);
+		if (!evp_aead_iov_cursor_write(&out_cur, tag, gcm_ctx->tag_len))
+			return 0;
+	}
+	*out_len = in_len + gcm_ctx->tag_len;
+
+	return 1;
+}
+
 static int
 aead_aes_gcm_open(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
     size_t max_out_len, const unsigned char *nonce, size_t nonce_len,
@@ -1527,6 +1601,97 @@ aead_aes_gcm_open(const EVP_AEAD_CTX *ctx, unsigned char *out, size_t *out_len,
 	return 1;
 }
 
+static int
+aead_aes_gcm_openv(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, const unsigned char *nonce,
+    size_t nonce_len, const EVP_AEAD_IOVEC *in, size_t in_cnt,
+    const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	const struct aead_aes_gcm_ctx *gcm_ctx = ctx->aead_state;
+	struct evp_aead_iov_cursor in_cur, out_cur;
+	unsigned char tag[EVP_AEAD_AES_GCM_TAG_LEN];
+	unsigned char want_tag[EVP_AEAD_AES_GCM_TAG_LEN];
+	const unsigned char *in_tag;
+	unsigned char *ip, *op;
+	size_t in_len, max_out_len, plaintext_len;
+	size_t i, m, n, remaining;
+	GCM128_CONTEXT gcm;
+
+	if (!evp_aead_iov_len(in, in_cnt, &in_len) ||
+	    !evp_aead_iov_len(out, out_cnt, &max_out_len))
+		return 0;
+
+	if (in_len < gcm_ctx->tag_len) {
+		EVPerror(EVP_R_BAD_DECRYPT);
+		return 0;
+	}
+
+	plaintext_len = in_len - gcm_ctx->tag_len;
+
+	if (max_out_len < plaintext_len) {
+		EVPerror(EVP_R_BUFFER_TOO_SMALL);
+		return 0;
+	}
+
+	memcpy(&gcm, &gcm_ctx->gcm, sizeof(gcm));
+
+	if (nonce_len == 0) {
+		EVPerror(EVP_R_INVALID_IV_LENGTH);
+		return 0;
+	}
+	CRYPTO_gcm128_setiv(&gcm, nonce, nonce_len);
+
+	for (i = 0; i < ad_cnt; i++) {
+		if (ad[i].len > 0 &&
+		    CRYPTO_gcm128_aad(&gcm, ad[i].data, ad[i].len))
+			return 0;
+	}
+
+	evp_aead_iov_cursor_init(&in_cur, in, in_cnt);
+	evp_aead_iov_cursor_init(&out_cur, out, out_cnt);
+
+	for (remaining = plaintext_len; remaining > 0; remaining -= n) {
+		if ((n = evp_aead_iov_cursor_peek(&in_cur, &ip)) == 0)
+			return 0;
+		if ((m = evp_aead_iov_cursor_peek(&out_cur, &op)) == 0)
+			return 0;
+		if (n > m)
+			n = m;
+		if (n > remaining)
+			n = remaining;
+		if (gcm_ctx->ctr) {
+			if (CRYPTO_gcm128_decrypt_ctr32(&gcm, ip, op, n,
+			    gcm_ctx->ctr))
+				return 0;
+		} else {
+			if (CRYPTO_gcm128_decrypt(&gcm, ip, op, n))
+				return 0;
+		}
+		evp_aead_iov_cursor_advance(&in_cur, n);
+		evp_aead_iov_cursor_advance(&out_cur, n);
+	}
+
+	/* The tag is only copied out if it spans input regions. */
+	if (evp_aead_iov_cursor_peek(&in_cur, &ip) >= gcm_ctx->tag_len) {
+		in_tag = ip;
+	} else {
+		if (!evp_aead_iov_cursor_read(&in_cur, want_tag,
+		    gcm_ctx->tag_len))
+			return 0;
+		in_tag = want_tag;
+	}
+
+	CRYPTO_gcm128_tag(&gcm, tag, gcm_ctx->tag_len);
+	if (timingsafe_memcmp(tag, in_tag, gcm_ctx->tag_len) != 0) {
+		EVPerror(EVP_R_BAD_DECRYPT);
+		return 0;
+	}
+
+	*out_len = plaintext_len;
+
+	return 1;
+}
+
 static const EVP_AEAD aead_aes_128_gcm = {
 	.key_len = 16,
 	.nonce_len = 12,
@@ -1537,6 +1702,8 @@ static const EVP_AEAD aead_aes_128_gcm = {
 	.cleanup = aead_aes_gcm_cleanup,
 	.seal = aead_aes_gcm_seal,
 	.open = aead_aes_gcm_open,
+	.sealv = aead_aes_gcm_sealv,
+	.openv = aead_aes_gcm_openv,
 };
 
 static const EVP_AEAD aead_aes_256_gcm = {
@@ -1549,6 +1716,8 @@ static const EVP_AEAD aead_aes_256_gcm = {
 	.cleanup = aead_aes_gcm_cleanup,
 	.seal = aead_aes_gcm_seal,
 	.open = aead_aes_gcm_open,
+	.sealv = aead_aes_gcm_sealv,
+	.openv = aead_aes_gcm_openv,
 };
 
 const EVP_AEAD *
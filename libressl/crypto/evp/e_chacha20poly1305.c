@@ -99,14 +99,11 @@ poly1305_update_with_length(poly1305_state *poly1305,
 }
 
 static void
-poly1305_update_with_pad16(poly1305_state *poly1305,
-    const unsigned char *data, size_t data_len)
+poly1305_pad16(poly1305_state *poly1305, size_t data_len)
 {
 	static const unsigned char zero_pad16[16];
 	size_t pad_len;
 
-	CRYPTO_poly1305_update(poly1305, data, data_len);
-
 	/* pad16() is defined in RFC 7539 2.8.1. */
 	if ((pad_len = data_len % 16) == 0)
 		return;
@@ -114,6 +111,25 @@ poly1305_update_with_pad16(poly1305_state *poly1305,
 	CRYPTO_poly1305_update(poly1305, zero_pad16, 16 - pad_len);
 }
 
+static void
+poly1305_update_with_pad16(poly1305_state *poly1305,
+    const unsigned char *data, size_t data_len)
+{
+	CRYPTO_poly1305_update(poly1305, data, data_len);
+	poly1305_pad16(poly1305, data_len);
+}
+
+static void
+poly1305_update_iov_with_pad16(poly1305_state *poly1305,
+    const EVP_AEAD_IOVEC *iov, size_t cnt, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		CRYPTO_poly1305_update(poly1305, iov[i].data, iov[i].len);
+	poly1305_pad16(poly1305, len);
+}
+
 static int
 aead_chacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, unsigned char *out,
     size_t *out_len, size_t max_out_len, const unsigned char *nonce,
@@ -177,6 +193,269 @@ aead_chacha20_poly1305_seal(const EVP_AEAD_CTX *ctx, unsigned char *out,
 	return 1;
 }
 
+/*
+ * chacha20_poly1305_sealv implements scatter/gather sealing for both the
+ * ChaCha20 and XChaCha20 variants, given the (sub)key, the 8 byte IV and the
+ * initial 64 bit block counter used to derive the Poly1305 key. The input is
+ * encrypted straight into the output regions and the resulting ciphertext is
+ * fed to Poly1305 from there, so no intermediate copies are made.
+ */
+static int
+chacha20_poly1305_sealv(const struct aead_chacha20_poly1305_ctx *c20_ctx,
+    const unsigned char *key, const unsigned char *iv, uint64_t ctr,
+    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+    const EVP_AEAD_IOVEC *in, size_t in_cnt, const EVP_AEAD_IOVEC *ad,
+    size_t ad_cnt)
+{
+	struct evp_aead_iov_cursor in_cur, out_cur;
+	unsigned char tag[POLY1305_TAG_LEN];
+	unsigned char poly1305_key[32];
+	unsigned char counter[8];
+	size_t in_len, ad_len, max_out_len;
+	unsigned char *ip, *op;
+	poly1305_state poly1305;
+	ChaCha_ctx chacha;
+	uint64_t in_len_64;
+	size_t i, m, n;
+
+	if (!evp_aead_iov_len(in, in_cnt, &in_len) ||
+	    !evp_aead_iov_len(ad, ad_cnt, &ad_len) ||
+	    !evp_aead_iov_len(out, out_cnt, &max_out_len))
+		return 0;
+
+	/* See aead_chacha20_poly1305_seal() for the rationale. */
+	in_len_64 = in_len;
+	if (in_len_64 >= (1ULL << 32) * 64 - 64) {
+		EVPerror(EVP_R_TOO_LARGE);
+		return 0;
+	}
+
+	if (max_out_len < in_len + c20_ctx->tag_len) {
+		EVPerror(EVP_R_BUFFER_TOO_SMALL);
+		return 0;
+	}
+
+	memset(poly1305_key, 0, sizeof(poly1305_key));
+	CRYPTO_chacha_20(poly1305_key, poly1305_key,
+	    sizeof(poly1305_key), key, iv, ctr);
+
+	CRYPTO_poly1305_init(&poly1305, poly1305_key);
+	poly1305_update_iov_with_pad16(&poly1305, ad, ad_cnt, ad_len);
+
+	/*
+	 * The keystream for the payload starts at the following block - the
+	 * streaming interface retains partial blocks between chunks.
+	 */
+	ctr++;
+	for (i = 0; i < sizeof(counter); i++)
+		counter[i] = (ctr >> (i * 8)) & 0xff;
+
+	ChaCha_set_key(&chacha, key, 256);
+	ChaCha_set_iv(&chacha, iv, counter);
+
+	evp_aead_iov_cursor_init(&in_cur, in, in_cnt);
+	evp_aead_iov_cursor_init(&out_cur, out, out_cnt);
+
+	while ((n = evp_aead_iov_cursor_peek(&in_cur, &ip)) > 0) {
+		if ((m = evp_aead_iov_cursor_peek(&out_cur, &op)) == 0)
+			goto err;
+		if (n > m)
+			n = m;
+		ChaCha(&chacha, op, ip, n);
+		CRYPTO_poly1305_update(&poly1305, op, n);
+		evp_aead_iov_cursor_advance(&in_cur, n);
+		evp_aead_iov_cursor_advance(&out_cur, n);
+	}
+
+	poly1305_pad16(&poly1305, in_len);
+	poly1305_update_with_length(&poly1305, NULL, ad_len);
+	poly1305_update_with_length(&poly1305, NULL, in_len);
+
+	/* Write the tag directly if it fits in the current output region. */
+	if (c20_ctx->tag_len == POLY1305_TAG_LEN &&
+	    evp_aead_iov_cursor_peek(&out_cur, &op) >= POLY1305_TAG_LEN) {
+		CRYPTO_poly1305_finish(&poly1305, op);
+	} else {
+		CRYPTO_poly1305_finish(&poly1305, tag);
+		if (!evp_aead_iov_cursor_write(&out_cur, tag, c20_ctx->tag_len))
+			goto err;
+	}
+	*out_len = in_len + c20_ctx->tag_len;
+
+	explicit_bzero(&chacha, sizeof(chacha));
+
+	return 1;
+
+ err:
+	explicit_bzero(&chacha, sizeof(chacha));
+
+	return 0;
+}
+
+static int
+aead_chacha20_poly1305_sealv(const EVP_AEAD_CTX *ctx,
+    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+    const unsigned char *nonce, size_t nonce_len, const EVP_AEAD_IOVEC *in,
+    size_t in_cnt, const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
+	uint64_t ctr;
+
+	if (nonce_len != ctx->aead->nonce_len) {
+		EVPerror(EVP_R_IV_TOO_LARGE);
+		return 0;
+	}
+
+	ctr = (uint64_t)((uint32_t)(nonce[0]) | (uint32_t)(nonce[1]) << 8 |
+	    (uint32_t)(nonce[2]) << 16 | (uint32_t)(nonce[3]) << 24) << 32;
+
+	return chacha20_poly1305_sealv(c20_ctx, c20_ctx->key,
+	    nonce + CHACHA20_CONSTANT_LEN, ctr, out, out_cnt, out_len,
+	    in, in_cnt, ad, ad_cnt);
+}
+
+/*
+ * chacha20_poly1305_openv is the counterpart of chacha20_poly1305_sealv. The
+ * tag is verified over the ciphertext regions before anything is decrypted.
+ */
+static int
+chacha20_poly1305_openv(const struct aead_chacha20_poly1305_ctx *c20_ctx,
+    const unsigned char *key, const unsigned char *iv, uint64_t ctr,
+    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+    const EVP_AEAD_IOVEC *in, size_t in_cnt, const EVP_AEAD_IOVEC *ad,
+    size_t ad_cnt)
+{
+	struct evp_aead_iov_cursor in_cur, out_cur;
+	unsigned char mac[POLY1305_TAG_LEN];
+	unsigned char tag[POLY1305_TAG_LEN];
+	unsigned char poly1305_key[32];
+	unsigned char counter[8];
+	size_t in_len, ad_len, max_out_len, plaintext_len;
+	const unsigned char *in_tag;
+	unsigned char *ip, *op;
+	poly1305_state poly1305;
+	ChaCha_ctx chacha;
+	uint64_t in_len_64;
+	size_t i, m, n, remaining;
+
+	if (!evp_aead_iov_len(in, in_cnt, &in_len) ||
+	    !evp_aead_iov_len(ad, ad_cnt, &ad_len) ||
+	    !evp_aead_iov_len(out, out_cnt, &max_out_len))
+		return 0;
+
+	if (in_len < c20_ctx->tag_len) {
+		EVPerror(EVP_R_BAD_DECRYPT);
+		return 0;
+	}
+
+	/* See aead_chacha20_poly1305_seal() for the rationale. */
+	in_len_64 = in_len;
+	if (in_len_64 >= (1ULL << 32) * 64 - 64) {
+		EVPerror(EVP_R_TOO_LARGE);
+		return 0;
+	}
+
+	plaintext_len = in_len - c20_ctx->tag_len;
+
+	if (max_out_len < plaintext_len) {
+		EVPerror(EVP_R_BUFFER_TOO_SMALL);
+		return 0;
+	}
+
+	memset(poly1305_key, 0, sizeof(poly1305_key));
+	CRYPTO_chacha_20(poly1305_key, poly1305_key,
+	    sizeof(poly1305_key), key, iv, ctr);
+
+	CRYPTO_poly1305_init(&poly1305, poly1305_key);
+	poly1305_update_iov_with_pad16(&poly1305, ad, ad_cnt, ad_len);
+
+	evp_aead_iov_cursor_init(&in_cur, in, in_cnt);
+	for (remaining = plaintext_len; remaining > 0; remaining -= n) {
+		if ((n = evp_aead_iov_cursor_peek(&in_cur, &ip)) == 0)
+			return 0;
+		if (n > remaining)
+			n = remaining;
+		CRYPTO_poly1305_update(&poly1305, ip, n);
+		evp_aead_iov_cursor_advance(&in_cur, n);
+	}
+
+	poly1305_pad16(&poly1305, plaintext_len);
+	poly1305_update_with_length(&poly1305, NULL, ad_len);
+	poly1305_update_with_length(&poly1305, NULL, plaintext_len);
+
+	CRYPTO_poly1305_finish(&poly1305, mac);
+
+	/* The tag is only copied out if it spans input regions. */
+	if (evp_aead_iov_cursor_peek(&in_cur, &ip) >= c20_ctx->tag_len) {
+		in_tag = ip;
+	} else {
+		if (!evp_aead_iov_cursor_read(&in_cur, tag, c20_ctx->tag_len))
+			return 0;
+		in_tag = tag;
+	}
+
+	if (timingsafe_memcmp(mac, in_tag, c20_ctx->tag_len) != 0) {
+		EVPerror(EVP_R_BAD_DECRYPT);
+		return 0;
+	}
+
+	ctr++;
+	for (i = 0; i < sizeof(counter); i++)
+		counter[i] = (ctr >> (i * 8)) & 0xff;
+
+	ChaCha_set_key(&chacha, key, 256);
+	ChaCha_set_iv(&chacha, iv, counter);
+
+	evp_aead_iov_cursor_init(&in_cur, in, in_cnt);
+	evp_aead_iov_cursor_init(&out_cur, out, out_cnt);
+
+	for (remaining = plaintext_len; remaining > 0; remaining -= n) {
+		if ((n = evp_aead_iov_cursor_peek(&in_cur, &ip)) == 0)
+			goto err;
+		if ((m = evp_aead_iov_cursor_peek(&out_cur, &op)) == 0)
+			goto err;
+		if (n > m)
+			n = m;
+		if (n > remaining)
+			n = remaining;
+		ChaCha(&chacha, op, ip, n);
+		evp_aead_iov_cursor_advance(&in_cur, n);
+		evp_aead_iov_cursor_advance(&out_cur, n);
+	}
+	*out_len = plaintext_len;
+
+	explicit_bzero(&chacha, sizeof(chacha));
+
+	return 1;
+
+ err:
+	explicit_bzero(&chacha, sizeof(chacha));
+
+	return 0;
+}
+
+static int
+aead_chacha20_poly1305_openv(const EVP_AEAD_CTX *ctx,
+    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+    const unsigned char *nonce, size_t nonce_len, const EVP_AEAD_IOVEC *in,
+    size_t in_cnt, const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
+	uint64_t ctr;
+
+	if (nonce_len != ctx->aead->nonce_len) {
+		EVPerror(EVP_R_IV_TOO_LARGE);
+		return 0;
+	}
+
+	ctr = (uint64_t)((uint32_t)(nonce[0]) | (uint32_t)(nonce[1]) << 8 |
+	    (uint32_t)(nonce[2]) << 16 | (uint32_t)(nonce[3]) << 24) << 32;
+
+	return chacha20_poly1305_openv(c20_ctx, c20_ctx->key,
+	    nonce + CHACHA20_CONSTANT_LEN, ctr, out, out_cnt, out_len,
+	    in, in_cnt, ad, ad_cnt);
+}
+
 static int
 aead_chacha20_poly1305_open(const EVP_AEAD_CTX *ctx, unsigned char *out,
     size_t *out_len, size_t max_out_len, const unsigned char *nonce,
@@ -349,6 +628,56 @@ aead_xchacha20_poly1305_open(const EVP_AEAD_CTX *ctx, unsigned char *out,
 	return 1;
 }
 
+static int
+aead_xchacha20_poly1305_sealv(const EVP_AEAD_CTX *ctx,
+    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+    const unsigned char *nonce, size_t nonce_len, const EVP_AEAD_IOVEC *in,
+    size_t in_cnt, const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
+	unsigned char subkey[32];
+	int ret;
+
+	if (nonce_len != ctx->aead->nonce_len) {
+		EVPerror(EVP_R_IV_TOO_LARGE);
+		return 0;
+	}
+
+	CRYPTO_hchacha_20(subkey, c20_ctx->key, nonce);
+
+	ret = chacha20_poly1305_sealv(c20_ctx, subkey, nonce + 16, 0,
+	    out, out_cnt, out_len, in, in_cnt, ad, ad_cnt);
+
+	explicit_bzero(subkey, sizeof(subkey));
+
+	return ret;
+}
+
+static int
+aead_xchacha20_poly1305_openv(const EVP_AEAD_CTX *ctx,
+    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+    const unsigned char *nonce, size_t nonce_len, const EVP_AEAD_IOVEC *in,
+    size_t in_cnt, const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	const struct aead_chacha20_poly1305_ctx *c20_ctx = ctx->aead_state;
+	unsigned char subkey[32];
+	int ret;
+
+	if (nonce_len != ctx->aead->nonce_len) {
+		EVPerror(EVP_R_IV_TOO_LARGE);
+		return 0;
+	}
+
+	CRYPTO_hchacha_20(subkey, c20_ctx->key, nonce);
+
+	ret = chacha20_poly1305_openv(c20_ctx, subkey, nonce + 16, 0,
+	    out, out_cnt, out_len, in, in_cnt, ad, ad_cnt);
+
+	explicit_bzero(subkey, sizeof(subkey));
+
+	return ret;
+}
+
 /* RFC 7539 */
 static const EVP_AEAD aead_chacha20_poly1305 = {
 	.key_len = 32,
@@ -360,6 +689,8 @@ static const EVP_AEAD aead_chacha20_poly1305 = {
 	.cleanup = aead_chacha20_poly1305_cleanup,
 	.seal = aead_chacha20_poly1305_seal,
 	.open = aead_chacha20_poly1305_open,
+	.sealv = aead_chacha20_poly1305_sealv,
+	.openv = aead_chacha20_poly1305_openv,
 };
 
 const EVP_AEAD *
@@ -378,6 +709,8 @@ static const EVP_AEAD aead_xchacha20_poly1305 = {
 	.cleanup = aead_chacha20_poly1305_cleanup,
 	.seal = aead_xchacha20_poly1305_seal,
 	.open = aead_xchacha20_poly1305_open,
+	.sealv = aead_xchacha20_poly1305_sealv,
+	.openv = aead_xchacha20_poly1305_openv,
 };
 
 const EVP_AEAD *
@@ -16,6 +16,8 @@
  */
 
 #include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <openssl/evp.h>
@@ -142,3 +144,341 @@ error:
 	*out_len = 0;
 	return 0;
 }
+
+int
+evp_aead_iov_len(const EVP_AEAD_IOVEC *iov, size_t cnt, size_t *out_len)
+{
+	size_t i, len = 0;
+
+	for (i = 0; i < cnt; i++) {
+		if (len + iov[i].len < len)
+			return 0;
+		len += iov[i].len;
+	}
+
+	*out_len = len;
+
+	return 1;
+}
+
+void
+evp_aead_iov_cursor_init(struct evp_aead_iov_cursor *cur,
+    const EVP_AEAD_IOVEC *iov, size_t cnt)
+{
+	memset(cur, 0, sizeof(*cur));
+
+	cur->iov = iov;
+	cur->cnt = cnt;
+}
+
+/*
+ * evp_aead_iov_cursor_peek returns the number of contiguous bytes that are
+ * available at the current position, setting data to point at them. Zero is
+ * returned once the end of the list has been reached.
+ */
+size_t
+evp_aead_iov_cursor_peek(struct evp_aead_iov_cursor *cur, unsigned char **data)
+{
+	/* Skip over exhausted and zero length regions. */
+	while (cur->idx < cur->cnt && cur->off >= cur->iov[cur->idx].len) {
+		cur->idx++;
+		cur->off = 0;
+	}
+
+	if (cur->idx >= cur->cnt) {
+		*data = NULL;
+		return 0;
+	}
+
+	*data = cur->iov[cur->idx].data + cur->off;
+
+	return cur->iov[cur->idx].len - cur->off;
+}
+
+/* Advance by len bytes, which must not exceed the result of the last peek. */
+void
+evp_aead_iov_cursor_advance(struct evp_aead_iov_cursor *cur, size_t len)
+{
+	cur->off += len;
+}
+
+int
+evp_aead_iov_cursor_write(struct evp_aead_iov_cursor *cur,
+    const unsigned char *data, size_t len)
+{
+	unsigned char *out;
+	size_t n;
+
+	while (len > 0) {
+		if ((n = evp_aead_iov_cursor_peek(cur, &out)) == 0)
+			return 0;
+		if (n > len)
+			n = len;
+
+		memcpy(out, data, n);
+		evp_aead_iov_cursor_advance(cur, n);
+
+		data += n;
+		len -= n;
+	}
+
+	return 1;
+}
+
+int
+evp_aead_iov_cursor_read(struct evp_aead_iov_cursor *cur,
+    unsigned char *data, size_t len)
+{
+	unsigned char *in;
+	size_t n;
+
+	while (len > 0) {
+		if ((n = evp_aead_iov_cursor_peek(cur, &in)) == 0)
+			return 0;
+		if (n > len)
+			n = len;
+
+		memcpy(data, in, n);
+		evp_aead_iov_cursor_advance(cur, n);
+
+		data += n;
+		len -= n;
+	}
+
+	return 1;
+}
+
+/* check_alias_iov returns 0 if an output region overlaps an input region
+ * and 1 otherwise.
+ *
+ * Overlap is permitted for in-place processing, where each overlapping
+ * output byte is at the same offset in the output as the input byte that
+ * it overlays is in the input. Otherwise writing the output would stomp
+ * input that hasn't been read yet. */
+static int
+check_alias_iov(const EVP_AEAD_IOVEC *in, size_t in_cnt,
+    const EVP_AEAD_IOVEC *out, size_t out_cnt)
+{
+	size_t i, j, in_off, out_off;
+
+	for (i = 0, in_off = 0; i < in_cnt; in_off += in[i].len, i++) {
+		if (in[i].len == 0)
+			continue;
+		for (j = 0, out_off = 0; j < out_cnt; out_off += out[j].len, j++) {
+			if (out[j].len == 0)
+				continue;
+			if (out[j].data + out[j].len <= in[i].data)
+				continue;
+			if (in[i].data + in[i].len <= out[j].data)
+				continue;
+			if (out[j].data - in[i].data ==
+			    (ptrdiff_t)out_off - (ptrdiff_t)in_off)
+				continue;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static unsigned char *
+evp_aead_iov_gather(const EVP_AEAD_IOVEC *iov, size_t cnt, size_t len)
+{
+	unsigned char *buf, *p;
+	size_t i;
+
+	if ((buf = malloc(len > 0 ? len : 1)) == NULL)
+		return NULL;
+
+	for (i = 0, p = buf; i < cnt; i++) {
+		if (iov[i].len == 0)
+			continue;
+		memcpy(p, iov[i].data, iov[i].len);
+		p += iov[i].len;
+	}
+
+	return buf;
+}
+
+/*
+ * evp_aead_sealv_linear provides scatter/gather sealing for AEADs that do not
+ * implement it natively, by gathering the input and additional data into
+ * newly allocated buffers and sealing into a third, which is then scattered
+ * across the output regions.
+ */
+static int
+evp_aead_sealv_linear(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, size_t max_out_len,
+    const unsigned char *nonce, size_t nonce_len, const EVP_AEAD_IOVEC *in,
+    size_t in_cnt, size_t in_len, const EVP_AEAD_IOVEC *ad, size_t ad_cnt,
+    size_t ad_len)
+{
+	unsigned char *in_buf = NULL, *ad_buf = NULL, *out_buf = NULL;
+	size_t out_buf_len;
+	struct evp_aead_iov_cursor cur;
+	int ret = 0;
+
+	out_buf_len = in_len + ctx->aead->overhead;
+	if (out_buf_len > max_out_len)
+		out_buf_len = max_out_len;
+
+	if ((in_buf = evp_aead_iov_gather(in, in_cnt, in_len)) == NULL)
+		goto err;
+	if ((ad_buf = evp_aead_iov_gather(ad, ad_cnt, ad_len)) == NULL)
+		goto err;
+	if ((out_buf = malloc(out_buf_len > 0 ? out_buf_len : 1)) == NULL)
+		goto err;
+
+	if (!ctx->aead->seal(ctx, out_buf, out_len, out_buf_len, nonce,
+	    nonce_len, in_buf, in_len, ad_buf, ad_len))
+		goto err;
+
+	evp_aead_iov_cursor_init(&cur, out, out_cnt);
+	if (!evp_aead_iov_cursor_write(&cur, out_buf, *out_len))
+		goto err;
+
+	ret = 1;
+
+ err:
+	freezero(in_buf, in_len);
+	freezero(ad_buf, ad_len);
+	freezero(out_buf, out_buf_len);
+
+	return ret;
+}
+
+/*
+ * evp_aead_openv_linear is the counterpart of evp_aead_sealv_linear.
+ */
+static int
+evp_aead_openv_linear(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, size_t max_out_len,
+    const unsigned char *nonce, size_t nonce_len, const EVP_AEAD_IOVEC *in,
+    size_t in_cnt, size_t in_len, const EVP_AEAD_IOVEC *ad, size_t ad_cnt,
+    size_t ad_len)
+{
+	unsigned char *in_buf = NULL, *ad_buf = NULL, *out_buf = NULL;
+	size_t out_buf_len;
+	struct evp_aead_iov_cursor cur;
+	int ret = 0;
+
+	out_buf_len = in_len;
+	if (out_buf_len > max_out_len)
+		out_buf_len = max_out_len;
+
+	if ((in_buf = evp_aead_iov_gather(in, in_cnt, in_len)) == NULL)
+		goto err;
+	if ((ad_buf = evp_aead_iov_gather(ad, ad_cnt, ad_len)) == NULL)
+		goto err;
+	if ((out_buf = malloc(out_buf_len > 0 ? out_buf_len : 1)) == NULL)
+		goto err;
+
+	if (!ctx->aead->open(ctx, out_buf, out_len, out_buf_len, nonce,
+	    nonce_len, in_buf, in_len, ad_buf, ad_len))
+		goto err;
+
+	evp_aead_iov_cursor_init(&cur, out, out_cnt);
+	if (!evp_aead_iov_cursor_write(&cur, out_buf, *out_len))
+		goto err;
+
+	ret = 1;
+
+ err:
+	freezero(in_buf, in_len);
+	freezero(ad_buf, ad_len);
+	freezero(out_buf, out_buf_len);
+
+	return ret;
+}
+
+int
+EVP_AEAD_CTX_sealv(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, const unsigned char *nonce,
+    size_t nonce_len, const EVP_AEAD_IOVEC *in, size_t in_cnt,
+    const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	size_t in_len, ad_len, max_out_len;
+	size_t i;
+
+	if (!evp_aead_iov_len(in, in_cnt, &in_len) ||
+	    !evp_aead_iov_len(ad, ad_cnt, &ad_len) ||
+	    !evp_aead_iov_len(out, out_cnt, &max_out_len)) {
+		EVPerror(EVP_R_TOO_LARGE);
+		goto error;
+	}
+
+	/* Overflow. */
+	if (in_len + ctx->aead->overhead < in_len) {
+		EVPerror(EVP_R_TOO_LARGE);
+		goto error;
+	}
+
+	if (!check_alias_iov(in, in_cnt, out, out_cnt)) {
+		EVPerror(EVP_R_OUTPUT_ALIASES_INPUT);
+		goto error;
+	}
+
+	if (ctx->aead->sealv != NULL) {
+		if (ctx->aead->sealv(ctx, out, out_cnt, out_len, nonce,
+		    nonce_len, in, in_cnt, ad, ad_cnt))
+			return 1;
+		goto error;
+	}
+
+	if (evp_aead_sealv_linear(ctx, out, out_cnt, out_len, max_out_len,
+	    nonce, nonce_len, in, in_cnt, in_len, ad, ad_cnt, ad_len))
+		return 1;
+
+error:
+	/* In the event of an error, clear the output regions so that a caller
+	 * that doesn't check the return value doesn't send raw data. */
+	for (i = 0; i < out_cnt; i++) {
+		if (out[i].len > 0)
+			memset(out[i].data, 0, out[i].len);
+	}
+	*out_len = 0;
+	return 0;
+}
+
+int
+EVP_AEAD_CTX_openv(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, const unsigned char *nonce,
+    size_t nonce_len, const EVP_AEAD_IOVEC *in, size_t in_cnt,
+    const EVP_AEAD_IOVEC *ad, size_t ad_cnt)
+{
+	size_t in_len, ad_len, max_out_len;
+	size_t i;
+
+	if (!evp_aead_iov_len(in, in_cnt, &in_len) ||
+	    !evp_aead_iov_len(ad, ad_cnt, &ad_len) ||
+	    !evp_aead_iov_len(out, out_cnt, &max_out_len)) {
+		EVPerror(EVP_R_TOO_LARGE);
+		goto error;
+	}
+
+	if (!check_alias_iov(in, in_cnt, out, out_cnt)) {
+		EVPerror(EVP_R_OUTPUT_ALIASES_INPUT);
+		goto error;
+	}
+
+	if (ctx->aead->openv != NULL) {
+		if (ctx->aead->openv(ctx, out, out_cnt, out_len, nonce,
+		    nonce_len, in, in_cnt, ad, ad_cnt))
+			return 1;
+		goto error;
+	}
+
+	if (evp_aead_openv_linear(ctx, out, out_cnt, out_len, max_out_len,
+	    nonce, nonce_len, in, in_cnt, in_len, ad, ad_cnt, ad_len))
+		return 1;
+
+error:
+	/* In the event of an error, clear the output regions so that a caller
+	 * that doesn't check the return value doesn't try and process bad
+	 * data. */
+	for (i = 0; i < out_cnt; i++) {
+		if (out[i].len > 0)
+			memset(out[i].data, 0, out[i].len);
+	}
+	*out_len = 0;
+	return 0;
+}
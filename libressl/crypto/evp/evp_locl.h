@@ -338,6 +338,12 @@ struct evp_pkey_method_st {
 
 	int (*ctrl)(EVP_PKEY_CTX *ctx, int type, int p1, void *p2);
 	int (*ctrl_str)(EVP_PKEY_CTX *ctx, const char *type, const char *value);
+
+	/* One-shot signing of a whole message, for schemes without a digest. */
+	int (*digestsign)(EVP_MD_CTX *ctx, unsigned char *sig, size_t *siglen,
+	    const unsigned char *tbs, size_t tbslen);
+	int (*digestverify)(EVP_MD_CTX *ctx, const unsigned char *sig,
+	    size_t siglen, const unsigned char *tbs, size_t tbslen);
 } /* EVP_PKEY_METHOD */;
 
 void evp_pkey_set_cb_translate(BN_GENCB *cb, EVP_PKEY_CTX *ctx);
@@ -365,8 +371,46 @@ struct evp_aead_st {
 	    size_t *out_len, size_t max_out_len, const unsigned char *nonce,
 	    size_t nonce_len, const unsigned char *in, size_t in_len,
 	    const unsigned char *ad, size_t ad_len);
+
+	/*
+	 * Optional - if NULL, EVP_AEAD_CTX_sealv and EVP_AEAD_CTX_openv
+	 * linearise their input and call seal or open respectively.
+	 */
+	int (*sealv)(const struct evp_aead_ctx_st *ctx,
+	    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+	    const unsigned char *nonce, size_t nonce_len,
+	    const EVP_AEAD_IOVEC *in, size_t in_cnt,
+	    const EVP_AEAD_IOVEC *ad, size_t ad_cnt);
+
+	int (*openv)(const struct evp_aead_ctx_st *ctx,
+	    const EVP_AEAD_IOVEC *out, size_t out_cnt, size_t *out_len,
+	    const unsigned char *nonce, size_t nonce_len,
+	    const EVP_AEAD_IOVEC *in, size_t in_cnt,
+	    const EVP_AEAD_IOVEC *ad, size_t ad_cnt);
+};
+
+/*
+ * An evp_aead_iov_cursor tracks a position within a scatter/gather list,
+ * allowing the regions of an input and output list to be walked in step.
+ */
+struct evp_aead_iov_cursor {
+	const EVP_AEAD_IOVEC *iov;
+	size_t cnt;
+	size_t idx;
+	size_t off;
 };
 
+int evp_aead_iov_len(const EVP_AEAD_IOVEC *iov, size_t cnt, size_t *out_len);
+void evp_aead_iov_cursor_init(struct evp_aead_iov_cursor *cur,
+    const EVP_AEAD_IOVEC *iov, size_t cnt);
+size_t evp_aead_iov_cursor_peek(struct evp_aead_iov_cursor *cur,
+    unsigned char **data);
+void evp_aead_iov_cursor_advance(struct evp_aead_iov_cursor *cur, size_t len);
+int evp_aead_iov_cursor_read(struct evp_aead_iov_cursor *cur,
+    unsigned char *data, size_t len);
+int evp_aead_iov_cursor_write(struct evp_aead_iov_cursor *cur,
+    const unsigned char *data, size_t len);
+
 int EVP_PKEY_CTX_md(EVP_PKEY_CTX *ctx, int optype, int cmd, const char *md_name);
 
 __END_HIDDEN_DECLS
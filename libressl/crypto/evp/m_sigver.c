@@ -65,6 +65,13 @@
 
 #include "evp_locl.h"
 
+static int
+oneshot_update(EVP_MD_CTX *ctx, const void *data, size_t count)
+{
+	EVPerror(EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+	return 0;
+}
+
 static int
 do_sigver_init(EVP_MD_CTX *ctx, EVP_PKEY_CTX **pctx, const EVP_MD *type,
     ENGINE *e, EVP_PKEY *pkey, int ver)
@@ -74,6 +81,24 @@ do_sigver_init(EVP_MD_CTX *ctx, EVP_PKEY_CTX **pctx, const EVP_MD *type,
 	if (ctx->pctx == NULL)
 		return 0;
 
+	/*
+	 * Methods that sign the message itself take no digest and only
+	 * support EVP_DigestSign() and EVP_DigestVerify().
+	 */
+	if ((ver && ctx->pctx->pmeth->digestverify != NULL) ||
+	    (!ver && ctx->pctx->pmeth->digestsign != NULL)) {
+		if (type != NULL) {
+			EVPerror(EVP_R_INVALID_DIGEST);
+			return 0;
+		}
+		ctx->pctx->operation = ver ? EVP_PKEY_OP_VERIFY :
+		    EVP_PKEY_OP_SIGN;
+		ctx->update = oneshot_update;
+		if (pctx)
+			*pctx = ctx->pctx;
+		return 1;
+	}
+
 	if (!(ctx->pctx->pmeth->flags & EVP_PKEY_FLAG_SIGCTX_CUSTOM)) {
 		if (type == NULL) {
 			int def_nid;
@@ -135,6 +160,11 @@ EVP_DigestSignFinal(EVP_MD_CTX *ctx, unsigned char *sigret, size_t *siglen)
 	int sctx;
 	int r = 0;
 
+	if (pctx->pmeth->digestsign != NULL) {
+		EVPerror(EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+		return 0;
+	}
+
 	if (pctx->pmeth->flags & EVP_PKEY_FLAG_SIGCTX_CUSTOM) {
 		EVP_PKEY_CTX *dctx;
 
@@ -195,6 +225,11 @@ EVP_DigestVerifyFinal(EVP_MD_CTX *ctx, const unsigned char *sig, size_t siglen)
 	unsigned int mdlen = 0;
 	int vctx;
 
+	if (ctx->pctx->pmeth->digestverify != NULL) {
+		EVPerror(EVP_R_OPERATION_NOT_SUPPORTED_FOR_THIS_KEYTYPE);
+		return -1;
+	}
+
 	if (ctx->pctx->pmeth->verifyctx)
 		vctx = 1;
 	else
@@ -212,3 +247,31 @@ EVP_DigestVerifyFinal(EVP_MD_CTX *ctx, const unsigned char *sig, size_t siglen)
 		return r;
 	return EVP_PKEY_verify(ctx->pctx, sig, siglen, md, mdlen);
 }
+
+int
+EVP_DigestSign(EVP_MD_CTX *ctx, unsigned char *sigret, size_t *siglen,
+    const unsigned char *tbs, size_t tbslen)
+{
+	if (ctx->pctx->pmeth->digestsign != NULL)
+		return ctx->pctx->pmeth->digestsign(ctx, sigret, siglen,
+		    tbs, tbslen);
+
+	if (sigret != NULL && !EVP_DigestSignUpdate(ctx, tbs, tbslen))
+		return 0;
+
+	return EVP_DigestSignFinal(ctx, sigret, siglen);
+}
+
+int
+EVP_DigestVerify(EVP_MD_CTX *ctx, const unsigned char *sigret, size_t siglen,
+    const unsigned char *tbs, size_t tbslen)
+{
+	if (ctx->pctx->pmeth->digestverify != NULL)
+		return ctx->pctx->pmeth->digestverify(ctx, sigret, siglen,
+		    tbs, tbslen);
+
+	if (!EVP_DigestVerifyUpdate(ctx, tbs, tbslen))
+		return -1;
+
+	return EVP_DigestVerifyFinal(ctx, sigret, siglen);
+}
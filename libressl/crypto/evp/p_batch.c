@@ -0,0 +1,199 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/opensslconf.h>
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+
+#ifndef OPENSSL_NO_EC
+#include <openssl/ecdsa.h>
+#endif
+
+/*
+ * Items are handed to the runner in jobs of this many, which is enough to
+ * amortise the ECDSA inversions while leaving work for several threads.
+ */
+#define EVP_VERIFY_BATCH_JOB_SIZE	64
+
+struct evp_verify_batch_job {
+	EVP_PKEY_VERIFY_ITEM *items;
+	size_t num;
+};
+
+static int
+evp_verify_batch_one(EVP_PKEY_VERIFY_ITEM *item)
+{
+	EVP_PKEY_CTX *pctx;
+	int ret = -1;
+
+	if ((pctx = EVP_PKEY_CTX_new(item->pkey, NULL)) == NULL)
+		goto err;
+	if (EVP_PKEY_verify_init(pctx) <= 0)
+		goto err;
+	if (item->md != NULL &&
+	    EVP_PKEY_CTX_set_signature_md(pctx, item->md) <= 0)
+		goto err;
+	ret = EVP_PKEY_verify(pctx, item->sig, item->sig_len, item->dgst,
+	    item->dgst_len);
+
+ err:
+	EVP_PKEY_CTX_free(pctx);
+	return ret;
+}
+
+#ifndef OPENSSL_NO_EC
+/*
+ * Decode an ECDSA signature the way ECDSA_verify() does, refusing anything
+ * that is not in DER or has trailing garbage.
+ */
+static ECDSA_SIG *
+evp_verify_batch_ecdsa_sig(const unsigned char *sig, size_t sig_len)
+{
+	const unsigned char *p = sig;
+	unsigned char *der = NULL;
+	ECDSA_SIG *s;
+	int derlen = -1;
+
+	if (sig_len > INT_MAX)
+		return NULL;
+	if ((s = ECDSA_SIG_new()) == NULL)
+		return NULL;
+	if (d2i_ECDSA_SIG(&s, &p, sig_len) == NULL)
+		goto err;
+	derlen = i2d_ECDSA_SIG(s, &der);
+	if (derlen != (int)sig_len || memcmp(sig, der, derlen) != 0)
+		goto err;
+	freezero(der, derlen);
+
+	return s;
+
+ err:
+	freezero(der, derlen);
+	ECDSA_SIG_free(s);
+	return NULL;
+}
+#endif
+
+static void
+evp_verify_batch_job(void *arg)
+{
+	struct evp_verify_batch_job *job = arg;
+	EVP_PKEY_VERIFY_ITEM *item;
+#ifndef OPENSSL_NO_EC
+	const unsigned char *dgsts[EVP_VERIFY_BATCH_JOB_SIZE];
+	int dgst_lens[EVP_VERIFY_BATCH_JOB_SIZE];
+	const ECDSA_SIG *sigs[EVP_VERIFY_BATCH_JOB_SIZE];
+	ECDSA_SIG *sig;
+	EC_KEY *eckeys[EVP_VERIFY_BATCH_JOB_SIZE];
+	int results[EVP_VERIFY_BATCH_JOB_SIZE];
+	size_t idx[EVP_VERIFY_BATCH_JOB_SIZE];
+	size_t j, n = 0;
+#endif
+	size_t i;
+
+	for (i = 0; i < job->num; i++) {
+		item = &job->items[i];
+#ifndef OPENSSL_NO_EC
+		if (EVP_PKEY_base_id(item->pkey) == EVP_PKEY_EC &&
+		    item->pkey->engine == NULL && item->dgst_len <= INT_MAX) {
+			/* Undecodable signatures fail as in ECDSA_verify(). */
+			if ((sig = evp_verify_batch_ecdsa_sig(item->sig,
+			    item->sig_len)) == NULL) {
+				item->result = -1;
+				continue;
+			}
+			dgsts[n] = item->dgst;
+			dgst_lens[n] = item->dgst_len;
+			sigs[n] = sig;
+			eckeys[n] = EVP_PKEY_get0_EC_KEY(item->pkey);
+			idx[n++] = i;
+			continue;
+		}
+#endif
+		item->result = evp_verify_batch_one(item);
+	}
+
+#ifndef OPENSSL_NO_EC
+	if (n == 0)
+		return;
+
+	ECDSA_do_verify_batch(dgsts, dgst_lens, sigs, eckeys, results, n);
+
+	for (j = 0; j < n; j++) {
+		job->items[idx[j]].result = results[j];
+		ECDSA_SIG_free((ECDSA_SIG *)sigs[j]);
+	}
+#endif
+}
+
+static void
+evp_verify_batch_serial(void (*job)(void *), void **args, size_t njobs,
+    void *runner_arg)
+{
+	size_t i;
+
+	for (i = 0; i < njobs; i++)
+		job(args[i]);
+}
+
+int
+EVP_PKEY_verify_batch(EVP_PKEY_VERIFY_ITEM *items, size_t num,
+    EVP_PKEY_BATCH_RUNNER runner, void *runner_arg)
+{
+	struct evp_verify_batch_job *jobs = NULL;
+	void **args = NULL;
+	size_t i, njobs;
+	int ret = 0;
+
+	for (i = 0; i < num; i++)
+		items[i].result = -1;
+	if (num == 0)
+		return 1;
+
+	njobs = (num + EVP_VERIFY_BATCH_JOB_SIZE - 1) /
+	    EVP_VERIFY_BATCH_JOB_SIZE;
+	if ((jobs = calloc(njobs, sizeof(*jobs))) == NULL ||
+	    (args = calloc(njobs, sizeof(*args))) == NULL) {
+		EVPerror(ERR_R_MALLOC_FAILURE);
+		goto err;
+	}
+	for (i = 0; i < njobs; i++) {
+		jobs[i].items = &items[i * EVP_VERIFY_BATCH_JOB_SIZE];
+		jobs[i].num = EVP_VERIFY_BATCH_JOB_SIZE;
+		if (i == njobs - 1)
+			jobs[i].num = num - i * EVP_VERIFY_BATCH_JOB_SIZE;
+		args[i] = &jobs[i];
+	}
+
+	if (runner == NULL)
+		runner = evp_verify_batch_serial;
+	runner(evp_verify_batch_job, args, njobs, runner_arg);
+
+	ret = 1;
+	for (i = 0; i < num; i++) {
+		if (items[i].result != 1)
+			ret = 0;
+	}
+
+ err:
+	free(jobs);
+	free(args);
+	return ret;
+}
@@ -82,6 +82,7 @@ extern const EVP_PKEY_METHOD rsa_pkey_meth, rsa_pss_pkey_meth;
 extern const EVP_PKEY_METHOD dh_pkey_meth, dsa_pkey_meth;
 extern const EVP_PKEY_METHOD ec_pkey_meth, hmac_pkey_meth, cmac_pkey_meth;
 extern const EVP_PKEY_METHOD gostimit_pkey_meth, gostr01_pkey_meth;
+extern const EVP_PKEY_METHOD ed25519_pkey_meth;
 
 static const EVP_PKEY_METHOD *standard_methods[] = {
 #ifndef OPENSSL_NO_RSA
@@ -105,6 +106,7 @@ static const EVP_PKEY_METHOD *standard_methods[] = {
 #ifndef OPENSSL_NO_RSA
 	&rsa_pss_pkey_meth,
 #endif
+	&ed25519_pkey_meth,
 };
 
 static int pmeth_cmp_BSEARCH_CMP_FN(const void *, const void *);
@@ -308,6 +310,9 @@ EVP_PKEY_meth_copy(EVP_PKEY_METHOD *dst, const EVP_PKEY_METHOD *src)
 
 	dst->ctrl = src->ctrl;
 	dst->ctrl_str = src->ctrl_str;
+
+	dst->digestsign = src->digestsign;
+	dst->digestverify = src->digestverify;
 }
 
 void
@@ -0,0 +1,573 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Stitched AES-GCM for x86_64, processing 8 (AES-NI and PCLMULQDQ) or 16
+ * (VAES and VPCLMULQDQ) blocks per iteration. The AES rounds for one group
+ * of counter blocks are interleaved with the GHASH multiplications for a
+ * group of ciphertext blocks - the previous group when encrypting, and the
+ * same group when decrypting - so that every byte is only loaded once and
+ * the AES and carry-less multiplication units are kept busy together.
+ *
+ * GHASH works on byte reflected values, where a group of eight blocks is
+ * absorbed as X = (X + C[0]) * H^8 + C[1] * H^7 + ... + C[7] * H, with the
+ * products summed before a single reduction. The carry-less multiplication
+ * and reduction follow the Intel Carry-Less Multiplication Instruction and
+ * its Usage for Computing the GCM Mode white paper.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/aes.h>
+#include <openssl/crypto.h>
+
+#include "modes_lcl.h"
+
+#ifdef GCM128_X86_64
+
+#include <immintrin.h>
+
+#include "cryptlib.h"
+#include "x86_arch.h"
+
+/*
+ * AES-NI and PCLMULQDQ, eight blocks.
+ */
+
+#define GCM_ATTR	__attribute__((__target__("aes,pclmul,ssse3")))
+
+#define AESENC8(b, k) do {						\
+	(b)[0] = _mm_aesenc_si128((b)[0], (k));				\
+	(b)[1] = _mm_aesenc_si128((b)[1], (k));				\
+	(b)[2] = _mm_aesenc_si128((b)[2], (k));				\
+	(b)[3] = _mm_aesenc_si128((b)[3], (k));				\
+	(b)[4] = _mm_aesenc_si128((b)[4], (k));				\
+	(b)[5] = _mm_aesenc_si128((b)[5], (k));				\
+	(b)[6] = _mm_aesenc_si128((b)[6], (k));				\
+	(b)[7] = _mm_aesenc_si128((b)[7], (k));				\
+} while (0)
+
+#define AESENCLAST8(b, k) do {						\
+	(b)[0] = _mm_aesenclast_si128((b)[0], (k));			\
+	(b)[1] = _mm_aesenclast_si128((b)[1], (k));			\
+	(b)[2] = _mm_aesenclast_si128((b)[2], (k));			\
+	(b)[3] = _mm_aesenclast_si128((b)[3], (k));			\
+	(b)[4] = _mm_aesenclast_si128((b)[4], (k));			\
+	(b)[5] = _mm_aesenclast_si128((b)[5], (k));			\
+	(b)[6] = _mm_aesenclast_si128((b)[6], (k));			\
+	(b)[7] = _mm_aesenclast_si128((b)[7], (k));			\
+} while (0)
+
+static inline __m128i GCM_ATTR
+gcm_bswap(__m128i x)
+{
+	return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+	    8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+/* lo, mid, hi += x * h, without reduction. */
+static inline void GCM_ATTR
+gcm_mul_acc(__m128i x, __m128i h, __m128i *lo, __m128i *mid, __m128i *hi)
+{
+	*lo = _mm_xor_si128(*lo, _mm_clmulepi64_si128(x, h, 0x00));
+	*hi = _mm_xor_si128(*hi, _mm_clmulepi64_si128(x, h, 0x11));
+	*mid = _mm_xor_si128(*mid, _mm_xor_si128(
+	    _mm_clmulepi64_si128(x, h, 0x01),
+	    _mm_clmulepi64_si128(x, h, 0x10)));
+}
+
+/* Reduce the 256 bit product lo + mid * 2^64 + hi * 2^128. */
+static inline __m128i GCM_ATTR
+gcm_reduce(__m128i lo, __m128i mid, __m128i hi)
+{
+	__m128i t0, t1, t2;
+
+	lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+	hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+	/* The operands are reflected, so shift the product left by one bit. */
+	t0 = _mm_srli_epi32(lo, 31);
+	t1 = _mm_srli_epi32(hi, 31);
+	lo = _mm_slli_epi32(lo, 1);
+	hi = _mm_slli_epi32(hi, 1);
+	t2 = _mm_srli_si128(t0, 12);
+	t1 = _mm_slli_si128(t1, 4);
+	t0 = _mm_slli_si128(t0, 4);
+	lo = _mm_or_si128(lo, t0);
+	hi = _mm_or_si128(hi, t1);
+	hi = _mm_or_si128(hi, t2);
+
+	/* Reduce modulo x^128 + x^7 + x^2 + x + 1. */
+	t0 = _mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30));
+	t0 = _mm_xor_si128(t0, _mm_slli_epi32(lo, 25));
+	t1 = _mm_srli_si128(t0, 4);
+	lo = _mm_xor_si128(lo, _mm_slli_si128(t0, 12));
+	t2 = _mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2));
+	t2 = _mm_xor_si128(t2, _mm_srli_epi32(lo, 7));
+	t2 = _mm_xor_si128(t2, t1);
+	lo = _mm_xor_si128(lo, t2);
+
+	return _mm_xor_si128(hi, lo);
+}
+
+static inline __m128i GCM_ATTR
+gcm_mul(__m128i x, __m128i h)
+{
+	__m128i lo, mid, hi;
+
+	lo = mid = hi = _mm_setzero_si128();
+	gcm_mul_acc(x, h, &lo, &mid, &hi);
+
+	return gcm_reduce(lo, mid, hi);
+}
+
+void GCM_ATTR
+gcm_init_x86_64(u128 Htable[16], const u64 H[2])
+{
+	__m128i h, hn;
+	int i;
+
+	/* H is in host byte order, which is its byte reflected value. */
+	h = _mm_set_epi64x(H[0], H[1]);
+
+	hn = h;
+	for (i = 15; i >= 8; i--) {
+		_mm_storeu_si128((__m128i *)&Htable[i], hn);
+		hn = gcm_mul(hn, h);
+	}
+}
+
+/* Absorb the (reflected) blocks c[0] ... c[7] into x. */
+static inline __m128i GCM_ATTR
+gcm_ghash8(const __m128i c[8], const __m128i h[8], __m128i x)
+{
+	__m128i lo, mid, hi;
+	int i;
+
+	lo = mid = hi = _mm_setzero_si128();
+	gcm_mul_acc(_mm_xor_si128(c[0], x), h[0], &lo, &mid, &hi);
+	for (i = 1; i < 8; i++)
+		gcm_mul_acc(c[i], h[i], &lo, &mid, &hi);
+
+	return gcm_reduce(lo, mid, hi);
+}
+
+static inline void GCM_ATTR
+aesni_gcm_load_key(__m128i rk[15], const void *key, int *rounds)
+{
+	const AES_KEY *aes_key = key;
+	int i;
+
+	/* The AES-NI key schedule stores the number of rounds minus one. */
+	*rounds = aes_key->rounds;
+	for (i = 0; i <= *rounds + 1; i++)
+		rk[i] = _mm_loadu_si128((const __m128i *)aes_key->rd_key + i);
+}
+
+/* Set up eight counter blocks for the first round. */
+static inline void GCM_ATTR
+aesni_gcm_ctr8(__m128i b[8], __m128i ctr, __m128i rk0)
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		b[i] = _mm_xor_si128(gcm_bswap(_mm_add_epi32(ctr,
+		    _mm_set_epi32(0, 0, 0, i))), rk0);
+}
+
+/*
+ * Run the AES rounds for eight counter blocks, while absorbing the
+ * (reflected) blocks c[0] ... c[7] into the GHASH state x.
+ */
+static inline __m128i GCM_ATTR
+aesni_gcm_rounds8(__m128i b[8], const __m128i rk[15], int rounds,
+    const __m128i c[8], const __m128i h[8], __m128i x)
+{
+	__m128i lo, mid, hi;
+	int r;
+
+	lo = mid = hi = _mm_setzero_si128();
+
+	AESENC8(b, rk[1]);
+	gcm_mul_acc(_mm_xor_si128(c[0], x), h[0], &lo, &mid, &hi);
+	AESENC8(b, rk[2]);
+	gcm_mul_acc(c[1], h[1], &lo, &mid, &hi);
+	AESENC8(b, rk[3]);
+	gcm_mul_acc(c[2], h[2], &lo, &mid, &hi);
+	AESENC8(b, rk[4]);
+	gcm_mul_acc(c[3], h[3], &lo, &mid, &hi);
+	AESENC8(b, rk[5]);
+	gcm_mul_acc(c[4], h[4], &lo, &mid, &hi);
+	AESENC8(b, rk[6]);
+	gcm_mul_acc(c[5], h[5], &lo, &mid, &hi);
+	AESENC8(b, rk[7]);
+	gcm_mul_acc(c[6], h[6], &lo, &mid, &hi);
+	AESENC8(b, rk[8]);
+	gcm_mul_acc(c[7], h[7], &lo, &mid, &hi);
+	for (r = 9; r <= rounds; r++)
+		AESENC8(b, rk[r]);
+	x = gcm_reduce(lo, mid, hi);
+	AESENCLAST8(b, rk[rounds + 1]);
+
+	return x;
+}
+
+static size_t GCM_ATTR
+aesni_gcm_encrypt_8x(const u8 *in, u8 *out, size_t blocks, const void *key,
+    const u8 ivec[16], u64 Xi[2], const u128 Htable[16])
+{
+	__m128i rk[15], h[8], b[8], c[8], ctr, x;
+	const __m128i eight = _mm_set_epi32(0, 0, 0, 8);
+	size_t done;
+	int rounds, i;
+
+	aesni_gcm_load_key(rk, key, &rounds);
+	for (i = 0; i < 8; i++)
+		h[i] = _mm_loadu_si128((const __m128i *)&Htable[8 + i]);
+	ctr = gcm_bswap(_mm_loadu_si128((const __m128i *)ivec));
+	x = gcm_bswap(_mm_loadu_si128((const __m128i *)Xi));
+
+	/* The first group has no preceding ciphertext to hash. */
+	aesni_gcm_ctr8(b, ctr, rk[0]);
+	ctr = _mm_add_epi32(ctr, eight);
+	for (i = 1; i <= rounds; i++)
+		AESENC8(b, rk[i]);
+	AESENCLAST8(b, rk[rounds + 1]);
+	for (i = 0; i < 8; i++) {
+		b[i] = _mm_xor_si128(b[i],
+		    _mm_loadu_si128((const __m128i *)in + i));
+		_mm_storeu_si128((__m128i *)out + i, b[i]);
+		c[i] = gcm_bswap(b[i]);
+	}
+
+	for (done = 8; blocks - done >= 8; done += 8) {
+		in += 8 * 16;
+		out += 8 * 16;
+
+		aesni_gcm_ctr8(b, ctr, rk[0]);
+		ctr = _mm_add_epi32(ctr, eight);
+		x = aesni_gcm_rounds8(b, rk, rounds, c, h, x);
+		for (i = 0; i < 8; i++) {
+			b[i] = _mm_xor_si128(b[i],
+			    _mm_loadu_si128((const __m128i *)in + i));
+			_mm_storeu_si128((__m128i *)out + i, b[i]);
+			c[i] = gcm_bswap(b[i]);
+		}
+	}
+
+	/* Hash the last group. */
+	x = gcm_ghash8(c, h, x);
+	_mm_storeu_si128((__m128i *)Xi, gcm_bswap(x));
+
+	return done;
+}
+
+static size_t GCM_ATTR
+aesni_gcm_decrypt_8x(const u8 *in, u8 *out, size_t blocks, const void *key,
+    const u8 ivec[16], u64 Xi[2], const u128 Htable[16])
+{
+	__m128i rk[15], h[8], b[8], c[8], ctr, x;
+	const __m128i eight = _mm_set_epi32(0, 0, 0, 8);
+	size_t done;
+	int rounds, i;
+
+	aesni_gcm_load_key(rk, key, &rounds);
+	for (i = 0; i < 8; i++)
+		h[i] = _mm_loadu_si128((const __m128i *)&Htable[8 + i]);
+	ctr = gcm_bswap(_mm_loadu_si128((const __m128i *)ivec));
+	x = gcm_bswap(_mm_loadu_si128((const __m128i *)Xi));
+
+	for (done = 0; blocks - done >= 8; done += 8) {
+		for (i = 0; i < 8; i++)
+			c[i] = _mm_loadu_si128((const __m128i *)in + i);
+		aesni_gcm_ctr8(b, ctr, rk[0]);
+		ctr = _mm_add_epi32(ctr, eight);
+		for (i = 0; i < 8; i++)
+			c[i] = gcm_bswap(c[i]);
+		x = aesni_gcm_rounds8(b, rk, rounds, c, h, x);
+		for (i = 0; i < 8; i++)
+			_mm_storeu_si128((__m128i *)out + i,
+			    _mm_xor_si128(b[i], gcm_bswap(c[i])));
+
+		in += 8 * 16;
+		out += 8 * 16;
+	}
+	_mm_storeu_si128((__m128i *)Xi, gcm_bswap(x));
+
+	return done;
+}
+
+/*
+ * VAES and VPCLMULQDQ, sixteen blocks in four vectors of four blocks. The
+ * GHASH is computed as two aggregated groups of eight blocks, so that the
+ * same H^8 ... H^1 table serves both implementations.
+ */
+
+#define VAES_ATTR \
+	__attribute__((__target__("avx512f,avx512bw,vaes,vpclmulqdq,aes,pclmul")))
+
+#define VAESENC4(b, k) do {						\
+	(b)[0] = _mm512_aesenc_epi128((b)[0], (k));			\
+	(b)[1] = _mm512_aesenc_epi128((b)[1], (k));			\
+	(b)[2] = _mm512_aesenc_epi128((b)[2], (k));			\
+	(b)[3] = _mm512_aesenc_epi128((b)[3], (k));			\
+} while (0)
+
+#define VAESENCLAST4(b, k) do {						\
+	(b)[0] = _mm512_aesenclast_epi128((b)[0], (k));			\
+	(b)[1] = _mm512_aesenclast_epi128((b)[1], (k));			\
+	(b)[2] = _mm512_aesenclast_epi128((b)[2], (k));			\
+	(b)[3] = _mm512_aesenclast_epi128((b)[3], (k));			\
+} while (0)
+
+static inline __m512i VAES_ATTR
+gcm_bswap_vaes(__m512i x)
+{
+	return _mm512_shuffle_epi8(x, _mm512_broadcast_i32x4(
+	    _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+}
+
+static inline void VAES_ATTR
+gcm_mul_acc_vaes(__m512i x, __m512i h, __m512i *lo, __m512i *mid,
+    __m512i *hi)
+{
+	*lo = _mm512_xor_si512(*lo, _mm512_clmulepi64_epi128(x, h, 0x00));
+	*hi = _mm512_xor_si512(*hi, _mm512_clmulepi64_epi128(x, h, 0x11));
+	*mid = _mm512_xor_si512(*mid, _mm512_xor_si512(
+	    _mm512_clmulepi64_epi128(x, h, 0x01),
+	    _mm512_clmulepi64_epi128(x, h, 0x10)));
+}
+
+static inline __m128i VAES_ATTR
+gcm_xor_lanes_vaes(__m512i x)
+{
+	return _mm_xor_si128(
+	    _mm_xor_si128(_mm512_extracti32x4_epi32(x, 0),
+	    _mm512_extracti32x4_epi32(x, 1)),
+	    _mm_xor_si128(_mm512_extracti32x4_epi32(x, 2),
+	    _mm512_extracti32x4_epi32(x, 3)));
+}
+
+/* Absorb the (reflected) eight blocks in c0 and c1 into x. */
+static inline __m128i VAES_ATTR
+gcm_ghash8_vaes(__m512i c0, __m512i c1, const __m512i h[2], __m128i x)
+{
+	__m512i lo, mid, hi;
+
+	lo = mid = hi = _mm512_setzero_si512();
+	c0 = _mm512_xor_si512(c0,
+	    _mm512_inserti32x4(_mm512_setzero_si512(), x, 0));
+	gcm_mul_acc_vaes(c0, h[0], &lo, &mid, &hi);
+	gcm_mul_acc_vaes(c1, h[1], &lo, &mid, &hi);
+
+	return gcm_reduce(gcm_xor_lanes_vaes(lo), gcm_xor_lanes_vaes(mid),
+	    gcm_xor_lanes_vaes(hi));
+}
+
+/* Set up sixteen counter blocks for the first round. */
+static inline void VAES_ATTR
+aesni_gcm_ctr16_vaes(__m512i b[4], __m128i ctr, __m512i rk0)
+{
+	const __m512i four = _mm512_set_epi32(0, 0, 0, 4, 0, 0, 0, 4,
+	    0, 0, 0, 4, 0, 0, 0, 4);
+	__m512i c;
+	int i;
+
+	c = _mm512_add_epi32(_mm512_broadcast_i32x4(ctr),
+	    _mm512_set_epi32(0, 0, 0, 3, 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 0));
+	for (i = 0; i < 4; i++) {
+		b[i] = _mm512_xor_si512(gcm_bswap_vaes(c), rk0);
+		c = _mm512_add_epi32(c, four);
+	}
+}
+
+/*
+ * Run the AES rounds for sixteen counter blocks, while absorbing the
+ * (reflected) blocks c[0] ... c[3] into the GHASH state x.
+ */
+static inline __m128i VAES_ATTR
+aesni_gcm_rounds16_vaes(__m512i b[4], const __m512i rk[15], int rounds,
+    const __m512i c[4], const __m512i h[2], __m128i x)
+{
+	int r;
+
+	VAESENC4(b, rk[1]);
+	VAESENC4(b, rk[2]);
+	x = gcm_ghash8_vaes(c[0], c[1], h, x);
+	VAESENC4(b, rk[3]);
+	VAESENC4(b, rk[4]);
+	VAESENC4(b, rk[5]);
+	x = gcm_ghash8_vaes(c[2], c[3], h, x);
+	for (r = 6; r <= rounds; r++)
+		VAESENC4(b, rk[r]);
+	VAESENCLAST4(b, rk[rounds + 1]);
+
+	return x;
+}
+
+static inline void VAES_ATTR
+aesni_gcm_load_key_vaes(__m512i rk[15], const void *key, int *rounds)
+{
+	const AES_KEY *aes_key = key;
+	int i;
+
+	*rounds = aes_key->rounds;
+	for (i = 0; i <= *rounds + 1; i++)
+		rk[i] = _mm512_broadcast_i32x4(
+		    _mm_loadu_si128((const __m128i *)aes_key->rd_key + i));
+}
+
+static size_t VAES_ATTR
+aesni_gcm_encrypt_16x_vaes(const u8 *in, u8 *out, size_t blocks,
+    const void *key, const u8 ivec[16], u64 Xi[2], const u128 Htable[16])
+{
+	__m512i rk[15], h[2], b[4], c[4];
+	const __m128i sixteen = _mm_set_epi32(0, 0, 0, 16);
+	__m128i ctr, x;
+	size_t done;
+	int rounds, i;
+
+	aesni_gcm_load_key_vaes(rk, key, &rounds);
+	h[0] = _mm512_loadu_si512((const void *)&Htable[8]);
+	h[1] = _mm512_loadu_si512((const void *)&Htable[12]);
+	ctr = gcm_bswap(_mm_loadu_si128((const __m128i *)ivec));
+	x = gcm_bswap(_mm_loadu_si128((const __m128i *)Xi));
+
+	/* The first group has no preceding ciphertext to hash. */
+	aesni_gcm_ctr16_vaes(b, ctr, rk[0]);
+	ctr = _mm_add_epi32(ctr, sixteen);
+	for (i = 1; i <= rounds; i++)
+		VAESENC4(b, rk[i]);
+	VAESENCLAST4(b, rk[rounds + 1]);
+	for (i = 0; i < 4; i++) {
+		b[i] = _mm512_xor_si512(b[i],
+		    _mm512_loadu_si512((const void *)(in + 64 * i)));
+		_mm512_storeu_si512((void *)(out + 64 * i), b[i]);
+		c[i] = gcm_bswap_vaes(b[i]);
+	}
+
+	for (done = 16; blocks - done >= 16; done += 16) {
+		in += 16 * 16;
+		out += 16 * 16;
+
+		aesni_gcm_ctr16_vaes(b, ctr, rk[0]);
+		ctr = _mm_add_epi32(ctr, sixteen);
+		x = aesni_gcm_rounds16_vaes(b, rk, rounds, c, h, x);
+		for (i = 0; i < 4; i++) {
+			b[i] = _mm512_xor_si512(b[i],
+			    _mm512_loadu_si512((const void *)(in + 64 * i)));
+			_mm512_storeu_si512((void *)(out + 64 * i), b[i]);
+			c[i] = gcm_bswap_vaes(b[i]);
+		}
+	}
+
+	/* Hash the last group. */
+	x = gcm_ghash8_vaes(c[0], c[1], h, x);
+	x = gcm_ghash8_vaes(c[2], c[3], h, x);
+	_mm_storeu_si128((__m128i *)Xi, gcm_bswap(x));
+
+	return done;
+}
+
+static size_t VAES_ATTR
+aesni_gcm_decrypt_16x_vaes(const u8 *in, u8 *out, size_t blocks,
+    const void *key, const u8 ivec[16], u64 Xi[2], const u128 Htable[16])
+{
+	__m512i rk[15], h[2], b[4], c[4];
+	const __m128i sixteen = _mm_set_epi32(0, 0, 0, 16);
+	__m128i ctr, x;
+	size_t done;
+	int rounds, i;
+
+	aesni_gcm_load_key_vaes(rk, key, &rounds);
+	h[0] = _mm512_loadu_si512((const void *)&Htable[8]);
+	h[1] = _mm512_loadu_si512((const void *)&Htable[12]);
+	ctr = gcm_bswap(_mm_loadu_si128((const __m128i *)ivec));
+	x = gcm_bswap(_mm_loadu_si128((const __m128i *)Xi));
+
+	for (done = 0; blocks - done >= 16; done += 16) {
+		for (i = 0; i < 4; i++)
+			c[i] = _mm512_loadu_si512((const void *)(in + 64 * i));
+		aesni_gcm_ctr16_vaes(b, ctr, rk[0]);
+		ctr = _mm_add_epi32(ctr, sixteen);
+		for (i = 0; i < 4; i++)
+			c[i] = gcm_bswap_vaes(c[i]);
+		x = aesni_gcm_rounds16_vaes(b, rk, rounds, c, h, x);
+		for (i = 0; i < 4; i++)
+			_mm512_storeu_si512((void *)(out + 64 * i),
+			    _mm512_xor_si512(b[i], gcm_bswap_vaes(c[i])));
+
+		in += 16 * 16;
+		out += 16 * 16;
+	}
+	_mm_storeu_si128((__m128i *)Xi, gcm_bswap(x));
+
+	return done;
+}
+
+#define GCM_VAES_CAPS	(CPUCAP_EXT_MASK_AVX512F | CPUCAP_EXT_MASK_AVX512BW | \
+	CPUCAP_EXT_MASK_VAES | CPUCAP_EXT_MASK_VPCLMULQDQ)
+
+typedef size_t (*aesni_gcm_f)(const u8 *in, u8 *out, size_t blocks,
+    const void *key, const u8 ivec[16], u64 Xi[2], const u128 Htable[16]);
+
+static size_t
+aesni_gcm_x86_64(aesni_gcm_f gcm_16x, aesni_gcm_f gcm_8x, const u8 *in,
+    u8 *out, size_t blocks, const void *key, const u8 ivec[16], u64 Xi[2],
+    const u128 Htable[16])
+{
+	u8 iv[16];
+	size_t done, n;
+	u32 ctr;
+
+	if ((OPENSSL_cpu_caps() & CPUCAP_MASK_SSSE3) == 0)
+		return 0;
+
+	memcpy(iv, ivec, sizeof(iv));
+
+	done = 0;
+	if ((OPENSSL_cpu_caps_ext() & GCM_VAES_CAPS) == GCM_VAES_CAPS &&
+	    blocks >= 16) {
+		done = gcm_16x(in, out, blocks, key, iv, Xi, Htable);
+		ctr = GETU32(iv + 12) + (u32)done;
+		PUTU32(iv + 12, ctr);
+	}
+	if (blocks - done >= 8) {
+		n = gcm_8x(in + done * 16, out + done * 16, blocks - done, key,
+		    iv, Xi, Htable);
+		done += n;
+	}
+
+	return done;
+}
+
+size_t
+aesni_gcm_encrypt_x86_64(const u8 *in, u8 *out, size_t blocks,
+    const void *key, const u8 ivec[16], u64 Xi[2], const u128 Htable[16])
+{
+	return aesni_gcm_x86_64(aesni_gcm_encrypt_16x_vaes,
+	    aesni_gcm_encrypt_8x, in, out, blocks, key, ivec, Xi, Htable);
+}
+
+size_t
+aesni_gcm_decrypt_x86_64(const u8 *in, u8 *out, size_t blocks,
+    const void *key, const u8 ivec[16], u64 Xi[2], const u128 Htable[16])
+{
+	return aesni_gcm_x86_64(aesni_gcm_decrypt_16x_vaes,
+	    aesni_gcm_decrypt_8x, in, out, blocks, key, ivec, Xi, Htable);
+}
+
+#endif /* GCM128_X86_64 */
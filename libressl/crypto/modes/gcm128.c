@@ -670,6 +670,19 @@ void gcm_ghash_neon(u64 Xi[2],const u128 Htable[16],const u8 *inp,size_t len);
 # endif
 #endif
 
+#ifdef GCM128_X86_64
+void aesni_ctr32_encrypt_blocks(const unsigned char *in, unsigned char *out,
+    size_t blocks, const void *key, const unsigned char *ivec);
+
+/*
+ * Use the stitched implementation for AES-NI keys with PCLMULQDQ GHASH.
+ * It only handles runs of eight or more blocks, so shorter inputs skip it.
+ */
+# define GCM_STITCHED(ctx,stream) \
+	((stream) == (ctr128_f)aesni_ctr32_encrypt_blocks && \
+	 (ctx)->gmult == gcm_gmult_clmul)
+#endif
+
 #ifdef GCM_FUNCREF_4BIT
 # undef  GCM_MUL
 # define GCM_MUL(ctx,Xi)	(*gcm_gmult_p)(ctx->Xi.u,ctx->Htable)
@@ -711,6 +724,9 @@ void CRYPTO_gcm128_init(GCM128_CONTEXT *ctx,void *key,block128_f block)
 	if ((OPENSSL_cpu_caps() & (CPUCAP_MASK_FXSR | CPUCAP_MASK_PCLMUL)) ==
 	    (CPUCAP_MASK_FXSR | CPUCAP_MASK_PCLMUL)) {
 		gcm_init_clmul(ctx->Htable,ctx->H.u);
+#  ifdef GCM128_X86_64
+		gcm_init_x86_64(ctx->Htable,ctx->H.u);
+#  endif
 		ctx->gmult = gcm_gmult_clmul;
 		ctx->ghash = gcm_ghash_clmul;
 		return;
@@ -1305,6 +1321,18 @@ int CRYPTO_gcm128_encrypt_ctr32(GCM128_CONTEXT *ctx,
 			return 0;
 		}
 	}
+#ifdef GCM128_X86_64
+	if (GCM_STITCHED(ctx,stream) && len>=128) {
+		size_t j = aesni_gcm_encrypt_x86_64(in,out,len/16,key,
+		    ctx->Yi.c,ctx->Xi.u,ctx->Htable);
+
+		ctr += (unsigned int)j;
+		PUTU32(ctx->Yi.c+12,ctr);
+		in  += j*16;
+		out += j*16;
+		len -= j*16;
+	}
+#endif
 #if defined(GHASH) && !defined(OPENSSL_SMALL_FOOTPRINT)
 	while (len>=GHASH_CHUNK) {
 		(*stream)(in,out,GHASH_CHUNK/16,key,ctx->Yi.c);
@@ -1425,6 +1453,18 @@ int CRYPTO_gcm128_decrypt_ctr32(GCM128_CONTEXT *ctx,
 			return 0;
 		}
 	}
+#ifdef GCM128_X86_64
+	if (GCM_STITCHED(ctx,stream) && len>=128) {
+		size_t j = aesni_gcm_decrypt_x86_64(in,out,len/16,key,
+		    ctx->Yi.c,ctx->Xi.u,ctx->Htable);
+
+		ctr += (unsigned int)j;
+		PUTU32(ctx->Yi.c+12,ctr);
+		in  += j*16;
+		out += j*16;
+		len -= j*16;
+	}
+#endif
 #if defined(GHASH) && !defined(OPENSSL_SMALL_FOOTPRINT)
 	while (len>=GHASH_CHUNK) {
 		GHASH(ctx,in,GHASH_CHUNK);
@@ -98,6 +98,34 @@ struct gcm128_context {
 	void *key;
 };
 
+#if TABLE_BITS==4 && defined(GHASH_ASM) && defined(AES_ASM) && \
+    defined(__x86_64__) && defined(__GNUC__) && \
+    defined(OPENSSL_CPUID_OBJ) && !defined(OPENSSL_NO_ASM)
+#define GCM128_X86_64
+
+/*
+ * Stitched AES-GCM for x86_64, which interleaves AES-NI (or VAES) counter
+ * mode with an aggregated PCLMULQDQ GHASH of the same data. It is used by
+ * CRYPTO_gcm128_{en,de}crypt_ctr32() for AES-NI key schedules, when the
+ * GHASH uses the PCLMULQDQ implementation - gcm_init_clmul() only fills the
+ * first two Htable entries, and gcm_init_x86_64() stores H^8 ... H^1 in
+ * Htable[8] ... Htable[15].
+ */
+void gcm_init_x86_64(u128 Htable[16], const u64 H[2]);
+
+/*
+ * Encrypt or decrypt as many of the given 16 byte blocks as the stitched
+ * implementations can handle, starting with the counter block ivec and
+ * updating the GHASH in Xi. Returns the number of blocks processed, which
+ * may be zero. Like ctr128_f, only the low 32 bits of the counter are
+ * incremented.
+ */
+size_t aesni_gcm_encrypt_x86_64(const u8 *in, u8 *out, size_t blocks,
+    const void *key, const u8 ivec[16], u64 Xi[2], const u128 Htable[16]);
+size_t aesni_gcm_decrypt_x86_64(const u8 *in, u8 *out, size_t blocks,
+    const void *key, const u8 ivec[16], u64 Xi[2], const u128 Htable[16]);
+#endif
+
 struct xts128_context {
 	void      *key1, *key2;
 	block128_f block1,block2;
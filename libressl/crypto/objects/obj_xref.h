@@ -44,6 +44,7 @@ static const nid_triple sigoid_srt[] =
 	{NID_rsassaPss, NID_undef, NID_rsaEncryption},
 	{NID_id_tc26_signwithdigest_gost3410_2012_256, NID_id_tc26_gost3411_2012_256, NID_id_GostR3410_2001},
 	{NID_id_tc26_signwithdigest_gost3410_2012_512, NID_id_tc26_gost3411_2012_512, NID_id_GostR3410_2001},
+	{NID_Ed25519, NID_undef, NID_Ed25519},
 	};
 
 static const nid_triple * const sigoid_srt_xref[] =
@@ -51,6 +52,7 @@ static const nid_triple * const sigoid_srt_xref[] =
 	&sigoid_srt[29],
 	&sigoid_srt[17],
 	&sigoid_srt[18],
+	&sigoid_srt[32],
 	&sigoid_srt[0],
 	&sigoid_srt[1],
 	&sigoid_srt[7],
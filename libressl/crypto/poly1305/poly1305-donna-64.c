@@ -0,0 +1,339 @@
+/* $OpenBSD$ */
+/*
+ * Public Domain poly1305 from Andrew Moon
+ * Based on poly1305-donna.c, poly1305-donna-64.h and poly1305-donna.h from:
+ *   https://github.com/floodyberry/poly1305-donna
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "poly1305_internal.h"
+
+static inline void poly1305_init(poly1305_context *ctx,
+    const unsigned char key[32]);
+static inline void poly1305_update(poly1305_context *ctx,
+    const unsigned char *m, size_t bytes);
+static inline void poly1305_finish(poly1305_context *ctx,
+    unsigned char mac[16]);
+
+/*
+ * poly1305 implementation using 64 bit * 64 bit = 128 bit multiplication
+ * and 128 bit addition, with h and r held in three limbs of 44, 44 and 42
+ * bits.
+ */
+
+#define poly1305_block_size 16
+
+/*
+ * Hand runs of at least this many blocks to the SIMD implementations, which
+ * need the powers of r to be computed first.
+ */
+#define poly1305_simd_blocks 32
+
+typedef unsigned __int128 uint128_t;
+
+/* 17 + sizeof(size_t) + 8*sizeof(uint64_t) */
+typedef struct poly1305_state_internal_t {
+	uint64_t r[3];
+	uint64_t h[3];
+	uint64_t pad[2];
+	size_t leftover;
+	unsigned char buffer[poly1305_block_size];
+	unsigned char final;
+} poly1305_state_internal_t;
+
+/* interpret eight 8 bit unsigned integers as a 64 bit unsigned integer in little endian */
+static uint64_t
+U8TO64(const unsigned char *p)
+{
+	return (((uint64_t)(p[0] & 0xff)) |
+	    ((uint64_t)(p[1] & 0xff) <<  8) |
+	    ((uint64_t)(p[2] & 0xff) << 16) |
+	    ((uint64_t)(p[3] & 0xff) << 24) |
+	    ((uint64_t)(p[4] & 0xff) << 32) |
+	    ((uint64_t)(p[5] & 0xff) << 40) |
+	    ((uint64_t)(p[6] & 0xff) << 48) |
+	    ((uint64_t)(p[7] & 0xff) << 56));
+}
+
+/* store a 64 bit unsigned integer as eight 8 bit unsigned integers in little endian */
+static void
+U64TO8(unsigned char *p, uint64_t v)
+{
+	p[0] = (v) & 0xff;
+	p[1] = (v >>  8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+	p[4] = (v >> 32) & 0xff;
+	p[5] = (v >> 40) & 0xff;
+	p[6] = (v >> 48) & 0xff;
+	p[7] = (v >> 56) & 0xff;
+}
+
+/* h = (h * r) % p, partially reduced */
+static inline void
+poly1305_mul(uint64_t h[3], const uint64_t r[3])
+{
+	uint64_t h0, h1, h2, s1, s2, c;
+	uint128_t d0, d1, d2;
+
+	h0 = h[0];
+	h1 = h[1];
+	h2 = h[2];
+
+	s1 = r[1] * (5 << 2);
+	s2 = r[2] * (5 << 2);
+
+	d0 = ((uint128_t)h0 * r[0]) + ((uint128_t)h1 * s2) +
+	    ((uint128_t)h2 * s1);
+	d1 = ((uint128_t)h0 * r[1]) + ((uint128_t)h1 * r[0]) +
+	    ((uint128_t)h2 * s2);
+	d2 = ((uint128_t)h0 * r[2]) + ((uint128_t)h1 * r[1]) +
+	    ((uint128_t)h2 * r[0]);
+
+	c = (uint64_t)(d0 >> 44);
+	h0 = (uint64_t)d0 & 0xfffffffffff;
+	d1 += c;
+	c = (uint64_t)(d1 >> 44);
+	h1 = (uint64_t)d1 & 0xfffffffffff;
+	d2 += c;
+	c = (uint64_t)(d2 >> 42);
+	h2 = (uint64_t)d2 & 0x3ffffffffff;
+	h0 += c * 5;
+	c = (h0 >> 44);
+	h0 = h0 & 0xfffffffffff;
+	h1 += c;
+
+	h[0] = h0;
+	h[1] = h1;
+	h[2] = h2;
+}
+
+static inline void
+poly1305_init(poly1305_context *ctx, const unsigned char key[32])
+{
+	poly1305_state_internal_t *st = (poly1305_state_internal_t *)ctx;
+	uint64_t t0, t1;
+
+	/* r &= 0xffffffc0ffffffc0ffffffc0fffffff */
+	t0 = U8TO64(&key[0]);
+	t1 = U8TO64(&key[8]);
+
+	st->r[0] = (t0) & 0xffc0fffffff;
+	st->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+	st->r[2] = ((t1 >> 24)) & 0x00ffffffc0f;
+
+	/* h = 0 */
+	st->h[0] = 0;
+	st->h[1] = 0;
+	st->h[2] = 0;
+
+	/* save pad for later */
+	st->pad[0] = U8TO64(&key[16]);
+	st->pad[1] = U8TO64(&key[24]);
+
+	st->leftover = 0;
+	st->final = 0;
+}
+
+static void
+poly1305_blocks(poly1305_state_internal_t *st, const unsigned char *m, size_t bytes)
+{
+	const uint64_t hibit = (st->final) ? 0 : ((uint64_t)1 << 40); /* 1 << 128 */
+	uint64_t h[3];
+	uint64_t t0, t1;
+
+	h[0] = st->h[0];
+	h[1] = st->h[1];
+	h[2] = st->h[2];
+
+	while (bytes >= poly1305_block_size) {
+		t0 = U8TO64(&m[0]);
+		t1 = U8TO64(&m[8]);
+
+		/* h += m[i] */
+		h[0] += ((t0) & 0xfffffffffff);
+		h[1] += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff);
+		h[2] += (((t1 >> 24)) & 0x3ffffffffff) | hibit;
+
+		/* h *= r, (partial) h %= p */
+		poly1305_mul(h, st->r);
+
+		m += poly1305_block_size;
+		bytes -= poly1305_block_size;
+	}
+
+	st->h[0] = h[0];
+	st->h[1] = h[1];
+	st->h[2] = h[2];
+}
+
+#ifdef POLY1305_X86_64
+/*
+ * Process a run of full blocks with the SIMD implementations, leaving any
+ * blocks they do not handle to poly1305_blocks().
+ */
+static size_t
+poly1305_blocks_simd(poly1305_state_internal_t *st, const unsigned char *m,
+    size_t bytes)
+{
+	uint64_t rpow[POLY1305_X86_64_POWERS][3];
+	size_t i;
+
+	if (bytes < poly1305_simd_blocks * poly1305_block_size ||
+	    !poly1305_x86_64_available())
+		return 0;
+
+	/* rpow[i] = r^(i + 1) */
+	rpow[0][0] = st->r[0];
+	rpow[0][1] = st->r[1];
+	rpow[0][2] = st->r[2];
+	for (i = 1; i < POLY1305_X86_64_POWERS; i++) {
+		rpow[i][0] = rpow[i - 1][0];
+		rpow[i][1] = rpow[i - 1][1];
+		rpow[i][2] = rpow[i - 1][2];
+		poly1305_mul(rpow[i], st->r);
+	}
+
+	return poly1305_blocks_x86_64(st->h, rpow, m,
+	    bytes / poly1305_block_size) * poly1305_block_size;
+}
+#endif
+
+static inline void
+poly1305_update(poly1305_context *ctx, const unsigned char *m, size_t bytes)
+{
+	poly1305_state_internal_t *st = (poly1305_state_internal_t *)ctx;
+	size_t i;
+
+	/* handle leftover */
+	if (st->leftover) {
+		size_t want = (poly1305_block_size - st->leftover);
+		if (want > bytes)
+			want = bytes;
+		for (i = 0; i < want; i++)
+			st->buffer[st->leftover + i] = m[i];
+		bytes -= want;
+		m += want;
+		st->leftover += want;
+		if (st->leftover < poly1305_block_size)
+			return;
+		poly1305_blocks(st, st->buffer, poly1305_block_size);
+		st->leftover = 0;
+	}
+
+	/* process full blocks */
+	if (bytes >= poly1305_block_size) {
+		size_t want = (bytes & ~(poly1305_block_size - 1));
+#ifdef POLY1305_X86_64
+		size_t done = poly1305_blocks_simd(st, m, want);
+		m += done;
+		bytes -= done;
+		want -= done;
+#endif
+		poly1305_blocks(st, m, want);
+		m += want;
+		bytes -= want;
+	}
+
+	/* store leftover */
+	if (bytes) {
+		for (i = 0; i < bytes; i++)
+			st->buffer[st->leftover + i] = m[i];
+		st->leftover += bytes;
+	}
+}
+
+static inline void
+poly1305_finish(poly1305_context *ctx, unsigned char mac[16])
+{
+	poly1305_state_internal_t *st = (poly1305_state_internal_t *)ctx;
+	uint64_t h0, h1, h2, c;
+	uint64_t g0, g1, g2;
+	uint64_t t0, t1;
+	uint64_t mask;
+
+	/* process the remaining block */
+	if (st->leftover) {
+		size_t i = st->leftover;
+		st->buffer[i++] = 1;
+		for (; i < poly1305_block_size; i++)
+			st->buffer[i] = 0;
+		st->final = 1;
+		poly1305_blocks(st, st->buffer, poly1305_block_size);
+	}
+
+	/* fully carry h */
+	h0 = st->h[0];
+	h1 = st->h[1];
+	h2 = st->h[2];
+
+	c = (h1 >> 44);
+	h1 &= 0xfffffffffff;
+	h2 += c;
+	c = (h2 >> 42);
+	h2 &= 0x3ffffffffff;
+	h0 += c * 5;
+	c = (h0 >> 44);
+	h0 &= 0xfffffffffff;
+	h1 += c;
+	c = (h1 >> 44);
+	h1 &= 0xfffffffffff;
+	h2 += c;
+	c = (h2 >> 42);
+	h2 &= 0x3ffffffffff;
+	h0 += c * 5;
+	c = (h0 >> 44);
+	h0 &= 0xfffffffffff;
+	h1 += c;
+
+	/* compute h + -p */
+	g0 = h0 + 5;
+	c = (g0 >> 44);
+	g0 &= 0xfffffffffff;
+	g1 = h1 + c;
+	c = (g1 >> 44);
+	g1 &= 0xfffffffffff;
+	g2 = h2 + c - ((uint64_t)1 << 42);
+
+	/* select h if h < p, or h + -p if h >= p */
+	mask = (g2 >> ((sizeof(uint64_t) * 8) - 1)) - 1;
+	g0 &= mask;
+	g1 &= mask;
+	g2 &= mask;
+	mask = ~mask;
+	h0 = (h0 & mask) | g0;
+	h1 = (h1 & mask) | g1;
+	h2 = (h2 & mask) | g2;
+
+	/* h = (h + pad) */
+	t0 = st->pad[0];
+	t1 = st->pad[1];
+
+	h0 += ((t0) & 0xfffffffffff);
+	c = (h0 >> 44);
+	h0 &= 0xfffffffffff;
+	h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff) + c;
+	c = (h1 >> 44);
+	h1 &= 0xfffffffffff;
+	h2 += (((t1 >> 24)) & 0x3ffffffffff) + c;
+	h2 &= 0x3ffffffffff;
+
+	/* mac = h % (2^128) */
+	h0 = ((h0) | (h1 << 44));
+	h1 = ((h1 >> 20) | (h2 << 24));
+
+	U64TO8(&mac[0], h0);
+	U64TO8(&mac[8], h1);
+
+	/* zero out the state */
+	st->h[0] = 0;
+	st->h[1] = 0;
+	st->h[2] = 0;
+	st->r[0] = 0;
+	st->r[1] = 0;
+	st->r[2] = 0;
+	st->pad[0] = 0;
+	st->pad[1] = 0;
+}
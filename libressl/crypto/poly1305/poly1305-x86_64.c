@@ -0,0 +1,385 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Multi-block Poly1305 for x86_64, absorbing 4 (AVX2) or 8 (AVX-512) blocks
+ * per iteration. Lane j of each vector accumulates blocks j, j + n, j + 2n
+ * and so on, so that every iteration computes h = (h + m) * r^n for all
+ * lanes at once. The last iteration multiplies the lanes by r^n ... r^1
+ * instead, after which the sum of the lanes is the same value the scalar
+ * implementation would have computed. The vectors hold five 26 bit limbs in
+ * 64 bit lanes, which keeps all products within 32 x 32 = 64 bit
+ * multiplications.
+ */
+
+#include <stdint.h>
+
+#include <openssl/crypto.h>
+
+#include "poly1305_internal.h"
+
+#ifdef POLY1305_X86_64
+
+#include <immintrin.h>
+
+#include "cryptlib.h"
+#include "x86_arch.h"
+
+/* Convert from 44, 44 and 42 bit limbs to 26 bit limbs. */
+static void
+poly1305_to_base26(uint64_t out[5], const uint64_t in[3])
+{
+	out[0] = in[0] & 0x3ffffff;
+	out[1] = (in[0] >> 26) + ((in[1] & 0xff) << 18);
+	out[2] = (in[1] >> 8) & 0x3ffffff;
+	out[3] = (in[1] >> 34) + ((in[2] & 0xffff) << 10);
+	out[4] = in[2] >> 16;
+}
+
+/* Carry the 26 bit limbs and convert back to 44, 44 and 42 bit limbs. */
+static void
+poly1305_from_base26(uint64_t out[3], uint64_t in[5])
+{
+	uint64_t c;
+
+	c = in[0] >> 26;
+	in[0] &= 0x3ffffff;
+	in[1] += c;
+	c = in[1] >> 26;
+	in[1] &= 0x3ffffff;
+	in[2] += c;
+	c = in[2] >> 26;
+	in[2] &= 0x3ffffff;
+	in[3] += c;
+	c = in[3] >> 26;
+	in[3] &= 0x3ffffff;
+	in[4] += c;
+	c = in[4] >> 26;
+	in[4] &= 0x3ffffff;
+	in[0] += c * 5;
+	c = in[0] >> 26;
+	in[0] &= 0x3ffffff;
+	in[1] += c;
+
+	out[0] = in[0] + (in[1] << 26);
+	out[1] = (in[2] << 8) + (in[3] << 34);
+	out[2] = in[4] << 16;
+
+	c = out[0] >> 44;
+	out[0] &= 0xfffffffffff;
+	out[1] += c;
+	c = out[1] >> 44;
+	out[1] &= 0xfffffffffff;
+	out[2] += c;
+}
+
+/*
+ * AVX2, four blocks.
+ */
+
+#define AVX2_ATTR	__attribute__((__target__("avx2")))
+
+static inline __m256i AVX2_ATTR
+poly1305_madd_avx2(__m256i d, __m256i a, __m256i b)
+{
+	return _mm256_add_epi64(d, _mm256_mul_epu32(a, b));
+}
+
+/* h = (h * r) % p, partially reduced, where s = 5 * r. */
+static inline void AVX2_ATTR
+poly1305_mul_avx2(__m256i h[5], const __m256i r[5], const __m256i s[5])
+{
+	const __m256i mask = _mm256_set1_epi64x(0x3ffffff);
+	__m256i d0, d1, d2, d3, d4, c;
+
+	d0 = _mm256_mul_epu32(h[0], r[0]);
+	d0 = poly1305_madd_avx2(d0, h[1], s[4]);
+	d0 = poly1305_madd_avx2(d0, h[2], s[3]);
+	d0 = poly1305_madd_avx2(d0, h[3], s[2]);
+	d0 = poly1305_madd_avx2(d0, h[4], s[1]);
+
+	d1 = _mm256_mul_epu32(h[0], r[1]);
+	d1 = poly1305_madd_avx2(d1, h[1], r[0]);
+	d1 = poly1305_madd_avx2(d1, h[2], s[4]);
+	d1 = poly1305_madd_avx2(d1, h[3], s[3]);
+	d1 = poly1305_madd_avx2(d1, h[4], s[2]);
+
+	d2 = _mm256_mul_epu32(h[0], r[2]);
+	d2 = poly1305_madd_avx2(d2, h[1], r[1]);
+	d2 = poly1305_madd_avx2(d2, h[2], r[0]);
+	d2 = poly1305_madd_avx2(d2, h[3], s[4]);
+	d2 = poly1305_madd_avx2(d2, h[4], s[3]);
+
+	d3 = _mm256_mul_epu32(h[0], r[3]);
+	d3 = poly1305_madd_avx2(d3, h[1], r[2]);
+	d3 = poly1305_madd_avx2(d3, h[2], r[1]);
+	d3 = poly1305_madd_avx2(d3, h[3], r[0]);
+	d3 = poly1305_madd_avx2(d3, h[4], s[4]);
+
+	d4 = _mm256_mul_epu32(h[0], r[4]);
+	d4 = poly1305_madd_avx2(d4, h[1], r[3]);
+	d4 = poly1305_madd_avx2(d4, h[2], r[2]);
+	d4 = poly1305_madd_avx2(d4, h[3], r[1]);
+	d4 = poly1305_madd_avx2(d4, h[4], r[0]);
+
+	c = _mm256_srli_epi64(d0, 26);
+	h[0] = _mm256_and_si256(d0, mask);
+	d1 = _mm256_add_epi64(d1, c);
+	c = _mm256_srli_epi64(d1, 26);
+	h[1] = _mm256_and_si256(d1, mask);
+	d2 = _mm256_add_epi64(d2, c);
+	c = _mm256_srli_epi64(d2, 26);
+	h[2] = _mm256_and_si256(d2, mask);
+	d3 = _mm256_add_epi64(d3, c);
+	c = _mm256_srli_epi64(d3, 26);
+	h[3] = _mm256_and_si256(d3, mask);
+	d4 = _mm256_add_epi64(d4, c);
+	c = _mm256_srli_epi64(d4, 26);
+	h[4] = _mm256_and_si256(d4, mask);
+	h[0] = _mm256_add_epi64(h[0], _mm256_add_epi64(c,
+	    _mm256_slli_epi64(c, 2)));
+	c = _mm256_srli_epi64(h[0], 26);
+	h[0] = _mm256_and_si256(h[0], mask);
+	h[1] = _mm256_add_epi64(h[1], c);
+}
+
+/* h += m, for four consecutive blocks. */
+static inline void AVX2_ATTR
+poly1305_add_avx2(__m256i h[5], const unsigned char *m)
+{
+	const __m256i mask = _mm256_set1_epi64x(0x3ffffff);
+	__m256i a, b, lo, hi;
+
+	/* Gather the low and high halves of each block. */
+	a = _mm256_loadu_si256((const __m256i *)(m + 0));
+	b = _mm256_loadu_si256((const __m256i *)(m + 32));
+	lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8);
+	hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8);
+
+	h[0] = _mm256_add_epi64(h[0], _mm256_and_si256(lo, mask));
+	h[1] = _mm256_add_epi64(h[1],
+	    _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask));
+	h[2] = _mm256_add_epi64(h[2], _mm256_and_si256(_mm256_or_si256(
+	    _mm256_srli_epi64(lo, 52), _mm256_slli_epi64(hi, 12)), mask));
+	h[3] = _mm256_add_epi64(h[3],
+	    _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask));
+	h[4] = _mm256_add_epi64(h[4], _mm256_or_si256(_mm256_srli_epi64(hi, 40),
+	    _mm256_set1_epi64x(1 << 24)));
+}
+
+static void AVX2_ATTR
+poly1305_blocks_avx2(uint64_t h[3],
+    const uint64_t rpow[POLY1305_X86_64_POWERS][3], const unsigned char *m,
+    size_t blocks)
+{
+	__m256i hv[5], r[5], s[5], rl[5], sl[5];
+	uint64_t l[4][5], t[5], lanes[4];
+	int i, j;
+
+	for (i = 0; i < 4; i++)
+		poly1305_to_base26(l[i], rpow[i]);
+	poly1305_to_base26(t, h);
+
+	/* r^4 for every lane, and r^4 ... r^1 for the last iteration. */
+	for (i = 0; i < 5; i++) {
+		r[i] = _mm256_set1_epi64x(l[3][i]);
+		rl[i] = _mm256_set_epi64x(l[0][i], l[1][i], l[2][i], l[3][i]);
+		s[i] = _mm256_add_epi64(r[i], _mm256_slli_epi64(r[i], 2));
+		sl[i] = _mm256_add_epi64(rl[i], _mm256_slli_epi64(rl[i], 2));
+		hv[i] = _mm256_set_epi64x(0, 0, 0, t[i]);
+	}
+
+	for (; blocks > 4; blocks -= 4) {
+		poly1305_add_avx2(hv, m);
+		poly1305_mul_avx2(hv, r, s);
+		m += 4 * 16;
+	}
+	poly1305_add_avx2(hv, m);
+	poly1305_mul_avx2(hv, rl, sl);
+
+	for (i = 0; i < 5; i++) {
+		_mm256_storeu_si256((__m256i *)lanes, hv[i]);
+		t[i] = 0;
+		for (j = 0; j < 4; j++)
+			t[i] += lanes[j];
+	}
+	poly1305_from_base26(h, t);
+}
+
+/*
+ * AVX-512, eight blocks.
+ */
+
+#define AVX512_ATTR	__attribute__((__target__("avx512f")))
+
+static inline __m512i AVX512_ATTR
+poly1305_madd_avx512(__m512i d, __m512i a, __m512i b)
+{
+	return _mm512_add_epi64(d, _mm512_mul_epu32(a, b));
+}
+
+/* h = (h * r) % p, partially reduced, where s = 5 * r. */
+static inline void AVX512_ATTR
+poly1305_mul_avx512(__m512i h[5], const __m512i r[5], const __m512i s[5])
+{
+	const __m512i mask = _mm512_set1_epi64(0x3ffffff);
+	__m512i d0, d1, d2, d3, d4, c;
+
+	d0 = _mm512_mul_epu32(h[0], r[0]);
+	d0 = poly1305_madd_avx512(d0, h[1], s[4]);
+	d0 = poly1305_madd_avx512(d0, h[2], s[3]);
+	d0 = poly1305_madd_avx512(d0, h[3], s[2]);
+	d0 = poly1305_madd_avx512(d0, h[4], s[1]);
+
+	d1 = _mm512_mul_epu32(h[0], r[1]);
+	d1 = poly1305_madd_avx512(d1, h[1], r[0]);
+	d1 = poly1305_madd_avx512(d1, h[2], s[4]);
+	d1 = poly1305_madd_avx512(d1, h[3], s[3]);
+	d1 = poly1305_madd_avx512(d1, h[4], s[2]);
+
+	d2 = _mm512_mul_epu32(h[0], r[2]);
+	d2 = poly1305_madd_avx512(d2, h[1], r[1]);
+	d2 = poly1305_madd_avx512(d2, h[2], r[0]);
+	d2 = poly1305_madd_avx512(d2, h[3], s[4]);
+	d2 = poly1305_madd_avx512(d2, h[4], s[3]);
+
+	d3 = _mm512_mul_epu32(h[0], r[3]);
+	d3 = poly1305_madd_avx512(d3, h[1], r[2]);
+	d3 = poly1305_madd_avx512(d3, h[2], r[1]);
+	d3 = poly1305_madd_avx512(d3, h[3], r[0]);
+	d3 = poly1305_madd_avx512(d3, h[4], s[4]);
+
+	d4 = _mm512_mul_epu32(h[0], r[4]);
+	d4 = poly1305_madd_avx512(d4, h[1], r[3]);
+	d4 = poly1305_madd_avx512(d4, h[2], r[2]);
+	d4 = poly1305_madd_avx512(d4, h[3], r[1]);
+	d4 = poly1305_madd_avx512(d4, h[4], r[0]);
+
+	c = _mm512_srli_epi64(d0, 26);
+	h[0] = _mm512_and_si512(d0, mask);
+	d1 = _mm512_add_epi64(d1, c);
+	c = _mm512_srli_epi64(d1, 26);
+	h[1] = _mm512_and_si512(d1, mask);
+	d2 = _mm512_add_epi64(d2, c);
+	c = _mm512_srli_epi64(d2, 26);
+	h[2] = _mm512_and_si512(d2, mask);
+	d3 = _mm512_add_epi64(d3, c);
+	c = _mm512_srli_epi64(d3, 26);
+	h[3] = _mm512_and_si512(d3, mask);
+	d4 = _mm512_add_epi64(d4, c);
+	c = _mm512_srli_epi64(d4, 26);
+	h[4] = _mm512_and_si512(d4, mask);
+	h[0] = _mm512_add_epi64(h[0], _mm512_add_epi64(c,
+	    _mm512_slli_epi64(c, 2)));
+	c = _mm512_srli_epi64(h[0], 26);
+	h[0] = _mm512_and_si512(h[0], mask);
+	h[1] = _mm512_add_epi64(h[1], c);
+}
+
+/* h += m, for eight consecutive blocks. */
+static inline void AVX512_ATTR
+poly1305_add_avx512(__m512i h[5], const unsigned char *m)
+{
+	const __m512i mask = _mm512_set1_epi64(0x3ffffff);
+	__m512i a, b, lo, hi;
+
+	/* Gather the low and high halves of each block. */
+	a = _mm512_loadu_si512((const void *)(m + 0));
+	b = _mm512_loadu_si512((const void *)(m + 64));
+	lo = _mm512_permutex2var_epi64(a,
+	    _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0), b);
+	hi = _mm512_permutex2var_epi64(a,
+	    _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1), b);
+
+	h[0] = _mm512_add_epi64(h[0], _mm512_and_si512(lo, mask));
+	h[1] = _mm512_add_epi64(h[1],
+	    _mm512_and_si512(_mm512_srli_epi64(lo, 26), mask));
+	h[2] = _mm512_add_epi64(h[2], _mm512_and_si512(_mm512_or_si512(
+	    _mm512_srli_epi64(lo, 52), _mm512_slli_epi64(hi, 12)), mask));
+	h[3] = _mm512_add_epi64(h[3],
+	    _mm512_and_si512(_mm512_srli_epi64(hi, 14), mask));
+	h[4] = _mm512_add_epi64(h[4], _mm512_or_si512(_mm512_srli_epi64(hi, 40),
+	    _mm512_set1_epi64(1 << 24)));
+}
+
+static void AVX512_ATTR
+poly1305_blocks_avx512(uint64_t h[3],
+    const uint64_t rpow[POLY1305_X86_64_POWERS][3], const unsigned char *m,
+    size_t blocks)
+{
+	__m512i hv[5], r[5], s[5], rl[5], sl[5];
+	uint64_t l[8][5], t[5];
+	int i;
+
+	for (i = 0; i < 8; i++)
+		poly1305_to_base26(l[i], rpow[i]);
+	poly1305_to_base26(t, h);
+
+	/* r^8 for every lane, and r^8 ... r^1 for the last iteration. */
+	for (i = 0; i < 5; i++) {
+		r[i] = _mm512_set1_epi64(l[7][i]);
+		rl[i] = _mm512_set_epi64(l[0][i], l[1][i], l[2][i], l[3][i],
+		    l[4][i], l[5][i], l[6][i], l[7][i]);
+		s[i] = _mm512_add_epi64(r[i], _mm512_slli_epi64(r[i], 2));
+		sl[i] = _mm512_add_epi64(rl[i], _mm512_slli_epi64(rl[i], 2));
+		hv[i] = _mm512_set_epi64(0, 0, 0, 0, 0, 0, 0, t[i]);
+	}
+
+	for (; blocks > 8; blocks -= 8) {
+		poly1305_add_avx512(hv, m);
+		poly1305_mul_avx512(hv, r, s);
+		m += 8 * 16;
+	}
+	poly1305_add_avx512(hv, m);
+	poly1305_mul_avx512(hv, rl, sl);
+
+	for (i = 0; i < 5; i++)
+		t[i] = _mm512_reduce_add_epi64(hv[i]);
+	poly1305_from_base26(h, t);
+}
+
+int
+poly1305_x86_64_available(void)
+{
+	return (OPENSSL_cpu_caps_ext() &
+	    (CPUCAP_EXT_MASK_AVX2 | CPUCAP_EXT_MASK_AVX512F)) != 0;
+}
+
+size_t
+poly1305_blocks_x86_64(uint64_t h[3],
+    const uint64_t rpow[POLY1305_X86_64_POWERS][3], const unsigned char *m,
+    size_t blocks)
+{
+	uint64_t caps_ext = OPENSSL_cpu_caps_ext();
+	size_t done, n;
+
+	done = 0;
+	if ((caps_ext & CPUCAP_EXT_MASK_AVX512F) != 0) {
+		n = blocks & ~(size_t)7;
+		if (n > 0)
+			poly1305_blocks_avx512(h, rpow, m, n);
+		done += n;
+	}
+	if ((caps_ext & CPUCAP_EXT_MASK_AVX2) != 0) {
+		n = (blocks - done) & ~(size_t)3;
+		if (n > 0)
+			poly1305_blocks_avx2(h, rpow, m + done * 16, n);
+		done += n;
+	}
+
+	return done;
+}
+
+#endif /* POLY1305_X86_64 */
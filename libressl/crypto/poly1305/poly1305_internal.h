@@ -0,0 +1,52 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef HEADER_POLY1305_INTERNAL_H
+#define HEADER_POLY1305_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_HIDDEN_DECLS
+
+/*
+ * The multi-block x86_64 implementations use compiler intrinsics and are
+ * selected at runtime based on OPENSSL_cpu_caps_ext(). They work on the
+ * state of the 64 bit scalar implementation, where h and r are held in
+ * limbs of 44, 44 and 42 bits.
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && defined(__SIZEOF_INT128__) && \
+    defined(OPENSSL_CPUID_OBJ) && !defined(OPENSSL_NO_ASM)
+#define POLY1305_X86_64
+
+/* Number of powers of r needed by poly1305_blocks_x86_64(). */
+#define POLY1305_X86_64_POWERS	8
+
+int poly1305_x86_64_available(void);
+
+/*
+ * Absorb as many of the given 16 byte blocks into h as the available SIMD
+ * implementations can handle, where rpow[i] holds r^(i + 1). Every block
+ * is a full message block, with the 2^128 bit set. Returns the number of
+ * blocks processed, which may be zero.
+ */
+size_t poly1305_blocks_x86_64(uint64_t h[3],
+    const uint64_t rpow[POLY1305_X86_64_POWERS][3], const unsigned char *m,
+    size_t blocks);
+#endif
+
+__END_HIDDEN_DECLS
+
+#endif /* HEADER_POLY1305_INTERNAL_H */
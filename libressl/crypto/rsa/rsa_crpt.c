@@ -57,6 +57,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <openssl/opensslconf.h>
 
@@ -67,6 +68,7 @@
 #include <openssl/rsa.h>
 
 #include "bn_lcl.h"
+#include "rsa_locl.h"
 
 #ifndef OPENSSL_NO_ENGINE
 #include <openssl/engine.h>
@@ -219,3 +221,102 @@ err:
 
 	return ret;
 }
+
+/*
+ * Private key operations check out one of the BN_BLINDINGs in the key's
+ * blinding pool for their duration. Since a checked out BN_BLINDING is only
+ * used by one thread at a time, every thread updates its blinding factors in
+ * place by squaring, instead of all but the owner of rsa->blinding sharing
+ * rsa->mt_blinding under CRYPTO_LOCK_RSA_BLINDING. If no slot can be had,
+ * or without the __atomic builtins, callers fall back to those as before.
+ */
+static struct rsa_internal *
+rsa_internal(RSA *rsa)
+{
+	return (struct rsa_internal *)rsa;
+}
+
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+BN_BLINDING *
+rsa_blinding_pool_get(RSA *rsa, int *slot, BN_CTX *ctx)
+{
+	struct rsa_internal *ri = rsa_internal(rsa);
+	struct rsa_blinding_pool_st *pool;
+	unsigned int bit, busy;
+	int i;
+
+	*slot = -1;
+
+	pool = __atomic_load_n(&ri->blinding_pool, __ATOMIC_ACQUIRE);
+	if (pool == NULL) {
+		CRYPTO_w_lock(CRYPTO_LOCK_RSA);
+		if ((pool = ri->blinding_pool) == NULL) {
+			if ((pool = calloc(1, sizeof(*pool))) != NULL)
+				__atomic_store_n(&ri->blinding_pool, pool,
+				    __ATOMIC_RELEASE);
+		}
+		CRYPTO_w_unlock(CRYPTO_LOCK_RSA);
+		if (pool == NULL)
+			return NULL;
+	}
+
+	busy = __atomic_load_n(&pool->busy, __ATOMIC_RELAXED);
+	for (i = 0; i < RSA_BLINDING_POOL_SIZE; i++) {
+		bit = 1U << i;
+		if ((busy & bit) != 0)
+			continue;
+		busy = __atomic_fetch_or(&pool->busy, bit, __ATOMIC_ACQUIRE);
+		if ((busy & bit) != 0)
+			continue;
+
+		if (pool->blinding[i] == NULL &&
+		    (pool->blinding[i] = RSA_setup_blinding(rsa, ctx)) == NULL) {
+			__atomic_fetch_and(&pool->busy, ~bit, __ATOMIC_RELEASE);
+			return NULL;
+		}
+		*slot = i;
+
+		return pool->blinding[i];
+	}
+
+	/* More concurrent operations than slots. */
+	return NULL;
+}
+
+void
+rsa_blinding_pool_put(RSA *rsa, int slot)
+{
+	if (slot < 0)
+		return;
+
+	__atomic_fetch_and(&rsa_internal(rsa)->blinding_pool->busy,
+	    ~(1U << slot), __ATOMIC_RELEASE);
+}
+#else
+BN_BLINDING *
+rsa_blinding_pool_get(RSA *rsa, int *slot, BN_CTX *ctx)
+{
+	*slot = -1;
+
+	return NULL;
+}
+
+void
+rsa_blinding_pool_put(RSA *rsa, int slot)
+{
+}
+#endif
+
+void
+rsa_blinding_pool_free(RSA *rsa)
+{
+	struct rsa_blinding_pool_st *pool = rsa_internal(rsa)->blinding_pool;
+	int i;
+
+	if (pool == NULL)
+		return;
+
+	for (i = 0; i < RSA_BLINDING_POOL_SIZE; i++)
+		BN_BLINDING_free(pool->blinding[i]);
+	free(pool);
+}
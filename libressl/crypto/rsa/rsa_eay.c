@@ -119,6 +119,7 @@
 #include <openssl/rsa.h>
 
 #include "bn_lcl.h"
+#include "rsa_locl.h"
 
 static int RSA_eay_public_encrypt(int flen, const unsigned char *from,
     unsigned char *to, RSA *rsa, int padding);
@@ -252,12 +253,18 @@ err:
 }
 
 static BN_BLINDING *
-rsa_get_blinding(RSA *rsa, int *local, BN_CTX *ctx)
+rsa_get_blinding(RSA *rsa, int *local, int *slot, BN_CTX *ctx)
 {
 	BN_BLINDING *ret;
 	int got_write_lock = 0;
 	CRYPTO_THREADID cur;
 
+	/* A BN_BLINDING from the pool is ours until rsa_blinding_pool_put(). */
+	if ((ret = rsa_blinding_pool_get(rsa, slot, ctx)) != NULL) {
+		*local = 1;
+		return ret;
+	}
+
 	CRYPTO_r_lock(CRYPTO_LOCK_RSA);
 
 	if (rsa->blinding == NULL) {
@@ -354,6 +361,7 @@ RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
 	unsigned char *buf = NULL;
 	BN_CTX *ctx = NULL;
 	int local_blinding = 0;
+	int blinding_slot = -1;
 	/*
 	 * Used only if the blinding structure is shared. A non-NULL unblind
 	 * instructs rsa_blinding_convert() and rsa_blinding_invert() to store
@@ -403,7 +411,8 @@ RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
 	}
 
 	if (!(rsa->flags & RSA_FLAG_NO_BLINDING)) {
-		blinding = rsa_get_blinding(rsa, &local_blinding, ctx);
+		blinding = rsa_get_blinding(rsa, &local_blinding,
+		    &blinding_slot, ctx);
 		if (blinding == NULL) {
 			RSAerror(ERR_R_INTERNAL_ERROR);
 			goto err;
@@ -463,6 +472,7 @@ RSA_eay_private_encrypt(int flen, const unsigned char *from, unsigned char *to,
 
 	r = num;
 err:
+	rsa_blinding_pool_put(rsa, blinding_slot);
 	if (ctx != NULL) {
 		BN_CTX_end(ctx);
 		BN_CTX_free(ctx);
@@ -481,6 +491,7 @@ RSA_eay_private_decrypt(int flen, const unsigned char *from, unsigned char *to,
 	unsigned char *buf = NULL;
 	BN_CTX *ctx = NULL;
 	int local_blinding = 0;
+	int blinding_slot = -1;
 	/*
 	 * Used only if the blinding structure is shared. A non-NULL unblind
 	 * instructs rsa_blinding_convert() and rsa_blinding_invert() to store
@@ -520,7 +531,8 @@ RSA_eay_private_decrypt(int flen, const unsigned char *from, unsigned char *to,
 	}
 
 	if (!(rsa->flags & RSA_FLAG_NO_BLINDING)) {
-		blinding = rsa_get_blinding(rsa, &local_blinding, ctx);
+		blinding = rsa_get_blinding(rsa, &local_blinding,
+		    &blinding_slot, ctx);
 		if (blinding == NULL) {
 			RSAerror(ERR_R_INTERNAL_ERROR);
 			goto err;
@@ -586,6 +598,7 @@ RSA_eay_private_decrypt(int flen, const unsigned char *from, unsigned char *to,
 		RSAerror(RSA_R_PADDING_CHECK_FAILED);
 
 err:
+	rsa_blinding_pool_put(rsa, blinding_slot);
 	if (ctx != NULL) {
 		BN_CTX_end(ctx);
 		BN_CTX_free(ctx);
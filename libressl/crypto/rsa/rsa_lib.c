@@ -68,6 +68,7 @@
 #include <openssl/rsa.h>
 
 #include "evp_locl.h"
+#include "rsa_locl.h"
 
 #ifndef OPENSSL_NO_ENGINE
 #include <openssl/engine.h>
@@ -131,7 +132,7 @@ RSA_new_method(ENGINE *engine)
 {
 	RSA *ret;
 
-	if ((ret = calloc(1, sizeof(RSA))) == NULL) {
+	if ((ret = calloc(1, sizeof(struct rsa_internal))) == NULL) {
 		RSAerror(ERR_R_MALLOC_FAILURE);
 		return NULL;
 	}
@@ -209,6 +210,7 @@ RSA_free(RSA *r)
 	BN_clear_free(r->iqmp);
 	BN_BLINDING_free(r->blinding);
 	BN_BLINDING_free(r->mt_blinding);
+	rsa_blinding_pool_free(r);
 	RSA_PSS_PARAMS_free(r->pss);
 	free(r);
 }
@@ -4,6 +4,24 @@ __BEGIN_HIDDEN_DECLS
 
 #define RSA_MIN_MODULUS_BITS	512
 
+#define RSA_BLINDING_POOL_SIZE	32
+
+struct rsa_blinding_pool_st {
+	unsigned int busy;		/* one bit per slot */
+	BN_BLINDING *blinding[RSA_BLINDING_POOL_SIZE];
+};
+
+/*
+ * RSA objects are allocated with room for the fields below, which are kept
+ * out of the public struct rsa_st so that its layout does not change. They
+ * are only ever allocated by RSA_new_method().
+ */
+struct rsa_internal {
+	RSA rsa;
+	/* Blinding factors checked out by concurrent private key operations */
+	struct rsa_blinding_pool_st *blinding_pool;
+};
+
 /* Macros to test if a pkey or ctx is for a PSS key */
 #define pkey_is_pss(pkey) (pkey->ameth->pkey_id == EVP_PKEY_RSA_PSS)
 #define pkey_ctx_is_pss(ctx) (ctx->pmeth->pkey_id == EVP_PKEY_RSA_PSS)
@@ -13,6 +31,10 @@ RSA_PSS_PARAMS *rsa_pss_params_create(const EVP_MD *sigmd, const EVP_MD *mgf1md,
 int rsa_pss_get_param(const RSA_PSS_PARAMS *pss, const EVP_MD **pmd,
     const EVP_MD **pmgf1md, int *psaltlen);
 
+BN_BLINDING *rsa_blinding_pool_get(RSA *rsa, int *slot, BN_CTX *ctx);
+void rsa_blinding_pool_put(RSA *rsa, int slot);
+void rsa_blinding_pool_free(RSA *rsa);
+
 extern int int_rsa_verify(int dtype, const unsigned char *m,
     unsigned int m_len, unsigned char *rm, size_t *prm_len,
     const unsigned char *sigbuf, size_t siglen, RSA *rsa);
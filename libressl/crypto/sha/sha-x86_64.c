@@ -0,0 +1,268 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * SHA-1 and SHA-256 block functions for x86_64 using the SHA extensions.
+ * Without them, sha{1,256}_block_data_order() are used.
+ */
+
+#include <stdint.h>
+
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+
+#include "sha_internal.h"
+
+#ifdef SHA_X86_64
+
+#include <immintrin.h>
+
+#include "cryptlib.h"
+#include "x86_arch.h"
+
+#define SHANI_ATTR	__attribute__((__target__("sha,sse4.1,ssse3")))
+
+static const uint32_t K256[64] __attribute__((__aligned__(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/*
+ * SHA-1 with the SHA extensions. Each sha1rnds4 performs four rounds, with
+ * sha1nexte deriving E for the next four rounds from the previous A.
+ */
+
+/* W[i..i+3] = ROTL1(W[i-16..] ^ W[i-14..] ^ W[i-8..] ^ W[i-3..]) */
+#define SHA1_SCHED(w0, w1, w2, w3)					\
+	w0 = _mm_sha1msg2_epu32(_mm_xor_si128(				\
+	    _mm_sha1msg1_epu32(w0, w1), w2), w3)
+
+#define SHA1_ROUNDS4(f, w) do {						\
+	x = _mm_sha1nexte_epu32(e, w);					\
+	e = abcd;							\
+	abcd = _mm_sha1rnds4_epu32(abcd, x, f);				\
+} while (0)
+
+static void SHANI_ATTR
+sha1_blocks_shani(SHA_CTX *c, const uint8_t *in, size_t num)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0001020304050607ULL,
+	    0x08090a0b0c0d0e0fULL);
+	__m128i abcd, abcd_save, e0, e0_save, e, x;
+	__m128i w0, w1, w2, w3;
+
+	abcd = _mm_loadu_si128((const __m128i *)&c->h0);
+	abcd = _mm_shuffle_epi32(abcd, 0x1b);
+	e0 = _mm_set_epi32(c->h4, 0, 0, 0);
+
+	while (num-- > 0) {
+		abcd_save = abcd;
+		e0_save = e0;
+
+		w0 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 0)), bswap);
+		w1 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 16)), bswap);
+		w2 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 32)), bswap);
+		w3 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 48)), bswap);
+
+		/* Rounds 0-3 take E from the chaining value. */
+		x = _mm_add_epi32(e0, w0);
+		e = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, x, 0);
+
+		SHA1_ROUNDS4(0, w1);
+		SHA1_ROUNDS4(0, w2);
+		SHA1_ROUNDS4(0, w3);
+		SHA1_SCHED(w0, w1, w2, w3);
+		SHA1_ROUNDS4(0, w0);
+		SHA1_SCHED(w1, w2, w3, w0);
+		SHA1_ROUNDS4(1, w1);
+		SHA1_SCHED(w2, w3, w0, w1);
+		SHA1_ROUNDS4(1, w2);
+		SHA1_SCHED(w3, w0, w1, w2);
+		SHA1_ROUNDS4(1, w3);
+		SHA1_SCHED(w0, w1, w2, w3);
+		SHA1_ROUNDS4(1, w0);
+		SHA1_SCHED(w1, w2, w3, w0);
+		SHA1_ROUNDS4(1, w1);
+		SHA1_SCHED(w2, w3, w0, w1);
+		SHA1_ROUNDS4(2, w2);
+		SHA1_SCHED(w3, w0, w1, w2);
+		SHA1_ROUNDS4(2, w3);
+		SHA1_SCHED(w0, w1, w2, w3);
+		SHA1_ROUNDS4(2, w0);
+		SHA1_SCHED(w1, w2, w3, w0);
+		SHA1_ROUNDS4(2, w1);
+		SHA1_SCHED(w2, w3, w0, w1);
+		SHA1_ROUNDS4(2, w2);
+		SHA1_SCHED(w3, w0, w1, w2);
+		SHA1_ROUNDS4(3, w3);
+		SHA1_SCHED(w0, w1, w2, w3);
+		SHA1_ROUNDS4(3, w0);
+		SHA1_SCHED(w1, w2, w3, w0);
+		SHA1_ROUNDS4(3, w1);
+		SHA1_SCHED(w2, w3, w0, w1);
+		SHA1_ROUNDS4(3, w2);
+		SHA1_SCHED(w3, w0, w1, w2);
+		SHA1_ROUNDS4(3, w3);
+
+		e0 = _mm_sha1nexte_epu32(e, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+
+		in += SHA_CBLOCK;
+	}
+
+	abcd = _mm_shuffle_epi32(abcd, 0x1b);
+	_mm_storeu_si128((__m128i *)&c->h0, abcd);
+	c->h4 = _mm_extract_epi32(e0, 3);
+}
+
+/*
+ * SHA-256 with the SHA extensions. The state is kept as ABEF and CDGH, and
+ * each sha256rnds2 performs two rounds using the low half of its message
+ * operand.
+ */
+
+/* W[i..i+3] from W[i-16..], W[i-12..], W[i-8..] and W[i-4..] */
+#define SHA256_SCHED(w0, w1, w2, w3)					\
+	w0 = _mm_sha256msg2_epu32(_mm_add_epi32(			\
+	    _mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4)), w3)
+
+#define SHA256_ROUNDS4(i, w) do {					\
+	x = _mm_add_epi32(w, _mm_load_si128((const __m128i *)&K256[i]));\
+	cdgh = _mm_sha256rnds2_epu32(cdgh, abef, x);			\
+	x = _mm_shuffle_epi32(x, 0x0e);					\
+	abef = _mm_sha256rnds2_epu32(abef, cdgh, x);			\
+} while (0)
+
+static void SHANI_ATTR
+sha256_blocks_shani(SHA256_CTX *c, const uint8_t *in, size_t num)
+{
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+	    0x0405060700010203ULL);
+	__m128i abef, cdgh, abef_save, cdgh_save, x, t;
+	__m128i w0, w1, w2, w3;
+
+	/* Rearrange DCBA and HGFE into ABEF and CDGH. */
+	t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&c->h[0]),
+	    0xb1);
+	cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&c->h[4]),
+	    0x1b);
+	abef = _mm_alignr_epi8(t, cdgh, 8);
+	cdgh = _mm_blend_epi16(cdgh, t, 0xf0);
+
+	while (num-- > 0) {
+		abef_save = abef;
+		cdgh_save = cdgh;
+
+		w0 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 0)), bswap);
+		w1 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 16)), bswap);
+		w2 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 32)), bswap);
+		w3 = _mm_shuffle_epi8(_mm_loadu_si128(
+		    (const __m128i *)(in + 48)), bswap);
+
+		SHA256_ROUNDS4(0, w0);
+		SHA256_ROUNDS4(4, w1);
+		SHA256_ROUNDS4(8, w2);
+		SHA256_ROUNDS4(12, w3);
+		SHA256_SCHED(w0, w1, w2, w3);
+		SHA256_ROUNDS4(16, w0);
+		SHA256_SCHED(w1, w2, w3, w0);
+		SHA256_ROUNDS4(20, w1);
+		SHA256_SCHED(w2, w3, w0, w1);
+		SHA256_ROUNDS4(24, w2);
+		SHA256_SCHED(w3, w0, w1, w2);
+		SHA256_ROUNDS4(28, w3);
+		SHA256_SCHED(w0, w1, w2, w3);
+		SHA256_ROUNDS4(32, w0);
+		SHA256_SCHED(w1, w2, w3, w0);
+		SHA256_ROUNDS4(36, w1);
+		SHA256_SCHED(w2, w3, w0, w1);
+		SHA256_ROUNDS4(40, w2);
+		SHA256_SCHED(w3, w0, w1, w2);
+		SHA256_ROUNDS4(44, w3);
+		SHA256_SCHED(w0, w1, w2, w3);
+		SHA256_ROUNDS4(48, w0);
+		SHA256_SCHED(w1, w2, w3, w0);
+		SHA256_ROUNDS4(52, w1);
+		SHA256_SCHED(w2, w3, w0, w1);
+		SHA256_ROUNDS4(56, w2);
+		SHA256_SCHED(w3, w0, w1, w2);
+		SHA256_ROUNDS4(60, w3);
+
+		abef = _mm_add_epi32(abef, abef_save);
+		cdgh = _mm_add_epi32(cdgh, cdgh_save);
+
+		in += SHA256_CBLOCK;
+	}
+
+	/* Rearrange ABEF and CDGH back into DCBA and HGFE. */
+	t = _mm_shuffle_epi32(abef, 0x1b);
+	cdgh = _mm_shuffle_epi32(cdgh, 0xb1);
+	_mm_storeu_si128((__m128i *)&c->h[0], _mm_blend_epi16(t, cdgh, 0xf0));
+	_mm_storeu_si128((__m128i *)&c->h[4], _mm_alignr_epi8(cdgh, t, 8));
+}
+
+int
+sha1_blocks_x86_64(SHA_CTX *c, const void *in, size_t num)
+{
+	uint64_t caps = OPENSSL_cpu_caps();
+	uint64_t caps_ext = OPENSSL_cpu_caps_ext();
+
+	if ((caps_ext & CPUCAP_EXT_MASK_SHA) != 0 &&
+	    (caps & CPUCAP_MASK_SSSE3) != 0) {
+		sha1_blocks_shani(c, in, num);
+		return 1;
+	}
+
+	return 0;
+}
+
+int
+sha256_blocks_x86_64(SHA256_CTX *c, const void *in, size_t num)
+{
+	uint64_t caps = OPENSSL_cpu_caps();
+	uint64_t caps_ext = OPENSSL_cpu_caps_ext();
+
+	if ((caps_ext & CPUCAP_EXT_MASK_SHA) != 0 &&
+	    (caps & CPUCAP_MASK_SSSE3) != 0) {
+		sha256_blocks_shani(c, in, num);
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif /* SHA_X86_64 */
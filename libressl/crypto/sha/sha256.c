@@ -18,6 +18,8 @@
 #include <openssl/sha.h>
 #include <openssl/opensslv.h>
 
+#include "sha_internal.h"
+
 int SHA224_Init(SHA256_CTX *c)
 	{
 	memset (c,0,sizeof(*c));
@@ -108,11 +110,21 @@ int SHA224_Final (unsigned char *md, SHA256_CTX *c)
 #define	HASH_UPDATE		SHA256_Update
 #define	HASH_TRANSFORM		SHA256_Transform
 #define	HASH_FINAL		SHA256_Final
-#define	HASH_BLOCK_DATA_ORDER	sha256_block_data_order
 #ifndef SHA256_ASM
 static
 #endif
 void sha256_block_data_order (SHA256_CTX *ctx, const void *in, size_t num);
+#ifdef SHA_X86_64
+static void
+sha256_blocks(SHA256_CTX *ctx, const void *in, size_t num)
+	{
+	if (!sha256_blocks_x86_64(ctx,in,num))
+		sha256_block_data_order(ctx,in,num);
+	}
+#define	HASH_BLOCK_DATA_ORDER	sha256_blocks
+#else
+#define	HASH_BLOCK_DATA_ORDER	sha256_block_data_order
+#endif
 
 #include "md32_common.h"
 
@@ -0,0 +1,44 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef HEADER_SHA_INTERNAL_H
+#define HEADER_SHA_INTERNAL_H
+
+#include <stddef.h>
+
+#include <openssl/sha.h>
+
+__BEGIN_HIDDEN_DECLS
+
+/*
+ * The SHA extensions implementations use compiler intrinsics and are
+ * selected at runtime based on OPENSSL_cpu_caps() and OPENSSL_cpu_caps_ext().
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && \
+    defined(OPENSSL_CPUID_OBJ) && !defined(OPENSSL_NO_ASM)
+#define SHA_X86_64
+
+/*
+ * Process num 64 byte blocks if the SHA extensions are available on this
+ * CPU. Returns 1 if the blocks were processed and 0 if the caller needs to
+ * fall back to sha{1,256}_block_data_order().
+ */
+int sha1_blocks_x86_64(SHA_CTX *c, const void *in, size_t num);
+int sha256_blocks_x86_64(SHA256_CTX *c, const void *in, size_t num);
+#endif
+
+__END_HIDDEN_DECLS
+
+#endif /* HEADER_SHA_INTERNAL_H */
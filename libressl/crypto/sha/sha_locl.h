@@ -62,6 +62,8 @@
 #include <openssl/opensslconf.h>
 #include <openssl/sha.h>
 
+#include "sha_internal.h"
+
 #define DATA_ORDER_IS_BIG_ENDIAN
 
 #define HASH_LONG               SHA_LONG
@@ -80,7 +82,6 @@
 # define HASH_TRANSFORM          	SHA1_Transform
 # define HASH_FINAL              	SHA1_Final
 # define HASH_INIT			SHA1_Init
-# define HASH_BLOCK_DATA_ORDER   	sha1_block_data_order
 # define Xupdate(a,ix,ia,ib,ic,id)	( (a)=(ia^ib^ic^id),	\
 					  ix=(a)=ROTATE((a),1)	\
 					)
@@ -95,6 +96,18 @@ void sha1_block_data_order (SHA_CTX *c, const void *p,size_t num);
 
 __END_HIDDEN_DECLS
 
+#ifdef SHA_X86_64
+static void
+sha1_blocks(SHA_CTX *c, const void *p, size_t num)
+	{
+	if (!sha1_blocks_x86_64(c,p,num))
+		sha1_block_data_order(c,p,num);
+	}
+# define HASH_BLOCK_DATA_ORDER   	sha1_blocks
+#else
+# define HASH_BLOCK_DATA_ORDER   	sha1_block_data_order
+#endif
+
 #include "md32_common.h"
 
 #define INIT_DATA_h0 0x67452301UL
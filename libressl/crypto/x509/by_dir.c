@@ -58,8 +58,13 @@
 
 #include <sys/types.h>
 
+#include <ctype.h>
+#include <dirent.h>
 #include <errno.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
@@ -68,27 +73,59 @@
 
 #include <openssl/err.h>
 #include <openssl/lhash.h>
+#include <openssl/pem.h>
 #include <openssl/x509.h>
 
+#include "x509_lcl.h"
+
 # include <sys/stat.h>
 
+/*
+ * An indexed directory is read into memory once, so that lookups do not
+ * touch the file system.  It is checked for changes at most once every
+ * BY_DIR_INDEX_CHECK seconds, and then scanned again.
+ */
+#define BY_DIR_INDEX_CHECK	1
+
 typedef struct lookup_dir_hashes_st {
 	unsigned long hash;
 	int suffix;
 } BY_DIR_HASH;
 
+/* A file of an indexed directory, shared between successive scans. */
+typedef struct lookup_dir_file_st {
+	char *name;
+	unsigned long hash;
+	int crl;
+	int suffix;
+	time_t mtime;
+	off_t size;
+	ino_t ino;
+	int references;
+	STACK_OF(X509_INFO) *objs;
+} BY_DIR_FILE;
+
 typedef struct lookup_dir_entry_st {
 	char *dir;
 	int dir_type;
 	STACK_OF(BY_DIR_HASH) *hashes;
+	/* Index of the directory, sorted by hash, type and suffix. */
+	STACK_OF(BY_DIR_FILE) *files;
+	time_t mtime;
+	time_t scanned;
+	time_t checked;
+	int refreshing;
 } BY_DIR_ENTRY;
 
 typedef struct lookup_dir_st {
 	BUF_MEM *buffer;
 	STACK_OF(BY_DIR_ENTRY) *dirs;
+	int indexed;
+	pthread_mutex_t index_lock;
 } BY_DIR;
 
 DECLARE_STACK_OF(BY_DIR_HASH)
+DECLARE_STACK_OF(BY_DIR_FILE)
 DECLARE_STACK_OF(BY_DIR_ENTRY)
 
 static int dir_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
@@ -96,6 +133,8 @@ static int dir_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
 static int new_dir(X509_LOOKUP *lu);
 static void free_dir(X509_LOOKUP *lu);
 static int add_cert_dir(BY_DIR *ctx, const char *dir, int type);
+static int by_dir_set_indexed(BY_DIR *ctx, int on);
+static int by_dir_index(BY_DIR *ctx, BY_DIR_ENTRY *ent);
 static int get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
     X509_OBJECT *ret);
 
@@ -138,6 +177,9 @@ dir_ctrl(X509_LOOKUP *ctx, int cmd, const char *argp, long argl,
 		} else
 			ret = add_cert_dir(ld, argp, (int)argl);
 		break;
+	case X509_L_INDEX_DIR:
+		ret = by_dir_set_indexed(ld, argl != 0);
+		break;
 	}
 	return (ret);
 }
@@ -154,6 +196,12 @@ new_dir(X509_LOOKUP *lu)
 		return (0);
 	}
 	a->dirs = NULL;
+	a->indexed = 0;
+	if (pthread_mutex_init(&a->index_lock, NULL) != 0) {
+		BUF_MEM_free(a->buffer);
+		free(a);
+		return (0);
+	}
 	lu->method_data = (char *)a;
 	return (1);
 }
@@ -175,12 +223,50 @@ by_dir_hash_cmp(const BY_DIR_HASH * const *a,
 	return 0;
 }
 
+static void
+by_dir_file_free(BY_DIR_FILE *file)
+{
+	if (file == NULL)
+		return;
+	if (--file->references > 0)
+		return;
+	free(file->name);
+	sk_X509_INFO_pop_free(file->objs, X509_INFO_free);
+	free(file);
+}
+
+static void
+by_dir_files_free(STACK_OF(BY_DIR_FILE) *files)
+{
+	sk_BY_DIR_FILE_pop_free(files, by_dir_file_free);
+}
+
+static int
+by_dir_file_cmp(const BY_DIR_FILE * const *a, const BY_DIR_FILE * const *b)
+{
+	if ((*a)->hash != (*b)->hash)
+		return (*a)->hash > (*b)->hash ? 1 : -1;
+	if ((*a)->crl != (*b)->crl)
+		return (*a)->crl - (*b)->crl;
+	if ((*a)->suffix != (*b)->suffix)
+		return (*a)->suffix > (*b)->suffix ? 1 : -1;
+	return 0;
+}
+
+static int
+by_dir_file_name_cmp(const BY_DIR_FILE * const *a,
+    const BY_DIR_FILE * const *b)
+{
+	return strcmp((*a)->name, (*b)->name);
+}
+
 static void
 by_dir_entry_free(BY_DIR_ENTRY *ent)
 {
 	free(ent->dir);
 	if (ent->hashes)
 		sk_BY_DIR_HASH_pop_free(ent->hashes, by_dir_hash_free);
+	by_dir_files_free(ent->files);
 	free(ent);
 }
 
@@ -194,9 +280,369 @@ free_dir(X509_LOOKUP *lu)
 		sk_BY_DIR_ENTRY_pop_free(a->dirs, by_dir_entry_free);
 	if (a->buffer != NULL)
 		BUF_MEM_free(a->buffer);
+	pthread_mutex_destroy(&a->index_lock);
 	free(a);
 }
 
+/*
+ * Parse a file name of the form hash.N for certificates or hash.rN for
+ * CRLs, as looked for by get_cert_by_subject().
+ */
+static int
+by_dir_parse_name(const char *name, unsigned long *hash, int *crl,
+    int *suffix)
+{
+	int i;
+
+	*hash = 0;
+	for (i = 0; i < 8; i++) {
+		if (isdigit((unsigned char)name[i]))
+			*hash = (*hash << 4) | (name[i] - '0');
+		else if (name[i] >= 'a' && name[i] <= 'f')
+			*hash = (*hash << 4) | (name[i] - 'a' + 10);
+		else
+			return 0;
+	}
+	name += 8;
+	if (*name++ != '.')
+		return 0;
+	*crl = 0;
+	if (*name == 'r') {
+		*crl = 1;
+		name++;
+	}
+	if (*name == '\0')
+		return 0;
+	for (*suffix = 0; *name != '\0'; name++) {
+		if (!isdigit((unsigned char)*name))
+			return 0;
+		if (*suffix > (INT_MAX - 9) / 10)
+			return 0;
+		*suffix = *suffix * 10 + (*name - '0');
+	}
+	return 1;
+}
+
+/*
+ * Load the certificates, or the CRLs, of a file into a new index record.
+ * Files that hold neither are skipped, as get_cert_by_subject() would.
+ */
+static BY_DIR_FILE *
+by_dir_file_load(const char *path, const char *name, const struct stat *st,
+    int type)
+{
+	STACK_OF(X509_INFO) *info = NULL;
+	BY_DIR_FILE *file;
+	X509_INFO *xi;
+	BIO *in = NULL;
+
+	if ((file = calloc(1, sizeof(*file))) == NULL)
+		return NULL;
+	file->references = 1;
+	if (!by_dir_parse_name(name, &file->hash, &file->crl, &file->suffix))
+		goto err;
+	if ((file->name = strdup(name)) == NULL)
+		goto err;
+	file->mtime = st->st_mtime;
+	file->size = st->st_size;
+	file->ino = st->st_ino;
+	if ((file->objs = sk_X509_INFO_new_null()) == NULL)
+		goto err;
+
+	if ((in = BIO_new_file(path, "r")) == NULL)
+		goto err;
+	if (type == X509_FILETYPE_PEM) {
+		if ((info = PEM_X509_INFO_read_bio(in, NULL, NULL,
+		    NULL)) == NULL)
+			goto err;
+		while ((xi = sk_X509_INFO_shift(info)) != NULL) {
+			if ((file->crl && xi->crl == NULL) ||
+			    (!file->crl && xi->x509 == NULL)) {
+				X509_INFO_free(xi);
+				continue;
+			}
+			if (!sk_X509_INFO_push(file->objs, xi)) {
+				X509_INFO_free(xi);
+				goto err;
+			}
+		}
+	} else if (type == X509_FILETYPE_ASN1) {
+		if ((xi = X509_INFO_new()) == NULL)
+			goto err;
+		if (file->crl)
+			xi->crl = d2i_X509_CRL_bio(in, NULL);
+		else
+			xi->x509 = d2i_X509_bio(in, NULL);
+		if ((xi->crl == NULL && xi->x509 == NULL) ||
+		    !sk_X509_INFO_push(file->objs, xi)) {
+			X509_INFO_free(xi);
+			goto err;
+		}
+	} else
+		goto err;
+	if (sk_X509_INFO_num(file->objs) == 0)
+		goto err;
+
+	sk_X509_INFO_pop_free(info, X509_INFO_free);
+	BIO_free(in);
+
+	return file;
+
+ err:
+	sk_X509_INFO_pop_free(info, X509_INFO_free);
+	BIO_free(in);
+	by_dir_file_free(file);
+
+	return NULL;
+}
+
+/*
+ * Scan the directory of ent into a new index, sharing the files of the
+ * old index that did not change since.  A missing or unreadable directory
+ * gives an empty index, and so do unreadable files, so that the lookup
+ * behaves as if they were not there.
+ */
+static STACK_OF(BY_DIR_FILE) *
+by_dir_scan(BY_DIR_ENTRY *ent, STACK_OF(BY_DIR_FILE) *old)
+{
+	STACK_OF(BY_DIR_FILE) *files = NULL, *byname = NULL;
+	BY_DIR_FILE key, *file;
+	struct dirent *dp;
+	struct stat st;
+	DIR *dirp = NULL;
+	char *path = NULL;
+	int i;
+
+	ERR_set_mark();
+
+	if ((files = sk_BY_DIR_FILE_new(by_dir_file_cmp)) == NULL)
+		goto err;
+	if (old != NULL) {
+		if ((byname = sk_BY_DIR_FILE_dup(old)) == NULL)
+			goto err;
+		(void)sk_BY_DIR_FILE_set_cmp_func(byname,
+		    by_dir_file_name_cmp);
+		sk_BY_DIR_FILE_sort(byname);
+	}
+
+	if ((dirp = opendir(ent->dir)) == NULL)
+		goto done;
+	while ((dp = readdir(dirp)) != NULL) {
+		if (!by_dir_parse_name(dp->d_name, &key.hash, &key.crl,
+		    &key.suffix))
+			continue;
+		free(path);
+		if (asprintf(&path, "%s/%s", ent->dir, dp->d_name) == -1) {
+			path = NULL;
+			goto err;
+		}
+		if (stat(path, &st) == -1 || !S_ISREG(st.st_mode))
+			continue;
+
+		file = NULL;
+		key.name = dp->d_name;
+		if ((i = sk_BY_DIR_FILE_find(byname, &key)) >= 0) {
+			file = sk_BY_DIR_FILE_value(byname, i);
+			if (file->mtime == st.st_mtime &&
+			    file->size == st.st_size && file->ino == st.st_ino)
+				file->references++;
+			else
+				file = NULL;
+		}
+		if (file == NULL && (file = by_dir_file_load(path, dp->d_name,
+		    &st, ent->dir_type)) == NULL)
+			continue;
+		if (!sk_BY_DIR_FILE_push(files, file)) {
+			by_dir_file_free(file);
+			goto err;
+		}
+	}
+
+ done:
+	sk_BY_DIR_FILE_sort(files);
+	if (dirp != NULL)
+		closedir(dirp);
+	sk_BY_DIR_FILE_free(byname);
+	free(path);
+	ERR_pop_to_mark();
+
+	return files;
+
+ err:
+	if (dirp != NULL)
+		closedir(dirp);
+	sk_BY_DIR_FILE_free(byname);
+	free(path);
+	by_dir_files_free(files);
+	ERR_pop_to_mark();
+
+	return NULL;
+}
+
+/*
+ * Scan the directory of ent again if it changed.  Called with the index
+ * lock held; the lock is dropped while scanning, so that other lookups
+ * keep being served from the old index meanwhile.  There is nothing to
+ * serve before the first scan, which is done holding the lock.  The old
+ * index belongs to the scan until it is done, so if indexing was turned
+ * off meanwhile, both indexes are freed here.
+ */
+static int
+by_dir_index(BY_DIR *ctx, BY_DIR_ENTRY *ent)
+{
+	STACK_OF(BY_DIR_FILE) *files = NULL, *old;
+	struct stat st;
+	time_t now, mtime = 0;
+
+	now = time(NULL);
+	if (ent->refreshing)
+		return 1;
+	if (ent->files != NULL && now >= ent->checked &&
+	    now - ent->checked < BY_DIR_INDEX_CHECK)
+		return 1;
+	ent->checked = now;
+
+	ent->refreshing = 1;
+	if ((old = ent->files) != NULL)
+		pthread_mutex_unlock(&ctx->index_lock);
+
+	if (stat(ent->dir, &st) == 0)
+		mtime = st.st_mtime;
+	/*
+	 * Files added within the second of the last scan do not change
+	 * the mtime of the directory, so scan until a second has passed.
+	 */
+	if (old == NULL || mtime != ent->mtime || mtime >= ent->scanned)
+		files = by_dir_scan(ent, old);
+
+	if (old != NULL)
+		pthread_mutex_lock(&ctx->index_lock);
+	ent->refreshing = 0;
+	if (!ctx->indexed) {
+		by_dir_files_free(files);
+		by_dir_files_free(old);
+		ent->files = NULL;
+		return 1;
+	}
+	if (files == NULL)
+		return old != NULL;
+	ent->files = files;
+	ent->mtime = mtime;
+	ent->scanned = now;
+	by_dir_files_free(old);
+
+	return 1;
+}
+
+static int
+by_dir_set_indexed(BY_DIR *ctx, int on)
+{
+	BY_DIR_ENTRY *ent;
+	int i, ret = 1;
+
+	pthread_mutex_lock(&ctx->index_lock);
+	ctx->indexed = on;
+	for (i = 0; i < sk_BY_DIR_ENTRY_num(ctx->dirs); i++) {
+		ent = sk_BY_DIR_ENTRY_value(ctx->dirs, i);
+		if (!on) {
+			/* A running scan frees the index when it is done. */
+			if (ent->refreshing)
+				continue;
+			by_dir_files_free(ent->files);
+			ent->files = NULL;
+		} else if (!by_dir_index(ctx, ent)) {
+			X509error(ERR_R_MALLOC_FAILURE);
+			ret = 0;
+		}
+	}
+	pthread_mutex_unlock(&ctx->index_lock);
+
+	return ret;
+}
+
+/*
+ * Add the certificates, or the CRLs, with the given name hash from the
+ * index of ent to the store.  They are collected under the index lock and
+ * added without it, since adding takes the store lock, which is only done
+ * for those that the store does not hold yet.  Return 0 if the directory
+ * is not indexed, so that the caller looks at the files instead.
+ */
+static int
+by_dir_index_load(X509_LOOKUP *xl, BY_DIR *ctx, BY_DIR_ENTRY *ent, int type,
+    unsigned long h)
+{
+	STACK_OF(X509) *certs = NULL;
+	STACK_OF(X509_CRL) *crls = NULL;
+	BY_DIR_FILE key, *file;
+	X509_INFO *xi;
+	X509_CRL *crl;
+	X509 *x;
+	int i, j, k;
+
+	if (type == X509_LU_X509)
+		certs = sk_X509_new_null();
+	else
+		crls = sk_X509_CRL_new_null();
+	if (certs == NULL && crls == NULL)
+		return 1;
+
+	key.hash = h;
+	key.crl = (type == X509_LU_CRL);
+	key.suffix = 0;
+
+	pthread_mutex_lock(&ctx->index_lock);
+	if (!ctx->indexed) {
+		pthread_mutex_unlock(&ctx->index_lock);
+		sk_X509_free(certs);
+		sk_X509_CRL_free(crls);
+		return 0;
+	}
+	if (!by_dir_index(ctx, ent))
+		goto unlock;
+	/* As with files on disk, stop at the first gap in the suffixes. */
+	k = 0;
+	for (i = sk_BY_DIR_FILE_find(ent->files, &key);
+	    i >= 0 && i < sk_BY_DIR_FILE_num(ent->files); i++, k++) {
+		file = sk_BY_DIR_FILE_value(ent->files, i);
+		if (file->hash != h || file->crl != key.crl ||
+		    file->suffix != k)
+			break;
+		for (j = 0; j < sk_X509_INFO_num(file->objs); j++) {
+			xi = sk_X509_INFO_value(file->objs, j);
+			if (certs != NULL) {
+				if (!sk_X509_push(certs, xi->x509))
+					goto unlock;
+				X509_up_ref(xi->x509);
+			} else {
+				if (!sk_X509_CRL_push(crls, xi->crl))
+					goto unlock;
+				X509_CRL_up_ref(xi->crl);
+			}
+		}
+	}
+ unlock:
+	pthread_mutex_unlock(&ctx->index_lock);
+
+	/* Another thread may add the same object first; that is no error. */
+	ERR_set_mark();
+	for (i = 0; i < sk_X509_num(certs); i++) {
+		x = sk_X509_value(certs, i);
+		if (!x509_store_has_object(xl->store_ctx, X509_LU_X509, x))
+			X509_STORE_add_cert(xl->store_ctx, x);
+	}
+	for (i = 0; i < sk_X509_CRL_num(crls); i++) {
+		crl = sk_X509_CRL_value(crls, i);
+		if (!x509_store_has_object(xl->store_ctx, X509_LU_CRL, crl))
+			X509_STORE_add_crl(xl->store_ctx, crl);
+	}
+	ERR_pop_to_mark();
+
+	sk_X509_pop_free(certs, X509_free);
+	sk_X509_CRL_pop_free(crls, X509_CRL_free);
+
+	return 1;
+}
+
 static int
 add_cert_dir(BY_DIR *ctx, const char *dir, int type)
 {
@@ -242,16 +688,27 @@ add_cert_dir(BY_DIR *ctx, const char *dir, int type)
 			ent->dir_type = type;
 			ent->hashes = sk_BY_DIR_HASH_new(by_dir_hash_cmp);
 			ent->dir = strndup(ss, (size_t)len);
+			ent->files = NULL;
+			ent->mtime = ent->scanned = ent->checked = 0;
+			ent->refreshing = 0;
 			if (!ent->dir || !ent->hashes) {
 				X509error(ERR_R_MALLOC_FAILURE);
 				by_dir_entry_free(ent);
 				return 0;
 			}
+			pthread_mutex_lock(&ctx->index_lock);
 			if (!sk_BY_DIR_ENTRY_push(ctx->dirs, ent)) {
+				pthread_mutex_unlock(&ctx->index_lock);
 				X509error(ERR_R_MALLOC_FAILURE);
 				by_dir_entry_free(ent);
 				return 0;
 			}
+			if (ctx->indexed && !by_dir_index(ctx, ent)) {
+				pthread_mutex_unlock(&ctx->index_lock);
+				X509error(ERR_R_MALLOC_FAILURE);
+				return 0;
+			}
+			pthread_mutex_unlock(&ctx->index_lock);
 		}
 	} while (*p++ != '\0');
 	return 1;
@@ -262,36 +719,19 @@ get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
     X509_OBJECT *ret)
 {
 	BY_DIR *ctx;
-	union	{
-		struct	{
-			X509 st_x509;
-			X509_CINF st_x509_cinf;
-		} x509;
-		struct	{
-			X509_CRL st_crl;
-			X509_CRL_INFO st_crl_info;
-		} crl;
-	} data;
 	int ok = 0;
 	int i, j, k;
 	unsigned long h;
 	BUF_MEM *b = NULL;
-	X509_OBJECT stmp, *tmp;
+	X509_OBJECT *tmp;
 	const char *postfix="";
 
 	if (name == NULL)
 		return (0);
 
-	stmp.type = type;
 	if (type == X509_LU_X509) {
-		data.x509.st_x509.cert_info = &data.x509.st_x509_cinf;
-		data.x509.st_x509_cinf.subject = name;
-		stmp.data.x509 = &data.x509.st_x509;
 		postfix="";
 	} else if (type == X509_LU_CRL) {
-		data.crl.st_crl.crl = &data.crl.st_crl_info;
-		data.crl.st_crl_info.issuer = name;
-		stmp.data.crl = &data.crl.st_crl;
 		postfix="r";
 	} else {
 		X509error(X509_R_WRONG_LOOKUP_TYPE);
@@ -311,6 +751,15 @@ get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
 		int idx;
 		BY_DIR_HASH htmp, *hent;
 		ent = sk_BY_DIR_ENTRY_value(ctx->dirs, i);
+		if (by_dir_index_load(xl, ctx, ent, type, h)) {
+			if ((tmp = x509_store_get0_object(xl->store_ctx, type,
+			    name)) == NULL)
+				continue;
+			ok = 1;
+			ret->type = tmp->type;
+			memcpy(&ret->data, &tmp->data, sizeof(ret->data));
+			goto finish;
+		}
 		j = strlen(ent->dir) + 1 + 8 + 6 + 1 + 1;
 		if (!BUF_MEM_grow(b, j)) {
 			X509error(ERR_R_MALLOC_FAILURE);
@@ -356,13 +805,7 @@ get_cert_by_subject(X509_LOOKUP *xl, int type, X509_NAME *name,
 		}
 
 		/* we have added it to the cache so now pull it out again */
-		CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-		j = sk_X509_OBJECT_find(xl->store_ctx->objs, &stmp);
-		if (j != -1)
-			tmp = sk_X509_OBJECT_value(xl->store_ctx->objs, j);
-		else
-			tmp = NULL;
-		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+		tmp = x509_store_get0_object(xl->store_ctx, type, name);
 
 		/* If a CRL, update the last file suffix added for this */
 		if (type == X509_LU_CRL) {
@@ -32,10 +32,38 @@
  */
 
 #include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <openssl/x509_vfy.h>
+
 #include "x509_issuer_cache.h"
 
+/*
+ * The cache is split into X509_ISSUER_CACHE_SHARDS shards by digest, each
+ * with its own mutex, tree and CLOCK ring, so that threads verifying
+ * different chains rarely contend. A hit still takes the shard mutex to
+ * search the tree, count the hit and mark its entry as referenced, but the
+ * entries are not reordered. On eviction the hand moves from the head of
+ * the ring, giving referenced entries a second chance at the tail, and
+ * removes the first unreferenced one.
+ *
+ * The limits are only changed with every shard mutex held and only read
+ * with one held.
+ */
+RB_HEAD(x509_issuer_tree, x509_issuer);
+TAILQ_HEAD(x509_issuer_clock, x509_issuer);
+
+struct x509_issuer_shard {
+	pthread_mutex_t mutex;
+	struct x509_issuer_tree tree;
+	struct x509_issuer_clock clock;
+	size_t count;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+
 static int
 x509_issuer_cmp(struct x509_issuer *x1, struct x509_issuer *x2)
 {
@@ -45,34 +73,169 @@ x509_issuer_cmp(struct x509_issuer *x1, struct x509_issuer *x2)
 	return memcmp(x1->child_md, x2->child_md, EVP_MAX_MD_SIZE);
 }
 
-static size_t x509_issuer_cache_count;
 static size_t x509_issuer_cache_max = X509_ISSUER_CACHE_MAX;
-static RB_HEAD(x509_issuer_tree, x509_issuer) x509_issuer_cache =
-    RB_INITIALIZER(&x509_issuer_cache);
-static TAILQ_HEAD(lruqueue, x509_issuer) x509_issuer_lru =
-    TAILQ_HEAD_INITIALIZER(x509_issuer_lru);
-static pthread_mutex_t x509_issuer_tree_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t x509_issuer_cache_max_bytes = X509_ISSUER_CACHE_MAX_BYTES;
+static struct x509_issuer_shard
+    x509_issuer_shards[X509_ISSUER_CACHE_SHARDS];
+static pthread_once_t x509_issuer_cache_once = PTHREAD_ONCE_INIT;
 
 RB_PROTOTYPE(x509_issuer_tree, x509_issuer, entry, x509_issuer_cmp);
 RB_GENERATE(x509_issuer_tree, x509_issuer, entry, x509_issuer_cmp);
 
+static void
+x509_issuer_cache_init(void)
+{
+	struct x509_issuer_shard *shard;
+	int i;
+
+	for (i = 0; i < X509_ISSUER_CACHE_SHARDS; i++) {
+		shard = &x509_issuer_shards[i];
+		pthread_mutex_init(&shard->mutex, NULL);
+		RB_INIT(&shard->tree);
+		TAILQ_INIT(&shard->clock);
+	}
+}
+
+static struct x509_issuer_shard *
+x509_issuer_shard(unsigned char *parent_md, unsigned char *child_md)
+{
+	if (pthread_once(&x509_issuer_cache_once,
+	    x509_issuer_cache_init) != 0)
+		return NULL;
+
+	return &x509_issuer_shards[(parent_md[0] ^ child_md[0]) %
+	    X509_ISSUER_CACHE_SHARDS];
+}
+
+/*
+ * The most entries a shard may hold, from the limits on the whole cache.
+ * These are split evenly and rounded up, so that a small cache still
+ * caches something. Called with a shard mutex held.
+ */
+static size_t
+x509_issuer_shard_max(void)
+{
+	size_t max = x509_issuer_cache_max;
+
+	if (x509_issuer_cache_max_bytes / sizeof(struct x509_issuer) < max)
+		max = x509_issuer_cache_max_bytes / sizeof(struct x509_issuer);
+
+	return (max + X509_ISSUER_CACHE_SHARDS - 1) / X509_ISSUER_CACHE_SHARDS;
+}
+
+static void
+x509_issuer_shard_evict(struct x509_issuer_shard *shard)
+{
+	struct x509_issuer *old;
+
+	while ((old = TAILQ_FIRST(&shard->clock)) != NULL && old->referenced) {
+		old->referenced = 0;
+		TAILQ_REMOVE(&shard->clock, old, queue);
+		TAILQ_INSERT_TAIL(&shard->clock, old, queue);
+	}
+	if (old == NULL)
+		return;
+	TAILQ_REMOVE(&shard->clock, old, queue);
+	RB_REMOVE(x509_issuer_tree, &shard->tree, old);
+	free(old);
+	shard->count--;
+	shard->evictions++;
+}
+
+static int
+x509_issuer_cache_lock_all(void)
+{
+	int i;
+
+	if (pthread_once(&x509_issuer_cache_once,
+	    x509_issuer_cache_init) != 0)
+		return 0;
+
+	for (i = 0; i < X509_ISSUER_CACHE_SHARDS; i++) {
+		if (pthread_mutex_lock(&x509_issuer_shards[i].mutex) != 0) {
+			while (--i >= 0)
+				(void) pthread_mutex_unlock(
+				    &x509_issuer_shards[i].mutex);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void
+x509_issuer_cache_unlock_all(void)
+{
+	int i;
+
+	for (i = X509_ISSUER_CACHE_SHARDS - 1; i >= 0; i--)
+		(void) pthread_mutex_unlock(&x509_issuer_shards[i].mutex);
+}
+
 /*
  * Set the maximum number of cached entries. On additions to the cache
- * the least recently used entries will be discarded so that the cache
- * stays under the maximum number of entries.  Setting a maximum of 0
+ * entries that have not been used recently will be discarded so that the
+ * cache stays under the maximum number of entries.  Setting a maximum of 0
  * disables the cache.
  */
 int
 x509_issuer_cache_set_max(size_t max)
 {
-	if (pthread_mutex_lock(&x509_issuer_tree_mutex) != 0)
+	if (!x509_issuer_cache_lock_all())
 		return 0;
 	x509_issuer_cache_max = max;
-	(void) pthread_mutex_unlock(&x509_issuer_tree_mutex);
+	x509_issuer_cache_unlock_all();
 
 	return 1;
 }
 
+int
+X509_issuer_cache_set_max(size_t max_entries, size_t max_bytes)
+{
+	if (!x509_issuer_cache_lock_all())
+		return 0;
+	x509_issuer_cache_max = max_entries;
+	x509_issuer_cache_max_bytes = max_bytes;
+	x509_issuer_cache_unlock_all();
+
+	return 1;
+}
+
+void
+X509_issuer_cache_get_stats(uint64_t *hits, uint64_t *misses,
+    uint64_t *evictions, size_t *entries, size_t *bytes)
+{
+	struct x509_issuer_shard *shard;
+	uint64_t h = 0, m = 0, e = 0;
+	size_t count = 0;
+	int i;
+
+	if (pthread_once(&x509_issuer_cache_once,
+	    x509_issuer_cache_init) == 0) {
+		for (i = 0; i < X509_ISSUER_CACHE_SHARDS; i++) {
+			shard = &x509_issuer_shards[i];
+			if (pthread_mutex_lock(&shard->mutex) != 0)
+				continue;
+			h += shard->hits;
+			m += shard->misses;
+			e += shard->evictions;
+			count += shard->count;
+			(void) pthread_mutex_unlock(&shard->mutex);
+		}
+	}
+
+	if (hits != NULL)
+		*hits = h;
+	if (misses != NULL)
+		*misses = m;
+	if (evictions != NULL)
+		*evictions = e;
+	if (entries != NULL)
+		*entries = count;
+	if (bytes != NULL)
+		*bytes = count * sizeof(struct x509_issuer);
+}
+
 /*
  * Find a previous result of checking if parent signed child
  *
@@ -84,25 +247,30 @@ x509_issuer_cache_set_max(size_t max)
 int
 x509_issuer_cache_find(unsigned char *parent_md, unsigned char *child_md)
 {
+	struct x509_issuer_shard *shard;
 	struct x509_issuer candidate, *found;
 	int ret = -1;
 
-	memset(&candidate, 0, sizeof(candidate));
-	candidate.parent_md = parent_md;
-	candidate.child_md = child_md;
-
-	if (x509_issuer_cache_max == 0)
+	if ((shard = x509_issuer_shard(parent_md, child_md)) == NULL)
 		return -1;
 
-	if (pthread_mutex_lock(&x509_issuer_tree_mutex) != 0)
+	memcpy(candidate.parent_md, parent_md, EVP_MAX_MD_SIZE);
+	memcpy(candidate.child_md, child_md, EVP_MAX_MD_SIZE);
+
+	if (pthread_mutex_lock(&shard->mutex) != 0)
 		return -1;
-	if ((found = RB_FIND(x509_issuer_tree, &x509_issuer_cache,
+	if (x509_issuer_shard_max() == 0)
+		goto done;
+	if ((found = RB_FIND(x509_issuer_tree, &shard->tree,
 	    &candidate)) != NULL) {
-		TAILQ_REMOVE(&x509_issuer_lru, found, queue);
-		TAILQ_INSERT_HEAD(&x509_issuer_lru, found, queue);
+		if (!found->referenced)
+			found->referenced = 1;
 		ret = found->valid;
-	}
-	(void) pthread_mutex_unlock(&x509_issuer_tree_mutex);
+		shard->hits++;
+	} else
+		shard->misses++;
+ done:
+	(void) pthread_mutex_unlock(&shard->mutex);
 
 	return ret;
 }
@@ -120,48 +288,37 @@ void
 x509_issuer_cache_add(unsigned char *parent_md, unsigned char *child_md,
     int valid)
 {
+	struct x509_issuer_shard *shard;
 	struct x509_issuer *new;
+	size_t max;
 
-	if (x509_issuer_cache_max == 0)
-		return;
 	if (valid != 0 && valid != 1)
 		return;
+	if ((shard = x509_issuer_shard(parent_md, child_md)) == NULL)
+		return;
 
 	if ((new = calloc(1, sizeof(struct x509_issuer))) == NULL)
 		return;
-	if ((new->parent_md = calloc(1, EVP_MAX_MD_SIZE)) == NULL)
-		goto err;
 	memcpy(new->parent_md, parent_md, EVP_MAX_MD_SIZE);
-	if ((new->child_md = calloc(1, EVP_MAX_MD_SIZE)) == NULL)
-		goto err;
 	memcpy(new->child_md, child_md, EVP_MAX_MD_SIZE);
 
 	new->valid = valid;
 
-	if (pthread_mutex_lock(&x509_issuer_tree_mutex) != 0)
+	if (pthread_mutex_lock(&shard->mutex) != 0)
 		goto err;
-	while (x509_issuer_cache_count >= x509_issuer_cache_max) {
-		struct x509_issuer *old;
-		if ((old = TAILQ_LAST(&x509_issuer_lru, lruqueue)) == NULL)
-			goto err;
-		TAILQ_REMOVE(&x509_issuer_lru, old, queue);
-		RB_REMOVE(x509_issuer_tree, &x509_issuer_cache, old);
-		free(old->parent_md);
-		free(old->child_md);
-		free(old);
-		x509_issuer_cache_count--;
-	}
-	if (RB_INSERT(x509_issuer_tree, &x509_issuer_cache, new) == NULL) {
-		TAILQ_INSERT_HEAD(&x509_issuer_lru, new, queue);
-		x509_issuer_cache_count++;
+	if ((max = x509_issuer_shard_max()) == 0)
+		goto done;
+	while (shard->count >= max && shard->count > 0)
+		x509_issuer_shard_evict(shard);
+	if (RB_INSERT(x509_issuer_tree, &shard->tree, new) == NULL) {
+		TAILQ_INSERT_TAIL(&shard->clock, new, queue);
+		shard->count++;
 		new = NULL;
 	}
+ done:
+	(void) pthread_mutex_unlock(&shard->mutex);
+
  err:
-	(void) pthread_mutex_unlock(&x509_issuer_tree_mutex);
-	if (new != NULL) {
-		free(new->parent_md);
-		free(new->child_md);
-	}
 	free(new);
 	return;
 }
@@ -59,5 +59,9 @@
 __BEGIN_HIDDEN_DECLS
 
 int x509_check_cert_time(X509_STORE_CTX *ctx, X509 *x, int quiet);
+X509_OBJECT *x509_store_get0_object(X509_STORE *store, int type,
+    X509_NAME *name);
+int x509_store_has_object(X509_STORE *store, int type, void *data);
+STACK_OF(X509) *x509_store_get1_all_certs(X509_STORE *store);
 
 __END_HIDDEN_DECLS
@@ -56,7 +56,12 @@
  * [including the GNU Public Licence.]
  */
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include <openssl/err.h>
 #include <openssl/lhash.h>
@@ -64,8 +69,6 @@
 #include <openssl/x509v3.h>
 #include "x509_lcl.h"
 
-static void X509_OBJECT_dec_ref_count(X509_OBJECT *a);
-
 X509_LOOKUP *
 X509_LOOKUP_new(X509_LOOKUP_METHOD *method)
 {
@@ -192,13 +195,326 @@ x509_object_cmp(const X509_OBJECT * const *a, const X509_OBJECT * const *b)
 	return ret;
 }
 
+/*
+ * Besides objs, the objects of a store are kept in a hash table indexed by
+ * the canonical encoding of their subject name, or issuer name for CRLs,
+ * and by the subject key identifier of certificates. Objects are only
+ * removed from a store when it is freed, so the table is append only: new
+ * entries go at the end of the table and of their chains. A lookup takes a
+ * reference to the table and notes how many entries it has, and sees just
+ * those, without copying anything. Only when the table is full is it
+ * replaced, by a copy of twice the size, and the old one is freed once the
+ * last lookup using it drops its reference.
+ *
+ * The table and its reference counts are protected by the lock of the
+ * store, which lookups hold only to take and drop their reference and
+ * writers only while adding. Chain links that a writer may extend while a
+ * lookup follows them are accessed atomically where the __atomic builtins
+ * are available; elsewhere lookups hold the lock throughout. objs, which
+ * callers of X509_STORE_get0_objects() may walk under
+ * CRYPTO_LOCK_X509_STORE, is also updated under that lock and kept sorted.
+ */
+#if defined(__ATOMIC_RELAXED) && !defined(_WIN32)
+#define X509_OBJECT_LINK_GET(p)		__atomic_load_n((p), __ATOMIC_RELAXED)
+#define X509_OBJECT_LINK_SET(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#else
+#define X509_STORE_LOCKED_READS
+#define X509_OBJECT_LINK_GET(p)		(*(p))
+#define X509_OBJECT_LINK_SET(p, v)	(*(p) = (v))
+#endif
+
+#define X509_OBJECT_TABLE_MIN	16
+
+struct x509_object_entry {
+	uint32_t name_hash;
+	uint32_t skid_hash;
+	int has_skid;
+	int name_next;
+	int skid_next;
+};
+
+struct x509_object_table {
+	X509_OBJECT **objs;
+	struct x509_object_entry *entries;
+	int *name_buckets;
+	int *skid_buckets;
+	size_t num;
+	size_t size;		/* Power of two, both capacity and buckets. */
+	int references;
+};
+
+/* What a lookup sees: the first num entries of table. */
+struct x509_object_snapshot {
+	struct x509_object_table *table;
+	int num;
+};
+
+/* X509_STORE_new() allocates this, keeping the public struct unchanged. */
+struct x509_store_internal {
+	X509_STORE store;
+	pthread_mutex_t lock;
+	struct x509_object_table *table;
+};
+
+static struct x509_store_internal *
+store_internal(X509_STORE *store)
+{
+	return (struct x509_store_internal *)store;
+}
+
+/* FNV-1a. */
+static uint32_t
+x509_object_hash(const unsigned char *data, size_t len)
+{
+	uint32_t hash = 2166136261U;
+
+	while (len-- > 0) {
+		hash ^= *data++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static int
+x509_object_name_hash(X509_NAME *name, uint32_t *hash)
+{
+	/* As in X509_NAME_cmp(), make sure the canonical encoding is current. */
+	if (name->canon_enc == NULL || name->modified) {
+		if (i2d_X509_NAME(name, NULL) < 0)
+			return 0;
+	}
+	*hash = x509_object_hash(name->canon_enc, name->canon_enclen);
+
+	return 1;
+}
+
+static X509_NAME *
+x509_object_name(const X509_OBJECT *obj)
+{
+	switch (obj->type) {
+	case X509_LU_X509:
+		return X509_get_subject_name(obj->data.x509);
+	case X509_LU_CRL:
+		return X509_CRL_get_issuer(obj->data.crl);
+	}
+	return NULL;
+}
+
+static void
+x509_object_table_free(struct x509_object_table *t)
+{
+	if (t == NULL)
+		return;
+
+	free(t->objs);
+	free(t->entries);
+	free(t->name_buckets);
+	free(t->skid_buckets);
+	free(t);
+}
+
+static struct x509_object_table *
+x509_object_table_new(size_t size)
+{
+	struct x509_object_table *t;
+	size_t i;
+
+	if ((t = calloc(1, sizeof(*t))) == NULL)
+		return NULL;
+	t->size = size;
+	t->references = 1;
+	if ((t->objs = reallocarray(NULL, size, sizeof(*t->objs))) == NULL)
+		goto err;
+	if ((t->entries = reallocarray(NULL, size,
+	    sizeof(*t->entries))) == NULL)
+		goto err;
+	if ((t->name_buckets = reallocarray(NULL, size,
+	    sizeof(*t->name_buckets))) == NULL)
+		goto err;
+	if ((t->skid_buckets = reallocarray(NULL, size,
+	    sizeof(*t->skid_buckets))) == NULL)
+		goto err;
+	for (i = 0; i < size; i++) {
+		t->name_buckets[i] = -1;
+		t->skid_buckets[i] = -1;
+	}
+
+	return t;
+
+ err:
+	x509_object_table_free(t);
+	return NULL;
+}
+
+/*
+ * Append entry idx to its chains, so that they stay in insertion order.
+ * Lookups may be following the chains at the same time.
+ */
+static void
+x509_object_table_link(struct x509_object_table *t, int idx)
+{
+	struct x509_object_entry *entry = &t->entries[idx];
+	int *p;
+
+	entry->name_next = -1;
+	entry->skid_next = -1;
+
+	p = &t->name_buckets[entry->name_hash & (t->size - 1)];
+	while (*p != -1)
+		p = &t->entries[*p].name_next;
+	X509_OBJECT_LINK_SET(p, idx);
+
+	if (!entry->has_skid)
+		return;
+	p = &t->skid_buckets[entry->skid_hash & (t->size - 1)];
+	while (*p != -1)
+		p = &t->entries[*p].skid_next;
+	X509_OBJECT_LINK_SET(p, idx);
+}
+
+/* Drop a reference to a table. Called with the store lock held. */
+static void
+x509_object_table_release(struct x509_object_table *t)
+{
+	if (--t->references == 0)
+		x509_object_table_free(t);
+}
+
+/* Add obj to the table, replacing it by a larger one if it is full. */
+static int
+x509_object_table_add(struct x509_object_table **table, X509_OBJECT *obj,
+    const struct x509_object_entry *entry)
+{
+	struct x509_object_table *t = *table, *nt;
+	size_t i;
+
+	if (t->num == t->size) {
+		if (t->size > INT_MAX / 2)
+			return 0;
+		if ((nt = x509_object_table_new(t->size * 2)) == NULL)
+			return 0;
+		for (i = 0; i < t->num; i++) {
+			nt->objs[i] = t->objs[i];
+			nt->entries[i] = t->entries[i];
+			x509_object_table_link(nt, i);
+		}
+		nt->num = t->num;
+		x509_object_table_release(t);
+		*table = t = nt;
+	}
+
+	t->objs[t->num] = obj;
+	t->entries[t->num] = *entry;
+	x509_object_table_link(t, t->num);
+	t->num++;
+
+	return 1;
+}
+
+/*
+ * Return the entry that a chain link points to, or -1 at the end of the
+ * chain. Since chains are in insertion order, the first entry that the
+ * snapshot does not include ends it as well.
+ */
+static int
+x509_object_snapshot_link(const struct x509_object_snapshot *s, int *link)
+{
+	int idx;
+
+	if ((idx = X509_OBJECT_LINK_GET(link)) >= s->num)
+		return -1;
+
+	return idx;
+}
+
+/* Return the first object from idx on along its chain with the given name. */
+static int
+x509_object_snapshot_match(const struct x509_object_snapshot *s, int idx,
+    int type, X509_NAME *name, uint32_t hash)
+{
+	struct x509_object_table *t = s->table;
+	const X509_OBJECT *obj;
+
+	for (; idx != -1;
+	    idx = x509_object_snapshot_link(s, &t->entries[idx].name_next)) {
+		obj = t->objs[idx];
+		if (obj->type != type || t->entries[idx].name_hash != hash)
+			continue;
+		if (X509_NAME_cmp(x509_object_name(obj), name) == 0)
+			return idx;
+	}
+
+	return -1;
+}
+
+static int
+x509_object_snapshot_first(const struct x509_object_snapshot *s, int type,
+    X509_NAME *name, uint32_t hash)
+{
+	struct x509_object_table *t = s->table;
+
+	return x509_object_snapshot_match(s, x509_object_snapshot_link(s,
+	    &t->name_buckets[hash & (t->size - 1)]), type, name, hash);
+}
+
+static int
+x509_object_snapshot_next(const struct x509_object_snapshot *s, int idx,
+    int type, X509_NAME *name, uint32_t hash)
+{
+	return x509_object_snapshot_match(s, x509_object_snapshot_link(s,
+	    &s->table->entries[idx].name_next), type, name, hash);
+}
+
+/*
+ * Take a snapshot of the table for a lookup, which ends with
+ * x509_store_read_end(). Objects found in it stay valid for the lifetime
+ * of the store.
+ */
+static void
+x509_store_read_begin(X509_STORE *store, struct x509_object_snapshot *s)
+{
+	struct x509_store_internal *si = store_internal(store);
+
+	(void) pthread_mutex_lock(&si->lock);
+	s->table = si->table;
+	s->num = si->table->num;
+#ifndef X509_STORE_LOCKED_READS
+	s->table->references++;
+	(void) pthread_mutex_unlock(&si->lock);
+#endif
+}
+
+static void
+x509_store_read_end(X509_STORE *store, struct x509_object_snapshot *s)
+{
+	struct x509_store_internal *si = store_internal(store);
+
+#ifndef X509_STORE_LOCKED_READS
+	(void) pthread_mutex_lock(&si->lock);
+	x509_object_table_release(s->table);
+#endif
+	(void) pthread_mutex_unlock(&si->lock);
+}
+
 X509_STORE *
 X509_STORE_new(void)
 {
+	struct x509_store_internal *si;
 	X509_STORE *ret;
 
-	if ((ret = malloc(sizeof(X509_STORE))) == NULL)
+	if ((si = malloc(sizeof(*si))) == NULL)
+		return NULL;
+	if ((si->table = x509_object_table_new(X509_OBJECT_TABLE_MIN)) == NULL) {
+		free(si);
 		return NULL;
+	}
+	if (pthread_mutex_init(&si->lock, NULL) != 0) {
+		x509_object_table_free(si->table);
+		free(si);
+		return NULL;
+	}
+	ret = &si->store;
 	ret->objs = sk_X509_OBJECT_new(x509_object_cmp);
 	ret->cache = 1;
 	ret->get_cert_methods = sk_X509_LOOKUP_new_null();
@@ -228,7 +544,9 @@ err:
 	X509_VERIFY_PARAM_free(ret->param);
 	sk_X509_LOOKUP_free(ret->get_cert_methods);
 	sk_X509_OBJECT_free(ret->objs);
-	free(ret);
+	pthread_mutex_destroy(&si->lock);
+	x509_object_table_free(si->table);
+	free(si);
 	return NULL;
 }
 
@@ -242,12 +560,14 @@ X509_OBJECT_free(X509_OBJECT *a)
 void
 X509_STORE_free(X509_STORE *vfy)
 {
+	struct x509_store_internal *si;
 	int i;
 	STACK_OF(X509_LOOKUP) *sk;
 	X509_LOOKUP *lu;
 
 	if (vfy == NULL)
 		return;
+	si = store_internal(vfy);
 
 	i = CRYPTO_add(&vfy->references, -1, CRYPTO_LOCK_X509_STORE);
 	if (i > 0)
@@ -264,7 +584,9 @@ X509_STORE_free(X509_STORE *vfy)
 
 	CRYPTO_free_ex_data(CRYPTO_EX_INDEX_X509_STORE, vfy, &vfy->ex_data);
 	X509_VERIFY_PARAM_free(vfy->param);
-	free(vfy);
+	pthread_mutex_destroy(&si->lock);
+	x509_object_table_release(si->table);
+	free(si);
 }
 
 int
@@ -312,9 +634,7 @@ X509_STORE_get_by_subject(X509_STORE_CTX *vs, int type, X509_NAME *name,
 	X509_OBJECT stmp, *tmp;
 	int i, j;
 
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-	tmp = X509_OBJECT_retrieve_by_subject(ctx->objs, type, name);
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	tmp = x509_store_get0_object(ctx, type, name);
 
 	if (tmp == NULL || type == X509_LU_CRL) {
 		for (i = vs->current_method;
@@ -345,103 +665,123 @@ X509_STORE_get_by_subject(X509_STORE_CTX *vs, int type, X509_NAME *name,
 	return 1;
 }
 
-int
-X509_STORE_add_cert(X509_STORE *ctx, X509 *x)
+static int
+x509_store_add(X509_STORE *store, void *data, int crl)
 {
-	X509_OBJECT *obj;
-	int ret = 1;
+	struct x509_store_internal *si = store_internal(store);
+	struct x509_object_snapshot snap;
+	struct x509_object_entry entry;
+	X509_OBJECT *obj, *other;
+	X509_NAME *name;
+	X509 *x;
+	int i, dup, lo, hi, mid, ret = 0;
 
-	if (x == NULL)
+	if (data == NULL)
 		return 0;
 	obj = malloc(sizeof(X509_OBJECT));
 	if (obj == NULL) {
 		X509error(ERR_R_MALLOC_FAILURE);
 		return 0;
 	}
-	obj->type = X509_LU_X509;
-	obj->data.x509 = x;
-
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-
-	X509_OBJECT_up_ref_count(obj);
-
-	if (X509_OBJECT_retrieve_match(ctx->objs, obj)) {
-		X509error(X509_R_CERT_ALREADY_IN_HASH_TABLE);
-		ret = 0;
+	if (crl) {
+		obj->type = X509_LU_CRL;
+		obj->data.crl = data;
 	} else {
-		if (sk_X509_OBJECT_push(ctx->objs, obj) == 0) {
-			X509error(ERR_R_MALLOC_FAILURE);
-			ret = 0;
-		}
+		obj->type = X509_LU_X509;
+		obj->data.x509 = data;
 	}
 
-	if (ret == 0)
-		X509_OBJECT_dec_ref_count(obj);
-
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
-
-	if (ret == 0) {
-		obj->data.x509 = NULL; /* owned by the caller */
-		X509_OBJECT_free(obj);
+	memset(&entry, 0, sizeof(entry));
+	name = x509_object_name(obj);
+	if (!x509_object_name_hash(name, &entry.name_hash))
+		goto err;
+	if (!crl) {
+		x = data;
+		/* Make sure that the subject key identifier is decoded. */
+		X509_check_purpose(x, -1, -1);
+		if (x->skid != NULL) {
+			entry.has_skid = 1;
+			entry.skid_hash = x509_object_hash(x->skid->data,
+			    x->skid->length);
+		}
 	}
 
-	return ret;
-}
-
-int
-X509_STORE_add_crl(X509_STORE *ctx, X509_CRL *x)
-{
-	X509_OBJECT *obj;
-	int ret = 1;
-
-	if (x == NULL)
-		return 0;
-	obj = malloc(sizeof(X509_OBJECT));
-	if (obj == NULL) {
-		X509error(ERR_R_MALLOC_FAILURE);
-		return 0;
+	(void) pthread_mutex_lock(&si->lock);
+
+	snap.table = si->table;
+	snap.num = si->table->num;
+	for (i = x509_object_snapshot_first(&snap, obj->type, name,
+	    entry.name_hash); i != -1; i = x509_object_snapshot_next(&snap, i,
+	    obj->type, name, entry.name_hash)) {
+		if (crl)
+			dup = !X509_CRL_match(snap.table->objs[i]->data.crl,
+			    obj->data.crl);
+		else
+			dup = !X509_cmp(snap.table->objs[i]->data.x509,
+			    obj->data.x509);
+		if (dup) {
+			X509error(X509_R_CERT_ALREADY_IN_HASH_TABLE);
+			goto unlock;
+		}
 	}
-	obj->type = X509_LU_CRL;
-	obj->data.crl = x;
 
+	/*
+	 * Insert into objs after any equal objects, keeping it sorted as
+	 * sk_X509_OBJECT_find() expects. The insertion clears the sorted
+	 * flag, which would make the next find sort the stack again.
+	 */
 	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+	lo = 0;
+	hi = sk_X509_OBJECT_num(store->objs);
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		other = sk_X509_OBJECT_value(store->objs, mid);
+		if (x509_object_cmp((const X509_OBJECT * const *)&other,
+		    (const X509_OBJECT * const *)&obj) > 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	if (sk_X509_OBJECT_insert(store->objs, obj, lo) == 0) {
+		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+		X509error(ERR_R_MALLOC_FAILURE);
+		goto unlock;
+	}
+	if (!x509_object_table_add(&si->table, obj, &entry)) {
+		(void)sk_X509_OBJECT_delete(store->objs, lo);
+		((_STACK *)store->objs)->sorted = 1;
+		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+		X509error(ERR_R_MALLOC_FAILURE);
+		goto unlock;
+	}
+	((_STACK *)store->objs)->sorted = 1;
+	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
 
 	X509_OBJECT_up_ref_count(obj);
 
-	if (X509_OBJECT_retrieve_match(ctx->objs, obj)) {
-		X509error(X509_R_CERT_ALREADY_IN_HASH_TABLE);
-		ret = 0;
-	} else {
-		if (sk_X509_OBJECT_push(ctx->objs, obj) == 0) {
-			X509error(ERR_R_MALLOC_FAILURE);
-			ret = 0;
-		}
-	}
-
-	if (ret == 0)
-		X509_OBJECT_dec_ref_count(obj);
+	ret = 1;
 
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+ unlock:
+	(void) pthread_mutex_unlock(&si->lock);
 
-	if (ret == 0) {
-		obj->data.crl = NULL; /* owned by the caller */
-		X509_OBJECT_free(obj);
-	}
+ err:
+	/* On failure the certificate or CRL is still owned by the caller. */
+	if (ret == 0)
+		free(obj);
 
 	return ret;
 }
 
-static void
-X509_OBJECT_dec_ref_count(X509_OBJECT *a)
+int
+X509_STORE_add_cert(X509_STORE *ctx, X509 *x)
 {
-	switch (a->type) {
-	case X509_LU_X509:
-		CRYPTO_add(&a->data.x509->references, -1, CRYPTO_LOCK_X509);
-		break;
-	case X509_LU_CRL:
-		CRYPTO_add(&a->data.crl->references, -1, CRYPTO_LOCK_X509_CRL);
-		break;
-	}
+	return x509_store_add(ctx, x, 0);
+}
+
+int
+X509_STORE_add_crl(X509_STORE *ctx, X509_CRL *x)
+{
+	return x509_store_add(ctx, x, 1);
 }
 
 int
@@ -556,95 +896,190 @@ X509_OBJECT_get0_X509_CRL(X509_OBJECT *xo)
 STACK_OF(X509) *
 X509_STORE_get1_certs(X509_STORE_CTX *ctx, X509_NAME *nm)
 {
-	int i, idx, cnt;
+	struct x509_object_snapshot snap;
 	STACK_OF(X509) *sk;
 	X509 *x;
-	X509_OBJECT *obj;
+	X509_OBJECT xobj;
+	uint32_t hash;
+	int i, looked_up = 0;
 
+	if (!x509_object_name_hash(nm, &hash))
+		return NULL;
 	sk = sk_X509_new_null();
 	if (sk == NULL)
 		return NULL;
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-	idx = x509_object_idx_cnt(ctx->ctx->objs, X509_LU_X509, nm, &cnt);
-	if (idx < 0) {
+
+ again:
+	x509_store_read_begin(ctx->ctx, &snap);
+	for (i = x509_object_snapshot_first(&snap, X509_LU_X509, nm, hash);
+	    i != -1;
+	    i = x509_object_snapshot_next(&snap, i, X509_LU_X509, nm, hash)) {
+		x = snap.table->objs[i]->data.x509;
+		CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509);
+		if (!sk_X509_push(sk, x)) {
+			x509_store_read_end(ctx->ctx, &snap);
+			X509_free(x);
+			sk_X509_pop_free(sk, X509_free);
+			return NULL;
+		}
+	}
+	x509_store_read_end(ctx->ctx, &snap);
+
+	if (sk_X509_num(sk) == 0 && !looked_up) {
 		/* Nothing found in cache: do lookup to possibly add new
 		 * objects to cache
 		 */
-		X509_OBJECT xobj;
-		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
 		if (!X509_STORE_get_by_subject(ctx, X509_LU_X509, nm, &xobj)) {
 			sk_X509_free(sk);
 			return NULL;
 		}
 		X509_OBJECT_free_contents(&xobj);
-		CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-		idx = x509_object_idx_cnt(ctx->ctx->objs,
-		    X509_LU_X509, nm, &cnt);
-		if (idx < 0) {
-			CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
-			sk_X509_free(sk);
-			return NULL;
-		}
+		looked_up = 1;
+		goto again;
 	}
-	for (i = 0; i < cnt; i++, idx++) {
-		obj = sk_X509_OBJECT_value(ctx->ctx->objs, idx);
-		x = obj->data.x509;
-		CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509);
-		if (!sk_X509_push(sk, x)) {
-			CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
-			X509_free(x);
-			sk_X509_pop_free(sk, X509_free);
-			return NULL;
-		}
+	if (sk_X509_num(sk) == 0) {
+		sk_X509_free(sk);
+		return NULL;
 	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
 	return sk;
-
 }
 
 STACK_OF(X509_CRL) *
 X509_STORE_get1_crls(X509_STORE_CTX *ctx, X509_NAME *nm)
 {
-	int i, idx, cnt;
+	struct x509_object_snapshot snap;
 	STACK_OF(X509_CRL) *sk;
 	X509_CRL *x;
-	X509_OBJECT *obj, xobj;
+	X509_OBJECT xobj;
+	uint32_t hash;
+	int i;
 
+	if (!x509_object_name_hash(nm, &hash))
+		return NULL;
 	sk = sk_X509_CRL_new_null();
 	if (sk == NULL)
 		return NULL;
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-	/* Check cache first */
-	idx = x509_object_idx_cnt(ctx->ctx->objs, X509_LU_CRL, nm, &cnt);
 
 	/* Always do lookup to possibly add new CRLs to cache
 	 */
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
 	if (!X509_STORE_get_by_subject(ctx, X509_LU_CRL, nm, &xobj)) {
 		sk_X509_CRL_free(sk);
 		return NULL;
 	}
 	X509_OBJECT_free_contents(&xobj);
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-	idx = x509_object_idx_cnt(ctx->ctx->objs, X509_LU_CRL, nm, &cnt);
-	if (idx < 0) {
-		CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
-		sk_X509_CRL_free(sk);
-		return NULL;
-	}
 
-	for (i = 0; i < cnt; i++, idx++) {
-		obj = sk_X509_OBJECT_value(ctx->ctx->objs, idx);
-		x = obj->data.crl;
+	x509_store_read_begin(ctx->ctx, &snap);
+	for (i = x509_object_snapshot_first(&snap, X509_LU_CRL, nm, hash);
+	    i != -1;
+	    i = x509_object_snapshot_next(&snap, i, X509_LU_CRL, nm, hash)) {
+		x = snap.table->objs[i]->data.crl;
 		CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509_CRL);
 		if (!sk_X509_CRL_push(sk, x)) {
-			CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+			x509_store_read_end(ctx->ctx, &snap);
 			X509_CRL_free(x);
 			sk_X509_CRL_pop_free(sk, X509_CRL_free);
 			return NULL;
 		}
 	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+	x509_store_read_end(ctx->ctx, &snap);
+
+	if (sk_X509_CRL_num(sk) == 0) {
+		sk_X509_CRL_free(sk);
+		return NULL;
+	}
+	return sk;
+}
+
+/*
+ * Return the first object in the store with the given type and name. It
+ * remains owned by the store.
+ */
+X509_OBJECT *
+x509_store_get0_object(X509_STORE *store, int type, X509_NAME *name)
+{
+	struct x509_object_snapshot snap;
+	X509_OBJECT *obj = NULL;
+	uint32_t hash;
+	int i;
+
+	if (!x509_object_name_hash(name, &hash))
+		return NULL;
+
+	x509_store_read_begin(store, &snap);
+	if ((i = x509_object_snapshot_first(&snap, type, name, hash)) != -1)
+		obj = snap.table->objs[i];
+	x509_store_read_end(store, &snap);
+
+	return obj;
+}
+
+/*
+ * Return whether the store holds the certificate or the CRL in data, or one
+ * matching it, as checked by x509_store_add() before adding.
+ */
+int
+x509_store_has_object(X509_STORE *store, int type, void *data)
+{
+	struct x509_object_snapshot snap;
+	X509_OBJECT *obj;
+	X509_NAME *name;
+	uint32_t hash;
+	int i, found = 0;
+
+	if (type == X509_LU_X509)
+		name = X509_get_subject_name(data);
+	else if (type == X509_LU_CRL)
+		name = X509_CRL_get_issuer(data);
+	else
+		return 0;
+	if (!x509_object_name_hash(name, &hash))
+		return 0;
+
+	x509_store_read_begin(store, &snap);
+	for (i = x509_object_snapshot_first(&snap, type, name, hash); i != -1;
+	    i = x509_object_snapshot_next(&snap, i, type, name, hash)) {
+		obj = snap.table->objs[i];
+		if (type == X509_LU_X509)
+			found = obj->data.x509 == data ||
+			    !X509_cmp(obj->data.x509, data);
+		else
+			found = obj->data.crl == data ||
+			    !X509_CRL_match(obj->data.crl, data);
+		if (found)
+			break;
+	}
+	x509_store_read_end(store, &snap);
+
+	return found;
+}
+
+/* Return all certificates in the store, each with a new reference. */
+STACK_OF(X509) *
+x509_store_get1_all_certs(X509_STORE *store)
+{
+	struct x509_object_snapshot snap;
+	STACK_OF(X509) *sk;
+	X509 *x;
+	int i;
+
+	if ((sk = sk_X509_new_null()) == NULL)
+		return NULL;
+
+	x509_store_read_begin(store, &snap);
+	for (i = 0; i < snap.num; i++) {
+		if (snap.table->objs[i]->type != X509_LU_X509)
+			continue;
+		x = snap.table->objs[i]->data.x509;
+		CRYPTO_add(&x->references, 1, CRYPTO_LOCK_X509);
+		if (!sk_X509_push(sk, x)) {
+			x509_store_read_end(store, &snap);
+			X509_free(x);
+			sk_X509_pop_free(sk, X509_free);
+			return NULL;
+		}
+	}
+	x509_store_read_end(store, &snap);
+
 	return sk;
 }
 
@@ -676,6 +1111,20 @@ X509_OBJECT_retrieve_match(STACK_OF(X509_OBJECT) *h, X509_OBJECT *x)
 	return NULL;
 }
 
+/*
+ * Add a reference to candidate to the issuers to be considered for x.
+ */
+static int
+x509_store_push_issuer(STACK_OF(X509) *candidates, X509 *candidate)
+{
+	CRYPTO_add(&candidate->references, 1, CRYPTO_LOCK_X509);
+	if (!sk_X509_push(candidates, candidate)) {
+		X509_free(candidate);
+		return 0;
+	}
+	return 1;
+}
+
 /* Try to get issuer certificate from store. Due to limitations
  * of the API this can only retrieve a single certificate matching
  * a given subject name. However it will fill the cache with all
@@ -690,9 +1139,15 @@ X509_OBJECT_retrieve_match(STACK_OF(X509_OBJECT) *h, X509_OBJECT *x)
 int
 X509_STORE_CTX_get1_issuer(X509 **issuer, X509_STORE_CTX *ctx, X509 *x)
 {
+	struct x509_object_snapshot snap;
+	struct x509_object_table *t;
+	ASN1_OCTET_STRING *keyid = NULL;
+	STACK_OF(X509) *candidates;
 	X509_NAME *xn;
-	X509_OBJECT obj, *pobj;
-	int i, ok, idx, ret;
+	X509_OBJECT obj;
+	X509 *pcert;
+	uint32_t hash, skid_hash = 0;
+	int i, ok;
 
 	*issuer = NULL;
 	xn = X509_get_issuer_name(x);
@@ -718,38 +1173,72 @@ X509_STORE_CTX_get1_issuer(X509 **issuer, X509_STORE_CTX *ctx, X509 *x)
 	}
 	X509_OBJECT_free_contents(&obj);
 
-	/* Else find index of first cert accepted by 'check_issued' */
-	ret = 0;
-	CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
-	idx = X509_OBJECT_idx_by_subject(ctx->ctx->objs, X509_LU_X509, xn);
-	if (idx != -1) /* should be true as we've had at least one match */ {
-		/* Look through all matching certs for suitable issuer */
-		for (i = idx; i < sk_X509_OBJECT_num(ctx->ctx->objs); i++) {
-			pobj = sk_X509_OBJECT_value(ctx->ctx->objs, i);
-			/* See if we've run past the matches */
-			if (pobj->type != X509_LU_X509)
-				break;
-			if (X509_NAME_cmp(xn,
-			    X509_get_subject_name(pobj->data.x509)))
-				break;
-			if (ctx->check_issued(ctx, x, pobj->data.x509)) {
-				*issuer = pobj->data.x509;
-				ret = 1;
-				/*
-				 * If times check, exit with match,
-				 * otherwise keep looking. Leave last
-				 * match in issuer so we return nearest
-				 * match if no certificate time is OK.
-				 */
-				if (x509_check_cert_time(ctx, *issuer, 1))
-					break;
-			}
+	if (!x509_object_name_hash(xn, &hash))
+		return 0;
+	X509_check_purpose(x, -1, -1);
+	if (x->akid != NULL && x->akid->keyid != NULL) {
+		keyid = x->akid->keyid;
+		skid_hash = x509_object_hash(keyid->data, keyid->length);
+	}
+
+	if ((candidates = sk_X509_new_null()) == NULL)
+		return -1;
+
+	/*
+	 * Collect the certificates with the subject key identifier named by
+	 * x first, then all with a matching subject name. The check_issued
+	 * callback may itself use the store, so it is only run once the
+	 * snapshot has been released.
+	 */
+	x509_store_read_begin(ctx->ctx, &snap);
+	if (keyid != NULL) {
+		t = snap.table;
+		for (i = x509_object_snapshot_link(&snap,
+		    &t->skid_buckets[skid_hash & (t->size - 1)]); i != -1;
+		    i = x509_object_snapshot_link(&snap,
+		    &t->entries[i].skid_next)) {
+			if (t->objs[i]->type != X509_LU_X509 ||
+			    t->entries[i].skid_hash != skid_hash)
+				continue;
+			pcert = t->objs[i]->data.x509;
+			if (ASN1_OCTET_STRING_cmp(pcert->skid, keyid) != 0 ||
+			    X509_NAME_cmp(xn, X509_get_subject_name(pcert)) != 0)
+				continue;
+			if (!x509_store_push_issuer(candidates, pcert))
+				goto err;
 		}
 	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
-	if (*issuer)
+	for (i = x509_object_snapshot_first(&snap, X509_LU_X509, xn, hash);
+	    i != -1;
+	    i = x509_object_snapshot_next(&snap, i, X509_LU_X509, xn, hash)) {
+		pcert = snap.table->objs[i]->data.x509;
+		if (!x509_store_push_issuer(candidates, pcert))
+			goto err;
+	}
+	x509_store_read_end(ctx->ctx, &snap);
+
+	/*
+	 * Leave the last match in issuer so we return the nearest match if
+	 * no certificate time is OK.
+	 */
+	for (i = 0; i < sk_X509_num(candidates); i++) {
+		pcert = sk_X509_value(candidates, i);
+		if (!ctx->check_issued(ctx, x, pcert))
+			continue;
+		*issuer = pcert;
+		if (x509_check_cert_time(ctx, pcert, 1))
+			break;
+	}
+	if (*issuer != NULL)
 		CRYPTO_add(&(*issuer)->references, 1, CRYPTO_LOCK_X509);
-	return ret;
+	sk_X509_pop_free(candidates, X509_free);
+
+	return *issuer != NULL;
+
+ err:
+	x509_store_read_end(ctx->ctx, &snap);
+	sk_X509_pop_free(candidates, X509_free);
+	return -1;
 }
 
 STACK_OF(X509_OBJECT) *
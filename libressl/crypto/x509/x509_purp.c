@@ -58,6 +58,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+#include <sched.h>
+#endif
 
 #include <openssl/opensslconf.h>
 
@@ -65,6 +68,26 @@
 #include <openssl/x509v3.h>
 #include <openssl/x509_vfy.h>
 
+/*
+ * The extensions of a certificate are decoded once, by the first thread
+ * that needs them, and only read afterwards. Where the __atomic builtins
+ * are available, the state moves from X509_EXCACHE_NONE to
+ * X509_EXCACHE_BUSY while one thread decodes and to X509_EXCACHE_DONE once
+ * the result may be read; other threads wait for a decode in progress.
+ * Without the builtins, the decode is done under CRYPTO_LOCK_X509.
+ *
+ * The state is kept in x->valid, which is zeroed when the certificate is
+ * allocated and otherwise unused, so that struct x509_st keeps its size
+ * and layout.
+ */
+#if defined(__ATOMIC_ACQUIRE) && !defined(_WIN32)
+#define X509_EXCACHE_ONCE
+#endif
+
+#define X509_EXCACHE_NONE	0
+#define X509_EXCACHE_BUSY	1
+#define X509_EXCACHE_DONE	2
+
 #define V1_ROOT (EXFLAG_V1|EXFLAG_SS)
 #define ku_reject(x, usage) \
 	(((x)->ex_flags & EXFLAG_KUSAGE) && !((x)->ex_kusage & (usage)))
@@ -75,6 +98,7 @@
 
 void x509v3_cache_extensions(X509 *x);
 
+static void x509v3_decode_extensions(X509 *x);
 static int check_ssl_ca(const X509 *x);
 static int check_purpose_ssl_client(const X509_PURPOSE *xp, const X509 *x,
     int ca);
@@ -128,13 +152,9 @@ X509_check_purpose(X509 *x, int id, int ca)
 	int idx;
 	const X509_PURPOSE *pt;
 
-	if (!(x->ex_flags & EXFLAG_SET)) {
-		CRYPTO_w_lock(CRYPTO_LOCK_X509);
-		x509v3_cache_extensions(x);
-		CRYPTO_w_unlock(CRYPTO_LOCK_X509);
-		if (x->ex_flags & EXFLAG_INVALID)
-			return X509_V_ERR_UNSPECIFIED;
-	}
+	x509v3_cache_extensions(x);
+	if (x->ex_flags & EXFLAG_INVALID)
+		return X509_V_ERR_UNSPECIFIED;
 	if (id == -1)
 		return 1;
 	idx = X509_PURPOSE_get_by_id(id);
@@ -435,6 +455,34 @@ setup_crldp(X509 *x)
 
 void
 x509v3_cache_extensions(X509 *x)
+{
+#ifdef X509_EXCACHE_ONCE
+	int state = X509_EXCACHE_NONE;
+
+	if (__atomic_load_n(&x->valid, __ATOMIC_ACQUIRE) ==
+	    X509_EXCACHE_DONE)
+		return;
+	if (__atomic_compare_exchange_n(&x->valid, &state,
+	    X509_EXCACHE_BUSY, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+		x509v3_decode_extensions(x);
+		__atomic_store_n(&x->valid, X509_EXCACHE_DONE,
+		    __ATOMIC_RELEASE);
+		return;
+	}
+	while (__atomic_load_n(&x->valid, __ATOMIC_ACQUIRE) !=
+	    X509_EXCACHE_DONE)
+		sched_yield();
+#else
+	if (x->ex_flags & EXFLAG_SET)
+		return;
+	CRYPTO_w_lock(CRYPTO_LOCK_X509);
+	x509v3_decode_extensions(x);
+	CRYPTO_w_unlock(CRYPTO_LOCK_X509);
+#endif
+}
+
+static void
+x509v3_decode_extensions(X509 *x)
 {
 	BASIC_CONSTRAINTS *bs;
 	PROXY_CERT_INFO_EXTENSION *pci;
@@ -646,13 +694,9 @@ check_ca(const X509 *x)
 int
 X509_check_ca(X509 *x)
 {
-	if (!(x->ex_flags & EXFLAG_SET)) {
-		CRYPTO_w_lock(CRYPTO_LOCK_X509);
-		x509v3_cache_extensions(x);
-		CRYPTO_w_unlock(CRYPTO_LOCK_X509);
-		if (x->ex_flags & EXFLAG_INVALID)
-			return X509_V_ERR_UNSPECIFIED;
-	}
+	x509v3_cache_extensions(x);
+	if (x->ex_flags & EXFLAG_INVALID)
+		return X509_V_ERR_UNSPECIFIED;
 
 	return check_ca(x);
 }
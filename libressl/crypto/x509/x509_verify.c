@@ -23,6 +23,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
 #include <openssl/safestack.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
@@ -375,6 +378,145 @@ x509_verify_parent_signature(X509 *parent, X509 *child,
 	return ret;
 }
 
+/*
+ * Prepare the digest of the signed part of cert for verification with
+ * pkey. Returns 1 if item is ready for EVP_PKEY_verify_batch(), 0 if the
+ * certificate has to go through X509_verify() instead and -1 if it cannot
+ * be verified. Mismatched signature algorithms are left to X509_verify(),
+ * which rejects them with 0, so that they are cached like bad signatures.
+ */
+static int
+x509_verify_batch_item(X509 *cert, EVP_PKEY *pkey, unsigned char *dgst,
+    EVP_PKEY_VERIFY_ITEM *item)
+{
+	const EVP_MD *md;
+	unsigned int dgst_len;
+	int mdnid, pknid;
+
+	if (X509_ALGOR_cmp(cert->sig_alg, cert->cert_info->signature))
+		return 0;
+	if (cert->signature->type == V_ASN1_BIT_STRING &&
+	    cert->signature->flags & 0x7)
+		return -1;
+	if (!OBJ_find_sigid_algs(OBJ_obj2nid(cert->sig_alg->algorithm),
+	    &mdnid, &pknid))
+		return -1;
+	if (mdnid == NID_undef)
+		return 0;
+	if (EVP_PKEY_base_id(pkey) != EVP_PKEY_RSA &&
+	    EVP_PKEY_base_id(pkey) != EVP_PKEY_EC)
+		return 0;
+	if (EVP_PKEY_type(pknid) != EVP_PKEY_base_id(pkey))
+		return -1;
+	if ((md = EVP_get_digestbynid(mdnid)) == NULL)
+		return -1;
+	if (!ASN1_item_digest(&X509_CINF_it, md, cert->cert_info, dgst,
+	    &dgst_len))
+		return -1;
+
+	item->pkey = pkey;
+	item->md = md;
+	item->dgst = dgst;
+	item->dgst_len = dgst_len;
+	item->sig = cert->signature->data;
+	item->sig_len = cert->signature->length;
+
+	return 1;
+}
+
+int
+X509_verify_batch(X509 *const *certs, X509 *const *issuers, int *results,
+    size_t num, EVP_PKEY_BATCH_RUNNER runner, void *runner_arg)
+{
+	unsigned char (*parent_mds)[EVP_MAX_MD_SIZE] = NULL;
+	unsigned char (*child_mds)[EVP_MAX_MD_SIZE] = NULL;
+	unsigned char (*dgsts)[EVP_MAX_MD_SIZE] = NULL;
+	unsigned char *have_md = NULL;
+	EVP_PKEY_VERIFY_ITEM *items = NULL;
+	EVP_PKEY **pkeys = NULL;
+	size_t *idx = NULL;
+	size_t i, j, n = 0;
+	int ready;
+	int ret = 0;
+
+	for (i = 0; i < num; i++)
+		results[i] = -1;
+	if (num == 0)
+		return 1;
+
+	if ((parent_mds = calloc(num, sizeof(*parent_mds))) == NULL ||
+	    (child_mds = calloc(num, sizeof(*child_mds))) == NULL ||
+	    (dgsts = calloc(num, sizeof(*dgsts))) == NULL ||
+	    (have_md = calloc(num, sizeof(*have_md))) == NULL ||
+	    (items = calloc(num, sizeof(*items))) == NULL ||
+	    (pkeys = calloc(num, sizeof(*pkeys))) == NULL ||
+	    (idx = calloc(num, sizeof(*idx))) == NULL) {
+		X509error(ERR_R_MALLOC_FAILURE);
+		goto err;
+	}
+
+	/*
+	 * Answer what we can from the issuer cache, verify anything that
+	 * cannot be expressed as a digest and a signature on the spot, and
+	 * queue the rest.
+	 */
+	for (i = 0; i < num; i++) {
+		have_md[i] = X509_digest(issuers[i], X509_VERIFY_CERT_HASH,
+		    parent_mds[i], NULL) && X509_digest(certs[i],
+		    X509_VERIFY_CERT_HASH, child_mds[i], NULL);
+		if (have_md[i] && (results[i] =
+		    x509_issuer_cache_find(parent_mds[i], child_mds[i])) >= 0)
+			continue;
+		results[i] = -1;
+
+		if ((pkeys[i] = X509_get_pubkey(issuers[i])) == NULL)
+			continue;
+		if ((ready = x509_verify_batch_item(certs[i], pkeys[i],
+		    dgsts[n], &items[n])) < 0)
+			continue;
+		if (ready > 0) {
+			idx[n++] = i;
+			continue;
+		}
+		/* Errors are not cached, so that chain building tries again. */
+		if ((results[i] = X509_verify(certs[i], pkeys[i])) > 0)
+			results[i] = 1;
+		if (results[i] >= 0 && have_md[i])
+			x509_issuer_cache_add(parent_mds[i], child_mds[i],
+			    results[i]);
+	}
+
+	EVP_PKEY_verify_batch(items, n, runner, runner_arg);
+
+	for (j = 0; j < n; j++) {
+		i = idx[j];
+		if ((results[i] = items[j].result) < 0)
+			continue;
+		if (have_md[i])
+			x509_issuer_cache_add(parent_mds[i], child_mds[i],
+			    results[i]);
+	}
+
+	ret = 1;
+	for (i = 0; i < num; i++) {
+		if (results[i] != 1)
+			ret = 0;
+	}
+
+ err:
+	for (i = 0; pkeys != NULL && i < num; i++)
+		EVP_PKEY_free(pkeys[i]);
+	free(parent_mds);
+	free(child_mds);
+	free(dgsts);
+	free(have_md);
+	free(items);
+	free(pkeys);
+	free(idx);
+
+	return ret;
+}
+
 static int
 x509_verify_consider_candidate(struct x509_verify_ctx *ctx, X509 *cert,
     unsigned char *cert_md, int is_root_cert, X509 *candidate,
@@ -752,14 +894,10 @@ x509_verify_validate_constraints(X509 *cert,
 static int
 x509_verify_cert_extensions(struct x509_verify_ctx *ctx, X509 *cert, int need_ca)
 {
-	if (!(cert->ex_flags & EXFLAG_SET)) {
-		CRYPTO_w_lock(CRYPTO_LOCK_X509);
-		x509v3_cache_extensions(cert);
-		CRYPTO_w_unlock(CRYPTO_LOCK_X509);
-		if (cert->ex_flags & EXFLAG_INVALID) {
-			ctx->error = X509_V_ERR_UNSPECIFIED;
-			return 0;
-		}
+	x509v3_cache_extensions(cert);
+	if (cert->ex_flags & EXFLAG_INVALID) {
+		ctx->error = X509_V_ERR_UNSPECIFIED;
+		return 0;
 	}
 
 	if (ctx->xsc != NULL)
@@ -63,6 +63,8 @@
 #include <openssl/objects.h>
 #include <openssl/x509.h>
 
+#include "asn1_locl.h"
+
 int
 X509_CRL_up_ref(X509_CRL *x)   
 {
@@ -152,6 +154,7 @@ X509_CRL_sort(X509_CRL *c)
 		r->sequence = i;
 	}
 	c->crl->enc.modified = 1;
+	x509_crl_index_clear(c);
 	return 1;
 }
 
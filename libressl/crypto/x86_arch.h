@@ -88,3 +88,44 @@
 #define	CPUCAP_MASK_PCLMUL	(1ULL << (32 + IA32CAP_BIT1_PCLMUL))
 #define	CPUCAP_MASK_SSSE3	(1ULL << (32 + IA32CAP_BIT1_SSSE3))
 #define	CPUCAP_MASK_AESNI	(1ULL << (32 + IA32CAP_BIT1_AESNI))
+#define	CPUCAP_MASK_AVX		(1ULL << (32 + IA32CAP_BIT1_AVX))
+
+/*
+ * The extended feature word holds the values of %ebx (low word) and %ecx
+ * (high word) after running "cpuid 7", with the AVX2, AVX-512 and vector
+ * AES and carry-less multiplication bits cleared if the operating system
+ * does not save the corresponding register state. It is computed by
+ * OPENSSL_cpuid_setup() and returned by OPENSSL_cpu_caps_ext().
+ */
+
+/* bit numbers for the extended feature word */
+#define	IA32CAP_EXT_BIT_BMI1		3
+#define	IA32CAP_EXT_BIT_AVX2		5
+#define	IA32CAP_EXT_BIT_BMI2		8
+#define	IA32CAP_EXT_BIT_AVX512F		16
+#define	IA32CAP_EXT_BIT_AVX512DQ	17
+#define	IA32CAP_EXT_BIT_ADX		19
+#define	IA32CAP_EXT_BIT_SHA		29
+#define	IA32CAP_EXT_BIT_AVX512BW	30
+#define	IA32CAP_EXT_BIT_AVX512VL	31
+
+#define	IA32CAP_EXT_BIT1_VAES		9
+#define	IA32CAP_EXT_BIT1_VPCLMULQDQ	10
+
+/* bit masks for OPENSSL_cpu_caps_ext() */
+#define	CPUCAP_EXT_MASK_BMI1		(1U << IA32CAP_EXT_BIT_BMI1)
+#define	CPUCAP_EXT_MASK_AVX2		(1U << IA32CAP_EXT_BIT_AVX2)
+#define	CPUCAP_EXT_MASK_BMI2		(1U << IA32CAP_EXT_BIT_BMI2)
+#define	CPUCAP_EXT_MASK_AVX512F		(1U << IA32CAP_EXT_BIT_AVX512F)
+#define	CPUCAP_EXT_MASK_AVX512DQ	(1U << IA32CAP_EXT_BIT_AVX512DQ)
+#define	CPUCAP_EXT_MASK_ADX		(1U << IA32CAP_EXT_BIT_ADX)
+#define	CPUCAP_EXT_MASK_SHA		(1U << IA32CAP_EXT_BIT_SHA)
+#define	CPUCAP_EXT_MASK_AVX512BW	(1U << IA32CAP_EXT_BIT_AVX512BW)
+#define	CPUCAP_EXT_MASK_AVX512VL	(1U << IA32CAP_EXT_BIT_AVX512VL)
+#define	CPUCAP_EXT_MASK_VAES		(1ULL << (32 + IA32CAP_EXT_BIT1_VAES))
+#define	CPUCAP_EXT_MASK_VPCLMULQDQ \
+	(1ULL << (32 + IA32CAP_EXT_BIT1_VPCLMULQDQ))
+
+#define	CPUCAP_EXT_MASK_AVX512	(CPUCAP_EXT_MASK_AVX512F | \
+	CPUCAP_EXT_MASK_AVX512DQ | CPUCAP_EXT_MASK_AVX512BW | \
+	CPUCAP_EXT_MASK_AVX512VL)
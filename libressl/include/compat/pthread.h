@@ -110,6 +110,34 @@ pthread_mutex_destroy(pthread_mutex_t *mutex)
 	return 0;
 }
 
+/*
+ * Thread-specific data. Destructors are not supported, so data has to be
+ * released explicitly before a thread exits.
+ */
+typedef DWORD pthread_key_t;
+
+static inline int
+pthread_key_create(pthread_key_t *key, void (*destructor)(void *))
+{
+	if ((*key = TlsAlloc()) == TLS_OUT_OF_INDEXES)
+		return -1;
+	return 0;
+}
+
+static inline void *
+pthread_getspecific(pthread_key_t key)
+{
+	return TlsGetValue(key);
+}
+
+static inline int
+pthread_setspecific(pthread_key_t key, const void *value)
+{
+	if (!TlsSetValue(key, (LPVOID)value))
+		return -1;
+	return 0;
+}
+
 #else
 #include_next <pthread.h>
 #endif
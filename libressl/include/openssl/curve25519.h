@@ -18,6 +18,7 @@
 #ifndef HEADER_CURVE25519_H
 #define HEADER_CURVE25519_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <openssl/opensslconf.h>
@@ -61,6 +62,56 @@ int X25519(uint8_t out_shared_key[X25519_KEY_LENGTH],
     const uint8_t private_key[X25519_KEY_LENGTH],
     const uint8_t peers_public_value[X25519_KEY_LENGTH]);
 
+/*
+ * Ed25519.
+ *
+ * Ed25519 is a signature scheme using a twisted Edwards curve that is
+ * birationally equivalent to curve25519. See https://ed25519.cr.yp.to/
+ * and https://tools.ietf.org/html/rfc8032.
+ */
+
+#define ED25519_PRIVATE_KEY_LENGTH 32
+#define ED25519_PUBLIC_KEY_LENGTH 32
+#define ED25519_SIGNATURE_LENGTH 64
+
+/*
+ * ED25519_keypair sets |out_public_key| and |out_private_key| to a freshly
+ * generated public/private key pair. The private key is the 32 byte seed
+ * from RFC 8032.
+ */
+void ED25519_keypair(uint8_t out_public_key[ED25519_PUBLIC_KEY_LENGTH],
+    uint8_t out_private_key[ED25519_PRIVATE_KEY_LENGTH]);
+
+/*
+ * ED25519_sign writes a 64 byte signature of |message| to |out_sig|, using
+ * |private_key| and the matching |public_key|. It returns one on success
+ * and zero on error.
+ */
+int ED25519_sign(uint8_t *out_sig, const uint8_t *message, size_t message_len,
+    const uint8_t public_key[ED25519_PUBLIC_KEY_LENGTH],
+    const uint8_t private_key[ED25519_PRIVATE_KEY_LENGTH]);
+
+/*
+ * ED25519_verify returns one if |signature| is a valid signature of
+ * |message| by |public_key| and zero otherwise. It uses the cofactored
+ * equation from RFC 8032 and rejects public keys and R values that are not
+ * canonically encoded or have small order.
+ */
+int ED25519_verify(const uint8_t *message, size_t message_len,
+    const uint8_t signature[ED25519_SIGNATURE_LENGTH],
+    const uint8_t public_key[ED25519_PUBLIC_KEY_LENGTH]);
+
+/*
+ * ED25519_verify_batch checks |num| signatures at once, where signature i
+ * is |signatures[i]| over the |message_lens[i]| bytes at |messages[i]| by
+ * |public_keys[i]|. It returns one if all of them are valid and zero if
+ * at least one is not, without saying which. Callers that need to know
+ * should fall back to ED25519_verify, which accepts the same signatures.
+ */
+int ED25519_verify_batch(const uint8_t *const *messages,
+    const size_t *message_lens, const uint8_t *const *signatures,
+    const uint8_t *const *public_keys, size_t num);
+
 #if defined(__cplusplus)
 }  /* extern C */
 #endif
@@ -182,6 +182,22 @@ ECDSA_SIG *ECDSA_do_sign_ex(const unsigned char *dgst, int dgstlen,
 int ECDSA_do_verify(const unsigned char *dgst, int dgst_len,
     const ECDSA_SIG *sig, EC_KEY* eckey);
 
+/** Verifies num ECDSA signatures, where sigs[i] is checked against the
+ *  dgst_lens[i] bytes at dgsts[i] using eckeys[i]. Signatures by keys on
+ *  the same curve share their modular inversions.
+ *  \param  dgsts      hash values
+ *  \param  dgst_lens  lengths of the hash values
+ *  \param  sigs       ECDSA_SIG structures
+ *  \param  eckeys     EC_KEY objects containing public EC keys
+ *  \param  results    receives what ECDSA_do_verify would return for
+ *                     each signature
+ *  \param  num        number of signatures
+ *  \return 1 if all signatures are valid and 0 otherwise
+ */
+int ECDSA_do_verify_batch(const unsigned char *const *dgsts,
+    const int *dgst_lens, const ECDSA_SIG *const *sigs,
+    EC_KEY *const *eckeys, int *results, size_t num);
+
 const ECDSA_METHOD *ECDSA_OpenSSL(void);
 
 /** Sets the default ECDSA method
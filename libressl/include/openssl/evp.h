@@ -114,6 +114,7 @@
 #define EVP_PKEY_CMAC	NID_cmac
 #define EVP_PKEY_GOSTR12_256 NID_id_tc26_gost3410_2012_256
 #define EVP_PKEY_GOSTR12_512 NID_id_tc26_gost3410_2012_512
+#define EVP_PKEY_ED25519 NID_Ed25519
 
 #ifdef	__cplusplus
 extern "C" {
@@ -145,6 +146,7 @@ struct evp_pkey_st {
 #ifndef OPENSSL_NO_GOST
 		struct gost_key_st *gost; /* GOST */
 #endif
+		struct ecx_key_st *ecx;	/* Ed25519 */
 	} pkey;
 	int save_parameters;
 	STACK_OF(X509_ATTRIBUTE) *attributes; /* [ 0 ] */
@@ -627,11 +629,15 @@ int EVP_VerifyFinal(EVP_MD_CTX *ctx, const unsigned char *sigbuf,
 int EVP_DigestSignInit(EVP_MD_CTX *ctx, EVP_PKEY_CTX **pctx,
     const EVP_MD *type, ENGINE *e, EVP_PKEY *pkey);
 int EVP_DigestSignFinal(EVP_MD_CTX *ctx, unsigned char *sigret, size_t *siglen);
+int EVP_DigestSign(EVP_MD_CTX *ctx, unsigned char *sigret, size_t *siglen,
+    const unsigned char *tbs, size_t tbslen);
 
 int EVP_DigestVerifyInit(EVP_MD_CTX *ctx, EVP_PKEY_CTX **pctx,
     const EVP_MD *type, ENGINE *e, EVP_PKEY *pkey);
 int EVP_DigestVerifyFinal(EVP_MD_CTX *ctx, const unsigned char *sig,
     size_t siglen);
+int EVP_DigestVerify(EVP_MD_CTX *ctx, const unsigned char *sigret,
+    size_t siglen, const unsigned char *tbs, size_t tbslen);
 
 int EVP_OpenInit(EVP_CIPHER_CTX *ctx, const EVP_CIPHER *type,
     const unsigned char *ek, int ekl, const unsigned char *iv, EVP_PKEY *priv);
@@ -1151,6 +1157,14 @@ EVP_PKEY *EVP_PKEY_new_mac_key(int type, ENGINE *e, const unsigned char *key,
     int keylen);
 EVP_PKEY *EVP_PKEY_new_CMAC_key(ENGINE *e, const unsigned char *priv,
     size_t len, const EVP_CIPHER *cipher);
+EVP_PKEY *EVP_PKEY_new_raw_private_key(int type, ENGINE *engine,
+    const unsigned char *private_key, size_t len);
+EVP_PKEY *EVP_PKEY_new_raw_public_key(int type, ENGINE *engine,
+    const unsigned char *public_key, size_t len);
+int EVP_PKEY_get_raw_private_key(const EVP_PKEY *pkey,
+    unsigned char *out_private_key, size_t *out_len);
+int EVP_PKEY_get_raw_public_key(const EVP_PKEY *pkey,
+    unsigned char *out_public_key, size_t *out_len);
 
 void EVP_PKEY_CTX_set_data(EVP_PKEY_CTX *ctx, void *data);
 void *EVP_PKEY_CTX_get_data(EVP_PKEY_CTX *ctx);
@@ -1167,6 +1181,25 @@ int EVP_PKEY_sign(EVP_PKEY_CTX *ctx, unsigned char *sig, size_t *siglen,
 int EVP_PKEY_verify_init(EVP_PKEY_CTX *ctx);
 int EVP_PKEY_verify(EVP_PKEY_CTX *ctx, const unsigned char *sig, size_t siglen,
     const unsigned char *tbs, size_t tbslen);
+typedef struct evp_pkey_verify_item_st {
+	EVP_PKEY *pkey;
+	const EVP_MD *md;
+	const unsigned char *dgst;
+	size_t dgst_len;
+	const unsigned char *sig;
+	size_t sig_len;
+	int result;
+} EVP_PKEY_VERIFY_ITEM;
+
+/*
+ * Runs job(args[i]) for every i below njobs, possibly concurrently, and
+ * returns once all of them have completed.
+ */
+typedef void (*EVP_PKEY_BATCH_RUNNER)(void (*job)(void *), void **args,
+    size_t njobs, void *runner_arg);
+
+int EVP_PKEY_verify_batch(EVP_PKEY_VERIFY_ITEM *items, size_t num,
+    EVP_PKEY_BATCH_RUNNER runner, void *runner_arg);
 int EVP_PKEY_verify_recover_init(EVP_PKEY_CTX *ctx);
 int EVP_PKEY_verify_recover(EVP_PKEY_CTX *ctx, unsigned char *rout,
     size_t *routlen, const unsigned char *sig, size_t siglen);
@@ -1366,6 +1399,45 @@ int EVP_AEAD_CTX_open(const EVP_AEAD_CTX *ctx, unsigned char *out,
     size_t nonce_len, const unsigned char *in, size_t in_len,
     const unsigned char *ad, size_t ad_len);
 
+/* EVP_AEAD_IOVEC describes a single contiguous region of a scatter/gather
+ * list. Regions are processed in order, as though they had been
+ * concatenated, and zero length regions are permitted. */
+typedef struct evp_aead_iovec_st {
+	unsigned char *data;
+	size_t len;
+} EVP_AEAD_IOVEC;
+
+/* EVP_AEAD_CTX_sealv behaves like EVP_AEAD_CTX_seal, except that the input
+ * and additional data are each given as a list of in_cnt and ad_cnt regions
+ * and the ciphertext, followed by the tag, is written across the out_cnt
+ * regions of out, so the caller does not need to assemble a message from
+ * its component parts before sealing it. AES-GCM, ChaCha20-Poly1305 and
+ * XChaCha20-Poly1305 process the regions directly; other AEADs gather the
+ * input and additional data into temporary buffers and seal those.
+ *
+ * The total length of the output regions acts as max_out_len and, on
+ * success, out_len is set to the number of bytes written.
+ *
+ * If the input and output regions are aliased then each aliased output byte
+ * must be at the same offset within the output as the input byte that it
+ * overlays is within the input, that is, processing must be in-place. */
+int EVP_AEAD_CTX_sealv(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, const unsigned char *nonce,
+    size_t nonce_len, const EVP_AEAD_IOVEC *in, size_t in_cnt,
+    const EVP_AEAD_IOVEC *ad, size_t ad_cnt);
+
+/* EVP_AEAD_CTX_openv behaves like EVP_AEAD_CTX_open, except that the input
+ * (the ciphertext followed by the tag) and additional data are each given
+ * as a list of regions and the plaintext is written across the out_cnt
+ * regions of out. The tag may span input regions.
+ *
+ * The total length of the output regions acts as max_out_len and the same
+ * aliasing rules apply as for EVP_AEAD_CTX_sealv. */
+int EVP_AEAD_CTX_openv(const EVP_AEAD_CTX *ctx, const EVP_AEAD_IOVEC *out,
+    size_t out_cnt, size_t *out_len, const unsigned char *nonce,
+    size_t nonce_len, const EVP_AEAD_IOVEC *in, size_t in_cnt,
+    const EVP_AEAD_IOVEC *ad, size_t ad_cnt);
+
 void EVP_add_alg_module(void);
 
 /* BEGIN ERROR CODES */
@@ -421,6 +421,28 @@ DECLARE_SPECIAL_STACK_OF(OPENSSL_BLOCK, void)
 #define sk_BY_DIR_ENTRY_sort(st) SKM_sk_sort(BY_DIR_ENTRY, (st))
 #define sk_BY_DIR_ENTRY_is_sorted(st) SKM_sk_is_sorted(BY_DIR_ENTRY, (st))
 
+#define sk_BY_DIR_FILE_new(cmp) SKM_sk_new(BY_DIR_FILE, (cmp))
+#define sk_BY_DIR_FILE_new_null() SKM_sk_new_null(BY_DIR_FILE)
+#define sk_BY_DIR_FILE_free(st) SKM_sk_free(BY_DIR_FILE, (st))
+#define sk_BY_DIR_FILE_num(st) SKM_sk_num(BY_DIR_FILE, (st))
+#define sk_BY_DIR_FILE_value(st, i) SKM_sk_value(BY_DIR_FILE, (st), (i))
+#define sk_BY_DIR_FILE_set(st, i, val) SKM_sk_set(BY_DIR_FILE, (st), (i), (val))
+#define sk_BY_DIR_FILE_zero(st) SKM_sk_zero(BY_DIR_FILE, (st))
+#define sk_BY_DIR_FILE_push(st, val) SKM_sk_push(BY_DIR_FILE, (st), (val))
+#define sk_BY_DIR_FILE_unshift(st, val) SKM_sk_unshift(BY_DIR_FILE, (st), (val))
+#define sk_BY_DIR_FILE_find(st, val) SKM_sk_find(BY_DIR_FILE, (st), (val))
+#define sk_BY_DIR_FILE_find_ex(st, val) SKM_sk_find_ex(BY_DIR_FILE, (st), (val))
+#define sk_BY_DIR_FILE_delete(st, i) SKM_sk_delete(BY_DIR_FILE, (st), (i))
+#define sk_BY_DIR_FILE_delete_ptr(st, ptr) SKM_sk_delete_ptr(BY_DIR_FILE, (st), (ptr))
+#define sk_BY_DIR_FILE_insert(st, val, i) SKM_sk_insert(BY_DIR_FILE, (st), (val), (i))
+#define sk_BY_DIR_FILE_set_cmp_func(st, cmp) SKM_sk_set_cmp_func(BY_DIR_FILE, (st), (cmp))
+#define sk_BY_DIR_FILE_dup(st) SKM_sk_dup(BY_DIR_FILE, st)
+#define sk_BY_DIR_FILE_pop_free(st, free_func) SKM_sk_pop_free(BY_DIR_FILE, (st), (free_func))
+#define sk_BY_DIR_FILE_shift(st) SKM_sk_shift(BY_DIR_FILE, (st))
+#define sk_BY_DIR_FILE_pop(st) SKM_sk_pop(BY_DIR_FILE, (st))
+#define sk_BY_DIR_FILE_sort(st) SKM_sk_sort(BY_DIR_FILE, (st))
+#define sk_BY_DIR_FILE_is_sorted(st) SKM_sk_is_sorted(BY_DIR_FILE, (st))
+
 #define sk_BY_DIR_HASH_new(cmp) SKM_sk_new(BY_DIR_HASH, (cmp))
 #define sk_BY_DIR_HASH_new_null() SKM_sk_new_null(BY_DIR_HASH)
 #define sk_BY_DIR_HASH_free(st) SKM_sk_free(BY_DIR_HASH, (st))
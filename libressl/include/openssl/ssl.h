@@ -431,6 +431,9 @@ struct ssl_method_st {
  *	Ticket [10]             EXPLICIT OCTET STRING, -- session ticket (clients only)
  *	Compression_meth [11]   EXPLICIT OCTET STRING, -- optional compression method
  *	SRP_username [ 12 ] EXPLICIT OCTET STRING -- optional SRP username
+ *	Ticket_age_add [ 14 ] EXPLICIT INTEGER -- TLSv1.3 ticket age add
+ *	Max_early_data [ 15 ] EXPLICIT INTEGER -- TLSv1.3 early data limit
+ *	ALPN_selected [ 16 ] EXPLICIT OCTET STRING -- selected ALPN protocol
  *	}
  * Look in ssl/ssl_asn1.c for more details
  * I'm using EXPLICIT tags so I can read the damn things using asn1parse :-).
@@ -478,6 +481,8 @@ struct ssl_session_st {
 	unsigned char *tlsext_tick;	/* Session ticket */
 	size_t tlsext_ticklen;		/* Session ticket length */
 	long tlsext_tick_lifetime_hint;	/* Session lifetime hint in seconds */
+	uint32_t tlsext_tick_age_add;	/* TLSv1.3 ticket age obfuscation */
+	uint32_t max_early_data;	/* TLSv1.3 early data limit */
 
 	struct ssl_session_internal_st *internal;
 };
@@ -1473,6 +1478,11 @@ int 	SSL_peek(SSL *ssl, void *buf, int num);
 int 	SSL_write(SSL *ssl, const void *buf, int num);
 
 #if defined(LIBRESSL_HAS_TLS1_3) || defined(LIBRESSL_INTERNAL)
+int SSL_CTX_set_num_tickets(SSL_CTX *ctx, size_t num_tickets);
+size_t SSL_CTX_get_num_tickets(const SSL_CTX *ctx);
+int SSL_set_num_tickets(SSL *s, size_t num_tickets);
+size_t SSL_get_num_tickets(const SSL *s);
+
 uint32_t SSL_CTX_get_max_early_data(const SSL_CTX *ctx);
 int SSL_CTX_set_max_early_data(SSL_CTX *ctx, uint32_t max_early_data);
 
@@ -639,6 +639,8 @@ const char *X509_verify_cert_error_string(long n);
 
 #ifndef OPENSSL_NO_EVP
 int X509_verify(X509 *a, EVP_PKEY *r);
+int X509_verify_batch(X509 *const *certs, X509 *const *issuers, int *results,
+    size_t num, EVP_PKEY_BATCH_RUNNER runner, void *runner_arg);
 
 int X509_REQ_verify(X509_REQ *a, EVP_PKEY *r);
 int X509_CRL_verify(X509_CRL *a, EVP_PKEY *r);
@@ -278,6 +278,7 @@ void X509_STORE_CTX_set_depth(X509_STORE_CTX *ctx, int depth);
 #define X509_L_FILE_LOAD	1
 #define X509_L_ADD_DIR		2
 #define X509_L_MEM		3
+#define X509_L_INDEX_DIR	4
 
 #define X509_LOOKUP_load_file(x,name,type) \
 		X509_LOOKUP_ctrl((x),X509_L_FILE_LOAD,(name),(long)(type),NULL)
@@ -285,6 +286,9 @@ void X509_STORE_CTX_set_depth(X509_STORE_CTX *ctx, int depth);
 #define X509_LOOKUP_add_dir(x,name,type) \
 		X509_LOOKUP_ctrl((x),X509_L_ADD_DIR,(name),(long)(type),NULL)
 
+#define X509_LOOKUP_index_dir(x,on) \
+		X509_LOOKUP_ctrl((x),X509_L_INDEX_DIR,NULL,(long)(on),NULL)
+
 #define X509_LOOKUP_add_mem(x,iov,type) \
 		X509_LOOKUP_ctrl((x),X509_L_MEM,(const char *)(iov),\
 		(long)(type),NULL)
@@ -508,6 +512,10 @@ int	X509_STORE_load_locations (X509_STORE *ctx,
 int	X509_STORE_load_mem(X509_STORE *ctx, void *buf, int len);
 int	X509_STORE_set_default_paths(X509_STORE *ctx);
 
+int	X509_issuer_cache_set_max(size_t max_entries, size_t max_bytes);
+void	X509_issuer_cache_get_stats(uint64_t *hits, uint64_t *misses,
+	    uint64_t *evictions, size_t *entries, size_t *bytes);
+
 int X509_STORE_CTX_get_ex_new_index(long argl, void *argp, CRYPTO_EX_new *new_func,
 	CRYPTO_EX_dup *dup_func, CRYPTO_EX_free *free_func);
 int	X509_STORE_CTX_set_ex_data(X509_STORE_CTX *ctx,int idx,void *data);
@@ -1569,6 +1569,7 @@ ssl3_free(SSL *s)
 	tls13_secrets_destroy(S3I(s)->hs.tls13.secrets);
 	freezero(S3I(s)->hs.tls13.cookie, S3I(s)->hs.tls13.cookie_len);
 	tls13_clienthello_hash_clear(&S3I(s)->hs.tls13);
+	SSL_SESSION_free(S3I(s)->hs.tls13.psk_session);
 
 	sk_X509_NAME_pop_free(S3I(s)->tmp.ca_names, X509_NAME_free);
 
@@ -1614,6 +1615,8 @@ ssl3_clear(SSL *s)
 	S3I(s)->hs.tls13.cookie = NULL;
 	S3I(s)->hs.tls13.cookie_len = 0;
 	tls13_clienthello_hash_clear(&S3I(s)->hs.tls13);
+	SSL_SESSION_free(S3I(s)->hs.tls13.psk_session);
+	S3I(s)->hs.tls13.psk_session = NULL;
 
 	S3I(s)->hs.extensions_seen = 0;
 
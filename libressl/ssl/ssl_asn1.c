@@ -33,6 +33,9 @@
 #define SSLASN1_HOSTNAME_TAG		(SSLASN1_TAG | 6)
 #define SSLASN1_LIFETIME_TAG		(SSLASN1_TAG | 9)
 #define SSLASN1_TICKET_TAG		(SSLASN1_TAG | 10)
+#define SSLASN1_TICKET_AGE_ADD_TAG	(SSLASN1_TAG | 14)
+#define SSLASN1_MAX_EARLY_DATA_TAG	(SSLASN1_TAG | 15)
+#define SSLASN1_ALPN_SELECTED_TAG	(SSLASN1_TAG | 16)
 
 static uint64_t
 time_max(void)
@@ -50,6 +53,7 @@ SSL_SESSION_encode(SSL_SESSION *s, unsigned char **out, size_t *out_len,
 {
 	CBB cbb, session, cipher_suite, session_id, master_key, time, timeout;
 	CBB peer_cert, sidctx, verify_result, hostname, lifetime, ticket, value;
+	CBB age_add, max_early_data, alpn_selected;
 	unsigned char *peer_cert_bytes = NULL;
 	int len, rv = 0;
 	uint16_t cid;
@@ -178,6 +182,42 @@ SSL_SESSION_encode(SSL_SESSION *s, unsigned char **out, size_t *out_len,
 
 	/* Compression method [11]. */
 	/* SRP username [12]. */
+	/* Flags [13]. */
+
+	/* Ticket age add [14]. */
+	if (s->tlsext_tick_age_add != 0) {
+		if (!CBB_add_asn1(&session, &age_add,
+		    SSLASN1_TICKET_AGE_ADD_TAG))
+			goto err;
+		if (!CBB_add_asn1_uint64(&age_add,
+		    s->tlsext_tick_age_add))
+			goto err;
+	}
+
+	/* Max early data [15]. */
+	if (s->max_early_data != 0) {
+		if (!CBB_add_asn1(&session, &max_early_data,
+		    SSLASN1_MAX_EARLY_DATA_TAG))
+			goto err;
+		if (!CBB_add_asn1_uint64(&max_early_data,
+		    s->max_early_data))
+			goto err;
+	}
+
+	/*
+	 * ALPN selected [16] - only sessions made by SSL_SESSION_new() have
+	 * the internal part.
+	 */
+	if (s->internal != NULL && s->internal->alpn_selected_len > 0) {
+		if (!CBB_add_asn1(&session, &alpn_selected,
+		    SSLASN1_ALPN_SELECTED_TAG))
+			goto err;
+		if (!CBB_add_asn1(&alpn_selected, &value, CBS_ASN1_OCTETSTRING))
+			goto err;
+		if (!CBB_add_bytes(&value, s->internal->alpn_selected,
+		    s->internal->alpn_selected_len))
+			goto err;
+	}
 
 	if (!CBB_finish(&cbb, out, out_len))
 		goto err;
@@ -244,8 +284,9 @@ SSL_SESSION *
 d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp, long length)
 {
 	CBS cbs, session, cipher_suite, session_id, master_key, peer_cert;
-	CBS hostname, ticket;
+	CBS hostname, ticket, alpn_selected;
 	uint64_t version, tls_version, stime, timeout, verify_result, lifetime;
+	uint64_t age_add, max_early_data;
 	const unsigned char *peer_cert_bytes;
 	uint16_t cipher_value;
 	SSL_SESSION *s = NULL;
@@ -413,6 +454,36 @@ d2i_SSL_SESSION(SSL_SESSION **a, const unsigned char **pp, long length)
 
 	/* Compression method [11]. */
 	/* SRP username [12]. */
+	/* Flags [13]. */
+
+	/* Ticket age add [14]. */
+	if (!CBS_get_optional_asn1_uint64(&session, &age_add,
+	    SSLASN1_TICKET_AGE_ADD_TAG, 0))
+		goto err;
+	if (age_add > UINT32_MAX)
+		goto err;
+	s->tlsext_tick_age_add = (uint32_t)age_add;
+
+	/* Max early data [15]. */
+	if (!CBS_get_optional_asn1_uint64(&session, &max_early_data,
+	    SSLASN1_MAX_EARLY_DATA_TAG, 0))
+		goto err;
+	if (max_early_data > UINT32_MAX)
+		goto err;
+	s->max_early_data = (uint32_t)max_early_data;
+
+	/* ALPN selected [16]. */
+	free(s->internal->alpn_selected);
+	s->internal->alpn_selected = NULL;
+	s->internal->alpn_selected_len = 0;
+	if (!CBS_get_optional_asn1_octet_string(&session, &alpn_selected,
+	    &present, SSLASN1_ALPN_SELECTED_TAG))
+		goto err;
+	if (present) {
+		if (!CBS_stow(&alpn_selected, &s->internal->alpn_selected,
+		    &s->internal->alpn_selected_len))
+			goto err;
+	}
 
 	*pp = CBS_data(&cbs);
 
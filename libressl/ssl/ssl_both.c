@@ -589,6 +589,8 @@ ssl_cert_type(X509 *x, EVP_PKEY *pkey)
 		ret = SSL_PKEY_RSA;
 	} else if (i == EVP_PKEY_EC) {
 		ret = SSL_PKEY_ECC;
+	} else if (i == EVP_PKEY_ED25519) {
+		ret = SSL_PKEY_ED25519;
 	} else if (i == NID_id_GostR3410_2001 ||
 	    i == NID_id_GostR3410_2001_cc) {
 		ret = SSL_PKEY_GOST01;
@@ -252,6 +252,10 @@ ssl_cert_dup(CERT *cert)
 				/* We have a GOST key */
 				break;
 
+			case SSL_PKEY_ED25519:
+				/* We have an Ed25519 key */
+				break;
+
 			default:
 				/* Can't happen. */
 				SSLerrorx(SSL_R_LIBRARY_BUG);
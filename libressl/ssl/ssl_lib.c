@@ -260,6 +260,8 @@ SSL_new(SSL_CTX *ctx)
 	s->internal->options = ctx->internal->options;
 	s->internal->mode = ctx->internal->mode;
 	s->internal->max_cert_list = ctx->internal->max_cert_list;
+	s->internal->num_tickets = ctx->internal->num_tickets;
+	s->internal->max_early_data = ctx->internal->max_early_data;
 
 	if ((s->cert = ssl_cert_dup(ctx->internal->cert)) == NULL)
 		goto err;
@@ -409,26 +411,7 @@ int
 SSL_has_matching_session_id(const SSL *ssl, const unsigned char *id,
     unsigned int id_len)
 {
-	/*
-	 * A quick examination of SSL_SESSION_hash and SSL_SESSION_cmp
-	 * shows how we can "construct" a session to give us the desired
-	 * check - ie. to find if there's a session in the hash table
-	 * that would conflict with any new session built out of this
-	 * id/id_len and the ssl_version in use by this SSL.
-	 */
-	SSL_SESSION r, *p;
-
-	if (id_len > sizeof r.session_id)
-		return (0);
-
-	r.ssl_version = ssl->version;
-	r.session_id_length = id_len;
-	memcpy(r.session_id, id, id_len);
-
-	CRYPTO_r_lock(CRYPTO_LOCK_SSL_CTX);
-	p = lh_SSL_SESSION_retrieve(ssl->ctx->internal->sessions, &r);
-	CRYPTO_r_unlock(CRYPTO_LOCK_SSL_CTX);
-	return (p != NULL);
+	return ssl_session_cache_has_id(ssl->ctx, ssl->version, id, id_len);
 }
 
 int
@@ -1017,34 +1000,69 @@ SSL_write(SSL *s, const void *buf, int num)
 	return ssl3_write(s, buf, num);
 }
 
+int
+SSL_CTX_set_num_tickets(SSL_CTX *ctx, size_t num_tickets)
+{
+	ctx->internal->num_tickets = num_tickets;
+
+	return 1;
+}
+
+size_t
+SSL_CTX_get_num_tickets(const SSL_CTX *ctx)
+{
+	return ctx->internal->num_tickets;
+}
+
+int
+SSL_set_num_tickets(SSL *s, size_t num_tickets)
+{
+	s->internal->num_tickets = num_tickets;
+
+	return 1;
+}
+
+size_t
+SSL_get_num_tickets(const SSL *s)
+{
+	return s->internal->num_tickets;
+}
+
 uint32_t
 SSL_CTX_get_max_early_data(const SSL_CTX *ctx)
 {
-	return 0;
+	return ctx->internal->max_early_data;
 }
 
 int
 SSL_CTX_set_max_early_data(SSL_CTX *ctx, uint32_t max_early_data)
 {
+	ctx->internal->max_early_data = max_early_data;
 	return 1;
 }
 
 uint32_t
 SSL_get_max_early_data(const SSL *s)
 {
-	return 0;
+	return s->internal->max_early_data;
 }
 
 int
 SSL_set_max_early_data(SSL *s, uint32_t max_early_data)
 {
+	s->internal->max_early_data = max_early_data;
 	return 1;
 }
 
 int
 SSL_get_early_data_status(const SSL *s)
 {
-	return SSL_EARLY_DATA_REJECTED;
+	if (S3I(s)->hs.tls13.early_data_accepted)
+		return SSL_EARLY_DATA_ACCEPTED;
+	if (S3I(s)->hs.tls13.early_data)
+		return SSL_EARLY_DATA_REJECTED;
+
+	return SSL_EARLY_DATA_NOT_SENT;
 }
 
 int
@@ -1052,20 +1070,36 @@ SSL_read_early_data(SSL *s, void *buf, size_t num, size_t *readbytes)
 {
 	*readbytes = 0;
 
+	if (s->internal->handshake_func == NULL)
+		SSL_set_accept_state(s);
+
 	if (!s->server) {
 		SSLerror(s, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
 		return SSL_READ_EARLY_DATA_ERROR;
 	}
 
-	return SSL_READ_EARLY_DATA_FINISH;
+	/* Early data only exists with TLSv1.3. */
+	if (s->method->internal->max_tls_version < TLS1_3_VERSION)
+		return SSL_READ_EARLY_DATA_FINISH;
+
+	return tls13_legacy_read_early_data(s, buf, num, readbytes);
 }
 
 int
 SSL_write_early_data(SSL *s, const void *buf, size_t num, size_t *written)
 {
 	*written = 0;
-	SSLerror(s, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
-	return 0;
+
+	if (s->internal->handshake_func == NULL)
+		SSL_set_connect_state(s);
+
+	if (s->server ||
+	    s->method->internal->max_tls_version < TLS1_3_VERSION) {
+		SSLerror(s, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+		return 0;
+	}
+
+	return tls13_legacy_write_early_data(s, buf, num, written);
 }
 
 int
@@ -1196,7 +1230,7 @@ SSL_callback_ctrl(SSL *s, int cmd, void (*fp)(void))
 struct lhash_st_SSL_SESSION *
 SSL_CTX_sessions(SSL_CTX *ctx)
 {
-	return (ctx->internal->sessions);
+	return (ssl_session_cache_sessions(ctx));
 }
 
 long
@@ -1237,7 +1271,7 @@ SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
 		return (ctx->internal->session_cache_mode);
 
 	case SSL_CTRL_SESS_NUMBER:
-		return (lh_SSL_SESSION_num_items(ctx->internal->sessions));
+		return (ssl_session_cache_num_items(ctx));
 	case SSL_CTRL_SESS_CONNECT:
 		return (ctx->internal->stats.sess_connect);
 	case SSL_CTRL_SESS_CONNECT_GOOD:
@@ -1738,61 +1772,6 @@ SSL_export_keying_material(SSL *s, unsigned char *out, size_t olen,
 	    use_context));
 }
 
-static unsigned long
-ssl_session_hash(const SSL_SESSION *a)
-{
-	unsigned long	l;
-
-	l = (unsigned long)
-	    ((unsigned int) a->session_id[0]     )|
-	    ((unsigned int) a->session_id[1]<< 8L)|
-	    ((unsigned long)a->session_id[2]<<16L)|
-	    ((unsigned long)a->session_id[3]<<24L);
-	return (l);
-}
-
-/*
- * NB: If this function (or indeed the hash function which uses a sort of
- * coarser function than this one) is changed, ensure
- * SSL_CTX_has_matching_session_id() is checked accordingly. It relies on being
- * able to construct an SSL_SESSION that will collide with any existing session
- * with a matching session ID.
- */
-static int
-ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b)
-{
-	if (a->ssl_version != b->ssl_version)
-		return (1);
-	if (a->session_id_length != b->session_id_length)
-		return (1);
-	if (timingsafe_memcmp(a->session_id, b->session_id, a->session_id_length) != 0)
-		return (1);
-	return (0);
-}
-
-/*
- * These wrapper functions should remain rather than redeclaring
- * SSL_SESSION_hash and SSL_SESSION_cmp for void* types and casting each
- * variable. The reason is that the functions aren't static, they're exposed via
- * ssl.h.
- */
-static unsigned long
-ssl_session_LHASH_HASH(const void *arg)
-{
-	const SSL_SESSION *a = arg;
-
-	return ssl_session_hash(a);
-}
-
-static int
-ssl_session_LHASH_COMP(const void *arg1, const void *arg2)
-{
-	const SSL_SESSION *a = arg1;
-	const SSL_SESSION *b = arg2;
-
-	return ssl_session_cmp(a, b);
-}
-
 SSL_CTX *
 SSL_CTX_new(const SSL_METHOD *meth)
 {
@@ -1833,8 +1812,6 @@ SSL_CTX_new(const SSL_METHOD *meth)
 	ret->cert_store = NULL;
 	ret->internal->session_cache_mode = SSL_SESS_CACHE_SERVER;
 	ret->internal->session_cache_size = SSL_SESSION_CACHE_MAX_SIZE_DEFAULT;
-	ret->internal->session_cache_head = NULL;
-	ret->internal->session_cache_tail = NULL;
 
 	/* We take the system default */
 	ret->session_timeout = ssl_get_default_timeout();
@@ -1856,6 +1833,7 @@ SSL_CTX_new(const SSL_METHOD *meth)
 
 	ret->internal->max_cert_list = SSL_MAX_CERT_LIST_DEFAULT;
 	ret->internal->read_ahead = 0;
+	ret->internal->num_tickets = SSL_NUM_TICKETS_DEFAULT;
 	ret->internal->msg_callback = 0;
 	ret->internal->msg_callback_arg = NULL;
 	ret->verify_mode = SSL_VERIFY_NONE;
@@ -1871,8 +1849,7 @@ SSL_CTX_new(const SSL_METHOD *meth)
 	ret->internal->app_gen_cookie_cb = 0;
 	ret->internal->app_verify_cookie_cb = 0;
 
-	ret->internal->sessions = lh_SSL_SESSION_new();
-	if (ret->internal->sessions == NULL)
+	if (!ssl_session_cache_init(ret))
 		goto err;
 	ret->cert_store = X509_STORE_new();
 	if (ret->cert_store == NULL)
@@ -1967,16 +1944,16 @@ SSL_CTX_free(SSL_CTX *ctx)
 	 * free ex_data, then finally free the cache.
 	 * (See ticket [openssl.org #212].)
 	 */
-	if (ctx->internal->sessions != NULL)
-		SSL_CTX_flush_sessions(ctx, 0);
+	SSL_CTX_flush_sessions(ctx, 0);
 
 	CRYPTO_free_ex_data(CRYPTO_EX_INDEX_SSL_CTX, ctx, &ctx->internal->ex_data);
 
-	lh_SSL_SESSION_free(ctx->internal->sessions);
+	ssl_session_cache_free(ctx);
 
 	X509_STORE_free(ctx->cert_store);
 	sk_SSL_CIPHER_free(ctx->cipher_list);
 	sk_SSL_CIPHER_free(ctx->internal->cipher_list_tls13);
+	tls13_replay_cache_free(ctx->internal->early_data_replay);
 	ssl_cert_free(ctx->internal->cert);
 	sk_X509_NAME_pop_free(ctx->internal->client_CA, X509_NAME_free);
 	sk_X509_pop_free(ctx->extra_certs, X509_free);
@@ -2266,13 +2243,16 @@ ssl_update_cache(SSL *s, int mode)
 			SSL_SESSION_free(s->session);
 	}
 
-	/* auto flush every 255 connections */
+	/*
+	 * auto flush one shard every 16 connections, which covers the entire
+	 * cache every 256 connections
+	 */
 	if ((!(i & SSL_SESS_CACHE_NO_AUTO_CLEAR)) &&
 	    ((i & mode) == mode)) {
 		if ((((mode & SSL_SESS_CACHE_CLIENT) ?
 		    s->session_ctx->internal->stats.sess_connect_good :
-		    s->session_ctx->internal->stats.sess_accept_good) & 0xff) == 0xff) {
-			SSL_CTX_flush_sessions(s->session_ctx, time(NULL));
+		    s->session_ctx->internal->stats.sess_accept_good) & 0x0f) == 0x0f) {
+			ssl_session_cache_expire(s->session_ctx, time(NULL));
 		}
 	}
 }
@@ -146,6 +146,7 @@
 #include <sys/types.h>
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -336,10 +337,17 @@ __BEGIN_HIDDEN_DECLS
 #define SSL_PKEY_RSA		0
 #define SSL_PKEY_ECC		1
 #define SSL_PKEY_GOST01		2
-#define SSL_PKEY_NUM		3
+#define SSL_PKEY_ED25519	3
+#define SSL_PKEY_NUM		4
 
 #define SSL_MAX_EMPTY_RECORDS	32
 
+/* Number of TLSv1.3 session tickets issued by default, as per OpenSSL. */
+#define SSL_NUM_TICKETS_DEFAULT	2
+
+/* Maximum TLSv1.3 ticket lifetime in seconds (RFC 8446 section 4.6.1). */
+#define TLS13_MAX_TICKET_LIFETIME	(7 * 24 * 60 * 60)
+
 /* SSL_kRSA <- RSA_ENC | (RSA_TMP & RSA_SIGN) |
  * 	    <- (EXPORT & (RSA_ENC | RSA_TMP) & RSA_SIGN)
  * SSL_kDH  <- DH_ENC & (RSA_ENC | RSA_SIGN | DSA_SIGN)
@@ -407,6 +415,10 @@ typedef struct ssl_session_internal_st {
 	uint8_t *tlsext_ecpointformatlist; /* peer's list */
 	size_t tlsext_supportedgroups_length;
 	uint16_t *tlsext_supportedgroups; /* peer's list */
+
+	/* ALPN protocol selected, which TLSv1.3 early data must match. */
+	uint8_t *alpn_selected;
+	size_t alpn_selected_len;
 } SSL_SESSION_INTERNAL;
 #define SSI(s) (s->session->internal)
 
@@ -455,6 +467,31 @@ typedef struct ssl_handshake_tls13_st {
 	EVP_MD_CTX *clienthello_md_ctx;
 	unsigned char *clienthello_hash;
 	unsigned int clienthello_hash_len;
+
+	/*
+	 * Session being offered (client) or validated (server) for PSK
+	 * resumption, along with the peer's psk_key_exchange_modes.
+	 */
+	SSL_SESSION *psk_session;
+	int psk_dhe_ke;
+
+	/* Obfuscated ticket age and binder of the PSK offered by the client. */
+	uint32_t psk_ticket_age;
+	uint8_t psk_binder[EVP_MAX_MD_SIZE];
+	size_t psk_binder_len;
+
+	/*
+	 * Early data (0-RTT) - whether it was offered in the ClientHello and
+	 * accepted by the server, whether the handshake has moved beyond the
+	 * point where early data can be sent or read, and the amount sent.
+	 * The handshake pauses at that point while early_data_pause is set,
+	 * so that SSL_write_early_data() or SSL_read_early_data() can proceed.
+	 */
+	int early_data;
+	int early_data_accepted;
+	int early_data_done;
+	int early_data_pause;
+	size_t early_data_len;
 } SSL_HANDSHAKE_TLS13;
 
 typedef struct ssl_handshake_st {
@@ -545,6 +582,22 @@ int tls12_record_layer_seal_record(struct tls12_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len,
     CBB *out);
 
+/*
+ * The internal session cache is split into shards by session ID, each with
+ * its own lock, hash table and LRU list, so that lookups and inserts from
+ * different threads rarely contend with each other.
+ */
+#define SSL_SESSION_CACHE_SHARDS	16
+
+struct ssl_session_cache_shard {
+	pthread_mutex_t lock;
+	struct lhash_st_SSL_SESSION *sessions;
+
+	/* Least recently used sessions are found at the tail. */
+	struct ssl_session_st *head;
+	struct ssl_session_st *tail;
+};
+
 typedef struct ssl_ctx_internal_st {
 	uint16_t min_tls_version;
 	uint16_t max_tls_version;
@@ -612,13 +665,17 @@ typedef struct ssl_ctx_internal_st {
 	int (*tlsext_status_cb)(SSL *ssl, void *arg);
 	void *tlsext_status_arg;
 
-	struct lhash_st_SSL_SESSION *sessions;
+	struct ssl_session_cache_shard session_cache[SSL_SESSION_CACHE_SHARDS];
+
+	/* Sessions in all shards, updated with CRYPTO_add(). */
+	int session_cache_count;
+
+	/* Shard to be flushed next by ssl_session_cache_expire(). */
+	int session_cache_expire_shard;
 
 	/* Most session-ids that will be cached, default is
 	 * SSL_SESSION_CACHE_MAX_SIZE_DEFAULT. 0 is unlimited. */
 	unsigned long session_cache_size;
-	struct ssl_session_st *session_cache_head;
-	struct ssl_session_st *session_cache_tail;
 
 	/* This can have one of 2 values, ored together,
 	 * SSL_SESS_CACHE_CLIENT,
@@ -680,6 +737,16 @@ typedef struct ssl_ctx_internal_st {
 	unsigned char tlsext_tick_hmac_key[16];
 	unsigned char tlsext_tick_aes_key[16];
 
+	/* Number of TLSv1.3 session tickets to issue after a handshake. */
+	size_t num_tickets;
+
+	/*
+	 * Maximum amount of early data that we will accept, along with the
+	 * anti-replay state used to decide whether early data is accepted.
+	 */
+	uint32_t max_early_data;
+	struct tls13_replay_cache *early_data_replay;
+
 	/* SRTP profiles we are willing to do from RFC 5764 */
 	STACK_OF(SRTP_PROTECTION_PROFILE) *srtp_profiles;
 
@@ -831,6 +898,12 @@ typedef struct ssl_internal_st {
 	/* RFC4507 session ticket expected to be received or sent */
 	int tlsext_ticket_expected;
 
+	/* Number of TLSv1.3 session tickets to issue after a handshake. */
+	size_t num_tickets;
+
+	/* Maximum amount of early data that we will accept. */
+	uint32_t max_early_data;
+
 	size_t tlsext_ecpointformatlist_length;
 	uint8_t *tlsext_ecpointformatlist; /* our list */
 	size_t tlsext_supportedgroups_length;
@@ -1171,7 +1244,15 @@ int ssl_cert_add1_chain_cert(CERT *c, X509 *cert);
 
 SESS_CERT *ssl_sess_cert_new(void);
 void ssl_sess_cert_free(SESS_CERT *sc);
+int ssl_session_cache_init(SSL_CTX *ctx);
+void ssl_session_cache_free(SSL_CTX *ctx);
+void ssl_session_cache_expire(SSL_CTX *ctx, long t);
+int ssl_session_cache_has_id(SSL_CTX *ctx, int ssl_version,
+    const unsigned char *id, unsigned int id_len);
+unsigned long ssl_session_cache_num_items(SSL_CTX *ctx);
+struct lhash_st_SSL_SESSION *ssl_session_cache_sessions(SSL_CTX *ctx);
 int ssl_get_new_session(SSL *s, int session);
+SSL_SESSION *ssl_session_dup(SSL_SESSION *sess);
 int ssl_get_prev_session(SSL *s, CBS *session_id, CBS *ext_block,
     int *alert);
 int ssl_cipher_id_cmp(const SSL_CIPHER *a, const SSL_CIPHER *b);
@@ -1414,6 +1495,8 @@ int ssl_check_serverhello_tlsext(SSL *s);
 #define TLS1_TICKET_DECRYPTED		 3
 
 int tls1_process_ticket(SSL *s, CBS *ext_block, int *alert, SSL_SESSION **ret);
+int tls_decrypt_ticket(SSL *s, CBS *ticket, int *alert, SSL_SESSION **psess);
+int tls_encrypt_ticket(SSL *s, SSL_SESSION *sess, CBB *ticket);
 
 int tls1_check_ec_server_key(SSL *s);
 
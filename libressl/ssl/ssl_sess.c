@@ -143,8 +143,10 @@
 
 #include "ssl_locl.h"
 
-static void SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s);
-static void SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s);
+static void SSL_SESSION_list_remove(struct ssl_session_cache_shard *shard,
+    SSL_SESSION *s);
+static void SSL_SESSION_list_add(struct ssl_session_cache_shard *shard,
+    SSL_SESSION *s);
 static int remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck);
 
 /* aka SSL_get0_session; gets 0 objects, just returns a copy of the pointer */
@@ -161,15 +163,12 @@ SSL_get1_session(SSL *ssl)
 	SSL_SESSION *sess;
 
 	/*
-	 * Need to lock this all up rather than just use CRYPTO_add so that
-	 * somebody doesn't free ssl->session between when we check it's
-	 * non-null and when we up the reference count.
+	 * The session reference count is updated atomically, so it must not
+	 * be modified directly. ssl->session itself is only changed by the
+	 * thread that owns the SSL.
 	 */
-	CRYPTO_w_lock(CRYPTO_LOCK_SSL_SESSION);
-	sess = ssl->session;
-	if (sess)
-		sess->references++;
-	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_SESSION);
+	if ((sess = ssl->session) != NULL)
+		CRYPTO_add(&sess->references, 1, CRYPTO_LOCK_SSL_SESSION);
 
 	return (sess);
 }
@@ -197,12 +196,14 @@ SSL_SESSION_get_ex_data(const SSL_SESSION *s, int idx)
 uint32_t
 SSL_SESSION_get_max_early_data(const SSL_SESSION *s)
 {
-	return 0;
+	return s->max_early_data;
 }
 
 int
 SSL_SESSION_set_max_early_data(SSL_SESSION *s, uint32_t max_early_data)
 {
+	s->max_early_data = max_early_data;
+
 	return 1;
 }
 
@@ -244,6 +245,79 @@ SSL_SESSION_new(void)
 	return (ss);
 }
 
+/*
+ * Copy the parts of a session that a session ticket carries. The peer
+ * certificate is shared rather than encoded and parsed again.
+ */
+SSL_SESSION *
+ssl_session_dup(SSL_SESSION *sess)
+{
+	SSL_SESSION *dup;
+
+	if ((dup = SSL_SESSION_new()) == NULL)
+		return NULL;
+
+	dup->ssl_version = sess->ssl_version;
+	dup->cipher = sess->cipher;
+	dup->cipher_id = sess->cipher_id;
+
+	if (sess->master_key_length < 0 ||
+	    (size_t)sess->master_key_length > sizeof(dup->master_key))
+		goto err;
+	memcpy(dup->master_key, sess->master_key, sess->master_key_length);
+	dup->master_key_length = sess->master_key_length;
+
+	if (sess->sid_ctx_length > sizeof(dup->sid_ctx))
+		goto err;
+	memcpy(dup->sid_ctx, sess->sid_ctx, sess->sid_ctx_length);
+	dup->sid_ctx_length = sess->sid_ctx_length;
+
+	dup->time = sess->time;
+	dup->timeout = sess->timeout;
+	dup->verify_result = sess->verify_result;
+
+	if (sess->peer != NULL) {
+		X509_up_ref(sess->peer);
+		dup->peer = sess->peer;
+	}
+
+	if (sess->tlsext_hostname != NULL) {
+		if ((dup->tlsext_hostname =
+		    strdup(sess->tlsext_hostname)) == NULL)
+			goto err;
+	}
+
+	dup->tlsext_tick_lifetime_hint = sess->tlsext_tick_lifetime_hint;
+	if (sess->tlsext_tick != NULL) {
+		if ((dup->tlsext_tick = malloc(sess->tlsext_ticklen)) == NULL)
+			goto err;
+		memcpy(dup->tlsext_tick, sess->tlsext_tick,
+		    sess->tlsext_ticklen);
+		dup->tlsext_ticklen = sess->tlsext_ticklen;
+	}
+
+	dup->tlsext_tick_age_add = sess->tlsext_tick_age_add;
+	dup->max_early_data = sess->max_early_data;
+
+	if (sess->internal->alpn_selected_len > 0) {
+		if ((dup->internal->alpn_selected =
+		    malloc(sess->internal->alpn_selected_len)) == NULL)
+			goto err;
+		memcpy(dup->internal->alpn_selected,
+		    sess->internal->alpn_selected,
+		    sess->internal->alpn_selected_len);
+		dup->internal->alpn_selected_len =
+		    sess->internal->alpn_selected_len;
+	}
+
+	return dup;
+
+ err:
+	SSL_SESSION_free(dup);
+
+	return NULL;
+}
+
 const unsigned char *
 SSL_SESSION_get_id(const SSL_SESSION *ss, unsigned int *len)
 {
@@ -426,9 +500,291 @@ ssl_get_new_session(SSL *s, int session)
 	return (1);
 }
 
+static unsigned long
+ssl_session_hash(const SSL_SESSION *a)
+{
+	unsigned long	l;
+
+	l = (unsigned long)
+	    ((unsigned int) a->session_id[0]     )|
+	    ((unsigned int) a->session_id[1]<< 8L)|
+	    ((unsigned long)a->session_id[2]<<16L)|
+	    ((unsigned long)a->session_id[3]<<24L);
+	return (l);
+}
+
+/*
+ * NB: If this function (or indeed the hash function which uses a sort of
+ * coarser function than this one) is changed, ensure
+ * ssl_session_cache_has_id() is checked accordingly. It relies on being
+ * able to construct an SSL_SESSION that will collide with any existing session
+ * with a matching session ID.
+ */
+static int
+ssl_session_cmp(const SSL_SESSION *a, const SSL_SESSION *b)
+{
+	if (a->ssl_version != b->ssl_version)
+		return (1);
+	if (a->session_id_length != b->session_id_length)
+		return (1);
+	if (timingsafe_memcmp(a->session_id, b->session_id, a->session_id_length) != 0)
+		return (1);
+	return (0);
+}
+
+/*
+ * These wrapper functions should remain rather than redeclaring
+ * SSL_SESSION_hash and SSL_SESSION_cmp for void* types and casting each
+ * variable. The reason is that the functions aren't static, they're exposed via
+ * ssl.h.
+ */
+static unsigned long
+ssl_session_LHASH_HASH(const void *arg)
+{
+	const SSL_SESSION *a = arg;
+
+	return ssl_session_hash(a);
+}
+
+static int
+ssl_session_LHASH_COMP(const void *arg1, const void *arg2)
+{
+	const SSL_SESSION *a = arg1;
+	const SSL_SESSION *b = arg2;
+
+	return ssl_session_cmp(a, b);
+}
+
+/*
+ * The session cache is split into shards, each with its own lock, hash table
+ * and LRU list, so that lookups and insertions for different sessions do not
+ * contend with each other. The hash table within a shard is indexed by the
+ * leading bytes of the session ID, so the shard is chosen by hashing all of
+ * them.
+ */
+static struct ssl_session_cache_shard *
+ssl_session_cache_shard(SSL_CTX *ctx, const unsigned char *id,
+    unsigned int id_len)
+{
+	uint32_t h = 2166136261U;
+	unsigned int i;
+
+	for (i = 0; i < id_len; i++) {
+		h ^= id[i];
+		h *= 16777619U;
+	}
+
+	return &ctx->internal->session_cache[h % SSL_SESSION_CACHE_SHARDS];
+}
+
+/*
+ * The sessions in all shards are counted together, so that the cache never
+ * holds more than the configured number once an addition has returned.
+ * Each shard keeps its own least recently used order, and a shard that is
+ * added to evicts from its own tail first, other than the session just
+ * added. Should that not be enough, the other shards are visited in turn,
+ * one lock at a time, each giving up its least recently used session.
+ */
+static void
+ssl_session_cache_count(SSL_CTX *ctx, int n)
+{
+	CRYPTO_add(&ctx->internal->session_cache_count, n,
+	    CRYPTO_LOCK_SSL_CTX);
+}
+
+static int
+ssl_session_cache_over(SSL_CTX *ctx)
+{
+	unsigned long size = ctx->internal->session_cache_size;
+	int count;
+
+	if (size == 0)
+		return 0;
+	count = CRYPTO_add(&ctx->internal->session_cache_count, 0,
+	    CRYPTO_LOCK_SSL_CTX);
+
+	return count > 0 && (unsigned long)count > size;
+}
+
+/* Called with the lock of the shard held. */
+static int
+ssl_session_cache_evict(SSL_CTX *ctx, struct ssl_session_cache_shard *shard)
+{
+	if (!remove_session_lock(ctx, shard->tail, 0))
+		return 0;
+	CRYPTO_add(&ctx->internal->stats.sess_cache_full, 1,
+	    CRYPTO_LOCK_SSL_CTX);
+
+	return 1;
+}
+
+static void
+ssl_session_cache_trim(SSL_CTX *ctx, struct ssl_session_cache_shard *from)
+{
+	struct ssl_session_cache_shard *shard;
+	size_t first, i;
+	int evicted = 1;
+
+	first = from - ctx->internal->session_cache;
+	while (evicted && ssl_session_cache_over(ctx)) {
+		evicted = 0;
+		for (i = 1; i < SSL_SESSION_CACHE_SHARDS; i++) {
+			if (!ssl_session_cache_over(ctx))
+				break;
+			shard = &ctx->internal->session_cache[
+			    (first + i) % SSL_SESSION_CACHE_SHARDS];
+			pthread_mutex_lock(&shard->lock);
+			if (ssl_session_cache_evict(ctx, shard))
+				evicted = 1;
+			pthread_mutex_unlock(&shard->lock);
+		}
+	}
+}
+
+static void
+ssl_session_view_free_doall(SSL_SESSION *s)
+{
+	SSL_SESSION_free(s);
+}
+
+static IMPLEMENT_LHASH_DOALL_FN(ssl_session_view_free, SSL_SESSION)
+
+static void
+ssl_session_view_destroy(LHASH_OF(SSL_SESSION) *view)
+{
+	if (view == NULL)
+		return;
+
+	lh_SSL_SESSION_doall(view, LHASH_DOALL_FN(ssl_session_view_free));
+	lh_SSL_SESSION_free(view);
+}
+
+int
+ssl_session_cache_init(SSL_CTX *ctx)
+{
+	struct ssl_session_cache_shard *shard;
+	size_t i;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+		shard = &ctx->internal->session_cache[i];
+		if (pthread_mutex_init(&shard->lock, NULL) != 0)
+			return 0;
+		if ((shard->sessions = lh_SSL_SESSION_new()) == NULL) {
+			pthread_mutex_destroy(&shard->lock);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+void
+ssl_session_cache_free(SSL_CTX *ctx)
+{
+	struct ssl_session_cache_shard *shard;
+	size_t i;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+		shard = &ctx->internal->session_cache[i];
+		if (shard->sessions == NULL)
+			continue;
+		lh_SSL_SESSION_free(shard->sessions);
+		shard->sessions = NULL;
+		pthread_mutex_destroy(&shard->lock);
+	}
+}
+
+int
+ssl_session_cache_has_id(SSL_CTX *ctx, int ssl_version,
+    const unsigned char *id, unsigned int id_len)
+{
+	struct ssl_session_cache_shard *shard;
+	SSL_SESSION *sess;
+	SSL_SESSION data;
+
+	/*
+	 * A quick examination of SSL_SESSION_hash and SSL_SESSION_cmp
+	 * shows how we can "construct" a session to give us the desired
+	 * check - ie. to find if there's a session in the hash table
+	 * that would conflict with any new session built out of this
+	 * id/id_len and the given ssl_version.
+	 */
+	if (id_len > sizeof(data.session_id))
+		return 0;
+
+	memset(&data, 0, sizeof(data));
+
+	data.ssl_version = ssl_version;
+	data.session_id_length = id_len;
+	memcpy(data.session_id, id, id_len);
+
+	shard = ssl_session_cache_shard(ctx, id, id_len);
+
+	pthread_mutex_lock(&shard->lock);
+	sess = lh_SSL_SESSION_retrieve(shard->sessions, &data);
+	pthread_mutex_unlock(&shard->lock);
+
+	return (sess != NULL);
+}
+
+unsigned long
+ssl_session_cache_num_items(SSL_CTX *ctx)
+{
+	struct ssl_session_cache_shard *shard;
+	unsigned long num = 0;
+	size_t i;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+		shard = &ctx->internal->session_cache[i];
+		pthread_mutex_lock(&shard->lock);
+		num += lh_SSL_SESSION_num_items(shard->sessions);
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	return num;
+}
+
+/*
+ * SSL_CTX_sessions() hands out a single lhash, which the sharded cache does
+ * not have. Build one holding a reference to each session cached at the
+ * time of the call and give it to the caller, who frees the sessions and
+ * the lhash. Changes to it do not affect the cache.
+ */
+LHASH_OF(SSL_SESSION) *
+ssl_session_cache_sessions(SSL_CTX *ctx)
+{
+	struct ssl_session_cache_shard *shard;
+	LHASH_OF(SSL_SESSION) *view;
+	SSL_SESSION *s;
+	size_t i;
+
+	if ((view = lh_SSL_SESSION_new()) == NULL)
+		return NULL;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++) {
+		shard = &ctx->internal->session_cache[i];
+		pthread_mutex_lock(&shard->lock);
+		for (s = shard->head; s != NULL &&
+		    s != (SSL_SESSION *)&shard->tail; s = s->internal->next) {
+			CRYPTO_add(&s->references, 1, CRYPTO_LOCK_SSL_SESSION);
+			(void)lh_SSL_SESSION_insert(view, s);
+			if (lh_SSL_SESSION_error(view) > 0) {
+				pthread_mutex_unlock(&shard->lock);
+				SSL_SESSION_free(s);
+				ssl_session_view_destroy(view);
+				return NULL;
+			}
+		}
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	return view;
+}
+
 static SSL_SESSION *
 ssl_session_from_cache(SSL *s, CBS *session_id)
 {
+	struct ssl_session_cache_shard *shard;
 	SSL_SESSION *sess;
 	SSL_SESSION data;
 
@@ -442,14 +798,21 @@ ssl_session_from_cache(SSL *s, CBS *session_id)
 	data.session_id_length = CBS_len(session_id);
 	memcpy(data.session_id, CBS_data(session_id), CBS_len(session_id));
 
-	CRYPTO_r_lock(CRYPTO_LOCK_SSL_CTX);
-	sess = lh_SSL_SESSION_retrieve(s->session_ctx->internal->sessions, &data);
-	if (sess != NULL)
+	shard = ssl_session_cache_shard(s->session_ctx, data.session_id,
+	    data.session_id_length);
+
+	pthread_mutex_lock(&shard->lock);
+	sess = lh_SSL_SESSION_retrieve(shard->sessions, &data);
+	if (sess != NULL) {
 		CRYPTO_add(&sess->references, 1, CRYPTO_LOCK_SSL_SESSION);
-	CRYPTO_r_unlock(CRYPTO_LOCK_SSL_CTX);
+		/* Move to the head of the LRU list. */
+		SSL_SESSION_list_add(shard, sess);
+	}
+	pthread_mutex_unlock(&shard->lock);
 
 	if (sess == NULL)
-		s->session_ctx->internal->stats.sess_miss++;
+		CRYPTO_add(&s->session_ctx->internal->stats.sess_miss, 1,
+		    CRYPTO_LOCK_SSL_CTX);
 
 	return sess;
 }
@@ -476,7 +839,8 @@ ssl_session_from_callback(SSL *s, CBS *session_id)
 	if (copy)
 		CRYPTO_add(&sess->references, 1, CRYPTO_LOCK_SSL_SESSION);
 
-	s->session_ctx->internal->stats.sess_cb_hit++;
+	CRYPTO_add(&s->session_ctx->internal->stats.sess_cb_hit, 1,
+	    CRYPTO_LOCK_SSL_CTX);
 
 	/* Add the externally cached session to the internal cache as well. */
 	if (!(s->session_ctx->internal->session_cache_mode &
@@ -607,7 +971,8 @@ ssl_get_prev_session(SSL *s, CBS *session_id, CBS *ext_block, int *alert)
 	}
 
 	if (sess->timeout < (time(NULL) - sess->time)) {
-		s->session_ctx->internal->stats.sess_timeout++;
+		CRYPTO_add(&s->session_ctx->internal->stats.sess_timeout, 1,
+		    CRYPTO_LOCK_SSL_CTX);
 		if (!ticket_decrypted) {
 			/* The session was from the cache, so remove it. */
 			SSL_CTX_remove_session(s->session_ctx, sess);
@@ -615,7 +980,8 @@ ssl_get_prev_session(SSL *s, CBS *session_id, CBS *ext_block, int *alert)
 		goto err;
 	}
 
-	s->session_ctx->internal->stats.sess_hit++;
+	CRYPTO_add(&s->session_ctx->internal->stats.sess_hit, 1,
+	    CRYPTO_LOCK_SSL_CTX);
 
 	SSL_SESSION_free(s->session);
 	s->session = sess;
@@ -642,6 +1008,7 @@ ssl_get_prev_session(SSL *s, CBS *session_id, CBS *ext_block, int *alert)
 int
 SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 {
+	struct ssl_session_cache_shard *shard;
 	int ret = 0;
 	SSL_SESSION *s;
 
@@ -656,17 +1023,21 @@ SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 	 * If session c is in already in cache, we take back the increment
 	 * later.
 	 */
-	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
-	s = lh_SSL_SESSION_insert(ctx->internal->sessions, c);
+	shard = ssl_session_cache_shard(ctx, c->session_id,
+	    c->session_id_length);
+
+	pthread_mutex_lock(&shard->lock);
+	if ((s = lh_SSL_SESSION_insert(shard->sessions, c)) == NULL)
+		ssl_session_cache_count(ctx, 1);
 
 	/*
 	 * s != NULL iff we already had a session with the given PID.
 	 * In this case, s == c should hold (then we did not really modify
-	 * ctx->internal->sessions), or we're in trouble.
+	 * shard->sessions), or we're in trouble.
 	 */
 	if (s != NULL && s != c) {
 		/* We *are* in trouble ... */
-		SSL_SESSION_list_remove(ctx, s);
+		SSL_SESSION_list_remove(shard, s);
 		SSL_SESSION_free(s);
 		/*
 		 * ... so pretend the other session did not exist in cache
@@ -680,7 +1051,7 @@ SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 
 	/* Put at the head of the queue unless it is already in the cache */
 	if (s == NULL)
-		SSL_SESSION_list_add(ctx, c);
+		SSL_SESSION_list_add(shard, c);
 
 	if (s != NULL) {
 		/*
@@ -692,24 +1063,22 @@ SSL_CTX_add_session(SSL_CTX *ctx, SSL_SESSION *c)
 		ret = 0;
 	} else {
 		/*
-		 * New cache entry -- remove old ones if cache has become
+		 * New cache entry -- remove old ones if the cache has become
 		 * too large.
 		 */
 
 		ret = 1;
 
-		if (SSL_CTX_sess_get_cache_size(ctx) > 0) {
-			while (SSL_CTX_sess_number(ctx) >
-			    SSL_CTX_sess_get_cache_size(ctx)) {
-				if (!remove_session_lock(ctx,
-				    ctx->internal->session_cache_tail, 0))
-					break;
-				else
-					ctx->internal->stats.sess_cache_full++;
-			}
+		while (ssl_session_cache_over(ctx) && shard->tail != c) {
+			if (!ssl_session_cache_evict(ctx, shard))
+				break;
 		}
 	}
-	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+	pthread_mutex_unlock(&shard->lock);
+
+	if (ret)
+		ssl_session_cache_trim(ctx, shard);
+
 	return (ret);
 }
 
@@ -719,22 +1088,27 @@ SSL_CTX_remove_session(SSL_CTX *ctx, SSL_SESSION *c)
 	return remove_session_lock(ctx, c, 1);
 }
 
+/* If lck is zero, the caller already holds the lock of the session's shard. */
 static int
 remove_session_lock(SSL_CTX *ctx, SSL_SESSION *c, int lck)
 {
+	struct ssl_session_cache_shard *shard;
 	SSL_SESSION *r;
 	int ret = 0;
 
 	if ((c != NULL) && (c->session_id_length != 0)) {
+		shard = ssl_session_cache_shard(ctx, c->session_id,
+		    c->session_id_length);
 		if (lck)
-			CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
-		if ((r = lh_SSL_SESSION_retrieve(ctx->internal->sessions, c)) == c) {
+			pthread_mutex_lock(&shard->lock);
+		if ((r = lh_SSL_SESSION_retrieve(shard->sessions, c)) == c) {
 			ret = 1;
-			r = lh_SSL_SESSION_delete(ctx->internal->sessions, c);
-			SSL_SESSION_list_remove(ctx, c);
+			r = lh_SSL_SESSION_delete(shard->sessions, c);
+			SSL_SESSION_list_remove(shard, c);
+			ssl_session_cache_count(ctx, -1);
 		}
 		if (lck)
-			CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+			pthread_mutex_unlock(&shard->lock);
 
 		if (ret) {
 			r->internal->not_resumable = 1;
@@ -774,6 +1148,7 @@ SSL_SESSION_free(SSL_SESSION *ss)
 	free(ss->tlsext_tick);
 	free(ss->internal->tlsext_ecpointformatlist);
 	free(ss->internal->tlsext_supportedgroups);
+	free(ss->internal->alpn_selected);
 
 	freezero(ss->internal, sizeof(*ss->internal));
 	freezero(ss, sizeof(*ss));
@@ -979,56 +1354,63 @@ SSL_set_session_ticket_ext(SSL *s, void *ext_data, int ext_len)
 	return 0;
 }
 
-typedef struct timeout_param_st {
-	SSL_CTX *ctx;
-	long time;
-	struct lhash_st_SSL_SESSION *cache;
-} TIMEOUT_PARAM;
-
 static void
-timeout_doall_arg(SSL_SESSION *s, TIMEOUT_PARAM *p)
-{
-	if ((p->time == 0) || (p->time > (s->time + s->timeout))) {
-		/* timeout */
-		/* The reason we don't call SSL_CTX_remove_session() is to
-		 * save on locking overhead */
-		(void)lh_SSL_SESSION_delete(p->cache, s);
-		SSL_SESSION_list_remove(p->ctx, s);
-		s->internal->not_resumable = 1;
-		if (p->ctx->internal->remove_session_cb != NULL)
-			p->ctx->internal->remove_session_cb(p->ctx, s);
-		SSL_SESSION_free(s);
+ssl_session_cache_flush_shard(SSL_CTX *ctx,
+    struct ssl_session_cache_shard *shard, long t)
+{
+	SSL_SESSION *s, *prev;
+
+	if (shard->sessions == NULL)
+		return;
+
+	pthread_mutex_lock(&shard->lock);
+
+	/* Walk from the least recently used session towards the head. */
+	s = shard->tail;
+	while (s != NULL && s != (SSL_SESSION *)&shard->head) {
+		prev = s->internal->prev;
+		if (t == 0 || t > s->time + s->timeout) {
+			/* The reason we don't call SSL_CTX_remove_session() is
+			 * to save on locking overhead */
+			(void)lh_SSL_SESSION_delete(shard->sessions, s);
+			SSL_SESSION_list_remove(shard, s);
+			ssl_session_cache_count(ctx, -1);
+			s->internal->not_resumable = 1;
+			if (ctx->internal->remove_session_cb != NULL)
+				ctx->internal->remove_session_cb(ctx, s);
+			SSL_SESSION_free(s);
+		}
+		s = prev;
 	}
+
+	pthread_mutex_unlock(&shard->lock);
 }
 
-static void
-timeout_LHASH_DOALL_ARG(void *arg1, void *arg2)
+/* XXX 2038 */
+void
+SSL_CTX_flush_sessions(SSL_CTX *s, long t)
 {
-	SSL_SESSION *a = arg1;
-	TIMEOUT_PARAM *b = arg2;
+	size_t i;
 
-	timeout_doall_arg(a, b);
+	for (i = 0; i < SSL_SESSION_CACHE_SHARDS; i++)
+		ssl_session_cache_flush_shard(s,
+		    &s->internal->session_cache[i], t);
 }
 
-/* XXX 2038 */
+/*
+ * Flush the expired sessions from a single shard, moving on to the next shard
+ * with each call - this spreads the cost of expiry over many handshakes,
+ * rather than having one of them walk the entire cache.
+ */
 void
-SSL_CTX_flush_sessions(SSL_CTX *s, long t)
+ssl_session_cache_expire(SSL_CTX *ctx, long t)
 {
-	unsigned long i;
-	TIMEOUT_PARAM tp;
+	unsigned int i;
 
-	tp.ctx = s;
-	tp.cache = s->internal->sessions;
-	if (tp.cache == NULL)
-		return;
-	tp.time = t;
-	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
-	i = CHECKED_LHASH_OF(SSL_SESSION, tp.cache)->down_load;
-	CHECKED_LHASH_OF(SSL_SESSION, tp.cache)->down_load = 0;
-	lh_SSL_SESSION_doall_arg(tp.cache, timeout_LHASH_DOALL_ARG,
-	TIMEOUT_PARAM, &tp);
-	CHECKED_LHASH_OF(SSL_SESSION, tp.cache)->down_load = i;
-	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+	i = CRYPTO_add(&ctx->internal->session_cache_expire_shard, 1,
+	    CRYPTO_LOCK_SSL_CTX);
+	ssl_session_cache_flush_shard(ctx,
+	    &ctx->internal->session_cache[i % SSL_SESSION_CACHE_SHARDS], t);
 }
 
 int
@@ -1042,30 +1424,30 @@ ssl_clear_bad_session(SSL *s)
 		return (0);
 }
 
-/* locked by SSL_CTX in the calling function */
+/* locked by the shard in the calling function */
 static void
-SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
+SSL_SESSION_list_remove(struct ssl_session_cache_shard *shard, SSL_SESSION *s)
 {
 	if ((s->internal->next == NULL) || (s->internal->prev == NULL))
 		return;
 
-	if (s->internal->next == (SSL_SESSION *)&(ctx->internal->session_cache_tail)) {
+	if (s->internal->next == (SSL_SESSION *)&(shard->tail)) {
 		/* last element in list */
-		if (s->internal->prev == (SSL_SESSION *)&(ctx->internal->session_cache_head)) {
+		if (s->internal->prev == (SSL_SESSION *)&(shard->head)) {
 			/* only one element in list */
-			ctx->internal->session_cache_head = NULL;
-			ctx->internal->session_cache_tail = NULL;
+			shard->head = NULL;
+			shard->tail = NULL;
 		} else {
-			ctx->internal->session_cache_tail = s->internal->prev;
+			shard->tail = s->internal->prev;
 			s->internal->prev->internal->next =
-			    (SSL_SESSION *)&(ctx->internal->session_cache_tail);
+			    (SSL_SESSION *)&(shard->tail);
 		}
 	} else {
-		if (s->internal->prev == (SSL_SESSION *)&(ctx->internal->session_cache_head)) {
+		if (s->internal->prev == (SSL_SESSION *)&(shard->head)) {
 			/* first element in list */
-			ctx->internal->session_cache_head = s->internal->next;
+			shard->head = s->internal->next;
 			s->internal->next->internal->prev =
-			    (SSL_SESSION *)&(ctx->internal->session_cache_head);
+			    (SSL_SESSION *)&(shard->head);
 		} else {
 			/* middle of list */
 			s->internal->next->internal->prev = s->internal->prev;
@@ -1076,21 +1458,21 @@ SSL_SESSION_list_remove(SSL_CTX *ctx, SSL_SESSION *s)
 }
 
 static void
-SSL_SESSION_list_add(SSL_CTX *ctx, SSL_SESSION *s)
+SSL_SESSION_list_add(struct ssl_session_cache_shard *shard, SSL_SESSION *s)
 {
 	if ((s->internal->next != NULL) && (s->internal->prev != NULL))
-		SSL_SESSION_list_remove(ctx, s);
+		SSL_SESSION_list_remove(shard, s);
 
-	if (ctx->internal->session_cache_head == NULL) {
-		ctx->internal->session_cache_head = s;
-		ctx->internal->session_cache_tail = s;
-		s->internal->prev = (SSL_SESSION *)&(ctx->internal->session_cache_head);
-		s->internal->next = (SSL_SESSION *)&(ctx->internal->session_cache_tail);
+	if (shard->head == NULL) {
+		shard->head = s;
+		shard->tail = s;
+		s->internal->prev = (SSL_SESSION *)&(shard->head);
+		s->internal->next = (SSL_SESSION *)&(shard->tail);
 	} else {
-		s->internal->next = ctx->internal->session_cache_head;
+		s->internal->next = shard->head;
 		s->internal->next->internal->prev = s;
-		s->internal->prev = (SSL_SESSION *)&(ctx->internal->session_cache_head);
-		ctx->internal->session_cache_head = s;
+		s->internal->prev = (SSL_SESSION *)&(shard->head);
+		shard->head = s;
 	}
 }
 
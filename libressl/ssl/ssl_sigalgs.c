@@ -65,6 +65,10 @@ const struct ssl_sigalg sigalgs[] = {
 		.key_type = EVP_PKEY_EC,
 		.curve_nid = NID_X9_62_prime256v1,
 	},
+	{
+		.value = SIGALG_ED25519,
+		.key_type = EVP_PKEY_ED25519,
+	},
 #ifndef OPENSSL_NO_GOST
 	{
 		.value = SIGALG_GOSTR12_256_STREEBOG_256,
@@ -154,6 +158,7 @@ const uint16_t tls13_sigalgs[] = {
 	SIGALG_RSA_PSS_RSAE_SHA256,
 	SIGALG_RSA_PKCS1_SHA256,
 	SIGALG_ECDSA_SECP256R1_SHA256,
+	SIGALG_ED25519,
 };
 const size_t tls13_sigalgs_len = (sizeof(tls13_sigalgs) / sizeof(tls13_sigalgs[0]));
 
@@ -2541,25 +2541,11 @@ int
 ssl3_send_newsession_ticket(SSL *s)
 {
 	CBB cbb, session_ticket, ticket;
-	SSL_CTX *tctx = s->initial_ctx;
-	size_t enc_session_len, enc_session_max_len, hmac_len;
-	size_t session_len = 0;
-	unsigned char *enc_session = NULL, *session = NULL;
-	unsigned char iv[EVP_MAX_IV_LENGTH];
-	unsigned char key_name[16];
-	unsigned char *hmac;
-	unsigned int hlen;
-	EVP_CIPHER_CTX ctx;
-	HMAC_CTX hctx;
-	int len;
 
 	/*
 	 * New Session Ticket - RFC 5077, section 3.3.
 	 */
 
-	EVP_CIPHER_CTX_init(&ctx);
-	HMAC_CTX_init(&hctx);
-
 	memset(&cbb, 0, sizeof(cbb));
 
 	if (S3I(s)->hs.state == SSL3_ST_SW_SESSION_TICKET_A) {
@@ -2567,59 +2553,6 @@ ssl3_send_newsession_ticket(SSL *s)
 		    SSL3_MT_NEWSESSION_TICKET))
 			goto err;
 
-		if (!SSL_SESSION_ticket(s->session, &session, &session_len))
-			goto err;
-		if (session_len > 0xffff)
-			goto err;
-
-		/*
-		 * Initialize HMAC and cipher contexts. If callback is present
-		 * it does all the work, otherwise use generated values from
-		 * parent context.
-		 */
-		if (tctx->internal->tlsext_ticket_key_cb != NULL) {
-			if (tctx->internal->tlsext_ticket_key_cb(s,
-			    key_name, iv, &ctx, &hctx, 1) < 0) {
-				EVP_CIPHER_CTX_cleanup(&ctx);
-				goto err;
-			}
-		} else {
-			arc4random_buf(iv, 16);
-			EVP_EncryptInit_ex(&ctx, EVP_aes_128_cbc(), NULL,
-			    tctx->internal->tlsext_tick_aes_key, iv);
-			HMAC_Init_ex(&hctx, tctx->internal->tlsext_tick_hmac_key,
-			    16, EVP_sha256(), NULL);
-			memcpy(key_name, tctx->internal->tlsext_tick_key_name, 16);
-		}
-
-		/* Encrypt the session state. */
-		enc_session_max_len = session_len + EVP_MAX_BLOCK_LENGTH;
-		if ((enc_session = calloc(1, enc_session_max_len)) == NULL)
-			goto err;
-		enc_session_len = 0;
-		if (!EVP_EncryptUpdate(&ctx, enc_session, &len, session,
-		    session_len))
-			goto err;
-		enc_session_len += len;
-		if (!EVP_EncryptFinal_ex(&ctx, enc_session + enc_session_len,
-		    &len))
-			goto err;
-		enc_session_len += len;
-
-		if (enc_session_len > enc_session_max_len)
-			goto err;
-
-		/* Generate the HMAC. */
-		if (!HMAC_Update(&hctx, key_name, sizeof(key_name)))
-			goto err;
-		if (!HMAC_Update(&hctx, iv, EVP_CIPHER_CTX_iv_length(&ctx)))
-			goto err;
-		if (!HMAC_Update(&hctx, enc_session, enc_session_len))
-			goto err;
-
-		if ((hmac_len = HMAC_size(&hctx)) <= 0)
-			goto err;
-
 		/*
 		 * Ticket lifetime hint (advisory only):
 		 * We leave this unspecified for resumed session
@@ -2632,18 +2565,7 @@ ssl3_send_newsession_ticket(SSL *s)
 
 		if (!CBB_add_u16_length_prefixed(&session_ticket, &ticket))
 			goto err;
-		if (!CBB_add_bytes(&ticket, key_name, sizeof(key_name)))
-			goto err;
-		if (!CBB_add_bytes(&ticket, iv, EVP_CIPHER_CTX_iv_length(&ctx)))
-			goto err;
-		if (!CBB_add_bytes(&ticket, enc_session, enc_session_len))
-			goto err;
-		if (!CBB_add_space(&ticket, &hmac, hmac_len))
-			goto err;
-
-		if (!HMAC_Final(&hctx, hmac, &hlen))
-			goto err;
-		if (hlen != hmac_len)
+		if (!tls_encrypt_ticket(s, s->session, &ticket))
 			goto err;
 
 		if (!ssl3_handshake_msg_finish(s, &cbb))
@@ -2652,20 +2574,11 @@ ssl3_send_newsession_ticket(SSL *s)
 		S3I(s)->hs.state = SSL3_ST_SW_SESSION_TICKET_B;
 	}
 
-	EVP_CIPHER_CTX_cleanup(&ctx);
-	HMAC_CTX_cleanup(&hctx);
-	freezero(session, session_len);
-	free(enc_session);
-
 	/* SSL3_ST_SW_SESSION_TICKET_B */
 	return (ssl3_handshake_write(s));
 
  err:
 	CBB_cleanup(&cbb);
-	EVP_CIPHER_CTX_cleanup(&ctx);
-	HMAC_CTX_cleanup(&hctx);
-	freezero(session, session_len);
-	free(enc_session);
 
 	return (-1);
 }
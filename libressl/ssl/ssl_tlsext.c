@@ -1765,6 +1765,397 @@ tlsext_cookie_client_parse(SSL *s, uint16_t msg_type, CBS *cbs, int *alert)
 	return 0;
 }
 
+/*
+ * Pre-Shared Key Exchange Modes - RFC 8446 section 4.2.9.
+ */
+
+int
+tlsext_psk_kex_modes_client_needs(SSL *s, uint16_t msg_type)
+{
+	return (S3I(s)->hs.our_max_tls_version >= TLS1_3_VERSION &&
+	    (SSL_get_options(s) & SSL_OP_NO_TICKET) == 0);
+}
+
+int
+tlsext_psk_kex_modes_client_build(SSL *s, uint16_t msg_type, CBB *cbb)
+{
+	CBB ke_modes;
+
+	if (!CBB_add_u8_length_prefixed(cbb, &ke_modes))
+		return 0;
+
+	/* Only psk_dhe_ke mode is supported. */
+	if (!CBB_add_u8(&ke_modes, TLS13_PSK_DHE_KE))
+		return 0;
+
+	if (!CBB_flush(cbb))
+		return 0;
+
+	return 1;
+}
+
+int
+tlsext_psk_kex_modes_client_parse(SSL *s, uint16_t msg_type, CBS *cbs,
+    int *alert)
+{
+	/* Servers never send this extension. */
+	*alert = TLS1_AD_UNSUPPORTED_EXTENSION;
+	return 0;
+}
+
+int
+tlsext_psk_kex_modes_server_needs(SSL *s, uint16_t msg_type)
+{
+	return 0;
+}
+
+int
+tlsext_psk_kex_modes_server_build(SSL *s, uint16_t msg_type, CBB *cbb)
+{
+	return 0;
+}
+
+int
+tlsext_psk_kex_modes_server_parse(SSL *s, uint16_t msg_type, CBS *cbs,
+    int *alert)
+{
+	CBS ke_modes;
+	uint8_t ke_mode;
+
+	if (!CBS_get_u8_length_prefixed(cbs, &ke_modes))
+		goto err;
+	if (CBS_len(&ke_modes) == 0)
+		goto err;
+
+	while (CBS_len(&ke_modes) > 0) {
+		if (!CBS_get_u8(&ke_modes, &ke_mode))
+			goto err;
+		if (ke_mode == TLS13_PSK_DHE_KE)
+			S3I(s)->hs.tls13.psk_dhe_ke = 1;
+	}
+
+	return 1;
+
+ err:
+	*alert = SSL_AD_DECODE_ERROR;
+	return 0;
+}
+
+/*
+ * Early Data Indication - RFC 8446 section 4.2.10.
+ *
+ * Empty in the ClientHello and EncryptedExtensions, while a NewSessionTicket
+ * carries the maximum amount of early data the server will accept.
+ */
+
+int
+tlsext_early_data_client_needs(SSL *s, uint16_t msg_type)
+{
+	return (msg_type == SSL_TLSEXT_MSG_CH &&
+	    S3I(s)->hs.tls13.early_data && !S3I(s)->hs.tls13.early_data_done);
+}
+
+int
+tlsext_early_data_client_build(SSL *s, uint16_t msg_type, CBB *cbb)
+{
+	return 1;
+}
+
+int
+tlsext_early_data_client_parse(SSL *s, uint16_t msg_type, CBS *cbs,
+    int *alert)
+{
+	uint32_t max_early_data;
+
+	if (msg_type == SSL_TLSEXT_MSG_NST) {
+		if (!CBS_get_u32(cbs, &max_early_data)) {
+			*alert = SSL_AD_DECODE_ERROR;
+			return 0;
+		}
+		s->session->max_early_data = max_early_data;
+		return 1;
+	}
+
+	if (!S3I(s)->hs.tls13.early_data) {
+		*alert = SSL_AD_UNSUPPORTED_EXTENSION;
+		return 0;
+	}
+	S3I(s)->hs.tls13.early_data_accepted = 1;
+
+	return 1;
+}
+
+int
+tlsext_early_data_server_needs(SSL *s, uint16_t msg_type)
+{
+	if (msg_type == SSL_TLSEXT_MSG_NST)
+		return (s->internal->max_early_data > 0);
+
+	return (msg_type == SSL_TLSEXT_MSG_EE &&
+	    S3I(s)->hs.tls13.early_data_accepted);
+}
+
+int
+tlsext_early_data_server_build(SSL *s, uint16_t msg_type, CBB *cbb)
+{
+	if (msg_type == SSL_TLSEXT_MSG_NST) {
+		if (!CBB_add_u32(cbb, s->internal->max_early_data))
+			return 0;
+	}
+
+	return 1;
+}
+
+int
+tlsext_early_data_server_parse(SSL *s, uint16_t msg_type, CBS *cbs,
+    int *alert)
+{
+	/* Early data must not be offered following a HelloRetryRequest. */
+	if (S3I(s)->hs.tls13.hrr) {
+		*alert = SSL_AD_ILLEGAL_PARAMETER;
+		return 0;
+	}
+	S3I(s)->hs.tls13.early_data = 1;
+
+	return 1;
+}
+
+/*
+ * Pre-Shared Key - RFC 8446 section 4.2.11.
+ *
+ * Only resumption PSKs (session tickets) are supported. A client offers a
+ * single identity, while a server only considers the first identity offered.
+ * This extension must be the last one in the ClientHello, since the binder
+ * covers the ClientHello up to (but excluding) the binders list.
+ */
+
+int
+tlsext_psk_client_needs(SSL *s, uint16_t msg_type)
+{
+	return (S3I(s)->hs.our_max_tls_version >= TLS1_3_VERSION &&
+	    S3I(s)->hs.tls13.psk_session != NULL);
+}
+
+int
+tlsext_psk_client_build(SSL *s, uint16_t msg_type, CBB *cbb)
+{
+	SSL_SESSION *sess = S3I(s)->hs.tls13.psk_session;
+	CBB identities, identity, binders, binder;
+	uint32_t ticket_age;
+	const EVP_MD *md;
+	uint8_t *data;
+	time_t now;
+
+	if ((md = tls13_cipher_hash(sess->cipher)) == NULL)
+		return 0;
+
+	/* Obfuscated ticket age, in milliseconds - see section 4.2.11.1. */
+	now = time(NULL);
+	ticket_age = 0;
+	if (now > sess->time)
+		ticket_age = (uint32_t)(now - sess->time) * 1000;
+	ticket_age += sess->tlsext_tick_age_add;
+
+	if (!CBB_add_u16_length_prefixed(cbb, &identities))
+		return 0;
+	if (!CBB_add_u16_length_prefixed(&identities, &identity))
+		return 0;
+	if (!CBB_add_bytes(&identity, sess->tlsext_tick, sess->tlsext_ticklen))
+		return 0;
+	if (!CBB_add_u32(&identities, ticket_age))
+		return 0;
+
+	/*
+	 * The binder is computed over the completed ClientHello, hence a
+	 * zeroed placeholder is written here and later replaced.
+	 */
+	if (!CBB_add_u16_length_prefixed(cbb, &binders))
+		return 0;
+	if (!CBB_add_u8_length_prefixed(&binders, &binder))
+		return 0;
+	if (!CBB_add_space(&binder, &data, EVP_MD_size(md)))
+		return 0;
+	memset(data, 0, EVP_MD_size(md));
+
+	if (!CBB_flush(cbb))
+		return 0;
+
+	return 1;
+}
+
+int
+tlsext_psk_client_parse(SSL *s, uint16_t msg_type, CBS *cbs, int *alert)
+{
+	uint16_t selected_identity;
+
+	if (!CBS_get_u16(cbs, &selected_identity)) {
+		*alert = SSL_AD_DECODE_ERROR;
+		return 0;
+	}
+
+	/* We only ever offer a single identity. */
+	if (S3I(s)->hs.tls13.psk_session == NULL || selected_identity != 0) {
+		*alert = SSL_AD_ILLEGAL_PARAMETER;
+		return 0;
+	}
+
+	s->internal->hit = 1;
+
+	return 1;
+}
+
+int
+tlsext_psk_server_needs(SSL *s, uint16_t msg_type)
+{
+	return (ssl_effective_tls_version(s) >= TLS1_3_VERSION &&
+	    s->internal->hit);
+}
+
+int
+tlsext_psk_server_build(SSL *s, uint16_t msg_type, CBB *cbb)
+{
+	/* Selected identity - we only ever select the first. */
+	if (!CBB_add_u16(cbb, 0))
+		return 0;
+
+	return 1;
+}
+
+static int
+tlsext_psk_session_usable(SSL *s, SSL_SESSION *sess)
+{
+	if (sess->ssl_version != TLS1_3_VERSION)
+		return 0;
+
+	if (sess->sid_ctx_length != s->sid_ctx_length ||
+	    timingsafe_memcmp(sess->sid_ctx, s->sid_ctx,
+	    sess->sid_ctx_length) != 0)
+		return 0;
+
+	if (sess->cipher == NULL) {
+		if ((sess->cipher = ssl3_get_cipher_by_id(sess->cipher_id)) ==
+		    NULL)
+			return 0;
+	}
+	if (sess->cipher->algorithm_ssl != SSL_TLSV1_3)
+		return 0;
+
+	if (sess->timeout < (time(NULL) - sess->time))
+		return 0;
+
+	return 1;
+}
+
+int
+tlsext_psk_server_parse(SSL *s, uint16_t msg_type, CBS *cbs, int *alert)
+{
+	struct tls13_ctx *ctx = s->internal->tls13;
+	CBS identities, identity, ticket, binders, binder;
+	uint8_t computed_binder[EVP_MAX_MD_SIZE];
+	uint8_t transcript_hash[EVP_MAX_MD_SIZE];
+	unsigned int transcript_hash_len;
+	uint32_t obfuscated_ticket_age;
+	SSL_SESSION *sess = NULL;
+	const unsigned char *msgs;
+	size_t binders_len, msgs_len;
+	const EVP_MD *md;
+	int alert_desc;
+	int ret = 0;
+
+	alert_desc = SSL_AD_DECODE_ERROR;
+
+	if (!CBS_get_u16_length_prefixed(cbs, &identities))
+		goto err;
+	binders_len = CBS_len(cbs);
+	if (!CBS_get_u16_length_prefixed(cbs, &binders))
+		goto err;
+
+	/* Only the first identity and its binder are considered. */
+	if (!CBS_get_u16_length_prefixed(&identities, &identity))
+		goto err;
+	if (CBS_len(&identity) == 0)
+		goto err;
+	if (!CBS_get_u32(&identities, &obfuscated_ticket_age))
+		goto err;
+	if (!CBS_get_u8_length_prefixed(&binders, &binder))
+		goto err;
+
+	SSL_SESSION_free(S3I(s)->hs.tls13.psk_session);
+	S3I(s)->hs.tls13.psk_session = NULL;
+
+	if (ctx == NULL || ssl_effective_tls_version(s) < TLS1_3_VERSION)
+		return 1;
+	if ((SSL_get_options(s) & SSL_OP_NO_TICKET) != 0)
+		return 1;
+
+	alert_desc = SSL_AD_INTERNAL_ERROR;
+
+	CBS_dup(&identity, &ticket);
+	switch (tls_decrypt_ticket(s, &ticket, &alert_desc, &sess)) {
+	case TLS1_TICKET_DECRYPTED:
+		break;
+	case TLS1_TICKET_NOT_DECRYPTED:
+		/* Fall back to a full handshake. */
+		return 1;
+	default:
+		goto err;
+	}
+
+	if (!tlsext_psk_session_usable(s, sess)) {
+		SSL_SESSION_free(sess);
+		return 1;
+	}
+
+	if ((md = tls13_cipher_hash(sess->cipher)) == NULL)
+		goto err;
+	if (sess->master_key_length != EVP_MD_size(md)) {
+		SSL_SESSION_free(sess);
+		return 1;
+	}
+	if (CBS_len(&binder) != EVP_MD_size(md)) {
+		alert_desc = SSL_AD_ILLEGAL_PARAMETER;
+		goto err;
+	}
+
+	/*
+	 * The ClientHello has already been added to the transcript - the
+	 * binder is computed over everything up to the binders list, which
+	 * is at the very end of the message.
+	 */
+	if (!tls1_transcript_data(s, &msgs, &msgs_len))
+		goto err;
+	if (msgs_len < binders_len)
+		goto err;
+	if (!EVP_Digest(msgs, msgs_len - binders_len, transcript_hash,
+	    &transcript_hash_len, md, NULL))
+		goto err;
+	if (!tls13_psk_binder(ctx, md, sess->master_key,
+	    sess->master_key_length, transcript_hash, transcript_hash_len,
+	    computed_binder, EVP_MD_size(md)))
+		goto err;
+	if (!CBS_mem_equal(&binder, computed_binder, EVP_MD_size(md))) {
+		alert_desc = SSL_AD_DECRYPT_ERROR;
+		goto err;
+	}
+
+	/* Retained for the early data age check and anti-replay. */
+	S3I(s)->hs.tls13.psk_ticket_age = obfuscated_ticket_age;
+	memcpy(S3I(s)->hs.tls13.psk_binder, computed_binder, EVP_MD_size(md));
+	S3I(s)->hs.tls13.psk_binder_len = EVP_MD_size(md);
+
+	S3I(s)->hs.tls13.psk_session = sess;
+	sess = NULL;
+
+	ret = 1;
+
+ err:
+	SSL_SESSION_free(sess);
+	if (!ret)
+		*alert = alert_desc;
+
+	return ret;
+}
+
 struct tls_extension_funcs {
 	int (*needs)(SSL *s, uint16_t msg_type);
 	int (*build)(SSL *s, uint16_t msg_type, CBB *cbb);
@@ -1951,8 +2342,52 @@ static const struct tls_extension tls_extensions[] = {
 			.build = tlsext_srtp_server_build,
 			.parse = tlsext_srtp_server_parse,
 		},
-	}
+	},
 #endif /* OPENSSL_NO_SRTP */
+	{
+		.type = TLSEXT_TYPE_psk_key_exchange_modes,
+		.messages = SSL_TLSEXT_MSG_CH,
+		.client = {
+			.needs = tlsext_psk_kex_modes_client_needs,
+			.build = tlsext_psk_kex_modes_client_build,
+			.parse = tlsext_psk_kex_modes_client_parse,
+		},
+		.server = {
+			.needs = tlsext_psk_kex_modes_server_needs,
+			.build = tlsext_psk_kex_modes_server_build,
+			.parse = tlsext_psk_kex_modes_server_parse,
+		},
+	},
+	{
+		.type = TLSEXT_TYPE_early_data,
+		.messages = SSL_TLSEXT_MSG_CH | SSL_TLSEXT_MSG_EE |
+		    SSL_TLSEXT_MSG_NST,
+		.client = {
+			.needs = tlsext_early_data_client_needs,
+			.build = tlsext_early_data_client_build,
+			.parse = tlsext_early_data_client_parse,
+		},
+		.server = {
+			.needs = tlsext_early_data_server_needs,
+			.build = tlsext_early_data_server_build,
+			.parse = tlsext_early_data_server_parse,
+		},
+	},
+	/* RFC 8446 section 4.2.11 - pre_shared_key MUST be the last extension. */
+	{
+		.type = TLSEXT_TYPE_pre_shared_key,
+		.messages = SSL_TLSEXT_MSG_CH | SSL_TLSEXT_MSG_SH,
+		.client = {
+			.needs = tlsext_psk_client_needs,
+			.build = tlsext_psk_client_build,
+			.parse = tlsext_psk_client_parse,
+		},
+		.server = {
+			.needs = tlsext_psk_server_needs,
+			.build = tlsext_psk_server_build,
+			.parse = tlsext_psk_server_parse,
+		},
+	},
 };
 
 #define N_TLS_EXTENSIONS (sizeof(tls_extensions) / sizeof(*tls_extensions))
@@ -2123,6 +2558,13 @@ tlsext_parse(SSL *s, int is_server, uint16_t msg_type, CBS *cbs, int *alert)
 			goto err;
 		}
 
+		/* The pre_shared_key must be last in the ClientHello. */
+		if (type == TLSEXT_TYPE_pre_shared_key &&
+		    msg_type == SSL_TLSEXT_MSG_CH && CBS_len(&extensions) != 0) {
+			alert_desc = SSL_AD_ILLEGAL_PARAMETER;
+			goto err;
+		}
+
 		/* Check for duplicate known extensions. */
 		if ((S3I(s)->hs.extensions_seen & (1 << idx)) != 0)
 			goto err;
@@ -2153,6 +2595,9 @@ tlsext_server_reset_state(SSL *s)
 	S3I(s)->alpn_selected = NULL;
 	S3I(s)->alpn_selected_len = 0;
 	s->internal->srtp_profile = NULL;
+	SSL_SESSION_free(S3I(s)->hs.tls13.psk_session);
+	S3I(s)->hs.tls13.psk_session = NULL;
+	S3I(s)->hs.tls13.psk_dhe_ke = 0;
 }
 
 int
@@ -122,9 +122,6 @@
 #include "ssl_sigalgs.h"
 #include "ssl_tlsext.h"
 
-static int tls_decrypt_ticket(SSL *s, CBS *ticket, int *alert,
-    SSL_SESSION **psess);
-
 int
 tls1_new(SSL *s)
 {
@@ -838,7 +835,7 @@ tls1_process_ticket(SSL *s, CBS *ext_block, int *alert, SSL_SESSION **ret)
  *    TLS1_TICKET_NOT_DECRYPTED: the ticket couldn't be decrypted.
  *    TLS1_TICKET_DECRYPTED: a ticket was decrypted and *psess was set.
  */
-static int
+int
 tls_decrypt_ticket(SSL *s, CBS *ticket, int *alert, SSL_SESSION **psess)
 {
 	CBS ticket_name, ticket_iv, ticket_encdata, ticket_hmac;
@@ -993,3 +990,111 @@ tls_decrypt_ticket(SSL *s, CBS *ticket, int *alert, SSL_SESSION **psess)
 
 	return ret;
 }
+
+/*
+ * tls_encrypt_ticket encrypts the given session, appending the opaque ticket
+ * (key name, IV, encrypted session and HMAC) to the ticket CBB. This is the
+ * inverse of tls_decrypt_ticket and is used by both TLSv1.2 (RFC 5077) and
+ * TLSv1.3 (RFC 8446 section 4.6.1) servers.
+ */
+int
+tls_encrypt_ticket(SSL *s, SSL_SESSION *sess, CBB *ticket)
+{
+	SSL_CTX *tctx = s->initial_ctx;
+	size_t enc_session_len, enc_session_max_len, hmac_len;
+	unsigned char *enc_session = NULL, *session = NULL;
+	size_t session_len = 0;
+	unsigned char iv[EVP_MAX_IV_LENGTH];
+	unsigned char key_name[16];
+	EVP_CIPHER_CTX *cctx = NULL;
+	HMAC_CTX *hctx = NULL;
+	unsigned char *hmac;
+	unsigned int hlen;
+	int len;
+	int ret = 0;
+
+	if (!SSL_SESSION_ticket(sess, &session, &session_len))
+		goto err;
+	if (session_len > 0xffff)
+		goto err;
+
+	if ((cctx = EVP_CIPHER_CTX_new()) == NULL)
+		goto err;
+	if ((hctx = HMAC_CTX_new()) == NULL)
+		goto err;
+
+	/*
+	 * Initialize HMAC and cipher contexts. If callback is present
+	 * it does all the work, otherwise use generated values from
+	 * parent context.
+	 */
+	if (tctx->internal->tlsext_ticket_key_cb != NULL) {
+		if (tctx->internal->tlsext_ticket_key_cb(s,
+		    key_name, iv, cctx, hctx, 1) < 0)
+			goto err;
+	} else {
+		arc4random_buf(iv, 16);
+		if (!EVP_EncryptInit_ex(cctx, EVP_aes_128_cbc(), NULL,
+		    tctx->internal->tlsext_tick_aes_key, iv))
+			goto err;
+		if (!HMAC_Init_ex(hctx, tctx->internal->tlsext_tick_hmac_key,
+		    16, EVP_sha256(), NULL))
+			goto err;
+		memcpy(key_name, tctx->internal->tlsext_tick_key_name, 16);
+	}
+
+	/* Encrypt the session state. */
+	enc_session_max_len = session_len + EVP_MAX_BLOCK_LENGTH;
+	if ((enc_session = calloc(1, enc_session_max_len)) == NULL)
+		goto err;
+	enc_session_len = 0;
+	if (!EVP_EncryptUpdate(cctx, enc_session, &len, session,
+	    session_len))
+		goto err;
+	enc_session_len += len;
+	if (!EVP_EncryptFinal_ex(cctx, enc_session + enc_session_len,
+	    &len))
+		goto err;
+	enc_session_len += len;
+
+	if (enc_session_len > enc_session_max_len)
+		goto err;
+
+	/* Generate the HMAC. */
+	if (!HMAC_Update(hctx, key_name, sizeof(key_name)))
+		goto err;
+	if (!HMAC_Update(hctx, iv, EVP_CIPHER_CTX_iv_length(cctx)))
+		goto err;
+	if (!HMAC_Update(hctx, enc_session, enc_session_len))
+		goto err;
+
+	if ((hmac_len = HMAC_size(hctx)) <= 0)
+		goto err;
+
+	if (!CBB_add_bytes(ticket, key_name, sizeof(key_name)))
+		goto err;
+	if (!CBB_add_bytes(ticket, iv, EVP_CIPHER_CTX_iv_length(cctx)))
+		goto err;
+	if (!CBB_add_bytes(ticket, enc_session, enc_session_len))
+		goto err;
+	if (!CBB_add_space(ticket, &hmac, hmac_len))
+		goto err;
+
+	if (!HMAC_Final(hctx, hmac, &hlen))
+		goto err;
+	if (hlen != hmac_len)
+		goto err;
+
+	if (!CBB_flush(ticket))
+		goto err;
+
+	ret = 1;
+
+ err:
+	EVP_CIPHER_CTX_free(cctx);
+	HMAC_CTX_free(hctx);
+	freezero(session, session_len);
+	free(enc_session);
+
+	return ret;
+}
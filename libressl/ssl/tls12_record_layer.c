@@ -660,6 +660,28 @@ tls12_record_layer_pseudo_header(struct tls12_record_layer *rl,
 	return 0;
 }
 
+/*
+ * Build the AEAD additional data as two regions - the sequence number as it
+ * already exists and a short header on the caller's stack - avoiding the
+ * allocation and copy needed for a contiguous pseudo-header.
+ */
+static void
+tls12_record_layer_aead_ad(struct tls12_record_layer *rl,
+    uint8_t content_type, uint16_t record_len, CBS *seq_num,
+    uint8_t header[5], EVP_AEAD_IOVEC ad[2])
+{
+	header[0] = content_type;
+	header[1] = (rl->version >> 8) & 0xff;
+	header[2] = rl->version & 0xff;
+	header[3] = (record_len >> 8) & 0xff;
+	header[4] = record_len & 0xff;
+
+	ad[0].data = (unsigned char *)CBS_data(seq_num);
+	ad[0].len = CBS_len(seq_num);
+	ad[1].data = header;
+	ad[1].len = 5;
+}
+
 static int
 tls12_record_layer_mac(struct tls12_record_layer *rl, CBB *cbb,
     EVP_MD_CTX *hash_ctx, int stream_mac, CBS *seq_num, uint8_t content_type,
@@ -868,10 +890,10 @@ tls12_record_layer_open_record_protected_aead(struct tls12_record_layer *rl,
     size_t *out_len)
 {
 	const SSL_AEAD_CTX *aead = rl->read->aead_ctx;
-	uint8_t *header = NULL, *nonce = NULL;
-	size_t header_len = 0, nonce_len = 0;
-	uint8_t *plain;
-	size_t plain_len;
+	EVP_AEAD_IOVEC ad[2], in, plain;
+	uint8_t *nonce = NULL;
+	size_t nonce_len = 0;
+	uint8_t header[5];
 	CBS var_nonce;
 	int ret = 0;
 
@@ -904,16 +926,16 @@ tls12_record_layer_open_record_protected_aead(struct tls12_record_layer *rl,
 	}
 
 	/* XXX - decrypt/process in place for now. */
-	plain = (uint8_t *)CBS_data(fragment);
-	plain_len = CBS_len(fragment) - aead->tag_len;
+	in.data = (uint8_t *)CBS_data(fragment);
+	in.len = CBS_len(fragment);
+	plain.data = in.data;
+	plain.len = in.len - aead->tag_len;
 
-	if (!tls12_record_layer_pseudo_header(rl, content_type, plain_len,
-	    seq_num, &header, &header_len))
-		goto err;
+	tls12_record_layer_aead_ad(rl, content_type, plain.len, seq_num,
+	    header, ad);
 
-	if (!EVP_AEAD_CTX_open(&aead->ctx, plain, out_len, plain_len,
-	    nonce, nonce_len, CBS_data(fragment), CBS_len(fragment),
-	    header, header_len)) {
+	if (!EVP_AEAD_CTX_openv(&aead->ctx, &plain, 1, out_len,
+	    nonce, nonce_len, &in, 1, ad, 2)) {
 		rl->alert_desc = SSL_AD_BAD_RECORD_MAC;
 		goto err;
 	}
@@ -923,15 +945,14 @@ tls12_record_layer_open_record_protected_aead(struct tls12_record_layer *rl,
 		goto err;
 	}
 
-	if (*out_len != plain_len)
+	if (*out_len != plain.len)
 		goto err;
 
-	*out = plain;
+	*out = plain.data;
 
 	ret = 1;
 
  err:
-	freezero(header, header_len);
 	freezero(nonce, nonce_len);
 
 	return ret;
@@ -1132,10 +1153,11 @@ tls12_record_layer_seal_record_protected_aead(struct tls12_record_layer *rl,
     size_t content_len, CBB *out)
 {
 	const SSL_AEAD_CTX *aead = rl->write->aead_ctx;
-	uint8_t *header = NULL, *nonce = NULL;
-	size_t header_len = 0, nonce_len = 0;
-	size_t enc_record_len, out_len;
-	uint8_t *enc_data;
+	EVP_AEAD_IOVEC ad[2], in, enc;
+	uint8_t *nonce = NULL;
+	size_t nonce_len = 0;
+	size_t out_len;
+	uint8_t header[5];
 	int ret = 0;
 
 	/* XXX - move to nonce allocated in record layer, matching TLSv1.3 */
@@ -1156,28 +1178,29 @@ tls12_record_layer_seal_record_protected_aead(struct tls12_record_layer *rl,
 			goto err;
 	}
 
-	if (!tls12_record_layer_pseudo_header(rl, content_type, content_len,
-	    seq_num, &header, &header_len))
-		goto err;
+	tls12_record_layer_aead_ad(rl, content_type, content_len, seq_num,
+	    header, ad);
 
 	/* XXX EVP_AEAD_max_tag_len vs EVP_AEAD_CTX_tag_len. */
-	enc_record_len = content_len + aead->tag_len;
-	if (enc_record_len > SSL3_RT_MAX_ENCRYPTED_LENGTH)
+	enc.len = content_len + aead->tag_len;
+	if (enc.len > SSL3_RT_MAX_ENCRYPTED_LENGTH)
 		goto err;
-	if (!CBB_add_space(out, &enc_data, enc_record_len))
+	if (!CBB_add_space(out, &enc.data, enc.len))
 		goto err;
 
-	if (!EVP_AEAD_CTX_seal(&aead->ctx, enc_data, &out_len, enc_record_len,
-	    nonce, nonce_len, content, content_len, header, header_len))
+	in.data = (uint8_t *)content;
+	in.len = content_len;
+
+	if (!EVP_AEAD_CTX_sealv(&aead->ctx, &enc, 1, &out_len,
+	    nonce, nonce_len, &in, 1, ad, 2))
 		goto err;
 
-	if (out_len != enc_record_len)
+	if (out_len != enc.len)
 		goto err;
 
 	ret = 1;
 
  err:
-	freezero(header, header_len);
 	freezero(nonce, nonce_len);
 
 	return ret;
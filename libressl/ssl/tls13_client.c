@@ -24,6 +24,41 @@
 #include "tls13_handshake.h"
 #include "tls13_internal.h"
 
+static int
+tls13_client_psk_session_usable(struct tls13_ctx *ctx, SSL_SESSION *sess)
+{
+	SSL *s = ctx->ssl;
+
+	if (sess == NULL)
+		return 0;
+	if (ctx->hs->our_max_tls_version < TLS1_3_VERSION)
+		return 0;
+	if ((SSL_get_options(s) & SSL_OP_NO_TICKET) != 0)
+		return 0;
+
+	if (sess->ssl_version != TLS1_3_VERSION)
+		return 0;
+	if (sess->tlsext_tick == NULL || sess->tlsext_ticklen == 0)
+		return 0;
+	if (sess->master_key_length == 0)
+		return 0;
+
+	if (sess->cipher == NULL) {
+		if ((sess->cipher = ssl3_get_cipher_by_id(sess->cipher_id)) ==
+		    NULL)
+			return 0;
+	}
+	if (sess->cipher->algorithm_ssl != SSL_TLSV1_3)
+		return 0;
+	if (tls13_cipher_hash(sess->cipher) == NULL)
+		return 0;
+
+	if (sess->timeout < (time(NULL) - sess->time))
+		return 0;
+
+	return 1;
+}
+
 int
 tls13_client_init(struct tls13_ctx *ctx)
 {
@@ -41,6 +76,15 @@ tls13_client_init(struct tls13_ctx *ctx)
 	tls13_record_layer_set_retry_after_phh(ctx->rl,
 	    (s->internal->mode & SSL_MODE_AUTO_RETRY) != 0);
 
+	/*
+	 * Retain a TLSv1.3 session that has a ticket, so that it can be
+	 * offered for resumption via a pre-shared key.
+	 */
+	if (tls13_client_psk_session_usable(ctx, s->session)) {
+		ctx->hs->tls13.psk_session = s->session;
+		s->session = NULL;
+	}
+
 	if (!ssl_get_new_session(s, 0)) /* XXX */
 		return 0;
 
@@ -131,6 +175,104 @@ tls13_client_hello_build(struct tls13_ctx *ctx, CBB *cbb)
 	return 0;
 }
 
+/*
+ * Fill in the binder for the offered PSK, which is computed over the
+ * transcript and the ClientHello up to (but excluding) the binders list - see
+ * RFC 8446 section 4.2.11.2.
+ */
+static int
+tls13_client_hello_psk_binder(struct tls13_ctx *ctx, uint8_t *hello,
+    size_t hello_len)
+{
+	SSL_SESSION *sess = ctx->hs->tls13.psk_session;
+	uint8_t transcript_hash[EVP_MAX_MD_SIZE];
+	unsigned int transcript_hash_len;
+	const unsigned char *transcript;
+	size_t transcript_len;
+	size_t binder_len, binders_len;
+	EVP_MD_CTX *md_ctx = NULL;
+	uint8_t header[4];
+	const EVP_MD *md;
+	int ret = 0;
+
+	if ((md = tls13_cipher_hash(sess->cipher)) == NULL)
+		goto err;
+	binder_len = EVP_MD_size(md);
+	binders_len = 2 + 1 + binder_len;
+	if (hello_len < binders_len || hello_len > 0xffffff)
+		goto err;
+
+	header[0] = TLS13_MT_CLIENT_HELLO;
+	header[1] = (hello_len >> 16) & 0xff;
+	header[2] = (hello_len >> 8) & 0xff;
+	header[3] = hello_len & 0xff;
+
+	if (!tls1_transcript_data(ctx->ssl, &transcript, &transcript_len))
+		goto err;
+
+	if ((md_ctx = EVP_MD_CTX_new()) == NULL)
+		goto err;
+	if (!EVP_DigestInit_ex(md_ctx, md, NULL))
+		goto err;
+	if (!EVP_DigestUpdate(md_ctx, transcript, transcript_len))
+		goto err;
+	if (!EVP_DigestUpdate(md_ctx, header, sizeof(header)))
+		goto err;
+	if (!EVP_DigestUpdate(md_ctx, hello, hello_len - binders_len))
+		goto err;
+	if (!EVP_DigestFinal_ex(md_ctx, transcript_hash, &transcript_hash_len))
+		goto err;
+
+	if (!tls13_psk_binder(ctx, md, sess->master_key,
+	    sess->master_key_length, transcript_hash, transcript_hash_len,
+	    &hello[hello_len - binder_len], binder_len))
+		goto err;
+
+	ret = 1;
+
+ err:
+	EVP_MD_CTX_free(md_ctx);
+
+	return ret;
+}
+
+static int
+tls13_client_hello_build_with_psk(struct tls13_ctx *ctx, CBB *cbb)
+{
+	uint8_t *hello = NULL;
+	size_t hello_len = 0;
+	CBB client_hello;
+	int ret = 0;
+
+	if (ctx->hs->tls13.psk_session == NULL)
+		return tls13_client_hello_build(ctx, cbb);
+
+	/*
+	 * The binder can only be computed once the rest of the ClientHello
+	 * is known, hence build it separately and patch the binder in.
+	 */
+	if (!CBB_init(&client_hello, 0))
+		goto err;
+	if (!tls13_client_hello_build(ctx, &client_hello))
+		goto err;
+	if (!CBB_finish(&client_hello, &hello, &hello_len))
+		goto err;
+
+	if (!tls13_client_hello_psk_binder(ctx, hello, hello_len))
+		goto err;
+
+	if (!CBB_add_bytes(cbb, hello, hello_len))
+		goto err;
+
+	ret = 1;
+
+ err:
+	CBB_cleanup(&client_hello);
+	free(hello);
+
+	return ret;
+}
+
 int
 tls13_client_hello_send(struct tls13_ctx *ctx, CBB *cbb)
 {
@@ -140,7 +282,16 @@ tls13_client_hello_send(struct tls13_ctx *ctx, CBB *cbb)
 	/* We may receive a pre-TLSv1.3 alert in response to the client hello. */
 	tls13_record_layer_allow_legacy_alerts(ctx->rl, 1);
 
-	if (!tls13_client_hello_build(ctx, cbb))
+	/*
+	 * Early data is only offered when the application is writing it and
+	 * the session ticket permits it.
+	 */
+	if (ctx->hs->tls13.early_data_pause &&
+	    ctx->hs->tls13.psk_session != NULL &&
+	    ctx->hs->tls13.psk_session->max_early_data > 0)
+		ctx->hs->tls13.early_data = 1;
+
+	if (!tls13_client_hello_build_with_psk(ctx, cbb))
 		return 0;
 
 	return 1;
@@ -156,6 +307,11 @@ tls13_client_hello_sent(struct tls13_ctx *ctx)
 	if (ctx->middlebox_compat)
 		ctx->send_dummy_ccs = 1;
 
+	if (ctx->hs->tls13.early_data) {
+		if (!tls13_early_data_engage(ctx, ctx->hs->tls13.psk_session))
+			return 0;
+	}
+
 	return 1;
 }
 
@@ -303,6 +459,13 @@ tls13_server_hello_process(struct tls13_ctx *ctx, CBS *cbs)
 		ctx->alert = TLS13_ALERT_ILLEGAL_PARAMETER;
 		goto err;
 	}
+	/* The cipher suite hash must match that of the resumed session. */
+	if (s->internal->hit &&
+	    tls13_cipher_hash(cipher) !=
+	    tls13_cipher_hash(ctx->hs->tls13.psk_session->cipher)) {
+		ctx->alert = TLS13_ALERT_ILLEGAL_PARAMETER;
+		goto err;
+	}
 	/* XXX - move this to hs.tls13? */
 	ctx->hs->cipher = cipher;
 
@@ -328,6 +491,8 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	unsigned char buf[EVP_MAX_MD_SIZE];
 	uint8_t *shared_key = NULL;
 	size_t shared_key_len = 0;
+	uint8_t *psk;
+	size_t psk_len;
 	size_t hash_len;
 	SSL *s = ctx->ssl;
 	int ret = 0;
@@ -338,6 +503,16 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	    &shared_key_len))
 		goto err;
 
+	/* The server accepted our PSK, so continue with the offered session. */
+	if (s->internal->hit) {
+		if (ctx->hs->tls13.psk_session == NULL)
+			goto err;
+		SSL_SESSION_free(s->session);
+		s->session = ctx->hs->tls13.psk_session;
+		ctx->hs->tls13.psk_session = NULL;
+		s->verify_result = s->session->verify_result;
+	}
+
 	s->session->cipher = ctx->hs->cipher;
 	s->session->ssl_version = ctx->hs->tls13.server_version;
 
@@ -346,7 +521,8 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	if ((ctx->hash = tls13_cipher_hash(ctx->hs->cipher)) == NULL)
 		goto err;
 
-	if ((secrets = tls13_secrets_create(ctx->hash, 0)) == NULL)
+	if ((secrets = tls13_secrets_create(ctx->hash,
+	    s->internal->hit)) == NULL)
 		goto err;
 	ctx->hs->tls13.secrets = secrets;
 
@@ -359,9 +535,15 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	context.data = buf;
 	context.len = hash_len;
 
-	/* Early secrets. */
-	if (!tls13_derive_early_secrets(ctx, secrets, secrets->zeros.data,
-	    secrets->zeros.len, &context))
+	/* Early secrets - a resumed session carries the PSK as its master key. */
+	psk = secrets->zeros.data;
+	psk_len = secrets->zeros.len;
+	if (s->internal->hit) {
+		if (s->session->master_key_length != psk_len)
+			goto err;
+		psk = s->session->master_key;
+	}
+	if (!tls13_derive_early_secrets(ctx, secrets, psk, psk_len, &context))
 		goto err;
 
 	/* Handshake secrets. */
@@ -375,9 +557,17 @@ tls13_client_engage_record_protection(struct tls13_ctx *ctx)
 	if (!tls13_record_layer_set_read_traffic_key(ctx, ctx->rl,
 	    &secrets->server_handshake_traffic))
 		goto err;
-	if (!tls13_record_layer_set_write_traffic_key(ctx, ctx->rl,
-	    &secrets->client_handshake_traffic))
-		goto err;
+
+	/*
+	 * Early data continues to be written with the early traffic keys until
+	 * we know whether the server accepted it.
+	 */
+	if (!ctx->hs->tls13.early_data ||
+	    !(ctx->handshake_stage.hs_type & WITHOUT_HRR)) {
+		if (!tls13_record_layer_set_write_traffic_key(ctx, ctx->rl,
+		    &secrets->client_handshake_traffic))
+			goto err;
+	}
 
 	ret = 1;
 
@@ -395,6 +585,8 @@ tls13_server_hello_retry_request_recv(struct tls13_ctx *ctx, CBS *cbs)
 	 * HelloRetryRequest or a ServerHello. As such, we have to handle
 	 * this case here and hand off to the appropriate function.
 	 */
+	ctx->hs->tls13.early_data_done = 1;
+
 	if (!tls13_server_hello_is_retry(cbs)) {
 		ctx->handshake_stage.hs_type |= WITHOUT_HRR;
 		return tls13_server_hello_recv(ctx, cbs);
@@ -413,6 +605,10 @@ tls13_server_hello_retry_request_recv(struct tls13_ctx *ctx, CBS *cbs)
 	if (!ctx->hs->tls13.hrr)
 		return 0;
 
+	/* Early data is rejected and the next ClientHello is plaintext. */
+	if (ctx->hs->tls13.early_data)
+		tls13_record_layer_clear_write_traffic_key(ctx->rl);
+
 	if (!tls13_synthetic_handshake_message(ctx))
 		return 0;
 	if (!tls13_handshake_msg_record(ctx))
@@ -444,7 +640,18 @@ tls13_client_hello_retry_send(struct tls13_ctx *ctx, CBB *cbb)
 	if (!tls13_key_share_generate(ctx->hs->tls13.key_share))
 		return 0;
 
-	if (!tls13_client_hello_build(ctx, cbb))
+	/*
+	 * Only continue to offer the PSK if its hash matches that of the
+	 * cipher suite selected by the server - RFC 8446 section 4.1.4.
+	 */
+	if (ctx->hs->tls13.psk_session != NULL &&
+	    tls13_cipher_hash(ctx->hs->tls13.psk_session->cipher) !=
+	    tls13_cipher_hash(ctx->hs->cipher)) {
+		SSL_SESSION_free(ctx->hs->tls13.psk_session);
+		ctx->hs->tls13.psk_session = NULL;
+	}
+
+	if (!tls13_client_hello_build_with_psk(ctx, cbb))
 		return 0;
 
 	return 1;
@@ -484,6 +691,8 @@ tls13_server_hello_recv(struct tls13_ctx *ctx, CBS *cbs)
 		return 0;
 
 	ctx->handshake_stage.hs_type |= NEGOTIATED;
+	if (ctx->ssl->internal->hit)
+		ctx->handshake_stage.hs_type |= WITH_PSK;
 
 	return 1;
 }
@@ -491,6 +700,7 @@ tls13_server_hello_recv(struct tls13_ctx *ctx, CBS *cbs)
 int
 tls13_server_encrypted_extensions_recv(struct tls13_ctx *ctx, CBS *cbs)
 {
+	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
 	int alert_desc;
 
 	if (!tlsext_client_parse(ctx->ssl, SSL_TLSEXT_MSG_EE, cbs, &alert_desc)) {
@@ -498,6 +708,25 @@ tls13_server_encrypted_extensions_recv(struct tls13_ctx *ctx, CBS *cbs)
 		goto err;
 	}
 
+	/*
+	 * Early data can only be accepted along with the PSK it was offered
+	 * with, in which case an EndOfEarlyData message follows. Otherwise
+	 * switch over to the handshake traffic keys.
+	 */
+	if (ctx->hs->tls13.early_data_accepted) {
+		if (!ctx->ssl->internal->hit ||
+		    !(ctx->handshake_stage.hs_type & WITHOUT_HRR)) {
+			ctx->alert = TLS13_ALERT_ILLEGAL_PARAMETER;
+			goto err;
+		}
+		ctx->handshake_stage.hs_type |= WITH_0RTT;
+	} else if (ctx->hs->tls13.early_data &&
+	    (ctx->handshake_stage.hs_type & WITHOUT_HRR)) {
+		if (!tls13_record_layer_set_write_traffic_key(ctx, ctx->rl,
+		    &secrets->client_handshake_traffic))
+			goto err;
+	}
+
 	return 1;
 
  err:
@@ -703,7 +932,8 @@ tls13_server_certificate_verify_recv(struct tls13_ctx *ctx, CBS *cbs)
 
 	if ((mdctx = EVP_MD_CTX_new()) == NULL)
 		goto err;
-	if (!EVP_DigestVerifyInit(mdctx, &pctx, sigalg->md(), NULL, pkey))
+	if (!EVP_DigestVerifyInit(mdctx, &pctx,
+	    sigalg->md != NULL ? sigalg->md() : NULL, NULL, pkey))
 		goto err;
 	if (sigalg->flags & SIGALG_FLAG_RSA_PSS) {
 		if (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING))
@@ -711,12 +941,8 @@ tls13_server_certificate_verify_recv(struct tls13_ctx *ctx, CBS *cbs)
 		if (!EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1))
 			goto err;
 	}
-	if (!EVP_DigestVerifyUpdate(mdctx, sig_content, sig_content_len)) {
-		ctx->alert = TLS13_ALERT_DECRYPT_ERROR;
-		goto err;
-	}
-	if (EVP_DigestVerifyFinal(mdctx, CBS_data(&signature),
-	    CBS_len(&signature)) <= 0) {
+	if (EVP_DigestVerify(mdctx, CBS_data(&signature), CBS_len(&signature),
+	    sig_content, sig_content_len) <= 0) {
 		ctx->alert = TLS13_ALERT_DECRYPT_ERROR;
 		goto err;
 	}
@@ -867,6 +1093,12 @@ tls13_client_select_certificate(struct tls13_ctx *ctx, CERT_PKEY **out_cpk,
 	if (cert_ok)
 		goto done;
 
+	cpk = &s->cert->pkeys[SSL_PKEY_ED25519];
+	if (!tls13_client_check_certificate(ctx, cpk, &cert_ok, &sigalg))
+		return 0;
+	if (cert_ok)
+		goto done;
+
 	cpk = &s->cert->pkeys[SSL_PKEY_RSA];
 	if (!tls13_client_check_certificate(ctx, cpk, &cert_ok, &sigalg))
 		return 0;
@@ -971,7 +1203,8 @@ tls13_client_certificate_verify_send(struct tls13_ctx *ctx, CBB *cbb)
 
 	if ((mdctx = EVP_MD_CTX_new()) == NULL)
 		goto err;
-	if (!EVP_DigestSignInit(mdctx, &pctx, sigalg->md(), NULL, pkey))
+	if (!EVP_DigestSignInit(mdctx, &pctx,
+	    sigalg->md != NULL ? sigalg->md() : NULL, NULL, pkey))
 		goto err;
 	if (sigalg->flags & SIGALG_FLAG_RSA_PSS) {
 		if (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING))
@@ -979,13 +1212,13 @@ tls13_client_certificate_verify_send(struct tls13_ctx *ctx, CBB *cbb)
 		if (!EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1))
 			goto err;
 	}
-	if (!EVP_DigestSignUpdate(mdctx, sig_content, sig_content_len))
-		goto err;
-	if (EVP_DigestSignFinal(mdctx, NULL, &sig_len) <= 0)
+	if (!EVP_DigestSign(mdctx, NULL, &sig_len, sig_content,
+	    sig_content_len))
 		goto err;
 	if ((sig = calloc(1, sig_len)) == NULL)
 		goto err;
-	if (EVP_DigestSignFinal(mdctx, sig, &sig_len) <= 0)
+	if (!EVP_DigestSign(mdctx, sig, &sig_len, sig_content,
+	    sig_content_len))
 		goto err;
 
 	if (!CBB_add_u16(cbb, sigalg->value))
@@ -1015,7 +1248,17 @@ tls13_client_certificate_verify_send(struct tls13_ctx *ctx, CBB *cbb)
 int
 tls13_client_end_of_early_data_send(struct tls13_ctx *ctx, CBB *cbb)
 {
-	return 0;
+	/* EndOfEarlyData has an empty body. */
+	return 1;
+}
+
+int
+tls13_client_end_of_early_data_sent(struct tls13_ctx *ctx)
+{
+	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
+
+	return tls13_record_layer_set_write_traffic_key(ctx, ctx->rl,
+	    &secrets->client_handshake_traffic);
 }
 
 int
@@ -1079,6 +1322,21 @@ int
 tls13_client_finished_sent(struct tls13_ctx *ctx)
 {
 	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
+	uint8_t transcript_hash[EVP_MAX_MD_SIZE] = { 0 };
+	size_t transcript_hash_len = 0;
+	struct tls13_secret context;
+
+	/*
+	 * The resumption master secret covers the transcript through the
+	 * client finished message, which has now been recorded.
+	 */
+	if (!tls1_transcript_hash_value(ctx->ssl, transcript_hash,
+	    sizeof(transcript_hash), &transcript_hash_len))
+		return 0;
+	context.data = transcript_hash;
+	context.len = transcript_hash_len;
+	if (!tls13_derive_resumption_secrets(ctx, secrets, &context))
+		return 0;
 
 	/*
 	 * Any records following the client finished message must be encrypted
@@ -1087,3 +1345,93 @@ tls13_client_finished_sent(struct tls13_ctx *ctx)
 	return tls13_record_layer_set_write_traffic_key(ctx, ctx->rl,
 	    &secrets->client_application_traffic);
 }
+
+ssize_t
+tls13_new_session_ticket_recv(struct tls13_ctx *ctx, CBS *cbs)
+{
+	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
+	CBS ticket_nonce, ticket;
+	uint32_t lifetime, age_add;
+	struct tls13_secret psk;
+	unsigned int session_id_len;
+	SSL *s = ctx->ssl;
+	SSL_SESSION *sess = s->session;
+	uint8_t alert = TLS13_ALERT_DECODE_ERROR;
+	int alert_desc;
+
+	if (ctx->mode != TLS13_HS_CLIENT) {
+		alert = TLS13_ALERT_UNEXPECTED_MESSAGE;
+		goto err;
+	}
+
+	if (!CBS_get_u32(cbs, &lifetime))
+		goto err;
+	if (!CBS_get_u32(cbs, &age_add))
+		goto err;
+	if (!CBS_get_u8_length_prefixed(cbs, &ticket_nonce))
+		goto err;
+	if (!CBS_get_u16_length_prefixed(cbs, &ticket))
+		goto err;
+	if (CBS_len(&ticket) == 0)
+		goto err;
+
+	/* Early data is only permitted if this ticket allows for it. */
+	sess->max_early_data = 0;
+
+	if (!tlsext_client_parse(s, SSL_TLSEXT_MSG_NST, cbs, &alert_desc)) {
+		alert = alert_desc;
+		goto err;
+	}
+	if (CBS_len(cbs) != 0)
+		goto err;
+
+	if (lifetime > TLS13_MAX_TICKET_LIFETIME) {
+		alert = TLS13_ALERT_ILLEGAL_PARAMETER;
+		goto err;
+	}
+
+	/* A lifetime of zero indicates that the ticket should be discarded. */
+	if (lifetime == 0)
+		return TLS13_IO_SUCCESS;
+
+	/*
+	 * Store the PSK for this ticket as the master key of the session -
+	 * the session is updated in place, as is done for TLSv1.2 tickets.
+	 */
+	alert = TLS13_ALERT_INTERNAL_ERROR;
+
+	psk.data = sess->master_key;
+	psk.len = EVP_MD_size(ctx->hash);
+	if (psk.len > sizeof(sess->master_key))
+		goto err;
+	if (!tls13_derive_ticket_psk(ctx, secrets, CBS_data(&ticket_nonce),
+	    CBS_len(&ticket_nonce), &psk))
+		goto err;
+	sess->master_key_length = psk.len;
+
+	if (!CBS_stow(&ticket, &sess->tlsext_tick, &sess->tlsext_ticklen))
+		goto err;
+	sess->tlsext_tick_lifetime_hint = lifetime;
+	sess->tlsext_tick_age_add = age_add;
+	sess->time = time(NULL);
+	sess->timeout = lifetime;
+
+	/*
+	 * As with TLSv1.2, use a hash of the first ticket as the session ID so
+	 * that the session can be cached. The identifier is retained for any
+	 * subsequent tickets, since the session may already be in the cache.
+	 */
+	if (sess->session_id_length == 0) {
+		if (!EVP_Digest(CBS_data(&ticket), CBS_len(&ticket),
+		    sess->session_id, &session_id_len, EVP_sha256(), NULL))
+			goto err;
+		sess->session_id_length = session_id_len;
+	}
+
+	ssl_update_cache(s, SSL_SESS_CACHE_CLIENT);
+
+	return TLS13_IO_SUCCESS;
+
+ err:
+	return tls13_send_alert(ctx->rl, alert);
+}
@@ -66,6 +66,7 @@ static const struct tls13_handshake_action state_machine[] = {
 		.handshake_type = TLS13_MT_END_OF_EARLY_DATA,
 		.sender = TLS13_HS_CLIENT,
 		.send = tls13_client_end_of_early_data_send,
+		.sent = tls13_client_end_of_early_data_sent,
 		.recv = tls13_client_end_of_early_data_recv,
 	},
 	[CLIENT_CERTIFICATE] = {
@@ -217,6 +218,26 @@ const enum tls13_message_type handshakes[][TLS13_NUM_MESSAGE_TYPES] = {
 		CLIENT_FINISHED,
 		APPLICATION_DATA,
 	},
+	[NEGOTIATED | WITH_PSK | WITH_0RTT] = {
+		CLIENT_HELLO,
+		SERVER_HELLO_RETRY_REQUEST,
+		CLIENT_HELLO_RETRY,
+		SERVER_HELLO,
+		SERVER_ENCRYPTED_EXTENSIONS,
+		SERVER_FINISHED,
+		CLIENT_END_OF_EARLY_DATA,
+		CLIENT_FINISHED,
+		APPLICATION_DATA,
+	},
+	[NEGOTIATED | WITHOUT_HRR | WITH_PSK | WITH_0RTT] = {
+		CLIENT_HELLO,
+		SERVER_HELLO,
+		SERVER_ENCRYPTED_EXTENSIONS,
+		SERVER_FINISHED,
+		CLIENT_END_OF_EARLY_DATA,
+		CLIENT_FINISHED,
+		APPLICATION_DATA,
+	},
 	[NEGOTIATED | WITH_CCV] = {
 		CLIENT_HELLO,
 		SERVER_HELLO_RETRY_REQUEST,
@@ -337,6 +358,25 @@ tls13_handshake_msg_record(struct tls13_ctx *ctx)
 	return tls1_transcript_record(ctx->ssl, CBS_data(&cbs), CBS_len(&cbs));
 }
 
+/*
+ * When early data is being sent or received, the handshake stops at the
+ * point where the early data flows - before a client reads the ServerHello
+ * and once a server has sent its flight, before it reads the first message
+ * that follows the client's early data.
+ */
+static int
+tls13_handshake_early_data_pause(struct tls13_ctx *ctx,
+    const struct tls13_handshake_action *action)
+{
+	if (!ctx->hs->tls13.early_data_pause || action->sender == ctx->mode)
+		return 0;
+
+	if (ctx->mode == TLS13_HS_CLIENT)
+		return action->handshake_type == TLS13_MT_SERVER_HELLO;
+
+	return action->handshake_type != TLS13_MT_CLIENT_HELLO;
+}
+
 int
 tls13_handshake_perform(struct tls13_ctx *ctx)
 {
@@ -362,6 +402,9 @@ tls13_handshake_perform(struct tls13_ctx *ctx)
 			return TLS13_IO_SUCCESS;
 		}
 
+		if (tls13_handshake_early_data_pause(ctx, action))
+			return TLS13_IO_SUCCESS;
+
 		DEBUGF("%s %s %s\n", tls13_handshake_mode_name(ctx->mode),
 		    (action->sender == ctx->mode) ? "sending" : "receiving",
 		    tls13_handshake_message_name(action->handshake_type));
@@ -79,6 +79,10 @@ __BEGIN_HIDDEN_DECLS
 #define TLS13_ALERT_CERTIFICATE_REQUIRED		116
 #define TLS13_ALERT_NO_APPLICATION_PROTOCOL		120
 
+/* PSK key exchange modes - RFC 8446 section 4.2.9. */
+#define TLS13_PSK_KE					0
+#define TLS13_PSK_DHE_KE				1
+
 #define TLS13_INFO_HANDSHAKE_STARTED			SSL_CB_HANDSHAKE_START
 #define TLS13_INFO_HANDSHAKE_COMPLETED			SSL_CB_HANDSHAKE_DONE
 
@@ -122,6 +126,7 @@ struct tls13_secrets {
 	int early_done;
 	int handshake_done;
 	int schedule_done;
+	int resumption_done;
 	int insecure; /* Set by tests */
 	struct tls13_secret zeros;
 	struct tls13_secret empty_hash;
@@ -186,6 +191,10 @@ struct tls13_record_layer *tls13_record_layer_new(
 void tls13_record_layer_free(struct tls13_record_layer *rl);
 void tls13_record_layer_allow_ccs(struct tls13_record_layer *rl, int allow);
 void tls13_record_layer_allow_legacy_alerts(struct tls13_record_layer *rl, int allow);
+void tls13_record_layer_allow_early_data(struct tls13_record_layer *rl, int allow,
+    size_t max_len);
+void tls13_record_layer_skip_early_data(struct tls13_record_layer *rl,
+    size_t max_len);
 void tls13_record_layer_rbuf(struct tls13_record_layer *rl, CBS *cbs);
 void tls13_record_layer_set_aead(struct tls13_record_layer *rl,
     const EVP_AEAD *aead);
@@ -207,6 +216,9 @@ ssize_t tls13_peek_application_data(struct tls13_record_layer *rl, uint8_t *buf,
 ssize_t tls13_read_application_data(struct tls13_record_layer *rl, uint8_t *buf, size_t n);
 ssize_t tls13_write_application_data(struct tls13_record_layer *rl, const uint8_t *buf,
     size_t n);
+ssize_t tls13_read_early_data(struct tls13_record_layer *rl, uint8_t *buf, size_t n);
+ssize_t tls13_write_early_data(struct tls13_record_layer *rl, const uint8_t *buf,
+    size_t n);
 
 ssize_t tls13_send_alert(struct tls13_record_layer *rl, uint8_t alert_desc);
 ssize_t tls13_send_dummy_ccs(struct tls13_record_layer *rl);
@@ -268,6 +280,8 @@ struct tls13_ctx {
 	struct tls13_record_layer *rl;
 	struct tls13_handshake_msg *hs_msg;
 	uint8_t key_update_request;
+	uint8_t ticket_nonce;
+	size_t tickets_pending;
 	uint8_t alert;
 	int phh_count;
 	time_t phh_last_seen;
@@ -284,16 +298,33 @@ struct tls13_ctx {
 #define TLS13_PHH_LIMIT 100
 #endif
 
+/*
+ * Early data is only accepted if the client's view of the ticket age is
+ * within this many seconds of our own (RFC 8446 section 8.3).
+ */
+#ifndef TLS13_EARLY_DATA_AGE_WINDOW
+#define TLS13_EARLY_DATA_AGE_WINDOW 10
+#endif
+
+struct tls13_replay_cache;
+
+struct tls13_replay_cache *tls13_replay_cache_new(time_t window);
+void tls13_replay_cache_free(struct tls13_replay_cache *rc);
+int tls13_replay_cache_check(struct tls13_replay_cache *rc, const uint8_t *id,
+    size_t id_len, time_t now);
+
 struct tls13_ctx *tls13_ctx_new(int mode);
 void tls13_ctx_free(struct tls13_ctx *ctx);
 
 const EVP_AEAD *tls13_cipher_aead(const SSL_CIPHER *cipher);
 const EVP_MD *tls13_cipher_hash(const SSL_CIPHER *cipher);
+int tls13_early_data_engage(struct tls13_ctx *ctx, SSL_SESSION *sess);
 
 int tls13_record_layer_set_read_traffic_key(struct tls13_ctx *ctx, struct tls13_record_layer *rl,
                                             struct tls13_secret *read_key);
 int tls13_record_layer_set_write_traffic_key(struct tls13_ctx *ctx, struct tls13_record_layer *rl,
                                              struct tls13_secret *write_key);
+void tls13_record_layer_clear_write_traffic_key(struct tls13_record_layer *rl);
 int tls13_hkdf_expand_label(struct tls13_ctx *ctx, struct tls13_secret *out, const EVP_MD *digest,
                             const struct tls13_secret *secret, const char *label,
                             const struct tls13_secret *context);
@@ -314,6 +345,17 @@ int tls13_derive_handshake_secrets(struct tls13_ctx *ctx, struct tls13_secrets *
                                    const uint8_t *ecdhe, size_t ecdhe_len, const struct tls13_secret *context);
 int tls13_derive_application_secrets(struct tls13_ctx *ctx, struct tls13_secrets *secrets,
                                      const struct tls13_secret *context);
+int tls13_derive_resumption_secrets(struct tls13_ctx *ctx,
+    struct tls13_secrets *secrets, const struct tls13_secret *context);
+int tls13_derive_ticket_psk(struct tls13_ctx *ctx, struct tls13_secrets *secrets,
+    const uint8_t *nonce, size_t nonce_len, struct tls13_secret *psk);
+int tls13_psk_binder(struct tls13_ctx *ctx, const EVP_MD *digest,
+    const uint8_t *psk, size_t psk_len, const uint8_t *transcript_hash,
+    size_t transcript_hash_len, uint8_t *binder, size_t binder_len);
+int tls13_derive_early_traffic_secret(struct tls13_ctx *ctx,
+    const EVP_MD *digest, const uint8_t *psk, size_t psk_len,
+    const uint8_t *hello_hash, size_t hello_hash_len,
+    struct tls13_secret *secret);
 int tls13_update_client_traffic_secret(struct tls13_ctx *ctx, struct tls13_secrets *secrets);
 int tls13_update_server_traffic_secret(struct tls13_ctx *ctx, struct tls13_secrets *secrets);
 /*
@@ -330,6 +372,10 @@ int tls13_legacy_pending(const SSL *ssl);
 int tls13_legacy_read_bytes(SSL *ssl, int type, unsigned char *buf, int len,
     int peek);
 int tls13_legacy_write_bytes(SSL *ssl, int type, const void *buf, int len);
+int tls13_legacy_read_early_data(SSL *ssl, void *buf, size_t len,
+    size_t *readbytes);
+int tls13_legacy_write_early_data(SSL *ssl, const void *buf, size_t len,
+    size_t *written);
 int tls13_legacy_shutdown(SSL *ssl);
 int tls13_legacy_servername_process(struct tls13_ctx *ctx, uint8_t *alert);
 
@@ -375,6 +421,7 @@ int tls13_client_hello_recv(struct tls13_ctx *ctx, CBS *cbs);
 int tls13_client_hello_retry_send(struct tls13_ctx *ctx, CBB *cbb);
 int tls13_client_hello_retry_recv(struct tls13_ctx *ctx, CBS *cbs);
 int tls13_client_end_of_early_data_send(struct tls13_ctx *ctx, CBB *cbb);
+int tls13_client_end_of_early_data_sent(struct tls13_ctx *ctx);
 int tls13_client_end_of_early_data_recv(struct tls13_ctx *ctx, CBS *cbs);
 int tls13_client_certificate_send(struct tls13_ctx *ctx, CBB *cbb);
 int tls13_client_certificate_recv(struct tls13_ctx *ctx, CBS *cbs);
@@ -400,6 +447,8 @@ int tls13_server_certificate_verify_recv(struct tls13_ctx *ctx, CBS *cbs);
 int tls13_server_finished_recv(struct tls13_ctx *ctx, CBS *cbs);
 int tls13_server_finished_send(struct tls13_ctx *ctx, CBB *cbb);
 int tls13_server_finished_sent(struct tls13_ctx *ctx);
+ssize_t tls13_new_session_ticket_send(struct tls13_ctx *ctx);
+ssize_t tls13_new_session_ticket_recv(struct tls13_ctx *ctx, CBS *cbs);
 
 void tls13_error_clear(struct tls13_error *error);
 int tls13_cert_add(struct tls13_ctx *ctx, CBB *cbb, X509 *cert,
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 
 #include <openssl/hkdf.h>
+#include <openssl/hmac.h>
 
 #include "bytestring.h"
 #include "tls13_internal.h"
@@ -202,7 +203,8 @@ tls13_hkdf_expand_label_with_length(struct tls13_ctx *ctx, struct tls13_secret *
         }
         memcpy(claim.transcript.data, data, datalen);
         claim.transcript.length = datalen;
-        ctx->ssl->claim(claim, ctx->ssl->claim_ctx);
+        if (ctx->ssl->claim != NULL)
+            ctx->ssl->claim(claim, ctx->ssl->claim_ctx);
     }
 
 	const char tls13_plabel[] = "tls13 ";
@@ -377,6 +379,25 @@ tls13_derive_application_secrets(struct tls13_ctx *ctx, struct tls13_secrets *se
 	    secrets->digest, &secrets->extracted_master, "exp master",
 	    context))
 		return 0;
+
+	/*
+	 * The master secret is retained until the resumption master secret
+	 * has been derived, since this requires the transcript through the
+	 * client finished message.
+	 */
+	secrets->schedule_done = 1;
+
+	return 1;
+}
+
+int
+tls13_derive_resumption_secrets(struct tls13_ctx *ctx,
+    struct tls13_secrets *secrets, const struct tls13_secret *context)
+{
+	if (!secrets->init_done || !secrets->schedule_done ||
+	    secrets->resumption_done)
+		return 0;
+
 	if (!tls13_derive_secret(ctx, &secrets->resumption_master,
 	    secrets->digest, &secrets->extracted_master, "res master",
 	    context))
@@ -387,11 +408,146 @@ tls13_derive_application_secrets(struct tls13_ctx *ctx, struct tls13_secrets *se
 		explicit_bzero(secrets->extracted_master.data,
 		    secrets->extracted_master.len);
 
-	secrets->schedule_done = 1;
+	secrets->resumption_done = 1;
 
 	return 1;
 }
 
+/*
+ * Derive the PSK associated with a ticket from the resumption master secret,
+ * as per RFC 8446 section 4.6.1.
+ */
+int
+tls13_derive_ticket_psk(struct tls13_ctx *ctx, struct tls13_secrets *secrets,
+    const uint8_t *nonce, size_t nonce_len, struct tls13_secret *psk)
+{
+	struct tls13_secret context;
+
+	if (!secrets->resumption_done)
+		return 0;
+	if (psk->len != secrets->resumption_master.len)
+		return 0;
+
+	context.data = (uint8_t *)nonce;
+	context.len = nonce_len;
+
+	return tls13_hkdf_expand_label(ctx, psk, secrets->digest,
+	    &secrets->resumption_master, "resumption", &context);
+}
+
+/*
+ * Compute a PSK binder value given the hash of the partial transcript - see
+ * RFC 8446 section 4.2.11.2. Only resumption PSKs are supported.
+ */
+int
+tls13_psk_binder(struct tls13_ctx *ctx, const EVP_MD *digest,
+    const uint8_t *psk, size_t psk_len, const uint8_t *transcript_hash,
+    size_t transcript_hash_len, uint8_t *binder, size_t binder_len)
+{
+	struct tls13_secret context = { .data = "", .len = 0 };
+	struct tls13_secret early, binder_key, finished_key, empty_hash;
+	uint8_t early_buf[EVP_MAX_MD_SIZE], binder_key_buf[EVP_MAX_MD_SIZE];
+	uint8_t finished_key_buf[EVP_MAX_MD_SIZE];
+	uint8_t empty_hash_buf[EVP_MAX_MD_SIZE], zeros[EVP_MAX_MD_SIZE];
+	unsigned int empty_hash_len, hlen;
+	size_t hash_len;
+	int ret = 0;
+
+	hash_len = EVP_MD_size(digest);
+	if (hash_len > EVP_MAX_MD_SIZE || binder_len != hash_len)
+		return 0;
+	if (transcript_hash_len != hash_len)
+		return 0;
+
+	memset(zeros, 0, sizeof(zeros));
+
+	early.data = early_buf;
+	early.len = hash_len;
+	binder_key.data = binder_key_buf;
+	binder_key.len = hash_len;
+	finished_key.data = finished_key_buf;
+	finished_key.len = hash_len;
+	empty_hash.data = empty_hash_buf;
+	empty_hash.len = hash_len;
+
+	if (!EVP_Digest("", 0, empty_hash_buf, &empty_hash_len, digest, NULL))
+		goto err;
+
+	if (!HKDF_extract(early.data, &early.len, digest, psk, psk_len,
+	    zeros, hash_len))
+		goto err;
+	if (early.len != hash_len)
+		goto err;
+
+	if (!tls13_derive_secret(ctx, &binder_key, digest, &early,
+	    "res binder", &empty_hash))
+		goto err;
+	if (!tls13_hkdf_expand_label(ctx, &finished_key, digest, &binder_key,
+	    "finished", &context))
+		goto err;
+
+	if (HMAC(digest, finished_key.data, finished_key.len, transcript_hash,
+	    transcript_hash_len, binder, &hlen) == NULL)
+		goto err;
+	if (hlen != binder_len)
+		goto err;
+
+	ret = 1;
+
+ err:
+	explicit_bzero(early_buf, sizeof(early_buf));
+	explicit_bzero(binder_key_buf, sizeof(binder_key_buf));
+	explicit_bzero(finished_key_buf, sizeof(finished_key_buf));
+
+	return ret;
+}
+
+/*
+ * Derive the client_early_traffic_secret for 0-RTT - RFC 8446 section 7.1.
+ * The hello hash is the transcript hash of the ClientHello that offered the
+ * PSK, which is the only message covered by early data keys.
+ */
+int
+tls13_derive_early_traffic_secret(struct tls13_ctx *ctx, const EVP_MD *digest,
+    const uint8_t *psk, size_t psk_len, const uint8_t *hello_hash,
+    size_t hello_hash_len, struct tls13_secret *secret)
+{
+	struct tls13_secret early, context;
+	uint8_t early_buf[EVP_MAX_MD_SIZE], zeros[EVP_MAX_MD_SIZE];
+	size_t hash_len;
+	int ret = 0;
+
+	hash_len = EVP_MD_size(digest);
+	if (hash_len > EVP_MAX_MD_SIZE || hello_hash_len != hash_len)
+		return 0;
+	if (secret->len != hash_len)
+		return 0;
+
+	memset(zeros, 0, sizeof(zeros));
+
+	early.data = early_buf;
+	early.len = hash_len;
+	context.data = (uint8_t *)hello_hash;
+	context.len = hello_hash_len;
+
+	if (!HKDF_extract(early.data, &early.len, digest, psk, psk_len,
+	    zeros, hash_len))
+		goto err;
+	if (early.len != hash_len)
+		goto err;
+
+	if (!tls13_derive_secret(ctx, secret, digest, &early, "c e traffic",
+	    &context))
+		goto err;
+
+	ret = 1;
+
+ err:
+	explicit_bzero(early_buf, sizeof(early_buf));
+
+	return ret;
+}
+
 int
 tls13_update_client_traffic_secret(struct tls13_ctx *ctx, struct tls13_secrets *secrets)
 {
@@ -383,6 +383,125 @@ tls13_use_legacy_server(struct tls13_ctx *ctx)
 	return 1;
 }
 
+/*
+ * Early data is written once the ClientHello has been sent and before the
+ * ServerHello is read - SSL_do_handshake() is used to progress the handshake
+ * to that point, with the handshake pausing there.
+ */
+int
+tls13_legacy_write_early_data(SSL *ssl, const void *vbuf, size_t len,
+    size_t *written)
+{
+	struct tls13_ctx *ctx = ssl->internal->tls13;
+	const uint8_t *buf = vbuf;
+	SSL_SESSION *sess;
+	size_t n, sent;
+	ssize_t ret;
+
+	if (ctx == NULL) {
+		if (ssl->session == NULL ||
+		    ssl->session->max_early_data == 0) {
+			SSLerror(ssl, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+			return 0;
+		}
+	}
+
+	S3I(ssl)->hs.tls13.early_data_pause = 1;
+	ret = SSL_do_handshake(ssl);
+	S3I(ssl)->hs.tls13.early_data_pause = 0;
+	if (ret <= 0)
+		return 0;
+
+	if ((ctx = ssl->internal->tls13) == NULL ||
+	    !ctx->hs->tls13.early_data || ctx->hs->tls13.early_data_done ||
+	    (sess = ctx->hs->tls13.psk_session) == NULL) {
+		SSLerror(ssl, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+		return 0;
+	}
+
+	if (len > sess->max_early_data ||
+	    ctx->hs->tls13.early_data_len > sess->max_early_data - len) {
+		SSLerror(ssl, SSL_R_BAD_LENGTH);
+		return 0;
+	}
+
+	/* The dummy ChangeCipherSpec immediately follows the ClientHello. */
+	if (ctx->send_dummy_ccs) {
+		if ((ret = tls13_send_dummy_ccs(ctx->rl)) != TLS13_IO_SUCCESS) {
+			tls13_legacy_return_code(ssl, ret);
+			return 0;
+		}
+		ctx->send_dummy_ccs = 0;
+	}
+
+	sent = S3I(ssl)->wnum;
+	if (len < sent) {
+		SSLerror(ssl, SSL_R_BAD_LENGTH);
+		return 0;
+	}
+	n = len - sent;
+	while (n > 0) {
+		if ((ret = tls13_write_early_data(ctx->rl, &buf[sent],
+		    n)) <= 0) {
+			S3I(ssl)->wnum = sent;
+			tls13_legacy_return_code(ssl, ret);
+			return 0;
+		}
+		sent += ret;
+		n -= ret;
+	}
+	S3I(ssl)->wnum = 0;
+
+	ctx->hs->tls13.early_data_len += len;
+	*written = len;
+
+	return 1;
+}
+
+/*
+ * Early data is read after the server has sent its Finished message and
+ * before the client's EndOfEarlyData message is processed.
+ */
+int
+tls13_legacy_read_early_data(SSL *ssl, void *buf, size_t len,
+    size_t *readbytes)
+{
+	struct tls13_ctx *ctx;
+	ssize_t ret;
+
+	if (S3I(ssl)->hs.tls13.early_data_done)
+		return SSL_READ_EARLY_DATA_FINISH;
+
+	S3I(ssl)->hs.tls13.early_data_pause = 1;
+	ret = SSL_do_handshake(ssl);
+	S3I(ssl)->hs.tls13.early_data_pause = 0;
+	if (ret <= 0)
+		return SSL_READ_EARLY_DATA_ERROR;
+
+	if ((ctx = ssl->internal->tls13) == NULL || ctx->handshake_completed ||
+	    !ctx->hs->tls13.early_data_accepted) {
+		S3I(ssl)->hs.tls13.early_data_done = 1;
+		return SSL_READ_EARLY_DATA_FINISH;
+	}
+
+	if (len > INT_MAX)
+		len = INT_MAX;
+
+	ret = tls13_read_early_data(ctx->rl, buf, len);
+	if (ret > 0) {
+		*readbytes = ret;
+		return SSL_READ_EARLY_DATA_SUCCESS;
+	}
+	if (ret == TLS13_IO_EOF) {
+		S3I(ssl)->hs.tls13.early_data_done = 1;
+		return SSL_READ_EARLY_DATA_FINISH;
+	}
+
+	tls13_legacy_return_code(ssl, ret);
+
+	return SSL_READ_EARLY_DATA_ERROR;
+}
+
 int
 tls13_legacy_accept(SSL *ssl)
 {
@@ -411,7 +530,7 @@ tls13_legacy_accept(SSL *ssl)
 	ret = tls13_server_accept(ctx);
 	if (ret == TLS13_IO_USE_LEGACY)
 		return ssl->method->internal->ssl_accept(ssl);
-	if (ret == TLS13_IO_SUCCESS)
+	if (ret == TLS13_IO_SUCCESS && ctx->handshake_completed)
 		ctx->hs->state = SSL_ST_OK;
 
 	return tls13_legacy_return_code(ssl, ret);
@@ -453,7 +572,7 @@ tls13_legacy_connect(SSL *ssl)
 	ret = tls13_client_connect(ctx);
 	if (ret == TLS13_IO_USE_LEGACY)
 		return ssl->method->internal->ssl_connect(ssl);
-	if (ret == TLS13_IO_SUCCESS)
+	if (ret == TLS13_IO_SUCCESS && ctx->handshake_completed)
 		ctx->hs->state = SSL_ST_OK;
 
 	return tls13_legacy_return_code(ssl, ret);
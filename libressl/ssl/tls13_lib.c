@@ -103,6 +103,64 @@ tls13_cipher_hash(const SSL_CIPHER *cipher)
 	return NULL;
 }
 
+/*
+ * Engage early data record protection for the session being resumed - the
+ * client writes and the server reads with the client_early_traffic_secret,
+ * which is derived from the PSK and the hash of the ClientHello.
+ */
+int
+tls13_early_data_engage(struct tls13_ctx *ctx, SSL_SESSION *sess)
+{
+	struct tls13_secret secret;
+	uint8_t secret_buf[EVP_MAX_MD_SIZE];
+	uint8_t hello_hash[EVP_MAX_MD_SIZE];
+	unsigned int hello_hash_len;
+	const unsigned char *msgs;
+	size_t msgs_len;
+	const EVP_AEAD *aead;
+	const EVP_MD *md;
+	int ret = 0;
+
+	if ((aead = tls13_cipher_aead(sess->cipher)) == NULL)
+		goto err;
+	if ((md = tls13_cipher_hash(sess->cipher)) == NULL)
+		goto err;
+	if (sess->master_key_length != EVP_MD_size(md))
+		goto err;
+
+	/* The transcript only contains the ClientHello at this point. */
+	if (!tls1_transcript_data(ctx->ssl, &msgs, &msgs_len))
+		goto err;
+	if (!EVP_Digest(msgs, msgs_len, hello_hash, &hello_hash_len, md, NULL))
+		goto err;
+
+	secret.data = secret_buf;
+	secret.len = EVP_MD_size(md);
+	if (!tls13_derive_early_traffic_secret(ctx, md, sess->master_key,
+	    sess->master_key_length, hello_hash, hello_hash_len, &secret))
+		goto err;
+
+	tls13_record_layer_set_aead(ctx->rl, aead);
+	tls13_record_layer_set_hash(ctx->rl, md);
+
+	if (ctx->mode == TLS13_HS_CLIENT) {
+		if (!tls13_record_layer_set_write_traffic_key(ctx, ctx->rl,
+		    &secret))
+			goto err;
+	} else {
+		if (!tls13_record_layer_set_read_traffic_key(ctx, ctx->rl,
+		    &secret))
+			goto err;
+	}
+
+	ret = 1;
+
+ err:
+	explicit_bzero(secret_buf, sizeof(secret_buf));
+
+	return ret;
+}
+
 static void
 tls13_alert_received_cb(uint8_t alert_desc, void *arg)
 {
@@ -332,6 +390,10 @@ tls13_phh_done_cb(void *cb_arg)
 		tls13_phh_update_local_traffic_secret(ctx);
 		ctx->key_update_request = 0;
 	}
+
+	/* Queue the next NewSessionTicket, if any remain to be sent. */
+	if (ctx->tickets_pending > 0)
+		(void)tls13_new_session_ticket_send(ctx);
 }
 
 static ssize_t
@@ -363,7 +425,7 @@ tls13_phh_received_cb(void *cb_arg, CBS *cbs)
 		ret = tls13_key_update_recv(ctx, &phh_cbs);
 		break;
 	case TLS13_MT_NEW_SESSION_TICKET:
-		/* XXX do nothing for now and ignore this */
+		ret = tls13_new_session_ticket_recv(ctx, &phh_cbs);
 		break;
 	case TLS13_MT_CERTIFICATE_REQUEST:
 		/* XXX add support if we choose to advertise this */
@@ -26,6 +26,7 @@ static ssize_t tls13_record_layer_write_record(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len);
 
 struct tls13_record_protection {
+	const EVP_AEAD *aead;
 	EVP_AEAD_CTX aead_ctx;
 	struct tls13_secret iv;
 	struct tls13_secret nonce;
@@ -42,6 +43,7 @@ void
 tls13_record_protection_clear(struct tls13_record_protection *rp)
 {
 	EVP_AEAD_CTX_cleanup(&rp->aead_ctx);
+	rp->aead = NULL;
 
 	tls13_secret_cleanup(&rp->iv);
 	tls13_secret_cleanup(&rp->nonce);
@@ -71,6 +73,17 @@ struct tls13_record_layer {
 	int phh;
 	int phh_retry;
 
+	/*
+	 * Early data (RFC 8446 section 4.2.10) - either we are accepting early
+	 * data, in which case application data may be read before the
+	 * handshake completes, or we have rejected it and need to skip over
+	 * the peer's early data records. Either way the amount of early data
+	 * is limited to early_data_len bytes.
+	 */
+	int early_data;
+	int early_data_skip;
+	size_t early_data_len;
+
 	/*
 	 * Read and/or write channels are closed due to an alert being
 	 * sent or received. In the case of an error alert both channels
@@ -82,7 +95,13 @@ struct tls13_record_layer {
 
 	struct tls13_record *rrec;
 
-	struct tls13_record *wrec;
+	/*
+	 * Buffer that records are sealed into, which is allocated on first
+	 * use and reused for the lifetime of the record layer. The CBS
+	 * tracks the part of the current record that is yet to be written.
+	 */
+	uint8_t *wbuf;
+	CBS wbuf_cbs;
 	uint8_t wrec_content_type;
 	size_t wrec_appdata_len;
 	size_t wrec_content_len;
@@ -136,10 +155,11 @@ tls13_record_layer_rrec_free(struct tls13_record_layer *rl)
 }
 
 static void
-tls13_record_layer_wrec_free(struct tls13_record_layer *rl)
+tls13_record_layer_wbuf_free(struct tls13_record_layer *rl)
 {
-	tls13_record_free(rl->wrec);
-	rl->wrec = NULL;
+	CBS_init(&rl->wbuf_cbs, NULL, 0);
+	freezero(rl->wbuf, TLS13_RECORD_MAX_LEN);
+	rl->wbuf = NULL;
 }
 
 struct tls13_record_layer *
@@ -175,7 +195,7 @@ tls13_record_layer_free(struct tls13_record_layer *rl)
 		return;
 
 	tls13_record_layer_rrec_free(rl);
-	tls13_record_layer_wrec_free(rl);
+	tls13_record_layer_wbuf_free(rl);
 
 	freezero(rl->alert_data, rl->alert_len);
 	freezero(rl->phh_data, rl->phh_len);
@@ -247,6 +267,23 @@ tls13_record_layer_allow_legacy_alerts(struct tls13_record_layer *rl, int allow)
 	rl->legacy_alerts_allowed = allow;
 }
 
+void
+tls13_record_layer_allow_early_data(struct tls13_record_layer *rl, int allow,
+    size_t max_len)
+{
+	rl->early_data = allow;
+	rl->early_data_skip = 0;
+	rl->early_data_len = allow ? max_len : 0;
+}
+
+void
+tls13_record_layer_skip_early_data(struct tls13_record_layer *rl,
+    size_t max_len)
+{
+	rl->early_data_skip = 1;
+	rl->early_data_len = max_len;
+}
+
 void
 tls13_record_layer_set_aead(struct tls13_record_layer *rl,
     const EVP_AEAD *aead)
@@ -488,6 +525,7 @@ tls13_record_layer_set_traffic_key(struct tls13_ctx *ctx, const EVP_AEAD *aead,
 	if (!EVP_AEAD_CTX_init(&rp->aead_ctx, aead, key.data, key.len,
 	    EVP_AEAD_DEFAULT_TAG_LENGTH, NULL))
 		goto err;
+	rp->aead = aead;
 
 	ret = 1;
 
@@ -513,12 +551,22 @@ tls13_record_layer_set_write_traffic_key(struct tls13_ctx *ctx, struct tls13_rec
 	    rl->write, write_key);
 }
 
+/*
+ * Revert to sending plaintext records, which is needed by a client that
+ * sent early data and then received a HelloRetryRequest.
+ */
+void
+tls13_record_layer_clear_write_traffic_key(struct tls13_record_layer *rl)
+{
+	tls13_record_protection_clear(rl->write);
+}
+
 static int
 tls13_record_layer_open_record_plaintext(struct tls13_record_layer *rl)
 {
 	CBS cbs;
 
-	if (rl->aead != NULL)
+	if (rl->read->aead != NULL)
 		return 0;
 
 	/*
@@ -555,7 +603,7 @@ tls13_record_layer_open_record_protected(struct tls13_record_layer *rl)
 	uint8_t content_type;
 	size_t out_len;
 
-	if (rl->aead == NULL)
+	if (rl->read->aead == NULL)
 		goto err;
 
 	if (!tls13_record_header(rl->rrec, &header))
@@ -625,23 +673,36 @@ tls13_record_layer_open_record_protected(struct tls13_record_layer *rl)
 static int
 tls13_record_layer_open_record(struct tls13_record_layer *rl)
 {
-	if (rl->handshake_completed && rl->aead == NULL)
+	if (rl->handshake_completed && rl->read->aead == NULL)
 		return 0;
 
-	if (rl->aead == NULL)
+	if (rl->read->aead == NULL)
 		return tls13_record_layer_open_record_plaintext(rl);
 
 	return tls13_record_layer_open_record_protected(rl);
 }
 
+static void
+tls13_record_layer_wbuf_header(struct tls13_record_layer *rl,
+    uint8_t content_type, uint16_t version, size_t len)
+{
+	uint8_t *header = rl->wbuf;
+
+	/*
+	 * The header is built by hand, rather than via a CBB, since it is
+	 * written into the reusable write buffer for every record sealed.
+	 */
+	header[0] = content_type;
+	header[1] = version >> 8;
+	header[2] = version & 0xff;
+	header[3] = len >> 8;
+	header[4] = len & 0xff;
+}
+
 static int
 tls13_record_layer_seal_record_plaintext(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len)
 {
-	uint8_t *data = NULL;
-	size_t data_len = 0;
-	CBB cbb, body;
-
 	/*
 	 * Allow dummy CCS messages to be sent in plaintext even when
 	 * record protection has been engaged, as long as the handshake
@@ -649,156 +710,110 @@ tls13_record_layer_seal_record_plaintext(struct tls13_record_layer *rl,
 	 */
 	if (rl->handshake_completed)
 		return 0;
-	if (rl->aead != NULL && content_type != SSL3_RT_CHANGE_CIPHER_SPEC)
+	if (rl->write->aead != NULL &&
+	    content_type != SSL3_RT_CHANGE_CIPHER_SPEC)
+		return 0;
+
+	if (content_len > TLS13_RECORD_MAX_PLAINTEXT_LEN)
 		return 0;
 
 	/*
 	 * We're still operating in plaintext mode, so just copy the
 	 * content into the record.
 	 */
-	if (!CBB_init(&cbb, TLS13_RECORD_HEADER_LEN + content_len))
-		goto err;
-
-	if (!CBB_add_u8(&cbb, content_type))
-		goto err;
-	if (!CBB_add_u16(&cbb, rl->legacy_version))
-		goto err;
-	if (!CBB_add_u16_length_prefixed(&cbb, &body))
-		goto err;
-	if (!CBB_add_bytes(&body, content, content_len))
-		goto err;
+	tls13_record_layer_wbuf_header(rl, content_type, rl->legacy_version,
+	    content_len);
+	memcpy(rl->wbuf + TLS13_RECORD_HEADER_LEN, content, content_len);
 
-	if (!CBB_finish(&cbb, &data, &data_len))
-		goto err;
-
-	if (!tls13_record_set_data(rl->wrec, data, data_len))
-		goto err;
+	CBS_init(&rl->wbuf_cbs, rl->wbuf,
+	    TLS13_RECORD_HEADER_LEN + content_len);
 
 	rl->wrec_content_len = content_len;
 	rl->wrec_content_type = content_type;
 
 	return 1;
-
- err:
-	CBB_cleanup(&cbb);
-	freezero(data, data_len);
-
-	return 0;
 }
 
 static int
 tls13_record_layer_seal_record_protected(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len)
 {
-	uint8_t *data = NULL, *header = NULL, *inner = NULL;
-	size_t data_len = 0, header_len = 0, inner_len = 0;
-	uint8_t *enc_record;
-	size_t enc_record_len;
-	ssize_t ret = 0;
+	EVP_AEAD_IOVEC in[2], ad[1], out[1];
+	size_t enc_record_len, inner_len;
 	size_t out_len;
-	CBB cbb;
 
-	if (rl->aead == NULL)
+	if (rl->write->aead == NULL)
 		return 0;
 
-	memset(&cbb, 0, sizeof(cbb));
-
-	/* Build inner plaintext. */
-	if (!CBB_init(&cbb, content_len + 1))
-		goto err;
-	if (!CBB_add_bytes(&cbb, content, content_len))
-		goto err;
-	if (!CBB_add_u8(&cbb, content_type))
-		goto err;
+	/*
+	 * The inner plaintext is the content followed by the real content
+	 * type - these are passed to the AEAD as separate regions, rather
+	 * than being copied into a contiguous buffer.
+	 */
 	/* XXX - padding? */
-	if (!CBB_finish(&cbb, &inner, &inner_len))
-		goto err;
-
+	inner_len = content_len + 1;
 	if (inner_len > TLS13_RECORD_MAX_INNER_PLAINTEXT_LEN)
-		goto err;
+		return 0;
 
 	/* XXX EVP_AEAD_max_tag_len vs EVP_AEAD_CTX_tag_len. */
-	enc_record_len = inner_len + EVP_AEAD_max_tag_len(rl->aead);
+	enc_record_len = inner_len + EVP_AEAD_max_tag_len(rl->write->aead);
 	if (enc_record_len > TLS13_RECORD_MAX_CIPHERTEXT_LEN)
-		goto err;
-
-	/* Build the record header. */
-	if (!CBB_init(&cbb, TLS13_RECORD_HEADER_LEN))
-		goto err;
-	if (!CBB_add_u8(&cbb, SSL3_RT_APPLICATION_DATA))
-		goto err;
-	if (!CBB_add_u16(&cbb, TLS1_2_VERSION))
-		goto err;
-	if (!CBB_add_u16(&cbb, enc_record_len))
-		goto err;
-	if (!CBB_finish(&cbb, &header, &header_len))
-		goto err;
+		return 0;
 
-	/* Build the actual record. */
-	if (!CBB_init(&cbb, TLS13_RECORD_HEADER_LEN + enc_record_len))
-		goto err;
-	if (!CBB_add_bytes(&cbb, header, header_len))
-		goto err;
-	if (!CBB_add_space(&cbb, &enc_record, enc_record_len))
-		goto err;
-	if (!CBB_finish(&cbb, &data, &data_len))
-		goto err;
+	tls13_record_layer_wbuf_header(rl, SSL3_RT_APPLICATION_DATA,
+	    TLS1_2_VERSION, enc_record_len);
 
 	if (!tls13_record_layer_update_nonce(&rl->write->nonce,
 	    &rl->write->iv, rl->write->seq_num))
-		goto err;
+		return 0;
 
-	/*
-	 * XXX - consider a EVP_AEAD_CTX_seal_iov() that takes an iovec...
-	 * this would avoid a copy since the inner would be passed as two
-	 * separate pieces.
-	 */
-	if (!EVP_AEAD_CTX_seal(&rl->write->aead_ctx,
-	    enc_record, &out_len, enc_record_len,
-	    rl->write->nonce.data, rl->write->nonce.len,
-	    inner, inner_len, header, header_len))
-		goto err;
+	in[0].data = (uint8_t *)content;
+	in[0].len = content_len;
+	in[1].data = &content_type;
+	in[1].len = 1;
+
+	ad[0].data = rl->wbuf;
+	ad[0].len = TLS13_RECORD_HEADER_LEN;
+
+	/* Ciphertext and tag are written directly after the header. */
+	out[0].data = rl->wbuf + TLS13_RECORD_HEADER_LEN;
+	out[0].len = enc_record_len;
+
+	if (!EVP_AEAD_CTX_sealv(&rl->write->aead_ctx, out, 1, &out_len,
+	    rl->write->nonce.data, rl->write->nonce.len, in, 2, ad, 1))
+		return 0;
 
 	if (out_len != enc_record_len)
-		goto err;
+		return 0;
 
 	if (!tls13_record_layer_inc_seq_num(rl->write->seq_num))
-		goto err;
+		return 0;
 
-	if (!tls13_record_set_data(rl->wrec, data, data_len))
-		goto err;
+	CBS_init(&rl->wbuf_cbs, rl->wbuf,
+	    TLS13_RECORD_HEADER_LEN + enc_record_len);
 
 	rl->wrec_content_len = content_len;
 	rl->wrec_content_type = content_type;
 
-	data = NULL;
-	data_len = 0;
-
-	ret = 1;
-
- err:
-	CBB_cleanup(&cbb);
-
-	freezero(data, data_len);
-	freezero(header, header_len);
-	freezero(inner, inner_len);
-
-	return ret;
+	return 1;
 }
 
 static int
 tls13_record_layer_seal_record(struct tls13_record_layer *rl,
     uint8_t content_type, const uint8_t *content, size_t content_len)
 {
-	if (rl->handshake_completed && rl->aead == NULL)
+	if (rl->handshake_completed && rl->write->aead == NULL)
 		return 0;
 
-	tls13_record_layer_wrec_free(rl);
+	CBS_init(&rl->wbuf_cbs, NULL, 0);
 
-	if ((rl->wrec = tls13_record_new()) == NULL)
-		return 0;
+	if (rl->wbuf == NULL) {
+		if ((rl->wbuf = calloc(1, TLS13_RECORD_MAX_LEN)) == NULL)
+			return 0;
+	}
 
-	if (rl->aead == NULL || content_type == SSL3_RT_CHANGE_CIPHER_SPEC)
+	if (rl->write->aead == NULL ||
+	    content_type == SSL3_RT_CHANGE_CIPHER_SPEC)
 		return tls13_record_layer_seal_record_plaintext(rl,
 		    content_type, content, content_len);
 
@@ -806,6 +821,47 @@ tls13_record_layer_seal_record(struct tls13_record_layer *rl,
 	    content, content_len);
 }
 
+static ssize_t
+tls13_record_layer_send_wbuf(struct tls13_record_layer *rl)
+{
+	ssize_t ret;
+
+	while (CBS_len(&rl->wbuf_cbs) > 0) {
+		if ((ret = rl->cb.wire_write(CBS_data(&rl->wbuf_cbs),
+		    CBS_len(&rl->wbuf_cbs), rl->cb_arg)) <= 0)
+			return ret;
+
+		if (!CBS_skip(&rl->wbuf_cbs, ret))
+			return TLS13_IO_FAILURE;
+	}
+
+	return TLS13_IO_SUCCESS;
+}
+
+/*
+ * Skip over an early data record that was sent by a client, when we have
+ * rejected early data (RFC 8446 section 4.2.10). The record is accounted
+ * for as if it contained the maximum amount of plaintext.
+ */
+static ssize_t
+tls13_record_layer_skip_early_data_record(struct tls13_record_layer *rl)
+{
+	size_t len = 0;
+	CBS cbs;
+
+	if (!tls13_record_content(rl->rrec, &cbs))
+		return TLS13_IO_FAILURE;
+	if (CBS_len(&cbs) > EVP_AEAD_MAX_TAG_LENGTH + 1)
+		len = CBS_len(&cbs) - EVP_AEAD_MAX_TAG_LENGTH - 1;
+	if (len > rl->early_data_len)
+		return tls13_send_alert(rl, TLS13_ALERT_UNEXPECTED_MESSAGE);
+	rl->early_data_len -= len;
+
+	tls13_record_layer_rrec_free(rl);
+
+	return TLS13_IO_WANT_RETRY;
+}
+
 static ssize_t
 tls13_record_layer_read_record(struct tls13_record_layer *rl)
 {
@@ -855,17 +911,44 @@ tls13_record_layer_read_record(struct tls13_record_layer *rl)
 		return TLS13_IO_WANT_RETRY;
 	}
 
+	/*
+	 * Early data that we have rejected is either protected with keys that
+	 * we do not have, or follows a HelloRetryRequest, in which case we
+	 * are still expecting plaintext. Skip over it until we find a record
+	 * that we can process.
+	 */
+	if (rl->early_data_skip) {
+		if (content_type != SSL3_RT_APPLICATION_DATA) {
+			rl->early_data_skip = 0;
+		} else if (rl->read->aead == NULL) {
+			return tls13_record_layer_skip_early_data_record(rl);
+		} else {
+			/* A failed trial decryption is not an error. */
+			ERR_set_mark();
+			if (!tls13_record_layer_open_record(rl)) {
+				if (rl->alert != 0)
+					goto err;
+				ERR_pop_to_mark();
+				return tls13_record_layer_skip_early_data_record(rl);
+			}
+			rl->early_data_skip = 0;
+			goto opened;
+		}
+	}
+
 	/*
 	 * Once record protection is engaged, we should only receive
 	 * protected application data messages (aside from the
 	 * dummy ChangeCipherSpec messages, handled above).
 	 */
-	if (rl->aead != NULL && content_type != SSL3_RT_APPLICATION_DATA)
+	if (rl->read->aead != NULL && content_type != SSL3_RT_APPLICATION_DATA)
 		return tls13_send_alert(rl, TLS13_ALERT_UNEXPECTED_MESSAGE);
 
 	if (!tls13_record_layer_open_record(rl))
 		goto err;
 
+ opened:
+
 	tls13_record_layer_rrec_free(rl);
 
 	/*
@@ -886,8 +969,12 @@ tls13_record_layer_read_record(struct tls13_record_layer *rl)
 		break;
 
 	case SSL3_RT_APPLICATION_DATA:
-		if (!rl->handshake_completed)
+		if (rl->handshake_completed)
+			break;
+		if (!rl->early_data ||
+		    CBS_len(&rl->rbuf_cbs) > rl->early_data_len)
 			return tls13_send_alert(rl, TLS13_ALERT_UNEXPECTED_MESSAGE);
+		rl->early_data_len -= CBS_len(&rl->rbuf_cbs);
 		break;
 
 	default:
@@ -987,6 +1074,22 @@ tls13_record_layer_read_internal(struct tls13_record_layer *rl,
 		if (rl->rbuf_content_type == SSL3_RT_HANDSHAKE) {
 			if (rl->handshake_completed)
 				return tls13_record_layer_recv_phh(rl);
+			/*
+			 * The end of early data is signalled by the
+			 * EndOfEarlyData handshake message, which is left in
+			 * place for the handshake to consume.
+			 */
+			if (rl->early_data)
+				return TLS13_IO_EOF;
+		}
+		/*
+		 * Early data that is not read before the handshake resumes
+		 * is discarded.
+		 */
+		if (rl->rbuf_content_type == SSL3_RT_APPLICATION_DATA &&
+		    rl->early_data) {
+			tls13_record_layer_rbuf_free(rl);
+			return TLS13_IO_WANT_RETRY;
 		}
 		return tls13_send_alert(rl, TLS13_ALERT_UNEXPECTED_MESSAGE);
 	}
@@ -1064,11 +1167,9 @@ tls13_record_layer_write_record(struct tls13_record_layer *rl,
 	}
 
 	/* See if there is an existing record and attempt to push it out... */
-	if (rl->wrec != NULL) {
-		if ((ret = tls13_record_send(rl->wrec, rl->cb.wire_write,
-		    rl->cb_arg)) <= 0)
+	if (CBS_len(&rl->wbuf_cbs) > 0) {
+		if ((ret = tls13_record_layer_send_wbuf(rl)) <= 0)
 			return ret;
-		tls13_record_layer_wrec_free(rl);
 
 		if (rl->wrec_content_type == content_type) {
 			ret = rl->wrec_content_len;
@@ -1092,11 +1193,9 @@ tls13_record_layer_write_record(struct tls13_record_layer *rl,
 	if (!tls13_record_layer_seal_record(rl, content_type, content, content_len))
 		goto err;
 
-	if ((ret = tls13_record_send(rl->wrec, rl->cb.wire_write, rl->cb_arg)) <= 0)
+	if ((ret = tls13_record_layer_send_wbuf(rl)) <= 0)
 		return ret;
 
-	tls13_record_layer_wrec_free(rl);
-
 	return content_len;
 
  err:
@@ -1201,6 +1300,25 @@ tls13_write_application_data(struct tls13_record_layer *rl, const uint8_t *buf,
 	return tls13_record_layer_write(rl, SSL3_RT_APPLICATION_DATA, buf, n);
 }
 
+ssize_t
+tls13_read_early_data(struct tls13_record_layer *rl, uint8_t *buf, size_t n)
+{
+	if (rl->handshake_completed || !rl->early_data)
+		return TLS13_IO_EOF;
+
+	return tls13_record_layer_read(rl, SSL3_RT_APPLICATION_DATA, buf, n);
+}
+
+ssize_t
+tls13_write_early_data(struct tls13_record_layer *rl, const uint8_t *buf,
+    size_t n)
+{
+	if (rl->handshake_completed || rl->write->aead == NULL)
+		return TLS13_IO_FAILURE;
+
+	return tls13_record_layer_write(rl, SSL3_RT_APPLICATION_DATA, buf, n);
+}
+
 ssize_t
 tls13_send_alert(struct tls13_record_layer *rl, uint8_t alert_desc)
 {
@@ -0,0 +1,163 @@
+/*	$OpenBSD$ */
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/sha.h>
+
+#include "tls13_internal.h"
+
+/*
+ * Anti-replay for 0-RTT - RFC 8446 section 8.2. ClientHellos that carry early
+ * data are only accepted inside a ticket age window, so it is sufficient to
+ * remember the PSK binders seen during the last two windows. This is done
+ * with a pair of bloom filters that are rotated once per window - a false
+ * positive only results in early data being rejected, never accepted.
+ *
+ * The cache is shared by all connections of an SSL_CTX and has its own lock,
+ * so that checking a ClientHello does not serialise on CRYPTO_LOCK_SSL_CTX.
+ */
+
+#define TLS13_REPLAY_FILTER_BITS	(1 << 17)
+#define TLS13_REPLAY_FILTER_HASHES	4
+
+struct tls13_replay_filter {
+	uint8_t bits[TLS13_REPLAY_FILTER_BITS / 8];
+};
+
+struct tls13_replay_cache {
+	pthread_mutex_t lock;
+	struct tls13_replay_filter filters[2];
+	size_t current;
+	time_t window;
+	time_t rotated;
+};
+
+struct tls13_replay_cache *
+tls13_replay_cache_new(time_t window)
+{
+	struct tls13_replay_cache *rc;
+
+	if (window <= 0)
+		return NULL;
+	if ((rc = calloc(1, sizeof(*rc))) == NULL)
+		return NULL;
+	if (pthread_mutex_init(&rc->lock, NULL) != 0) {
+		free(rc);
+		return NULL;
+	}
+
+	rc->window = window;
+
+	return rc;
+}
+
+void
+tls13_replay_cache_free(struct tls13_replay_cache *rc)
+{
+	if (rc == NULL)
+		return;
+
+	pthread_mutex_destroy(&rc->lock);
+	freezero(rc, sizeof(*rc));
+}
+
+static void
+tls13_replay_cache_rotate(struct tls13_replay_cache *rc, time_t now)
+{
+	if (rc->rotated == 0) {
+		rc->rotated = now;
+		return;
+	}
+	if (now - rc->rotated < rc->window)
+		return;
+
+	/*
+	 * If more than two windows have passed, nothing that either filter
+	 * holds can still be inside the ticket age window.
+	 */
+	if (now - rc->rotated >= 2 * rc->window)
+		memset(&rc->filters[rc->current], 0,
+		    sizeof(rc->filters[rc->current]));
+
+	rc->current ^= 1;
+	memset(&rc->filters[rc->current], 0, sizeof(rc->filters[rc->current]));
+	rc->rotated = now;
+}
+
+static int
+tls13_replay_filter_test(const struct tls13_replay_filter *rf,
+    const uint32_t *idx)
+{
+	int i;
+
+	for (i = 0; i < TLS13_REPLAY_FILTER_HASHES; i++) {
+		if ((rf->bits[idx[i] >> 3] & (1 << (idx[i] & 7))) == 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Check whether the given identifier (the PSK binder of a ClientHello) has
+ * been seen within the anti-replay window, recording it if not. Returns 1 if
+ * the identifier is fresh and 0 if it may be a replay.
+ */
+int
+tls13_replay_cache_check(struct tls13_replay_cache *rc, const uint8_t *id,
+    size_t id_len, time_t now)
+{
+	struct tls13_replay_filter *rf;
+	uint8_t md[SHA256_DIGEST_LENGTH];
+	uint32_t idx[TLS13_REPLAY_FILTER_HASHES];
+	int i, ret = 0;
+
+	if (rc == NULL || id_len == 0)
+		return 0;
+
+	/*
+	 * Binders are already uniformly distributed, but may be shorter than
+	 * needed - hash them so that every input yields enough index bits.
+	 */
+	SHA256(id, id_len, md);
+	for (i = 0; i < TLS13_REPLAY_FILTER_HASHES; i++) {
+		idx[i] = (uint32_t)md[i * 4] << 24 |
+		    (uint32_t)md[i * 4 + 1] << 16 |
+		    (uint32_t)md[i * 4 + 2] << 8 | md[i * 4 + 3];
+		idx[i] &= TLS13_REPLAY_FILTER_BITS - 1;
+	}
+
+	(void) pthread_mutex_lock(&rc->lock);
+
+	tls13_replay_cache_rotate(rc, now);
+
+	if (tls13_replay_filter_test(&rc->filters[0], idx) ||
+	    tls13_replay_filter_test(&rc->filters[1], idx))
+		goto done;
+
+	rf = &rc->filters[rc->current];
+	for (i = 0; i < TLS13_REPLAY_FILTER_HASHES; i++)
+		rf->bits[idx[i] >> 3] |= 1 << (idx[i] & 7);
+
+	ret = 1;
+
+ done:
+	(void) pthread_mutex_unlock(&rc->lock);
+
+	return ret;
+}
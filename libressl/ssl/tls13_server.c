@@ -126,6 +126,14 @@ tls13_client_hello_required_extensions(struct tls13_ctx *ctx)
 	    tlsext_extension_seen(s, TLSEXT_TYPE_key_share))
 		return 0;
 
+	/*
+	 * A client offering a pre_shared_key must also send
+	 * psk_key_exchange_modes - RFC 8446, 4.2.9.
+	 */
+	if (tlsext_extension_seen(s, TLSEXT_TYPE_pre_shared_key) &&
+	    !tlsext_extension_seen(s, TLSEXT_TYPE_psk_key_exchange_modes))
+		return 0;
+
 	/*
 	 * XXX - Require server_name from client? If so, we SHOULD enforce
 	 * this here - RFC 8446, 9.2.
@@ -142,6 +150,7 @@ tls13_client_hello_process(struct tls13_ctx *ctx, CBS *cbs)
 	CBS cipher_suites, client_random, compression_methods, session_id;
 	STACK_OF(SSL_CIPHER) *ciphers = NULL;
 	const SSL_CIPHER *cipher;
+	SSL_SESSION *psk_session;
 	uint16_t legacy_version;
 	int alert_desc;
 	SSL *s = ctx->ssl;
@@ -251,6 +260,20 @@ tls13_client_hello_process(struct tls13_ctx *ctx, CBS *cbs)
 	}
 	ctx->hs->cipher = cipher;
 
+	/*
+	 * Only resume with (EC)DHE and if the hash associated with the
+	 * ticket matches that of the selected cipher suite, otherwise
+	 * proceed with a full handshake.
+	 */
+	if ((psk_session = ctx->hs->tls13.psk_session) != NULL) {
+		if (!ctx->hs->tls13.psk_dhe_ke ||
+		    tls13_cipher_hash(psk_session->cipher) !=
+		    tls13_cipher_hash(cipher)) {
+			SSL_SESSION_free(psk_session);
+			ctx->hs->tls13.psk_session = NULL;
+		}
+	}
+
 	sk_SSL_CIPHER_free(s->session->ciphers);
 	s->session->ciphers = ciphers;
 	ciphers = NULL;
@@ -270,6 +293,106 @@ tls13_client_hello_process(struct tls13_ctx *ctx, CBS *cbs)
 	return ret;
 }
 
+/*
+ * Return the SSL_CTX's anti-replay cache, creating it on first use. Only its
+ * creation takes CRYPTO_LOCK_SSL_CTX; the cache has a lock of its own.
+ */
+static struct tls13_replay_cache *
+tls13_server_replay_cache(SSL_CTX *ssl_ctx)
+{
+	struct tls13_replay_cache *rc;
+
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+	rc = __atomic_load_n(&ssl_ctx->internal->early_data_replay,
+	    __ATOMIC_ACQUIRE);
+	if (rc != NULL)
+		return rc;
+#endif
+
+	CRYPTO_w_lock(CRYPTO_LOCK_SSL_CTX);
+	if ((rc = ssl_ctx->internal->early_data_replay) == NULL) {
+		rc = tls13_replay_cache_new(2 * TLS13_EARLY_DATA_AGE_WINDOW);
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+		__atomic_store_n(&ssl_ctx->internal->early_data_replay, rc,
+		    __ATOMIC_RELEASE);
+#else
+		ssl_ctx->internal->early_data_replay = rc;
+#endif
+	}
+	CRYPTO_w_unlock(CRYPTO_LOCK_SSL_CTX);
+
+	return rc;
+}
+
+/*
+ * Early data is only accepted for a resumed session when the application is
+ * reading it, the ticket allowed for it and the handshake matches that of
+ * the original session, including the ALPN protocol selected (RFC 8446
+ * section 4.2.10). The ticket age must be close to our own view of it
+ * and the ClientHello must not have been seen before (RFC 8446 section 8).
+ */
+static int
+tls13_server_early_data_acceptable(struct tls13_ctx *ctx)
+{
+	SSL_SESSION *sess = ctx->hs->tls13.psk_session;
+	int64_t client_age, server_age;
+	SSL *s = ctx->ssl;
+	time_t now;
+
+	if (sess == NULL || !ctx->hs->tls13.early_data_pause)
+		return 0;
+	if (s->internal->max_early_data == 0 || sess->max_early_data == 0)
+		return 0;
+	if (!(ctx->handshake_stage.hs_type & WITHOUT_HRR))
+		return 0;
+	if (ctx->hs->cipher != sess->cipher)
+		return 0;
+
+	if (S3I(s)->alpn_selected_len != sess->internal->alpn_selected_len)
+		return 0;
+	if (S3I(s)->alpn_selected_len > 0 &&
+	    memcmp(S3I(s)->alpn_selected, sess->internal->alpn_selected,
+	    S3I(s)->alpn_selected_len) != 0)
+		return 0;
+
+	now = time(NULL);
+	if (now < sess->time)
+		return 0;
+	client_age = (uint32_t)(ctx->hs->tls13.psk_ticket_age -
+	    sess->tlsext_tick_age_add);
+	server_age = (int64_t)(now - sess->time) * 1000;
+	if (client_age < server_age - TLS13_EARLY_DATA_AGE_WINDOW * 1000 ||
+	    client_age > server_age + TLS13_EARLY_DATA_AGE_WINDOW * 1000)
+		return 0;
+
+	return tls13_replay_cache_check(tls13_server_replay_cache(s->ctx),
+	    ctx->hs->tls13.psk_binder, ctx->hs->tls13.psk_binder_len, now);
+}
+
+static int
+tls13_server_early_data_process(struct tls13_ctx *ctx)
+{
+	SSL_SESSION *sess = ctx->hs->tls13.psk_session;
+	SSL *s = ctx->ssl;
+	size_t max_len;
+
+	if (!tls13_server_early_data_acceptable(ctx)) {
+		/* Skip over the early data that we are not going to read. */
+		max_len = s->internal->max_early_data;
+		if (max_len == 0)
+			max_len = SSL3_RT_MAX_PLAIN_LENGTH;
+		tls13_record_layer_skip_early_data(ctx->rl, max_len);
+		return 1;
+	}
+
+	if (!tls13_early_data_engage(ctx, sess))
+		return 0;
+	tls13_record_layer_allow_early_data(ctx->rl, 1, sess->max_early_data);
+	ctx->hs->tls13.early_data_accepted = 1;
+
+	return 1;
+}
+
 int
 tls13_client_hello_recv(struct tls13_ctx *ctx, CBS *cbs)
 {
@@ -299,6 +422,11 @@ tls13_client_hello_recv(struct tls13_ctx *ctx, CBS *cbs)
 	/* XXX - check this is the correct point */
 	tls13_record_layer_allow_ccs(ctx->rl, 1);
 
+	if (ctx->hs->tls13.early_data) {
+		if (!tls13_server_early_data_process(ctx))
+			goto err;
+	}
+
 	return 1;
 
  err:
@@ -354,6 +482,8 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 	unsigned char buf[EVP_MAX_MD_SIZE];
 	uint8_t *shared_key = NULL;
 	size_t shared_key_len = 0;
+	uint8_t *psk;
+	size_t psk_len;
 	size_t hash_len;
 	SSL *s = ctx->ssl;
 	int ret = 0;
@@ -363,13 +493,15 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 		goto err;
 
 	s->session->cipher = ctx->hs->cipher;
+	s->session->ssl_version = TLS1_3_VERSION;
 
 	if ((ctx->aead = tls13_cipher_aead(ctx->hs->cipher)) == NULL)
 		goto err;
 	if ((ctx->hash = tls13_cipher_hash(ctx->hs->cipher)) == NULL)
 		goto err;
 
-	if ((secrets = tls13_secrets_create(ctx->hash, 0)) == NULL)
+	if ((secrets = tls13_secrets_create(ctx->hash,
+	    s->internal->hit)) == NULL)
 		goto err;
 	ctx->hs->tls13.secrets = secrets;
 
@@ -382,9 +514,15 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 	context.data = buf;
 	context.len = hash_len;
 
-	/* Early secrets. */
-	if (!tls13_derive_early_secrets(ctx, secrets, secrets->zeros.data,
-	    secrets->zeros.len, &context))
+	/* Early secrets - a resumed session carries the PSK as its master key. */
+	psk = secrets->zeros.data;
+	psk_len = secrets->zeros.len;
+	if (s->internal->hit) {
+		if (s->session->master_key_length != psk_len)
+			goto err;
+		psk = s->session->master_key;
+	}
+	if (!tls13_derive_early_secrets(ctx, secrets, psk, psk_len, &context))
 		goto err;
 
 	/* Handshake secrets. */
@@ -395,16 +533,23 @@ tls13_server_engage_record_protection(struct tls13_ctx *ctx)
 	tls13_record_layer_set_aead(ctx->rl, ctx->aead);
 	tls13_record_layer_set_hash(ctx->rl, ctx->hash);
 
-	if (!tls13_record_layer_set_read_traffic_key(ctx, ctx->rl,
-	    &secrets->client_handshake_traffic))
-		goto err;
+	/* Accepted early data is read until the EndOfEarlyData message. */
+	if (!ctx->hs->tls13.early_data_accepted) {
+		if (!tls13_record_layer_set_read_traffic_key(ctx, ctx->rl,
+		    &secrets->client_handshake_traffic))
+			goto err;
+	}
 	if (!tls13_record_layer_set_write_traffic_key(ctx, ctx->rl,
 	    &secrets->server_handshake_traffic))
 		goto err;
 
 	ctx->handshake_stage.hs_type |= NEGOTIATED;
-	if (!(SSL_get_verify_mode(s) & SSL_VERIFY_PEER))
+	if (s->internal->hit)
+		ctx->handshake_stage.hs_type |= WITH_PSK;
+	else if (!(SSL_get_verify_mode(s) & SSL_VERIFY_PEER))
 		ctx->handshake_stage.hs_type |= WITHOUT_CR;
+	if (ctx->hs->tls13.early_data_accepted)
+		ctx->handshake_stage.hs_type |= WITH_0RTT;
 
 	ret = 1;
 
@@ -480,6 +625,29 @@ tls13_servername_process(struct tls13_ctx *ctx)
 	return 1;
 }
 
+static void
+tls13_server_resume_session(struct tls13_ctx *ctx)
+{
+	SSL_SESSION *sess;
+	SSL *s = ctx->ssl;
+
+	if ((sess = ctx->hs->tls13.psk_session) == NULL)
+		return;
+	ctx->hs->tls13.psk_session = NULL;
+
+	/* Retain the cipher list offered in this ClientHello. */
+	sk_SSL_CIPHER_free(sess->ciphers);
+	sess->ciphers = s->session->ciphers;
+	s->session->ciphers = NULL;
+
+	SSL_SESSION_free(s->session);
+	s->session = sess;
+
+	s->internal->hit = 1;
+	s->verify_result = s->session->verify_result;
+	s->ctx->internal->stats.sess_hit++;
+}
+
 int
 tls13_server_hello_send(struct tls13_ctx *ctx, CBB *cbb)
 {
@@ -490,6 +658,8 @@ tls13_server_hello_send(struct tls13_ctx *ctx, CBB *cbb)
 	if (!tls13_servername_process(ctx))
 		return 0;
 
+	tls13_server_resume_session(ctx);
+
 	ctx->hs->tls13.server_group = 0;
 
 	if (!tls13_server_hello_build(ctx, cbb, 0))
@@ -594,6 +764,12 @@ tls13_server_select_certificate(struct tls13_ctx *ctx, CERT_PKEY **out_cpk,
 	if (cert_ok)
 		goto done;
 
+	cpk = &s->cert->pkeys[SSL_PKEY_ED25519];
+	if (!tls13_server_check_certificate(ctx, cpk, &cert_ok, &sigalg))
+		return 0;
+	if (cert_ok)
+		goto done;
+
 	cpk = &s->cert->pkeys[SSL_PKEY_RSA];
 	if (!tls13_server_check_certificate(ctx, cpk, &cert_ok, &sigalg))
 		return 0;
@@ -729,7 +905,8 @@ tls13_server_certificate_verify_send(struct tls13_ctx *ctx, CBB *cbb)
 
 	if ((mdctx = EVP_MD_CTX_new()) == NULL)
 		goto err;
-	if (!EVP_DigestSignInit(mdctx, &pctx, sigalg->md(), NULL, pkey))
+	if (!EVP_DigestSignInit(mdctx, &pctx,
+	    sigalg->md != NULL ? sigalg->md() : NULL, NULL, pkey))
 		goto err;
 	if (sigalg->flags & SIGALG_FLAG_RSA_PSS) {
 		if (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING))
@@ -737,13 +914,13 @@ tls13_server_certificate_verify_send(struct tls13_ctx *ctx, CBB *cbb)
 		if (!EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1))
 			goto err;
 	}
-	if (!EVP_DigestSignUpdate(mdctx, sig_content, sig_content_len))
-		goto err;
-	if (EVP_DigestSignFinal(mdctx, NULL, &sig_len) <= 0)
+	if (!EVP_DigestSign(mdctx, NULL, &sig_len, sig_content,
+	    sig_content_len))
 		goto err;
 	if ((sig = calloc(1, sig_len)) == NULL)
 		goto err;
-	if (EVP_DigestSignFinal(mdctx, sig, &sig_len) <= 0)
+	if (!EVP_DigestSign(mdctx, sig, &sig_len, sig_content,
+	    sig_content_len))
 		goto err;
 
 	if (!CBB_add_u16(cbb, sigalg->value))
@@ -1001,7 +1178,8 @@ tls13_client_certificate_verify_recv(struct tls13_ctx *ctx, CBS *cbs)
 
 	if ((mdctx = EVP_MD_CTX_new()) == NULL)
 		goto err;
-	if (!EVP_DigestVerifyInit(mdctx, &pctx, sigalg->md(), NULL, pkey))
+	if (!EVP_DigestVerifyInit(mdctx, &pctx,
+	    sigalg->md != NULL ? sigalg->md() : NULL, NULL, pkey))
 		goto err;
 	if (sigalg->flags & SIGALG_FLAG_RSA_PSS) {
 		if (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING))
@@ -1009,12 +1187,8 @@ tls13_client_certificate_verify_recv(struct tls13_ctx *ctx, CBS *cbs)
 		if (!EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1))
 			goto err;
 	}
-	if (!EVP_DigestVerifyUpdate(mdctx, sig_content, sig_content_len)) {
-		ctx->alert = TLS13_ALERT_DECRYPT_ERROR;
-		goto err;
-	}
-	if (EVP_DigestVerifyFinal(mdctx, CBS_data(&signature),
-	    CBS_len(&signature)) <= 0) {
+	if (EVP_DigestVerify(mdctx, CBS_data(&signature), CBS_len(&signature),
+	    sig_content, sig_content_len) <= 0) {
 		ctx->alert = TLS13_ALERT_DECRYPT_ERROR;
 		goto err;
 	}
@@ -1035,6 +1209,150 @@ tls13_client_certificate_verify_recv(struct tls13_ctx *ctx, CBS *cbs)
 int
 tls13_client_end_of_early_data_recv(struct tls13_ctx *ctx, CBS *cbs)
 {
+	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
+
+	if (CBS_len(cbs) != 0) {
+		ctx->alert = TLS13_ALERT_DECODE_ERROR;
+		return 0;
+	}
+
+	tls13_record_layer_allow_early_data(ctx->rl, 0, 0);
+	ctx->hs->tls13.early_data_done = 1;
+
+	return tls13_record_layer_set_read_traffic_key(ctx, ctx->rl,
+	    &secrets->client_handshake_traffic);
+}
+
+static int
+tls13_server_new_session_ticket_build(struct tls13_ctx *ctx, CBB *cbb)
+{
+	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
+	CBB ticket_nonce, ticket;
+	struct tls13_secret psk;
+	SSL *s = ctx->ssl;
+	SSL_SESSION *sess = NULL;
+	uint32_t lifetime, age_add;
+	uint8_t nonce;
+	int ret = 0;
+
+	lifetime = TLS13_MAX_TICKET_LIFETIME;
+	if (s->session->timeout >= 0 && s->session->timeout < lifetime)
+		lifetime = s->session->timeout;
+	arc4random_buf(&age_add, sizeof(age_add));
+	nonce = ctx->ticket_nonce++;
+
+	/*
+	 * The ticket carries a copy of the session with the PSK derived for
+	 * this ticket in place of the master key, leaving the connection's
+	 * session untouched.
+	 */
+	if ((sess = ssl_session_dup(s->session)) == NULL)
+		goto err;
+	psk.data = sess->master_key;
+	psk.len = EVP_MD_size(ctx->hash);
+	if (psk.len > sizeof(sess->master_key))
+		goto err;
+	if (!tls13_derive_ticket_psk(ctx, secrets, &nonce, sizeof(nonce), &psk))
+		goto err;
+	sess->master_key_length = psk.len;
+	sess->tlsext_tick_age_add = age_add;
+	sess->time = time(NULL);
+	sess->timeout = lifetime;
+	sess->max_early_data = s->internal->max_early_data;
+	free(sess->internal->alpn_selected);
+	sess->internal->alpn_selected = NULL;
+	sess->internal->alpn_selected_len = 0;
+	if (S3I(s)->alpn_selected_len > 0) {
+		if ((sess->internal->alpn_selected =
+		    malloc(S3I(s)->alpn_selected_len)) == NULL)
+			goto err;
+		memcpy(sess->internal->alpn_selected, S3I(s)->alpn_selected,
+		    S3I(s)->alpn_selected_len);
+		sess->internal->alpn_selected_len = S3I(s)->alpn_selected_len;
+	}
+
+	if (!CBB_add_u32(cbb, lifetime))
+		goto err;
+	if (!CBB_add_u32(cbb, age_add))
+		goto err;
+	if (!CBB_add_u8_length_prefixed(cbb, &ticket_nonce))
+		goto err;
+	if (!CBB_add_u8(&ticket_nonce, nonce))
+		goto err;
+	if (!CBB_add_u16_length_prefixed(cbb, &ticket))
+		goto err;
+	if (!tls_encrypt_ticket(s, sess, &ticket))
+		goto err;
+	if (!tlsext_server_build(s, SSL_TLSEXT_MSG_NST, cbb))
+		goto err;
+	if (!CBB_flush(cbb))
+		goto err;
+
+	ret = 1;
+
+ err:
+	SSL_SESSION_free(sess);
+
+	return ret;
+}
+
+/*
+ * Send a single NewSessionTicket as a post-handshake message. Each ticket is
+ * sent in its own record - the next is queued once the previous one has been
+ * written (see tls13_phh_done_cb()).
+ */
+ssize_t
+tls13_new_session_ticket_send(struct tls13_ctx *ctx)
+{
+	struct tls13_handshake_msg *hs_msg = NULL;
+	CBB cbb_hs;
+	CBS cbs_hs;
+	ssize_t ret = TLS13_IO_FAILURE;
+
+	if (ctx->mode != TLS13_HS_SERVER || ctx->tickets_pending == 0)
+		return TLS13_IO_FAILURE;
+	ctx->tickets_pending--;
+
+	if ((hs_msg = tls13_handshake_msg_new()) == NULL)
+		goto err;
+	if (!tls13_handshake_msg_start(hs_msg, &cbb_hs,
+	    TLS13_MT_NEW_SESSION_TICKET))
+		goto err;
+	if (!tls13_server_new_session_ticket_build(ctx, &cbb_hs))
+		goto err;
+	if (!tls13_handshake_msg_finish(hs_msg))
+		goto err;
+
+	tls13_handshake_msg_data(hs_msg, &cbs_hs);
+	ret = tls13_record_layer_phh(ctx->rl, &cbs_hs);
+
+ err:
+	tls13_handshake_msg_free(hs_msg);
+
+	return ret;
+}
+
+static int
+tls13_server_new_session_tickets_start(struct tls13_ctx *ctx)
+{
+	SSL *s = ctx->ssl;
+	ssize_t ret;
+
+	if ((SSL_get_options(s) & SSL_OP_NO_TICKET) != 0)
+		return 1;
+	/* Only PSK with (EC)DHE is supported, do not issue useless tickets. */
+	if (!ctx->hs->tls13.psk_dhe_ke)
+		return 1;
+	if ((ctx->tickets_pending = s->internal->num_tickets) == 0)
+		return 1;
+	if (ctx->tickets_pending > UINT8_MAX + 1)
+		ctx->tickets_pending = UINT8_MAX + 1;
+
+	ret = tls13_new_session_ticket_send(ctx);
+	if (ret == TLS13_IO_SUCCESS || ret == TLS13_IO_WANT_POLLOUT ||
+	    ret == TLS13_IO_WANT_RETRY)
+		return 1;
+
 	return 0;
 }
 
@@ -1044,6 +1362,9 @@ tls13_client_finished_recv(struct tls13_ctx *ctx, CBS *cbs)
 	struct tls13_secrets *secrets = ctx->hs->tls13.secrets;
 	struct tls13_secret context = { .data = "", .len = 0 };
 	struct tls13_secret finished_key;
+	struct tls13_secret resumption_context;
+	uint8_t transcript_hash[EVP_MAX_MD_SIZE];
+	size_t transcript_hash_len;
 	uint8_t *verify_data = NULL;
 	size_t verify_data_len;
 	uint8_t key[EVP_MAX_MD_SIZE];
@@ -1101,6 +1422,21 @@ tls13_client_finished_recv(struct tls13_ctx *ctx, CBS *cbs)
 
 	tls13_record_layer_allow_ccs(ctx->rl, 0);
 
+	/*
+	 * The resumption master secret covers the transcript through the
+	 * client finished message, which has already been recorded.
+	 */
+	if (!tls1_transcript_hash_value(ctx->ssl, transcript_hash,
+	    sizeof(transcript_hash), &transcript_hash_len))
+		goto err;
+	resumption_context.data = transcript_hash;
+	resumption_context.len = transcript_hash_len;
+	if (!tls13_derive_resumption_secrets(ctx, secrets, &resumption_context))
+		goto err;
+
+	if (!tls13_server_new_session_tickets_start(ctx))
+		goto err;
+
 	ret = 1;
 
  err:
@@ -161,6 +161,115 @@ aead_from_name(const EVP_AEAD **aead, const char *name)
 	return 1;
 }
 
+/*
+ * Split buf into a zero length region, a single byte, the first half of what
+ * remains and the rest, so that every code path across region boundaries is
+ * exercised.
+ */
+static size_t
+split_iov(EVP_AEAD_IOVEC iov[4], unsigned char *buf, size_t len)
+{
+	size_t first, second;
+
+	first = len > 0 ? 1 : 0;
+	second = (len - first) / 2;
+
+	iov[0].data = buf;
+	iov[0].len = 0;
+	iov[1].data = buf;
+	iov[1].len = first;
+	iov[2].data = buf + first;
+	iov[2].len = second;
+	iov[3].data = buf + first + second;
+	iov[3].len = len - first - second;
+
+	return 4;
+}
+
+static int
+run_test_case_iov(EVP_AEAD_CTX *ctx, unsigned char bufs[NUM_TYPES][BUF_MAX],
+    const unsigned int lengths[NUM_TYPES], unsigned int line_no)
+{
+	unsigned char out[BUF_MAX + EVP_AEAD_MAX_TAG_LENGTH], out2[BUF_MAX];
+	EVP_AEAD_IOVEC in_iov[4], ad_iov[4], out_iov[3], out2_iov[4];
+	size_t in_cnt, ad_cnt, out2_cnt, out_len, out_len2, sealed_len;
+
+	in_cnt = split_iov(in_iov, bufs[IN], lengths[IN]);
+	ad_cnt = split_iov(ad_iov, bufs[AD], lengths[AD]);
+
+	/* Split the output so that the tag straddles two regions. */
+	sealed_len = lengths[CT] + lengths[TAG];
+	out_iov[0].data = out;
+	out_iov[0].len = sealed_len - 3;
+	out_iov[1].data = out + sealed_len - 3;
+	out_iov[1].len = 0;
+	out_iov[2].data = out + sealed_len - 3;
+	out_iov[2].len = sizeof(out) - sealed_len + 3;
+
+	memset(out, 0, sizeof(out));
+	if (!EVP_AEAD_CTX_sealv(ctx, out_iov, 3, &out_len, bufs[NONCE],
+	    lengths[NONCE], in_iov, in_cnt, ad_iov, ad_cnt)) {
+		fprintf(stderr, "Failed to run AEAD sealv on line %u\n",
+		    line_no);
+		return 0;
+	}
+
+	if (out_len != sealed_len) {
+		fprintf(stderr, "Bad sealv output length on line %u: %zu\n",
+		    line_no, out_len);
+		return 0;
+	}
+
+	if (memcmp(out, bufs[CT], lengths[CT]) != 0 ||
+	    memcmp(out + lengths[CT], bufs[TAG], lengths[TAG]) != 0) {
+		fprintf(stderr, "Bad sealv output on line %u\n", line_no);
+		return 0;
+	}
+
+	in_cnt = split_iov(in_iov, out, out_len);
+	out2_cnt = split_iov(out2_iov, out2, sizeof(out2));
+
+	if (!EVP_AEAD_CTX_openv(ctx, out2_iov, out2_cnt, &out_len2,
+	    bufs[NONCE], lengths[NONCE], in_iov, in_cnt, ad_iov, ad_cnt)) {
+		fprintf(stderr, "Failed to openv on line %u\n", line_no);
+		return 0;
+	}
+
+	if (out_len2 != lengths[IN] || memcmp(out2, bufs[IN], out_len2) != 0) {
+		fprintf(stderr, "Plaintext mismatch from openv on line %u\n",
+		    line_no);
+		return 0;
+	}
+
+	/* Decrypt in place, with the output regions aliasing the input. */
+	out2_cnt = split_iov(out2_iov, out, lengths[IN]);
+	if (!EVP_AEAD_CTX_openv(ctx, out2_iov, out2_cnt, &out_len2,
+	    bufs[NONCE], lengths[NONCE], in_iov, in_cnt, ad_iov, ad_cnt)) {
+		fprintf(stderr, "Failed to openv in place on line %u\n",
+		    line_no);
+		return 0;
+	}
+
+	if (out_len2 != lengths[IN] || memcmp(out, bufs[IN], out_len2) != 0) {
+		fprintf(stderr, "Plaintext mismatch from in place openv on "
+		    "line %u\n", line_no);
+		return 0;
+	}
+
+	/* Restore the ciphertext and damage the tag. */
+	memcpy(out, bufs[CT], lengths[CT]);
+	out[sealed_len - 1] ^= 0x80;
+	out2_cnt = split_iov(out2_iov, out2, sizeof(out2));
+	if (EVP_AEAD_CTX_openv(ctx, out2_iov, out2_cnt, &out_len2,
+	    bufs[NONCE], lengths[NONCE], in_iov, in_cnt, ad_iov, ad_cnt)) {
+		fprintf(stderr, "openv decrypted bad data on line %u\n",
+		    line_no);
+		return 0;
+	}
+
+	return 1;
+}
+
 static int
 run_test_case(const EVP_AEAD* aead, unsigned char bufs[NUM_TYPES][BUF_MAX],
     const unsigned int lengths[NUM_TYPES], unsigned int line_no)
@@ -221,6 +330,9 @@ run_test_case(const EVP_AEAD* aead, unsigned char bufs[NUM_TYPES][BUF_MAX],
 		return 0;
 	}
 
+	if (!run_test_case_iov(&ctx, bufs, lengths, line_no))
+		return 0;
+
 	EVP_AEAD_CTX_cleanup(&ctx);
 	return 1;
 }
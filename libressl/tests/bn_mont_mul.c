@@ -0,0 +1,196 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Check Montgomery multiplication and exponentiation against computations
+ * that do not use Montgomery form.  On x86_64 with BMI2 and ADX this runs
+ * the MULX/ADX kernel for moduli of 512 to 8192 bits in steps of 256; the
+ * test script runs it again with -g, which clears both capabilities, so
+ * that the generic bn_mul_mont() gets the same operands.
+ */
+
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+
+void OPENSSL_cpu_caps_clear(uint64_t caps, uint64_t caps_ext);
+
+/* CPUCAP_EXT_MASK_BMI2 and CPUCAP_EXT_MASK_ADX. */
+#define MONT_CAPS_EXT_MULX	((1U << 8) | (1U << 19))
+
+#define MONT_ROUNDS	20
+
+static const int mont_bits[] = {
+	512, 576, 768, 1024, 1280, 2048, 2112, 3072, 4096, 8192,
+};
+
+#define N_MONT_BITS (sizeof(mont_bits) / sizeof(mont_bits[0]))
+
+enum mont_modulus {
+	MONT_RANDOM,
+	MONT_ALL_ONES,		/* 2^n - 1 */
+	MONT_NEAR_TOP,		/* 2^n - 2^64 - 1 */
+	MONT_NEAR_HALF,		/* 2^(n - 1) + 1 */
+	MONT_N_MODULI,
+};
+
+static const char *mont_modulus_names[] = {
+	"random", "2^n - 1", "2^n - 2^64 - 1", "2^(n - 1) + 1",
+};
+
+static void
+mont_modulus(BIGNUM *n, int bits, enum mont_modulus type)
+{
+	switch (type) {
+	case MONT_RANDOM:
+		if (!BN_rand(n, bits, 1, 1))
+			errx(1, "BN_rand");
+		break;
+	case MONT_ALL_ONES:
+	case MONT_NEAR_TOP:
+		BN_zero(n);
+		if (!BN_set_bit(n, bits) || !BN_sub_word(n, 1))
+			errx(1, "failed to set modulus");
+		if (type == MONT_NEAR_TOP && !BN_clear_bit(n, 64))
+			errx(1, "BN_clear_bit");
+		break;
+	case MONT_NEAR_HALF:
+		BN_zero(n);
+		if (!BN_set_bit(n, bits - 1) || !BN_add_word(n, 1))
+			errx(1, "failed to set modulus");
+		break;
+	default:
+		errx(1, "unknown modulus");
+	}
+}
+
+/*
+ * Pick an operand below n that has as many words as n, as the assembly is
+ * only used then: random ones, n - 1, and all words but the top one all
+ * ones.
+ */
+static void
+mont_operand(BIGNUM *a, const BIGNUM *n, int round)
+{
+	int bits = BN_num_bits(n);
+
+	switch (round % 3) {
+	case 0:
+		do {
+			if (!BN_rand_range(a, n))
+				errx(1, "BN_rand_range");
+		} while (BN_num_bytes(a) != BN_num_bytes(n));
+		break;
+	case 1:
+		if (!BN_copy(a, n) || !BN_sub_word(a, 1))
+			errx(1, "BN_sub_word");
+		break;
+	case 2:
+		BN_zero(a);
+		if (!BN_set_bit(a, bits - 64) || !BN_sub_word(a, 1) ||
+		    !BN_set_bit(a, bits - 2))
+			errx(1, "failed to set operand");
+		break;
+	}
+}
+
+static int
+mont_mul_test(int bits, enum mont_modulus type, BN_CTX *ctx)
+{
+	BN_MONT_CTX *mont;
+	BIGNUM *n, *a, *b, *want, *got, *p;
+	const BIGNUM *bb;
+	int i, failed = 0;
+
+	BN_CTX_start(ctx);
+	if ((n = BN_CTX_get(ctx)) == NULL || (a = BN_CTX_get(ctx)) == NULL ||
+	    (b = BN_CTX_get(ctx)) == NULL || (want = BN_CTX_get(ctx)) == NULL ||
+	    (got = BN_CTX_get(ctx)) == NULL || (p = BN_CTX_get(ctx)) == NULL)
+		errx(1, "BN_CTX_get");
+	if ((mont = BN_MONT_CTX_new()) == NULL)
+		errx(1, "BN_MONT_CTX_new");
+
+	mont_modulus(n, bits, type);
+	if (!BN_MONT_CTX_set(mont, n, ctx))
+		errx(1, "BN_MONT_CTX_set");
+
+	for (i = 0; i < MONT_ROUNDS && !failed; i++) {
+		mont_operand(a, n, i);
+		mont_operand(b, n, i / 3);
+		/* Squaring goes through the same kernel. */
+		bb = i % 4 == 3 ? a : b;
+
+		/* The reduction does not use bn_mul_mont(). */
+		if (!BN_mod_mul(want, a, bb, n, ctx) ||
+		    !BN_from_montgomery(want, want, mont, ctx))
+			errx(1, "failed to compute product");
+		if (!BN_mod_mul_montgomery(got, a, bb, mont, ctx))
+			errx(1, "BN_mod_mul_montgomery");
+		if (BN_cmp(want, got) != 0) {
+			fprintf(stderr, "FAIL: %d bits, %s modulus, round %d: "
+			    "product differs\n", bits,
+			    mont_modulus_names[type], i);
+			failed = 1;
+		}
+	}
+
+	/* The fixed window exponentiation is built on the kernel too. */
+	if (!failed && bits <= 2048) {
+		mont_operand(a, n, 0);
+		if (!BN_rand(p, bits, 0, 0))
+			errx(1, "BN_rand");
+		if (!BN_mod_exp_recp(want, a, p, n, ctx))
+			errx(1, "BN_mod_exp_recp");
+		if (!BN_mod_exp_mont_consttime(got, a, p, n, ctx, mont))
+			errx(1, "BN_mod_exp_mont_consttime");
+		if (BN_cmp(want, got) != 0) {
+			fprintf(stderr, "FAIL: %d bits, %s modulus: power "
+			    "differs\n", bits, mont_modulus_names[type]);
+			failed = 1;
+		}
+	}
+
+	BN_MONT_CTX_free(mont);
+	BN_CTX_end(ctx);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	BN_CTX *ctx;
+	size_t i;
+	int type;
+	int failed = 0;
+
+	if (argc == 2 && strcmp(argv[1], "-g") == 0)
+		OPENSSL_cpu_caps_clear(0, MONT_CAPS_EXT_MULX);
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+
+	for (i = 0; i < N_MONT_BITS; i++) {
+		for (type = 0; type < MONT_N_MODULI; type++)
+			failed |= mont_mul_test(mont_bits[i], type, ctx);
+	}
+
+	BN_CTX_free(ctx);
+
+	return (failed);
+}
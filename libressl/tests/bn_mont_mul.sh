@@ -0,0 +1,9 @@
+#!/bin/sh
+set -e
+TEST=./bn_mont_mul
+if [ -e ./bn_mont_mul.exe ]; then
+	TEST=./bn_mont_mul.exe
+fi
+$TEST
+# Again without BMI2 and ADX, so that the generic code is checked as well.
+$TEST -g
@@ -456,6 +456,73 @@ crypto_xchacha_20_test(void)
 	return (failed);
 }
 
+/*
+ * Compare bulk encryption, which may use multi-block implementations, with
+ * encryption in chunks that are too short for them, including lengths that
+ * are not a multiple of the block size and counters that carry into the
+ * second counter word.
+ */
+static int
+crypto_chacha_20_bulk_test(void)
+{
+	static const uint64_t counters[] = {
+		0, 1, 0xfffffff0ULL, 0x1fffffffaULL,
+	};
+	static const size_t lengths[] = {
+		255, 256, 511, 512, 513, 1024, 1088, 1600, 2047, 2048, 4160,
+	};
+	unsigned char key[32], iv[8], ctr[8];
+	unsigned char in[4161], out[4161], want[4161];
+	ChaCha_ctx ctx;
+	size_t i, j, k, len, size;
+	int failed = 0;
+
+	arc4random_buf(key, sizeof(key));
+	arc4random_buf(iv, sizeof(iv));
+	arc4random_buf(in, sizeof(in));
+
+	for (i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+		for (k = 0; k < 8; k++)
+			ctr[k] = counters[i] >> (8 * k);
+
+		for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+			len = lengths[j];
+
+			/* Use unaligned buffers. */
+			CRYPTO_chacha_20(out + 1, in + 1, len, key, iv,
+			    counters[i]);
+
+			ChaCha_set_key(&ctx, key, 256);
+			ChaCha_set_iv(&ctx, iv, ctr);
+			for (k = 0; k < len; k += size) {
+				size = len - k < 63 ? len - k : 63;
+				ChaCha(&ctx, want + 1 + k, in + 1 + k, size);
+			}
+
+			if (memcmp(out + 1, want + 1, len) != 0) {
+				printf("ChaCha bulk failed for length %zu with "
+				    "counter %llx!\n", len,
+				    (unsigned long long)counters[i]);
+				failed = 1;
+			}
+
+			/* The same again, in a single ChaCha() call. */
+			ChaCha_set_key(&ctx, key, 256);
+			ChaCha_set_iv(&ctx, iv, ctr);
+			ChaCha(&ctx, out + 1, in + 1, len);
+
+			if (memcmp(out + 1, want + 1, len) != 0) {
+				printf("ChaCha ctx bulk failed for length %zu "
+				    "with counter %llx!\n", len,
+				    (unsigned long long)counters[i]);
+				failed = 1;
+			}
+		}
+	}
+
+	return (failed);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -505,5 +572,8 @@ main(int argc, char **argv)
 	if (crypto_xchacha_20_test() != 0)
 		failed = 1;
 
+	if (crypto_chacha_20_bulk_test() != 0)
+		failed = 1;
+
 	return failed;
 }
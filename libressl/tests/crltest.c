@@ -0,0 +1,266 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/asn1.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CRL_REVOKED	5000
+#define CRL_REMOVED	77
+
+static X509_REVOKED *
+crl_revoked(long serial, int reason)
+{
+	ASN1_ENUMERATED *code;
+	X509_REVOKED *rev;
+	ASN1_TIME *tm;
+
+	if ((rev = X509_REVOKED_new()) == NULL)
+		errx(1, "X509_REVOKED_new");
+	if (!ASN1_INTEGER_set(rev->serialNumber, serial))
+		errx(1, "ASN1_INTEGER_set");
+	if ((tm = X509_gmtime_adj(NULL, 0)) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (!X509_REVOKED_set_revocationDate(rev, tm))
+		errx(1, "X509_REVOKED_set_revocationDate");
+	ASN1_TIME_free(tm);
+
+	if (reason != CRL_REASON_NONE) {
+		if ((code = ASN1_ENUMERATED_new()) == NULL)
+			errx(1, "ASN1_ENUMERATED_new");
+		if (!ASN1_ENUMERATED_set(code, reason))
+			errx(1, "ASN1_ENUMERATED_set");
+		if (!X509_REVOKED_add1_ext_i2d(rev, NID_crl_reason, code, 0, 0))
+			errx(1, "X509_REVOKED_add1_ext_i2d");
+		ASN1_ENUMERATED_free(code);
+	}
+
+	return rev;
+}
+
+static EVP_PKEY *
+crl_key(void)
+{
+	EVP_PKEY *pkey;
+	EC_KEY *eckey;
+
+	if ((eckey = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) == NULL)
+		errx(1, "EC_KEY_new_by_curve_name");
+	if (!EC_KEY_generate_key(eckey))
+		errx(1, "EC_KEY_generate_key");
+	if ((pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if (!EVP_PKEY_assign_EC_KEY(pkey, eckey))
+		errx(1, "EVP_PKEY_assign_EC_KEY");
+
+	return pkey;
+}
+
+/* Build a CRL revoking the odd serials and decode it again. */
+static X509_CRL *
+crl_decoded(void)
+{
+	X509_CRL *crl, *decoded;
+	X509_NAME *name;
+	EVP_PKEY *pkey;
+	ASN1_TIME *tm;
+	unsigned char *der = NULL;
+	const unsigned char *p;
+	int i, len;
+
+	if ((crl = X509_CRL_new()) == NULL)
+		errx(1, "X509_CRL_new");
+	if ((name = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)"Test CA", -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+	if (!X509_CRL_set_issuer_name(crl, name))
+		errx(1, "X509_CRL_set_issuer_name");
+	X509_NAME_free(name);
+	if ((tm = X509_gmtime_adj(NULL, 0)) == NULL)
+		errx(1, "X509_gmtime_adj");
+	if (!X509_CRL_set_lastUpdate(crl, tm))
+		errx(1, "X509_CRL_set_lastUpdate");
+	ASN1_TIME_free(tm);
+
+	/* Descending, so that the decoded stack is not sorted. */
+	for (i = 2 * CRL_REVOKED - 1; i > 0; i -= 2) {
+		if (!X509_CRL_add0_revoked(crl, crl_revoked(i,
+		    i == CRL_REMOVED ? CRL_REASON_REMOVE_FROM_CRL :
+		    CRL_REASON_NONE)))
+			errx(1, "X509_CRL_add0_revoked");
+	}
+	if (!X509_CRL_add0_revoked(crl, crl_revoked(-1, CRL_REASON_NONE)))
+		errx(1, "X509_CRL_add0_revoked");
+
+	pkey = crl_key();
+	if (!X509_CRL_sign(crl, pkey, EVP_sha256()))
+		errx(1, "X509_CRL_sign");
+	EVP_PKEY_free(pkey);
+
+	if ((len = i2d_X509_CRL(crl, &der)) <= 0)
+		errx(1, "i2d_X509_CRL");
+	p = der;
+	if ((decoded = d2i_X509_CRL(NULL, &p, len)) == NULL)
+		errx(1, "d2i_X509_CRL");
+	free(der);
+	X509_CRL_free(crl);
+
+	return decoded;
+}
+
+static int
+crl_check(X509_CRL *crl, long serial, int want)
+{
+	ASN1_INTEGER *aint;
+	X509_REVOKED *rev = NULL;
+	int got;
+
+	if ((aint = ASN1_INTEGER_new()) == NULL)
+		errx(1, "ASN1_INTEGER_new");
+	if (!ASN1_INTEGER_set(aint, serial))
+		errx(1, "ASN1_INTEGER_set");
+	got = X509_CRL_get0_by_serial(crl, &rev, aint);
+	if (got != want) {
+		fprintf(stderr, "FAIL: serial %ld: got %d, want %d\n",
+		    serial, got, want);
+		ASN1_INTEGER_free(aint);
+		return 1;
+	}
+	if (got != 0 && ASN1_INTEGER_cmp(rev->serialNumber, aint) != 0) {
+		fprintf(stderr, "FAIL: serial %ld: wrong entry\n", serial);
+		ASN1_INTEGER_free(aint);
+		return 1;
+	}
+	ASN1_INTEGER_free(aint);
+
+	return 0;
+}
+
+static int
+crl_lookup_test(void)
+{
+	X509_CRL *crl;
+	long i;
+	int failed = 0;
+
+	crl = crl_decoded();
+
+	for (i = 0; i <= 2 * CRL_REVOKED + 1; i++) {
+		failed |= crl_check(crl, i, (i & 1) == 0 ? 0 :
+		    i == CRL_REMOVED ? 2 : i < 2 * CRL_REVOKED);
+	}
+	failed |= crl_check(crl, -1, 1);
+	failed |= crl_check(crl, -3, 0);
+
+	/* Entries added after decoding must still be found. */
+	if (!X509_CRL_add0_revoked(crl, crl_revoked(2, CRL_REASON_NONE)))
+		errx(1, "X509_CRL_add0_revoked");
+	failed |= crl_check(crl, 2, 1);
+	failed |= crl_check(crl, 3, 1);
+	failed |= crl_check(crl, 4, 0);
+
+	X509_CRL_free(crl);
+
+	return failed;
+}
+
+/*
+ * Changing the revoked entries without changing their number must not
+ * leave lookups with a stale index.
+ */
+static int
+crl_modify_test(void)
+{
+	STACK_OF(X509_REVOKED) *revoked;
+	X509_REVOKED *rev;
+	X509_CRL *crl;
+	long serial;
+	int failed = 0;
+
+	crl = crl_decoded();
+	revoked = X509_CRL_get_REVOKED(crl);
+
+	/* Replace serial 1, the last entry but one, by serial 4. */
+	rev = sk_X509_REVOKED_delete(revoked, sk_X509_REVOKED_num(revoked) - 2);
+	X509_REVOKED_free(rev);
+	if (!X509_CRL_add0_revoked(crl, crl_revoked(4, CRL_REASON_NONE)))
+		errx(1, "X509_CRL_add0_revoked");
+	failed |= crl_check(crl, 1, 0);
+	failed |= crl_check(crl, 4, 1);
+	failed |= crl_check(crl, 3, 1);
+
+	if (!X509_CRL_sort(crl))
+		errx(1, "X509_CRL_sort");
+	failed |= crl_check(crl, 1, 0);
+	failed |= crl_check(crl, 4, 1);
+	failed |= crl_check(crl, 2 * CRL_REVOKED - 1, 1);
+
+	X509_CRL_free(crl);
+
+	/*
+	 * Entries replaced in place, after a lookup built the index, are no
+	 * longer found and their replacements are.
+	 */
+	crl = crl_decoded();
+	failed |= crl_check(crl, 3, 1);
+	revoked = X509_CRL_get_REVOKED(crl);
+	if ((rev = sk_X509_REVOKED_value(revoked, 1)) == NULL)
+		errx(1, "sk_X509_REVOKED_value");
+	serial = ASN1_INTEGER_get(rev->serialNumber);
+	if (sk_X509_REVOKED_set(revoked, 1,
+	    crl_revoked(6, CRL_REASON_NONE)) == NULL)
+		errx(1, "sk_X509_REVOKED_set");
+	X509_REVOKED_free(rev);
+	failed |= crl_check(crl, serial, 0);
+	failed |= crl_check(crl, 6, 1);
+	failed |= crl_check(crl, 2 * CRL_REVOKED - 3, 1);
+
+	/* The same for an entry deleted and another one pushed. */
+	rev = sk_X509_REVOKED_delete(revoked, 2);
+	serial = ASN1_INTEGER_get(rev->serialNumber);
+	X509_REVOKED_free(rev);
+	if (!sk_X509_REVOKED_push(revoked, crl_revoked(8, CRL_REASON_NONE)))
+		errx(1, "sk_X509_REVOKED_push");
+	failed |= crl_check(crl, serial, 0);
+	failed |= crl_check(crl, 8, 1);
+	failed |= crl_check(crl, 6, 1);
+
+	X509_CRL_free(crl);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	ERR_load_crypto_strings();
+
+	failed |= crl_lookup_test();
+	failed |= crl_modify_test();
+
+	return (failed);
+}
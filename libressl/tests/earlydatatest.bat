@@ -0,0 +1,14 @@
+@echo off
+setlocal enabledelayedexpansion
+REM	earlydatatest.bat
+
+set earlydatatest_bin=%1
+set earlydatatest_bin=%earlydatatest_bin:/=\%
+if not exist %earlydatatest_bin% exit /b 1
+
+%earlydatatest_bin% %srcdir%\server.pem %srcdir%\server.pem
+if !errorlevel! neq 0 (
+	exit /b 1
+)
+
+endlocal
@@ -0,0 +1,586 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/ssl.h>
+
+#include <openssl/err.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_EARLY_DATA		16384
+
+char *server_cert_file;
+char *server_key_file;
+
+static SSL_CTX *
+server_ctx_new(void)
+{
+	SSL_CTX *ssl_ctx;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_server_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	if (!SSL_CTX_set_min_proto_version(ssl_ctx, TLS1_3_VERSION))
+		errx(1, "failed to set minimum protocol version");
+	if (SSL_CTX_use_certificate_file(ssl_ctx, server_cert_file,
+	    SSL_FILETYPE_PEM) != 1)
+		errx(1, "failed to load server certificate");
+	if (SSL_CTX_use_PrivateKey_file(ssl_ctx, server_key_file,
+	    SSL_FILETYPE_PEM) != 1)
+		errx(1, "failed to load server private key");
+
+	return ssl_ctx;
+}
+
+static SSL_CTX *
+client_ctx_new(void)
+{
+	SSL_CTX *ssl_ctx;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_client_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	if (!SSL_CTX_set_min_proto_version(ssl_ctx, TLS1_3_VERSION))
+		errx(1, "failed to set minimum protocol version");
+
+	return ssl_ctx;
+}
+
+static int
+ssl_want_io(SSL *ssl, int ret)
+{
+	int ssl_err;
+
+	ssl_err = SSL_get_error(ssl, ret);
+
+	return (ssl_err == SSL_ERROR_WANT_READ ||
+	    ssl_err == SSL_ERROR_WANT_WRITE);
+}
+
+static int
+do_handshake(SSL *client, SSL *server)
+{
+	int client_done = 0, server_done = 0;
+	int i, ret;
+
+	for (i = 0; i < 100 && (!client_done || !server_done); i++) {
+		if (!client_done) {
+			if ((ret = SSL_do_handshake(client)) == 1)
+				client_done = 1;
+			else if (!ssl_want_io(client, ret))
+				return 0;
+		}
+		if (!server_done) {
+			if ((ret = SSL_do_handshake(server)) == 1)
+				server_done = 1;
+			else if (!ssl_want_io(server, ret))
+				return 0;
+		}
+	}
+
+	return (client_done && server_done);
+}
+
+static int
+read_data(SSL *client, SSL *server, const char *msg, size_t msg_len)
+{
+	char buf[64];
+	int i, ret;
+
+	if (SSL_write(server, msg, msg_len) != (int)msg_len)
+		return 0;
+
+	for (i = 0; i < 100; i++) {
+		if ((ret = SSL_read(client, buf, sizeof(buf))) > 0)
+			break;
+		if (!ssl_want_io(client, ret))
+			return 0;
+	}
+	if (ret != (int)msg_len || memcmp(buf, msg, msg_len) != 0)
+		return 0;
+
+	return 1;
+}
+
+static int
+ssl_pair_new(SSL_CTX *client_ctx, SSL_CTX *server_ctx, SSL **client,
+    SSL **server)
+{
+	BIO *client_bio, *server_bio;
+
+	*client = NULL;
+	*server = NULL;
+
+	if ((*client = SSL_new(client_ctx)) == NULL)
+		return 0;
+	if ((*server = SSL_new(server_ctx)) == NULL)
+		return 0;
+	if (!BIO_new_bio_pair(&client_bio, 0, &server_bio, 0))
+		return 0;
+
+	SSL_set_bio(*client, client_bio, client_bio);
+	SSL_set_bio(*server, server_bio, server_bio);
+
+	SSL_set_connect_state(*client);
+	SSL_set_accept_state(*server);
+
+	return 1;
+}
+
+/*
+ * Perform a full handshake and return the session from the ticket that the
+ * server issued.
+ */
+static SSL_SESSION *
+ticket_session(SSL_CTX *client_ctx, SSL_CTX *server_ctx)
+{
+	SSL *client = NULL, *server = NULL;
+	SSL_SESSION *sess = NULL;
+
+	if (!ssl_pair_new(client_ctx, server_ctx, &client, &server))
+		goto failure;
+	if (!do_handshake(client, server))
+		goto failure;
+	if (!read_data(client, server, "ticket", sizeof("ticket")))
+		goto failure;
+
+	sess = SSL_get1_session(client);
+
+ failure:
+	SSL_free(client);
+	SSL_free(server);
+
+	return sess;
+}
+
+/*
+ * Read early data on the server until the client's early data ends, driving
+ * the client handshake whenever the server needs more input.
+ */
+static int
+server_read_early_data(SSL *client, SSL *server, char *buf, size_t buf_len,
+    size_t *out_len)
+{
+	size_t off = 0, n;
+	int i, ret;
+
+	for (i = 0; i < 100; i++) {
+		ret = SSL_read_early_data(server, &buf[off], buf_len - off, &n);
+		if (ret == SSL_READ_EARLY_DATA_FINISH) {
+			*out_len = off;
+			return 1;
+		}
+		if (ret == SSL_READ_EARLY_DATA_SUCCESS) {
+			off += n;
+			continue;
+		}
+		if (!ssl_want_io(server, -1))
+			return 0;
+		if ((ret = SSL_do_handshake(client)) != 1 &&
+		    !ssl_want_io(client, ret))
+			return 0;
+	}
+
+	return 0;
+}
+
+static int
+early_data_test(void)
+{
+	SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+	SSL *client = NULL, *server = NULL;
+	SSL_SESSION *sess = NULL;
+	const char msg[] = "early data test";
+	char buf[64];
+	size_t len;
+	int failed = 1;
+
+	client_ctx = client_ctx_new();
+	server_ctx = server_ctx_new();
+
+	SSL_CTX_set_max_early_data(server_ctx, MAX_EARLY_DATA);
+
+	if ((sess = ticket_session(client_ctx, server_ctx)) == NULL) {
+		fprintf(stderr, "FAIL: failed to obtain session ticket\n");
+		goto failure;
+	}
+	if (SSL_SESSION_get_max_early_data(sess) != MAX_EARLY_DATA) {
+		fprintf(stderr, "FAIL: got max early data %u, want %u\n",
+		    SSL_SESSION_get_max_early_data(sess), MAX_EARLY_DATA);
+		goto failure;
+	}
+
+	if (!ssl_pair_new(client_ctx, server_ctx, &client, &server))
+		goto failure;
+	if (!SSL_set_session(client, sess))
+		goto failure;
+
+	if (SSL_write_early_data(client, msg, sizeof(msg), &len) != 1 ||
+	    len != sizeof(msg)) {
+		fprintf(stderr, "FAIL: failed to write early data\n");
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (!server_read_early_data(client, server, buf, sizeof(buf), &len)) {
+		fprintf(stderr, "FAIL: failed to read early data\n");
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (len != sizeof(msg) || memcmp(buf, msg, sizeof(msg)) != 0) {
+		fprintf(stderr, "FAIL: early data mismatch\n");
+		goto failure;
+	}
+	if (!do_handshake(client, server)) {
+		fprintf(stderr, "FAIL: handshake with early data failed\n");
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (!SSL_session_reused(client) || !SSL_session_reused(server)) {
+		fprintf(stderr, "FAIL: session was not resumed\n");
+		goto failure;
+	}
+	if (SSL_get_early_data_status(client) != SSL_EARLY_DATA_ACCEPTED ||
+	    SSL_get_early_data_status(server) != SSL_EARLY_DATA_ACCEPTED) {
+		fprintf(stderr, "FAIL: early data was not accepted\n");
+		goto failure;
+	}
+	if (!read_data(client, server, msg, sizeof(msg))) {
+		fprintf(stderr, "FAIL: failed to exchange data\n");
+		goto failure;
+	}
+
+	SSL_free(client);
+	SSL_free(server);
+
+	/* A server that does not read early data must skip over it. */
+	if (!ssl_pair_new(client_ctx, server_ctx, &client, &server))
+		goto failure;
+	if (!SSL_set_session(client, sess))
+		goto failure;
+
+	if (SSL_write_early_data(client, msg, sizeof(msg), &len) != 1) {
+		fprintf(stderr, "FAIL: failed to write early data\n");
+		goto failure;
+	}
+	if (!do_handshake(client, server)) {
+		fprintf(stderr, "FAIL: handshake with skipped early data "
+		    "failed\n");
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (SSL_get_early_data_status(client) != SSL_EARLY_DATA_REJECTED ||
+	    SSL_get_early_data_status(server) != SSL_EARLY_DATA_REJECTED) {
+		fprintf(stderr, "FAIL: skipped early data was not rejected\n");
+		goto failure;
+	}
+	if (!read_data(client, server, msg, sizeof(msg))) {
+		fprintf(stderr, "FAIL: failed to exchange data\n");
+		goto failure;
+	}
+
+	SSL_free(client);
+	SSL_free(server);
+	client = NULL;
+	server = NULL;
+
+	/* Tickets issued without early data permission cannot send any. */
+	SSL_SESSION_free(sess);
+	SSL_CTX_set_max_early_data(server_ctx, 0);
+	if ((sess = ticket_session(client_ctx, server_ctx)) == NULL) {
+		fprintf(stderr, "FAIL: failed to obtain session ticket\n");
+		goto failure;
+	}
+	if (SSL_SESSION_get_max_early_data(sess) != 0) {
+		fprintf(stderr, "FAIL: ticket permits early data\n");
+		goto failure;
+	}
+	if (!ssl_pair_new(client_ctx, server_ctx, &client, &server))
+		goto failure;
+	if (!SSL_set_session(client, sess))
+		goto failure;
+	if (SSL_write_early_data(client, msg, sizeof(msg), &len) == 1) {
+		fprintf(stderr, "FAIL: wrote early data without permission\n");
+		goto failure;
+	}
+	ERR_clear_error();
+
+	failed = 0;
+
+ failure:
+	SSL_SESSION_free(sess);
+	SSL_free(client);
+	SSL_free(server);
+	SSL_CTX_free(client_ctx);
+	SSL_CTX_free(server_ctx);
+
+	return failed;
+}
+
+/*
+ * Replay the same client flight to two servers that share an SSL_CTX - only
+ * the first may accept the early data.
+ */
+static int
+early_data_replay_test(void)
+{
+	SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+	SSL *client = NULL, *server = NULL;
+	SSL_SESSION *sess = NULL;
+	BIO *rbio, *wbio;
+	const char msg[] = "replayed early data";
+	char buf[64], *flight;
+	long flight_len;
+	size_t len;
+	int ret, i;
+	int failed = 1;
+
+	client_ctx = client_ctx_new();
+	server_ctx = server_ctx_new();
+
+	SSL_CTX_set_max_early_data(server_ctx, MAX_EARLY_DATA);
+
+	if ((sess = ticket_session(client_ctx, server_ctx)) == NULL) {
+		fprintf(stderr, "FAIL: failed to obtain session ticket\n");
+		goto failure;
+	}
+
+	if ((client = SSL_new(client_ctx)) == NULL)
+		goto failure;
+	if ((rbio = BIO_new(BIO_s_mem())) == NULL)
+		goto failure;
+	if ((wbio = BIO_new(BIO_s_mem())) == NULL) {
+		BIO_free(rbio);
+		goto failure;
+	}
+	SSL_set_bio(client, rbio, wbio);
+	SSL_set_connect_state(client);
+	if (!SSL_set_session(client, sess))
+		goto failure;
+
+	if (SSL_write_early_data(client, msg, sizeof(msg), &len) != 1) {
+		fprintf(stderr, "FAIL: failed to write early data\n");
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if ((flight_len = BIO_get_mem_data(wbio, &flight)) <= 0)
+		goto failure;
+
+	for (i = 0; i < 2; i++) {
+		if ((server = SSL_new(server_ctx)) == NULL)
+			goto failure;
+		if ((rbio = BIO_new(BIO_s_mem())) == NULL)
+			goto failure;
+		if ((wbio = BIO_new(BIO_s_mem())) == NULL) {
+			BIO_free(rbio);
+			goto failure;
+		}
+		SSL_set_bio(server, rbio, wbio);
+		SSL_set_accept_state(server);
+
+		if (BIO_write(rbio, flight, flight_len) != flight_len)
+			goto failure;
+
+		ret = SSL_read_early_data(server, buf, sizeof(buf), &len);
+		if (i == 0) {
+			if (ret != SSL_READ_EARLY_DATA_SUCCESS ||
+			    len != sizeof(msg) ||
+			    memcmp(buf, msg, sizeof(msg)) != 0) {
+				fprintf(stderr, "FAIL: early data was not "
+				    "read\n");
+				ERR_print_errors_fp(stderr);
+				goto failure;
+			}
+			if (SSL_get_early_data_status(server) !=
+			    SSL_EARLY_DATA_ACCEPTED) {
+				fprintf(stderr, "FAIL: early data was not "
+				    "accepted\n");
+				goto failure;
+			}
+		} else {
+			if (ret != SSL_READ_EARLY_DATA_FINISH) {
+				fprintf(stderr, "FAIL: replayed early data "
+				    "was read\n");
+				ERR_print_errors_fp(stderr);
+				goto failure;
+			}
+			if (SSL_get_early_data_status(server) !=
+			    SSL_EARLY_DATA_REJECTED) {
+				fprintf(stderr, "FAIL: replayed early data "
+				    "was not rejected\n");
+				goto failure;
+			}
+		}
+
+		SSL_free(server);
+		server = NULL;
+	}
+
+	failed = 0;
+
+ failure:
+	SSL_SESSION_free(sess);
+	SSL_free(client);
+	SSL_free(server);
+	SSL_CTX_free(client_ctx);
+	SSL_CTX_free(server_ctx);
+
+	return failed;
+}
+
+/* Select the first protocol that the client offers. */
+static int
+alpn_select_cb(SSL *ssl, const unsigned char **out, unsigned char *outlen,
+    const unsigned char *in, unsigned int inlen, void *arg)
+{
+	if (inlen < 1 || in[0] == 0 || in[0] > inlen - 1)
+		return SSL_TLSEXT_ERR_NOACK;
+
+	*out = &in[1];
+	*outlen = in[0];
+
+	return SSL_TLSEXT_ERR_OK;
+}
+
+/*
+ * Resume sess offering the given ALPN protocols, with the server reading
+ * early data, and return the early data status on the server.
+ */
+static int
+early_data_alpn_status(SSL_CTX *client_ctx, SSL_CTX *server_ctx,
+    SSL_SESSION *sess, const unsigned char *protos, unsigned int protos_len)
+{
+	SSL *client = NULL, *server = NULL;
+	const char msg[] = "early data alpn test";
+	char buf[64];
+	size_t len;
+	int status = -1;
+
+	if (!ssl_pair_new(client_ctx, server_ctx, &client, &server))
+		goto failure;
+	if (!SSL_set_session(client, sess))
+		goto failure;
+	if (protos_len > 0 && SSL_set_alpn_protos(client, protos,
+	    protos_len) != 0)
+		goto failure;
+
+	if (SSL_write_early_data(client, msg, sizeof(msg), &len) != 1)
+		goto failure;
+	if (!server_read_early_data(client, server, buf, sizeof(buf), &len))
+		goto failure;
+	if (!do_handshake(client, server))
+		goto failure;
+	if (SSL_get_early_data_status(client) !=
+	    SSL_get_early_data_status(server))
+		goto failure;
+	if (!read_data(client, server, msg, sizeof(msg)))
+		goto failure;
+
+	status = SSL_get_early_data_status(server);
+
+ failure:
+	ERR_print_errors_fp(stderr);
+	SSL_free(client);
+	SSL_free(server);
+
+	return status;
+}
+
+/*
+ * Early data is only accepted if the ALPN protocol selected for the
+ * connection is the one selected for the original session.
+ */
+static int
+early_data_alpn_test(void)
+{
+	SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+	SSL_SESSION *sess = NULL;
+	static const unsigned char h2[] = "\x02h2";
+	static const unsigned char http11[] = "\x08http/1.1";
+	int status;
+	int failed = 1;
+
+	client_ctx = client_ctx_new();
+	server_ctx = server_ctx_new();
+
+	SSL_CTX_set_max_early_data(server_ctx, MAX_EARLY_DATA);
+	SSL_CTX_set_alpn_select_cb(server_ctx, alpn_select_cb, NULL);
+	if (SSL_CTX_set_alpn_protos(client_ctx, h2, sizeof(h2) - 1) != 0)
+		errx(1, "failed to set ALPN protocols");
+
+	if ((sess = ticket_session(client_ctx, server_ctx)) == NULL) {
+		fprintf(stderr, "FAIL: failed to obtain session ticket\n");
+		goto failure;
+	}
+
+	if ((status = early_data_alpn_status(client_ctx, server_ctx, sess,
+	    NULL, 0)) != SSL_EARLY_DATA_ACCEPTED) {
+		fprintf(stderr, "FAIL: same ALPN protocol, got early data "
+		    "status %d\n", status);
+		goto failure;
+	}
+	if ((status = early_data_alpn_status(client_ctx, server_ctx, sess,
+	    http11, sizeof(http11) - 1)) != SSL_EARLY_DATA_REJECTED) {
+		fprintf(stderr, "FAIL: different ALPN protocol, got early "
+		    "data status %d\n", status);
+		goto failure;
+	}
+
+	/* A session without ALPN does not match a connection with it. */
+	SSL_SESSION_free(sess);
+	SSL_CTX_free(client_ctx);
+	client_ctx = client_ctx_new();
+	if ((sess = ticket_session(client_ctx, server_ctx)) == NULL) {
+		fprintf(stderr, "FAIL: failed to obtain session ticket\n");
+		goto failure;
+	}
+	if ((status = early_data_alpn_status(client_ctx, server_ctx, sess,
+	    h2, sizeof(h2) - 1)) != SSL_EARLY_DATA_REJECTED) {
+		fprintf(stderr, "FAIL: ALPN protocol not in session, got "
+		    "early data status %d\n", status);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	SSL_SESSION_free(sess);
+	SSL_CTX_free(client_ctx);
+	SSL_CTX_free(server_ctx);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s keyfile certfile\n", argv[0]);
+		exit(1);
+	}
+
+	server_key_file = argv[1];
+	server_cert_file = argv[2];
+
+	SSL_library_init();
+	SSL_load_error_strings();
+
+	failed |= early_data_test();
+	failed |= early_data_replay_test();
+	failed |= early_data_alpn_test();
+
+	return (failed);
+}
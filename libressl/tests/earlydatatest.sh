@@ -0,0 +1,13 @@
+#!/bin/sh
+set -e
+
+earlydatatest_bin=./earlydatatest
+if [ -e ./earlydatatest.exe ]; then
+	earlydatatest_bin=./earlydatatest.exe
+fi
+
+if [ -z $srcdir ]; then
+	srcdir=.
+fi
+
+$earlydatatest_bin $srcdir/server.pem $srcdir/server.pem
@@ -0,0 +1,197 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/objects.h>
+
+#include <err.h>
+#include <stdio.h>
+
+#define COMB_ROUNDS	100
+
+/*
+ * Named P-384 and P-521 groups multiply the generator with a precomputed
+ * comb, while a group built from the same parameters without a curve name
+ * uses the Montgomery ladder - both must agree.
+ */
+struct comb_groups {
+	const char *name;
+	EC_GROUP *named;
+	EC_GROUP *ladder;
+	BIGNUM *order;
+	BN_CTX *ctx;
+};
+
+static void
+comb_groups_init(struct comb_groups *cg, int nid)
+{
+	BIGNUM *p, *a, *b;
+
+	cg->name = OBJ_nid2sn(nid);
+	if ((cg->ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	if ((cg->named = EC_GROUP_new_by_curve_name(nid)) == NULL)
+		errx(1, "EC_GROUP_new_by_curve_name");
+
+	if ((p = BN_new()) == NULL || (a = BN_new()) == NULL ||
+	    (b = BN_new()) == NULL || (cg->order = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_curve_GFp(cg->named, p, a, b, cg->ctx))
+		errx(1, "EC_GROUP_get_curve_GFp");
+	if (!EC_GROUP_get_order(cg->named, cg->order, cg->ctx))
+		errx(1, "EC_GROUP_get_order");
+	if ((cg->ladder = EC_GROUP_new_curve_GFp(p, a, b, cg->ctx)) == NULL)
+		errx(1, "EC_GROUP_new_curve_GFp");
+	if (!EC_GROUP_set_generator(cg->ladder,
+	    EC_GROUP_get0_generator(cg->named), cg->order, BN_value_one()))
+		errx(1, "EC_GROUP_set_generator");
+	if (EC_GROUP_get_curve_name(cg->ladder) != NID_undef)
+		errx(1, "unexpected curve name");
+
+	BN_free(p);
+	BN_free(a);
+	BN_free(b);
+}
+
+static void
+comb_groups_cleanup(struct comb_groups *cg)
+{
+	EC_GROUP_free(cg->named);
+	EC_GROUP_free(cg->ladder);
+	BN_free(cg->order);
+	BN_CTX_free(cg->ctx);
+}
+
+/* Compute scalar * G in both groups and compare the results. */
+static int
+comb_mul_test(struct comb_groups *cg, const char *name, const BIGNUM *scalar)
+{
+	EC_POINT *r, *r_ladder;
+	int failed = 1;
+
+	if ((r = EC_POINT_new(cg->named)) == NULL ||
+	    (r_ladder = EC_POINT_new(cg->ladder)) == NULL)
+		errx(1, "EC_POINT_new");
+
+	if (!EC_POINT_mul(cg->named, r, scalar, NULL, NULL, cg->ctx)) {
+		fprintf(stderr, "FAIL: %s %s: EC_POINT_mul failed\n",
+		    cg->name, name);
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (!EC_POINT_mul(cg->ladder, r_ladder, scalar, NULL, NULL,
+	    cg->ctx)) {
+		fprintf(stderr, "FAIL: %s %s: EC_POINT_mul (ladder) failed\n",
+		    cg->name, name);
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (!EC_POINT_is_on_curve(cg->named, r, cg->ctx) ||
+	    EC_POINT_cmp(cg->named, r, r_ladder, cg->ctx) != 0) {
+		fprintf(stderr, "FAIL: %s %s: results differ\n", cg->name,
+		    name);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	EC_POINT_free(r);
+	EC_POINT_free(r_ladder);
+
+	return failed;
+}
+
+static int
+comb_random_test(struct comb_groups *cg)
+{
+	BIGNUM *k;
+	int failed = 0;
+	int i;
+
+	if ((k = BN_new()) == NULL)
+		errx(1, "BN_new");
+
+	for (i = 0; i < COMB_ROUNDS && !failed; i++) {
+		if (!BN_rand_range(k, cg->order))
+			errx(1, "BN_rand_range");
+		failed |= comb_mul_test(cg, "random", k);
+	}
+
+	BN_free(k);
+
+	return failed;
+}
+
+static int
+comb_edge_test(struct comb_groups *cg)
+{
+	const char *edge_names[] = {
+		"0", "1", "2", "3", "n - 2", "n - 1", "n", "n + 1", "-1",
+		"2^bits - 1",
+	};
+	BIGNUM *edge[10];
+	int bits, failed = 0;
+	size_t i;
+
+	for (i = 0; i < 10; i++) {
+		if ((edge[i] = BN_new()) == NULL)
+			errx(1, "BN_new");
+	}
+	bits = BN_num_bits(cg->order);
+	BN_zero(edge[0]);
+	if (!BN_set_word(edge[1], 1) ||
+	    !BN_set_word(edge[2], 2) ||
+	    !BN_set_word(edge[3], 3) ||
+	    !BN_sub(edge[4], cg->order, edge[2]) ||
+	    !BN_sub(edge[5], cg->order, edge[1]) ||
+	    !BN_copy(edge[6], cg->order) ||
+	    !BN_add(edge[7], cg->order, edge[1]) ||
+	    !BN_set_word(edge[8], 1) ||
+	    !BN_set_bit(edge[9], bits) ||
+	    !BN_sub_word(edge[9], 1))
+		errx(1, "failed to set up edge scalars");
+	BN_set_negative(edge[8], 1);
+
+	for (i = 0; i < 10; i++)
+		failed |= comb_mul_test(cg, edge_names[i], edge[i]);
+
+	for (i = 0; i < 10; i++)
+		BN_free(edge[i]);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	const int nids[] = { NID_secp384r1, NID_secp521r1 };
+	struct comb_groups cg;
+	int failed = 0;
+	size_t i;
+
+	ERR_load_crypto_strings();
+
+	for (i = 0; i < sizeof(nids) / sizeof(nids[0]); i++) {
+		comb_groups_init(&cg, nids[i]);
+		failed |= comb_random_test(&cg);
+		failed |= comb_edge_test(&cg);
+		comb_groups_cleanup(&cg);
+	}
+
+	return (failed);
+}
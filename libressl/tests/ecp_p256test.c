@@ -0,0 +1,319 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/objects.h>
+
+#include <err.h>
+#include <stdio.h>
+
+#define P256_ROUNDS	200
+
+/*
+ * The named P-256 group uses the fixed width P-256 method, while a group
+ * built from the same parameters with EC_GROUP_new_curve_GFp() uses the
+ * generic Montgomery method - every scalar multiplication must agree.
+ */
+struct p256_groups {
+	EC_GROUP *p256;
+	EC_GROUP *mont;
+	BIGNUM *order;
+	BN_CTX *ctx;
+};
+
+static void
+p256_groups_init(struct p256_groups *pg)
+{
+	BIGNUM *p, *a, *b, *x, *y;
+	EC_POINT *g;
+
+	if ((pg->ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	if ((pg->p256 = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1)) ==
+	    NULL)
+		errx(1, "EC_GROUP_new_by_curve_name");
+
+	if ((p = BN_new()) == NULL || (a = BN_new()) == NULL ||
+	    (b = BN_new()) == NULL || (x = BN_new()) == NULL ||
+	    (y = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_curve_GFp(pg->p256, p, a, b, pg->ctx))
+		errx(1, "EC_GROUP_get_curve_GFp");
+	if ((pg->mont = EC_GROUP_new_curve_GFp(p, a, b, pg->ctx)) == NULL)
+		errx(1, "EC_GROUP_new_curve_GFp");
+	if (EC_METHOD_get_field_type(EC_GROUP_method_of(pg->mont)) !=
+	    NID_X9_62_prime_field)
+		errx(1, "unexpected field type");
+
+	if (!EC_POINT_get_affine_coordinates_GFp(pg->p256,
+	    EC_GROUP_get0_generator(pg->p256), x, y, pg->ctx))
+		errx(1, "EC_POINT_get_affine_coordinates_GFp");
+	if ((g = EC_POINT_new(pg->mont)) == NULL)
+		errx(1, "EC_POINT_new");
+	if (!EC_POINT_set_affine_coordinates_GFp(pg->mont, g, x, y, pg->ctx))
+		errx(1, "EC_POINT_set_affine_coordinates_GFp");
+	if ((pg->order = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_order(pg->p256, pg->order, pg->ctx))
+		errx(1, "EC_GROUP_get_order");
+	if (!EC_GROUP_set_generator(pg->mont, g, pg->order, BN_value_one()))
+		errx(1, "EC_GROUP_set_generator");
+
+	if (EC_GROUP_method_of(pg->p256) == EC_GROUP_method_of(pg->mont))
+		errx(1, "P-256 group uses the Montgomery method");
+
+	EC_POINT_free(g);
+	BN_free(p);
+	BN_free(a);
+	BN_free(b);
+	BN_free(x);
+	BN_free(y);
+}
+
+static void
+p256_groups_cleanup(struct p256_groups *pg)
+{
+	EC_GROUP_free(pg->p256);
+	EC_GROUP_free(pg->mont);
+	BN_free(pg->order);
+	BN_CTX_free(pg->ctx);
+}
+
+/* Copy a point from the P-256 group to the Montgomery group. */
+static EC_POINT *
+p256_point_to_mont(struct p256_groups *pg, const EC_POINT *point)
+{
+	EC_POINT *r;
+	BIGNUM *x, *y;
+
+	if ((r = EC_POINT_new(pg->mont)) == NULL)
+		errx(1, "EC_POINT_new");
+	if (EC_POINT_is_at_infinity(pg->p256, point)) {
+		if (!EC_POINT_set_to_infinity(pg->mont, r))
+			errx(1, "EC_POINT_set_to_infinity");
+		return r;
+	}
+
+	if ((x = BN_new()) == NULL || (y = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_POINT_get_affine_coordinates_GFp(pg->p256, point, x, y,
+	    pg->ctx))
+		errx(1, "EC_POINT_get_affine_coordinates_GFp");
+	if (!EC_POINT_set_affine_coordinates_GFp(pg->mont, r, x, y, pg->ctx))
+		errx(1, "EC_POINT_set_affine_coordinates_GFp");
+	BN_free(x);
+	BN_free(y);
+
+	return r;
+}
+
+static int
+p256_points_equal(struct p256_groups *pg, const EC_POINT *a,
+    const EC_POINT *b)
+{
+	EC_POINT *t;
+	int ret;
+
+	if (!EC_POINT_is_on_curve(pg->p256, a, pg->ctx))
+		return 0;
+
+	t = p256_point_to_mont(pg, a);
+	ret = EC_POINT_cmp(pg->mont, t, b, pg->ctx) == 0;
+	EC_POINT_free(t);
+
+	return ret;
+}
+
+/*
+ * Compute g_scalar * G + p_scalar * P in both groups, where either scalar
+ * may be NULL, and compare the results.
+ */
+static int
+p256_mul_test(struct p256_groups *pg, const char *name, const BIGNUM *g_scalar,
+    const EC_POINT *point, const BIGNUM *p_scalar)
+{
+	EC_POINT *r = NULL, *r_mont = NULL, *point_mont = NULL;
+	int failed = 1;
+
+	if ((r = EC_POINT_new(pg->p256)) == NULL ||
+	    (r_mont = EC_POINT_new(pg->mont)) == NULL)
+		errx(1, "EC_POINT_new");
+	if (point != NULL)
+		point_mont = p256_point_to_mont(pg, point);
+
+	if (!EC_POINT_mul(pg->p256, r, g_scalar, point, p_scalar, pg->ctx)) {
+		fprintf(stderr, "FAIL: %s: EC_POINT_mul failed\n", name);
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (!EC_POINT_mul(pg->mont, r_mont, g_scalar, point_mont, p_scalar,
+	    pg->ctx)) {
+		fprintf(stderr, "FAIL: %s: EC_POINT_mul (Montgomery) failed\n",
+		    name);
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (!p256_points_equal(pg, r, r_mont)) {
+		fprintf(stderr, "FAIL: %s: results differ\n", name);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	EC_POINT_free(r);
+	EC_POINT_free(r_mont);
+	EC_POINT_free(point_mont);
+
+	return failed;
+}
+
+static int
+p256_random_test(struct p256_groups *pg)
+{
+	BIGNUM *k1, *k2, *k3;
+	EC_POINT *point;
+	int failed = 0;
+	int i;
+
+	if ((k1 = BN_new()) == NULL || (k2 = BN_new()) == NULL ||
+	    (k3 = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if ((point = EC_POINT_new(pg->p256)) == NULL)
+		errx(1, "EC_POINT_new");
+
+	for (i = 0; i < P256_ROUNDS && !failed; i++) {
+		if (!BN_rand_range(k1, pg->order) ||
+		    !BN_rand_range(k2, pg->order) ||
+		    !BN_rand_range(k3, pg->order))
+			errx(1, "BN_rand_range");
+		if (!EC_POINT_mul(pg->p256, point, k3, NULL, NULL, pg->ctx))
+			errx(1, "EC_POINT_mul");
+		/* Every other point is in Jacobian coordinates with Z != 1. */
+		if ((i & 1) && !EC_POINT_dbl(pg->p256, point, point, pg->ctx))
+			errx(1, "EC_POINT_dbl");
+
+		failed |= p256_mul_test(pg, "random generator", k1, NULL,
+		    NULL);
+		failed |= p256_mul_test(pg, "random point", NULL, point, k2);
+		failed |= p256_mul_test(pg, "random double", k1, point, k2);
+	}
+
+	EC_POINT_free(point);
+	BN_free(k1);
+	BN_free(k2);
+	BN_free(k3);
+
+	return failed;
+}
+
+static int
+p256_edge_test(struct p256_groups *pg)
+{
+	const char *edge_names[] = {
+		"0", "1", "2", "n - 1", "n", "n + 1", "-1", "2^256 - 1",
+		"2^256 + 5", "n + 30",
+	};
+	BIGNUM *edge[10], *k;
+	EC_POINT *point, *inf;
+	int failed = 0;
+	size_t i;
+
+	for (i = 0; i < 10; i++) {
+		if ((edge[i] = BN_new()) == NULL)
+			errx(1, "BN_new");
+	}
+	/*
+	 * Without reduction, the last window of n + 30 would add 15 * P to
+	 * (n + 15) * P, which is the same point.
+	 */
+	BN_zero(edge[0]);
+	if (!BN_set_word(edge[1], 1) ||
+	    !BN_set_word(edge[2], 2) ||
+	    !BN_sub(edge[3], pg->order, BN_value_one()) ||
+	    !BN_copy(edge[4], pg->order) ||
+	    !BN_add(edge[5], pg->order, BN_value_one()) ||
+	    !BN_set_word(edge[6], 1) ||
+	    !BN_set_bit(edge[7], 256) ||
+	    !BN_sub_word(edge[7], 1) ||
+	    !BN_set_bit(edge[8], 256) ||
+	    !BN_add_word(edge[8], 5) ||
+	    !BN_copy(edge[9], pg->order) ||
+	    !BN_add_word(edge[9], 30))
+		errx(1, "failed to set up edge scalars");
+	BN_set_negative(edge[6], 1);
+
+	if ((k = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if ((point = EC_POINT_new(pg->p256)) == NULL ||
+	    (inf = EC_POINT_new(pg->p256)) == NULL)
+		errx(1, "EC_POINT_new");
+	if (!BN_rand_range(k, pg->order))
+		errx(1, "BN_rand_range");
+	if (!EC_POINT_mul(pg->p256, point, k, NULL, NULL, pg->ctx))
+		errx(1, "EC_POINT_mul");
+	if (!EC_POINT_set_to_infinity(pg->p256, inf))
+		errx(1, "EC_POINT_set_to_infinity");
+
+	for (i = 0; i < 10; i++) {
+		if (p256_mul_test(pg, edge_names[i], edge[i], NULL, NULL) ||
+		    p256_mul_test(pg, edge_names[i], NULL, point, edge[i]) ||
+		    p256_mul_test(pg, edge_names[i], edge[i], point, k) ||
+		    p256_mul_test(pg, edge_names[i], k, point, edge[i]) ||
+		    p256_mul_test(pg, edge_names[i], NULL, inf, edge[i])) {
+			fprintf(stderr, "FAIL: edge scalar %s\n",
+			    edge_names[i]);
+			failed = 1;
+		}
+	}
+
+	/* k * G + k * G, where both halves of the sum are the same point. */
+	failed |= p256_mul_test(pg, "double", k,
+	    EC_GROUP_get0_generator(pg->p256), k);
+
+	/* k * G + (n - k) * G, which is the point at infinity. */
+	if (!BN_sub(edge[0], pg->order, k))
+		errx(1, "BN_sub");
+	failed |= p256_mul_test(pg, "inverse", k,
+	    EC_GROUP_get0_generator(pg->p256), edge[0]);
+
+	EC_POINT_free(point);
+	EC_POINT_free(inf);
+	BN_free(k);
+	for (i = 0; i < 10; i++)
+		BN_free(edge[i]);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct p256_groups pg;
+	int failed = 0;
+
+	ERR_load_crypto_strings();
+
+	p256_groups_init(&pg);
+
+	failed |= p256_random_test(&pg);
+	failed |= p256_edge_test(&pg);
+
+	p256_groups_cleanup(&pg);
+
+	return (failed);
+}
@@ -0,0 +1,582 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/bn.h>
+#include <openssl/curve25519.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+
+struct ed25519_test {
+	const char *private_key;
+	const char *public_key;
+	const char *message;
+	const char *signature;
+};
+
+/* Taken from https://tools.ietf.org/html/rfc8032#section-7.1 */
+static const struct ed25519_test ed25519_tests[] = {
+	{
+		.private_key =
+		    "9d61b19deffd5a60ba844af492ec2cc4"
+		    "4449c5697b326919703bac031cae7f60",
+		.public_key =
+		    "d75a980182b10ab7d54bfed3c964073a"
+		    "0ee172f3daa62325af021a68f707511a",
+		.message = "",
+		.signature =
+		    "e5564300c360ac729086e2cc806e828a"
+		    "84877f1eb8e5d974d873e06522490155"
+		    "5fb8821590a33bacc61e39701cf9b46b"
+		    "d25bf5f0595bbe24655141438e7a100b",
+	},
+	{
+		.private_key =
+		    "4ccd089b28ff96da9db6c346ec114e0f"
+		    "5b8a319f35aba624da8cf6ed4fb8a6fb",
+		.public_key =
+		    "3d4017c3e843895a92b70aa74d1b7ebc"
+		    "9c982ccf2ec4968cc0cd55f12af4660c",
+		.message = "72",
+		.signature =
+		    "92a009a9f0d4cab8720e820b5f642540"
+		    "a2b27b5416503f8fb3762223ebdb69da"
+		    "085ac1e43e15996e458f3613d0f11d8c"
+		    "387b2eaeb4302aeeb00d291612bb0c00",
+	},
+	{
+		.private_key =
+		    "c5aa8df43f9f837bedb7442f31dcb7b1"
+		    "66d38535076f094b85ce3a2e0b4458f7",
+		.public_key =
+		    "fc51cd8e6218a1a38da47ed00230f058"
+		    "0816ed13ba3303ac5deb911548908025",
+		.message = "af82",
+		.signature =
+		    "6291d657deec24024827e69c3abe01a3"
+		    "0ce548a284743a445e3680d7db5ac3ac"
+		    "18ff9b538d16f290ae67f760984dc659"
+		    "4a7c15e9716ed28dc027beceea1ec40a",
+	},
+};
+
+#define N_ED25519_TESTS (sizeof(ed25519_tests) / sizeof(ed25519_tests[0]))
+
+#define BATCH_SIZE 100
+
+/* The order of the base point, little endian. */
+static const uint8_t ed25519_order[32] = {
+	0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+	0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+};
+
+/* 2^255 - 19, little endian. */
+static const uint8_t ed25519_prime[32] = {
+	0xed, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f,
+};
+
+static void
+hex_decode(const char *hex, uint8_t **out, size_t *out_len)
+{
+	size_t i, len;
+	unsigned int v;
+
+	len = strlen(hex) / 2;
+	if ((*out = malloc(len + 1)) == NULL)
+		err(1, NULL);
+	for (i = 0; i < len; i++) {
+		if (sscanf(&hex[i * 2], "%2x", &v) != 1)
+			errx(1, "bad hex string '%s'", hex);
+		(*out)[i] = v;
+	}
+	*out_len = len;
+}
+
+static BIGNUM *
+le_to_bn(const uint8_t *in, size_t len)
+{
+	uint8_t be[SHA512_DIGEST_LENGTH];
+	BIGNUM *bn;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		be[i] = in[len - 1 - i];
+	if ((bn = BN_bin2bn(be, len, NULL)) == NULL)
+		errx(1, "BN_bin2bn");
+
+	return bn;
+}
+
+static void
+bn_to_le(uint8_t out[32], const BIGNUM *bn)
+{
+	uint8_t be[32];
+	int i, len;
+
+	if ((len = BN_num_bytes(bn)) > 32)
+		errx(1, "BIGNUM too large");
+	memset(be, 0, sizeof(be));
+	BN_bn2bin(bn, be + 32 - len);
+	for (i = 0; i < 32; i++)
+		out[i] = be[31 - i];
+}
+
+/* Returns SHA-512(R || A || M) mod l. */
+static BIGNUM *
+ed25519_test_hram(const uint8_t *R, const uint8_t *A, const uint8_t *message,
+    size_t message_len, const BIGNUM *order, BN_CTX *ctx)
+{
+	uint8_t digest[SHA512_DIGEST_LENGTH];
+	SHA512_CTX sha;
+	BIGNUM *k;
+
+	SHA512_Init(&sha);
+	SHA512_Update(&sha, R, 32);
+	SHA512_Update(&sha, A, 32);
+	SHA512_Update(&sha, message, message_len);
+	SHA512_Final(digest, &sha);
+
+	k = le_to_bn(digest, sizeof(digest));
+	if (!BN_nnmod(k, k, order, ctx))
+		errx(1, "BN_nnmod");
+
+	return k;
+}
+
+/* Adds the point of order two, (0, -1), by negating both coordinates. */
+static void
+ed25519_add_order_two(uint8_t point[32])
+{
+	BIGNUM *y, *prime;
+	uint8_t sign;
+
+	sign = point[31] & 0x80;
+	point[31] &= 0x7f;
+	y = le_to_bn(point, 32);
+	prime = le_to_bn(ed25519_prime, 32);
+	if (!BN_sub(y, prime, y))
+		errx(1, "BN_sub");
+	bn_to_le(point, y);
+	point[31] |= sign ^ 0x80;
+
+	BN_free(y);
+	BN_free(prime);
+}
+
+/*
+ * Signs message with the RFC 8032 key pair et, replacing R or A with a point
+ * that has an extra component of order two. The result is only valid under
+ * the cofactored equation.
+ */
+static void
+ed25519_torsion_sign(const struct ed25519_test *et, int torsion_key,
+    uint8_t sig[ED25519_SIGNATURE_LENGTH], uint8_t pub[32],
+    const uint8_t *message, size_t message_len)
+{
+	uint8_t *priv, *pub0;
+	size_t priv_len, pub_len;
+	uint8_t az[SHA512_DIGEST_LENGTH];
+	BIGNUM *order, *a, *k, *r, *s;
+	BN_CTX *ctx;
+
+	hex_decode(et->private_key, &priv, &priv_len);
+	hex_decode(et->public_key, &pub0, &pub_len);
+	if (!ED25519_sign(sig, message, message_len, pub0, priv))
+		errx(1, "ED25519_sign");
+	memcpy(pub, pub0, 32);
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	order = le_to_bn(ed25519_order, 32);
+
+	SHA512(priv, priv_len, az);
+	az[0] &= 248;
+	az[31] &= 127;
+	az[31] |= 64;
+	a = le_to_bn(az, 32);
+
+	/* Recover the nonce r = s - k * a. */
+	k = ed25519_test_hram(sig, pub, message, message_len, order, ctx);
+	s = le_to_bn(sig + 32, 32);
+	if ((r = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!BN_mod_mul(r, k, a, order, ctx) ||
+	    !BN_mod_sub(r, s, r, order, ctx))
+		errx(1, "BN_mod_sub");
+	BN_free(k);
+
+	if (torsion_key)
+		ed25519_add_order_two(pub);
+	else
+		ed25519_add_order_two(sig);
+
+	k = ed25519_test_hram(sig, pub, message, message_len, order, ctx);
+	if (!BN_mod_mul(s, k, a, order, ctx) ||
+	    !BN_mod_add(s, s, r, order, ctx))
+		errx(1, "BN_mod_add");
+	bn_to_le(sig + 32, s);
+
+	BN_free(order);
+	BN_free(a);
+	BN_free(k);
+	BN_free(r);
+	BN_free(s);
+	BN_CTX_free(ctx);
+	free(priv);
+	free(pub0);
+}
+
+static int
+ed25519_rfc8032_test(void)
+{
+	const struct ed25519_test *et;
+	uint8_t *priv, *pub, *message, *signature;
+	size_t priv_len, pub_len, message_len, signature_len;
+	uint8_t sig[ED25519_SIGNATURE_LENGTH];
+	unsigned int carry;
+	size_t i, j;
+	int failed = 0;
+
+	for (i = 0; i < N_ED25519_TESTS; i++) {
+		et = &ed25519_tests[i];
+
+		hex_decode(et->private_key, &priv, &priv_len);
+		hex_decode(et->public_key, &pub, &pub_len);
+		hex_decode(et->message, &message, &message_len);
+		hex_decode(et->signature, &signature, &signature_len);
+
+		if (!ED25519_sign(sig, message, message_len, pub, priv)) {
+			fprintf(stderr, "FAIL: test %zu: ED25519_sign\n", i);
+			failed = 1;
+		} else if (memcmp(sig, signature, sizeof(sig)) != 0) {
+			fprintf(stderr, "FAIL: test %zu: signature mismatch\n",
+			    i);
+			failed = 1;
+		}
+		if (!ED25519_verify(message, message_len, signature, pub)) {
+			fprintf(stderr, "FAIL: test %zu: ED25519_verify\n", i);
+			failed = 1;
+		}
+
+		/* S + l is an equivalent, non-canonical, signature. */
+		for (carry = 0, j = 0; j < 32; j++) {
+			carry += signature[32 + j] + ed25519_order[j];
+			signature[32 + j] = carry & 0xff;
+			carry >>= 8;
+		}
+		if (ED25519_verify(message, message_len, signature, pub)) {
+			fprintf(stderr, "FAIL: test %zu: verified modified "
+			    "signature\n", i);
+			failed = 1;
+		}
+
+		free(priv);
+		free(pub);
+		free(message);
+		free(signature);
+	}
+
+	return !failed;
+}
+
+static int
+ed25519_batch_test(void)
+{
+	uint8_t pub[BATCH_SIZE][ED25519_PUBLIC_KEY_LENGTH];
+	uint8_t priv[ED25519_PRIVATE_KEY_LENGTH];
+	uint8_t sig[BATCH_SIZE][ED25519_SIGNATURE_LENGTH];
+	uint8_t msg[BATCH_SIZE][16];
+	const uint8_t *messages[BATCH_SIZE], *sigs[BATCH_SIZE];
+	const uint8_t *pubs[BATCH_SIZE];
+	size_t message_lens[BATCH_SIZE];
+	size_t i;
+	int failed = 0;
+
+	for (i = 0; i < BATCH_SIZE; i++) {
+		ED25519_keypair(pub[i], priv);
+		arc4random_buf(msg[i], sizeof(msg[i]));
+		message_lens[i] = i % sizeof(msg[i]);
+		if (!ED25519_sign(sig[i], msg[i], message_lens[i], pub[i],
+		    priv))
+			errx(1, "ED25519_sign");
+		messages[i] = msg[i];
+		sigs[i] = sig[i];
+		pubs[i] = pub[i];
+	}
+
+	if (!ED25519_verify_batch(messages, message_lens, sigs, pubs,
+	    BATCH_SIZE)) {
+		fprintf(stderr, "FAIL: valid batch did not verify\n");
+		failed = 1;
+	}
+	if (!ED25519_verify_batch(messages, message_lens, sigs, pubs, 1)) {
+		fprintf(stderr, "FAIL: batch of one did not verify\n");
+		failed = 1;
+	}
+
+	sig[BATCH_SIZE - 3][5] ^= 0x10;
+	if (ED25519_verify_batch(messages, message_lens, sigs, pubs,
+	    BATCH_SIZE)) {
+		fprintf(stderr, "FAIL: batch with a bad signature verified\n");
+		failed = 1;
+	}
+	sig[BATCH_SIZE - 3][5] ^= 0x10;
+
+	/* Swapping two public keys must be noticed as well. */
+	pubs[0] = pub[1];
+	pubs[1] = pub[0];
+	if (ED25519_verify_batch(messages, message_lens, sigs, pubs,
+	    BATCH_SIZE)) {
+		fprintf(stderr, "FAIL: batch with swapped keys verified\n");
+		failed = 1;
+	}
+
+	return !failed;
+}
+
+static int
+ed25519_agree(const char *name, const uint8_t *message, size_t message_len,
+    const uint8_t *sig, const uint8_t *pub, int want)
+{
+	int single, batch;
+
+	single = ED25519_verify(message, message_len, sig, pub);
+	batch = ED25519_verify_batch(&message, &message_len, &sig, &pub, 1);
+	if (single != want || batch != want) {
+		fprintf(stderr, "FAIL: %s: ED25519_verify %d, "
+		    "ED25519_verify_batch %d, want %d\n", name, single, batch,
+		    want);
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * ED25519_verify and ED25519_verify_batch must accept the same signatures
+ * when R or A carry a small order component, and both must refuse points
+ * of small order and non-canonical encodings.
+ */
+static int
+ed25519_torsion_test(void)
+{
+	static const uint8_t message[] = "torsion";
+	const size_t message_len = sizeof(message) - 1;
+	uint8_t sig[2][ED25519_SIGNATURE_LENGTH], pub[2][32];
+	uint8_t forged[ED25519_SIGNATURE_LENGTH];
+	const uint8_t *messages[2], *sigs[2], *pubs[2];
+	size_t message_lens[2];
+	int failed = 0;
+
+	ed25519_torsion_sign(&ed25519_tests[0], 0, sig[0], pub[0], message,
+	    message_len);
+	ed25519_torsion_sign(&ed25519_tests[1], 1, sig[1], pub[1], message,
+	    message_len);
+
+	failed |= !ed25519_agree("torsion in R", message, message_len,
+	    sig[0], pub[0], 1);
+	failed |= !ed25519_agree("torsion in A", message, message_len,
+	    sig[1], pub[1], 1);
+
+	messages[0] = messages[1] = message;
+	message_lens[0] = message_lens[1] = message_len;
+	sigs[0] = sig[0];
+	sigs[1] = sig[1];
+	pubs[0] = pub[0];
+	pubs[1] = pub[1];
+	if (!ED25519_verify_batch(messages, message_lens, sigs, pubs, 2)) {
+		fprintf(stderr, "FAIL: batch with torsion did not verify\n");
+		failed = 1;
+	}
+
+	/* With A = R = 0 and S = 0 any message would verify. */
+	memset(forged, 0, sizeof(forged));
+	forged[0] = 0x01;
+	failed |= !ed25519_agree("identity", message, message_len, forged,
+	    forged, 0);
+
+	/* The same point encoded as y = 1 + p. */
+	memcpy(forged, ed25519_prime, 32);
+	forged[0] += 1;
+	failed |= !ed25519_agree("non-canonical identity", message,
+	    message_len, forged, forged, 0);
+
+	/* A = (0, -1), the point of order two, and R = 0. */
+	memcpy(pub[0], ed25519_prime, 32);
+	pub[0][0] -= 1;
+	memset(forged, 0, sizeof(forged));
+	forged[0] = 0x01;
+	failed |= !ed25519_agree("order two key", message, message_len,
+	    forged, pub[0], 0);
+
+	return !failed;
+}
+
+static int
+ed25519_evp_test(void)
+{
+	const struct ed25519_test *et = &ed25519_tests[2];
+	EVP_PKEY *pkey = NULL, *pubkey = NULL, *genkey = NULL;
+	EVP_PKEY_CTX *pkey_ctx = NULL;
+	EVP_MD_CTX *md_ctx = NULL;
+	X509 *x509 = NULL;
+	uint8_t *priv, *pub, *message, *signature;
+	size_t priv_len, pub_len, message_len, signature_len;
+	uint8_t raw[ED25519_PUBLIC_KEY_LENGTH];
+	uint8_t sig[ED25519_SIGNATURE_LENGTH];
+	size_t raw_len, sig_len;
+	int failed = 1;
+
+	hex_decode(et->private_key, &priv, &priv_len);
+	hex_decode(et->public_key, &pub, &pub_len);
+	hex_decode(et->message, &message, &message_len);
+	hex_decode(et->signature, &signature, &signature_len);
+
+	if ((pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, NULL,
+	    priv, priv_len)) == NULL) {
+		fprintf(stderr, "FAIL: EVP_PKEY_new_raw_private_key\n");
+		goto failure;
+	}
+	if ((pubkey = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, NULL,
+	    pub, pub_len)) == NULL) {
+		fprintf(stderr, "FAIL: EVP_PKEY_new_raw_public_key\n");
+		goto failure;
+	}
+	raw_len = sizeof(raw);
+	if (!EVP_PKEY_get_raw_public_key(pkey, raw, &raw_len) ||
+	    raw_len != pub_len || memcmp(raw, pub, raw_len) != 0) {
+		fprintf(stderr, "FAIL: EVP_PKEY_get_raw_public_key\n");
+		goto failure;
+	}
+	if (EVP_PKEY_cmp(pkey, pubkey) != 1) {
+		fprintf(stderr, "FAIL: EVP_PKEY_cmp\n");
+		goto failure;
+	}
+
+	if ((md_ctx = EVP_MD_CTX_new()) == NULL)
+		errx(1, "EVP_MD_CTX_new");
+	if (!EVP_DigestSignInit(md_ctx, NULL, NULL, NULL, pkey)) {
+		fprintf(stderr, "FAIL: EVP_DigestSignInit\n");
+		goto failure;
+	}
+	sig_len = 0;
+	if (!EVP_DigestSign(md_ctx, NULL, &sig_len, message, message_len) ||
+	    sig_len != sizeof(sig)) {
+		fprintf(stderr, "FAIL: EVP_DigestSign length\n");
+		goto failure;
+	}
+	if (!EVP_DigestSign(md_ctx, sig, &sig_len, message, message_len) ||
+	    memcmp(sig, signature, sizeof(sig)) != 0) {
+		fprintf(stderr, "FAIL: EVP_DigestSign\n");
+		goto failure;
+	}
+	EVP_MD_CTX_free(md_ctx);
+
+	if ((md_ctx = EVP_MD_CTX_new()) == NULL)
+		errx(1, "EVP_MD_CTX_new");
+	if (EVP_DigestVerifyInit(md_ctx, NULL, EVP_sha256(), NULL,
+	    pubkey)) {
+		fprintf(stderr, "FAIL: EVP_DigestVerifyInit accepted digest\n");
+		goto failure;
+	}
+	EVP_MD_CTX_free(md_ctx);
+
+	if ((md_ctx = EVP_MD_CTX_new()) == NULL)
+		errx(1, "EVP_MD_CTX_new");
+	if (!EVP_DigestVerifyInit(md_ctx, NULL, NULL, NULL, pubkey)) {
+		fprintf(stderr, "FAIL: EVP_DigestVerifyInit\n");
+		goto failure;
+	}
+	if (EVP_DigestVerify(md_ctx, sig, sig_len, message,
+	    message_len) != 1) {
+		fprintf(stderr, "FAIL: EVP_DigestVerify\n");
+		goto failure;
+	}
+
+	/* Self-signed certificate with a generated key. */
+	if ((pkey_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, NULL)) == NULL)
+		errx(1, "EVP_PKEY_CTX_new_id");
+	if (EVP_PKEY_keygen_init(pkey_ctx) <= 0 ||
+	    EVP_PKEY_keygen(pkey_ctx, &genkey) <= 0) {
+		fprintf(stderr, "FAIL: EVP_PKEY_keygen\n");
+		goto failure;
+	}
+	if ((x509 = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if (!X509_set_pubkey(x509, genkey)) {
+		fprintf(stderr, "FAIL: X509_set_pubkey\n");
+		goto failure;
+	}
+	if (!X509_sign(x509, genkey, NULL)) {
+		fprintf(stderr, "FAIL: X509_sign\n");
+		goto failure;
+	}
+	if (X509_get_signature_nid(x509) != NID_Ed25519) {
+		fprintf(stderr, "FAIL: X509 signature algorithm\n");
+		goto failure;
+	}
+	if (X509_verify(x509, genkey) != 1) {
+		fprintf(stderr, "FAIL: X509_verify\n");
+		goto failure;
+	}
+	if (X509_verify(x509, pubkey) == 1) {
+		fprintf(stderr, "FAIL: X509_verify with wrong key\n");
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	EVP_MD_CTX_free(md_ctx);
+	EVP_PKEY_CTX_free(pkey_ctx);
+	EVP_PKEY_free(pkey);
+	EVP_PKEY_free(pubkey);
+	EVP_PKEY_free(genkey);
+	X509_free(x509);
+	free(priv);
+	free(pub);
+	free(message);
+	free(signature);
+
+	return !failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	failed |= !ed25519_rfc8032_test();
+	failed |= !ed25519_batch_test();
+	failed |= !ed25519_torsion_test();
+	failed |= !ed25519_evp_test();
+
+	if (failed)
+		return 1;
+
+	printf("PASS\n");
+	return 0;
+}
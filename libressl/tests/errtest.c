@@ -0,0 +1,161 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define ERR_THREADS	8
+#define ERR_ROUNDS	1000000
+
+struct err_state {
+	int thread;
+	int rounds;
+	int failed;
+};
+
+/*
+ * Each thread queues errors with its own reason code, which must never show
+ * up in the queue of another thread.
+ */
+static void *
+err_thread(void *arg)
+{
+	struct err_state *es = arg;
+	unsigned long e;
+	int reason = es->thread + 1;
+	int i;
+
+	for (i = 0; i < es->rounds; i++) {
+		if ((i & 0xff) == 0) {
+			ERR_put_error(ERR_LIB_USER, 0, reason, __FILE__, __LINE__);
+			ERR_put_error(ERR_LIB_USER, 0, reason, __FILE__, __LINE__);
+			if ((e = ERR_get_error()) == 0 ||
+			    ERR_GET_REASON(e) != reason)
+				es->failed = 1;
+			if ((e = ERR_peek_last_error()) == 0 ||
+			    ERR_GET_REASON(e) != reason)
+				es->failed = 1;
+		}
+		ERR_clear_error();
+		if (ERR_peek_error() != 0)
+			es->failed = 1;
+	}
+
+	/* Leave errors behind - these are freed when the thread exits. */
+	ERR_put_error(ERR_LIB_USER, 0, reason, __FILE__, __LINE__);
+
+	return NULL;
+}
+
+static double
+timespec_diff(struct timespec *start, struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) +
+	    (end->tv_nsec - start->tv_nsec) / 1000000000.0;
+}
+
+static int
+err_threads_test(int num_threads)
+{
+	struct err_state es[ERR_THREADS];
+	pthread_t threads[ERR_THREADS];
+	struct timespec start, end;
+	double elapsed;
+	int failed = 0;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < num_threads; i++) {
+		es[i].thread = i;
+		es[i].rounds = ERR_ROUNDS / num_threads;
+		es[i].failed = 0;
+		if (pthread_create(&threads[i], NULL, err_thread, &es[i]) != 0)
+			errx(1, "failed to create thread");
+	}
+	for (i = 0; i < num_threads; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "failed to join thread");
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < num_threads; i++) {
+		if (es[i].failed) {
+			fprintf(stderr, "FAIL: thread %d saw a foreign or "
+			    "missing error\n", i);
+			failed = 1;
+		}
+	}
+
+	/* No other thread's errors may have leaked into this one. */
+	if (ERR_peek_error() != 0) {
+		fprintf(stderr, "FAIL: main thread has queued errors\n");
+		failed = 1;
+	}
+
+	elapsed = timespec_diff(&start, &end);
+	printf("%d thread%s: %d ERR_clear_error in %.3fs (%.0f/s)\n",
+	    num_threads, num_threads == 1 ? "" : "s",
+	    es[0].rounds * num_threads, elapsed,
+	    es[0].rounds * num_threads / elapsed);
+
+	return failed;
+}
+
+static int
+err_remove_state_test(void)
+{
+	int failed = 0;
+
+	ERR_put_error(ERR_LIB_USER, 0, 1, __FILE__, __LINE__);
+	ERR_remove_thread_state(NULL);
+	if (ERR_peek_error() != 0) {
+		fprintf(stderr, "FAIL: error queue survived "
+		    "ERR_remove_thread_state\n");
+		failed = 1;
+	}
+
+	/* A new queue is created on demand. */
+	ERR_put_error(ERR_LIB_USER, 0, 2, __FILE__, __LINE__);
+	if (ERR_GET_REASON(ERR_get_error()) != 2) {
+		fprintf(stderr, "FAIL: error queue not recreated\n");
+		failed = 1;
+	}
+	ERR_remove_thread_state(NULL);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	ERR_load_crypto_strings();
+
+	failed |= err_remove_state_test();
+
+	/* The timings are informational and depend on the machine. */
+	failed |= err_threads_test(1);
+	failed |= err_threads_test(ERR_THREADS);
+
+	return (failed);
+}
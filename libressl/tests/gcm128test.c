@@ -55,6 +55,7 @@
 #include <string.h>
 
 #include <openssl/aes.h>
+#include <openssl/evp.h>
 #include <openssl/modes.h>
 
 /* XXX - something like this should be in the public headers. */
@@ -913,6 +914,128 @@ fail:
 	return (ret);
 }
 
+#define BULK_MAX_LEN	16389
+#define BULK_CHUNK	333
+
+/*
+ * Compare bulk encryption and decryption through EVP, which may use the
+ * stitched AES-GCM implementations, with the block based GCM128 code.
+ */
+static int
+do_gcm128_bulk_test(void)
+{
+	static const size_t lengths[] = {
+		16, 127, 128, 129, 255, 256, 257, 1000, 4096, BULK_MAX_LEN,
+	};
+	static const size_t iv_lens[] = { 12, 16 };
+	const EVP_CIPHER *ciphers[3];
+	uint8_t key[32], iv[16], aad[13], tag[16], want_tag[16];
+	uint8_t *in, *out, *want;
+	GCM128_CONTEXT ctx;
+	EVP_CIPHER_CTX *cctx;
+	AES_KEY aes_key;
+	size_t i, j, k, len, n;
+	int key_bits, out_len, ret = 0;
+
+	ciphers[0] = EVP_aes_128_gcm();
+	ciphers[1] = EVP_aes_192_gcm();
+	ciphers[2] = EVP_aes_256_gcm();
+
+	if ((in = malloc(BULK_MAX_LEN)) == NULL ||
+	    (out = malloc(BULK_MAX_LEN)) == NULL ||
+	    (want = malloc(BULK_MAX_LEN)) == NULL)
+		err(1, "malloc");
+	if ((cctx = EVP_CIPHER_CTX_new()) == NULL)
+		errx(1, "EVP_CIPHER_CTX_new");
+
+	arc4random_buf(key, sizeof(key));
+	arc4random_buf(iv, sizeof(iv));
+	arc4random_buf(aad, sizeof(aad));
+	arc4random_buf(in, BULK_MAX_LEN);
+
+	for (i = 0; i < 3; i++) {
+		key_bits = 128 + 64 * i;
+		AES_set_encrypt_key(key, key_bits, &aes_key);
+
+		for (j = 0; j < sizeof(iv_lens) / sizeof(iv_lens[0]); j++) {
+			for (k = 0; k < sizeof(lengths) / sizeof(lengths[0]);
+			    k++) {
+				len = lengths[k];
+
+				CRYPTO_gcm128_init(&ctx, &aes_key,
+				    (block128_f)AES_encrypt);
+				CRYPTO_gcm128_setiv(&ctx, iv, iv_lens[j]);
+				CRYPTO_gcm128_aad(&ctx, aad, sizeof(aad));
+				CRYPTO_gcm128_encrypt(&ctx, in, want, len);
+				CRYPTO_gcm128_tag(&ctx, want_tag, 16);
+
+				/* Encrypt in a single update. */
+				if (!EVP_EncryptInit_ex(cctx, ciphers[i], NULL,
+				    NULL, NULL) ||
+				    !EVP_CIPHER_CTX_ctrl(cctx,
+				    EVP_CTRL_GCM_SET_IVLEN, iv_lens[j], NULL) ||
+				    !EVP_EncryptInit_ex(cctx, NULL, NULL, key,
+				    iv) ||
+				    !EVP_EncryptUpdate(cctx, NULL, &out_len, aad,
+				    sizeof(aad)) ||
+				    !EVP_EncryptUpdate(cctx, out, &out_len, in,
+				    len) ||
+				    !EVP_EncryptFinal_ex(cctx, out + out_len,
+				    &out_len) ||
+				    !EVP_CIPHER_CTX_ctrl(cctx,
+				    EVP_CTRL_GCM_GET_TAG, 16, tag))
+					errx(1, "AES-%d-GCM encrypt failed",
+					    key_bits);
+				if (memcmp(out, want, len) != 0 ||
+				    memcmp(tag, want_tag, 16) != 0) {
+					fprintf(stderr, "AES-%d-GCM bulk encrypt "
+					    "failed for length %zu with %zu "
+					    "byte IV\n", key_bits, len,
+					    iv_lens[j]);
+					ret = 1;
+				}
+
+				/* Decrypt in place, in uneven chunks. */
+				if (!EVP_DecryptInit_ex(cctx, ciphers[i], NULL,
+				    NULL, NULL) ||
+				    !EVP_CIPHER_CTX_ctrl(cctx,
+				    EVP_CTRL_GCM_SET_IVLEN, iv_lens[j], NULL) ||
+				    !EVP_DecryptInit_ex(cctx, NULL, NULL, key,
+				    iv) ||
+				    !EVP_CIPHER_CTX_ctrl(cctx,
+				    EVP_CTRL_GCM_SET_TAG, 16, want_tag) ||
+				    !EVP_DecryptUpdate(cctx, NULL, &out_len, aad,
+				    sizeof(aad)))
+					errx(1, "AES-%d-GCM decrypt failed",
+					    key_bits);
+				memcpy(out, want, len);
+				for (n = 0; n < len; n += BULK_CHUNK) {
+					if (!EVP_DecryptUpdate(cctx, out + n,
+					    &out_len, out + n,
+					    len - n < BULK_CHUNK ?
+					    len - n : BULK_CHUNK))
+						errx(1, "EVP_DecryptUpdate");
+				}
+				if (EVP_DecryptFinal_ex(cctx, out + len,
+				    &out_len) != 1 || memcmp(out, in, len) != 0) {
+					fprintf(stderr, "AES-%d-GCM bulk decrypt "
+					    "failed for length %zu with %zu "
+					    "byte IV\n", key_bits, len,
+					    iv_lens[j]);
+					ret = 1;
+				}
+			}
+		}
+	}
+
+	EVP_CIPHER_CTX_free(cctx);
+	free(in);
+	free(out);
+	free(want);
+
+	return ret;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -922,5 +1045,7 @@ main(int argc, char **argv)
 	for (i = 0; i < N_TESTS; i++)
 		ret |= do_gcm128_test(i + 1, &gcm128_tests[i]);
 
+	ret |= do_gcm128_bulk_test();
+
 	return ret;
 }
@@ -117,6 +117,10 @@ static struct child stateinfo[][TLS13_NUM_MESSAGE_TYPES] = {
 	[SERVER_FINISHED] = {
 		{CLIENT_FINISHED, DEFAULT, WITHOUT_CR | WITH_PSK, 0},
 		{CLIENT_CERTIFICATE, DEFAULT, 0, WITHOUT_CR | WITH_PSK},
+		{CLIENT_END_OF_EARLY_DATA, WITH_0RTT, WITH_PSK, 0},
+	},
+	[CLIENT_END_OF_EARLY_DATA] = {
+		{CLIENT_FINISHED, DEFAULT, 0, 0},
 	},
 	[CLIENT_CERTIFICATE] = {
 		{CLIENT_FINISHED, DEFAULT, 0, 0},
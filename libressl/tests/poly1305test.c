@@ -5,8 +5,12 @@
  *   https://github.com/floodyberry/poly1305-donna
  */
 
+#include <err.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include <openssl/bn.h>
 #include <openssl/poly1305.h>
 
 void poly1305_auth(unsigned char mac[16], const unsigned char *m, size_t bytes,
@@ -14,6 +18,7 @@ void poly1305_auth(unsigned char mac[16], const unsigned char *m, size_t bytes,
 
 int poly1305_verify(const unsigned char mac1[16], const unsigned char mac2[16]);
 int poly1305_power_on_self_test(void);
+int poly1305_bulk_test(void);
 
 void
 poly1305_auth(unsigned char mac[16], const unsigned char *m, size_t bytes,
@@ -157,6 +162,160 @@ poly1305_power_on_self_test(void)
 	return result;
 }
 
+/* load a little endian number into a BIGNUM */
+static void
+poly1305_bn_le(BIGNUM *bn, const unsigned char *p, size_t len)
+{
+	unsigned char be[17];
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		be[i] = p[len - 1 - i];
+	if (BN_bin2bn(be, len, bn) == NULL)
+		errx(1, "BN_bin2bn");
+}
+
+/*
+ * compute the mac directly from the definition, as
+ * (((m[0] + 2^128) * r^n + ... + (m[n-1] + 2^(8*len)) * r) % p + s) % 2^128
+ */
+static void
+poly1305_reference(unsigned char mac[16], const unsigned char *m, size_t bytes,
+    const unsigned char key[32])
+{
+	unsigned char rbuf[16], be[16];
+	BIGNUM *p, *r, *s, *h, *c;
+	BN_CTX *ctx;
+	size_t i, len;
+	int n;
+
+	if ((ctx = BN_CTX_new()) == NULL)
+		errx(1, "BN_CTX_new");
+	if ((p = BN_new()) == NULL || (r = BN_new()) == NULL ||
+	    (s = BN_new()) == NULL || (h = BN_new()) == NULL ||
+	    (c = BN_new()) == NULL)
+		errx(1, "BN_new");
+
+	/* p = 2^130 - 5 */
+	if (!BN_set_bit(p, 130) || !BN_sub_word(p, 5))
+		errx(1, "BN_set_bit");
+
+	memcpy(rbuf, key, 16);
+	rbuf[3] &= 15;
+	rbuf[7] &= 15;
+	rbuf[11] &= 15;
+	rbuf[15] &= 15;
+	rbuf[4] &= 252;
+	rbuf[8] &= 252;
+	rbuf[12] &= 252;
+	poly1305_bn_le(r, rbuf, 16);
+	poly1305_bn_le(s, key + 16, 16);
+
+	BN_zero(h);
+	for (i = 0; i < bytes; i += len) {
+		len = bytes - i < 16 ? bytes - i : 16;
+		poly1305_bn_le(c, m + i, len);
+		if (!BN_set_bit(c, 8 * len) ||
+		    !BN_add(h, h, c) ||
+		    !BN_mod_mul(h, h, r, p, ctx))
+			errx(1, "BN_mod_mul");
+	}
+	if (!BN_add(h, h, s))
+		errx(1, "BN_add");
+	if (BN_num_bits(h) > 128 && !BN_mask_bits(h, 128))
+		errx(1, "BN_mask_bits");
+
+	memset(be, 0, sizeof(be));
+	n = BN_num_bytes(h);
+	if (BN_bn2bin(h, be + 16 - n) != n)
+		errx(1, "BN_bn2bin");
+	for (i = 0; i < 16; i++)
+		mac[i] = be[15 - i];
+
+	BN_free(p);
+	BN_free(r);
+	BN_free(s);
+	BN_free(h);
+	BN_free(c);
+	BN_CTX_free(ctx);
+}
+
+/*
+ * compare long messages, which may be processed by multi-block
+ * implementations, against the reference, both in a single update and in
+ * chunks that leave partial blocks behind
+ */
+int
+poly1305_bulk_test(void)
+{
+	static const size_t lengths[] = {
+		0, 1, 15, 16, 17, 63, 64, 127, 128, 255, 256, 511, 512, 513,
+		527, 528, 1024, 1040, 1088, 1600, 2047, 2048, 4096, 4111,
+		16384, 16399,
+	};
+	static const size_t chunks[] = {
+		1, 15, 17, 64, 100, 511, 513, 4096,
+	};
+	unsigned char key[32];
+	unsigned char mac[16], want[16];
+	unsigned char *msg;
+	poly1305_context ctx;
+	size_t i, j, k, n, len, size;
+	int result = 1;
+
+	if ((msg = malloc(16400)) == NULL)
+		errx(1, "malloc");
+
+	for (i = 0; i < 3; i++) {
+		/* random, then with every message and key bit set */
+		if (i == 0) {
+			arc4random_buf(key, sizeof(key));
+			arc4random_buf(msg, 16400);
+		} else {
+			memset(key, 0xff, sizeof(key));
+			memset(msg, 0xff, 16400);
+			if (i == 2)
+				memset(key + 16, 0, 16);
+		}
+
+		for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+			len = lengths[j];
+
+			/* use an unaligned message */
+			poly1305_reference(want, msg + 1, len, key);
+
+			poly1305_auth(mac, msg + 1, len, key);
+			if (!poly1305_verify(want, mac)) {
+				fprintf(stderr, "poly1305 failed for length "
+				    "%zu\n", len);
+				result = 0;
+			}
+
+			for (k = 0; k < sizeof(chunks) / sizeof(chunks[0]);
+			    k++) {
+				CRYPTO_poly1305_init(&ctx, key);
+				for (n = 0; n < len; n += size) {
+					size = len - n < chunks[k] ?
+					    len - n : chunks[k];
+					CRYPTO_poly1305_update(&ctx,
+					    msg + 1 + n, size);
+				}
+				CRYPTO_poly1305_finish(&ctx, mac);
+				if (!poly1305_verify(want, mac)) {
+					fprintf(stderr, "poly1305 failed for "
+					    "length %zu in chunks of %zu\n",
+					    len, chunks[k]);
+					result = 0;
+				}
+			}
+		}
+	}
+
+	free(msg);
+
+	return result;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -165,5 +324,10 @@ main(int argc, char **argv)
 		return 1;
 	}
 
+	if (!poly1305_bulk_test()) {
+		fprintf(stderr, "One or more bulk tests failed!\n");
+		return 1;
+	}
+
 	return 0;
 }
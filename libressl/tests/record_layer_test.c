@@ -16,6 +16,7 @@
  */
 
 #include <err.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "ssl_locl.h"
@@ -26,6 +27,87 @@ int tls12_record_layer_inc_seq_num(struct tls12_record_layer *rl,
     uint8_t *seq_num);
 int tls13_record_layer_inc_seq_num(uint8_t *seq_num);
 
+/*
+ * With glibc, count the heap allocations made and the bytes copied by
+ * memcpy() and memmove() while records are written, by interposing on
+ * them. The test's own wire callbacks are not counted.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define RECORD_LAYER_TEST_COUNT
+
+/*
+ * The AEAD may copy key material, such as the AES key schedule, but the
+ * record content must not be copied.
+ */
+#define RECORD_LAYER_TEST_MAX_COPIED	256
+
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void __libc_free(void *);
+
+static volatile int counting;
+static size_t counted_allocs;
+static size_t counted_copies;
+
+void *
+malloc(size_t size)
+{
+	if (counting)
+		counted_allocs++;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	if (counting)
+		counted_allocs++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	if (counting)
+		counted_allocs++;
+	return __libc_realloc(ptr, size);
+}
+
+void
+free(void *ptr)
+{
+	__libc_free(ptr);
+}
+
+/* Copy through volatile pointers so that this is not made a memcpy call. */
+void *
+memmove(void *dst, const void *src, size_t n)
+{
+	volatile unsigned char *d = dst;
+	const volatile unsigned char *s = src;
+
+	if (counting)
+		counted_copies += n;
+
+	if (d <= s) {
+		while (n-- > 0)
+			*d++ = *s++;
+	} else {
+		while (n-- > 0)
+			d[n] = s[n];
+	}
+
+	return dst;
+}
+
+void *
+memcpy(void *dst, const void *src, size_t n)
+{
+	return memmove(dst, src, n);
+}
+#endif
+
 static void
 hexdump(const unsigned char *buf, size_t len)
 {
@@ -294,6 +376,234 @@ test_seq_num_tls13(void)
 	return failed;
 }
 
+#define RECORD_LAYER_TEST_WIRE_LEN (8 * TLS13_RECORD_MAX_LEN)
+
+struct record_layer_test_wire {
+	uint8_t buf[RECORD_LAYER_TEST_WIRE_LEN];
+	size_t len;
+	size_t off;
+	const void *write_buf;
+	int write_bufs;
+};
+
+static ssize_t
+wire_read_cb(void *buf, size_t n, void *arg)
+{
+	struct record_layer_test_wire *wire = arg;
+
+	if (wire->off == wire->len)
+		return TLS13_IO_WANT_POLLIN;
+	if (n > wire->len - wire->off)
+		n = wire->len - wire->off;
+
+	memcpy(buf, &wire->buf[wire->off], n);
+	wire->off += n;
+
+	return n;
+}
+
+static ssize_t
+wire_write_cb(const void *buf, size_t n, void *arg)
+{
+	struct record_layer_test_wire *wire = arg;
+
+	/* Count the number of distinct buffers records were written from. */
+	if (wire->write_buf != buf) {
+		wire->write_buf = buf;
+		wire->write_bufs++;
+	}
+
+	if (n > sizeof(wire->buf) - wire->len)
+		return TLS13_IO_FAILURE;
+
+#ifdef RECORD_LAYER_TEST_COUNT
+	counting = 0;
+	memcpy(&wire->buf[wire->len], buf, n);
+	counting = 1;
+#else
+	memcpy(&wire->buf[wire->len], buf, n);
+#endif
+	wire->len += n;
+
+	return n;
+}
+
+static void
+alert_cb(uint8_t alert_desc, void *arg)
+{
+}
+
+static void
+claim_cb(Claim claim, void *arg)
+{
+}
+
+static const struct tls13_record_layer_callbacks record_layer_test_cb = {
+	.wire_read = wire_read_cb,
+	.wire_write = wire_write_cb,
+	.alert_recv = alert_cb,
+	.alert_sent = alert_cb,
+};
+
+static const size_t record_layer_test_lens[] = {
+	1, 15, 16, 17, 255, 1024, 16383, 16384,
+};
+
+#define N_RECORD_LAYER_TEST_LENS \
+    (sizeof(record_layer_test_lens) / sizeof(record_layer_test_lens[0]))
+
+static int
+do_record_layer_test_tls13(const char *name, const EVP_AEAD *aead,
+    const EVP_MD *hash)
+{
+	struct tls13_record_layer *rl_read = NULL, *rl_write = NULL;
+	struct record_layer_test_wire *wire = NULL;
+	uint8_t key[EVP_MAX_MD_SIZE];
+	struct tls13_secret secret;
+	struct tls13_ctx ctx;
+	uint8_t *data = NULL, *got = NULL;
+	size_t data_len = 0, got_len;
+	ssize_t ret;
+	SSL ssl;
+	size_t i;
+	int failed = 1;
+
+	memset(&ssl, 0, sizeof(ssl));
+	ssl.claim = claim_cb;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.ssl = &ssl;
+
+	memset(key, 0x5a, sizeof(key));
+	secret.data = key;
+	secret.len = EVP_MD_size(hash);
+
+	for (i = 0; i < N_RECORD_LAYER_TEST_LENS; i++)
+		data_len += record_layer_test_lens[i];
+
+	if ((wire = calloc(1, sizeof(*wire))) == NULL)
+		errx(1, "failed to allocate wire");
+	if ((data = malloc(data_len)) == NULL)
+		errx(1, "failed to allocate data");
+	if ((got = calloc(1, data_len)) == NULL)
+		errx(1, "failed to allocate data");
+	arc4random_buf(data, data_len);
+
+	if ((rl_write = tls13_record_layer_new(&record_layer_test_cb,
+	    wire)) == NULL)
+		errx(1, "failed to create record layer");
+	if ((rl_read = tls13_record_layer_new(&record_layer_test_cb,
+	    wire)) == NULL)
+		errx(1, "failed to create record layer");
+
+	tls13_record_layer_set_aead(rl_write, aead);
+	tls13_record_layer_set_hash(rl_write, hash);
+	tls13_record_layer_set_aead(rl_read, aead);
+	tls13_record_layer_set_hash(rl_read, hash);
+
+	if (!tls13_record_layer_set_write_traffic_key(&ctx, rl_write,
+	    &secret)) {
+		fprintf(stderr, "FAIL: %s - failed to set write key\n", name);
+		goto failure;
+	}
+	if (!tls13_record_layer_set_read_traffic_key(&ctx, rl_read,
+	    &secret)) {
+		fprintf(stderr, "FAIL: %s - failed to set read key\n", name);
+		goto failure;
+	}
+
+	tls13_record_layer_handshake_completed(rl_write);
+	tls13_record_layer_handshake_completed(rl_read);
+
+	for (i = 0, got_len = 0; i < N_RECORD_LAYER_TEST_LENS; i++) {
+#ifdef RECORD_LAYER_TEST_COUNT
+		counted_allocs = 0;
+		counted_copies = 0;
+		counting = 1;
+#endif
+		ret = tls13_write_application_data(rl_write, &data[got_len],
+		    record_layer_test_lens[i]);
+#ifdef RECORD_LAYER_TEST_COUNT
+		counting = 0;
+#endif
+		if (ret != (ssize_t)record_layer_test_lens[i]) {
+			fprintf(stderr, "FAIL: %s - write of %zu bytes "
+			    "returned %zd\n", name, record_layer_test_lens[i],
+			    ret);
+			goto failure;
+		}
+#ifdef RECORD_LAYER_TEST_COUNT
+		/* Only the first record allocates, for the write buffer. */
+		if (counted_allocs != (i == 0)) {
+			fprintf(stderr, "FAIL: %s - write of %zu bytes made %zu "
+			    "allocations, want %d\n", name,
+			    record_layer_test_lens[i], counted_allocs, i == 0);
+			goto failure;
+		}
+		if (counted_copies > RECORD_LAYER_TEST_MAX_COPIED) {
+			fprintf(stderr, "FAIL: %s - write of %zu bytes copied "
+			    "%zu bytes\n", name, record_layer_test_lens[i],
+			    counted_copies);
+			goto failure;
+		}
+#endif
+		got_len += ret;
+	}
+
+	/*
+	 * Every record must have been sealed into, and written from, the
+	 * same per-connection buffer.
+	 */
+	if (wire->write_bufs != 1) {
+		fprintf(stderr, "FAIL: %s - records written from %d buffers, "
+		    "want 1\n", name, wire->write_bufs);
+		goto failure;
+	}
+
+	for (got_len = 0; got_len < data_len; got_len += ret) {
+		ret = tls13_read_application_data(rl_read, &got[got_len],
+		    data_len - got_len);
+		if (ret <= 0) {
+			fprintf(stderr, "FAIL: %s - read returned %zd after "
+			    "%zu bytes\n", name, ret, got_len);
+			goto failure;
+		}
+	}
+
+	if (memcmp(got, data, data_len) != 0) {
+		fprintf(stderr, "FAIL: %s - read data differs from written "
+		    "data\n", name);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	tls13_record_layer_free(rl_read);
+	tls13_record_layer_free(rl_write);
+	free(wire);
+	free(data);
+	free(got);
+
+	return failed;
+}
+
+static int
+test_record_layer_tls13(void)
+{
+	int failed = 0;
+
+	fprintf(stderr, "Running TLSv1.3 record layer tests...\n");
+
+	failed |= do_record_layer_test_tls13("AES-128-GCM",
+	    EVP_aead_aes_128_gcm(), EVP_sha256());
+	failed |= do_record_layer_test_tls13("AES-256-GCM",
+	    EVP_aead_aes_256_gcm(), EVP_sha384());
+	failed |= do_record_layer_test_tls13("ChaCha20-Poly1305",
+	    EVP_aead_chacha20_poly1305(), EVP_sha256());
+
+	return failed;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -301,6 +611,7 @@ main(int argc, char **argv)
 
 	failed |= test_seq_num_tls12();
 	failed |= test_seq_num_tls13();
+	failed |= test_record_layer_tls13();
 
 	return failed;
 }
@@ -0,0 +1,159 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/ssl.h>
+
+#include <openssl/err.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "ssl_locl.h"
+
+#define REFCOUNT_THREADS	8
+#define REFCOUNT_ROUNDS		20000
+
+struct refcount_state {
+	SSL_CTX *ssl_ctx;
+	SSL_SESSION *sess;
+	int rounds;
+	int failed;
+};
+
+/*
+ * Every SSL takes a reference to the SSL_CTX and, through SSL_set_session()
+ * and SSL_get1_session(), to the shared session - all threads contend on the
+ * same two reference counts.
+ */
+static void *
+refcount_thread(void *arg)
+{
+	struct refcount_state *rs = arg;
+	SSL_SESSION *sess;
+	SSL *ssl;
+	int i;
+
+	for (i = 0; i < rs->rounds; i++) {
+		if ((ssl = SSL_new(rs->ssl_ctx)) == NULL) {
+			rs->failed = 1;
+			break;
+		}
+		if (!SSL_set_session(ssl, rs->sess)) {
+			SSL_free(ssl);
+			rs->failed = 1;
+			break;
+		}
+		if ((sess = SSL_get1_session(ssl)) != rs->sess)
+			rs->failed = 1;
+		SSL_SESSION_free(sess);
+		SSL_free(ssl);
+	}
+
+	return NULL;
+}
+
+static double
+timespec_diff(struct timespec *start, struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) +
+	    (end->tv_nsec - start->tv_nsec) / 1000000000.0;
+}
+
+static int
+refcount_test(int num_threads)
+{
+	struct refcount_state rs[REFCOUNT_THREADS];
+	pthread_t threads[REFCOUNT_THREADS];
+	struct timespec start, end;
+	SSL_CTX *ssl_ctx;
+	SSL_SESSION *sess;
+	double elapsed;
+	int failed = 1;
+	int i;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_client_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	if ((sess = SSL_SESSION_new()) == NULL)
+		errx(1, "SSL_SESSION_new() returned NULL");
+	sess->ssl_version = TLS1_2_VERSION;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < num_threads; i++) {
+		rs[i].ssl_ctx = ssl_ctx;
+		rs[i].sess = sess;
+		rs[i].rounds = REFCOUNT_ROUNDS / num_threads;
+		rs[i].failed = 0;
+		if (pthread_create(&threads[i], NULL, refcount_thread,
+		    &rs[i]) != 0)
+			errx(1, "failed to create thread");
+	}
+	for (i = 0; i < num_threads; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "failed to join thread");
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < num_threads; i++) {
+		if (rs[i].failed) {
+			fprintf(stderr, "FAIL: thread %d failed\n", i);
+			ERR_print_errors_fp(stderr);
+			goto failure;
+		}
+	}
+
+	if (ssl_ctx->references != 1) {
+		fprintf(stderr, "FAIL: SSL_CTX has %d references, want 1\n",
+		    ssl_ctx->references);
+		goto failure;
+	}
+	if (sess->references != 1) {
+		fprintf(stderr, "FAIL: SSL_SESSION has %d references, "
+		    "want 1\n", sess->references);
+		goto failure;
+	}
+
+	elapsed = timespec_diff(&start, &end);
+	printf("%d thread%s: %d SSL_new/SSL_free in %.3fs (%.0f/s)\n",
+	    num_threads, num_threads == 1 ? "" : "s",
+	    rs[0].rounds * num_threads, elapsed,
+	    rs[0].rounds * num_threads / elapsed);
+
+	failed = 0;
+
+ failure:
+	SSL_SESSION_free(sess);
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	SSL_library_init();
+	SSL_load_error_strings();
+
+	/* The timings are informational and depend on the machine. */
+	failed |= refcount_test(1);
+	failed |= refcount_test(REFCOUNT_THREADS);
+
+	return (failed);
+}
@@ -0,0 +1,14 @@
+@echo off
+setlocal enabledelayedexpansion
+REM	resumptiontest.bat
+
+set resumptiontest_bin=%1
+set resumptiontest_bin=%resumptiontest_bin:/=\%
+if not exist %resumptiontest_bin% exit /b 1
+
+%resumptiontest_bin% %srcdir%\server.pem %srcdir%\server.pem
+if !errorlevel! neq 0 (
+	exit /b 1
+)
+
+endlocal
@@ -0,0 +1,361 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/ssl.h>
+
+#include <openssl/err.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define HANDSHAKE_ROUNDS	100
+
+char *server_cert_file;
+char *server_key_file;
+
+static SSL_CTX *
+server_ctx_new(void)
+{
+	SSL_CTX *ssl_ctx;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_server_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	if (!SSL_CTX_set_min_proto_version(ssl_ctx, TLS1_3_VERSION))
+		errx(1, "failed to set minimum protocol version");
+	if (SSL_CTX_use_certificate_file(ssl_ctx, server_cert_file,
+	    SSL_FILETYPE_PEM) != 1)
+		errx(1, "failed to load server certificate");
+	if (SSL_CTX_use_PrivateKey_file(ssl_ctx, server_key_file,
+	    SSL_FILETYPE_PEM) != 1)
+		errx(1, "failed to load server private key");
+
+	return ssl_ctx;
+}
+
+static SSL_CTX *
+client_ctx_new(void)
+{
+	SSL_CTX *ssl_ctx;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_client_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	if (!SSL_CTX_set_min_proto_version(ssl_ctx, TLS1_3_VERSION))
+		errx(1, "failed to set minimum protocol version");
+
+	return ssl_ctx;
+}
+
+static int
+ssl_want_io(SSL *ssl, int ret)
+{
+	int ssl_err;
+
+	ssl_err = SSL_get_error(ssl, ret);
+
+	return (ssl_err == SSL_ERROR_WANT_READ ||
+	    ssl_err == SSL_ERROR_WANT_WRITE);
+}
+
+static int
+do_handshake(SSL *client, SSL *server)
+{
+	int client_done = 0, server_done = 0;
+	int i, ret;
+
+	for (i = 0; i < 100 && (!client_done || !server_done); i++) {
+		if (!client_done) {
+			if ((ret = SSL_do_handshake(client)) == 1)
+				client_done = 1;
+			else if (!ssl_want_io(client, ret))
+				return 0;
+		}
+		if (!server_done) {
+			if ((ret = SSL_do_handshake(server)) == 1)
+				server_done = 1;
+			else if (!ssl_want_io(server, ret))
+				return 0;
+		}
+	}
+
+	return (client_done && server_done);
+}
+
+/*
+ * Exchange application data, which also processes any NewSessionTicket
+ * messages that the server has queued for the client.
+ */
+static int
+exchange_data(SSL *client, SSL *server)
+{
+	const char msg[] = "resumption test";
+	char buf[sizeof(msg)];
+	int i, ret;
+
+	if (SSL_write(server, msg, sizeof(msg)) != sizeof(msg))
+		return 0;
+
+	for (i = 0; i < 100; i++) {
+		if ((ret = SSL_read(client, buf, sizeof(buf))) > 0)
+			break;
+		if (!ssl_want_io(client, ret))
+			return 0;
+	}
+	if (ret != sizeof(msg) || memcmp(buf, msg, sizeof(msg)) != 0)
+		return 0;
+
+	return 1;
+}
+
+static int
+connect_pair(SSL_CTX *client_ctx, SSL_CTX *server_ctx, SSL_SESSION *sess,
+    SSL_SESSION **out_sess, int *reused)
+{
+	BIO *client_bio = NULL, *server_bio = NULL;
+	SSL *client = NULL, *server = NULL;
+	unsigned char master_key[SSL_MAX_MASTER_KEY_LENGTH];
+	unsigned char zeros[SSL_MAX_MASTER_KEY_LENGTH] = { 0 };
+	size_t master_key_len;
+	int ret = 0;
+
+	*reused = 0;
+
+	if ((client = SSL_new(client_ctx)) == NULL)
+		goto failure;
+	if ((server = SSL_new(server_ctx)) == NULL)
+		goto failure;
+	if (!BIO_new_bio_pair(&client_bio, 0, &server_bio, 0))
+		goto failure;
+
+	SSL_set_bio(client, client_bio, client_bio);
+	SSL_set_bio(server, server_bio, server_bio);
+	client_bio = NULL;
+	server_bio = NULL;
+
+	SSL_set_connect_state(client);
+	SSL_set_accept_state(server);
+
+	if (sess != NULL && !SSL_set_session(client, sess))
+		goto failure;
+
+	if (!do_handshake(client, server)) {
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (!exchange_data(client, server))
+		goto failure;
+
+	if (SSL_session_reused(client) != SSL_session_reused(server)) {
+		fprintf(stderr, "FAIL: client and server disagree on "
+		    "session reuse\n");
+		goto failure;
+	}
+	*reused = SSL_session_reused(client);
+
+	/*
+	 * Issuing tickets must leave the server's own session alone - a
+	 * resumed session keeps its PSK and a new one keeps its timeout.
+	 */
+	master_key_len = SSL_SESSION_get_master_key(SSL_get_session(server),
+	    master_key, sizeof(master_key));
+	if (*reused && (master_key_len == 0 ||
+	    memcmp(master_key, zeros, master_key_len) == 0)) {
+		fprintf(stderr, "FAIL: server session lost its master key\n");
+		goto failure;
+	}
+	if (!*reused && SSL_SESSION_get_timeout(SSL_get_session(server)) !=
+	    SSL_CTX_get_timeout(server_ctx)) {
+		fprintf(stderr, "FAIL: server session timeout changed\n");
+		goto failure;
+	}
+
+	if (out_sess != NULL) {
+		if ((*out_sess = SSL_get1_session(client)) == NULL)
+			goto failure;
+	}
+
+	ret = 1;
+
+ failure:
+	BIO_free(client_bio);
+	BIO_free(server_bio);
+	SSL_free(client);
+	SSL_free(server);
+
+	return ret;
+}
+
+static int
+resumption_test(void)
+{
+	SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+	SSL_SESSION *sess = NULL, *resumed_sess = NULL;
+	int reused;
+	int failed = 1;
+
+	client_ctx = client_ctx_new();
+	server_ctx = server_ctx_new();
+
+	if (!connect_pair(client_ctx, server_ctx, NULL, &sess, &reused)) {
+		fprintf(stderr, "FAIL: initial handshake failed\n");
+		goto failure;
+	}
+	if (reused) {
+		fprintf(stderr, "FAIL: initial handshake reused a session\n");
+		goto failure;
+	}
+	if (SSL_SESSION_get_ticket_lifetime_hint(sess) <= 0) {
+		fprintf(stderr, "FAIL: no session ticket received\n");
+		goto failure;
+	}
+
+	if (!connect_pair(client_ctx, server_ctx, sess, &resumed_sess,
+	    &reused)) {
+		fprintf(stderr, "FAIL: resumed handshake failed\n");
+		goto failure;
+	}
+	if (!reused) {
+		fprintf(stderr, "FAIL: session was not resumed\n");
+		goto failure;
+	}
+
+	/* The resumed connection issues fresh tickets, which must work. */
+	if (!connect_pair(client_ctx, server_ctx, resumed_sess, NULL,
+	    &reused)) {
+		fprintf(stderr, "FAIL: second resumed handshake failed\n");
+		goto failure;
+	}
+	if (!reused) {
+		fprintf(stderr, "FAIL: session was not resumed again\n");
+		goto failure;
+	}
+
+	SSL_SESSION_free(resumed_sess);
+	resumed_sess = NULL;
+
+	/* A server that issues no tickets results in full handshakes. */
+	SSL_CTX_set_num_tickets(server_ctx, 0);
+	if (!connect_pair(client_ctx, server_ctx, NULL, &resumed_sess,
+	    &reused)) {
+		fprintf(stderr, "FAIL: handshake without tickets failed\n");
+		goto failure;
+	}
+	if (SSL_SESSION_get_ticket_lifetime_hint(resumed_sess) != 0) {
+		fprintf(stderr, "FAIL: got ticket with num_tickets of 0\n");
+		goto failure;
+	}
+	SSL_CTX_set_num_tickets(server_ctx, 2);
+
+	/* A server with tickets disabled must fall back to a full handshake. */
+	SSL_CTX_set_options(server_ctx, SSL_OP_NO_TICKET);
+	if (!connect_pair(client_ctx, server_ctx, sess, NULL, &reused)) {
+		fprintf(stderr, "FAIL: handshake with tickets disabled "
+		    "failed\n");
+		goto failure;
+	}
+	if (reused) {
+		fprintf(stderr, "FAIL: resumed with tickets disabled\n");
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	SSL_SESSION_free(sess);
+	SSL_SESSION_free(resumed_sess);
+	SSL_CTX_free(client_ctx);
+	SSL_CTX_free(server_ctx);
+
+	return failed;
+}
+
+/*
+ * Compare the CPU cost of full and resumed handshakes. The timings are
+ * informational only, since they depend on the machine running the test.
+ */
+static int
+resumption_cost_test(void)
+{
+	SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+	SSL_SESSION *sess = NULL;
+	clock_t start, full, resumed;
+	int reused;
+	int failed = 1;
+	int i;
+
+	client_ctx = client_ctx_new();
+	server_ctx = server_ctx_new();
+
+	start = clock();
+	for (i = 0; i < HANDSHAKE_ROUNDS; i++) {
+		if (!connect_pair(client_ctx, server_ctx, NULL, NULL,
+		    &reused) || reused) {
+			fprintf(stderr, "FAIL: full handshake %d failed\n", i);
+			goto failure;
+		}
+	}
+	full = clock() - start;
+
+	if (!connect_pair(client_ctx, server_ctx, NULL, &sess, &reused))
+		goto failure;
+
+	start = clock();
+	for (i = 0; i < HANDSHAKE_ROUNDS; i++) {
+		if (!connect_pair(client_ctx, server_ctx, sess, NULL,
+		    &reused) || !reused) {
+			fprintf(stderr, "FAIL: resumed handshake %d failed\n",
+			    i);
+			goto failure;
+		}
+	}
+	resumed = clock() - start;
+
+	printf("%d full handshakes: %.3fs CPU\n", HANDSHAKE_ROUNDS,
+	    (double)full / CLOCKS_PER_SEC);
+	printf("%d resumed handshakes: %.3fs CPU\n", HANDSHAKE_ROUNDS,
+	    (double)resumed / CLOCKS_PER_SEC);
+
+	failed = 0;
+
+ failure:
+	SSL_SESSION_free(sess);
+	SSL_CTX_free(client_ctx);
+	SSL_CTX_free(server_ctx);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s keyfile certfile\n", argv[0]);
+		exit(1);
+	}
+
+	server_key_file = argv[1];
+	server_cert_file = argv[2];
+
+	SSL_library_init();
+	SSL_load_error_strings();
+
+	failed |= resumption_test();
+	failed |= resumption_cost_test();
+
+	return (failed);
+}
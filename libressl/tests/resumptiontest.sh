@@ -0,0 +1,13 @@
+#!/bin/sh
+set -e
+
+resumptiontest_bin=./resumptiontest
+if [ -e ./resumptiontest.exe ]; then
+	resumptiontest_bin=./resumptiontest.exe
+fi
+
+if [ -z $srcdir ]; then
+	srcdir=.
+fi
+
+$resumptiontest_bin $srcdir/server.pem $srcdir/server.pem
@@ -0,0 +1,155 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/bn.h>
+#include <openssl/err.h>
+#include <openssl/rsa.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BLINDING_BITS		2048
+#define BLINDING_THREADS	8
+#define BLINDING_ROUNDS		400
+
+struct blinding_state {
+	RSA *rsa;
+	int id;
+	int rounds;
+	int failed;
+};
+
+/*
+ * Every thread signs and decrypts with the same key, so that all of them
+ * need blinding factors at the same time.
+ */
+static void *
+blinding_thread(void *arg)
+{
+	struct blinding_state *bs = arg;
+	unsigned char msg[32], sig[BLINDING_BITS / 8], out[BLINDING_BITS / 8];
+	int i, len;
+
+	for (i = 0; i < bs->rounds && !bs->failed; i++) {
+		memset(msg, bs->id, sizeof(msg));
+		memcpy(msg, &i, sizeof(i));
+
+		if ((i & 1) == 0) {
+			len = RSA_private_encrypt(sizeof(msg), msg, sig,
+			    bs->rsa, RSA_PKCS1_PADDING);
+			if (len != sizeof(sig))
+				bs->failed = 1;
+			else if (RSA_public_decrypt(len, sig, out, bs->rsa,
+			    RSA_PKCS1_PADDING) != sizeof(msg) ||
+			    memcmp(out, msg, sizeof(msg)) != 0)
+				bs->failed = 1;
+		} else {
+			len = RSA_public_encrypt(sizeof(msg), msg, sig,
+			    bs->rsa, RSA_PKCS1_OAEP_PADDING);
+			if (len != sizeof(sig))
+				bs->failed = 1;
+			else if (RSA_private_decrypt(len, sig, out, bs->rsa,
+			    RSA_PKCS1_OAEP_PADDING) != sizeof(msg) ||
+			    memcmp(out, msg, sizeof(msg)) != 0)
+				bs->failed = 1;
+		}
+	}
+
+	return NULL;
+}
+
+static double
+timespec_diff(struct timespec *start, struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) +
+	    (end->tv_nsec - start->tv_nsec) / 1000000000.0;
+}
+
+static int
+blinding_test(RSA *rsa, int num_threads)
+{
+	struct blinding_state bs[BLINDING_THREADS];
+	pthread_t threads[BLINDING_THREADS];
+	struct timespec start, end;
+	double elapsed;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < num_threads; i++) {
+		bs[i].rsa = rsa;
+		bs[i].id = i;
+		bs[i].rounds = BLINDING_ROUNDS / num_threads;
+		bs[i].failed = 0;
+		if (pthread_create(&threads[i], NULL, blinding_thread,
+		    &bs[i]) != 0)
+			errx(1, "failed to create thread");
+	}
+	for (i = 0; i < num_threads; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "failed to join thread");
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < num_threads; i++) {
+		if (bs[i].failed) {
+			fprintf(stderr, "FAIL: thread %d failed\n", i);
+			ERR_print_errors_fp(stderr);
+			return 1;
+		}
+	}
+
+	elapsed = timespec_diff(&start, &end);
+	printf("%d thread%s: %d private key operations in %.3fs (%.0f/s)\n",
+	    num_threads, num_threads == 1 ? "" : "s",
+	    bs[0].rounds * num_threads, elapsed,
+	    bs[0].rounds * num_threads / elapsed);
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	BIGNUM *e;
+	RSA *rsa;
+	int failed = 0;
+
+	ERR_load_crypto_strings();
+
+	if ((e = BN_new()) == NULL || !BN_set_word(e, RSA_F4))
+		errx(1, "failed to set up exponent");
+	if ((rsa = RSA_new()) == NULL)
+		errx(1, "RSA_new");
+	if (!RSA_generate_key_ex(rsa, BLINDING_BITS, e, NULL))
+		errx(1, "RSA_generate_key_ex");
+
+	/* The timings are informational and depend on the machine. */
+	failed |= blinding_test(rsa, 1);
+	failed |= blinding_test(rsa, BLINDING_THREADS);
+
+	/* Operations without blinding must still work. */
+	RSA_blinding_off(rsa);
+	failed |= blinding_test(rsa, 2);
+
+	RSA_free(rsa);
+	BN_free(e);
+
+	return (failed);
+}
@@ -0,0 +1,392 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/ssl.h>
+
+#include <openssl/err.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssl_locl.h"
+
+#define CACHE_SESSIONS		1000
+#define CACHE_SIZE		64
+#define CACHE_THREADS		8
+#define CACHE_THREAD_SESSIONS	5000
+
+static int removed_sessions;
+
+static void
+remove_session_cb(SSL_CTX *ssl_ctx, SSL_SESSION *sess)
+{
+	removed_sessions++;
+}
+
+static SSL_SESSION *
+session_new(int n, long t, long timeout)
+{
+	unsigned char id[SSL3_SSL_SESSION_ID_LENGTH];
+	SSL_SESSION *sess;
+
+	if ((sess = SSL_SESSION_new()) == NULL)
+		errx(1, "SSL_SESSION_new() returned NULL");
+	sess->ssl_version = TLS1_2_VERSION;
+
+	arc4random_buf(id, sizeof(id));
+	id[0] = n & 0xff;
+	id[1] = (n >> 8) & 0xff;
+	id[2] = (n >> 16) & 0xff;
+	if (!SSL_SESSION_set1_id(sess, id, sizeof(id)))
+		errx(1, "failed to set session ID");
+
+	SSL_SESSION_set_time(sess, t);
+	SSL_SESSION_set_timeout(sess, timeout);
+
+	return sess;
+}
+
+static int
+session_cached(SSL_CTX *ssl_ctx, SSL_SESSION *sess)
+{
+	return ssl_session_cache_has_id(ssl_ctx, sess->ssl_version,
+	    sess->session_id, sess->session_id_length);
+}
+
+static void
+session_free_doall(SSL_SESSION *sess)
+{
+	SSL_SESSION_free(sess);
+}
+
+static IMPLEMENT_LHASH_DOALL_FN(session_free, SSL_SESSION)
+
+static void
+sessions_free(LHASH_OF(SSL_SESSION) *sessions)
+{
+	if (sessions == NULL)
+		return;
+	lh_SSL_SESSION_doall(sessions, LHASH_DOALL_FN(session_free));
+	lh_SSL_SESSION_free(sessions);
+}
+
+static int
+session_cache_test(void)
+{
+	SSL_SESSION *sess[CACHE_SESSIONS];
+	LHASH_OF(SSL_SESSION) *sessions = NULL;
+	SSL_CTX *ssl_ctx;
+	long now;
+	int failed = 1;
+	int i;
+
+	memset(sess, 0, sizeof(sess));
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_server_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	SSL_CTX_sess_set_cache_size(ssl_ctx, 0);
+	SSL_CTX_sess_set_remove_cb(ssl_ctx, remove_session_cb);
+	removed_sessions = 0;
+
+	if ((sessions = SSL_CTX_sessions(ssl_ctx)) == NULL ||
+	    lh_SSL_SESSION_num_items(sessions) != 0) {
+		fprintf(stderr, "FAIL: SSL_CTX_sessions() of an empty cache\n");
+		goto failure;
+	}
+	sessions_free(sessions);
+	sessions = NULL;
+
+	/* Every other session expires before the flush below. */
+	now = time(NULL);
+	for (i = 0; i < CACHE_SESSIONS; i++) {
+		sess[i] = session_new(i, now - 100, (i & 1) ? 1000 : 10);
+		if (SSL_CTX_add_session(ssl_ctx, sess[i]) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			goto failure;
+		}
+	}
+
+	/* Adding a session that is already cached must not duplicate it. */
+	if (SSL_CTX_add_session(ssl_ctx, sess[0]) != 0) {
+		fprintf(stderr, "FAIL: added session 0 twice\n");
+		goto failure;
+	}
+	if (SSL_CTX_sess_number(ssl_ctx) != CACHE_SESSIONS) {
+		fprintf(stderr, "FAIL: cache has %ld sessions, want %d\n",
+		    SSL_CTX_sess_number(ssl_ctx), CACHE_SESSIONS);
+		goto failure;
+	}
+	for (i = 0; i < CACHE_SESSIONS; i++) {
+		if (!session_cached(ssl_ctx, sess[i])) {
+			fprintf(stderr, "FAIL: session %d not cached\n", i);
+			goto failure;
+		}
+	}
+
+	/* SSL_CTX_sessions() returns a copy of all shards. */
+	if ((sessions = SSL_CTX_sessions(ssl_ctx)) == NULL) {
+		fprintf(stderr, "FAIL: SSL_CTX_sessions() returned NULL\n");
+		goto failure;
+	}
+	if (lh_SSL_SESSION_num_items(sessions) != CACHE_SESSIONS) {
+		fprintf(stderr, "FAIL: SSL_CTX_sessions() has %lu sessions, "
+		    "want %d\n", lh_SSL_SESSION_num_items(sessions),
+		    CACHE_SESSIONS);
+		goto failure;
+	}
+	for (i = 0; i < CACHE_SESSIONS; i++) {
+		if (lh_SSL_SESSION_retrieve(sessions, sess[i]) != sess[i]) {
+			fprintf(stderr, "FAIL: session %d not in "
+			    "SSL_CTX_sessions()\n", i);
+			goto failure;
+		}
+	}
+
+	if (!SSL_CTX_remove_session(ssl_ctx, sess[0]) ||
+	    SSL_CTX_remove_session(ssl_ctx, sess[0])) {
+		fprintf(stderr, "FAIL: failed to remove session 0\n");
+		goto failure;
+	}
+	if (session_cached(ssl_ctx, sess[0])) {
+		fprintf(stderr, "FAIL: removed session is still cached\n");
+		goto failure;
+	}
+
+	/* The copy is not changed by removals from the cache. */
+	if (lh_SSL_SESSION_retrieve(sessions, sess[0]) != sess[0]) {
+		fprintf(stderr, "FAIL: SSL_CTX_sessions() changed by removal\n");
+		goto failure;
+	}
+	sessions_free(sessions);
+	sessions = NULL;
+
+	SSL_CTX_flush_sessions(ssl_ctx, now);
+	if (SSL_CTX_sess_number(ssl_ctx) != CACHE_SESSIONS / 2) {
+		fprintf(stderr, "FAIL: cache has %ld sessions after flush, "
+		    "want %d\n", SSL_CTX_sess_number(ssl_ctx),
+		    CACHE_SESSIONS / 2);
+		goto failure;
+	}
+	for (i = 0; i < CACHE_SESSIONS; i++) {
+		if (session_cached(ssl_ctx, sess[i]) != (i & 1)) {
+			fprintf(stderr, "FAIL: session %d %s cached after "
+			    "flush\n", i, (i & 1) ? "not" : "still");
+			goto failure;
+		}
+	}
+	if (removed_sessions != CACHE_SESSIONS / 2) {
+		fprintf(stderr, "FAIL: remove callback called %d times, "
+		    "want %d\n", removed_sessions, CACHE_SESSIONS / 2);
+		goto failure;
+	}
+	if ((sessions = SSL_CTX_sessions(ssl_ctx)) == NULL ||
+	    lh_SSL_SESSION_num_items(sessions) != CACHE_SESSIONS / 2) {
+		fprintf(stderr, "FAIL: SSL_CTX_sessions() after flush\n");
+		goto failure;
+	}
+	sessions_free(sessions);
+	sessions = NULL;
+
+	SSL_CTX_flush_sessions(ssl_ctx, 0);
+	if (SSL_CTX_sess_number(ssl_ctx) != 0) {
+		fprintf(stderr, "FAIL: cache not empty after full flush\n");
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	sessions_free(sessions);
+	for (i = 0; i < CACHE_SESSIONS; i++)
+		SSL_SESSION_free(sess[i]);
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+/*
+ * The size limits the whole cache, also when it is smaller than the number
+ * of shards.
+ */
+static int
+session_cache_size_test(int cache_size)
+{
+	SSL_SESSION *sess;
+	SSL_CTX *ssl_ctx;
+	long num;
+	int failed = 1;
+	int i;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_server_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	SSL_CTX_sess_set_cache_size(ssl_ctx, cache_size);
+
+	for (i = 0; i < CACHE_SESSIONS; i++) {
+		sess = session_new(i, time(NULL), 1000);
+		if (SSL_CTX_add_session(ssl_ctx, sess) != 1) {
+			fprintf(stderr, "FAIL: failed to add session %d\n", i);
+			SSL_SESSION_free(sess);
+			goto failure;
+		}
+		/* The session that was just added is never evicted. */
+		if (!session_cached(ssl_ctx, sess)) {
+			fprintf(stderr, "FAIL: session %d was evicted\n", i);
+			SSL_SESSION_free(sess);
+			goto failure;
+		}
+		SSL_SESSION_free(sess);
+	}
+
+	num = SSL_CTX_sess_number(ssl_ctx);
+	if (num != cache_size) {
+		fprintf(stderr, "FAIL: cache has %ld sessions with a size "
+		    "of %d\n", num, cache_size);
+		goto failure;
+	}
+	if (SSL_CTX_sess_cache_full(ssl_ctx) != CACHE_SESSIONS - num) {
+		fprintf(stderr, "FAIL: cache full count is %ld, want %ld\n",
+		    SSL_CTX_sess_cache_full(ssl_ctx), CACHE_SESSIONS - num);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+struct session_cache_state {
+	SSL_CTX *ssl_ctx;
+	int thread;
+	int failed;
+};
+
+static void *
+session_cache_thread(void *arg)
+{
+	struct session_cache_state *cs = arg;
+	SSL_SESSION *sess;
+	int i;
+
+	for (i = 0; i < CACHE_THREAD_SESSIONS; i++) {
+		sess = session_new(cs->thread * CACHE_THREAD_SESSIONS + i,
+		    time(NULL), 1000);
+		if (SSL_CTX_add_session(cs->ssl_ctx, sess) != 1)
+			cs->failed = 1;
+		if (!session_cached(cs->ssl_ctx, sess))
+			cs->failed = 1;
+		/* Leave every other session in the cache. */
+		if ((i & 1) && !SSL_CTX_remove_session(cs->ssl_ctx, sess))
+			cs->failed = 1;
+		SSL_SESSION_free(sess);
+	}
+
+	return NULL;
+}
+
+static double
+timespec_diff(struct timespec *start, struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) +
+	    (end->tv_nsec - start->tv_nsec) / 1000000000.0;
+}
+
+static int
+session_cache_threads_test(int num_threads)
+{
+	struct session_cache_state cs[CACHE_THREADS];
+	pthread_t threads[CACHE_THREADS];
+	struct timespec start, end;
+	SSL_CTX *ssl_ctx;
+	double elapsed;
+	int failed = 1;
+	int i;
+
+	if ((ssl_ctx = SSL_CTX_new(TLS_server_method())) == NULL)
+		errx(1, "SSL_CTX_new() returned NULL");
+	SSL_CTX_sess_set_cache_size(ssl_ctx, 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < num_threads; i++) {
+		cs[i].ssl_ctx = ssl_ctx;
+		cs[i].thread = i;
+		cs[i].failed = 0;
+		if (pthread_create(&threads[i], NULL, session_cache_thread,
+		    &cs[i]) != 0)
+			errx(1, "failed to create thread");
+	}
+	for (i = 0; i < num_threads; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "failed to join thread");
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < num_threads; i++) {
+		if (cs[i].failed) {
+			fprintf(stderr, "FAIL: thread %d failed\n", i);
+			ERR_print_errors_fp(stderr);
+			goto failure;
+		}
+	}
+
+	if (SSL_CTX_sess_number(ssl_ctx) !=
+	    num_threads * CACHE_THREAD_SESSIONS / 2) {
+		fprintf(stderr, "FAIL: cache has %ld sessions, want %d\n",
+		    SSL_CTX_sess_number(ssl_ctx),
+		    num_threads * CACHE_THREAD_SESSIONS / 2);
+		goto failure;
+	}
+
+	elapsed = timespec_diff(&start, &end);
+	printf("%d thread%s: %d session add/lookup/remove in %.3fs "
+	    "(%.0f/s)\n", num_threads, num_threads == 1 ? "" : "s",
+	    num_threads * CACHE_THREAD_SESSIONS, elapsed,
+	    num_threads * CACHE_THREAD_SESSIONS / elapsed);
+
+	failed = 0;
+
+ failure:
+	SSL_CTX_free(ssl_ctx);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	int failed = 0;
+
+	SSL_library_init();
+	SSL_load_error_strings();
+
+	failed |= session_cache_test();
+	failed |= session_cache_size_test(CACHE_SIZE);
+	failed |= session_cache_size_test(1);
+	failed |= session_cache_size_test(3);
+
+	/* The timings are informational and depend on the machine. */
+	failed |= session_cache_threads_test(1);
+	failed |= session_cache_threads_test(CACHE_THREADS);
+
+	return (failed);
+}
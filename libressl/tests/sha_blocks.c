@@ -0,0 +1,247 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Check the SHA-1 and SHA-256 block functions with the FIPS 180 vectors
+ * and with every message length from 0 to 1000 bytes, each hashed in one
+ * go and in pseudo-random pieces.  On x86_64 with the SHA extensions this
+ * runs the sha1rnds4/sha256rnds2 code; the test script runs it again with
+ * -g, which clears the SHA extensions capability, so that the perlasm code
+ * gets the same input.  Both have to produce the digests below, which were
+ * computed independently.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+void OPENSSL_cpu_caps_clear(uint64_t caps, uint64_t caps_ext);
+
+/* CPUCAP_EXT_MASK_SHA. */
+#define SHA_CAPS_EXT_SHA	(1U << 29)
+
+#define SHA_MAX_LEN	1000
+
+struct sha_vector {
+	const char *in;
+	size_t repeat;
+	const char *digest;
+};
+
+struct sha_test {
+	const char *name;
+	const EVP_MD *(*md)(void);
+	struct sha_vector vectors[3];
+	/* SHA-256 of the digests of the first 0 to SHA_MAX_LEN bytes. */
+	uint8_t lengths_digest[SHA256_DIGEST_LENGTH];
+};
+
+#define SHA_ABC		"abc"
+#define SHA_448		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+
+static const struct sha_test sha_tests[] = {
+	{
+		.name = "SHA-1",
+		.md = EVP_sha1,
+		.vectors = {
+			{ SHA_ABC, 1,
+			    "a9993e364706816aba3e25717850c26c9cd0d89d" },
+			{ SHA_448, 1,
+			    "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+			{ "a", 1000000,
+			    "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+		},
+		.lengths_digest = {
+			0xfe, 0x15, 0xbc, 0x42, 0xcf, 0xdc, 0x2b, 0x76,
+			0x04, 0x73, 0x2b, 0xa4, 0xc4, 0xb5, 0x1a, 0xa7,
+			0xb5, 0x64, 0x29, 0x15, 0xc8, 0x67, 0xda, 0x5c,
+			0x33, 0xbd, 0x40, 0x62, 0x35, 0xb2, 0x7d, 0xa8,
+		},
+	},
+	{
+		.name = "SHA-224",
+		.md = EVP_sha224,
+		.vectors = {
+			{ SHA_ABC, 1, "23097d223405d8228642a477bda255b3"
+			    "2aadbce4bda0b3f7e36c9da7" },
+			{ SHA_448, 1, "75388b16512776cc5dba5da1fd890150"
+			    "b0c6455cb4f58b1952522525" },
+			{ "a", 1000000, "20794655980c91d8bbb4c1ea97618a4b"
+			    "f03f42581948b2ee4ee7ad67" },
+		},
+		.lengths_digest = {
+			0x35, 0x3e, 0xd5, 0xa9, 0x56, 0xfd, 0x58, 0xb4,
+			0x27, 0x81, 0x9b, 0x31, 0x0d, 0x29, 0xb9, 0x34,
+			0x5f, 0x80, 0x25, 0x2b, 0x6f, 0x7d, 0x6c, 0x30,
+			0xe5, 0x6a, 0xf5, 0x94, 0x5e, 0xa9, 0x34, 0x28,
+		},
+	},
+	{
+		.name = "SHA-256",
+		.md = EVP_sha256,
+		.vectors = {
+			{ SHA_ABC, 1, "ba7816bf8f01cfea414140de5dae2223"
+			    "b00361a396177a9cb410ff61f20015ad" },
+			{ SHA_448, 1, "248d6a61d20638b8e5c026930c3e6039"
+			    "a33ce45964ff2167f6ecedd419db06c1" },
+			{ "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67"
+			    "f1809a48a497200e046d39ccc7112cd0" },
+		},
+		.lengths_digest = {
+			0xb4, 0x98, 0xce, 0x2f, 0x58, 0x32, 0x7c, 0xda,
+			0x18, 0xe7, 0x2c, 0x4a, 0x6b, 0x74, 0x41, 0x30,
+			0xce, 0x1f, 0x10, 0x70, 0x91, 0xaa, 0xd1, 0x3f,
+			0xfd, 0x40, 0xfd, 0x4f, 0xb3, 0x6b, 0x6f, 0x89,
+		},
+	},
+};
+
+#define N_SHA_TESTS (sizeof(sha_tests) / sizeof(sha_tests[0]))
+
+/* A fixed generator, so that the lengths digests can be precomputed. */
+static uint64_t sha_lcg_state;
+
+static uint32_t
+sha_lcg(void)
+{
+	sha_lcg_state = sha_lcg_state * 6364136223846793005ULL +
+	    1442695040888963407ULL;
+
+	return sha_lcg_state >> 33;
+}
+
+static void
+sha_hex(char *out, const uint8_t *in, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		snprintf(&out[i * 2], 3, "%02x", in[i]);
+}
+
+static int
+sha_vectors_test(const struct sha_test *st, EVP_MD_CTX *md_ctx)
+{
+	const struct sha_vector *sv;
+	uint8_t md[EVP_MAX_MD_SIZE];
+	char hex[EVP_MAX_MD_SIZE * 2 + 1];
+	unsigned int md_len;
+	size_t i, j;
+	int failed = 0;
+
+	for (i = 0; i < sizeof(st->vectors) / sizeof(st->vectors[0]); i++) {
+		sv = &st->vectors[i];
+
+		if (!EVP_DigestInit_ex(md_ctx, st->md(), NULL))
+			errx(1, "EVP_DigestInit_ex");
+		for (j = 0; j < sv->repeat; j++) {
+			if (!EVP_DigestUpdate(md_ctx, sv->in, strlen(sv->in)))
+				errx(1, "EVP_DigestUpdate");
+		}
+		if (!EVP_DigestFinal_ex(md_ctx, md, &md_len))
+			errx(1, "EVP_DigestFinal_ex");
+
+		sha_hex(hex, md, md_len);
+		if (strcmp(hex, sv->digest) != 0) {
+			fprintf(stderr, "FAIL: %s vector %zu: got %s, want %s\n",
+			    st->name, i, hex, sv->digest);
+			failed = 1;
+		}
+	}
+
+	return failed;
+}
+
+static int
+sha_lengths_test(const struct sha_test *st, EVP_MD_CTX *md_ctx)
+{
+	uint8_t in[SHA_MAX_LEN];
+	uint8_t md[EVP_MAX_MD_SIZE], md_split[EVP_MAX_MD_SIZE];
+	uint8_t got[SHA256_DIGEST_LENGTH];
+	SHA256_CTX lengths_ctx;
+	unsigned int md_len;
+	size_t i, len, off, n;
+	int failed = 0;
+
+	sha_lcg_state = 0x5348414e49abcdefULL;
+	for (i = 0; i < sizeof(in); i++)
+		in[i] = sha_lcg() & 0xff;
+
+	SHA256_Init(&lengths_ctx);
+
+	for (len = 0; len <= SHA_MAX_LEN; len++) {
+		if (!EVP_Digest(in, len, md, &md_len, st->md(), NULL))
+			errx(1, "EVP_Digest");
+
+		/*
+		 * Pieces of up to 199 bytes, so that whole blocks are passed
+		 * both aligned and from the middle of the buffered block.
+		 */
+		if (!EVP_DigestInit_ex(md_ctx, st->md(), NULL))
+			errx(1, "EVP_DigestInit_ex");
+		for (off = 0; off < len; off += n) {
+			if ((n = sha_lcg() % 200) > len - off)
+				n = len - off;
+			if (!EVP_DigestUpdate(md_ctx, &in[off], n))
+				errx(1, "EVP_DigestUpdate");
+		}
+		if (!EVP_DigestFinal_ex(md_ctx, md_split, NULL))
+			errx(1, "EVP_DigestFinal_ex");
+
+		if (memcmp(md, md_split, md_len) != 0) {
+			fprintf(stderr, "FAIL: %s, %zu bytes: split digest "
+			    "differs\n", st->name, len);
+			failed = 1;
+		}
+
+		SHA256_Update(&lengths_ctx, md, md_len);
+	}
+
+	SHA256_Final(got, &lengths_ctx);
+	if (memcmp(got, st->lengths_digest, sizeof(got)) != 0) {
+		fprintf(stderr, "FAIL: %s: digests of 0 to %d bytes differ\n",
+		    st->name, SHA_MAX_LEN);
+		failed = 1;
+	}
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	EVP_MD_CTX *md_ctx;
+	size_t i;
+	int failed = 0;
+
+	if (argc == 2 && strcmp(argv[1], "-g") == 0)
+		OPENSSL_cpu_caps_clear(0, SHA_CAPS_EXT_SHA);
+
+	if ((md_ctx = EVP_MD_CTX_new()) == NULL)
+		errx(1, "EVP_MD_CTX_new");
+
+	for (i = 0; i < N_SHA_TESTS; i++) {
+		failed |= sha_vectors_test(&sha_tests[i], md_ctx);
+		failed |= sha_lengths_test(&sha_tests[i], md_ctx);
+	}
+
+	EVP_MD_CTX_free(md_ctx);
+
+	return (failed);
+}
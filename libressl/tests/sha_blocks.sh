@@ -0,0 +1,9 @@
+#!/bin/sh
+set -e
+TEST=./sha_blocks
+if [ -e ./sha_blocks.exe ]; then
+	TEST=./sha_blocks.exe
+fi
+$TEST
+# Again without the SHA extensions, so that the other code is checked too.
+$TEST -g
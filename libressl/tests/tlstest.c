@@ -407,6 +407,84 @@ do_tls_tests(void)
 	return (failure);
 }
 
+static int
+do_tls_shared_config_tests(void)
+{
+	struct tls_config *client_cfg, *server_cfg;
+	struct tls *client1, *client2, *server, *server_cctx;
+	int failure = 0;
+	int i, rv;
+
+	printf("== TLS shared config tests ==\n");
+
+	if ((client1 = tls_client()) == NULL)
+		errx(1, "failed to create tls client");
+	if ((client2 = tls_client()) == NULL)
+		errx(1, "failed to create tls client");
+	if ((client_cfg = tls_config_new()) == NULL)
+		errx(1, "failed to create tls client config");
+	tls_config_insecure_noverifyname(client_cfg);
+	if (tls_config_set_ca_file(client_cfg, cafile) == -1)
+		errx(1, "failed to set ca: %s", tls_config_error(client_cfg));
+
+	if ((server = tls_server()) == NULL)
+		errx(1, "failed to create tls server");
+	if ((server_cfg = tls_config_new()) == NULL)
+		errx(1, "failed to create tls server config");
+	if (tls_config_set_keypair_file(server_cfg, certfile, keyfile) == -1)
+		errx(1, "failed to set keypair: %s",
+		    tls_config_error(server_cfg));
+	if (tls_configure(server, server_cfg) == -1)
+		errx(1, "failed to configure server: %s", tls_error(server));
+
+	/* The second client reuses what was loaded for the first. */
+	if (tls_configure(client1, client_cfg) == -1)
+		errx(1, "failed to configure client: %s", tls_error(client1));
+	failure |= test_tls_cbs(client1, server);
+	if (tls_configure(client2, client_cfg) == -1)
+		errx(1, "failed to configure client: %s", tls_error(client2));
+	failure |= test_tls_cbs(client2, server);
+
+	/* Changing the configuration applies to subsequent connections. */
+	if (tls_config_set_ca_file(client_cfg, certfile) == -1)
+		errx(1, "failed to set ca: %s", tls_config_error(client_cfg));
+
+	tls_reset(client1);
+	if (tls_configure(client1, client_cfg) == -1)
+		errx(1, "failed to configure client: %s", tls_error(client1));
+
+	circular_init();
+
+	if (tls_accept_cbs(server, &server_cctx, server_read, server_write,
+	    NULL) == -1)
+		errx(1, "failed to accept: %s", tls_error(server));
+	if (tls_connect_cbs(client1, client_read, client_write, NULL,
+	    "test") == -1)
+		errx(1, "failed to connect: %s", tls_error(client1));
+
+	for (i = 0; i < 100; i++) {
+		if ((rv = tls_handshake(client1)) == 0 || rv == -1)
+			break;
+		(void)tls_handshake(server_cctx);
+	}
+	if (rv != -1) {
+		printf("FAIL: TLS handshake succeeded with changed CA\n");
+		failure = 1;
+	}
+
+	tls_config_free(client_cfg);
+	tls_config_free(server_cfg);
+
+	tls_free(client1);
+	tls_free(client2);
+	tls_free(server);
+	tls_free(server_cctx);
+
+	printf("\n");
+
+	return (failure);
+}
+
 static int
 do_tls_ordering_tests(void)
 {
@@ -548,6 +626,7 @@ main(int argc, char **argv)
 	keyfile = argv[3];
 
 	failure |= do_tls_tests();
+	failure |= do_tls_shared_config_tests();
 	failure |= do_tls_ordering_tests();
 	failure |= do_tls_version_tests();
 
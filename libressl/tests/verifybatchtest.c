@@ -0,0 +1,573 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/bn.h>
+#include <openssl/dsa.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BATCH_SIZE	150
+#define BATCH_THREADS	4
+
+/*
+ * A runner that spreads the jobs over a few threads, the way a caller with
+ * a thread pool would.
+ */
+struct batch_runner {
+	void (*job)(void *);
+	void **args;
+	size_t njobs;
+	size_t next;
+	pthread_mutex_t mtx;
+};
+
+static void *
+batch_runner_thread(void *arg)
+{
+	struct batch_runner *br = arg;
+	size_t i;
+
+	for (;;) {
+		pthread_mutex_lock(&br->mtx);
+		i = br->next++;
+		pthread_mutex_unlock(&br->mtx);
+		if (i >= br->njobs)
+			break;
+		br->job(br->args[i]);
+	}
+
+	return NULL;
+}
+
+static void
+batch_runner_run(void (*job)(void *), void **args, size_t njobs,
+    void *runner_arg)
+{
+	struct batch_runner br;
+	pthread_t threads[BATCH_THREADS];
+	int *calls = runner_arg;
+	int i;
+
+	(*calls)++;
+
+	br.job = job;
+	br.args = args;
+	br.njobs = njobs;
+	br.next = 0;
+	if (pthread_mutex_init(&br.mtx, NULL) != 0)
+		errx(1, "pthread_mutex_init");
+
+	for (i = 0; i < BATCH_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, batch_runner_thread,
+		    &br) != 0)
+			errx(1, "failed to create thread");
+	}
+	for (i = 0; i < BATCH_THREADS; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "failed to join thread");
+	}
+
+	pthread_mutex_destroy(&br.mtx);
+}
+
+static EVP_PKEY *
+ec_key_new(int nid)
+{
+	EVP_PKEY *pkey;
+	EC_KEY *eckey;
+
+	if ((eckey = EC_KEY_new_by_curve_name(nid)) == NULL)
+		errx(1, "EC_KEY_new_by_curve_name");
+	if (!EC_KEY_generate_key(eckey))
+		errx(1, "EC_KEY_generate_key");
+	if ((pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if (!EVP_PKEY_assign_EC_KEY(pkey, eckey))
+		errx(1, "EVP_PKEY_assign_EC_KEY");
+
+	return pkey;
+}
+
+static EVP_PKEY *
+rsa_key_new(void)
+{
+	EVP_PKEY *pkey;
+	BIGNUM *e;
+	RSA *rsa;
+
+	if ((e = BN_new()) == NULL || !BN_set_word(e, RSA_F4))
+		errx(1, "failed to set up exponent");
+	if ((rsa = RSA_new()) == NULL)
+		errx(1, "RSA_new");
+	if (!RSA_generate_key_ex(rsa, 2048, e, NULL))
+		errx(1, "RSA_generate_key_ex");
+	if ((pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if (!EVP_PKEY_assign_RSA(pkey, rsa))
+		errx(1, "EVP_PKEY_assign_RSA");
+	BN_free(e);
+
+	return pkey;
+}
+
+static EVP_PKEY *
+dsa_key_new(void)
+{
+	EVP_PKEY *pkey;
+	DSA *dsa;
+
+	if ((dsa = DSA_new()) == NULL)
+		errx(1, "DSA_new");
+	if (!DSA_generate_parameters_ex(dsa, 1024, NULL, 0, NULL, NULL,
+	    NULL) || !DSA_generate_key(dsa))
+		errx(1, "failed to generate DSA key");
+	if ((pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if (!EVP_PKEY_assign_DSA(pkey, dsa))
+		errx(1, "EVP_PKEY_assign_DSA");
+
+	return pkey;
+}
+
+static unsigned char *
+sign_digest(EVP_PKEY *pkey, const unsigned char *dgst, size_t *sig_len)
+{
+	EVP_PKEY_CTX *pctx;
+	unsigned char *sig;
+
+	if ((pctx = EVP_PKEY_CTX_new(pkey, NULL)) == NULL)
+		errx(1, "EVP_PKEY_CTX_new");
+	if (EVP_PKEY_sign_init(pctx) <= 0)
+		errx(1, "EVP_PKEY_sign_init");
+	if (EVP_PKEY_CTX_set_signature_md(pctx, EVP_sha256()) <= 0)
+		errx(1, "EVP_PKEY_CTX_set_signature_md");
+	if (EVP_PKEY_sign(pctx, NULL, sig_len, dgst, 32) <= 0)
+		errx(1, "EVP_PKEY_sign");
+	if ((sig = malloc(*sig_len)) == NULL)
+		errx(1, "malloc");
+	if (EVP_PKEY_sign(pctx, sig, sig_len, dgst, 32) <= 0)
+		errx(1, "EVP_PKEY_sign");
+	EVP_PKEY_CTX_free(pctx);
+
+	return sig;
+}
+
+/*
+ * Sign BATCH_SIZE digests with a mix of keys, damage some of the
+ * signatures and check that the batch agrees with EVP_PKEY_verify().
+ */
+static int
+evp_batch_test(EVP_PKEY **keys, size_t nkeys)
+{
+	EVP_PKEY_VERIFY_ITEM items[BATCH_SIZE];
+	unsigned char dgsts[BATCH_SIZE][32];
+	unsigned char *sigs[BATCH_SIZE];
+	EVP_PKEY_CTX *pctx;
+	int expected, ret, calls = 0;
+	int failed = 1;
+	size_t i;
+
+	for (i = 0; i < BATCH_SIZE; i++) {
+		arc4random_buf(dgsts[i], sizeof(dgsts[i]));
+		items[i].pkey = keys[i % nkeys];
+		items[i].md = EVP_sha256();
+		items[i].dgst = dgsts[i];
+		items[i].dgst_len = sizeof(dgsts[i]);
+		sigs[i] = sign_digest(items[i].pkey, dgsts[i],
+		    &items[i].sig_len);
+		items[i].sig = sigs[i];
+	}
+
+	if (EVP_PKEY_verify_batch(items, BATCH_SIZE, batch_runner_run,
+	    &calls) != 1) {
+		fprintf(stderr, "FAIL: valid batch did not verify\n");
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (calls != 1) {
+		fprintf(stderr, "FAIL: runner called %d times\n", calls);
+		goto failure;
+	}
+
+	/*
+	 * Wrong digest, damaged signature, truncated signature and either
+	 * the wrong key or a truncated digest.
+	 */
+	dgsts[3][0] ^= 1;
+	sigs[17][items[17].sig_len - 1] ^= 1;
+	items[42].sig_len--;
+	if (nkeys > 1)
+		items[99].pkey = keys[(99 + 1) % nkeys];
+	else
+		items[99].dgst_len = 20;
+
+	if (EVP_PKEY_verify_batch(items, BATCH_SIZE, NULL, NULL) != 0) {
+		fprintf(stderr, "FAIL: damaged batch verified\n");
+		goto failure;
+	}
+	for (i = 0; i < BATCH_SIZE; i++) {
+		if ((pctx = EVP_PKEY_CTX_new(items[i].pkey, NULL)) == NULL)
+			errx(1, "EVP_PKEY_CTX_new");
+		if (EVP_PKEY_verify_init(pctx) <= 0 ||
+		    EVP_PKEY_CTX_set_signature_md(pctx, EVP_sha256()) <= 0)
+			errx(1, "failed to set up verification");
+		expected = EVP_PKEY_verify(pctx, items[i].sig,
+		    items[i].sig_len, items[i].dgst, items[i].dgst_len);
+		EVP_PKEY_CTX_free(pctx);
+
+		ret = items[i].result;
+		if ((expected == 1) != (ret == 1)) {
+			fprintf(stderr, "FAIL: item %zu: got %d, want %d\n",
+			    i, ret, expected);
+			goto failure;
+		}
+		if ((ret == 1) != (i != 3 && i != 17 && i != 42 && i != 99)) {
+			fprintf(stderr, "FAIL: item %zu: unexpected %d\n", i,
+			    ret);
+			goto failure;
+		}
+	}
+
+	failed = 0;
+
+ failure:
+	for (i = 0; i < BATCH_SIZE; i++)
+		free(sigs[i]);
+	ERR_clear_error();
+
+	return failed;
+}
+
+/* Check ECDSA_do_verify_batch() against r and s at the edges of [1, n). */
+static int
+ecdsa_range_test(EVP_PKEY *pkey)
+{
+	const unsigned char *dgsts[4];
+	const ECDSA_SIG *sigs[4];
+	ECDSA_SIG *sig[4];
+	EC_KEY *eckeys[4];
+	int dgst_lens[4], results[4];
+	unsigned char dgst[32];
+	const BIGNUM *sig_r, *sig_s;
+	BIGNUM *order, *r, *s;
+	EC_KEY *eckey;
+	int failed = 1;
+	size_t i;
+
+	eckey = EVP_PKEY_get0_EC_KEY(pkey);
+	if ((order = BN_new()) == NULL)
+		errx(1, "BN_new");
+	if (!EC_GROUP_get_order(EC_KEY_get0_group(eckey), order, NULL))
+		errx(1, "EC_GROUP_get_order");
+
+	arc4random_buf(dgst, sizeof(dgst));
+	for (i = 0; i < 4; i++) {
+		if ((sig[i] = ECDSA_do_sign(dgst, sizeof(dgst), eckey)) ==
+		    NULL)
+			errx(1, "ECDSA_do_sign");
+		dgsts[i] = dgst;
+		dgst_lens[i] = sizeof(dgst);
+		eckeys[i] = eckey;
+		sigs[i] = sig[i];
+	}
+
+	/* r = 0, s = n and r + n must all fail, the last one succeeds. */
+	ECDSA_SIG_get0(sig[0], NULL, &sig_s);
+	if ((r = BN_new()) == NULL || (s = BN_dup(sig_s)) == NULL)
+		errx(1, "BN_dup");
+	if (!ECDSA_SIG_set0(sig[0], r, s))
+		errx(1, "ECDSA_SIG_set0");
+	ECDSA_SIG_get0(sig[1], &sig_r, NULL);
+	if ((r = BN_dup(sig_r)) == NULL || (s = BN_dup(order)) == NULL)
+		errx(1, "BN_dup");
+	if (!ECDSA_SIG_set0(sig[1], r, s))
+		errx(1, "ECDSA_SIG_set0");
+	ECDSA_SIG_get0(sig[2], &sig_r, &sig_s);
+	if ((r = BN_new()) == NULL || !BN_add(r, sig_r, order) ||
+	    (s = BN_dup(sig_s)) == NULL)
+		errx(1, "BN_add");
+	if (!ECDSA_SIG_set0(sig[2], r, s))
+		errx(1, "ECDSA_SIG_set0");
+
+	if (ECDSA_do_verify_batch(dgsts, dgst_lens, sigs, eckeys, results,
+	    4) != 0) {
+		fprintf(stderr, "FAIL: out of range batch verified\n");
+		goto failure;
+	}
+	for (i = 0; i < 4; i++) {
+		if (results[i] != ECDSA_do_verify(dgsts[i], dgst_lens[i],
+		    sigs[i], eckeys[i])) {
+			fprintf(stderr, "FAIL: range item %zu: got %d\n", i,
+			    results[i]);
+			goto failure;
+		}
+	}
+	if (results[3] != 1) {
+		fprintf(stderr, "FAIL: valid range item did not verify\n");
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	for (i = 0; i < 4; i++)
+		ECDSA_SIG_free(sig[i]);
+	BN_free(order);
+
+	return failed;
+}
+
+static X509 *
+cert_new(const char *cn, EVP_PKEY *pkey, const char *issuer_cn,
+    EVP_PKEY *issuer_pkey)
+{
+	X509_NAME *subject, *issuer;
+	X509 *cert;
+
+	if ((cert = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if (!X509_set_version(cert, 2) ||
+	    !ASN1_INTEGER_set(X509_get_serialNumber(cert), arc4random()))
+		errx(1, "failed to set serial");
+	if (X509_gmtime_adj(X509_get_notBefore(cert), 0) == NULL ||
+	    X509_gmtime_adj(X509_get_notAfter(cert), 3600) == NULL)
+		errx(1, "failed to set validity");
+	if ((subject = X509_NAME_new()) == NULL ||
+	    (issuer = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	if (!X509_NAME_add_entry_by_txt(subject, "CN", MBSTRING_ASC,
+	    (const unsigned char *)cn, -1, -1, 0) ||
+	    !X509_NAME_add_entry_by_txt(issuer, "CN", MBSTRING_ASC,
+	    (const unsigned char *)issuer_cn, -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+	if (!X509_set_subject_name(cert, subject) ||
+	    !X509_set_issuer_name(cert, issuer) ||
+	    !X509_set_pubkey(cert, pkey))
+		errx(1, "failed to fill in certificate");
+	if (!X509_sign(cert, issuer_pkey, EVP_sha256()))
+		errx(1, "X509_sign");
+	X509_NAME_free(subject);
+	X509_NAME_free(issuer);
+
+	return cert;
+}
+
+/*
+ * Issue leaves from an RSA, a P-256 and a P-384 CA and check the batch
+ * against X509_verify(), including leaves paired with the wrong issuer.
+ */
+static int
+x509_batch_test(EVP_PKEY **keys, size_t nkeys, EVP_PKEY *leaf_key)
+{
+	X509 *cas[3], *certs[BATCH_SIZE], *issuers[BATCH_SIZE];
+	int results[BATCH_SIZE];
+	EVP_PKEY *pkey;
+	int expected, calls = 0;
+	int failed = 1;
+	size_t i;
+
+	if (nkeys != 3)
+		errx(1, "need three issuer keys");
+	cas[0] = cert_new("RSA CA", keys[0], "RSA CA", keys[0]);
+	cas[1] = cert_new("P-256 CA", keys[1], "P-256 CA", keys[1]);
+	cas[2] = cert_new("P-384 CA", keys[2], "P-384 CA", keys[2]);
+
+	for (i = 0; i < BATCH_SIZE; i++) {
+		certs[i] = cert_new("leaf", leaf_key,
+		    i % 3 == 0 ? "RSA CA" : i % 3 == 1 ? "P-256 CA" :
+		    "P-384 CA", keys[i % 3]);
+		issuers[i] = cas[i % 3];
+	}
+	issuers[5] = cas[0];
+	issuers[31] = cas[2];
+
+	if (X509_verify_batch(certs, issuers, results, BATCH_SIZE,
+	    batch_runner_run, &calls) != 0) {
+		fprintf(stderr, "FAIL: mismatched issuers verified\n");
+		goto failure;
+	}
+	for (i = 0; i < BATCH_SIZE; i++) {
+		if ((pkey = X509_get_pubkey(issuers[i])) == NULL)
+			errx(1, "X509_get_pubkey");
+		expected = X509_verify(certs[i], pkey) == 1;
+		EVP_PKEY_free(pkey);
+		if ((results[i] == 1) != expected ||
+		    expected != (i != 5 && i != 31)) {
+			fprintf(stderr, "FAIL: cert %zu: got %d\n", i,
+			    results[i]);
+			goto failure;
+		}
+	}
+
+	/* The second run is answered from the issuer cache. */
+	issuers[5] = cas[5 % 3];
+	issuers[31] = cas[31 % 3];
+	calls = 0;
+	if (X509_verify_batch(certs, issuers, results, BATCH_SIZE,
+	    batch_runner_run, &calls) != 1) {
+		fprintf(stderr, "FAIL: valid certificates did not verify\n");
+		ERR_print_errors_fp(stderr);
+		goto failure;
+	}
+	if (calls != 1) {
+		fprintf(stderr, "FAIL: runner called %d times\n", calls);
+		goto failure;
+	}
+	calls = 0;
+	if (X509_verify_batch(certs, issuers, results, BATCH_SIZE,
+	    batch_runner_run, &calls) != 1 || calls != 0) {
+		fprintf(stderr, "FAIL: cached batch: %d runner calls\n",
+		    calls);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	for (i = 0; i < BATCH_SIZE; i++)
+		X509_free(certs[i]);
+	for (i = 0; i < 3; i++)
+		X509_free(cas[i]);
+	ERR_clear_error();
+
+	return failed;
+}
+
+/*
+ * A signature that cannot be checked with the key of the issuer at all
+ * gives -1, and is not remembered as a bad signature.
+ */
+static int
+x509_batch_error_test(EVP_PKEY *rsa_key, EVP_PKEY *leaf_key)
+{
+	X509 *ca, *cert;
+	EVP_PKEY *dsa_key;
+	int i, result, calls = 0;
+	int failed = 1;
+
+	dsa_key = dsa_key_new();
+	ca = cert_new("Error CA", dsa_key, "Error CA", dsa_key);
+	cert = cert_new("leaf", leaf_key, "Error CA", rsa_key);
+
+	for (i = 0; i < 2; i++) {
+		if (X509_verify_batch(&cert, &ca, &result, 1,
+		    batch_runner_run, &calls) != 0 || result != -1) {
+			fprintf(stderr, "FAIL: run %d: wrong key type gave "
+			    "%d\n", i, result);
+			goto failure;
+		}
+	}
+
+	failed = 0;
+
+ failure:
+	X509_free(cert);
+	X509_free(ca);
+	EVP_PKEY_free(dsa_key);
+	ERR_clear_error();
+
+	return failed;
+}
+
+/*
+ * A certificate whose outer signature algorithm differs from the signed
+ * one is rejected with 0, as X509_verify() does, on both runs.
+ */
+static int
+x509_batch_algor_test(EVP_PKEY *rsa_key, EVP_PKEY *leaf_key)
+{
+	X509 *ca, *cert;
+	EVP_PKEY *pkey;
+	int i, result, calls = 0;
+	int failed = 1;
+
+	ca = cert_new("Algor CA", rsa_key, "Algor CA", rsa_key);
+	cert = cert_new("leaf", leaf_key, "Algor CA", rsa_key);
+	if (!X509_ALGOR_set0(cert->sig_alg,
+	    OBJ_nid2obj(NID_sha384WithRSAEncryption), V_ASN1_NULL, NULL))
+		errx(1, "X509_ALGOR_set0");
+
+	if ((pkey = X509_get_pubkey(ca)) == NULL)
+		errx(1, "X509_get_pubkey");
+	if (X509_verify(cert, pkey) != 0) {
+		fprintf(stderr, "FAIL: X509_verify accepted mismatched "
+		    "algorithms\n");
+		goto failure;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (X509_verify_batch(&cert, &ca, &result, 1,
+		    batch_runner_run, &calls) != 0 || result != 0) {
+			fprintf(stderr, "FAIL: run %d: mismatched algorithms "
+			    "gave %d\n", i, result);
+			goto failure;
+		}
+	}
+	if (calls != 0) {
+		fprintf(stderr, "FAIL: mismatched algorithms: %d runner "
+		    "calls\n", calls);
+		goto failure;
+	}
+
+	failed = 0;
+
+ failure:
+	EVP_PKEY_free(pkey);
+	X509_free(cert);
+	X509_free(ca);
+	ERR_clear_error();
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	EVP_PKEY *keys[3], *leaf_key;
+	int failed = 0;
+	size_t i;
+
+	ERR_load_crypto_strings();
+
+	keys[0] = rsa_key_new();
+	keys[1] = ec_key_new(NID_X9_62_prime256v1);
+	keys[2] = ec_key_new(NID_secp384r1);
+	leaf_key = ec_key_new(NID_X9_62_prime256v1);
+
+	failed |= evp_batch_test(keys, 3);
+	failed |= evp_batch_test(&keys[1], 1);
+	failed |= ecdsa_range_test(keys[1]);
+	failed |= ecdsa_range_test(keys[2]);
+	failed |= x509_batch_test(keys, 3, leaf_key);
+	failed |= x509_batch_error_test(keys[0], leaf_key);
+	failed |= x509_batch_algor_test(keys[0], leaf_key);
+
+	for (i = 0; i < 3; i++)
+		EVP_PKEY_free(keys[i]);
+	EVP_PKEY_free(leaf_key);
+
+	return (failed);
+}
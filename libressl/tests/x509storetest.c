@@ -0,0 +1,637 @@
+/*	$OpenBSD$	*/
+/*
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+#include <err.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STORE_CAS		3
+#define STORE_CERTS		300
+#define STORE_THREADS		4
+#define STORE_LOOKUPS		2000
+#define STORE_CACHE_LEAVES	64
+
+static EVP_PKEY *
+store_key(void)
+{
+	EVP_PKEY *pkey;
+	EC_KEY *eckey;
+
+	if ((eckey = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1)) == NULL)
+		errx(1, "EC_KEY_new_by_curve_name");
+	if (!EC_KEY_generate_key(eckey))
+		errx(1, "EC_KEY_generate_key");
+	if ((pkey = EVP_PKEY_new()) == NULL)
+		errx(1, "EVP_PKEY_new");
+	if (!EVP_PKEY_assign_EC_KEY(pkey, eckey))
+		errx(1, "EVP_PKEY_assign_EC_KEY");
+
+	return pkey;
+}
+
+static void
+store_add_keyid(X509 *x, int nid, unsigned char id)
+{
+	ASN1_OCTET_STRING *keyid;
+	AUTHORITY_KEYID *akid;
+	unsigned char data[20];
+
+	memset(data, id, sizeof(data));
+	if ((keyid = ASN1_OCTET_STRING_new()) == NULL)
+		errx(1, "ASN1_OCTET_STRING_new");
+	if (!ASN1_OCTET_STRING_set(keyid, data, sizeof(data)))
+		errx(1, "ASN1_OCTET_STRING_set");
+
+	if (nid == NID_subject_key_identifier) {
+		if (!X509_add1_ext_i2d(x, nid, keyid, 0, 0))
+			errx(1, "X509_add1_ext_i2d");
+		ASN1_OCTET_STRING_free(keyid);
+		return;
+	}
+
+	if ((akid = AUTHORITY_KEYID_new()) == NULL)
+		errx(1, "AUTHORITY_KEYID_new");
+	akid->keyid = keyid;
+	if (!X509_add1_ext_i2d(x, nid, akid, 0, 0))
+		errx(1, "X509_add1_ext_i2d");
+	AUTHORITY_KEYID_free(akid);
+}
+
+/*
+ * Make a certificate with the given subject and issuer common names. A
+ * non-zero skid or akid adds a key identifier extension made of that byte.
+ */
+static X509 *
+store_cert(EVP_PKEY *pkey, const char *subject, const char *issuer,
+    unsigned char skid, unsigned char akid, long serial)
+{
+	X509_NAME *name;
+	X509 *x;
+
+	if ((x = X509_new()) == NULL)
+		errx(1, "X509_new");
+	if (!X509_set_version(x, 2))
+		errx(1, "X509_set_version");
+	if (!ASN1_INTEGER_set(X509_get_serialNumber(x), serial))
+		errx(1, "ASN1_INTEGER_set");
+	if (X509_gmtime_adj(X509_get_notBefore(x), -3600) == NULL ||
+	    X509_gmtime_adj(X509_get_notAfter(x), 3600) == NULL)
+		errx(1, "X509_gmtime_adj");
+
+	if ((name = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)subject, -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+	if (!X509_set_subject_name(x, name))
+		errx(1, "X509_set_subject_name");
+	X509_NAME_free(name);
+
+	if ((name = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)issuer, -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+	if (!X509_set_issuer_name(x, name))
+		errx(1, "X509_set_issuer_name");
+	X509_NAME_free(name);
+
+	if (skid != 0)
+		store_add_keyid(x, NID_subject_key_identifier, skid);
+	if (akid != 0)
+		store_add_keyid(x, NID_authority_key_identifier, akid);
+
+	if (!X509_set_pubkey(x, pkey))
+		errx(1, "X509_set_pubkey");
+	if (!X509_sign(x, pkey, EVP_sha256()))
+		errx(1, "X509_sign");
+
+	return x;
+}
+
+static X509 *store_extra_cert;
+static X509 *store_extra_issuer;
+
+/*
+ * A check_issued callback that adds to the store and looks in it, as an
+ * application's callback might, when it is asked about store_extra_issuer.
+ */
+static int
+store_check_issued_cb(X509_STORE_CTX *ctx, X509 *x, X509 *issuer)
+{
+	STACK_OF(X509) *certs;
+
+	if (store_extra_cert != NULL && issuer == store_extra_issuer) {
+		if (!X509_STORE_add_cert(ctx->ctx, store_extra_cert))
+			errx(1, "X509_STORE_add_cert");
+		certs = X509_STORE_get1_certs(ctx,
+		    X509_get_subject_name(store_extra_cert));
+		sk_X509_pop_free(certs, X509_free);
+		store_extra_cert = NULL;
+	}
+
+	return X509_check_issued(issuer, x) == X509_V_OK;
+}
+
+static int
+store_lookup_test(EVP_PKEY *pkey)
+{
+	X509_STORE *store;
+	X509_STORE_CTX *ctx;
+	X509_NAME *name;
+	STACK_OF(X509) *certs;
+	STACK_OF(X509_OBJECT) *objs;
+	X509_OBJECT *obj;
+	X509 *cas[STORE_CAS], *leaf = NULL, *extra = NULL, *issuer;
+	unsigned long err;
+	int i, failed = 1;
+
+	memset(cas, 0, sizeof(cas));
+	if ((store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+	if ((ctx = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+
+	/* Several CAs share a subject and differ in their key identifier. */
+	for (i = 0; i < STORE_CAS; i++) {
+		cas[i] = store_cert(pkey, "Test CA", "Test CA", i + 1, 0, i);
+		if (!X509_STORE_add_cert(store, cas[i])) {
+			fprintf(stderr, "FAIL: failed to add CA %d\n", i);
+			goto done;
+		}
+	}
+	if (X509_STORE_add_cert(store, cas[0])) {
+		fprintf(stderr, "FAIL: added duplicate certificate\n");
+		goto done;
+	}
+	err = ERR_get_error();
+	if (ERR_GET_REASON(err) != X509_R_CERT_ALREADY_IN_HASH_TABLE) {
+		fprintf(stderr, "FAIL: duplicate gave error %lx\n", err);
+		goto done;
+	}
+
+	leaf = store_cert(pkey, "Test leaf", "Test CA", 0, STORE_CAS, 100);
+	if (!X509_STORE_CTX_init(ctx, store, leaf, NULL))
+		errx(1, "X509_STORE_CTX_init");
+
+	if ((certs = X509_STORE_get1_certs(ctx,
+	    X509_get_issuer_name(leaf))) == NULL) {
+		fprintf(stderr, "FAIL: no certificates for CA name\n");
+		goto done;
+	}
+	if (sk_X509_num(certs) != STORE_CAS) {
+		fprintf(stderr, "FAIL: got %d certificates, want %d\n",
+		    sk_X509_num(certs), STORE_CAS);
+		sk_X509_pop_free(certs, X509_free);
+		goto done;
+	}
+	sk_X509_pop_free(certs, X509_free);
+
+	if ((certs = X509_STORE_get1_certs(ctx,
+	    X509_get_subject_name(leaf))) != NULL) {
+		fprintf(stderr, "FAIL: found certificate for leaf name\n");
+		sk_X509_pop_free(certs, X509_free);
+		goto done;
+	}
+
+	/* The issuer must be the CA whose key identifier matches. */
+	if (X509_STORE_CTX_get1_issuer(&issuer, ctx, leaf) != 1) {
+		fprintf(stderr, "FAIL: no issuer for leaf\n");
+		goto done;
+	}
+	if (issuer != cas[STORE_CAS - 1]) {
+		fprintf(stderr, "FAIL: wrong issuer for leaf\n");
+		X509_free(issuer);
+		goto done;
+	}
+	X509_free(issuer);
+
+	/* The callback is run outside the lookup, so it may use the store. */
+	extra = store_cert(pkey, "Extra CA", "Extra CA", 0, 0, 200);
+	store_extra_cert = extra;
+	store_extra_issuer = cas[STORE_CAS - 1];
+	ctx->check_issued = store_check_issued_cb;
+	if (X509_STORE_CTX_get1_issuer(&issuer, ctx, leaf) != 1) {
+		fprintf(stderr, "FAIL: no issuer with check_issued callback\n");
+		goto done;
+	}
+	X509_free(issuer);
+	if (store_extra_cert != NULL) {
+		fprintf(stderr, "FAIL: check_issued callback not called\n");
+		goto done;
+	}
+
+	if ((name = X509_NAME_new()) == NULL)
+		errx(1, "X509_NAME_new");
+	if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+	    (const unsigned char *)"Test CA", -1, -1, 0))
+		errx(1, "X509_NAME_add_entry_by_txt");
+	certs = X509_STORE_get1_certs(ctx, name);
+	X509_NAME_free(name);
+	if (certs == NULL || sk_X509_num(certs) != STORE_CAS) {
+		fprintf(stderr, "FAIL: lookup by new name failed\n");
+		sk_X509_pop_free(certs, X509_free);
+		goto done;
+	}
+	sk_X509_pop_free(certs, X509_free);
+
+	/* objs stays sorted as certificates, here the extra CA, are added. */
+	if (!X509_STORE_add_cert(store, leaf))
+		errx(1, "X509_STORE_add_cert");
+	objs = X509_STORE_get0_objects(store);
+	if (!sk_X509_OBJECT_is_sorted(objs)) {
+		fprintf(stderr, "FAIL: store objects not sorted\n");
+		goto done;
+	}
+	for (i = 1; i < sk_X509_OBJECT_num(objs); i++) {
+		if (X509_NAME_cmp(X509_get_subject_name(X509_OBJECT_get0_X509(
+		    sk_X509_OBJECT_value(objs, i - 1))),
+		    X509_get_subject_name(X509_OBJECT_get0_X509(
+		    sk_X509_OBJECT_value(objs, i)))) > 0) {
+			fprintf(stderr, "FAIL: store objects out of order\n");
+			goto done;
+		}
+	}
+	obj = X509_OBJECT_retrieve_by_subject(objs, X509_LU_X509,
+	    X509_get_subject_name(extra));
+	if (X509_OBJECT_get0_X509(obj) != extra) {
+		fprintf(stderr, "FAIL: extra CA not found in store objects\n");
+		goto done;
+	}
+
+	failed = 0;
+
+ done:
+	X509_STORE_CTX_free(ctx);
+	X509_free(leaf);
+	X509_free(extra);
+	X509_STORE_free(store);
+	for (i = 0; i < STORE_CAS; i++)
+		X509_free(cas[i]);
+
+	return failed;
+}
+
+static void
+store_write_cert(const char *dir, X509 *x, char *path, size_t len)
+{
+	FILE *fp;
+
+	snprintf(path, len, "%s/%08lx.0", dir,
+	    X509_NAME_hash(X509_get_subject_name(x)));
+	if ((fp = fopen(path, "w")) == NULL)
+		err(1, "fopen %s", path);
+	if (!PEM_write_X509(fp, x))
+		errx(1, "PEM_write_X509");
+	fclose(fp);
+}
+
+static int
+store_has_cert(X509_STORE *store, X509 *x)
+{
+	X509_STORE_CTX *ctx;
+	X509_OBJECT obj;
+	int found = 0;
+
+	if ((ctx = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+	if (!X509_STORE_CTX_init(ctx, store, x, NULL))
+		errx(1, "X509_STORE_CTX_init");
+	if (X509_STORE_get_by_subject(ctx, X509_LU_X509,
+	    X509_get_subject_name(x), &obj) == X509_LU_X509) {
+		found = X509_cmp(X509_OBJECT_get0_X509(&obj), x) == 0;
+		X509_OBJECT_free_contents(&obj);
+	}
+	X509_STORE_CTX_free(ctx);
+
+	return found;
+}
+
+/*
+ * An indexed directory serves the certificates it held when it was added,
+ * and picks up new ones once it is checked again.
+ */
+static int
+store_index_dir_test(EVP_PKEY *pkey)
+{
+	X509_STORE *store;
+	X509_LOOKUP *lookup;
+	X509 *a, *b, *c;
+	char dir[] = "/tmp/x509storetest.XXXXXXXX";
+	char path_a[64] = "", path_b[64] = "", path_c[64] = "";
+	int failed = 1;
+
+	if (mkdtemp(dir) == NULL)
+		err(1, "mkdtemp");
+	a = store_cert(pkey, "Test dir A", "Test dir A", 0, 0, 1);
+	b = store_cert(pkey, "Test dir B", "Test dir B", 0, 0, 2);
+	c = store_cert(pkey, "Test dir C", "Test dir C", 0, 0, 3);
+	store_write_cert(dir, a, path_a, sizeof(path_a));
+
+	if ((store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+	if ((lookup = X509_STORE_add_lookup(store,
+	    X509_LOOKUP_hash_dir())) == NULL)
+		errx(1, "X509_STORE_add_lookup");
+	if (!X509_LOOKUP_index_dir(lookup, 1)) {
+		fprintf(stderr, "FAIL: failed to index directory\n");
+		goto done;
+	}
+	if (!X509_LOOKUP_add_dir(lookup, dir, X509_FILETYPE_PEM)) {
+		fprintf(stderr, "FAIL: failed to add directory\n");
+		goto done;
+	}
+
+	if (!store_has_cert(store, a)) {
+		fprintf(stderr, "FAIL: indexed certificate not found\n");
+		goto done;
+	}
+	if (store_has_cert(store, c)) {
+		fprintf(stderr, "FAIL: found certificate not in directory\n");
+		goto done;
+	}
+
+	store_write_cert(dir, b, path_b, sizeof(path_b));
+	sleep(2);
+	if (!store_has_cert(store, b)) {
+		fprintf(stderr, "FAIL: new certificate not found\n");
+		goto done;
+	}
+	/* Looking up again must not add the same certificate twice. */
+	if (!store_has_cert(store, b) ||
+	    sk_X509_OBJECT_num(X509_STORE_get0_objects(store)) != 2) {
+		fprintf(stderr, "FAIL: indexed certificate added again\n");
+		goto done;
+	}
+
+	/* Without the index, the files are looked at directly. */
+	if (!X509_LOOKUP_index_dir(lookup, 0)) {
+		fprintf(stderr, "FAIL: failed to stop indexing\n");
+		goto done;
+	}
+	store_write_cert(dir, c, path_c, sizeof(path_c));
+	if (!store_has_cert(store, c)) {
+		fprintf(stderr, "FAIL: certificate not found without index\n");
+		goto done;
+	}
+	if (!X509_LOOKUP_index_dir(lookup, 1) || !store_has_cert(store, a)) {
+		fprintf(stderr, "FAIL: indexed certificate lost\n");
+		goto done;
+	}
+
+	failed = 0;
+
+ done:
+	X509_STORE_free(store);
+	unlink(path_a);
+	unlink(path_b);
+	unlink(path_c);
+	rmdir(dir);
+	X509_free(a);
+	X509_free(b);
+	X509_free(c);
+
+	return failed;
+}
+
+static void
+store_verify(X509_STORE *store, X509 *leaf)
+{
+	X509_STORE_CTX *ctx;
+
+	if ((ctx = X509_STORE_CTX_new()) == NULL)
+		errx(1, "X509_STORE_CTX_new");
+	if (!X509_STORE_CTX_init(ctx, store, leaf, NULL))
+		errx(1, "X509_STORE_CTX_init");
+	/* Only the multi-chain verifier consults the issuer cache. */
+	X509_VERIFY_PARAM_clear_flags(X509_STORE_CTX_get0_param(ctx),
+	    X509_V_FLAG_LEGACY_VERIFY);
+	(void)X509_verify_cert(ctx);
+	X509_STORE_CTX_free(ctx);
+}
+
+/*
+ * Signature checks are remembered in the issuer cache, which counts its
+ * hits and evicts once it is full.
+ */
+static int
+store_issuer_cache_test(EVP_PKEY *pkey)
+{
+	X509_STORE *store;
+	X509 *root, *leaves[STORE_CACHE_LEAVES];
+	uint64_t hits, misses, evictions, hits2, misses2;
+	size_t entries, bytes;
+	char subject[32];
+	int i, failed = 1;
+
+	if ((store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+	root = store_cert(pkey, "Cache CA", "Cache CA", 0, 0, 1);
+	if (!X509_STORE_add_cert(store, root))
+		errx(1, "X509_STORE_add_cert");
+	for (i = 0; i < STORE_CACHE_LEAVES; i++) {
+		snprintf(subject, sizeof(subject), "Cache leaf %d", i);
+		leaves[i] = store_cert(pkey, subject, "Cache CA", 0, 0, i + 2);
+	}
+
+	X509_issuer_cache_get_stats(&hits, &misses, NULL, NULL, NULL);
+	store_verify(store, leaves[0]);
+	X509_issuer_cache_get_stats(&hits2, &misses2, NULL, NULL, NULL);
+	if (misses2 <= misses) {
+		fprintf(stderr, "FAIL: first verification did not miss\n");
+		goto done;
+	}
+	store_verify(store, leaves[0]);
+	X509_issuer_cache_get_stats(&hits, &misses, NULL, NULL, NULL);
+	if (hits <= hits2 || misses != misses2) {
+		fprintf(stderr, "FAIL: second verification did not hit\n");
+		goto done;
+	}
+
+	/* One entry per shard. */
+	if (!X509_issuer_cache_set_max(16, SIZE_MAX))
+		errx(1, "X509_issuer_cache_set_max");
+	for (i = 0; i < STORE_CACHE_LEAVES; i++)
+		store_verify(store, leaves[i]);
+	X509_issuer_cache_get_stats(NULL, NULL, &evictions, &entries, &bytes);
+	if (evictions == 0 || entries == 0 || entries > 16 ||
+	    bytes < entries) {
+		fprintf(stderr, "FAIL: cache holds %zu entries, %zu bytes "
+		    "after %llu evictions\n", entries, bytes,
+		    (unsigned long long)evictions);
+		goto done;
+	}
+
+	failed = 0;
+
+ done:
+	if (!X509_issuer_cache_set_max(40000, 8 * 1024 * 1024))
+		errx(1, "X509_issuer_cache_set_max");
+	X509_STORE_free(store);
+	X509_free(root);
+	for (i = 0; i < STORE_CACHE_LEAVES; i++)
+		X509_free(leaves[i]);
+
+	return failed;
+}
+
+struct store_state {
+	X509_STORE *store;
+	X509 **certs;
+	pthread_mutex_t mtx;
+	int added;
+};
+
+struct store_reader {
+	struct store_state *ss;
+	unsigned int seed;
+	int failed;
+};
+
+/*
+ * Readers look up certificates that are known to have been added, while
+ * the main thread keeps adding more.
+ */
+static void *
+store_reader_thread(void *arg)
+{
+	struct store_reader *sr = arg;
+	struct store_state *ss = sr->ss;
+	X509_STORE_CTX *ctx;
+	STACK_OF(X509) *certs;
+	int i, n, added;
+
+	if ((ctx = X509_STORE_CTX_new()) == NULL) {
+		sr->failed = 1;
+		return NULL;
+	}
+
+	/* Keep going until the writer is done. */
+	added = 0;
+	for (i = 0; (i < STORE_LOOKUPS || added < STORE_CERTS) &&
+	    !sr->failed; i++) {
+		pthread_mutex_lock(&ss->mtx);
+		added = ss->added;
+		pthread_mutex_unlock(&ss->mtx);
+
+		n = rand_r(&sr->seed) % added;
+		if (!X509_STORE_CTX_init(ctx, ss->store, ss->certs[n], NULL)) {
+			sr->failed = 1;
+			break;
+		}
+		certs = X509_STORE_get1_certs(ctx,
+		    X509_get_subject_name(ss->certs[n]));
+		if (certs == NULL || sk_X509_num(certs) != 1 ||
+		    sk_X509_value(certs, 0) != ss->certs[n])
+			sr->failed = 1;
+		sk_X509_pop_free(certs, X509_free);
+		X509_STORE_CTX_cleanup(ctx);
+	}
+
+	X509_STORE_CTX_free(ctx);
+
+	return NULL;
+}
+
+static int
+store_thread_test(EVP_PKEY *pkey)
+{
+	struct store_state ss;
+	struct store_reader sr[STORE_THREADS];
+	pthread_t threads[STORE_THREADS];
+	char subject[32];
+	int i, failed = 0;
+
+	memset(&ss, 0, sizeof(ss));
+	if ((ss.store = X509_STORE_new()) == NULL)
+		errx(1, "X509_STORE_new");
+	if ((ss.certs = calloc(STORE_CERTS, sizeof(*ss.certs))) == NULL)
+		errx(1, "calloc");
+	for (i = 0; i < STORE_CERTS; i++) {
+		snprintf(subject, sizeof(subject), "Test cert %d", i);
+		ss.certs[i] = store_cert(pkey, subject, subject, 0, 0, i);
+	}
+	if (pthread_mutex_init(&ss.mtx, NULL) != 0)
+		errx(1, "pthread_mutex_init");
+
+	if (!X509_STORE_add_cert(ss.store, ss.certs[0]))
+		errx(1, "X509_STORE_add_cert");
+	ss.added = 1;
+
+	for (i = 0; i < STORE_THREADS; i++) {
+		sr[i].ss = &ss;
+		sr[i].seed = i;
+		sr[i].failed = 0;
+		if (pthread_create(&threads[i], NULL, store_reader_thread,
+		    &sr[i]) != 0)
+			errx(1, "failed to create thread");
+	}
+	for (i = 1; i < STORE_CERTS; i++) {
+		/* Readers wait for all certificates, so give up. */
+		if (!X509_STORE_add_cert(ss.store, ss.certs[i]))
+			errx(1, "FAIL: failed to add certificate %d", i);
+		pthread_mutex_lock(&ss.mtx);
+		ss.added = i + 1;
+		pthread_mutex_unlock(&ss.mtx);
+	}
+	for (i = 0; i < STORE_THREADS; i++) {
+		if (pthread_join(threads[i], NULL) != 0)
+			errx(1, "failed to join thread");
+		if (sr[i].failed) {
+			fprintf(stderr, "FAIL: reader %d failed\n", i);
+			failed = 1;
+		}
+	}
+
+	X509_STORE_free(ss.store);
+	for (i = 0; i < STORE_CERTS; i++)
+		X509_free(ss.certs[i]);
+	free(ss.certs);
+	pthread_mutex_destroy(&ss.mtx);
+
+	return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+	EVP_PKEY *pkey;
+	int failed = 0;
+
+	ERR_load_crypto_strings();
+
+	pkey = store_key();
+
+	failed |= store_lookup_test(pkey);
+	failed |= store_thread_test(pkey);
+	failed |= store_index_dir_test(pkey);
+	failed |= store_issuer_cache_test(pkey);
+
+	EVP_PKEY_free(pkey);
+
+	return (failed);
+}
@@ -539,8 +539,18 @@ static int
 tls_ssl_cert_verify_cb(X509_STORE_CTX *x509_ctx, void *arg)
 {
 	struct tls *ctx = arg;
+	SSL *ssl;
 	int x509_err;
 
+	/* A shared client SSL_CTX has no context of its own. */
+	if (ctx == NULL) {
+		if ((ssl = X509_STORE_CTX_get_ex_data(x509_ctx,
+		    SSL_get_ex_data_X509_STORE_CTX_idx())) == NULL)
+			return (0);
+		if ((ctx = SSL_get_app_data(ssl)) == NULL)
+			return (0);
+	}
+
 	if (ctx->config->verify_cert == 0)
 		return (1);
 
@@ -575,7 +585,8 @@ tls_configure_ssl_verify(struct tls *ctx, SSL_CTX *ssl_ctx, int verify)
 	int i;
 
 	SSL_CTX_set_verify(ssl_ctx, verify, NULL);
-	SSL_CTX_set_cert_verify_callback(ssl_ctx, tls_ssl_cert_verify_cb, ctx);
+	SSL_CTX_set_cert_verify_callback(ssl_ctx, tls_ssl_cert_verify_cb,
+	    (ctx->flags & TLS_CLIENT) ? NULL : ctx);
 
 	if (ctx->config->verify_depth >= 0)
 		SSL_CTX_set_verify_depth(ssl_ctx, ctx->config->verify_depth);
@@ -691,6 +702,11 @@ tls_reset(struct tls *ctx)
 	tls_ocsp_free(ctx->ocsp);
 	ctx->ocsp = NULL;
 
+	free(ctx->early_data);
+	ctx->early_data = NULL;
+	ctx->early_data_len = 0;
+	ctx->early_data_off = 0;
+
 	for (sni = ctx->sni_ctx; sni != NULL; sni = nsni) {
 		nsni = sni->next;
 		tls_sni_ctx_free(sni);
@@ -806,6 +822,16 @@ tls_read(struct tls *ctx, void *buf, size_t buflen)
 		goto out;
 	}
 
+	/* Early data received during the handshake is returned first. */
+	if (ctx->early_data_off < ctx->early_data_len) {
+		rv = ctx->early_data_len - ctx->early_data_off;
+		if ((size_t)rv > buflen)
+			rv = buflen;
+		memcpy(buf, ctx->early_data + ctx->early_data_off, rv);
+		ctx->early_data_off += rv;
+		goto out;
+	}
+
 	ERR_clear_error();
 	if ((ssl_ret = SSL_read(ctx->ssl_conn, buf, buflen)) > 0) {
 		rv = (ssize_t)ssl_ret;
@@ -275,59 +275,98 @@ tls_client_write_session(struct tls *ctx)
 	return (rv);
 }
 
+/*
+ * Client contexts share an SSL_CTX (and with it the parsed CA store) that is
+ * built from the configuration on first use and kept until the configuration
+ * is changed or freed.
+ */
 static int
-tls_connect_common(struct tls *ctx, const char *servername)
+tls_client_ssl_ctx(struct tls *ctx)
 {
-	union tls_addr addrbuf;
+	struct tls_config *config = ctx->config;
+	SSL_CTX *ssl_ctx = NULL;
 	int rv = -1;
 
-	if ((ctx->flags & TLS_CLIENT) == 0) {
-		tls_set_errorx(ctx, "not a client context");
-		goto err;
-	}
+	pthread_mutex_lock(&config->mutex);
 
-	if (servername != NULL) {
-		if ((ctx->servername = strdup(servername)) == NULL) {
-			tls_set_errorx(ctx, "out of memory");
-			goto err;
-		}
-	}
+	if (config->ssl_ctx != NULL)
+		goto done;
 
-	if ((ctx->ssl_ctx = SSL_CTX_new(SSLv23_client_method())) == NULL) {
+	if ((ssl_ctx = SSL_CTX_new(SSLv23_client_method())) == NULL) {
 		tls_set_errorx(ctx, "ssl context failure");
 		goto err;
 	}
 
-	if (tls_configure_ssl(ctx, ctx->ssl_ctx) != 0)
+	if (tls_configure_ssl(ctx, ssl_ctx) != 0)
 		goto err;
 
-	if (tls_configure_ssl_keypair(ctx, ctx->ssl_ctx,
+	if (tls_configure_ssl_keypair(ctx, ssl_ctx,
 	    ctx->config->keypair, 0) != 0)
 		goto err;
 
-	if (ctx->config->verify_name) {
-		if (servername == NULL) {
-			tls_set_errorx(ctx, "server name not specified");
-			goto err;
-		}
-	}
-
-	if (tls_configure_ssl_verify(ctx, ctx->ssl_ctx, SSL_VERIFY_PEER) == -1)
+	if (tls_configure_ssl_verify(ctx, ssl_ctx, SSL_VERIFY_PEER) == -1)
 		goto err;
 
 	if (ctx->config->ecdhecurves != NULL) {
-		if (SSL_CTX_set1_groups(ctx->ssl_ctx, ctx->config->ecdhecurves,
+		if (SSL_CTX_set1_groups(ssl_ctx, ctx->config->ecdhecurves,
 		    ctx->config->ecdhecurves_len) != 1) {
 			tls_set_errorx(ctx, "failed to set ecdhe curves");
 			goto err;
 		}
 	}
 
-	if (SSL_CTX_set_tlsext_status_cb(ctx->ssl_ctx, tls_ocsp_verify_cb) != 1) {
+	if (SSL_CTX_set_tlsext_status_cb(ssl_ctx, tls_ocsp_verify_cb) != 1) {
 		tls_set_errorx(ctx, "ssl OCSP verification setup failure");
 		goto err;
 	}
 
+	config->ssl_ctx = ssl_ctx;
+	ssl_ctx = NULL;
+
+ done:
+	if (!SSL_CTX_up_ref(config->ssl_ctx)) {
+		tls_set_errorx(ctx, "ssl context failure");
+		goto err;
+	}
+	ctx->ssl_ctx = config->ssl_ctx;
+
+	rv = 0;
+
+ err:
+	pthread_mutex_unlock(&config->mutex);
+	SSL_CTX_free(ssl_ctx);
+
+	return (rv);
+}
+
+static int
+tls_connect_common(struct tls *ctx, const char *servername)
+{
+	union tls_addr addrbuf;
+	int rv = -1;
+
+	if ((ctx->flags & TLS_CLIENT) == 0) {
+		tls_set_errorx(ctx, "not a client context");
+		goto err;
+	}
+
+	if (servername != NULL) {
+		if ((ctx->servername = strdup(servername)) == NULL) {
+			tls_set_errorx(ctx, "out of memory");
+			goto err;
+		}
+	}
+
+	if (ctx->config->verify_name) {
+		if (servername == NULL) {
+			tls_set_errorx(ctx, "server name not specified");
+			goto err;
+		}
+	}
+
+	if (tls_client_ssl_ctx(ctx) == -1)
+		goto err;
+
 	if ((ctx->ssl_conn = SSL_new(ctx->ssl_ctx)) == NULL) {
 		tls_set_errorx(ctx, "ssl connection failure");
 		goto err;
@@ -179,11 +179,31 @@ tls_config_free(struct tls_config *config)
 	free((char *)config->crl_mem);
 	free(config->ecdhecurves);
 
+	SSL_CTX_free(config->ssl_ctx);
+
 	pthread_mutex_destroy(&config->mutex);
 
 	free(config);
 }
 
+/*
+ * Discard the client SSL_CTX that was built from this configuration, so that
+ * the next connection builds one with the new settings. Contexts that are
+ * already connected keep their own reference.
+ */
+static void
+tls_config_changed(struct tls_config *config)
+{
+	SSL_CTX *ssl_ctx;
+
+	pthread_mutex_lock(&config->mutex);
+	ssl_ctx = config->ssl_ctx;
+	config->ssl_ctx = NULL;
+	pthread_mutex_unlock(&config->mutex);
+
+	SSL_CTX_free(ssl_ctx);
+}
+
 static void
 tls_config_keypair_add(struct tls_config *config, struct tls_keypair *keypair)
 {
@@ -339,6 +359,8 @@ tls_config_parse_alpn(struct tls_config *config, const char *alpn,
 int
 tls_config_set_alpn(struct tls_config *config, const char *alpn)
 {
+	tls_config_changed(config);
+
 	return tls_config_parse_alpn(config, alpn, &config->alpn,
 	    &config->alpn_len);
 }
@@ -434,6 +456,8 @@ tls_config_add_keypair_ocsp_file(struct tls_config *config,
 int
 tls_config_set_ca_file(struct tls_config *config, const char *ca_file)
 {
+	tls_config_changed(config);
+
 	return tls_config_load_file(&config->error, "CA", ca_file,
 	    &config->ca_mem, &config->ca_len);
 }
@@ -441,18 +465,24 @@ tls_config_set_ca_file(struct tls_config *config, const char *ca_file)
 int
 tls_config_set_ca_path(struct tls_config *config, const char *ca_path)
 {
+	tls_config_changed(config);
+
 	return tls_set_string(&config->ca_path, ca_path);
 }
 
 int
 tls_config_set_ca_mem(struct tls_config *config, const uint8_t *ca, size_t len)
 {
+	tls_config_changed(config);
+
 	return tls_set_mem(&config->ca_mem, &config->ca_len, ca, len);
 }
 
 int
 tls_config_set_cert_file(struct tls_config *config, const char *cert_file)
 {
+	tls_config_changed(config);
+
 	return tls_keypair_set_cert_file(config->keypair, &config->error,
 	    cert_file);
 }
@@ -461,6 +491,8 @@ int
 tls_config_set_cert_mem(struct tls_config *config, const uint8_t *cert,
     size_t len)
 {
+	tls_config_changed(config);
+
 	return tls_keypair_set_cert_mem(config->keypair, &config->error,
 	    cert, len);
 }
@@ -470,6 +502,8 @@ tls_config_set_ciphers(struct tls_config *config, const char *ciphers)
 {
 	SSL_CTX *ssl_ctx = NULL;
 
+	tls_config_changed(config);
+
 	if (ciphers == NULL ||
 	    strcasecmp(ciphers, "default") == 0 ||
 	    strcasecmp(ciphers, "secure") == 0)
@@ -502,6 +536,8 @@ tls_config_set_ciphers(struct tls_config *config, const char *ciphers)
 int
 tls_config_set_crl_file(struct tls_config *config, const char *crl_file)
 {
+	tls_config_changed(config);
+
 	return tls_config_load_file(&config->error, "CRL", crl_file,
 	    &config->crl_mem, &config->crl_len);
 }
@@ -510,6 +546,8 @@ int
 tls_config_set_crl_mem(struct tls_config *config, const uint8_t *crl,
     size_t len)
 {
+	tls_config_changed(config);
+
 	return tls_set_mem(&config->crl_mem, &config->crl_len, crl, len);
 }
 
@@ -560,6 +598,8 @@ tls_config_set_ecdhecurves(struct tls_config *config, const char *curves)
 	int rv = -1;
 	int nid;
 
+	tls_config_changed(config);
+
 	free(config->ecdhecurves);
 	config->ecdhecurves = NULL;
 	config->ecdhecurves_len = 0;
@@ -614,6 +654,8 @@ tls_config_set_ecdhecurves(struct tls_config *config, const char *curves)
 int
 tls_config_set_key_file(struct tls_config *config, const char *key_file)
 {
+	tls_config_changed(config);
+
 	return tls_keypair_set_key_file(config->keypair, &config->error,
 	    key_file);
 }
@@ -622,6 +664,8 @@ int
 tls_config_set_key_mem(struct tls_config *config, const uint8_t *key,
     size_t len)
 {
+	tls_config_changed(config);
+
 	return tls_keypair_set_key_mem(config->keypair, &config->error,
 	    key, len);
 }
@@ -694,6 +738,8 @@ tls_config_set_keypair_ocsp_mem(struct tls_config *config, const uint8_t *cert,
 int
 tls_config_set_protocols(struct tls_config *config, uint32_t protocols)
 {
+	tls_config_changed(config);
+
 	config->protocols = protocols;
 
 	return (0);
@@ -740,6 +786,8 @@ tls_config_set_session_fd(struct tls_config *config, int session_fd)
 int
 tls_config_set_verify_depth(struct tls_config *config, int verify_depth)
 {
+	tls_config_changed(config);
+
 	config->verify_depth = verify_depth;
 
 	return (0);
@@ -760,6 +808,8 @@ tls_config_prefer_ciphers_server(struct tls_config *config)
 void
 tls_config_insecure_noverifycert(struct tls_config *config)
 {
+	tls_config_changed(config);
+
 	config->verify_cert = 0;
 }
 
@@ -772,12 +822,16 @@ tls_config_insecure_noverifyname(struct tls_config *config)
 void
 tls_config_insecure_noverifytime(struct tls_config *config)
 {
+	tls_config_changed(config);
+
 	config->verify_time = 0;
 }
 
 void
 tls_config_verify(struct tls_config *config)
 {
+	tls_config_changed(config);
+
 	config->verify_cert = 1;
 	config->verify_name = 1;
 	config->verify_time = 1;
@@ -804,12 +858,16 @@ tls_config_verify_client_optional(struct tls_config *config)
 void
 tls_config_skip_private_key_check(struct tls_config *config)
 {
+	tls_config_changed(config);
+
 	config->skip_private_key_check = 1;
 }
 
 void
 tls_config_use_fake_private_key(struct tls_config *config)
 {
+	tls_config_changed(config);
+
 	config->use_fake_private_key = 1;
 	config->skip_private_key_check = 1;
 }
@@ -858,6 +916,19 @@ tls_config_set_session_lifetime(struct tls_config *config, int lifetime)
 	return (0);
 }
 
+int
+tls_config_set_max_early_data(struct tls_config *config,
+    uint32_t max_early_data)
+{
+	if (max_early_data > TLS_MAX_EARLY_DATA) {
+		tls_config_set_errorx(config, "max early data too large");
+		return (-1);
+	}
+
+	config->max_early_data = max_early_data;
+	return (0);
+}
+
 int
 tls_config_add_ticket_key(struct tls_config *config, uint32_t keyrev,
     unsigned char *key, size_t keylen)
@@ -65,6 +65,8 @@ struct tls_keypair {
 #define TLS_MIN_SESSION_TIMEOUT (4)
 #define TLS_MAX_SESSION_TIMEOUT (24 * 60 * 60)
 
+#define TLS_MAX_EARLY_DATA	(64 * 1024)
+
 #define TLS_NUM_TICKETS				4
 #define TLS_TICKET_NAME_SIZE			16
 #define TLS_TICKET_AES_SIZE			32
@@ -84,6 +86,9 @@ struct tls_config {
 	pthread_mutex_t mutex;
 	int refcount;
 
+	/* Client SSL_CTX shared by all contexts using this configuration. */
+	SSL_CTX *ssl_ctx;
+
 	char *alpn;
 	size_t alpn_len;
 	const char *ca_path;
@@ -97,6 +102,7 @@ struct tls_config {
 	int *ecdhecurves;
 	size_t ecdhecurves_len;
 	struct tls_keypair *keypair;
+	uint32_t max_early_data;
 	int ocsp_require_stapling;
 	uint32_t protocols;
 	unsigned char session_id[TLS_MAX_SESSION_ID_LENGTH];
@@ -141,6 +147,7 @@ struct tls_conninfo {
 #define TLS_CONNECTED		(1 << 1)
 #define TLS_HANDSHAKE_COMPLETE	(1 << 2)
 #define TLS_SSL_NEEDS_SHUTDOWN	(1 << 3)
+#define TLS_EARLY_DATA_DONE	(1 << 4)
 
 struct tls_ocsp_result {
 	const char *result_msg;
@@ -196,6 +203,10 @@ struct tls {
 
 	struct tls_ocsp *ocsp;
 
+	unsigned char *early_data;
+	size_t early_data_len;
+	size_t early_data_off;
+
 	tls_read_cb read_cb;
 	tls_write_cb write_cb;
 	void *cb_arg;
@@ -281,6 +281,11 @@ tls_configure_server_ssl(struct tls *ctx, SSL_CTX **ssl_ctx,
 		}
 	}
 
+	/* Early data requires resumption, hence tickets. */
+	if (ctx->config->session_lifetime > 0)
+		SSL_CTX_set_max_early_data(*ssl_ctx,
+		    ctx->config->max_early_data);
+
 	if (SSL_CTX_set_session_id_context(*ssl_ctx, ctx->config->session_id,
 	    sizeof(ctx->config->session_id)) != 1) {
 		tls_set_error(ctx, "failed to set session id context");
@@ -427,6 +432,42 @@ tls_accept_cbs(struct tls *ctx, struct tls **cctx,
 	return (-1);
 }
 
+/*
+ * Read any early data that the client sent, which is buffered until the
+ * handshake completes and then returned by tls_read().
+ */
+static int
+tls_server_read_early_data(struct tls *ctx)
+{
+	size_t max_early_data = ctx->config->max_early_data;
+	size_t readbytes;
+	int ssl_ret;
+
+	if (ctx->early_data == NULL) {
+		if ((ctx->early_data = malloc(max_early_data)) == NULL) {
+			tls_set_errorx(ctx, "out of memory");
+			return (-1);
+		}
+	}
+
+	while (ctx->early_data_len < max_early_data) {
+		ERR_clear_error();
+		ssl_ret = SSL_read_early_data(ctx->ssl_conn,
+		    ctx->early_data + ctx->early_data_len,
+		    max_early_data - ctx->early_data_len, &readbytes);
+		if (ssl_ret == SSL_READ_EARLY_DATA_FINISH)
+			break;
+		if (ssl_ret != SSL_READ_EARLY_DATA_SUCCESS)
+			return (tls_ssl_error(ctx, ctx->ssl_conn, -1,
+			    "early data"));
+		ctx->early_data_len += readbytes;
+	}
+
+	ctx->state |= TLS_EARLY_DATA_DONE;
+
+	return (0);
+}
+
 int
 tls_handshake_server(struct tls *ctx)
 {
@@ -440,6 +481,13 @@ tls_handshake_server(struct tls *ctx)
 
 	ctx->state |= TLS_SSL_NEEDS_SHUTDOWN;
 
+	if (ctx->config->max_early_data > 0 &&
+	    (ctx->state & TLS_EARLY_DATA_DONE) == 0) {
+		if ((rv = tls_server_read_early_data(ctx)) != 0)
+			goto err;
+		rv = -1;
+	}
+
 	ERR_clear_error();
 	if ((ssl_ret = SSL_accept(ctx->ssl_conn)) != 1) {
 		rv = tls_ssl_error(ctx, ctx->ssl_conn, ssl_ret, "handshake");